@@ -6,7 +6,56 @@
 #define SIM_BAUD_RATE 115200
 #define SIM_RX_PIN 17      // ESP32 receives, connects to module's TXD
 #define SIM_TX_PIN 18      // ESP32 sends, connects to module's RXD
+#define SIM_UART_RX_BUFFER_SIZE 4096   // UART driver RX ring buffer (must be set before begin())
+#define SIM_UART_RX_TIMEOUT_SYMBOLS 2  // RX idle timeout (in symbols) that raises a data event
 #define RI_PIN 40        // Ring Indicator
 #define DTR_PIN 45       // Data Terminal Ready
 
-#endif // CONFIG_H
\ No newline at end of file
+// Additional SIMCom modules, one per UART (1 = single module). Every module gets
+// its own arbiter and SMS ingestion task; the database, rule matcher and push
+// workers are shared, and pushes go out over any module with data connectivity.
+// UART0 is only free for a third module when the console runs over USB CDC.
+#define SIM_MODEM_COUNT 1
+#define SIM2_SERIAL_NUM 1
+#define SIM2_RX_PIN 15
+#define SIM2_TX_PIN 16
+#define SIM3_SERIAL_NUM 0
+#define SIM3_RX_PIN 4
+#define SIM3_TX_PIN 5
+
+// Optional WiFi station uplink for pushes (empty SSID disables it)
+#define WIFI_STA_SSID ""
+#define WIFI_STA_PASSWORD ""
+
+// Power-managed idle for solar/battery deployments: dynamic CPU frequency plus
+// automatic light sleep, woken by the modem RI line and UART RX. Light sleep
+// needs a tickless-idle build and only happens while WiFi is not holding the radio.
+#define POWER_SAVE_ENABLED 0
+#define POWER_CPU_MAX_FREQ_MHZ 240
+#define POWER_CPU_MIN_FREQ_MHZ 40
+
+// Task topology (ESP32-S3 dual core). WiFi/lwIP run on core 0 and the Arduino
+// loop on core 1 at priority 1. Modem I/O gets core 1 above the loop; push,
+// SMS sending, logging and scheduler work share core 0 with the web server
+// (AsyncTCP core is set by CONFIG_ASYNC_TCP_RUNNING_CORE in platformio.ini),
+// so web UI traffic cannot delay SMS ingestion.
+#define TASK_CORE_MODEM 1
+#define TASK_CORE_BACKGROUND 0
+#define MODEM_ARBITER_CORE TASK_CORE_MODEM
+#define MODEM_ARBITER_PRIORITY 5       // owns the SIM UART, must preempt everything on its core
+#define UART_MONITOR_CORE TASK_CORE_MODEM
+#define UART_MONITOR_PRIORITY 4        // SMS ingestion (decode + store)
+#define SMS_SEND_CORE TASK_CORE_BACKGROUND
+#define SMS_SEND_PRIORITY 2
+#define PUSH_WORKER_CORE TASK_CORE_BACKGROUND
+#define PUSH_WORKER_PRIORITY 2
+#define TASK_SCHEDULER_WORKER_CORE TASK_CORE_BACKGROUND
+#define TASK_SCHEDULER_WORKER_PRIORITY 1
+#define LOG_SINK_CORE TASK_CORE_BACKGROUND
+#define LOG_SINK_PRIORITY 1
+#define MODEM_SIM_CORE TASK_CORE_BACKGROUND
+#define MODEM_SIM_PRIORITY 3           // replays traces into the loopback UART, above push work
+#define DB_WORKER_CORE TASK_CORE_BACKGROUND
+#define DB_WORKER_PRIORITY 3           // owns the SQLite connection; SMS ingestion waits on it, so above push work
+
+#endif // CONFIG_H
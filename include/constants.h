@@ -22,7 +22,6 @@
 #define DEFAULT_AT_COMMAND_TIMEOUT_MS 5000
 #define DEFAULT_GSM_INIT_TIMEOUT_MS 30000
 #define DEFAULT_SMS_SEND_TIMEOUT_MS 30000
-#define DEFAULT_PHONE_CALL_TIMEOUT_MS 10000
 #define DEFAULT_UART_BAUD_RATE 115200
 #define DEFAULT_WATCHDOG_TIMEOUT_MS 60000
 
@@ -40,6 +39,8 @@
 /// 终端管理器配置
 #define MAX_FORWARD_RULES 50
 #define RULE_CACHE_SIZE 20
+#define FORWARD_RULE_DEFAULT_PRIORITY 100   // 规则默认优先级（数字越小越先推送）
+#define FORWARD_RULE_MAX_PRIORITY 1000
 
 // ==================== 缓冲区大小常量 ====================
 
@@ -57,6 +58,8 @@
 #define PASSWORD_MAX_SIZE 64
 #define URL_MAX_SIZE 512
 #define JSON_BUFFER_SIZE 2048
+#define UART_LINE_BUFFER_SIZE 1024   // 行分帧器环形缓冲区容量，需大于最长PDU行
+#define UART_READ_CHUNK_SIZE 256
 
 // ==================== 网络配置常量 ====================
 
@@ -74,26 +77,92 @@
 #define DEFAULT_WEB_SERVER_PORT 80
 #define DEFAULT_HTTPS_PORT 443
 
+/// 流式响应配置
+#define WEB_STREAM_BATCH_ROWS 10            // 流式JSON响应每次从数据库读取的行数
+#define WEB_DB_INLINE_WAIT_MS 20            // 流式响应在AsyncTCP回调中等待数据库结果的最长时间，超时后稍后再取
+#define WEB_DB_CALL_TIMEOUT_MS 2000         // 需要按结果返回状态码的请求等待数据库的最长时间
+#define WEB_EXPORT_MAX_ROWS 5000            // 增量导出单次请求最多返回的记录数
+
+/// 事件流配置
+#define EVENT_TYPE_SMS "sms"                // 新短信事件
+#define EVENT_TYPE_PUSH "push"              // 推送结果事件
+#define EVENT_TYPE_HEALTH "health"          // 系统状态事件
+#define WEB_EVENTS_HEALTH_INTERVAL_MS 5000  // 有事件流客户端时系统状态事件的发送间隔
+#define WEB_EVENTS_RETRY_MS 3000            // 断开后浏览器重连事件流的等待时间
+
+/// 静态资源缓存配置
+#define WEB_ASSET_MAX_AGE_S 31536000        // 带版本号的CSS/JS缓存时长（内容变化时URL随之变化）
+
 /// 网络重试配置
 #define MAX_WIFI_RETRY_COUNT 3
 #define MAX_HTTP_RETRY_COUNT 3
 #define RETRY_DELAY_MS 1000
 
+/// HTTP会话配置（模块HTTP服务在请求之间保持）
+#define HTTP_SESSION_IDLE_TIMEOUT_MS 30000
+#define HTTP_STATUS_CACHE_TTL_MS 10000      // 网络注册与PDP状态的缓存时间，期间由+CEREG/+CGEV上报更新
+#define HTTP_STATUS_URC_QUEUE_LENGTH 4
+#define HTTP_SSL_CONTEXT_ID 0
+#define HTTP_READ_CHUNK_SIZE 512            // 每次AT+HTTPREAD读取的长度，需小于UART_LINE_BUFFER_SIZE
+#define HTTP_DEBUG_LOG_SIZE 8192            // 调试日志环形缓冲区大小（仅调试模式下分配）
+
+/// 原生（WiFi）HTTP传输配置
+#define NATIVE_HTTP_MAX_CONNECTIONS 4       // 长连接池大小，也是可并行的请求数
+#define NATIVE_HTTP_IDLE_TIMEOUT_MS 60000   // 空闲连接的保留时间
+#define NATIVE_HTTP_BUFFER_SIZE 1024
+
 // ==================== 数据库配置常量 ====================
 
 /// 数据库文件配置
 #define DEFAULT_DB_PATH "/littlefs/sms_relay.db"
 #define DB_BACKUP_PATH "/littlefs/sms_relay_backup.db"
+#define DB_BACKUP_TEMP_SUFFIX ".tmp"        // 在线备份先写入临时文件，完成后才替换上一份备份
+#define DB_BACKUP_PAGES_PER_STEP 16         // 在线备份每次复制的页数（16 x 4KB = 64KB）
+#define DB_BACKUP_STEP_INTERVAL_MS 100      // 在线备份复制间隔，期间其他数据库请求照常执行
+
+/// 存储配置（DbStorageProfile默认值）
+#define DB_PAGE_SIZE 4096                   // 与LittleFS块大小一致（只对新建的数据库生效）
+#define DB_CACHE_SIZE_PAGES 256             // 页面缓存容量（页，256 x 4KB = 1MB）
+#define DB_PSRAM_PAGE_CACHE_PAGES 256       // PSRAM中预分配的页面缓存槽数
+#define DB_PSRAM_HEAP_SIZE (2 * 1024 * 1024) // PSRAM中SQLite堆的大小
+#define DB_PSRAM_HEAP_MIN_ALLOC 64          // SQLite堆最小分配单元
+#define DB_MMAP_SIZE 0                      // LittleFS VFS不支持内存映射
+
+/// 日志与合并提交配置
+#define DB_USE_WAL true                     // 启用WAL日志模式（独占锁模式，无需共享内存）
+#define DB_WAL_AUTOCHECKPOINT_PAGES 256     // WAL达到该页数时自动检查点
+#define DB_GROUP_COMMIT_INTERVAL_MS 1000    // 提交窗口最长打开时间
+#define DB_GROUP_COMMIT_MAX_WRITES 32       // 单个提交窗口的最大写入数
+#define DB_DEFAULT_DURABILITY DB_DURABILITY_NORMAL
+
+/// 原始分区存储（需使用partitions_rawdb.csv分区表）
+#define DB_USE_RAW_PARTITION false          // 数据库直接存放在专用flash分区上，不经过LittleFS（只支持回滚日志）
+#define DB_RAW_PARTITION_LABEL "sqldb"      // 数据库分区标签
+#define DB_RAW_VFS_NAME "rawflash"          // 注册给SQLite的VFS名称
+#define DB_RAW_SECTOR_SIZE 4096             // flash擦除扇区大小，迁移到原始分区的数据库使用此页面大小
+#define DB_RAW_JOURNAL_SECTORS 256          // 回滚日志区扇区数（256 x 4KB = 1MB，单个事务修改的页面不能超过约250页）
+#define DB_RAW_MIGRATED_SUFFIX ".migrated"  // 迁移到原始分区后，LittleFS上的原数据库改名保留
+
+/// 数据库工作线程配置（核心与优先级见config.h）
+#define DB_WORKER_QUEUE_LENGTH 16           // 待执行的数据库请求数上限
+#define DB_WORKER_STACK_SIZE 10240
+#define DB_CALL_TIMEOUT_MS 3000             // 同步调用等待请求开始执行的最长时间
 
 /// 数据清理配置
 #define DEFAULT_SMS_RETENTION_DAYS 30
 #define MAX_SMS_RECORDS_COUNT 10000
 #define SMS_CLEANUP_KEEP_COUNT 8000
 #define SMS_BATCH_SIZE 100
+#define DB_RETENTION_INTERVAL_MS 10000      // 后台清理任务间隔
+#define DB_RETENTION_BUDGET_MS 50           // 每次后台清理的时间预算
+#define DB_RETENTION_MIN_VALID_TIME 1704067200  // 早于此接收时间的记录（时间未同步）不按天数清理
+#define DB_VACUUM_IDLE_MS 60000             // 无写入超过该时间后才回收空闲页
+#define DB_VACUUM_PAGES_PER_STEP 32         // 每次最多回收的空闲页数
 
 /// 查询限制
 #define DEFAULT_QUERY_LIMIT 100
 #define MAX_QUERY_LIMIT 1000
+#define SMS_SEARCH_MIN_INDEXED_CHARS 3      // 全文索引（trigram）可匹配的最短搜索词
 
 // ==================== GSM/SMS配置常量 ====================
 
@@ -101,11 +170,57 @@
 #define AT_COMMAND_MAX_LENGTH 128
 #define AT_RESPONSE_MAX_LENGTH 512
 #define AT_COMMAND_RETRY_COUNT 3
+#define AT_COMMAND_BATCH_MAX_LENGTH 512     // 拼接发送多条扩展命令时单行的最大长度（SIMCom上限556）
+
+/// 调制解调器仲裁器配置
+#define MODEM_MAX_COUNT 3                   // 最多支持的SIM模块数（SIM_MODEM_COUNT的上限）
+#define MODEM_TRANSACTION_QUEUE_LENGTH 8
+#define MODEM_ARBITER_STACK_SIZE 6144
+#define MODEM_RESPONSE_SETTLE_MS 100        // 期望响应不是最终结果码时，其后静默多久视为完成
+#define MODEM_MAX_SUBSCRIPTIONS 12          // 短信4个、网络状态2个、通话状态5个
+#define MODEM_LINE_MAX_LENGTH 512           // 投递给订阅者的单行最大长度，需容纳一条PDU
+#define MODEM_URC_QUEUE_LENGTH 16
+#define MODEM_UNSOLICITED_BACKLOG_SIZE 4
+#define MODEM_UNSOLICITED_LINE_LENGTH 128
+#define MODEM_WRITE_CHUNK_SIZE 256          // 流式载荷每次从写入回调取数据的块大小
+
+/// 电话拨打配置
+#define PHONE_CALL_DIAL_TIMEOUT_MS 5000      // ATD只等待模块受理，接通与结束由上报驱动
+#define PHONE_CALL_POLL_INTERVAL_MS 500      // 通话期间处理上报、检查保持时间的间隔（空闲时任务禁用）
+#define PHONE_CALL_URC_QUEUE_LENGTH 8
+
+/// 调制解调器模拟器配置
+#define MODEM_SIM_STACK_SIZE 6144
+#define MODEM_SIM_SCRIPT_MAX_BYTES 32768    // 回放脚本文件的最大字节数
+#define MODEM_SIM_MAX_EVENTS 10000          // 单次回放的最大事件数
+#define MODEM_SIM_SETTLE_MS 10000           // 最后一个事件发出后保持接管串口的时间，等待进行中的推送对话结束
+#define MODEM_SIM_COMMAND_MAX_LENGTH 256    // 模拟器接收的单条AT命令最大长度
+
+/// 模块状态快照配置
+#define MODEM_STATUS_REFRESH_INTERVAL_MS 30000  // 后台批量查询模块状态的间隔
+#define MODEM_STATUS_MAX_AGE_MS 60000           // 快照超过该时长未刷新时，读取方才同步查询
 
 /// SMS配置
 #define SMS_PDU_MAX_LENGTH 320
 #define SMS_TEXT_MAX_LENGTH 160
 #define SMS_UNICODE_MAX_LENGTH 70
+#define SMS_PDU_SENDER_MAX_LENGTH 40        // 解码后发送方的最大字节数（字母数字地址为UTF-8）
+#define SMS_PDU_TEXT_BUFFER_SIZE 512        // 单条短信正文的UTF-8缓冲区大小（160个GSM字符最多480字节）
+#define SMS_TEXT_PART_LENGTH 153            // 长短信每个GSM 7位分段的septet数（扣除用户数据头）
+#define SMS_UNICODE_PART_LENGTH 67          // 长短信每个UCS2分段的UTF-16单元数（扣除用户数据头）
+#define SMS_SEND_MAX_PARTS 8                // 发送队列单条短信最多拆分的分段数
+#define SMS_SEND_QUEUE_LENGTH 8             // 发送队列容量
+#define SMS_SEND_PDU_BUFFER_SIZE 400        // 十六进制PDU编码缓冲区（短信中心、满长度分段与Ctrl+Z最多340字节）
+#define SMS_SEND_STACK_SIZE 8192
+#define SMS_CONCAT_MAX_ENTRIES 8            // 同时拼接中的长短信条数上限
+#define SMS_CONCAT_MAX_BYTES 8192           // 所有待拼接分片文本的总字节上限
+#define SMS_CONCAT_TIMEOUT_MS 600000        // 自首个分片起超过该时长仍不完整则按已收到的部分入库
+#define SMS_CONCAT_MISSING_MARK "[…]"       // 缺失分片在拼接内容中的占位符
+#define SMS_STORAGE_DRAIN_BATCH 20          // 每批从模块存储读取并入库的短信条数，入库提交后再批量删除
+#define SMS_STORAGE_LIST_TIMEOUT_MS 20000   // AT+CMGL列出存储短信的超时时间
+#define SMS_DEDUP_ENTRIES 128               // 内存中保留的最近来信指纹数（用于识别网络重传）
+#define SMS_DEDUP_PERSISTED_ENTRIES 128     // 数据库中保留的最近来信指纹数，重启后载入内存
+#define SMS_TRACE_MAX_EVENTS 24             // 单条短信链路追踪最多记录的阶段数（多条规则或重试时超出的阶段被丢弃）
 
 /// 信号强度阈值
 #define SIGNAL_STRENGTH_EXCELLENT 20
@@ -120,11 +235,99 @@
 #define PUSH_TYPE_DINGTALK "dingtalk"
 #define PUSH_TYPE_FEISHU "feishu"
 #define PUSH_TYPE_WEBHOOK "webhook"
+#define PUSH_TYPE_MQTT "mqtt"
 
 /// 推送重试配置
 #define MAX_PUSH_RETRY_COUNT 3
 #define PUSH_RETRY_DELAY_MS 2000
 
+/// 异步推送队列配置
+#define PUSH_QUEUE_LENGTH 32                // 每个优先级队列的容量
+#define PUSH_PRIORITY_LANES 3               // 高、普通、低三个优先级队列
+#define PUSH_LANE_HIGH_MAX_PRIORITY 10      // 命中规则的最高优先级不大于此值时进入高优先级队列
+#define PUSH_LANE_NORMAL_MAX_PRIORITY FORWARD_RULE_DEFAULT_PRIORITY // 不大于此值进入普通队列，其余进入低优先级队列
+#define PUSH_WORKER_STACK_SIZE 12288
+#define PUSH_MESSAGE_ARENA_BYTES 16384     // 单条短信推送内存区容量（PSRAM，推送完成后整体复位）
+#define PUSH_TIMESTAMP_TEXT_SIZE 32        // 格式化后推送时间的缓冲区大小（YYYY-MM-DD HH:mm:ss）
+#define PUSH_RESPONSE_MAX_BYTES 1024       // 需要检查结果的推送接口响应最多读取的字节数（errcode/access_token等都在前几百字节）
+#define PUSH_RESPONSE_NESTING_LIMIT 4      // 解析推送接口响应时允许的最大嵌套深度
+
+/// 推送发件箱（失败重试）配置
+#define PUSH_OUTBOX_MAX_ATTEMPTS 8
+#define PUSH_OUTBOX_BASE_DELAY_S 30
+#define PUSH_OUTBOX_MAX_DELAY_S 3600
+#define PUSH_OUTBOX_DRAIN_INTERVAL_MS 30000
+#define PUSH_OUTBOX_DRAIN_BATCH 3
+#define PUSH_DELIVERY_TIMEOUT_MS 90000     // 等待异步确认（WiFi MQTT的PUBACK）的上限，须大于客户端丢弃未确认消息的时间
+
+/// 推送端点限流与熔断配置
+#define PUSH_RATE_DINGTALK_PER_MINUTE 15    // 钉钉机器人限额每分钟20条（令牌桶容量另计）
+#define PUSH_RATE_WECOM_PER_MINUTE 15       // 企业微信机器人限额每分钟20条
+#define PUSH_RATE_FEISHU_PER_MINUTE 90      // 飞书机器人限额每分钟100条
+#define PUSH_RATE_BURST 5                   // 令牌桶容量：任意一分钟内最多推送 速率+容量 条
+#define PUSH_CIRCUIT_FAILURE_THRESHOLD 3    // 连续失败多少次后熔断
+#define PUSH_CIRCUIT_COOLDOWN_MS 300000     // 首次熔断的冷却时间
+#define PUSH_CIRCUIT_MAX_COOLDOWN_MS 1800000 // 试探失败后冷却时间加倍的上限
+#define PUSH_ENDPOINT_MAX_TRACKED 16        // 同时跟踪的推送端点数
+
+/// 转发规则匹配器配置
+#define RULE_MATCHER_MAX_RULES 1024
+#define RULE_MATCH_MAX_RESULTS 32
+
+/// 规则回测配置
+#define RULE_BACKTEST_BATCH_ROWS 256        // 每批读取的短信数（每批是一个数据库工作线程任务，批与批之间可穿插其他读写）
+#define RULE_BACKTEST_MAX_RECORDS 20000     // 单次回测最多检查的短信数
+#define RULE_BACKTEST_MAX_SAMPLES 20        // 最多返回的命中样例数
+
+/// 号码名单配置（规则来源号码写作"list:名单名"或"!list:名单名"）
+#define NUMBER_LIST_PATTERN_PREFIX "list:"
+#define NUMBER_LIST_COUNTRY_CODE "86"           // 规范化国内号码时补全的国家码
+#define NUMBER_LIST_MAX_NUMBER_LENGTH 24        // 规范化号码缓冲区大小（含"+"与'\0'）
+#define NUMBER_LIST_NAME_MAX_LENGTH 32
+#define NUMBER_LIST_IMPORT_MAX_BYTES 262144     // 单次批量导入的请求体上限（PSRAM暂存）
+
+/// 推送渠道实例池配置
+#define PUSH_CHANNEL_POOL_SIZE 2    // 每个渠道保留的空闲实例数（推送工作线程与同步推送/测试各一）
+
+/// 推送汇总配置（规则推送配置中的digest_window/digest_max）
+#define DIGEST_DEFAULT_MAX_MESSAGES 10
+#define DIGEST_MAX_MESSAGES 50
+#define DIGEST_MAX_WINDOW_S 1800  // 须小于PUSH_OUTBOX_MAX_DELAY_S，暂存的发件箱条目才不会被提前重试
+#define DIGEST_MAX_PENDING 8
+
+/// 访问令牌缓存配置
+#define TOKEN_CACHE_NVS_NAMESPACE "token_cache"
+#define TOKEN_CACHE_NVS_KEY "entries"
+#define TOKEN_CACHE_MAX_ENTRIES 8
+#define TOKEN_EXPIRY_MARGIN_S 300               // 推送路径上提前视为过期的时间
+#define TOKEN_REFRESH_AHEAD_S 900               // 定时任务提前刷新的时间，须大于TOKEN_EXPIRY_MARGIN_S
+#define TOKEN_REFRESH_CHECK_INTERVAL_MS 60000
+#define TOKEN_CACHE_MIN_VALID_TIME 1704067200   // 2024-01-01，早于此时间视为系统时间未同步
+
+/// 机器人签名缓存配置（钉钉、飞书）
+#define HMAC_SIGN_CACHE_MAX_ENTRIES 8
+#define HMAC_SIGN_MAX_SECRET_LENGTH 128
+#define HMAC_SIGN_TEXT_SIZE 45      // 32字节摘要的Base64编码（44字符）加结束符
+#define HMAC_SIGN_URL_SIZE 133      // Base64签名URL编码后的最大长度（每字符最多3字节）加结束符
+
+/// MQTT推送配置（连接由会话管理器长期保持，在渠道实例之间共享）
+#define MQTT_DEFAULT_PORT 1883
+#define MQTT_DEFAULT_TLS_PORT 8883
+#define MQTT_DEFAULT_KEEPALIVE_S 60
+#define MQTT_DEFAULT_MAX_INFLIGHT 8             // 未收到PUBACK时最多继续发布的消息数（WiFi连接）
+#define MQTT_MAX_INFLIGHT_LIMIT 32
+#define MQTT_MAX_SESSIONS 4                     // 同时保持的连接数，超出时关闭最久未用的连接
+#define MQTT_CONNECT_TIMEOUT_MS 15000
+#define MQTT_PUBACK_TIMEOUT_MS 10000            // 发布窗口已满时等待PUBACK的时间
+#define MQTT_WAIT_POLL_MS 20
+#define MQTT_SESSION_IDLE_TIMEOUT_MS 3600000    // 连接空闲超过此时间后关闭
+#define MQTT_IDLE_CHECK_INTERVAL_MS 300000
+#define MQTT_WIFI_BUFFER_SIZE 2048              // WiFi连接的收发缓冲区大小
+#define MQTT_MODEM_CLIENT_INDEX 0               // 模块MQTT客户端编号（每个模块只保持一个连接）
+#define MQTT_MODEM_PUB_TIMEOUT_S 30             // AT+CMQTTPUB等待PUBACK的时间
+#define MQTT_MAX_TOPIC_LENGTH 1024
+#define MQTT_MAX_PAYLOAD_LENGTH 10240           // 模块单条发布的载荷上限
+
 /// 推送消息长度限制
 #define PUSH_MESSAGE_MAX_LENGTH 4096
 #define PUSH_TITLE_MAX_LENGTH 100
@@ -141,6 +344,20 @@
 #define MAX_LOG_FILE_SIZE 1048576  // 1MB
 #define MAX_BACKUP_FILES 5
 
+/// 内存日志环形缓冲区（PSRAM）
+#define LOG_RING_ENTRIES 512                // 日志条目槽位数（须为2的幂，序号回绕时槽位保持连续）
+#define LOG_RING_TEXT_BYTES 65536           // 日志文本区大小（字节，须为2的幂）
+#define LOG_RING_MIN_VALID_TIME 1704067200  // 早于此时间视为系统时间未同步，日志不记录Unix时间
+#define LOG_RING_MAX_MESSAGE 512            // 单条日志消息最大长度，超出部分截断
+#define LOG_API_DEFAULT_LIMIT 100           // /api/logs默认返回条数
+#define LOG_API_MAX_LIMIT 200               // /api/logs单次最多返回条数
+
+/// 异步日志输出配置
+#define LOG_SINK_STACK_SIZE 4096
+#define LOG_SINK_POLL_MS 10                 // 无新日志时输出任务的轮询间隔
+#define LOG_SINK_BATCH 32                   // 输出任务每轮最多输出的条数
+#define LOG_SINK_FLUSH_TIMEOUT_MS 200       // 重启前等待日志输出完毕的最长时间
+
 // ==================== 任务调度配置常量 ====================
 
 /// 任务优先级
@@ -152,12 +369,33 @@
 #define TASK_STACK_SIZE_SMALL 2048
 #define TASK_STACK_SIZE_MEDIUM 4096
 #define TASK_STACK_SIZE_LARGE 8192
+#define UART_MONITOR_STACK_SIZE 10240               // 短信URC消费者（解码、入库、投递推送）
+
+/// 任务拓扑（各任务的核心与优先级见config.h）
+#define TASK_STACK_WARN_FREE_BYTES 1024             // 任务栈剩余低于该值时输出告警
+#define TASK_STACK_CHECK_INTERVAL_MS 60000          // 检查任务栈高水位的间隔
+
+/// 启动依赖图
+#define BOOT_STAGE_STACK_SIZE 8192                  // 异步启动阶段临时任务的栈大小
+#define BOOT_STAGE_PRIORITY TASK_PRIORITY_LOW
+#define BOOT_STARTUP_CALL_DELAY_MS 10000            // GSM探测完成后延迟执行开机拨号（先让积压短信导入完成）
 
 /// 任务执行间隔
 #define TASK_INTERVAL_FAST_MS 1000
 #define TASK_INTERVAL_NORMAL_MS 5000
 #define TASK_INTERVAL_SLOW_MS 30000
 
+/// 定时任务调度器
+#define TASK_SCHEDULER_MAX_IDLE_MS 50               // loop()无到期任务时的最长休眠时间（保证CLI输入及时处理）
+#define TASK_SCHEDULER_INLINE_BUDGET_MS 50          // 在loop()中执行的任务超过该时长计为超时
+#define TASK_SCHEDULER_WORKER_QUEUE_LENGTH 8        // 调度工作线程的待执行任务队列长度
+#define TASK_SCHEDULER_WORKER_STACK_SIZE 8192
+
+/// 电源管理（POWER_SAVE_ENABLED见config.h）
+#define POWER_WAKE_HOLD_MS 2000                     // 串口收发或RI唤醒后保持不进入浅睡眠的时间
+#define POWER_UART_WAKEUP_THRESHOLD 3               // 浅睡眠中SIM串口RX边沿数达到该值时唤醒
+#define POWER_IDLE_MAX_SLEEP_MS 1000                // 启用浅睡眠时loop()无到期任务的最长休眠时间
+
 // ==================== 模块管理配置常量 ====================
 
 /// 模块数量
@@ -177,6 +415,31 @@
 #define PERFORMANCE_MONITOR_INTERVAL_MS 60000
 #define MEMORY_CHECK_INTERVAL_MS 30000
 
+/// 内存压力分级（按内部堆最大连续空闲块判断，恢复时需高出阈值MEMORY_PRESSURE_HYSTERESIS_BYTES）
+#define MEMORY_PRESSURE_CHECK_INTERVAL_MS 5000      // 检查内存压力的间隔
+#define MEMORY_PRESSURE_ELEVATED_BYTES 24576        // 低于该值：释放SQLite页面缓存、输出积压日志
+#define MEMORY_PRESSURE_HIGH_BYTES 16384            // 低于该值：暂停Web服务器
+#define MEMORY_PRESSURE_CRITICAL_BYTES 10240        // 低于该值：暂停推送，匹配的推送写入发件箱
+#define MEMORY_PRESSURE_FATAL_BYTES 6144            // 低于该值持续MEMORY_PRESSURE_FATAL_CHECKS次：提交数据库后重启
+#define MEMORY_PRESSURE_FATAL_CHECKS 3
+#define MEMORY_PRESSURE_HYSTERESIS_BYTES 4096
+#define MEMORY_PRESSURE_PUSH_DEFER_MS 60000         // 推送暂停期间发件箱条目的推迟时间
+
+/// 运行指标（/api/metrics）
+#define METRICS_MAX_SERIES 64                       // 指标序列总数上限（所有指标与标签值共用，超出时丢弃并计数）
+#define METRICS_MAX_BUCKETS 12                      // 直方图桶数上限（不含+Inf）
+#define METRICS_LABEL_MAX_LENGTH 24                 // 标签值最大长度（超出截断）
+
+/// 基准测试（bench命令）
+#define BENCH_DEFAULT_ITERATIONS 200                // 离线测试组的默认次数
+#define BENCH_MAX_ITERATIONS 10000
+#define BENCH_DB_INSERT_DEFAULT_ITERATIONS 100
+#define BENCH_AT_DEFAULT_ITERATIONS 50
+#define BENCH_AT_TIMEOUT_MS 2000
+#define BENCH_HTTP_DEFAULT_ITERATIONS 10
+#define BENCH_HTTP_TIMEOUT_MS 15000
+#define BENCH_HTTP_DEFAULT_URL "http://connectivitycheck.platform.hicloud.com/generate_204"
+
 // ==================== 安全配置常量 ====================
 
 /// 密码强度要求
@@ -6,18 +6,58 @@
  */
 
 #include "at_command_handler.h"
+#include "../log_manager/log_manager.h"
+#include "../metrics/metrics.h"
+#include "../../include/config.h"
 #include "../../include/constants.h"
 #include <Arduino.h>
+#include <ctype.h>
 
-// 外部串口对象
-extern HardwareSerial simSerial;
+/**
+ * @brief 取出AT事务的命令名作为指标标签（如"AT+CMGS"、"ATD"），不含参数
+ * @param kind 事务类型
+ * @param payload 写入的载荷
+ * @param label 输出缓冲区
+ * @param size 缓冲区大小
+ */
+static void commandMetricLabel(ModemTransactionKind kind, const char* payload, char* label, size_t size) {
+    if (kind == MODEM_TXN_WAIT) {
+        snprintf(label, size, "wait");
+        return;
+    }
+    if (payload == nullptr || toupper((unsigned char)payload[0]) != 'A' || toupper((unsigned char)payload[1]) != 'T') {
+        // 短信PDU、HTTP正文等原始数据
+        snprintf(label, size, "data");
+        return;
+    }
+
+    size_t length = 2;
+    char prefix = payload[2];
+    if (prefix == '+' || prefix == '&' || prefix == '^' || prefix == '$') {
+        // 扩展命令：取到参数或查询符之前
+        length = 3;
+        while (length + 1 < size && isalnum((unsigned char)payload[length])) {
+            length++;
+        }
+    } else if (isalpha((unsigned char)prefix)) {
+        // 基本命令（ATD、ATH、ATE0等）只取命令字母，避免号码等参数成为标签
+        length = 3;
+    }
+    if (length >= size) {
+        length = size - 1;
+    }
+    for (size_t i = 0; i < length; i++) {
+        label[i] = (char)toupper((unsigned char)payload[i]);
+    }
+    label[length] = '\0';
+}
 
 /**
  * @brief 构造函数
- * @param serial 串口对象引用
+ * @param arbiter 所属SIM模块的仲裁器
  */
-AtCommandHandler::AtCommandHandler(HardwareSerial& serial) 
-    : serialPort(serial), lastError(""), debugMode(false), initialized(false),
+AtCommandHandler::AtCommandHandler(ModemArbiter& arbiter) 
+    : arbiter(arbiter), lastError(""), debugMode(false), initialized(false),
       totalCommands(0), successfulCommands(0), failedCommands(0), 
       timeoutCommands(0), lastDiagnosticTime(0), lastFailedCommand(""), 
       lastFailedResponse("") {
@@ -31,20 +71,37 @@ AtCommandHandler::~AtCommandHandler() {
 }
 
 /**
- * @brief 获取单例实例
- * @return AtCommandHandler& 单例引用
+ * @brief 获取主SIM模块的AT命令处理器
+ * @return AtCommandHandler& 实例引用
  */
 AtCommandHandler& AtCommandHandler::getInstance() {
-    // 注意：这个方法现在不应该被使用，因为构造函数需要串口参数
-    // 保留此方法是为了向后兼容，但会导致编译错误
-    // 应该使用带参数的构造函数创建实例
-    static AtCommandHandler* instance = nullptr;
-    if (!instance) {
-        // 这里需要外部提供串口实例，暂时使用全局simSerial
-        extern HardwareSerial simSerial;
-        instance = new AtCommandHandler(simSerial);
-    }
-    return *instance;
+    return getModem(0);
+}
+
+/**
+ * @brief 获取指定SIM模块的AT命令处理器
+ * @param index 模块序号
+ * @return AtCommandHandler& 实例引用
+ */
+AtCommandHandler& AtCommandHandler::getModem(uint8_t index) {
+    static AtCommandHandler* const instances[SIM_MODEM_COUNT] = {
+        new AtCommandHandler(ModemArbiter::getModem(0)),
+#if SIM_MODEM_COUNT > 1
+        new AtCommandHandler(ModemArbiter::getModem(1)),
+#endif
+#if SIM_MODEM_COUNT > 2
+        new AtCommandHandler(ModemArbiter::getModem(2)),
+#endif
+    };
+    return *instances[index < SIM_MODEM_COUNT ? index : 0];
+}
+
+/**
+ * @brief 获取所属SIM模块的仲裁器
+ * @return ModemArbiter& 仲裁器引用
+ */
+ModemArbiter& AtCommandHandler::getArbiter() {
+    return arbiter;
 }
 
 /**
@@ -57,11 +114,11 @@ bool AtCommandHandler::initialize() {
         return true;
     }
     
-    debugPrint("正在初始化AT命令处理器...");
+    LOG_DEBUG_PRINT("正在初始化AT命令处理器...");
     
-    // 检查串口是否可用
-    if (!serialPort) {
-        setError("串口未初始化");
+    // 串口由仲裁器独占，仲裁器必须先启动
+    if (!arbiter.isRunning()) {
+        setError("调制解调器仲裁器未启动");
         return false;
     }
     
@@ -76,7 +133,7 @@ bool AtCommandHandler::initialize() {
     }
     
     initialized = true;
-    debugPrint("AT命令处理器初始化完成");
+    LOG_DEBUG_PRINT("AT命令处理器初始化完成");
     return true;
 }
 
@@ -101,37 +158,25 @@ AtResponse AtCommandHandler::sendCommand(const String& command,
     
     for (int attempt = 0; attempt <= retries; attempt++) {
         if (attempt > 0) {
-            debugPrint("重试命令: " + command + " (第" + String(attempt) + "次)");
+            LOG_DEBUG_PRINT("重试命令: " + command + " (第" + String(attempt) + "次)");
             vTaskDelay(500 / portTICK_PERIOD_MS); // 重试间隔
         }
         
-        clearBuffer();
-        
-        // 发送命令
-        serialPort.println(command);
-        serialPort.flush();
-        debugPrint("发送AT命令: " + command);
-        
-        // 读取响应
-        String rawResponse = readResponse(timeout);
-        response.response = rawResponse;
+        LOG_DEBUG_PRINT("发送AT命令: " + command);
+        response = runTransaction(MODEM_TXN_COMMAND, command + "\r\n", expectedResponse, timeout);
         
         // 检查响应
-        if (rawResponse.indexOf(expectedResponse) != -1) {
-            response.result = AT_RESULT_SUCCESS;
+        if (response.result == AT_RESULT_SUCCESS) {
             successfulCommands++; // 统计成功命令数
-            debugPrint("命令执行成功，响应: " + rawResponse);
+            LOG_DEBUG_PRINT("命令执行成功，响应: " + response.response);
             break;
-        } else if (rawResponse.indexOf("ERROR") != -1) {
-            response.result = AT_RESULT_ERROR;
-            debugPrint("命令执行错误，响应: " + rawResponse);
-        } else if (rawResponse.length() == 0) {
-            response.result = AT_RESULT_TIMEOUT;
+        } else if (response.result == AT_RESULT_ERROR) {
+            LOG_DEBUG_PRINT("命令执行错误，响应: " + response.response);
+        } else if (response.result == AT_RESULT_TIMEOUT) {
             timeoutCommands++; // 统计超时命令数
-            debugPrint("命令执行超时");
+            LOG_DEBUG_PRINT("命令执行超时");
         } else {
-            response.result = AT_RESULT_INVALID;
-            debugPrint("命令响应无效，响应: " + rawResponse);
+            LOG_DEBUG_PRINT("命令响应无效，响应: " + response.response);
         }
     }
     
@@ -149,133 +194,218 @@ AtResponse AtCommandHandler::sendCommand(const String& command,
 }
 
 /**
- * @brief 发送AT命令并获取完整响应
- * @param command AT命令
- * @param timeout 超时时间（毫秒）
- * @return AtResponse 命令执行结果
+ * @brief 批量发送扩展AT命令
+ * @param commands AT命令列表（以"AT+"开头的命令参与拼接，其余单独发送）
+ * @param timeout 每行的超时时间（毫秒）
+ * @return AtResponse 最后一行（或失败命令）的执行结果
  */
-AtResponse AtCommandHandler::sendCommandWithFullResponse(const String& command, 
-                                                        unsigned long timeout) {
+AtResponse AtCommandHandler::sendCommandBatch(const std::vector<String>& commands, 
+                                             unsigned long timeout) {
     AtResponse response;
     response.result = AT_RESULT_SUCCESS;
+    response.response = "";
+    response.duration = 0;
     
     unsigned long startTime = millis();
+    size_t index = 0;
     
-    clearBuffer();
-    
-    // 发送命令
-    serialPort.println(command);
-    serialPort.flush();
-    debugPrint("发送AT命令: " + command);
+    while (index < commands.size()) {
+        // 从index开始尽量多地拼接扩展命令，总长不超过模块的命令行上限
+        String line = commands[index];
+        size_t groupEnd = index + 1;
+        if (line.startsWith("AT+")) {
+            while (groupEnd < commands.size() && commands[groupEnd].startsWith("AT+") &&
+                   line.length() + commands[groupEnd].length() - 1 <= AT_COMMAND_BATCH_MAX_LENGTH) {
+                line += ";";
+                line += commands[groupEnd].substring(2);
+                groupEnd++;
+            }
+        }
+        
+        size_t groupSize = groupEnd - index;
+        if (groupSize > 1) {
+            LOG_DEBUG_PRINT("批量发送 " + String((unsigned long)groupSize) + " 条命令: " + line);
+        }
+        totalCommands += groupSize;
+        response = runTransaction(MODEM_TXN_COMMAND, line + "\r\n", "OK", timeout);
+        
+        if (response.result == AT_RESULT_SUCCESS) {
+            successfulCommands += groupSize;
+            index = groupEnd;
+            continue;
+        }
+        
+        if (groupSize == 1) {
+            failedCommands++;
+            lastFailedCommand = line;
+            lastFailedResponse = response.response;
+            setError("AT命令失败: " + line + ", 响应: " + response.response);
+            break;
+        }
+        
+        // 拼接行失败：模块在第一条出错的命令处停止，逐条重发以定位失败命令
+        LOG_DEBUG_PRINT("批量命令失败，改为逐条发送: " + response.response);
+        totalCommands -= groupSize;
+        for (size_t i = index; i < groupEnd; i++) {
+            response = sendCommand(commands[i], "OK", timeout);
+            if (response.result != AT_RESULT_SUCCESS) {
+                break;
+            }
+        }
+        if (response.result != AT_RESULT_SUCCESS) {
+            break;
+        }
+        index = groupEnd;
+    }
     
-    // 读取完整响应
-    response.response = readResponse(timeout);
     response.duration = millis() - startTime;
+    return response;
+}
+
+/**
+ * @brief 发送AT命令并获取完整响应
+ * @param command AT命令
+ * @param timeout 超时时间（毫秒）
+ * @return AtResponse 命令执行结果
+ */
+AtResponse AtCommandHandler::sendCommandWithFullResponse(const String& command, 
+                                                        unsigned long timeout) {
+    LOG_DEBUG_PRINT("发送AT命令: " + command);
+    
+    // 读取到最终结果码为止的完整响应
+    AtResponse response = runTransaction(MODEM_TXN_COMMAND, command + "\r\n", "", timeout);
     
-    if (response.response.length() == 0) {
-        response.result = AT_RESULT_TIMEOUT;
+    // 模块返回ERROR时内容仍需交给调用方解析
+    if (response.result == AT_RESULT_ERROR) {
+        response.result = AT_RESULT_SUCCESS;
+    }
+    if (response.result == AT_RESULT_TIMEOUT) {
         setError("命令超时: " + command);
     }
     
-    debugPrint("完整响应: " + response.response);
+    LOG_DEBUG_PRINT("完整响应: " + response.response);
     return response;
 }
 
 /**
- * @brief 发送原始数据
- * @param data 要发送的数据
+ * @brief 发送AT命令并读取到指定结束行为止
+ * @param command AT命令
+ * @param terminator 结束行（整行匹配）
  * @param timeout 超时时间（毫秒）
- * @return AtResponse 执行结果
+ * @return AtResponse 命令执行结果
  */
-AtResponse AtCommandHandler::sendRawData(const String& data, unsigned long timeout) {
-    AtResponse response;
-    response.result = AT_RESULT_SUCCESS;
+AtResponse AtCommandHandler::sendCommandUntil(const String& command,
+                                             const String& terminator,
+                                             unsigned long timeout) {
+    LOG_DEBUG_PRINT("发送AT命令: " + command + "，结束行: " + terminator);
     
-    unsigned long startTime = millis();
-    
-    // 发送原始数据（不添加换行符）
-    serialPort.print(data);
-    serialPort.flush();
-    debugPrint("发送原始数据: " + data);
+    AtResponse response = runTransaction(MODEM_TXN_COMMAND, command + "\r\n", "", timeout, terminator);
+    if (response.result != AT_RESULT_SUCCESS) {
+        setError("命令未正常结束: " + command + ", 响应: " + response.response);
+    }
+    return response;
+}
+
+/**
+ * @brief 发送AT命令，把声明了长度的数据段交给回调，并读取到指定结束行为止
+ * @param command AT命令
+ * @param dataHeader 声明数据长度的行前缀
+ * @param terminator 结束行（整行匹配）
+ * @param reader 数据段读取回调
+ * @param context 回调上下文
+ * @param timeout 超时时间（毫秒）
+ * @return AtResponse 命令执行结果
+ */
+AtResponse AtCommandHandler::sendCommandReadData(const String& command,
+                                                const char* dataHeader,
+                                                const String& terminator,
+                                                ModemDataReader reader,
+                                                void* context,
+                                                unsigned long timeout) {
+    LOG_DEBUG_PRINT("发送AT命令: " + command + "，数据段前缀: " + String(dataHeader) + "，结束行: " + terminator);
     
-    // 读取响应
-    response.response = readResponse(timeout);
-    response.duration = millis() - startTime;
+    String payload = command + "\r\n";
+    ModemTransaction transaction;
+    prepareTransaction(transaction, MODEM_TXN_COMMAND, payload, "", timeout);
+    transaction.terminator = terminator.c_str();
+    transaction.dataHeader = dataHeader;
+    transaction.reader = reader;
+    transaction.readerContext = context;
     
-    if (response.response.length() == 0) {
-        response.result = AT_RESULT_TIMEOUT;
-        setError("发送数据超时");
+    AtResponse response = runTransaction(transaction);
+    if (response.result != AT_RESULT_SUCCESS) {
+        setError("命令未正常结束: " + command + ", 响应: " + response.response);
     }
+    return response;
+}
+
+/**
+ * @brief 发送需要提示符的AT命令，收到提示符后写入数据并等待结果
+ * @param command AT命令
+ * @param prompt 提示符
+ * @param data 收到提示符后写入的数据
+ * @param writer 在data之后继续分块提供数据的回调
+ * @param context 回调上下文
+ * @param promptTimeout 等待提示符的超时时间（毫秒）
+ * @param dataTimeout 数据写入后等待结果的超时时间（毫秒）
+ * @return AtResponse 执行结果
+ */
+AtResponse AtCommandHandler::sendCommandWithData(const String& command,
+                                                const char* prompt,
+                                                const String& data,
+                                                ModemPayloadWriter writer,
+                                                void* context,
+                                                unsigned long promptTimeout,
+                                                unsigned long dataTimeout) {
+    LOG_DEBUG_PRINT("发送AT命令: " + command + "，提示符: " + String(prompt) +
+                    "，数据长度: " + String((unsigned long)data.length()));
+    
+    String payload = command + "\r\n";
+    ModemTransaction transaction;
+    prepareTransaction(transaction, MODEM_TXN_COMMAND, payload, "", promptTimeout);
+    transaction.prompt = prompt;
+    transaction.body = data.c_str();
+    transaction.bodyLength = data.length();
+    transaction.bodyTimeout = dataTimeout;
+    transaction.writer = writer;
+    transaction.writerContext = context;
     
+    AtResponse response = runTransaction(transaction);
+    if (response.result != AT_RESULT_SUCCESS) {
+        setError("命令或数据发送失败: " + command + ", 响应: " + response.response);
+    }
     return response;
 }
 
 /**
  * @brief 等待特定响应
+ * 
+ * 命令返回OK之后才上报的结果（如+HTTPACTION:）即使在调用本方法之前到达，
+ * 也会由仲裁器暂存并在此匹配
  * @param expectedResponse 期望的响应
  * @param timeout 超时时间（毫秒）
  * @return AtResponse 执行结果
  */
 AtResponse AtCommandHandler::waitForResponse(const String& expectedResponse, 
                                             unsigned long timeout) {
-    AtResponse response;
-    response.result = AT_RESULT_TIMEOUT;
+    LOG_DEBUG_PRINT("等待响应: " + expectedResponse);
     
-    unsigned long startTime = millis();
-    String rawResponse = "";
-    unsigned long lastCharTime = startTime;
-    bool hasData = false;
+    AtResponse response = runTransaction(MODEM_TXN_WAIT, "", expectedResponse, timeout);
     
-    debugPrint("等待响应: " + expectedResponse);
-    
-    // 优化的等待逻辑：一旦收到期望响应就立即返回
-    while (millis() - startTime < timeout) {
-        if (serialPort.available()) {
-            char c = serialPort.read();
-            rawResponse += c;
-            lastCharTime = millis();
-            hasData = true;
-            
-            // 检查是否收到期望响应
-            if (rawResponse.indexOf(expectedResponse) != -1) {
-                // 等待一小段时间确保完整响应
-                delay(50);
-                // 读取剩余数据
-                while (serialPort.available()) {
-                    rawResponse += (char)serialPort.read();
-                }
-                response.result = AT_RESULT_SUCCESS;
-                debugPrint("收到期望响应: " + rawResponse);
-                break;
-            }
-        } else if (hasData && (millis() - lastCharTime > 200)) {
-            // 如果已经有数据且200ms内没有新数据，检查是否包含期望响应
-            if (rawResponse.indexOf(expectedResponse) != -1) {
-                response.result = AT_RESULT_SUCCESS;
-                debugPrint("收到期望响应: " + rawResponse);
-                break;
-            }
-        }
-        vTaskDelay(1); // 让出CPU时间
-    }
-    
-    response.response = rawResponse;
-    response.duration = millis() - startTime;
-    
-    if (response.result != AT_RESULT_SUCCESS) {
-        setError("未收到期望响应: " + expectedResponse + ", 实际响应: " + rawResponse);
+    if (response.result == AT_RESULT_SUCCESS) {
+        LOG_DEBUG_PRINT("收到期望响应: " + response.response);
+    } else {
+        setError("未收到期望响应: " + expectedResponse + ", 实际响应: " + response.response);
     }
     
     return response;
 }
 
 /**
- * @brief 清空串口缓冲区
+ * @brief 丢弃仲裁器中暂存的主动上报数据
  */
 void AtCommandHandler::clearBuffer() {
-    while (serialPort.available()) {
-        serialPort.read();
-    }
+    runTransaction(MODEM_TXN_DISCARD, "", "", 0);
 }
 
 /**
@@ -305,44 +435,96 @@ void AtCommandHandler::setDebugMode(bool enabled) {
 }
 
 /**
- * @brief 读取串口响应
+ * @brief 填写AT事务的基本字段，其余可选字段置空
+ * @param transaction 事务描述
+ * @param kind 事务类型
+ * @param payload 写入串口的数据
+ * @param expectedResponse 期望的响应
  * @param timeout 超时时间（毫秒）
- * @return String 响应内容
  */
-String AtCommandHandler::readResponse(unsigned long timeout) {
-    unsigned long startTime = millis();
-    String response = "";
-    unsigned long lastCharTime = startTime;
-    bool hasData = false;
+void AtCommandHandler::prepareTransaction(ModemTransaction& transaction, ModemTransactionKind kind,
+                                          const String& payload, const String& expectedResponse,
+                                          unsigned long timeout) {
+    transaction.kind = kind;
+    transaction.payload = payload.c_str();
+    transaction.payloadLength = payload.length();
+    transaction.prompt = nullptr;
+    transaction.body = nullptr;
+    transaction.bodyLength = 0;
+    transaction.bodyTimeout = 0;
+    transaction.writer = nullptr;
+    transaction.writerContext = nullptr;
+    transaction.expected = expectedResponse.c_str();
+    transaction.terminator = nullptr;
+    transaction.dataHeader = nullptr;
+    transaction.reader = nullptr;
+    transaction.readerContext = nullptr;
+    transaction.timeout = timeout;
+}
+
+/**
+ * @brief 向仲裁器提交一个AT事务
+ * @param kind 事务类型
+ * @param payload 写入串口的数据
+ * @param expectedResponse 期望的响应，""表示以最终结果码为准
+ * @param timeout 超时时间（毫秒）
+ * @param terminator 结束行，""表示以最终结果码为准
+ * @return AtResponse 执行结果
+ */
+AtResponse AtCommandHandler::runTransaction(ModemTransactionKind kind, const String& payload,
+                                            const String& expectedResponse, unsigned long timeout,
+                                            const String& terminator) {
+    ModemTransaction transaction;
+    prepareTransaction(transaction, kind, payload, expectedResponse, timeout);
+    transaction.terminator = terminator.c_str();
+    return runTransaction(transaction);
+}
+
+/**
+ * @brief 向仲裁器提交已填写好的AT事务，记录指标并转换执行结果
+ * @param transaction 事务描述
+ * @return AtResponse 执行结果
+ */
+AtResponse AtCommandHandler::runTransaction(ModemTransaction& transaction) {
+    ModemTransactionKind kind = transaction.kind;
+    ModemTransactionStatus status = arbiter.execute(transaction);
     
-    while (millis() - startTime < timeout) {
-        if (serialPort.available()) {
-            char c = serialPort.read();
-            response += c;
-            lastCharTime = millis();
-            hasData = true;
-            
-            // 检查是否收到完整响应（以OK、ERROR或特定响应结束）
-            if (response.indexOf("OK\r\n") != -1 || 
-                response.indexOf("ERROR\r\n") != -1 ||
-                response.indexOf("+HTTPACTION:") != -1) {
-                // 等待一小段时间确保没有更多数据
-                delay(50);
-                // 读取剩余数据
-                while (serialPort.available()) {
-                    response += (char)serialPort.read();
-                }
-                break;
-            }
-        } else if (hasData && (millis() - lastCharTime > 100)) {
-            // 如果已经有数据且100ms内没有新数据，认为响应完成
-            break;
+    AtResponse response;
+    response.response = transaction.response;
+    response.response.trim();
+    response.duration = transaction.duration + transaction.queueWait;
+    
+    if (kind != MODEM_TXN_DISCARD && status != MODEM_TXN_BUSY) {
+        char command[METRICS_LABEL_MAX_LENGTH + 1];
+        commandMetricLabel(kind, transaction.payload, command, sizeof(command));
+        MetricsRegistry& metrics = MetricsRegistry::getInstance();
+        metrics.observe(METRIC_AT_COMMAND, (uint32_t)response.duration * 1000, command);
+        if (status == MODEM_TXN_TIMEOUT) {
+            metrics.increment(METRIC_AT_TIMEOUTS, command);
         }
-        vTaskDelay(1); // 让出CPU时间
     }
     
-    response.trim();
-    debugPrint("收到响应: " + response);
+    switch (status) {
+        case MODEM_TXN_OK:
+            response.result = AT_RESULT_SUCCESS;
+            break;
+        case MODEM_TXN_TIMEOUT:
+            response.result = AT_RESULT_TIMEOUT;
+            break;
+        case MODEM_TXN_ERROR:
+            response.result = AT_RESULT_ERROR;
+            break;
+        case MODEM_TXN_BUSY:
+            response.result = AT_RESULT_BUSY;
+            setError("调制解调器仲裁器不可用: " + arbiter.getLastError());
+            break;
+        case MODEM_TXN_INVALID:
+        default:
+            response.result = AT_RESULT_INVALID;
+            break;
+    }
+    
+    LOG_DEBUG_PRINT("收到响应: " + response.response);
     return response;
 }
 
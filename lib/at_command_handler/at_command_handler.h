@@ -9,6 +9,9 @@
  * 2. AT命令的超时管理
  * 3. 响应解析和错误处理
  * 4. 命令队列管理
+ *
+ * 串口由ModemArbiter独占读写，本类的所有操作都以AT事务的形式提交给仲裁器；
+ * 每个SIM模块一个实例，绑定该模块的仲裁器
  */
 
 #ifndef AT_COMMAND_HANDLER_H
@@ -16,6 +19,8 @@
 
 #include <Arduino.h>
 #include <queue>
+#include <vector>
+#include "../modem_arbiter/modem_arbiter.h"
 
 /**
  * @enum AtCommandResult
@@ -60,9 +65,9 @@ class AtCommandHandler {
 public:
     /**
      * @brief 构造函数
-     * @param serial 串口对象引用
+     * @param arbiter 所属SIM模块的仲裁器
      */
-    AtCommandHandler(HardwareSerial& serial);
+    explicit AtCommandHandler(ModemArbiter& arbiter);
     
     /**
      * @brief 析构函数
@@ -89,6 +94,18 @@ public:
                           unsigned long timeout = 3000,
                           int retries = 0);
     
+    /**
+     * @brief 批量发送扩展AT命令
+     * 
+     * 以"AT+A;+B;+C"的形式把多条扩展命令拼接为一行发送，整行只等待一次最终结果码；
+     * 拼接行返回错误时逐条重发以定位失败的命令（适用于可重复执行的设置类命令）
+     * @param commands AT命令列表（以"AT+"开头的命令参与拼接，其余单独发送）
+     * @param timeout 每行的超时时间（毫秒）
+     * @return AtResponse 最后一行（或失败命令）的执行结果
+     */
+    AtResponse sendCommandBatch(const std::vector<String>& commands, 
+                               unsigned long timeout = 3000);
+    
     /**
      * @brief 发送AT命令并获取完整响应
      * @param command AT命令
@@ -99,12 +116,60 @@ public:
                                           unsigned long timeout = 3000);
     
     /**
-     * @brief 发送原始数据
-     * @param data 要发送的数据
+     * @brief 发送AT命令并读取到指定结束行为止
+     * 
+     * 用于在最终结果码之后才输出数据的命令，如AT+HTTPREAD以"+HTTPREAD: 0"结束
+     * @param command AT命令
+     * @param terminator 结束行（整行匹配）
      * @param timeout 超时时间（毫秒）
-     * @return AtResponse 执行结果
+     * @return AtResponse 命令执行结果
+     */
+    AtResponse sendCommandUntil(const String& command,
+                               const String& terminator,
+                               unsigned long timeout = 3000);
+    
+    /**
+     * @brief 发送AT命令，把以"<前缀> <n>"声明的n字节数据段原样交给回调，并读取到指定结束行为止
+     * 
+     * 用于AT+HTTPREAD：响应体按长度读取，其中的空行、首尾空白、ERROR或URC前缀都不会被当作响应行处理；
+     * 数据段不写入AtResponse::response，回调在仲裁任务中执行，不能再提交AT命令
+     * @param command AT命令
+     * @param dataHeader 声明数据长度的行前缀（如"+HTTPREAD:"）
+     * @param terminator 结束行（整行匹配）
+     * @param reader 数据段读取回调
+     * @param context 回调上下文
+     * @param timeout 超时时间（毫秒）
+     * @return AtResponse 命令执行结果
+     */
+    AtResponse sendCommandReadData(const String& command,
+                                  const char* dataHeader,
+                                  const String& terminator,
+                                  ModemDataReader reader,
+                                  void* context,
+                                  unsigned long timeout = 3000);
+    
+    /**
+     * @brief 发送需要提示符的AT命令，收到提示符后写入数据并等待结果
+     * 
+     * 命令、提示符与数据在仲裁器的同一个事务内完成（如AT+CMGS与PDU、AT+HTTPDATA与请求体），
+     * 等待提示符期间其他模块提交的命令不会写入串口、混入数据。
+     * 未收到提示符时数据不会写入；结果以数据写入后的最终结果码为准
+     * @param command AT命令
+     * @param prompt 提示符（如">"、"DOWNLOAD"）
+     * @param data 收到提示符后写入的数据（不添加换行符）
+     * @param writer 在data之后继续分块提供数据的回调（nullptr表示无，在仲裁任务中调用）
+     * @param context 回调上下文
+     * @param promptTimeout 等待提示符的超时时间（毫秒）
+     * @param dataTimeout 数据写入后等待结果的超时时间（毫秒）
+     * @return AtResponse 执行结果（响应包含提示符之前与数据写入之后的内容）
      */
-    AtResponse sendRawData(const String& data, unsigned long timeout = 3000);
+    AtResponse sendCommandWithData(const String& command,
+                                  const char* prompt,
+                                  const String& data,
+                                  ModemPayloadWriter writer,
+                                  void* context,
+                                  unsigned long promptTimeout,
+                                  unsigned long dataTimeout);
     
     /**
      * @brief 等待特定响应
@@ -116,7 +181,7 @@ public:
                               unsigned long timeout = 3000);
     
     /**
-     * @brief 清空串口缓冲区
+     * @brief 丢弃仲裁器中暂存的主动上报数据
      */
     void clearBuffer();
     
@@ -140,13 +205,26 @@ public:
     void setDebugMode(bool enabled);
     
     /**
-     * @brief 获取单例实例
-     * @return AtCommandHandler& 单例引用
+     * @brief 获取所属SIM模块的仲裁器
+     * @return ModemArbiter& 仲裁器引用
+     */
+    ModemArbiter& getArbiter();
+    
+    /**
+     * @brief 获取主SIM模块的AT命令处理器
+     * @return AtCommandHandler& 实例引用
      */
     static AtCommandHandler& getInstance();
+    
+    /**
+     * @brief 获取指定SIM模块的AT命令处理器
+     * @param index 模块序号（0为主模块，超出SIM_MODEM_COUNT时返回主模块）
+     * @return AtCommandHandler& 实例引用
+     */
+    static AtCommandHandler& getModem(uint8_t index);
 
 private:
-    HardwareSerial& serialPort; ///< 串口对象引用
+    ModemArbiter& arbiter;      ///< 所属SIM模块的仲裁器
     String lastError;           ///< 最后的错误信息
     bool debugMode;            ///< 调试模式
     bool initialized;          ///< 是否已初始化
@@ -161,11 +239,36 @@ private:
     String lastFailedResponse;       ///< 最后失败的响应
     
     /**
-     * @brief 读取串口响应
+     * @brief 填写AT事务的基本字段，其余可选字段（提示符、流式载荷、数据段读取等）置空
+     * @param transaction 事务描述
+     * @param kind 事务类型
+     * @param payload 写入串口的数据（须在事务期间保持有效）
+     * @param expectedResponse 期望的响应，""表示以最终结果码为准（须在事务期间保持有效）
      * @param timeout 超时时间（毫秒）
-     * @return String 响应内容
      */
-    String readResponse(unsigned long timeout);
+    static void prepareTransaction(ModemTransaction& transaction, ModemTransactionKind kind,
+                                   const String& payload, const String& expectedResponse,
+                                   unsigned long timeout);
+    
+    /**
+     * @brief 向仲裁器提交一个AT事务
+     * @param kind 事务类型
+     * @param payload 写入串口的数据
+     * @param expectedResponse 期望的响应，""表示以最终结果码为准
+     * @param timeout 超时时间（毫秒）
+     * @param terminator 结束行，""表示以最终结果码为准
+     * @return AtResponse 执行结果
+     */
+    AtResponse runTransaction(ModemTransactionKind kind, const String& payload,
+                              const String& expectedResponse, unsigned long timeout,
+                              const String& terminator = "");
+    
+    /**
+     * @brief 向仲裁器提交已填写好的AT事务，记录指标并转换执行结果
+     * @param transaction 事务描述
+     * @return AtResponse 执行结果
+     */
+    AtResponse runTransaction(ModemTransaction& transaction);
     
     /**
      * @brief 设置错误信息
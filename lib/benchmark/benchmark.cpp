@@ -0,0 +1,361 @@
+/**
+ * @file benchmark.cpp
+ * @brief 性能基准测试实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "benchmark.h"
+#include "../push_manager/push_manager.h"
+#include "../push_manager/message_template.h"
+#include "../carrier_config/carrier_config.h"
+#include "../pdu_decoder/pdu_decoder.h"
+#include "../pdu_encoder/pdu_encoder.h"
+#include "../database_manager/database_manager.h"
+#include "../db_worker/db_worker.h"
+#include "../at_command_handler/at_command_handler.h"
+#include "../http_client/http_client.h"
+#include "../../include/constants.h"
+#include <pdulib.h>
+
+/// GSM 7位编码的单条短信（"How are you?"）
+static const char* BENCH_PDU_GSM7 =
+    "07911326040000F0040B911346610089F60000208062917314080CC8F71D14969741F977FD07";
+
+/// UCS2编码的长短信分片（16位参考号，含代理对字符）
+static const char* BENCH_PDU_UCS2 =
+    "0891683108200105F0440D91683119325476F800084210412143002315060804123403024F60597DFF0C4E16754CD83DDE00";
+
+/// 发送编码样例：纯英文单条、中文单条与中英混排长短信
+static const char* BENCH_SMS_GSM7 = "Your verification code is 834921. It expires in 5 minutes. Do not share it with anyone.";
+static const char* BENCH_SMS_UCS2 = "【某银行】您的验证码为834921，5分钟内有效，请勿泄露。";
+static const char* BENCH_SMS_MIXED =
+    "Server alert: disk usage on db-01 reached 91% at 02:14, cleanup job failed with exit code 3. "
+    "服务器告警：磁盘使用率超过阈值，请尽快处理。 Next check in 15 minutes; escalate to on-call if usage keeps rising. "
+    "Ticket INC-20240601-0042 has been opened automatically.";
+
+/// 覆盖全部占位符的消息模板
+static const char* BENCH_TEMPLATE =
+    "{\"msgtype\":\"text\",\"text\":{\"content\":\"📱 来自 {sender}\\n⏰ {timestamp}\\n🆔 {sms_id}\\n{content}\"}}";
+
+/**
+ * @brief 构造样例推送上下文
+ * @param sender 发送方号码
+ * @param content 短信内容
+ * @return PushContext 推送上下文（不启动链路追踪）
+ */
+static PushContext makeSampleContext(const char* sender, const char* content) {
+    PushContext context;
+    context.sender = sender;
+    context.content = content;
+    context.timestamp = "24/06/01,12:30:45+32";
+    context.smsRecordId = 12345;
+    return context;
+}
+
+/**
+ * @brief 规则匹配：分别以命中与不命中关键词规则的短信匹配当前规则快照
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runMatchSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    PushManager& pushManager = PushManager::getInstance();
+    results.push_back(pushManager.benchmarkRuleMatch("match/验证码短信",
+        makeSampleContext("10690000", "【某银行】您的验证码为834921，5分钟内有效，请勿泄露。"), iterations));
+    results.push_back(pushManager.benchmarkRuleMatch("match/普通短信",
+        makeSampleContext("+8613800138000", "晚上一起吃饭吗？"), iterations));
+}
+
+/**
+ * @brief 消息模板：每次编译后渲染（applyTemplate的做法）与预编译后只渲染
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runTemplateSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    PushContext context = makeSampleContext("+8613800138000", "您的验证码为834921，5分钟内有效。\"引号\"与\\反斜杠需要转义");
+    String templateStr = BENCH_TEMPLATE;
+
+    results.push_back(Benchmark::run("template/编译+渲染", iterations, [&]() {
+        CompiledTemplate compiled(templateStr);
+        compiled.render(context.sender, context.content, context.timestamp, context.smsRecordId, true);
+    }));
+
+    CompiledTemplate precompiled(templateStr);
+    results.push_back(Benchmark::run("template/预编译渲染", iterations, [&]() {
+        precompiled.render(context.sender, context.content, context.timestamp, context.smsRecordId, true);
+    }));
+}
+
+/**
+ * @brief 运营商识别：依次识别三家运营商与未知运营商的IMSI
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runCarrierSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    static const char* imsis[] = {
+        "460001234567890", "460011234567890", "460111234567890", "310260123456789"
+    };
+    CarrierConfig& carrierConfig = CarrierConfig::getInstance();
+
+    results.push_back(Benchmark::run("carrier/识别IMSI", iterations, [&]() {
+        for (const char* imsi : imsis) {
+            carrierConfig.identifyCarrier(String(imsi));
+        }
+    }));
+}
+
+/**
+ * @brief PDU解码：GSM 7位编码与UCS2编码各一条
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runPduSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    static char text[SMS_PDU_TEXT_BUFFER_SIZE];
+    SmsPdu pdu;
+
+    struct Sample {
+        const char* name;
+        const char* hex;
+    };
+    static const Sample samples[] = {
+        {"pdu/GSM7", BENCH_PDU_GSM7},
+        {"pdu/UCS2长短信分片", BENCH_PDU_UCS2}
+    };
+
+    for (const Sample& sample : samples) {
+        size_t length = strlen(sample.hex);
+        // 样例无法解码时不计入结果，避免把失败路径当作解码耗时
+        int count = decodeSmsPdu(sample.hex, length, pdu, text, sizeof(text)) ? iterations : 0;
+        results.push_back(Benchmark::run(sample.name, count, [&]() {
+            decodeSmsPdu(sample.hex, length, pdu, text, sizeof(text));
+        }));
+    }
+}
+
+/**
+ * @brief 短信发送编码：pdulib与查表编码器分别编码单条短信，以及混排长短信的分段规划与逐段编码
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runSmsEncodeSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    static const char* sca = "+8613800100500";
+    static const char* recipient = "+8613800138000";
+    static char output[SMS_SEND_PDU_BUFFER_SIZE];
+    PDU pdulib(SMS_SEND_PDU_BUFFER_SIZE);
+    pdulib.setSCAnumber(sca);
+
+    struct Sample {
+        const char* name;
+        const char* text;
+    };
+    static const Sample samples[] = {
+        {"GSM7", BENCH_SMS_GSM7},
+        {"UCS2", BENCH_SMS_UCS2}
+    };
+
+    for (const Sample& sample : samples) {
+        size_t length = strlen(sample.text);
+        results.push_back(Benchmark::runChecked("sms-encode/pdulib " + String(sample.name), iterations, [&]() {
+            return pdulib.encodePDU(recipient, sample.text) > 0;
+        }));
+        results.push_back(Benchmark::runChecked("sms-encode/查表 " + String(sample.name), iterations, [&]() {
+            SmsSegmentPlan plan;
+            return planSmsSegments(sample.text, length, plan) &&
+                   encodeSmsSubmit(sca, recipient, sample.text, length, plan.parts[0].alphabet,
+                                   0, 0, 0, output, sizeof(output)) > 0;
+        }));
+    }
+
+    // 混排长短信：英文段落按GSM 7位、含中文的分段按UCS2编码
+    size_t length = strlen(BENCH_SMS_MIXED);
+    results.push_back(Benchmark::runChecked("sms-encode/混排长短信", iterations, [&]() {
+        SmsSegmentPlan plan;
+        if (!planSmsSegments(BENCH_SMS_MIXED, length, plan)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < plan.count; i++) {
+            const SmsSegment& segment = plan.parts[i];
+            if (encodeSmsSubmit(sca, recipient, BENCH_SMS_MIXED + segment.offset, segment.length, segment.alphabet,
+                                0x42, plan.count, i + 1, output, sizeof(output)) <= 0) {
+                return false;
+            }
+        }
+        return true;
+    }));
+}
+
+/**
+ * @brief 数据库查询：分页列表、计数与全文搜索（数据库未就绪时不执行）
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runDbQuerySuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    DatabaseManager& database = DatabaseManager::getInstance();
+    // SQLite连接由数据库工作线程独占，整组测量投递给它执行
+    bool executed = DbWorker::getInstance().call([&]() {
+        int count = database.isReady() ? iterations : 0;
+        results.push_back(Benchmark::run("db-query/最近20条", count, [&]() {
+            database.getSMSRecords(20, 0);
+        }));
+        results.push_back(Benchmark::run("db-query/记录总数", count, [&]() {
+            database.getSMSRecordCount();
+        }));
+        results.push_back(Benchmark::run("db-query/搜索", count, [&]() {
+            database.searchSMS("验证码", 20);
+        }));
+    });
+    if (!executed) {
+        results.push_back(Benchmark::run("db-query/数据库繁忙", 0, nullptr));
+    }
+}
+
+/**
+ * @brief 数据库插入：在独立测量表中逐条提交与在一个事务内插入（数据库未就绪时不执行）
+ * @param iterations 执行次数
+ * @param arg 未使用
+ * @param results 输出：测量结果
+ */
+static void runDbInsertSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    (void)arg;
+    DatabaseManager& database = DatabaseManager::getInstance();
+    bool executed = DbWorker::getInstance().call([&]() {
+        bool ready = database.prepareInsertBenchmark();
+        int count = ready ? iterations : 0;
+        // 每条单独提交：包含日志与同步开销，对应入库时提交窗口未打开的情况
+        results.push_back(Benchmark::runChecked("db-insert/单条提交", count, [&]() {
+            return database.insertBenchmarkRecord();
+        }));
+        // 事务内插入：只计语句执行，提交在测量之外
+        bool inTransaction = ready && database.beginTransaction();
+        results.push_back(Benchmark::runChecked("db-insert/事务内", inTransaction ? iterations : 0, [&]() {
+            return database.insertBenchmarkRecord();
+        }));
+        if (inTransaction) {
+            database.commitTransaction();
+        }
+        database.finishInsertBenchmark();
+    });
+    if (!executed) {
+        results.push_back(Benchmark::run("db-insert/数据库繁忙", 0, nullptr));
+    }
+}
+
+/**
+ * @brief AT命令往返：经调制解调器仲裁器向模块发送命令并等待OK
+ * @param iterations 执行次数
+ * @param arg AT命令（为空时为"AT"）
+ * @param results 输出：测量结果
+ */
+static void runAtSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    String command = arg.isEmpty() ? String("AT") : arg;
+    AtCommandHandler& handler = AtCommandHandler::getInstance();
+    results.push_back(Benchmark::runChecked("at/" + command, iterations, [&]() {
+        return handler.sendCommand(command, "OK", BENCH_AT_TIMEOUT_MS).result == AT_RESULT_SUCCESS;
+    }));
+}
+
+/**
+ * @brief HTTP请求：以推送使用的HTTP客户端（WiFi或模块）发出GET请求，不读取响应体
+ * @param iterations 执行次数
+ * @param arg URL（为空时为BENCH_HTTP_DEFAULT_URL）
+ * @param results 输出：测量结果
+ */
+static void runHttpSuite(int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    HttpRequest request;
+    request.url = arg.isEmpty() ? String(BENCH_HTTP_DEFAULT_URL) : arg;
+    request.method = HTTP_CLIENT_GET;
+    request.readBody = false;
+    request.timeout = BENCH_HTTP_TIMEOUT_MS;
+    HttpClient& client = HttpClient::getInstance();
+    results.push_back(Benchmark::runChecked("http/GET", iterations, [&]() {
+        HttpResponse response = client.request(request);
+        return response.error == HTTP_SUCCESS && response.statusCode > 0 && response.statusCode < 400;
+    }));
+}
+
+/**
+ * @struct BenchmarkSuite
+ * @brief 测试组
+ */
+struct BenchmarkSuite {
+    const char* name;               ///< 测试组名称
+    const char* description;        ///< 说明
+    int defaultIterations;          ///< 默认执行次数
+    bool offline;                   ///< 是否只测纯逻辑与查询（包含在"all"中）
+    void (*run)(int iterations, const String& arg, std::vector<BenchmarkResult>& results); ///< 执行函数
+};
+
+/// 全部测试组（"all"按此顺序执行其中的离线测试组）
+static const BenchmarkSuite BENCHMARK_SUITES[] = {
+    {"match", "规则匹配", BENCH_DEFAULT_ITERATIONS, true, runMatchSuite},
+    {"template", "消息模板渲染", BENCH_DEFAULT_ITERATIONS, true, runTemplateSuite},
+    {"carrier", "运营商识别", BENCH_DEFAULT_ITERATIONS, true, runCarrierSuite},
+    {"pdu", "PDU解码", BENCH_DEFAULT_ITERATIONS, true, runPduSuite},
+    {"sms-encode", "短信发送编码", BENCH_DEFAULT_ITERATIONS, true, runSmsEncodeSuite},
+    {"db-query", "数据库查询", BENCH_DEFAULT_ITERATIONS, true, runDbQuerySuite},
+    {"db-insert", "数据库插入（独立测量表，写入flash）", BENCH_DB_INSERT_DEFAULT_ITERATIONS, false, runDbInsertSuite},
+    {"at", "AT命令往返 [命令]", BENCH_AT_DEFAULT_ITERATIONS, false, runAtSuite},
+    {"http", "HTTP GET [URL]", BENCH_HTTP_DEFAULT_ITERATIONS, false, runHttpSuite}
+};
+
+/**
+ * @brief 执行一个测试组
+ * @param suite 测试组名称（见getSuiteNames()），"all"表示全部离线测试组
+ * @param iterations 每项的执行次数（0表示使用测试组的默认次数）
+ * @param arg 测试组参数，为空时使用默认值
+ * @param results 输出：测量结果
+ * @return true 测试组存在
+ * @return false 未知的测试组
+ */
+bool Benchmark::runSuite(const String& suite, int iterations, const String& arg, std::vector<BenchmarkResult>& results) {
+    bool all = suite == "all";
+    bool found = false;
+    for (const BenchmarkSuite& entry : BENCHMARK_SUITES) {
+        if ((all && entry.offline) || suite == entry.name) {
+            entry.run(iterations > 0 ? iterations : entry.defaultIterations, arg, results);
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief 获取所有测试组名称
+ * @return std::vector<String> 测试组名称
+ */
+std::vector<String> Benchmark::getSuiteNames() {
+    std::vector<String> names;
+    for (const BenchmarkSuite& entry : BENCHMARK_SUITES) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+/**
+ * @brief 获取测试组说明
+ * @return String 说明文本
+ */
+String Benchmark::getSuiteHelp() {
+    String help;
+    for (const BenchmarkSuite& entry : BENCHMARK_SUITES) {
+        String name = entry.name;
+        while (name.length() < 10) {
+            name += " ";
+        }
+        help += "  " + name + " " + String(entry.description) + "（默认" + String(entry.defaultIterations) + "次" +
+                (entry.offline ? "" : "，不含在all中") + "）\n";
+    }
+    return help;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file benchmark.h
+ * @brief 性能基准测试 - 在设备上对纯逻辑模块做可重复的耗时测量
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以固定次数重复执行被测代码，用esp_timer_get_time()逐次计时，统计中位数、P95、最大与平均耗时
+ * 2. 提供规则匹配、消息模板、运营商识别、PDU解码与数据库查询等测试组，
+ *    各组使用固定的样例输入，不同固件版本的结果可以直接对比
+ * 3. 另有针对运行中子系统的测试组：数据库插入（独立测量表）、AT命令往返与HTTP请求，
+ *    这些组会占用模块串口、网络或写入flash，不包含在"all"中，需单独指定
+ * 4. 测试组不收发短信、不发起推送；数据库测试在数据库工作线程中执行
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+#include <vector>
+#include <functional>
+
+/**
+ * @struct BenchmarkResult
+ * @brief 一项测量的结果
+ */
+struct BenchmarkResult {
+    String name;                    ///< 测量项名称
+    int iterations;                 ///< 执行次数（0表示测量未执行）
+    int failures;                   ///< 被测代码报告失败的次数（计入耗时统计）
+    unsigned long avgUs;            ///< 平均耗时（微秒）
+    unsigned long minUs;            ///< 最小耗时（微秒）
+    unsigned long p50Us;            ///< 中位数耗时（微秒）
+    unsigned long p95Us;            ///< 95分位耗时（微秒）
+    unsigned long maxUs;            ///< 最大耗时（微秒）
+};
+
+/**
+ * @brief 被测代码
+ */
+typedef std::function<void()> BenchmarkBody;
+
+/**
+ * @brief 可能失败的被测代码（返回false计为一次失败）
+ */
+typedef std::function<bool()> BenchmarkCheckedBody;
+
+/**
+ * @class Benchmark
+ * @brief 基准测试执行器
+ */
+class Benchmark {
+public:
+    /**
+     * @brief 重复执行被测代码并统计耗时
+     * @param name 测量项名称
+     * @param iterations 执行次数
+     * @param body 被测代码
+     * @return BenchmarkResult 测量结果
+     */
+    static BenchmarkResult run(const String& name, int iterations, const BenchmarkBody& body);
+
+    /**
+     * @brief 重复执行可能失败的被测代码并统计耗时与失败次数
+     * @param name 测量项名称
+     * @param iterations 执行次数
+     * @param body 被测代码
+     * @return BenchmarkResult 测量结果
+     */
+    static BenchmarkResult runChecked(const String& name, int iterations, const BenchmarkCheckedBody& body);
+
+    /**
+     * @brief 执行一个测试组
+     * @param suite 测试组名称（见getSuiteNames()），"all"表示全部离线测试组
+     * @param iterations 每项的执行次数（0表示使用测试组的默认次数）
+     * @param arg 测试组参数（at：AT命令；http：URL），为空时使用默认值
+     * @param results 输出：测量结果
+     * @return true 测试组存在
+     * @return false 未知的测试组
+     */
+    static bool runSuite(const String& suite, int iterations, const String& arg, std::vector<BenchmarkResult>& results);
+
+    /**
+     * @brief 获取所有测试组名称
+     * @return std::vector<String> 测试组名称
+     */
+    static std::vector<String> getSuiteNames();
+
+    /**
+     * @brief 获取测试组说明（每组一行：名称、默认次数与说明）
+     * @return String 说明文本
+     */
+    static String getSuiteHelp();
+
+    /**
+     * @brief 格式化测量结果（一行）
+     * @param result 测量结果
+     * @return String 格式化文本
+     */
+    static String format(const BenchmarkResult& result);
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,102 @@
+/**
+ * @file benchmark_runner.cpp
+ * @brief 基准测试执行器实现（计时与统计，不依赖被测子系统，主机测试也使用）
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "benchmark.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <algorithm>
+
+/**
+ * @brief 重复执行被测代码并统计耗时
+ * @param name 测量项名称
+ * @param iterations 执行次数
+ * @param body 被测代码
+ * @return BenchmarkResult 测量结果
+ */
+BenchmarkResult Benchmark::run(const String& name, int iterations, const BenchmarkBody& body) {
+    if (!body) {
+        return runChecked(name, 0, nullptr);
+    }
+    return runChecked(name, iterations, [&body]() {
+        body();
+        return true;
+    });
+}
+
+/**
+ * @brief 重复执行可能失败的被测代码并统计耗时与失败次数
+ * @param name 测量项名称
+ * @param iterations 执行次数
+ * @param body 被测代码
+ * @return BenchmarkResult 测量结果
+ */
+BenchmarkResult Benchmark::runChecked(const String& name, int iterations, const BenchmarkCheckedBody& body) {
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = 0;
+    result.failures = 0;
+    result.avgUs = 0;
+    result.minUs = 0;
+    result.p50Us = 0;
+    result.p95Us = 0;
+    result.maxUs = 0;
+    if (iterations <= 0 || !body) {
+        return result;
+    }
+
+    std::vector<uint32_t> samples;
+    samples.reserve(iterations);
+
+    // 预热一次，排除首次执行时的缓存与惰性初始化
+    body();
+
+    uint64_t total = 0;
+    for (int i = 0; i < iterations; i++) {
+        int64_t start = esp_timer_get_time();
+        bool ok = body();
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        samples.push_back(elapsed);
+        total += elapsed;
+        if (!ok) {
+            result.failures++;
+        }
+        // 长时间测量中让出CPU（不计入耗时），避免触发任务看门狗
+        if ((i & 0x3F) == 0x3F) {
+            vTaskDelay(1);
+        }
+    }
+
+    // 最近秩法取分位数
+    std::sort(samples.begin(), samples.end());
+    size_t count = samples.size();
+    result.iterations = iterations;
+    result.avgUs = (unsigned long)(total / count);
+    result.minUs = samples.front();
+    result.p50Us = samples[(count * 50 + 99) / 100 - 1];
+    result.p95Us = samples[(count * 95 + 99) / 100 - 1];
+    result.maxUs = samples.back();
+    return result;
+}
+
+/**
+ * @brief 格式化测量结果（一行）
+ * @param result 测量结果
+ * @return String 格式化文本
+ */
+String Benchmark::format(const BenchmarkResult& result) {
+    if (result.iterations == 0) {
+        return result.name + ": 未执行";
+    }
+    String line = result.name + ": p50 " + String(result.p50Us) + " us，p95 " + String(result.p95Us) +
+                  " us，最大 " + String(result.maxUs) + " us，平均 " + String(result.avgUs) + " us（" +
+                  String(result.iterations) + "次";
+    if (result.failures > 0) {
+        line += "，失败" + String(result.failures) + "次";
+    }
+    return line + "）";
+}
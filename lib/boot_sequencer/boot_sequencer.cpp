@@ -0,0 +1,285 @@
+/**
+ * @file boot_sequencer.cpp
+ * @brief 启动依赖图实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "boot_sequencer.h"
+#include "../log_manager/log_manager.h"
+#include "../metrics/metrics.h"
+#include "../../include/constants.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @brief 获取阶段状态名称
+ * @param state 阶段状态
+ * @return const char* 状态名称
+ */
+static const char* stateName(BootStageState state) {
+    switch (state) {
+        case BOOT_STAGE_PENDING: return "等待";
+        case BOOT_STAGE_RUNNING: return "执行中";
+        case BOOT_STAGE_DONE: return "完成";
+        case BOOT_STAGE_FAILED: return "失败";
+        case BOOT_STAGE_SKIPPED: return "跳过";
+    }
+    return "未知";
+}
+
+/**
+ * @brief 获取单例实例
+ * @return BootSequencer& 单例引用
+ */
+BootSequencer& BootSequencer::getInstance() {
+    static BootSequencer instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+BootSequencer::BootSequencer() : bootStartedAt(0), reported(false) {
+}
+
+/**
+ * @brief 登记启动阶段
+ * @param name 阶段名称
+ * @param dependencies 依赖的阶段ID
+ * @param function 阶段函数
+ * @param mode 执行方式
+ * @param required 是否为必需阶段
+ * @return int 阶段ID
+ */
+int BootSequencer::addStage(const String& name, std::initializer_list<int> dependencies,
+                            BootStageFunction function, BootStageMode mode, bool required) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BootStage stage;
+    stage.name = name;
+    stage.dependencies = dependencies;
+    stage.function = function;
+    stage.mode = mode;
+    stage.required = required;
+    stage.state = BOOT_STAGE_PENDING;
+    stage.startedAt = 0;
+    stage.finishedAt = 0;
+    stages.push_back(stage);
+    return (int)stages.size() - 1;
+}
+
+/**
+ * @brief 执行依赖图，在所有可同步执行的阶段完成后返回
+ * @return true 没有必需阶段失败
+ * @return false 有必需阶段失败
+ */
+bool BootSequencer::run() {
+    bootStartedAt = millis();
+    advance();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const BootStage& stage : stages) {
+        if (stage.required && (stage.state == BOOT_STAGE_FAILED || stage.state == BOOT_STAGE_SKIPPED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 检查所有阶段是否已结束
+ * @return true 已结束
+ * @return false 仍有阶段在等待或执行
+ */
+bool BootSequencer::isComplete() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const BootStage& stage : stages) {
+        if (stage.state == BOOT_STAGE_PENDING || stage.state == BOOT_STAGE_RUNNING) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 获取启动报告
+ * @return String 启动报告
+ */
+String BootSequencer::getReport() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return formatReport();
+}
+
+/**
+ * @brief 启动所有依赖已满足的阶段，同步阶段在当前上下文中执行
+ */
+void BootSequencer::advance() {
+    while (true) {
+        int id;
+        BootStageMode mode;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            id = takeReadyStage();
+            if (id < 0) {
+                break;
+            }
+            mode = stages[id].mode;
+        }
+
+        if (mode == BOOT_STAGE_ASYNC) {
+            BaseType_t created = xTaskCreate(
+                stageTask,
+                "BootStageTask",
+                BOOT_STAGE_STACK_SIZE,
+                (void*)(intptr_t)id,
+                BOOT_STAGE_PRIORITY,
+                nullptr
+            );
+            if (created == pdPASS) {
+                continue;
+            }
+            // 无法创建任务时退回同步执行
+        }
+        runStage(id);
+    }
+
+    reportIfComplete();
+}
+
+/**
+ * @brief 选出下一个可执行的阶段并标记为执行中（调用方须持有mutex）
+ * @return int 阶段ID，-1表示没有
+ */
+int BootSequencer::takeReadyStage() {
+    for (size_t i = 0; i < stages.size(); i++) {
+        BootStage& stage = stages[i];
+        if (stage.state != BOOT_STAGE_PENDING) {
+            continue;
+        }
+
+        bool ready = true;
+        bool blocked = false;
+        for (int dependency : stage.dependencies) {
+            BootStageState state = stages[dependency].state;
+            if (state == BOOT_STAGE_FAILED || state == BOOT_STAGE_SKIPPED) {
+                blocked = true;
+                break;
+            }
+            if (state != BOOT_STAGE_DONE) {
+                ready = false;
+            }
+        }
+
+        // 依赖只能指向先登记的阶段，顺序扫描即可把跳过传递下去
+        if (blocked) {
+            stage.state = BOOT_STAGE_SKIPPED;
+            stage.startedAt = stage.finishedAt = millis();
+            continue;
+        }
+        if (ready) {
+            stage.state = BOOT_STAGE_RUNNING;
+            stage.startedAt = millis();
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 执行一个阶段并记录结果
+ * @param id 阶段ID
+ */
+void BootSequencer::runStage(int id) {
+    BootStageFunction function;
+    String name;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        function = stages[id].function;
+        name = stages[id].name;
+    }
+
+    bool success = false;
+    try {
+        success = function();
+    } catch (...) {
+        success = false;
+    }
+
+    unsigned long durationMs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        BootStage& stage = stages[id];
+        stage.finishedAt = millis();
+        stage.state = success ? BOOT_STAGE_DONE : BOOT_STAGE_FAILED;
+        durationMs = stage.finishedAt - stage.startedAt;
+    }
+    MetricsRegistry::getInstance().setGauge(METRIC_BOOT_STAGE, (int64_t)durationMs * 1000, name.c_str());
+
+    if (success) {
+        LOG_INFO(LOG_MODULE_SYSTEM, "启动阶段完成: " + name + "，耗时 " + String(durationMs) + "ms");
+    } else {
+        LOG_WARN(LOG_MODULE_SYSTEM, "启动阶段失败: " + name + "，耗时 " + String(durationMs) + "ms");
+    }
+}
+
+/**
+ * @brief 异步阶段的任务入口
+ * @param parameter 阶段ID
+ */
+void BootSequencer::stageTask(void* parameter) {
+    BootSequencer& sequencer = getInstance();
+    sequencer.runStage((int)(intptr_t)parameter);
+
+    // 依赖本阶段的同步阶段在本任务中继续执行
+    sequencer.advance();
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 所有阶段结束时输出一次启动报告
+ */
+void BootSequencer::reportIfComplete() {
+    String report;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (reported) {
+            return;
+        }
+        for (const BootStage& stage : stages) {
+            if (stage.state == BOOT_STAGE_PENDING || stage.state == BOOT_STAGE_RUNNING) {
+                return;
+            }
+        }
+        reported = true;
+        report = formatReport();
+    }
+    LOG_INFO(LOG_MODULE_SYSTEM, "启动完成\n" + report);
+}
+
+/**
+ * @brief 格式化启动报告（调用方须持有mutex）
+ * @return String 启动报告
+ */
+String BootSequencer::formatReport() const {
+    String report = "启动阶段            状态    开始(ms)  耗时(ms)\n";
+    unsigned long lastFinished = bootStartedAt;
+    for (const BootStage& stage : stages) {
+        String line = stage.name;
+        while (line.length() < 20) {
+            line += " ";
+        }
+        line += stateName(stage.state);
+        if (stage.state != BOOT_STAGE_PENDING) {
+            line += "    " + String(stage.startedAt);
+            if (stage.state != BOOT_STAGE_RUNNING) {
+                line += "    " + String(stage.finishedAt - stage.startedAt);
+                if ((long)(stage.finishedAt - lastFinished) > 0) {
+                    lastFinished = stage.finishedAt;
+                }
+            }
+        }
+        report += line + "\n";
+    }
+    report += "依赖图耗时: " + String(lastFinished - bootStartedAt) + "ms";
+    return report;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file boot_sequencer.h
+ * @brief 启动依赖图 - 按依赖关系并行执行各启动阶段并统计耗时
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 登记启动阶段及其依赖，依赖全部完成后立即启动该阶段
+ * 2. 同步阶段在触发它的上下文中执行，异步阶段在独立的临时任务中执行，
+ *    耗时的GSM探测不再阻塞短信接收、数据库与Web服务的启动
+ * 3. 依赖失败的阶段被跳过；必需阶段失败时启动中止
+ * 4. 记录每个阶段的开始时间与耗时，全部完成后输出启动报告
+ */
+
+#ifndef BOOT_SEQUENCER_H
+#define BOOT_SEQUENCER_H
+
+#include <Arduino.h>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <initializer_list>
+
+/**
+ * @brief 启动阶段函数
+ * @return true 阶段成功
+ * @return false 阶段失败（依赖它的阶段将被跳过）
+ */
+typedef std::function<bool()> BootStageFunction;
+
+/**
+ * @enum BootStageMode
+ * @brief 启动阶段执行方式
+ */
+enum BootStageMode {
+    BOOT_STAGE_INLINE,      ///< 在触发它的上下文中执行（setup()或完成依赖的异步阶段）
+    BOOT_STAGE_ASYNC        ///< 在独立的临时任务中执行
+};
+
+/**
+ * @enum BootStageState
+ * @brief 启动阶段状态
+ */
+enum BootStageState {
+    BOOT_STAGE_PENDING,     ///< 等待依赖
+    BOOT_STAGE_RUNNING,     ///< 执行中
+    BOOT_STAGE_DONE,        ///< 已完成
+    BOOT_STAGE_FAILED,      ///< 执行失败
+    BOOT_STAGE_SKIPPED      ///< 依赖失败而跳过
+};
+
+/**
+ * @class BootSequencer
+ * @brief 启动依赖图执行器
+ */
+class BootSequencer {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return BootSequencer& 单例引用
+     */
+    static BootSequencer& getInstance();
+
+    /**
+     * @brief 登记启动阶段（须在run()之前调用）
+     * @param name 阶段名称
+     * @param dependencies 依赖的阶段ID
+     * @param function 阶段函数
+     * @param mode 执行方式
+     * @param required 是否为必需阶段（失败时run()返回false）
+     * @return int 阶段ID
+     */
+    int addStage(const String& name, std::initializer_list<int> dependencies,
+                 BootStageFunction function, BootStageMode mode = BOOT_STAGE_INLINE,
+                 bool required = false);
+
+    /**
+     * @brief 执行依赖图，在所有可同步执行的阶段完成后返回（异步阶段在后台继续）
+     * @return true 没有必需阶段失败
+     * @return false 有必需阶段失败
+     */
+    bool run();
+
+    /**
+     * @brief 检查所有阶段是否已结束
+     * @return true 已结束
+     * @return false 仍有阶段在等待或执行
+     */
+    bool isComplete() const;
+
+    /**
+     * @brief 获取启动报告（各阶段状态、开始时间与耗时）
+     * @return String 启动报告
+     */
+    String getReport() const;
+
+private:
+    /**
+     * @struct BootStage
+     * @brief 启动阶段
+     */
+    struct BootStage {
+        String name;                        ///< 阶段名称
+        std::vector<int> dependencies;      ///< 依赖的阶段ID
+        BootStageFunction function;         ///< 阶段函数
+        BootStageMode mode;                 ///< 执行方式
+        bool required;                      ///< 是否为必需阶段
+        BootStageState state;               ///< 状态
+        unsigned long startedAt;            ///< 开始时间（millis）
+        unsigned long finishedAt;           ///< 结束时间（millis）
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    BootSequencer();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    BootSequencer(const BootSequencer&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    BootSequencer& operator=(const BootSequencer&) = delete;
+
+    /**
+     * @brief 启动所有依赖已满足的阶段，同步阶段在当前上下文中执行
+     */
+    void advance();
+
+    /**
+     * @brief 选出下一个可执行的阶段并标记为执行中（调用方须持有mutex）
+     * @return int 阶段ID，-1表示没有
+     */
+    int takeReadyStage();
+
+    /**
+     * @brief 执行一个阶段并记录结果
+     * @param id 阶段ID
+     */
+    void runStage(int id);
+
+    /**
+     * @brief 异步阶段的任务入口
+     * @param parameter 阶段ID
+     */
+    static void stageTask(void* parameter);
+
+    /**
+     * @brief 所有阶段结束时输出一次启动报告
+     */
+    void reportIfComplete();
+
+    /**
+     * @brief 格式化启动报告（调用方须持有mutex）
+     * @return String 启动报告
+     */
+    String formatReport() const;
+
+private:
+    std::vector<BootStage> stages;          ///< 启动阶段
+    mutable std::mutex mutex;               ///< 保护阶段状态
+    unsigned long bootStartedAt;            ///< run()开始时间（millis）
+    bool reported;                          ///< 是否已输出启动报告
+};
+
+#endif // BOOT_SEQUENCER_H
@@ -7,24 +7,76 @@
 
 #include "carrier_config.h"
 #include <Arduino.h>
+#include <string.h>
 
-// 中国移动IMSI前缀
-static const String CHINA_MOBILE_PREFIXES[] = {
-    "46000", "46002", "46004", "46007", "46008"
+/// IMSI前缀（MCC+MNC）长度
+static constexpr size_t CARRIER_PREFIX_LENGTH = 5;
+
+/**
+ * @struct CarrierPrefix
+ * @brief IMSI前缀与运营商的对应关系
+ */
+struct CarrierPrefix {
+    char mccMnc[CARRIER_PREFIX_LENGTH + 1];     ///< IMSI前缀
+    CarrierType type;                           ///< 运营商类型
 };
-static const int CHINA_MOBILE_PREFIX_COUNT = 5;
 
-// 中国联通IMSI前缀
-static const String CHINA_UNICOM_PREFIXES[] = {
-    "46001", "46006", "46009"
+/// IMSI前缀表（编译期常量，位于Flash）
+static constexpr CarrierPrefix CARRIER_PREFIXES[] = {
+    {"46000", CARRIER_CHINA_MOBILE},
+    {"46002", CARRIER_CHINA_MOBILE},
+    {"46004", CARRIER_CHINA_MOBILE},
+    {"46007", CARRIER_CHINA_MOBILE},
+    {"46008", CARRIER_CHINA_MOBILE},
+    {"46001", CARRIER_CHINA_UNICOM},
+    {"46006", CARRIER_CHINA_UNICOM},
+    {"46009", CARRIER_CHINA_UNICOM},
+    {"46003", CARRIER_CHINA_TELECOM},
+    {"46005", CARRIER_CHINA_TELECOM},
+    {"46011", CARRIER_CHINA_TELECOM}
 };
-static const int CHINA_UNICOM_PREFIX_COUNT = 3;
 
-// 中国电信IMSI前缀
-static const String CHINA_TELECOM_PREFIXES[] = {
-    "46003", "46005", "46011"
+/**
+ * @struct CarrierProfile
+ * @brief 运营商的网络参数
+ */
+struct CarrierProfile {
+    CarrierType type;                           ///< 运营商类型
+    const char* name;                           ///< 运营商名称
+    const char* apn;                            ///< APN名称
+    const char* username;                       ///< APN用户名
+    const char* password;                       ///< APN密码
+    const char* authType;                       ///< 认证类型
+    const char* smsCenterNumber;                ///< 短信中心号码
 };
-static const int CHINA_TELECOM_PREFIX_COUNT = 3;
+
+/// 运营商参数表（第一项为未知运营商的默认值）
+static constexpr CarrierProfile CARRIER_PROFILES[] = {
+    {CARRIER_UNKNOWN, "未知运营商", "", "", "", "NONE", ""},
+    {CARRIER_CHINA_MOBILE, "中国移动", "cmnet", "", "", "NONE", "+8613800100500"},
+    {CARRIER_CHINA_UNICOM, "中国联通", "3gnet", "", "", "NONE", "+8613010112500"},
+    {CARRIER_CHINA_TELECOM, "中国电信", "ctnet", "ctnet@mycdma.cn", "vnet.mobi", "PAP", "+8613800100500"}
+};
+
+/**
+ * @brief 检查前缀表的每一项都是5位数字
+ * @return true 前缀表有效
+ */
+static constexpr bool carrierPrefixesValid() {
+    for (const CarrierPrefix& prefix : CARRIER_PREFIXES) {
+        for (size_t i = 0; i < CARRIER_PREFIX_LENGTH; i++) {
+            if (prefix.mccMnc[i] < '0' || prefix.mccMnc[i] > '9') {
+                return false;
+            }
+        }
+        if (prefix.mccMnc[CARRIER_PREFIX_LENGTH] != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(carrierPrefixesValid(), "IMSI前缀必须是5位数字");
 
 /**
  * @brief 构造函数
@@ -47,29 +99,14 @@ CarrierConfig::~CarrierConfig() {
  */
 CarrierType CarrierConfig::identifyCarrier(const String& imsi) {
     if (!isValidImsi(imsi)) {
-        Serial.println("无效的IMSI号码");
         return CARRIER_UNKNOWN;
     }
     
-    // 检查中国移动
-    if (matchesCarrierPrefix(imsi, CHINA_MOBILE_PREFIXES, CHINA_MOBILE_PREFIX_COUNT)) {
-        Serial.println("识别为中国移动");
-        return CARRIER_CHINA_MOBILE;
-    }
-    
-    // 检查中国联通
-    if (matchesCarrierPrefix(imsi, CHINA_UNICOM_PREFIXES, CHINA_UNICOM_PREFIX_COUNT)) {
-        Serial.println("识别为中国联通");
-        return CARRIER_CHINA_UNICOM;
-    }
-    
-    // 检查中国电信
-    if (matchesCarrierPrefix(imsi, CHINA_TELECOM_PREFIXES, CHINA_TELECOM_PREFIX_COUNT)) {
-        Serial.println("识别为中国电信");
-        return CARRIER_CHINA_TELECOM;
+    for (const CarrierPrefix& prefix : CARRIER_PREFIXES) {
+        if (memcmp(imsi.c_str(), prefix.mccMnc, CARRIER_PREFIX_LENGTH) == 0) {
+            return prefix.type;
+        }
     }
-    
-    Serial.println("未知运营商");
     return CARRIER_UNKNOWN;
 }
 
@@ -79,50 +116,34 @@ CarrierType CarrierConfig::identifyCarrier(const String& imsi) {
  * @return CarrierInfo 运营商信息
  */
 CarrierInfo CarrierConfig::getCarrierInfo(CarrierType carrierType) {
-    CarrierInfo info;
-    info.type = carrierType;
-    
-    switch (carrierType) {
-        case CARRIER_CHINA_MOBILE:
-            info.name = "中国移动";
-            info.apnConfig.apn = "cmnet";
-            info.apnConfig.username = "";
-            info.apnConfig.password = "";
-            info.apnConfig.authType = "NONE";
-            info.smsCenterNumber = "+8613800100500";
-            break;
-            
-        case CARRIER_CHINA_UNICOM:
-            info.name = "中国联通";
-            info.apnConfig.apn = "3gnet";
-            info.apnConfig.username = "";
-            info.apnConfig.password = "";
-            info.apnConfig.authType = "NONE";
-            info.smsCenterNumber = "+8613010112500";
-            break;
-            
-        case CARRIER_CHINA_TELECOM:
-            info.name = "中国电信";
-            info.apnConfig.apn = "ctnet";
-            info.apnConfig.username = "ctnet@mycdma.cn";
-            info.apnConfig.password = "vnet.mobi";
-            info.apnConfig.authType = "PAP";
-            info.smsCenterNumber = "+8613800100500";
-            break;
-            
-        default:
-            info.name = "未知运营商";
-            info.apnConfig.apn = "";
-            info.apnConfig.username = "";
-            info.apnConfig.password = "";
-            info.apnConfig.authType = "NONE";
-            info.smsCenterNumber = "";
+    const CarrierProfile* profile = &CARRIER_PROFILES[0];
+    for (const CarrierProfile& candidate : CARRIER_PROFILES) {
+        if (candidate.type == carrierType) {
+            profile = &candidate;
             break;
+        }
     }
     
+    CarrierInfo info;
+    info.type = carrierType;
+    info.name = profile->name;
+    info.apnConfig.apn = profile->apn;
+    info.apnConfig.username = profile->username;
+    info.apnConfig.password = profile->password;
+    info.apnConfig.authType = profile->authType;
+    info.smsCenterNumber = profile->smsCenterNumber;
     return info;
 }
 
+/**
+ * @brief 根据IMSI识别运营商并获取其信息
+ * @param imsi IMSI号码
+ * @return CarrierInfo 运营商信息（无法识别时为未知运营商）
+ */
+CarrierInfo CarrierConfig::resolveCarrier(const String& imsi) {
+    return getCarrierInfo(identifyCarrier(imsi));
+}
+
 /**
  * @brief 获取运营商名称
  * @param carrierType 运营商类型
@@ -146,7 +167,7 @@ bool CarrierConfig::isValidImsi(const String& imsi) {
     }
     
     // 检查是否全为数字
-    for (int i = 0; i < imsi.length(); i++) {
+    for (size_t i = 0; i < imsi.length(); i++) {
         if (!isdigit(imsi.charAt(i))) {
             return false;
         }
@@ -170,21 +191,3 @@ CarrierConfig& CarrierConfig::getInstance() {
 void CarrierConfig::initializeCarrierData() {
     Serial.println("运营商配置模块初始化完成");
 }
-
-/**
- * @brief 检查IMSI前缀是否匹配运营商
- * @param imsi IMSI号码
- * @param prefixes 运营商前缀数组
- * @param count 前缀数量
- * @return true 匹配
- * @return false 不匹配
- */
-bool CarrierConfig::matchesCarrierPrefix(const String& imsi, const String* prefixes, int count) {
-    for (int i = 0; i < count; i++) {
-        if (imsi.startsWith(prefixes[i])) {
-            Serial.printf("IMSI %s 匹配前缀 %s\n", imsi.c_str(), prefixes[i].c_str());
-            return true;
-        }
-    }
-    return false;
-}
\ No newline at end of file
@@ -8,6 +8,9 @@
  * 1. 根据IMSI前缀识别运营商类型
  * 2. 自动配置对应运营商的APN参数
  * 3. 提供运营商相关的网络配置信息
+ *
+ * IMSI前缀与运营商参数均为编译期常量表，识别只做一次线性比较，不分配内存也不输出日志；
+ * 启动时解析的结果保存在ConfigManager的运行配置快照中，其他模块无需重复识别
  */
 
 #ifndef CARRIER_CONFIG_H
@@ -80,6 +83,13 @@ public:
      */
     CarrierInfo getCarrierInfo(CarrierType carrierType);
     
+    /**
+     * @brief 根据IMSI识别运营商并获取其信息
+     * @param imsi IMSI号码
+     * @return CarrierInfo 运营商信息（无法识别时为未知运营商）
+     */
+    CarrierInfo resolveCarrier(const String& imsi);
+    
     /**
      * @brief 获取运营商名称
      * @param carrierType 运营商类型
@@ -106,16 +116,6 @@ private:
      * @brief 初始化运营商配置数据
      */
     void initializeCarrierData();
-    
-    /**
-     * @brief 检查IMSI前缀是否匹配运营商
-     * @param imsi IMSI号码
-     * @param prefixes 运营商前缀数组
-     * @param count 前缀数量
-     * @return true 匹配
-     * @return false 不匹配
-     */
-    bool matchesCarrierPrefix(const String& imsi, const String* prefixes, int count);
 };
 
 #endif // CARRIER_CONFIG_H
\ No newline at end of file
@@ -15,6 +15,8 @@
  */
 ConfigManager::ConfigManager() : initialized(false), lastError("") {
     setDefaultConfig();
+    carrierInfo = CarrierConfig::getInstance().getCarrierInfo(CARRIER_UNKNOWN);
+    publishSnapshot();
 }
 
 /**
@@ -86,6 +88,7 @@ bool ConfigManager::loadConfig() {
         loadSmsConfig();
         loadGsmConfig();
         loadSystemConfig();
+        publishSnapshot();
         
         Serial.println("配置加载完成");
         return true;
@@ -136,6 +139,7 @@ bool ConfigManager::resetToDefaults() {
     
     // 设置默认配置
     setDefaultConfig();
+    publishSnapshot();
     
     // 保存默认配置
     if (!saveConfig()) {
@@ -213,17 +217,57 @@ void ConfigManager::setDefaultConfig() {
     systemConfig.deviceName = "ESP-SMS-Relay";
 }
 
-// 配置获取方法
-UartConfig ConfigManager::getUartConfig() { return uartConfig; }
-SmsConfig ConfigManager::getSmsConfig() { return smsConfig; }
-GsmConfig ConfigManager::getGsmConfig() { return gsmConfig; }
-SystemConfig ConfigManager::getSystemConfig() { return systemConfig; }
+// 配置获取方法（读取当前快照）
+UartConfig ConfigManager::getUartConfig() { return getSnapshot()->uart; }
+SmsConfig ConfigManager::getSmsConfig() { return getSnapshot()->sms; }
+GsmConfig ConfigManager::getGsmConfig() { return getSnapshot()->gsm; }
+SystemConfig ConfigManager::getSystemConfig() { return getSnapshot()->system; }
 
-// 配置设置方法
-void ConfigManager::setUartConfig(const UartConfig& config) { uartConfig = config; }
-void ConfigManager::setSmsConfig(const SmsConfig& config) { smsConfig = config; }
-void ConfigManager::setGsmConfig(const GsmConfig& config) { gsmConfig = config; }
-void ConfigManager::setSystemConfig(const SystemConfig& config) { systemConfig = config; }
+// 配置设置方法（每次修改都发布新快照）
+void ConfigManager::setUartConfig(const UartConfig& config) { uartConfig = config; publishSnapshot(); }
+void ConfigManager::setSmsConfig(const SmsConfig& config) { smsConfig = config; publishSnapshot(); }
+void ConfigManager::setGsmConfig(const GsmConfig& config) { gsmConfig = config; publishSnapshot(); }
+void ConfigManager::setSystemConfig(const SystemConfig& config) { systemConfig = config; publishSnapshot(); }
+
+/**
+ * @brief 获取当前运行配置快照
+ * @return std::shared_ptr<const RuntimeConfig> 运行配置快照
+ */
+std::shared_ptr<const RuntimeConfig> ConfigManager::getSnapshot() const {
+    return std::atomic_load(&snapshot);
+}
+
+/**
+ * @brief 记录SIM卡的IMSI与解析出的运营商，并发布新快照
+ * @param imsi IMSI号码
+ * @param carrier 运营商信息
+ */
+void ConfigManager::setCarrier(const String& imsi, const CarrierInfo& carrier) {
+    carrierImsi = imsi;
+    carrierInfo = carrier;
+    publishSnapshot();
+}
+
+/**
+ * @brief 以当前配置构建新快照并整体替换
+ * 
+ * 旧快照在最后一个持有者释放后销毁，读取方不会看到只更新了一半的配置
+ */
+void ConfigManager::publishSnapshot() {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    std::shared_ptr<const RuntimeConfig> current = std::atomic_load(&snapshot);
+    
+    std::shared_ptr<RuntimeConfig> next = std::make_shared<RuntimeConfig>();
+    next->version = current ? current->version + 1 : 1;
+    next->uart = uartConfig;
+    next->sms = smsConfig;
+    next->gsm = gsmConfig;
+    next->system = systemConfig;
+    next->imsi = carrierImsi;
+    next->carrier = carrierInfo;
+    
+    std::atomic_store(&snapshot, std::shared_ptr<const RuntimeConfig>(next));
+}
 
 /**
  * @brief 获取最后的错误信息
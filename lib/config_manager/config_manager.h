@@ -9,6 +9,7 @@
  * 2. 配置参数的读取和设置
  * 3. 配置的持久化存储
  * 4. 配置验证和默认值管理
+ * 5. 发布不可变的运行配置快照：加载或修改配置后整体替换，读取方持有快照期间内容不变
  */
 
 #ifndef CONFIG_MANAGER_H
@@ -16,6 +17,9 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <memory>
+#include <mutex>
+#include "../carrier_config/carrier_config.h"
 
 /**
  * @struct UartConfig
@@ -65,6 +69,20 @@ struct SystemConfig {
     String deviceName;            ///< 设备名称
 };
 
+/**
+ * @struct RuntimeConfig
+ * @brief 运行配置快照（发布后不再修改）
+ */
+struct RuntimeConfig {
+    uint32_t version;       ///< 快照版本（每次发布加一）
+    UartConfig uart;        ///< 串口配置
+    SmsConfig sms;          ///< 短信配置
+    GsmConfig gsm;          ///< GSM配置
+    SystemConfig system;    ///< 系统配置
+    String imsi;            ///< 启动时读取的IMSI（空表示尚未读取）
+    CarrierInfo carrier;    ///< 按IMSI解析的运营商与APN配置
+};
+
 /**
  * @class ConfigManager
  * @brief 配置管理器类
@@ -118,6 +136,21 @@ public:
      */
     bool validateConfig();
     
+    /**
+     * @brief 获取当前运行配置快照
+     * 
+     * 快照不可变，读取方持有期间不受重新加载影响；只读取少量字段时无需复制整个结构
+     * @return std::shared_ptr<const RuntimeConfig> 运行配置快照
+     */
+    std::shared_ptr<const RuntimeConfig> getSnapshot() const;
+    
+    /**
+     * @brief 记录SIM卡的IMSI与解析出的运营商，并发布新快照
+     * @param imsi IMSI号码
+     * @param carrier 运营商信息
+     */
+    void setCarrier(const String& imsi, const CarrierInfo& carrier);
+    
     // 配置获取方法
     /**
      * @brief 获取串口配置
@@ -193,12 +226,22 @@ private:
     SystemConfig systemConfig; ///< 系统配置
     String lastError;          ///< 最后的错误信息
     bool initialized;          ///< 是否已初始化
+    String carrierImsi;        ///< SIM卡的IMSI
+    CarrierInfo carrierInfo;   ///< 解析出的运营商信息
+    
+    std::shared_ptr<const RuntimeConfig> snapshot;  ///< 当前运行配置快照（以atomic_load/atomic_store访问）
+    std::mutex publishMutex;                        ///< 串行化快照发布
     
     /**
      * @brief 设置默认配置
      */
     void setDefaultConfig();
     
+    /**
+     * @brief 以当前配置构建新快照并整体替换
+     */
+    void publishSnapshot();
+    
     /**
      * @brief 设置错误信息
      * @param error 错误信息
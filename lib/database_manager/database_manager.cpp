@@ -7,10 +7,118 @@
 
 #include "database_manager.h"
 #include "../filesystem_manager/filesystem_manager.h"
+#include "../flash_vfs/flash_vfs.h"
 #include "../../include/constants.h"
 #include <Arduino.h>
 #include <time.h>
+#include <stdio.h>
+#include <limits.h>
 #include <mutex>
+#include <esp_heap_caps.h>
+#include <esp_spi_flash.h>
+
+/**
+ * @brief 读取累计的flash擦除扇区数与写入字节数
+ * @param rawPartition 数据库是否位于原始分区（此时只统计FlashVfs的写入）
+ * @param erases 输出：擦除的扇区数
+ * @param bytes 输出：写入的字节数
+ * @return true 有可用的统计
+ * @return false LittleFS存储且未启用CONFIG_SPI_FLASH_ENABLE_COUNTERS
+ */
+static bool readFlashCounters(bool rawPartition, uint32_t& erases, uint32_t& bytes) {
+    if (rawPartition) {
+        FlashVfsStats stats = FlashVfs::getInstance().getStats();
+        erases = stats.sectorsErased;
+        bytes = stats.bytesProgrammed;
+        return true;
+    }
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    // 全局计数：测量期间其他任务的flash写入（日志、配置）也会计入
+    const spi_flash_counters_t* counters = spi_flash_get_counters();
+    erases = counters->erase.bytes / SPI_FLASH_SEC_SIZE;
+    bytes = counters->write.bytes;
+    return true;
+#else
+    erases = 0;
+    bytes = 0;
+    return false;
+#endif
+}
+
+/**
+ * @brief 缓存语句的SQL，下标与DbStatement一一对应
+ */
+static const char* const STATEMENT_SQL[DB_STMT_COUNT] = {
+    /* DB_STMT_INSERT_SMS */
+    "INSERT INTO sms_records (from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+    /* DB_STMT_UPDATE_SMS */
+    "UPDATE sms_records SET from_number=?, to_number=?, content=?, rule_id=?, forwarded=?, status=?, forwarded_at=?, received_at=? WHERE id=?",
+    /* DB_STMT_GET_SMS_BY_ID */
+    "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records WHERE id=?",
+    /* DB_STMT_GET_SMS_PAGE */
+    "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records ORDER BY received_at DESC, id DESC LIMIT ? OFFSET ?",
+    /* DB_STMT_GET_SMS_LATEST */
+    "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records "
+    "ORDER BY received_at DESC, id DESC LIMIT ?",
+    /* DB_STMT_GET_SMS_BEFORE */
+    "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records "
+    "WHERE (received_at, id) < (?, ?) ORDER BY received_at DESC, id DESC LIMIT ?",
+    /* DB_STMT_GET_SMS_AFTER_ID */
+    "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records "
+    "WHERE id > ? ORDER BY id LIMIT ?",
+    /* DB_STMT_SEARCH_SMS */
+    "SELECT s.id, s.from_number, s.to_number, s.content, s.rule_id, s.forwarded, s.status, s.forwarded_at, s.received_at "
+    "FROM sms_fts JOIN sms_records s ON s.id = sms_fts.rowid WHERE sms_fts MATCH ? ORDER BY sms_fts.rowid DESC LIMIT ?",
+    /* DB_STMT_SEARCH_SMS_SCAN */
+    "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records "
+    "WHERE content LIKE ? ESCAPE '\\' OR from_number LIKE ? ESCAPE '\\' ORDER BY id DESC LIMIT ?",
+    /* DB_STMT_SCAN_SMS_BEFORE_ID */
+    "SELECT id, from_number, content, received_at FROM sms_records WHERE id < ? ORDER BY id DESC LIMIT ?",
+    /* DB_STMT_SCAN_SMS_MATCH_BEFORE_ID */
+    "SELECT s.id, s.from_number, s.content, s.received_at FROM sms_fts JOIN sms_records s ON s.id = sms_fts.rowid "
+    "WHERE sms_fts MATCH ? AND sms_fts.rowid < ? ORDER BY sms_fts.rowid DESC LIMIT ?",
+    /* DB_STMT_DELETE_OLDEST_SMS */
+    "DELETE FROM sms_records WHERE id IN (SELECT id FROM sms_records ORDER BY id ASC LIMIT ?)",
+    /* DB_STMT_DELETE_SMS_BEFORE */
+    "DELETE FROM sms_records WHERE id IN (SELECT id FROM sms_records "
+    "WHERE received_at >= ? AND received_at < ? ORDER BY received_at ASC LIMIT ?)",
+    /* DB_STMT_COUNT_SMS */
+    "SELECT record_count FROM sms_stats WHERE id = 1",
+    /* DB_STMT_GET_RULE_BY_ID */
+    "SELECT id, rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at, priority FROM forward_rules WHERE id=?",
+    /* DB_STMT_GET_RULES */
+    "SELECT id, rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at, priority "
+    "FROM forward_rules WHERE (?1 IS NULL OR enabled = ?1) AND (?2 IS NULL OR push_type = ?2) "
+    "ORDER BY CASE WHEN ?5 THEN priority ELSE 0 END ASC, id ASC LIMIT ?3 OFFSET ?4",
+    /* DB_STMT_COUNT_RULES */
+    "SELECT COUNT(*) FROM forward_rules",
+    /* DB_STMT_COUNT_ENABLED_RULES */
+    "SELECT COUNT(*) FROM forward_rules WHERE enabled = 1",
+    /* DB_STMT_INSERT_OUTBOX */
+    "INSERT INTO push_outbox (sms_id, rule_id, attempt, next_attempt_at, last_error, created_at, follower_rule_ids) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?)",
+    /* DB_STMT_UPDATE_OUTBOX */
+    "UPDATE push_outbox SET attempt=?, next_attempt_at=?, last_error=? WHERE id=?",
+    /* DB_STMT_DELETE_OUTBOX */
+    "DELETE FROM push_outbox WHERE id=?",
+    /* DB_STMT_GET_OUTBOX_BY_ID */
+    "SELECT id, sms_id, rule_id, attempt, next_attempt_at, last_error, created_at, follower_rule_ids FROM push_outbox WHERE id=?",
+    /* DB_STMT_GET_DUE_OUTBOX */
+    "SELECT id, sms_id, rule_id, attempt, next_attempt_at, last_error, created_at, follower_rule_ids FROM push_outbox "
+    "WHERE next_attempt_at <= ? OR next_attempt_at > ? ORDER BY next_attempt_at ASC LIMIT ?",
+    /* DB_STMT_COUNT_OUTBOX */
+    "SELECT COUNT(*) FROM push_outbox",
+    /* DB_STMT_INSERT_SMS_FINGERPRINT */
+    "INSERT INTO sms_fingerprints (fingerprint, created_at) VALUES (?, ?)",
+    /* DB_STMT_TRIM_SMS_FINGERPRINTS */
+    "DELETE FROM sms_fingerprints WHERE id <= ?",
+    /* DB_STMT_GET_SMS_FINGERPRINTS */
+    "SELECT fingerprint FROM (SELECT id, fingerprint FROM sms_fingerprints ORDER BY id DESC LIMIT ?) ORDER BY id ASC",
+    /* DB_STMT_SAVE_SMS_TRACE */
+    "INSERT OR REPLACE INTO sms_traces (sms_id, trace) VALUES (?, ?)",
+    /* DB_STMT_GET_SMS_TRACE */
+    "SELECT trace FROM sms_traces WHERE sms_id=?",
+};
 
 /**
  * @brief SQLite查询回调函数
@@ -57,6 +165,77 @@ static int queryCallback(void *data, int argc, char **argv, char **azColName) {
     return 0;
 }
 
+/**
+ * @brief 短信记录的行解码器（列顺序与短信记录的SELECT一致）
+ * @return const RowDecoder<SMSRecord>& 解码器
+ */
+static const RowDecoder<SMSRecord>& smsRecordDecoder() {
+    static const RowDecoder<SMSRecord> decoder = RowDecoder<SMSRecord>()
+        .integer(0, &SMSRecord::id)
+        .text(1, &SMSRecord::fromNumber)
+        .text(2, &SMSRecord::toNumber)
+        .text(3, &SMSRecord::content)
+        .integer(4, &SMSRecord::ruleId)
+        .flag(5, &SMSRecord::forwarded)
+        .text(6, &SMSRecord::status)
+        .text(7, &SMSRecord::forwardedAt)
+        .timestamp(8, &SMSRecord::receivedAt);
+    return decoder;
+}
+
+/**
+ * @brief 转发规则的行解码器（列顺序与转发规则的SELECT一致）
+ * @return const RowDecoder<ForwardRule>& 解码器
+ */
+static const RowDecoder<ForwardRule>& forwardRuleDecoder() {
+    static const RowDecoder<ForwardRule> decoder = RowDecoder<ForwardRule>()
+        .integer(0, &ForwardRule::id)
+        .text(1, &ForwardRule::ruleName)
+        .text(2, &ForwardRule::sourceNumber)
+        .text(3, &ForwardRule::keywords)
+        .text(4, &ForwardRule::pushType)
+        .text(5, &ForwardRule::pushConfig, "{}")
+        .flag(6, &ForwardRule::enabled)
+        .flag(7, &ForwardRule::isDefaultForward)
+        .text(8, &ForwardRule::createdAt)
+        .text(9, &ForwardRule::updatedAt)
+        .integer(10, &ForwardRule::priority);
+    return decoder;
+}
+
+/**
+ * @brief 推送发件箱条目的行解码器（列顺序与发件箱的SELECT一致）
+ * @return const RowDecoder<PushOutboxEntry>& 解码器
+ */
+static const RowDecoder<PushOutboxEntry>& outboxEntryDecoder() {
+    static const RowDecoder<PushOutboxEntry> decoder = RowDecoder<PushOutboxEntry>()
+        .integer(0, &PushOutboxEntry::id)
+        .integer(1, &PushOutboxEntry::smsId)
+        .integer(2, &PushOutboxEntry::ruleId)
+        .integer(3, &PushOutboxEntry::attempt)
+        .timestamp(4, &PushOutboxEntry::nextAttemptAt)
+        .text(5, &PushOutboxEntry::lastError)
+        .timestamp(6, &PushOutboxEntry::createdAt)
+        .text(7, &PushOutboxEntry::followerRuleIds);
+    return decoder;
+}
+
+/**
+ * @brief AP配置的行解码器（列顺序与AP配置的SELECT一致）
+ * @return const RowDecoder<APConfig>& 解码器
+ */
+static const RowDecoder<APConfig>& apConfigDecoder() {
+    static const RowDecoder<APConfig> decoder = RowDecoder<APConfig>()
+        .text(0, &APConfig::ssid)
+        .text(1, &APConfig::password)
+        .flag(2, &APConfig::enabled)
+        .integer(3, &APConfig::channel)
+        .integer(4, &APConfig::maxConnections)
+        .text(5, &APConfig::createdAt)
+        .text(6, &APConfig::updatedAt);
+    return decoder;
+}
+
 /**
  * @brief 获取单例实例
  * @return DatabaseManager& 单例引用
@@ -70,10 +249,32 @@ DatabaseManager& DatabaseManager::getInstance() {
  * @brief 私有构造函数
  */
 DatabaseManager::DatabaseManager() 
-    : db(nullptr), status(DB_NOT_INITIALIZED), debugMode(false) {
+    : db(nullptr), status(DB_NOT_INITIALIZED), debugMode(false),
+      durability(DB_DEFAULT_DURABILITY), walEnabled(false), groupOpen(false),
+      explicitTransaction(false), groupOpenedAt(0), groupWrites(0), ftsEnabled(false),
+      storageProfile(getDefaultStorageProfile()), memoryConfigured(false),
+      psramPageCache(false), psramHeap(false), retentionActive(false), lastWriteAt(0),
+      backupDb(nullptr), backupHandle(nullptr), backupActive(false), rawPartition(false),
+      benchmarkStatement(nullptr) {
+    for (int i = 0; i < DB_STMT_COUNT; i++) {
+        statements[i] = nullptr;
+    }
     dbInfo.isOpen = false;
+    dbInfo.rawPartition = false;
     dbInfo.version = "1.0";
     dbInfo.lastModified = "";
+    dbInfo.pageSize = 0;
+    dbInfo.cacheSizePages = 0;
+    dbInfo.psramPageCache = false;
+    dbInfo.psramHeap = false;
+    dbInfo.cacheHits = 0;
+    dbInfo.cacheMisses = 0;
+    dbInfo.cacheHitRatio = 0.0f;
+    backupStatus.active = false;
+    backupStatus.totalPages = 0;
+    backupStatus.remainingPages = 0;
+    backupStatus.lastSucceeded = false;
+    backupStatus.finishedAt = 0;
 }
 
 /**
@@ -128,22 +329,34 @@ bool DatabaseManager::initialize(const String& dbPath, bool createIfNotExists) {
     bool dbExists = fsManager.fileExists(checkPath);
     debugPrint("数据库文件存在: " + String(dbExists ? "是" : "否"));
     
-    if (!dbExists && !createIfNotExists) {
-        setError("数据库文件不存在且未启用创建选项");
+    // 初始化SQLite（内存配置须在此之前完成）
+    configureMemory();
+    int rc = sqlite3_initialize();
+    if (rc != SQLITE_OK) {
+        setError("SQLite初始化失败: " + String(rc));
         status = DB_ERROR;
         return false;
     }
     
-    // 初始化SQLite
-    int rc = sqlite3_initialize();
-    if (rc != SQLITE_OK) {
-        setError("SQLite初始化失败: " + String(rc));
+    // 原始分区存储：挂载分区，首次启用时把LittleFS上的数据库迁移过去
+    rawPartition = false;
+    if (DB_USE_RAW_PARTITION) {
+        if (!prepareRawPartition(fullDbPath, dbExists)) {
+            status = DB_ERROR;
+            return false;
+        }
+        rawPartition = true;
+    }
+    
+    if (!dbExists && !createIfNotExists) {
+        setError("数据库文件不存在且未启用创建选项");
         status = DB_ERROR;
         return false;
     }
     
     // 打开数据库
-    rc = sqlite3_open(fullDbPath.c_str(), &db);
+    rc = sqlite3_open_v2(fullDbPath.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                         rawPartition ? DB_RAW_VFS_NAME : nullptr);
     if (rc != SQLITE_OK) {
         setError("无法打开数据库: " + String(sqlite3_errmsg(db)));
         sqlite3_close(db);
@@ -154,24 +367,21 @@ bool DatabaseManager::initialize(const String& dbPath, bool createIfNotExists) {
     
     debugPrint("数据库连接成功，开始配置SQLite参数");
     
-    // 配置SQLite以优化ESP32-S3的内存使用
-    // 设置页面大小为1KB（适合ESP32的内存特性）
-    executeSQLPrivate("PRAGMA page_size = 1024");
+    // 按存储配置设置页面布局
+    // 页面大小与LittleFS块大小一致，每次写页对应一个块（只对新建的数据库生效）
+    executeSQLPrivate("PRAGMA page_size = " + String(storageProfile.pageSize));
     
-    // 设置缓存大小（页面数量，1000页 = 1MB缓存）
-    executeSQLPrivate("PRAGMA cache_size = 1000");
+    // 设置缓存大小（页面数量）
+    executeSQLPrivate("PRAGMA cache_size = " + String(storageProfile.cacheSizePages));
     
     // 设置临时存储为内存模式
     executeSQLPrivate("PRAGMA temp_store = MEMORY");
     
-    // 设置日志模式为DELETE（默认模式）
-    executeSQLPrivate("PRAGMA journal_mode = DELETE");
+    // 设置日志模式（WAL或DELETE）与同步级别
+    configureJournal();
     
-    // 设置同步模式为NORMAL（平衡性能和安全性）
-    executeSQLPrivate("PRAGMA synchronous = NORMAL");
-    
-    // 设置内存映射大小（限制为256KB以避免PSRAM问题）
-    executeSQLPrivate("PRAGMA mmap_size = 262144");
+    // 设置内存映射大小
+    executeSQLPrivate("PRAGMA mmap_size = " + String((unsigned long)storageProfile.mmapSize));
     
     // 启用外键约束
     executeSQLPrivate("PRAGMA foreign_keys = ON");
@@ -220,6 +430,9 @@ bool DatabaseManager::initialize(const String& dbPath, bool createIfNotExists) {
         debugPrint("现有数据库验证完成");
     }
     
+    // 预编译固定查询，之后每次使用只需重置与重新绑定参数
+    prepareStatements();
+    
     status = DB_READY;
     debugPrint("数据库初始化完成");
     return true;
@@ -232,10 +445,16 @@ bool DatabaseManager::initialize(const String& dbPath, bool createIfNotExists) {
  */
 bool DatabaseManager::close() {
     if (db) {
+        // 未结束的备份会让sqlite3_close()返回SQLITE_BUSY
+        cancelBackup();
+        flushGroupCommit(true);
+        finalizeStatements();
         int rc = sqlite3_close(db);
         if (rc == SQLITE_OK) {
             db = nullptr;
             dbInfo.isOpen = false;
+            walEnabled = false;
+            rawPartition = false;
             status = DB_NOT_INITIALIZED;
             debugPrint("数据库连接已关闭");
             return true;
@@ -269,46 +488,127 @@ DatabaseStatus DatabaseManager::getStatus() const {
  * @return DatabaseInfo 数据库信息
  */
 DatabaseInfo DatabaseManager::getDatabaseInfo() {
+    dbInfo.rawPartition = rawPartition;
     if (isReady()) {
-        // 更新数据库文件大小
-        // 从完整路径中提取LittleFS相对路径
-        String littleFSPath = dbPath.substring(9); // 去掉 "/littlefs/" 前缀
-        FilesystemManager& fsManager = FilesystemManager::getInstance();
-        fs::FS& fs = fsManager.getFS();
-        File dbFile = fs.open(littleFSPath, "r");
-        if (dbFile) {
-            dbInfo.dbSize = dbFile.size();
-            // 获取文件最后修改时间
-            time_t lastWrite = dbFile.getLastWrite();
-            if (lastWrite > 0) {
-                struct tm* timeinfo = localtime(&lastWrite);
-                char timeStr[64];
-                strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);
-                dbInfo.lastModified = String(timeStr);
-            } else {
-                dbInfo.lastModified = "未知";
+        if (rawPartition) {
+            // 原始分区没有修改时间，大小取自超级块
+            dbInfo.dbSize = FlashVfs::getInstance().getDatabaseSize();
+            dbInfo.lastModified = "未知";
+        } else {
+            // 更新数据库文件大小
+            // 从完整路径中提取LittleFS相对路径
+            String littleFSPath = dbPath.substring(9); // 去掉 "/littlefs/" 前缀
+            FilesystemManager& fsManager = FilesystemManager::getInstance();
+            fs::FS& fs = fsManager.getFS();
+            File dbFile = fs.open(littleFSPath, "r");
+            if (dbFile) {
+                dbInfo.dbSize = dbFile.size();
+                // 获取文件最后修改时间
+                time_t lastWrite = dbFile.getLastWrite();
+                if (lastWrite > 0) {
+                    struct tm* timeinfo = localtime(&lastWrite);
+                    char timeStr[64];
+                    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);
+                    dbInfo.lastModified = String(timeStr);
+                } else {
+                    dbInfo.lastModified = "未知";
+                }
+                dbFile.close();
             }
-            dbFile.close();
         }
         
         // 更新表数量和记录数
-        std::vector<std::map<String, String>> tableResults;
-        if (executeQuery("SELECT COUNT(*) as count FROM sqlite_master WHERE type='table'", queryCallback, &tableResults)) {
-            if (!tableResults.empty()) {
-                dbInfo.tableCount = tableResults[0]["count"].toInt();
-            }
-        }
+        queryInt("SELECT COUNT(*) FROM sqlite_master WHERE type='table'", dbInfo.tableCount);
+        queryInt("SELECT (SELECT COUNT(*) FROM forward_rules) + (SELECT COUNT(*) FROM sms_records) + (SELECT COUNT(*) FROM ap_config)", dbInfo.recordCount);
         
-        std::vector<std::map<String, String>> recordResults;
-        if (executeQuery("SELECT (SELECT COUNT(*) FROM forward_rules) + (SELECT COUNT(*) FROM sms_records) + (SELECT COUNT(*) FROM ap_config) as total", queryCallback, &recordResults)) {
-            if (!recordResults.empty()) {
-                dbInfo.recordCount = recordResults[0]["total"].toInt();
-            }
-        }
+        // 页面布局与缓存命中率
+        queryInt("PRAGMA page_size", dbInfo.pageSize);
+        dbInfo.cacheSizePages = storageProfile.cacheSizePages;
+        dbInfo.psramPageCache = psramPageCache;
+        dbInfo.psramHeap = psramHeap;
+        
+        int current = 0;
+        int highwater = 0;
+        sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_HIT, &current, &highwater, 0);
+        dbInfo.cacheHits = current;
+        sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, &current, &highwater, 0);
+        dbInfo.cacheMisses = current;
+        int lookups = dbInfo.cacheHits + dbInfo.cacheMisses;
+        dbInfo.cacheHitRatio = lookups > 0 ? (float)dbInfo.cacheHits / lookups : 0.0f;
     }
     return dbInfo;
 }
 
+/**
+ * @brief 设置存储配置
+ * @param profile 存储配置
+ */
+void DatabaseManager::setStorageProfile(const DbStorageProfile& profile) {
+    if (memoryConfigured) {
+        debugPrint("SQLite已初始化，PSRAM内存配置将在重启后生效");
+    }
+    storageProfile = profile;
+}
+
+/**
+ * @brief 获取默认存储配置
+ * @return DbStorageProfile 默认存储配置
+ */
+DbStorageProfile DatabaseManager::getDefaultStorageProfile() {
+    DbStorageProfile profile;
+    profile.pageSize = DB_PAGE_SIZE;
+    profile.cacheSizePages = DB_CACHE_SIZE_PAGES;
+    profile.psramPageCachePages = DB_PSRAM_PAGE_CACHE_PAGES;
+    profile.psramHeapBytes = DB_PSRAM_HEAP_SIZE;
+    profile.mmapSize = DB_MMAP_SIZE;
+    return profile;
+}
+
+/**
+ * @brief 按存储配置为SQLite分配PSRAM页面缓存与堆
+ */
+void DatabaseManager::configureMemory() {
+    if (memoryConfigured) {
+        return;
+    }
+    memoryConfigured = true;
+    
+    if (!psramFound()) {
+        debugPrint("未检测到PSRAM，SQLite使用默认内存分配");
+        return;
+    }
+    
+    // 页面缓存：每个槽为页面大小加上页缓存头部
+    if (storageProfile.psramPageCachePages > 0) {
+        int headerSize = 0;
+        sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &headerSize);
+        int slotSize = storageProfile.pageSize + headerSize;
+        size_t bytes = (size_t)slotSize * storageProfile.psramPageCachePages;
+        void* buffer = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if (buffer != nullptr &&
+            sqlite3_config(SQLITE_CONFIG_PAGECACHE, buffer, slotSize, storageProfile.psramPageCachePages) == SQLITE_OK) {
+            psramPageCache = true;
+            debugPrint("页面缓存位于PSRAM: " + String(storageProfile.psramPageCachePages) + " 页, " + String((unsigned long)bytes) + " 字节");
+        } else {
+            heap_caps_free(buffer);
+            debugPrint("分配PSRAM页面缓存失败，使用默认分配");
+        }
+    }
+    
+    // SQLite堆（语句、排序与临时结构），需要SQLITE_ENABLE_MEMSYS5
+    if (storageProfile.psramHeapBytes > 0) {
+        void* buffer = heap_caps_malloc(storageProfile.psramHeapBytes, MALLOC_CAP_SPIRAM);
+        if (buffer != nullptr &&
+            sqlite3_config(SQLITE_CONFIG_HEAP, buffer, (int)storageProfile.psramHeapBytes, DB_PSRAM_HEAP_MIN_ALLOC) == SQLITE_OK) {
+            psramHeap = true;
+            debugPrint("SQLite堆位于PSRAM: " + String((unsigned long)storageProfile.psramHeapBytes) + " 字节");
+        } else {
+            heap_caps_free(buffer);
+            debugPrint("配置PSRAM堆失败，使用系统malloc");
+        }
+    }
+}
+
 /**
  * @brief 获取最后的错误信息
  * @return String 错误信息
@@ -336,20 +636,15 @@ APConfig DatabaseManager::getAPConfig() {
         return config;
     }
     
-    debugPrint("[DatabaseManager] Executing query: SELECT * FROM ap_config WHERE id = 1");
-    std::vector<std::map<String, String>> configResults;
-    if (executeQuery("SELECT * FROM ap_config WHERE id = 1", queryCallback, &configResults)) {
-        debugPrint("[DatabaseManager] Query executed successfully, results count: " + String(configResults.size()));
-        if (!configResults.empty()) {
-            auto& row = configResults[0];
-            config.ssid = row["ssid"];
-            config.password = row["password"];
-            config.enabled = row["enabled"].toInt() == 1;
-            config.channel = row["channel"].toInt();
-            config.maxConnections = row["max_connections"].toInt();
-            config.createdAt = row["created_at"];
-            config.updatedAt = row["updated_at"];
-            
+    bool found = false;
+    bool ok = forEachRow("SELECT ssid, password, enabled, channel, max_connections, created_at, updated_at FROM ap_config WHERE id = 1",
+                         [&](sqlite3_stmt* stmt) {
+        apConfigDecoder().decode(stmt, config);
+        found = true;
+        return false;
+    });
+    if (ok) {
+        if (found) {
             debugPrint("[DatabaseManager] Loaded AP config from database:");
             debugPrint("  SSID: " + config.ssid);
             debugPrint("  Password: " + String(config.password.length() > 0 ? "[SET]" : "[EMPTY]"));
@@ -423,7 +718,7 @@ int DatabaseManager::addForwardRule(const ForwardRule& rule) {
         return -1;
     }
     
-    const char* sql = "INSERT INTO forward_rules (rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+    const char* sql = "INSERT INTO forward_rules (rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at, priority) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
     sqlite3_stmt* stmt;
     
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
@@ -443,6 +738,7 @@ int DatabaseManager::addForwardRule(const ForwardRule& rule) {
     sqlite3_bind_int(stmt, 7, rule.isDefaultForward ? 1 : 0);
     sqlite3_bind_text(stmt, 8, timestamp.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 9, timestamp.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 10, rule.priority);
     
     rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -470,7 +766,7 @@ bool DatabaseManager::updateForwardRule(const ForwardRule& rule) {
         return false;
     }
     
-    const char* sql = "UPDATE forward_rules SET rule_name=?, source_number=?, keywords=?, push_type=?, push_config=?, enabled=?, is_default_forward=?, updated_at=? WHERE id=?";
+    const char* sql = "UPDATE forward_rules SET rule_name=?, source_number=?, keywords=?, push_type=?, push_config=?, enabled=?, is_default_forward=?, updated_at=?, priority=? WHERE id=?";
     sqlite3_stmt* stmt;
     
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
@@ -489,7 +785,8 @@ bool DatabaseManager::updateForwardRule(const ForwardRule& rule) {
     sqlite3_bind_int(stmt, 6, rule.enabled ? 1 : 0);
     sqlite3_bind_int(stmt, 7, rule.isDefaultForward ? 1 : 0);
     sqlite3_bind_text(stmt, 8, timestamp.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 9, rule.id);
+    sqlite3_bind_int(stmt, 9, rule.priority);
+    sqlite3_bind_int(stmt, 10, rule.id);
     
     rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -551,49 +848,8 @@ std::vector<ForwardRule> DatabaseManager::getAllForwardRules() {
         return rules;
     }
     
-    // 使用线程安全的方式，避免全局变量冲突
-    std::vector<std::map<String, String>> localResults;
-    if (executeQuery("SELECT id, rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at FROM forward_rules ORDER BY id", queryCallback, &localResults)) {
-        for (const auto& row : localResults) {
-            ForwardRule rule;
-            
-            // 使用安全的访问方式，避免at()方法可能的异常
-            auto it_id = row.find("id");
-            rule.id = (it_id != row.end()) ? it_id->second.toInt() : -1;
-            
-            auto it_name = row.find("rule_name");
-            rule.ruleName = (it_name != row.end()) ? it_name->second : "";
-            
-            auto it_source = row.find("source_number");
-            rule.sourceNumber = (it_source != row.end()) ? it_source->second : "";
-            
-            auto it_keywords = row.find("keywords");
-            rule.keywords = (it_keywords != row.end()) ? it_keywords->second : "";
-            
-            auto it_push_type = row.find("push_type");
-            rule.pushType = (it_push_type != row.end()) ? it_push_type->second : "";
-            
-            auto it_push_config = row.find("push_config");
-            rule.pushConfig = (it_push_config != row.end()) ? it_push_config->second : "{}";
-            
-            auto it_enabled = row.find("enabled");
-            rule.enabled = (it_enabled != row.end()) ? (it_enabled->second.toInt() == 1) : false;
-            
-            auto it_default = row.find("is_default_forward");
-            rule.isDefaultForward = (it_default != row.end()) ? (it_default->second.toInt() == 1) : false;
-            
-            auto it_created = row.find("created_at");
-            rule.createdAt = (it_created != row.end()) ? it_created->second : "";
-            
-            auto it_updated = row.find("updated_at");
-            rule.updatedAt = (it_updated != row.end()) ? it_updated->second : "";
-            
-            // 只有当规则ID有效时才添加到结果中
-            if (rule.id > 0) {
-                rules.push_back(rule);
-            }
-        }
-    }
+    queryRows(String("SELECT id, rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at, priority FROM forward_rules ORDER BY id"),
+              forwardRuleDecoder(), rules);
     
     return rules;
 }
@@ -612,50 +868,67 @@ ForwardRule DatabaseManager::getForwardRuleById(int ruleId) {
         return rule;
     }
     
-    const char* sql = "SELECT id, rule_name, source_number, keywords, push_type, push_config, enabled, is_default_forward, created_at, updated_at FROM forward_rules WHERE id=?";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_GET_RULE_BY_ID);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return rule;
     }
     
     sqlite3_bind_int(stmt, 1, ruleId);
     
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        rule.id = sqlite3_column_int(stmt, 0);
-        
-        // 安全地获取文本列，防止空指针访问
-        const char* text1 = (const char*)sqlite3_column_text(stmt, 1);
-        rule.ruleName = text1 ? String(text1) : "";
-        
-        const char* text2 = (const char*)sqlite3_column_text(stmt, 2);
-        rule.sourceNumber = text2 ? String(text2) : "";
-        
-        const char* text3 = (const char*)sqlite3_column_text(stmt, 3);
-        rule.keywords = text3 ? String(text3) : "";
-        
-        const char* text4 = (const char*)sqlite3_column_text(stmt, 4);
-        rule.pushType = text4 ? String(text4) : "";
-        
-        const char* text5 = (const char*)sqlite3_column_text(stmt, 5);
-        rule.pushConfig = text5 ? String(text5) : "{}";
-        
-        rule.enabled = sqlite3_column_int(stmt, 6) == 1;
-        rule.isDefaultForward = sqlite3_column_int(stmt, 7) == 1;
-        
-        const char* text8 = (const char*)sqlite3_column_text(stmt, 8);
-        rule.createdAt = text8 ? String(text8) : "";
-        
-        const char* text9 = (const char*)sqlite3_column_text(stmt, 9);
-        rule.updatedAt = text9 ? String(text9) : "";
+        forwardRuleDecoder().decode(stmt, rule);
     }
     
-    sqlite3_finalize(stmt);
     return rule;
 }
 
+/**
+ * @brief 按条件查询转发规则
+ * @param enabledFilter 启用状态过滤：1只查启用，0只查禁用，-1不过滤
+ * @param pushType 推送类型过滤，为空时不过滤
+ * @param limit 限制数量，小于等于0时不限制
+ * @param offset 偏移量
+ * @return std::vector<ForwardRule> 按ID升序的转发规则列表
+ */
+std::vector<ForwardRule> DatabaseManager::getForwardRules(int enabledFilter, const String& pushType, int limit, int offset,
+                                                          bool orderByPriority) {
+    std::vector<ForwardRule> rules;
+    
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return rules;
+    }
+    
+    CachedStatement statement(*this, DB_STMT_GET_RULES);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return rules;
+    }
+    
+    // 未使用的条件绑定为NULL
+    if (enabledFilter >= 0) {
+        sqlite3_bind_int(stmt, 1, enabledFilter);
+    } else {
+        sqlite3_bind_null(stmt, 1);
+    }
+    if (!pushType.isEmpty()) {
+        sqlite3_bind_text(stmt, 2, pushType.c_str(), -1, SQLITE_TRANSIENT);
+    } else {
+        sqlite3_bind_null(stmt, 2);
+    }
+    sqlite3_bind_int(stmt, 3, limit > 0 ? limit : -1);
+    sqlite3_bind_int(stmt, 4, offset > 0 ? offset : 0);
+    sqlite3_bind_int(stmt, 5, orderByPriority ? 1 : 0);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        rules.emplace_back();
+        forwardRuleDecoder().decode(stmt, rules.back());
+    }
+    
+    return rules;
+}
+
 /**
  * @brief 获取转发规则总数
  * @return int 规则总数
@@ -666,12 +939,9 @@ int DatabaseManager::getForwardRuleCount() {
         return 0;
     }
     
-    const char* sql = "SELECT COUNT(*) FROM forward_rules";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_COUNT_RULES);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return 0;
     }
     
@@ -680,7 +950,6 @@ int DatabaseManager::getForwardRuleCount() {
         count = sqlite3_column_int(stmt, 0);
     }
     
-    sqlite3_finalize(stmt);
     return count;
 }
 
@@ -694,12 +963,9 @@ int DatabaseManager::getEnabledForwardRuleCount() {
         return 0;
     }
     
-    const char* sql = "SELECT COUNT(*) FROM forward_rules WHERE enabled = 1";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_COUNT_ENABLED_RULES);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return 0;
     }
     
@@ -708,7 +974,6 @@ int DatabaseManager::getEnabledForwardRuleCount() {
         count = sqlite3_column_int(stmt, 0);
     }
     
-    sqlite3_finalize(stmt);
     return count;
 }
 
@@ -723,14 +988,13 @@ int DatabaseManager::addSMSRecord(const SMSRecord& record) {
         return -1;
     }
     
-    time_t receivedTime = record.receivedAt != 0 ? record.receivedAt : time(nullptr);
+    joinGroupCommit();
     
-    const char* sql = "INSERT INTO sms_records (from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at) VALUES (?, ?, ?, ?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt;
+    time_t receivedTime = record.receivedAt != 0 ? record.receivedAt : time(nullptr);
     
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_INSERT_SMS);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return -1;
     }
     
@@ -744,9 +1008,7 @@ int DatabaseManager::addSMSRecord(const SMSRecord& record) {
     sqlite3_bind_text(stmt, 7, record.forwardedAt.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int64(stmt, 8, receivedTime);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
+    int rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
         setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
         return -1;
@@ -767,12 +1029,11 @@ bool DatabaseManager::updateSMSRecord(const SMSRecord& record) {
         return false;
     }
     
-    const char* sql = "UPDATE sms_records SET from_number=?, to_number=?, content=?, rule_id=?, forwarded=?, status=?, forwarded_at=?, received_at=? WHERE id=?";
-    sqlite3_stmt* stmt;
+    joinGroupCommit();
     
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_UPDATE_SMS);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return false;
     }
     
@@ -787,9 +1048,7 @@ bool DatabaseManager::updateSMSRecord(const SMSRecord& record) {
     sqlite3_bind_int64(stmt, 8, record.receivedAt);
     sqlite3_bind_int(stmt, 9, record.id);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
+    int rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
         setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
         return false;
@@ -811,12 +1070,9 @@ std::vector<SMSRecord> DatabaseManager::getSMSRecords(int limit, int offset) {
         return records;
     }
     
-    const char* sql = "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records ORDER BY received_at DESC LIMIT ? OFFSET ?";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_GET_SMS_PAGE);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return records;
     }
     
@@ -824,33 +1080,79 @@ std::vector<SMSRecord> DatabaseManager::getSMSRecords(int limit, int offset) {
     sqlite3_bind_int(stmt, 2, offset);
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        SMSRecord record;
-        record.id = sqlite3_column_int(stmt, 0);
-        
-        // 安全地获取文本列，防止空指针访问
-        const char* fromNum = (const char*)sqlite3_column_text(stmt, 1);
-        record.fromNumber = fromNum ? String(fromNum) : "";
-        
-        const char* toNum = (const char*)sqlite3_column_text(stmt, 2);
-        record.toNumber = toNum ? String(toNum) : "";
-        
-        const char* content = (const char*)sqlite3_column_text(stmt, 3);
-        record.content = content ? String(content) : "";
-        
-        record.ruleId = sqlite3_column_int(stmt, 4);
-        record.forwarded = sqlite3_column_int(stmt, 5) == 1;
-        
-        const char* status = (const char*)sqlite3_column_text(stmt, 6);
-        record.status = status ? String(status) : "";
-        
-        const char* forwardedAt = (const char*)sqlite3_column_text(stmt, 7);
-        record.forwardedAt = forwardedAt ? String(forwardedAt) : "";
-        
-        record.receivedAt = sqlite3_column_int64(stmt, 8);
-        records.push_back(record);
+        records.emplace_back();
+        smsRecordDecoder().decode(stmt, records.back());
+    }
+    
+    return records;
+}
+
+/**
+ * @brief 按游标获取短信记录
+ * @param beforeTs 游标接收时间
+ * @param beforeId 游标记录ID，小于等于0时返回最新一页
+ * @param limit 限制数量
+ * @return std::vector<SMSRecord> 短信记录列表
+ */
+std::vector<SMSRecord> DatabaseManager::getSMSRecordsBefore(time_t beforeTs, int beforeId, int limit) {
+    std::vector<SMSRecord> records;
+    
+    if (!isReady()) {
+        return records;
+    }
+    
+    bool fromLatest = beforeId <= 0;
+    CachedStatement statement(*this, fromLatest ? DB_STMT_GET_SMS_LATEST : DB_STMT_GET_SMS_BEFORE);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return records;
+    }
+    
+    if (fromLatest) {
+        sqlite3_bind_int(stmt, 1, limit);
+    } else {
+        sqlite3_bind_int64(stmt, 1, beforeTs);
+        sqlite3_bind_int(stmt, 2, beforeId);
+        sqlite3_bind_int(stmt, 3, limit);
+    }
+    
+    records.reserve(limit);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        records.emplace_back();
+        smsRecordDecoder().decode(stmt, records.back());
+    }
+    
+    return records;
+}
+
+/**
+ * @brief 获取ID大于水位的短信记录
+ * @param afterId 水位ID（不含）
+ * @param limit 限制数量
+ * @return std::vector<SMSRecord> 短信记录列表
+ */
+std::vector<SMSRecord> DatabaseManager::getSMSRecordsAfterId(int afterId, int limit) {
+    std::vector<SMSRecord> records;
+    
+    if (!isReady()) {
+        return records;
+    }
+    
+    CachedStatement statement(*this, DB_STMT_GET_SMS_AFTER_ID);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return records;
+    }
+    
+    sqlite3_bind_int(stmt, 1, afterId);
+    sqlite3_bind_int(stmt, 2, limit);
+    
+    records.reserve(limit);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        records.emplace_back();
+        smsRecordDecoder().decode(stmt, records.back());
     }
     
-    sqlite3_finalize(stmt);
     return records;
 }
 
@@ -868,79 +1170,169 @@ SMSRecord DatabaseManager::getSMSRecordById(int recordId) {
         return record;
     }
     
-    const char* sql = "SELECT id, from_number, to_number, content, rule_id, forwarded, status, forwarded_at, received_at FROM sms_records WHERE id=?";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_GET_SMS_BY_ID);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return record;
     }
     
     sqlite3_bind_int(stmt, 1, recordId);
     
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        record.id = sqlite3_column_int(stmt, 0);
-        
-        // 安全地获取文本列，防止空指针访问
-        const char* fromNum = (const char*)sqlite3_column_text(stmt, 1);
-        record.fromNumber = fromNum ? String(fromNum) : "";
-        
-        const char* toNum = (const char*)sqlite3_column_text(stmt, 2);
-        record.toNumber = toNum ? String(toNum) : "";
-        
-        const char* content = (const char*)sqlite3_column_text(stmt, 3);
-        record.content = content ? String(content) : "";
-        
-        record.ruleId = sqlite3_column_int(stmt, 4);
-        record.forwarded = sqlite3_column_int(stmt, 5) == 1;
-        
-        const char* status = (const char*)sqlite3_column_text(stmt, 6);
-        record.status = status ? String(status) : "";
-        
-        const char* forwardedAt = (const char*)sqlite3_column_text(stmt, 7);
-        record.forwardedAt = forwardedAt ? String(forwardedAt) : "";
-        
-        record.receivedAt = sqlite3_column_int64(stmt, 8);
+        smsRecordDecoder().decode(stmt, record);
     }
     
-    sqlite3_finalize(stmt);
     return record;
 }
 
 /**
- * @brief 删除过期的短信记录
- * @param daysOld 保留天数
- * @return int 删除的记录数
+ * @brief 搜索短信内容与发送方号码
+ * @param query 搜索词
+ * @param limit 限制数量
+ * @return std::vector<SMSRecord> 匹配的短信记录（最新的在前）
  */
-int DatabaseManager::deleteOldSMSRecords(int daysOld) {
+std::vector<SMSRecord> DatabaseManager::searchSMS(const String& query, int limit) {
+    std::vector<SMSRecord> records;
+    
     if (!isReady()) {
         setError("数据库未就绪");
-        return 0;
+        return records;
     }
-    
-    time_t cutoffTime = time(nullptr) - (daysOld * 24 * 60 * 60); // 计算截止时间戳
-    const char* sql = "DELETE FROM sms_records WHERE received_at < ?";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
-        return 0;
+    if (query.isEmpty()) {
+        return records;
     }
     
-    sqlite3_bind_int64(stmt, 1, cutoffTime);
+    // trigram分词至少需要3个字符，更短的搜索词退回表扫描
+    bool useIndex = ftsEnabled && utf8Length(query) >= SMS_SEARCH_MIN_INDEXED_CHARS;
+    CachedStatement statement(*this, useIndex ? DB_STMT_SEARCH_SMS : DB_STMT_SEARCH_SMS_SCAN);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return records;
+    }
     
-    rc = sqlite3_step(stmt);
-    int deletedCount = 0;
-    if (rc == SQLITE_DONE) {
-        deletedCount = sqlite3_changes(db);
+    if (useIndex) {
+        // 作为短语整体匹配，避免搜索词中的FTS5语法字符被解释
+        String phrase = query;
+        phrase.replace("\"", "\"\"");
+        phrase = "\"" + phrase + "\"";
+        sqlite3_bind_text(stmt, 1, phrase.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 2, limit);
     } else {
-        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        String pattern = query;
+        pattern.replace("\\", "\\\\");
+        pattern.replace("%", "\\%");
+        pattern.replace("_", "\\_");
+        pattern = "%" + pattern + "%";
+        sqlite3_bind_text(stmt, 1, pattern.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, pattern.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 3, limit);
     }
     
-    sqlite3_finalize(stmt);
-    return deletedCount;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        records.emplace_back();
+        smsRecordDecoder().decode(stmt, records.back());
+    }
+    if (rc != SQLITE_DONE) {
+        setError("搜索短信失败: " + String(sqlite3_errmsg(db)));
+    }
+    
+    return records;
+}
+
+/**
+ * @brief 按ID倒序读取一批ID小于游标的短信并逐行回调
+ * @param beforeId 游标ID（不含），小于等于0时从最新的记录开始
+ * @param matchQuery FTS5查询表达式，空字符串表示不预筛选
+ * @param limit 本批最多读取的记录数
+ * @param visitor 行回调
+ * @param lastId 输出：本批最后一条记录的ID（下一批的游标）
+ * @return int 本批读取的记录数，失败返回-1
+ */
+int DatabaseManager::scanSMSBatch(int beforeId, const String& matchQuery, int limit,
+                                  const SmsRowVisitor& visitor, int& lastId) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return -1;
+    }
+    
+    bool useIndex = ftsEnabled && !matchQuery.isEmpty();
+    CachedStatement statement(*this, useIndex ? DB_STMT_SCAN_SMS_MATCH_BEFORE_ID : DB_STMT_SCAN_SMS_BEFORE_ID);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return -1;
+    }
+    
+    int column = 1;
+    if (useIndex) {
+        sqlite3_bind_text(stmt, column++, matchQuery.c_str(), matchQuery.length(), SQLITE_STATIC);
+    }
+    sqlite3_bind_int(stmt, column++, beforeId > 0 ? beforeId : INT_MAX);
+    sqlite3_bind_int(stmt, column, limit);
+    
+    int count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* fromNumber = (const char*)sqlite3_column_text(stmt, 1);
+        const char* content = (const char*)sqlite3_column_text(stmt, 2);
+        lastId = sqlite3_column_int(stmt, 0);
+        visitor(lastId, fromNumber != nullptr ? fromNumber : "", content != nullptr ? content : "",
+                (time_t)sqlite3_column_int64(stmt, 3));
+        count++;
+    }
+    if (rc != SQLITE_DONE) {
+        setError("读取短信失败: " + String(sqlite3_errmsg(db)));
+        return -1;
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 全文索引是否可用
+ * @return true 可用
+ * @return false 不可用
+ */
+bool DatabaseManager::isSearchIndexEnabled() const {
+    return ftsEnabled;
+}
+
+/**
+ * @brief 计算UTF-8字符串的字符数
+ * @param text 字符串
+ * @return size_t 字符数
+ */
+size_t DatabaseManager::utf8Length(const String& text) {
+    size_t count = 0;
+    for (size_t i = 0; i < text.length(); i++) {
+        // 只统计非续字节
+        if (((uint8_t)text[i] & 0xC0) != 0x80) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 删除过期的短信记录
+ * @param daysOld 保留天数
+ * @return int 删除的记录数
+ */
+int DatabaseManager::deleteOldSMSRecords(int daysOld) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return 0;
+    }
+    
+    time_t cutoffTime = time(nullptr) - (daysOld * 24 * 60 * 60); // 计算截止时间戳
+    
+    // 分批删除，批次之间释放数据库，避免长时间占用
+    int deletedCount = 0;
+    int batch;
+    while ((batch = deleteSMSBatchBefore(0, cutoffTime, SMS_BATCH_SIZE)) > 0) {
+        deletedCount += batch;
+    }
+    return deletedCount;
 }
 
 /**
@@ -953,12 +1345,9 @@ int DatabaseManager::getSMSRecordCount() {
         return 0;
     }
     
-    const char* sql = "SELECT COUNT(*) FROM sms_records";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
+    CachedStatement statement(*this, DB_STMT_COUNT_SMS);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
         return 0;
     }
     
@@ -967,7 +1356,6 @@ int DatabaseManager::getSMSRecordCount() {
         count = sqlite3_column_int(stmt, 0);
     }
     
-    sqlite3_finalize(stmt);
     return count;
 }
 
@@ -989,28 +1377,18 @@ int DatabaseManager::cleanupSMSRecordsByCount(int keepCount) {
         return 0;
     }
     
-    // 删除最旧的记录，保留最新的keepCount条
-    const char* sql = "DELETE FROM sms_records WHERE id NOT IN (SELECT id FROM sms_records ORDER BY received_at DESC LIMIT ?)";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        setError("准备SQL语句失败: " + String(sqlite3_errmsg(db)));
-        return 0;
-    }
-    
-    sqlite3_bind_int(stmt, 1, keepCount);
-    
-    rc = sqlite3_step(stmt);
+    // 按rowid从最旧的记录开始分批删除，保留最新的keepCount条
     int deletedCount = 0;
-    if (rc == SQLITE_DONE) {
-        deletedCount = sqlite3_changes(db);
-        debugPrint("按数量清理完成，删除了 " + String(deletedCount) + " 条记录，保留最新 " + String(keepCount) + " 条");
-    } else {
-        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+    int excess = totalCount - keepCount;
+    while (deletedCount < excess) {
+        int remaining = excess - deletedCount;
+        int batch = deleteOldestSMSBatch(remaining < SMS_BATCH_SIZE ? remaining : SMS_BATCH_SIZE);
+        if (batch <= 0) {
+            break;
+        }
+        deletedCount += batch;
     }
-    
-    sqlite3_finalize(stmt);
+    debugPrint("按数量清理完成，删除了 " + String(deletedCount) + " 条记录，保留最新 " + String(keepCount) + " 条");
     return deletedCount;
 }
 
@@ -1037,6 +1415,798 @@ int DatabaseManager::checkAndCleanupSMSRecords(int maxCount, int keepCount) {
     return 0;
 }
 
+/**
+ * @brief 执行一次后台保留清理（由定时任务调用）
+ * @param budgetMs 本次最多占用的时间（毫秒）
+ * @return int 删除的记录数
+ */
+int DatabaseManager::runRetentionStep(unsigned long budgetMs) {
+    if (!isReady()) {
+        return 0;
+    }
+    
+    unsigned long startTime = millis();
+    int deletedCount = 0;
+    
+    // 超过上限后持续清理，直到回落到保留数量（避免在上限附近反复触发）
+    int currentCount = getSMSRecordCount();
+    if (currentCount > MAX_SMS_RECORDS_COUNT) {
+        retentionActive = true;
+    }
+    while (retentionActive && millis() - startTime < budgetMs) {
+        int excess = currentCount - SMS_CLEANUP_KEEP_COUNT;
+        if (excess <= 0) {
+            retentionActive = false;
+            break;
+        }
+        int batch = deleteOldestSMSBatch(excess < SMS_BATCH_SIZE ? excess : SMS_BATCH_SIZE);
+        if (batch <= 0) {
+            break;
+        }
+        deletedCount += batch;
+        currentCount -= batch;
+    }
+    
+    // 按保留天数清理；系统时间未同步时接收的记录时间不可靠，不参与按时间清理
+    time_t now = time(nullptr);
+    if (now >= DB_RETENTION_MIN_VALID_TIME) {
+        time_t cutoffTime = now - (time_t)DEFAULT_SMS_RETENTION_DAYS * 24 * 60 * 60;
+        while (millis() - startTime < budgetMs) {
+            int batch = deleteSMSBatchBefore(DB_RETENTION_MIN_VALID_TIME, cutoffTime, SMS_BATCH_SIZE);
+            if (batch <= 0) {
+                break;
+            }
+            deletedCount += batch;
+        }
+    }
+    
+    if (deletedCount > 0) {
+        debugPrint("后台清理删除了 " + String(deletedCount) + " 条短信记录");
+        return deletedCount;
+    }
+    
+    // 没有待清理的记录且一段时间内没有写入时，回收空闲页
+    if (millis() - lastWriteAt >= DB_VACUUM_IDLE_MS) {
+        reclaimFreePages(DB_VACUUM_PAGES_PER_STEP);
+    }
+    return 0;
+}
+
+/**
+ * @brief 回收空闲页（PRAGMA incremental_vacuum）
+ * @param maxPages 最多回收的页数
+ * @return int 回收的页数
+ */
+int DatabaseManager::reclaimFreePages(int maxPages) {
+    if (!isReady()) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> lock(dbMutex);
+    
+    // auto_vacuum需在建表前设置才生效，旧数据库可能仍为NONE
+    int autoVacuum = 0;
+    int freePages = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "PRAGMA auto_vacuum", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            autoVacuum = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (autoVacuum != 2) {
+        return 0;
+    }
+    if (sqlite3_prepare_v2(db, "PRAGMA freelist_count", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            freePages = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (freePages == 0) {
+        return 0;
+    }
+    
+    int pages = freePages < maxPages ? freePages : maxPages;
+    String sql = "PRAGMA incremental_vacuum(" + String(pages) + ")";
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        setError("回收空闲页失败: " + String(sqlite3_errmsg(db)));
+        return 0;
+    }
+    debugPrint("回收了 " + String(pages) + " 个空闲页，剩余 " + String(freePages - pages) + " 个");
+    return pages;
+}
+
+/**
+ * @brief 按rowid删除最旧的一批短信记录
+ * @param limit 最多删除的记录数
+ * @return int 删除的记录数，-1表示失败
+ */
+int DatabaseManager::deleteOldestSMSBatch(int limit) {
+    CachedStatement statement(*this, DB_STMT_DELETE_OLDEST_SMS);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return -1;
+    }
+    
+    sqlite3_bind_int(stmt, 1, limit);
+    
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return -1;
+    }
+    return sqlite3_changes(db);
+}
+
+/**
+ * @brief 删除一批接收时间在[notBefore, cutoff)内的短信记录
+ * @param notBefore 接收时间下限
+ * @param cutoff 接收时间上限（不含）
+ * @param limit 最多删除的记录数
+ * @return int 删除的记录数，-1表示失败
+ */
+int DatabaseManager::deleteSMSBatchBefore(time_t notBefore, time_t cutoff, int limit) {
+    CachedStatement statement(*this, DB_STMT_DELETE_SMS_BEFORE);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return -1;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, notBefore);
+    sqlite3_bind_int64(stmt, 2, cutoff);
+    sqlite3_bind_int(stmt, 3, limit);
+    
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return -1;
+    }
+    return sqlite3_changes(db);
+}
+
+/**
+ * @brief 添加推送发件箱条目
+ * @param entry 发件箱条目
+ * @return int 条目ID，-1表示失败
+ */
+int DatabaseManager::addPushOutboxEntry(const PushOutboxEntry& entry) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return -1;
+    }
+    
+    joinGroupCommit();
+    
+    CachedStatement statement(*this, DB_STMT_INSERT_OUTBOX);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return -1;
+    }
+    
+    time_t createdAt = entry.createdAt != 0 ? entry.createdAt : time(nullptr);
+    
+    sqlite3_bind_int(stmt, 1, entry.smsId);
+    sqlite3_bind_int(stmt, 2, entry.ruleId);
+    sqlite3_bind_int(stmt, 3, entry.attempt);
+    sqlite3_bind_int64(stmt, 4, entry.nextAttemptAt);
+    sqlite3_bind_text(stmt, 5, entry.lastError.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 6, createdAt);
+    sqlite3_bind_text(stmt, 7, entry.followerRuleIds.c_str(), -1, SQLITE_TRANSIENT);
+    
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return -1;
+    }
+    
+    return sqlite3_last_insert_rowid(db);
+}
+
+/**
+ * @brief 更新推送发件箱条目（尝试次数、下次尝试时间、错误信息）
+ * @param entry 发件箱条目
+ * @return true 更新成功
+ * @return false 更新失败
+ */
+bool DatabaseManager::updatePushOutboxEntry(const PushOutboxEntry& entry) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    joinGroupCommit();
+    
+    CachedStatement statement(*this, DB_STMT_UPDATE_OUTBOX);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, entry.attempt);
+    sqlite3_bind_int64(stmt, 2, entry.nextAttemptAt);
+    sqlite3_bind_text(stmt, 3, entry.lastError.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, entry.id);
+    
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 删除推送发件箱条目
+ * @param entryId 条目ID
+ * @return true 删除成功
+ * @return false 删除失败
+ */
+bool DatabaseManager::deletePushOutboxEntry(int entryId) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    joinGroupCommit();
+    
+    CachedStatement statement(*this, DB_STMT_DELETE_OUTBOX);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, entryId);
+    
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 根据ID获取推送发件箱条目
+ * @param entryId 条目ID
+ * @return PushOutboxEntry 发件箱条目，id为-1表示未找到
+ */
+PushOutboxEntry DatabaseManager::getPushOutboxEntryById(int entryId) {
+    PushOutboxEntry entry;
+    entry.id = -1; // 表示未找到
+    entry.smsId = 0;
+    entry.ruleId = 0;
+    entry.attempt = 0;
+    entry.nextAttemptAt = 0;
+    entry.createdAt = 0;
+    
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return entry;
+    }
+    
+    CachedStatement statement(*this, DB_STMT_GET_OUTBOX_BY_ID);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return entry;
+    }
+    
+    sqlite3_bind_int(stmt, 1, entryId);
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        outboxEntryDecoder().decode(stmt, entry);
+    }
+    
+    return entry;
+}
+
+/**
+ * @brief 获取到期的推送发件箱条目
+ * @param now 当前时间
+ * @param horizon 最大退避时长，next_attempt_at超过now+horizon的条目视为时钟回拨，同样返回
+ * @param limit 最大返回数量
+ * @return std::vector<PushOutboxEntry> 到期条目列表（按下次尝试时间升序）
+ */
+std::vector<PushOutboxEntry> DatabaseManager::getDuePushOutboxEntries(time_t now, time_t horizon, int limit) {
+    std::vector<PushOutboxEntry> entries;
+    
+    if (!isReady()) {
+        return entries;
+    }
+    
+    // 重启后系统时间可能尚未同步（回到1970年），此时远超退避上限的条目同样视为到期
+    CachedStatement statement(*this, DB_STMT_GET_DUE_OUTBOX);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return entries;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, now);
+    sqlite3_bind_int64(stmt, 2, now + horizon);
+    sqlite3_bind_int(stmt, 3, limit);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        entries.emplace_back();
+        outboxEntryDecoder().decode(stmt, entries.back());
+    }
+    
+    return entries;
+}
+
+/**
+ * @brief 获取推送发件箱条目数量
+ * @return int 条目数量
+ */
+int DatabaseManager::getPushOutboxCount() {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return 0;
+    }
+    
+    CachedStatement statement(*this, DB_STMT_COUNT_OUTBOX);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return 0;
+    }
+    
+    int count = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 记录一条来信指纹
+ * @param fingerprint 指纹
+ * @return true 记录成功
+ * @return false 记录失败
+ */
+bool DatabaseManager::addSmsFingerprint(uint32_t fingerprint) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    joinGroupCommit();
+    
+    sqlite3_int64 id = 0;
+    {
+        CachedStatement statement(*this, DB_STMT_INSERT_SMS_FINGERPRINT);
+        sqlite3_stmt* stmt = statement.get();
+        if (stmt == nullptr) {
+            return false;
+        }
+        
+        sqlite3_bind_int64(stmt, 1, fingerprint);
+        sqlite3_bind_int64(stmt, 2, time(nullptr));
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+            return false;
+        }
+        id = sqlite3_last_insert_rowid(db);
+    }
+    
+    // 按自增ID截断，删除量固定为每次最多一条
+    if (id > SMS_DEDUP_PERSISTED_ENTRIES) {
+        CachedStatement statement(*this, DB_STMT_TRIM_SMS_FINGERPRINTS);
+        sqlite3_stmt* stmt = statement.get();
+        if (stmt != nullptr) {
+            sqlite3_bind_int64(stmt, 1, id - SMS_DEDUP_PERSISTED_ENTRIES);
+            sqlite3_step(stmt);
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 获取最近记录的来信指纹
+ * @param limit 最大返回数量
+ * @return std::vector<uint32_t> 指纹列表（从旧到新）
+ */
+std::vector<uint32_t> DatabaseManager::getRecentSmsFingerprints(int limit) {
+    std::vector<uint32_t> fingerprints;
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return fingerprints;
+    }
+    
+    CachedStatement statement(*this, DB_STMT_GET_SMS_FINGERPRINTS);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return fingerprints;
+    }
+    
+    sqlite3_bind_int(stmt, 1, limit);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        fingerprints.push_back((uint32_t)sqlite3_column_int64(stmt, 0));
+    }
+    
+    return fingerprints;
+}
+
+/**
+ * @brief 保存短信的链路追踪
+ * @param smsId 短信记录ID
+ * @param trace 追踪文本
+ * @return true 保存成功
+ * @return false 保存失败
+ */
+bool DatabaseManager::saveSmsTrace(int smsId, const String& trace) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    joinGroupCommit();
+    
+    CachedStatement statement(*this, DB_STMT_SAVE_SMS_TRACE);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, smsId);
+    sqlite3_bind_text(stmt, 2, trace.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        setError("执行SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 获取短信的链路追踪
+ * @param smsId 短信记录ID
+ * @param trace 输出：追踪文本
+ * @return true 找到追踪
+ * @return false 没有追踪或查询失败
+ */
+bool DatabaseManager::getSmsTrace(int smsId, String& trace) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    CachedStatement statement(*this, DB_STMT_GET_SMS_TRACE);
+    sqlite3_stmt* stmt = statement.get();
+    if (stmt == nullptr) {
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, smsId);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+    const unsigned char* text = sqlite3_column_text(stmt, 0);
+    trace = text != nullptr ? String((const char*)text) : String("");
+    return true;
+}
+
+/**
+ * @brief 批量导入号码名单
+ * @param listName 名单名
+ * @param numbers 已规范化的号码，以'\n'分隔
+ * @param replace 是否先清空该名单
+ * @return int 新增的号码数，-1表示导入失败
+ */
+int DatabaseManager::importNumberList(const String& listName, const char* numbers, bool replace) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return -1;
+    }
+    
+    if (!beginTransaction()) {
+        setError("开始事务失败");
+        return -1;
+    }
+    
+    if (replace) {
+        sqlite3_stmt* deleteStmt;
+        if (sqlite3_prepare_v2(db, "DELETE FROM number_list_entries WHERE list_name = ?", -1, &deleteStmt, nullptr) != SQLITE_OK) {
+            setError("准备删除SQL语句失败: " + String(sqlite3_errmsg(db)));
+            rollbackTransaction();
+            return -1;
+        }
+        sqlite3_bind_text(deleteStmt, 1, listName.c_str(), -1, SQLITE_TRANSIENT);
+        int rc = sqlite3_step(deleteStmt);
+        sqlite3_finalize(deleteStmt);
+        if (rc != SQLITE_DONE) {
+            setError("清空号码名单失败: " + String(sqlite3_errmsg(db)));
+            rollbackTransaction();
+            return -1;
+        }
+    }
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO number_list_entries (list_name, number, created_at) VALUES (?, ?, ?)",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        setError("准备插入SQL语句失败: " + String(sqlite3_errmsg(db)));
+        rollbackTransaction();
+        return -1;
+    }
+    
+    // 一次绑定名单名与时间，逐个号码重置后只重新绑定号码
+    sqlite3_bind_text(stmt, 1, listName.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 3, (sqlite3_int64)time(nullptr));
+    int added = 0;
+    const char* begin = numbers;
+    while (*begin != '\0') {
+        const char* end = strchr(begin, '\n');
+        size_t length = end != nullptr ? end - begin : strlen(begin);
+        if (length > 0) {
+            sqlite3_bind_text(stmt, 2, begin, (int)length, SQLITE_TRANSIENT);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                setError("插入号码失败: " + String(sqlite3_errmsg(db)));
+                sqlite3_finalize(stmt);
+                rollbackTransaction();
+                return -1;
+            }
+            added += sqlite3_changes(db);
+            sqlite3_reset(stmt);
+        }
+        if (end == nullptr) {
+            break;
+        }
+        begin = end + 1;
+    }
+    sqlite3_finalize(stmt);
+    
+    if (!commitTransaction()) {
+        rollbackTransaction();
+        setError("提交事务失败");
+        return -1;
+    }
+    
+    debugPrint("号码名单 " + listName + " 导入完成，新增 " + String(added) + " 个号码");
+    return added;
+}
+
+/**
+ * @brief 删除整个号码名单
+ * @param listName 名单名
+ * @return true 删除成功
+ * @return false 删除失败
+ */
+bool DatabaseManager::deleteNumberList(const String& listName) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "DELETE FROM number_list_entries WHERE list_name = ?", -1, &stmt, nullptr) != SQLITE_OK) {
+        setError("准备删除SQL语句失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, listName.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        setError("删除号码名单失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 获取所有号码名单及其号码数量
+ * @return std::vector<NumberListSummary> 名单摘要
+ */
+std::vector<NumberListSummary> DatabaseManager::getNumberListSummaries() {
+    std::vector<NumberListSummary> summaries;
+    forEachRow("SELECT list_name, COUNT(*) FROM number_list_entries GROUP BY list_name ORDER BY list_name",
+               [&](sqlite3_stmt* stmt) {
+        NumberListSummary summary;
+        summary.name = String((const char*)sqlite3_column_text(stmt, 0));
+        summary.count = sqlite3_column_int(stmt, 1);
+        summaries.push_back(summary);
+        return true;
+    });
+    return summaries;
+}
+
+/**
+ * @brief 逐个读取名单中的号码
+ * @param listName 名单名
+ * @param visitor 号码回调
+ * @return true 读取成功
+ * @return false 读取失败
+ */
+bool DatabaseManager::forEachNumberListEntry(const String& listName,
+                                             const std::function<void(const char* number)>& visitor) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(dbMutex);
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT number FROM number_list_entries WHERE list_name = ?", -1, &stmt, nullptr) != SQLITE_OK) {
+        setError("SQL准备失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, listName.c_str(), -1, SQLITE_TRANSIENT);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        visitor((const char*)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        setError("读取号码名单失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 测量短信插入耗时：每次编译语句与复用预编译语句对比
+ * @param iterations 每种方式的插入次数
+ * @return DbBenchmarkResult 测量结果
+ */
+DbBenchmarkResult DatabaseManager::benchmarkInsert(int iterations) {
+    DbBenchmarkResult result;
+    result.iterations = 0;
+    result.uncachedAvgUs = 0;
+    result.cachedAvgUs = 0;
+    result.flashStatsAvailable = false;
+    result.erasesPerInsert = 0.0f;
+    result.bytesPerInsert = 0;
+    
+    if (!isReady() || iterations <= 0) {
+        setError("数据库未就绪");
+        return result;
+    }
+    
+    // 在结构相同的独立表中测量，不影响其他任务同时写入的正式数据
+    if (!createBenchmarkTable()) {
+        return result;
+    }
+    
+    String sql = benchmarkInsertSql();
+    
+    // 每次插入都重新编译语句（缓存之前的做法）
+    bool ok = true;
+    unsigned long start = micros();
+    for (int i = 0; i < iterations && ok; i++) {
+        sqlite3_stmt* stmt = nullptr;
+        ok = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && bindBenchmarkRecord(stmt);
+        sqlite3_finalize(stmt);
+    }
+    unsigned long uncachedTotal = micros() - start;
+    
+    // 编译一次，每次插入只重置并重新绑定
+    sqlite3_stmt* cached = nullptr;
+    ok = ok && sqlite3_prepare_v2(db, sql.c_str(), -1, &cached, nullptr) == SQLITE_OK;
+    uint32_t erasesBefore = 0;
+    uint32_t bytesBefore = 0;
+    bool flashStats = readFlashCounters(rawPartition, erasesBefore, bytesBefore);
+    start = micros();
+    for (int i = 0; i < iterations && ok; i++) {
+        ok = bindBenchmarkRecord(cached);
+        sqlite3_reset(cached);
+        sqlite3_clear_bindings(cached);
+    }
+    unsigned long cachedTotal = micros() - start;
+    sqlite3_finalize(cached);
+    
+    // 每条插入单独提交，写放大即一次提交的flash开销
+    uint32_t erasesAfter = 0;
+    uint32_t bytesAfter = 0;
+    readFlashCounters(rawPartition, erasesAfter, bytesAfter);
+    
+    if (!ok) {
+        setError("测量插入失败: " + String(sqlite3_errmsg(db)));
+    } else {
+        result.iterations = iterations;
+        result.uncachedAvgUs = uncachedTotal / iterations;
+        result.cachedAvgUs = cachedTotal / iterations;
+        result.flashStatsAvailable = flashStats;
+        if (flashStats) {
+            result.erasesPerInsert = (float)(erasesAfter - erasesBefore) / iterations;
+            result.bytesPerInsert = (bytesAfter - bytesBefore) / iterations;
+        }
+        debugPrint("插入耗时 - 每次编译: " + String(result.uncachedAvgUs) + "us，预编译: " + String(result.cachedAvgUs) + "us");
+    }
+    
+    executeSQLPrivate("DROP TABLE IF EXISTS sms_records_benchmark");
+    return result;
+}
+
+/**
+ * @brief 建立插入测量用的独立表并预编译插入语句
+ * @return true 准备完成
+ * @return false 数据库未就绪或建表失败
+ */
+bool DatabaseManager::prepareInsertBenchmark() {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    finishInsertBenchmark();
+    // 先提交已打开的合并写入窗口，之后的插入才是各自独立提交
+    flushGroupCommit(true);
+    if (!createBenchmarkTable()) {
+        return false;
+    }
+    String sql = benchmarkInsertSql();
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &benchmarkStatement, nullptr) != SQLITE_OK) {
+        setError("预编译测量语句失败: " + String(sqlite3_errmsg(db)));
+        finishInsertBenchmark();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 以预编译语句向测量表插入一条样例短信
+ * @return true 插入成功
+ * @return false 插入失败或未调用prepareInsertBenchmark()
+ */
+bool DatabaseManager::insertBenchmarkRecord() {
+    if (benchmarkStatement == nullptr) {
+        return false;
+    }
+    bool ok = bindBenchmarkRecord(benchmarkStatement);
+    sqlite3_reset(benchmarkStatement);
+    sqlite3_clear_bindings(benchmarkStatement);
+    return ok;
+}
+
+/**
+ * @brief 释放插入语句并删除测量表
+ */
+void DatabaseManager::finishInsertBenchmark() {
+    if (benchmarkStatement != nullptr) {
+        sqlite3_finalize(benchmarkStatement);
+        benchmarkStatement = nullptr;
+    }
+    if (isReady()) {
+        executeSQLPrivate("DROP TABLE IF EXISTS sms_records_benchmark");
+    }
+}
+
+/**
+ * @brief 重建插入测量表（结构与sms_records相同，不含索引与触发器）
+ * @return true 建表成功
+ * @return false 建表失败
+ */
+bool DatabaseManager::createBenchmarkTable() {
+    executeSQLPrivate("DROP TABLE IF EXISTS sms_records_benchmark");
+    return executeSQLPrivate("CREATE TABLE sms_records_benchmark AS SELECT * FROM sms_records WHERE 0");
+}
+
+/**
+ * @brief 插入测量表的SQL（与DB_STMT_INSERT_SMS相同，只换表名）
+ * @return String SQL
+ */
+String DatabaseManager::benchmarkInsertSql() {
+    String sql = String(STATEMENT_SQL[DB_STMT_INSERT_SMS]);
+    sql.replace("INTO sms_records ", "INTO sms_records_benchmark ");
+    return sql;
+}
+
+/**
+ * @brief 绑定样例短信并执行插入
+ * @param stmt 插入语句
+ * @return true 插入成功
+ * @return false 插入失败
+ */
+bool DatabaseManager::bindBenchmarkRecord(sqlite3_stmt* stmt) {
+    sqlite3_bind_text(stmt, 1, "10000", -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, "", -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, "benchmark", -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, 0);
+    sqlite3_bind_int(stmt, 5, 0);
+    sqlite3_bind_text(stmt, 6, "received", -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, "", -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 8, time(nullptr));
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
 /**
  * @brief 启用调试模式
  * @param enable 是否启用
@@ -1136,46 +2306,149 @@ bool DatabaseManager::repairDatabase(const String& backupPath) {
 }
 
 /**
- * @brief 创建数据库备份
+ * @brief 创建数据库备份（一次完成）
  * @param backupPath 备份文件路径
  * @return true 备份成功
  * @return false 备份失败
  */
 bool DatabaseManager::createBackup(const String& backupPath) {
+    if (!beginBackup(backupPath)) {
+        return false;
+    }
+    while (stepBackup(-1)) {
+    }
+    return backupStatus.lastSucceeded;
+}
+
+/**
+ * @brief 开始在线备份
+ * @param backupPath 备份文件路径（为空时使用DB_BACKUP_PATH）
+ * @return true 已开始
+ * @return false 已有备份在进行或打开备份文件失败
+ */
+bool DatabaseManager::beginBackup(const String& backupPath) {
     if (!isReady()) {
         setError("数据库未就绪");
         return false;
     }
+    if (backupHandle != nullptr) {
+        setError("已有备份正在进行: " + backupStatus.path);
+        return false;
+    }
+    
+    String path = backupPath.isEmpty() ? String(DB_BACKUP_PATH) : backupPath;
+    String tempPath = path + DB_BACKUP_TEMP_SUFFIX;
+    debugPrint("开始在线备份到: " + path);
     
-    debugPrint("创建数据库备份到: " + backupPath);
+    // 备份前提交合并的写入
+    flushGroupCommit(true);
     
-    // 使用SQLite的备份API
-    sqlite3* backupDb;
-    int rc = sqlite3_open(backupPath.c_str(), &backupDb);
+    ::remove(tempPath.c_str());
+    int rc = sqlite3_open(tempPath.c_str(), &backupDb);
     if (rc != SQLITE_OK) {
         setError("无法创建备份文件: " + String(sqlite3_errmsg(backupDb)));
         sqlite3_close(backupDb);
+        backupDb = nullptr;
         return false;
     }
     
-    sqlite3_backup* backup = sqlite3_backup_init(backupDb, "main", db, "main");
-    if (backup == nullptr) {
+    backupHandle = sqlite3_backup_init(backupDb, "main", db, "main");
+    if (backupHandle == nullptr) {
         setError("初始化备份失败: " + String(sqlite3_errmsg(backupDb)));
         sqlite3_close(backupDb);
+        backupDb = nullptr;
+        ::remove(tempPath.c_str());
         return false;
     }
     
-    rc = sqlite3_backup_step(backup, -1);
-    sqlite3_backup_finish(backup);
-    sqlite3_close(backupDb);
+    backupStatus.active = true;
+    backupStatus.path = path;
+    backupStatus.totalPages = 0;
+    backupStatus.remainingPages = 0;
+    backupActive = true;
+    return true;
+}
+
+/**
+ * @brief 复制一批页面
+ * @param pages 本批最多复制的页数（-1表示全部）
+ * @return true 备份仍在进行
+ * @return false 没有进行中的备份
+ */
+bool DatabaseManager::stepBackup(int pages) {
+    if (backupHandle == nullptr) {
+        return false;
+    }
     
-    if (rc == SQLITE_DONE) {
-        debugPrint("数据库备份创建成功");
+    // 同一连接上未提交的合并写入会被当作已写入的页面复制，先提交
+    flushGroupCommit(true);
+    
+    int rc = sqlite3_backup_step(backupHandle, pages);
+    backupStatus.totalPages = sqlite3_backup_pagecount(backupHandle);
+    backupStatus.remainingPages = sqlite3_backup_remaining(backupHandle);
+    if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
         return true;
+    }
+    
+    finishBackup(rc == SQLITE_DONE, rc == SQLITE_DONE ? "" : "备份过程失败: " + String(sqlite3_errstr(rc)));
+    return false;
+}
+
+/**
+ * @brief 取消进行中的在线备份
+ */
+void DatabaseManager::cancelBackup() {
+    if (backupHandle != nullptr) {
+        finishBackup(false, "备份已取消");
+    }
+}
+
+/**
+ * @brief 是否有进行中的在线备份
+ * @return true 正在备份
+ * @return false 没有进行中的备份
+ */
+bool DatabaseManager::isBackupActive() const {
+    return backupActive;
+}
+
+/**
+ * @brief 获取在线备份进度
+ * @return DbBackupStatus 备份进度
+ */
+DbBackupStatus DatabaseManager::getBackupStatus() const {
+    return backupStatus;
+}
+
+/**
+ * @brief 结束在线备份
+ * @param succeeded 页面是否已全部复制
+ * @param error 失败原因
+ */
+void DatabaseManager::finishBackup(bool succeeded, const String& error) {
+    sqlite3_backup_finish(backupHandle);
+    backupHandle = nullptr;
+    sqlite3_close(backupDb);
+    backupDb = nullptr;
+    
+    String tempPath = backupStatus.path + DB_BACKUP_TEMP_SUFFIX;
+    String failure = error;
+    if (succeeded && ::rename(tempPath.c_str(), backupStatus.path.c_str()) != 0) {
+        succeeded = false;
+        failure = "替换备份文件失败: " + backupStatus.path;
+    }
+    if (!succeeded) {
+        ::remove(tempPath.c_str());
+        setError(failure);
     } else {
-        setError("备份过程失败: " + String(sqlite3_errstr(rc)));
-        return false;
+        debugPrint("数据库备份创建成功: " + backupStatus.path + " (" + String(backupStatus.totalPages) + " 页)");
     }
+    
+    backupStatus.active = false;
+    backupStatus.lastSucceeded = succeeded;
+    backupStatus.lastError = failure;
+    backupStatus.finishedAt = time(nullptr);
+    backupActive = false;
 }
 
 /**
@@ -1186,17 +2459,36 @@ bool DatabaseManager::createBackup(const String& backupPath) {
 bool DatabaseManager::rebuildDatabase() {
     debugPrint("开始重建数据库");
     
-    // 关闭当前数据库连接
+    // 关闭当前数据库连接（放弃未提交的合并写入）
     if (db) {
+        cancelBackup();
+        {
+            std::lock_guard<std::mutex> lock(groupMutex);
+            groupOpen = false;
+            explicitTransaction = false;
+        }
+        finalizeStatements();
         sqlite3_close(db);
         db = nullptr;
+        walEnabled = false;
     }
     
     // 删除损坏的数据库文件
-    if (LittleFS.exists(dbPath)) {
+    if (rawPartition) {
+        debugPrint("清空原始分区");
+        rawPartition = false;
+        if (!FlashVfs::getInstance().format()) {
+            setError("清空原始分区失败: " + FlashVfs::getInstance().getLastError());
+            return false;
+        }
+    } else if (LittleFS.exists(dbPath)) {
         debugPrint("删除损坏的数据库文件");
         LittleFS.remove(dbPath);
     }
+    String walPath = dbPath + "-wal";
+    if (LittleFS.exists(walPath)) {
+        LittleFS.remove(walPath);
+    }
     
     // 重新初始化数据库
     debugPrint("重新初始化数据库");
@@ -1220,8 +2512,18 @@ bool DatabaseManager::beginTransaction() {
         return false;
     }
     
+    // 先提交合并的写入，显式事务期间不再打开提交窗口
+    std::lock_guard<std::mutex> lock(groupMutex);
+    if (!commitGroupLocked()) {
+        return false;
+    }
+    
     debugPrint("开始事务");
-    return executeSQLPrivate("BEGIN TRANSACTION");
+    if (!executeSQLPrivate("BEGIN TRANSACTION")) {
+        return false;
+    }
+    explicitTransaction = true;
+    return true;
 }
 
 /**
@@ -1236,7 +2538,12 @@ bool DatabaseManager::commitTransaction() {
     }
     
     debugPrint("提交事务");
-    return executeSQLPrivate("COMMIT");
+    std::lock_guard<std::mutex> lock(groupMutex);
+    if (!executeSQLPrivate("COMMIT")) {
+        return false;
+    }
+    explicitTransaction = false;
+    return true;
 }
 
 /**
@@ -1251,9 +2558,252 @@ bool DatabaseManager::rollbackTransaction() {
     }
     
     debugPrint("回滚事务");
+    std::lock_guard<std::mutex> lock(groupMutex);
+    explicitTransaction = false;
     return executeSQLPrivate("ROLLBACK");
 }
 
+/**
+ * @brief 设置写入持久性级别
+ * @param level 持久性级别
+ */
+void DatabaseManager::setDurability(DbDurability level) {
+    // 切换前先提交已合并的写入
+    flushGroupCommit(true);
+    durability = level;
+    if (db) {
+        configureJournal();
+    }
+}
+
+/**
+ * @brief 获取写入持久性级别
+ * @return DbDurability 持久性级别
+ */
+DbDurability DatabaseManager::getDurability() const {
+    return durability;
+}
+
+/**
+ * @brief 检查是否已启用WAL日志模式
+ * @return true 已启用WAL
+ * @return false 使用DELETE日志模式
+ */
+bool DatabaseManager::isWalEnabled() const {
+    return walEnabled;
+}
+
+/**
+ * @brief 提交合并的写入
+ * @param force 是否立即提交
+ * @return true 无待提交写入或提交成功
+ * @return false 提交失败
+ */
+bool DatabaseManager::flushGroupCommit(bool force) {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    if (!groupOpen) {
+        return true;
+    }
+    if (!force && millis() - groupOpenedAt < DB_GROUP_COMMIT_INTERVAL_MS) {
+        return true;
+    }
+    return commitGroupLocked();
+}
+
+/**
+ * @brief 释放页面缓存中未使用的内存
+ * @return int 释放的字节数
+ */
+int DatabaseManager::releaseMemory() {
+    if (!isReady()) {
+        return 0;
+    }
+    int before = (int)sqlite3_memory_used();
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        sqlite3_db_release_memory(db);
+    }
+    int released = before - (int)sqlite3_memory_used();
+    debugPrint("释放页面缓存: " + String(released > 0 ? released : 0) + " 字节");
+    return released > 0 ? released : 0;
+}
+
+/**
+ * @brief 配置日志模式与同步级别
+ */
+void DatabaseManager::configureJournal() {
+    if (rawPartition) {
+        // 原始分区VFS不实现WAL，使用回滚日志（事务结束时只追加一条日志长度记录）
+        executeSQLPrivate("PRAGMA journal_mode = DELETE");
+    } else if (DB_USE_WAL && !walEnabled) {
+        // LittleFS VFS不支持共享内存，WAL需在独占锁模式下使用（本进程只有一个连接）
+        executeSQLPrivate("PRAGMA locking_mode = EXCLUSIVE");
+        // 初始化阶段isReady()尚为false，直接执行并读取实际生效的日志模式
+        std::vector<std::map<String, String>> result;
+        {
+            std::lock_guard<std::mutex> lock(dbMutex);
+            sqlite3_exec(db, "PRAGMA journal_mode = WAL", queryCallback, &result, nullptr);
+        }
+        walEnabled = !result.empty() && result[0]["journal_mode"] == "wal";
+        if (walEnabled) {
+            executeSQLPrivate("PRAGMA wal_autocheckpoint = " + String(DB_WAL_AUTOCHECKPOINT_PAGES));
+            debugPrint("已启用WAL日志模式");
+        } else {
+            debugPrint("WAL不可用，使用DELETE日志模式");
+            executeSQLPrivate("PRAGMA journal_mode = DELETE");
+            executeSQLPrivate("PRAGMA locking_mode = NORMAL");
+        }
+    } else if (!DB_USE_WAL) {
+        executeSQLPrivate("PRAGMA journal_mode = DELETE");
+    }
+    
+    switch (durability) {
+        case DB_DURABILITY_FULL:
+            executeSQLPrivate("PRAGMA synchronous = FULL");
+            break;
+        case DB_DURABILITY_RELAXED:
+            executeSQLPrivate("PRAGMA synchronous = OFF");
+            break;
+        case DB_DURABILITY_NORMAL:
+        default:
+            executeSQLPrivate("PRAGMA synchronous = NORMAL");
+            break;
+    }
+}
+
+/**
+ * @brief 挂载原始分区，分区为空且LittleFS上有数据库时迁移过去
+ * @param fullDbPath LittleFS上的数据库路径（也用作原始分区中数据库的文件名）
+ * @param dbExists 输入：LittleFS上是否有数据库；输出：原始分区中是否有数据库
+ * @return true 分区可用
+ * @return false 挂载或迁移失败
+ */
+bool DatabaseManager::prepareRawPartition(const String& fullDbPath, bool& dbExists) {
+    FlashVfs& flashVfs = FlashVfs::getInstance();
+    flashVfs.setDebugMode(debugMode);
+    if (!flashVfs.initialize(DB_RAW_PARTITION_LABEL)) {
+        setError("原始分区不可用: " + flashVfs.getLastError());
+        return false;
+    }
+    
+    if (!flashVfs.hasDatabase() && dbExists) {
+        // 清除上次中断的迁移可能留下的日志，迁移写入的大小只在完成时记录
+        if (!flashVfs.format() || !migrateToRawPartition(fullDbPath)) {
+            // 清除复制了一半的内容，下次启动重新迁移；LittleFS上的数据库保持不变
+            flashVfs.format();
+            return false;
+        }
+    }
+    dbExists = flashVfs.hasDatabase();
+    return true;
+}
+
+/**
+ * @brief 把LittleFS上的数据库以VACUUM INTO复制到原始分区，成功后原文件改名保留
+ *
+ * 目标数据库的页面大小固定为扇区大小：旧数据库可能使用1024字节页面，
+ * 按原样复制时擦除一个扇区会连带改写同扇区的其他页面
+ * @param fullDbPath LittleFS上的数据库路径
+ * @return true 迁移成功
+ * @return false 迁移失败
+ */
+bool DatabaseManager::migrateToRawPartition(const String& fullDbPath) {
+    debugPrint("开始迁移数据库到原始分区: " + fullDbPath);
+    unsigned long startTime = millis();
+    
+    sqlite3* source = nullptr;
+    // 以URI方式打开，VACUUM INTO的目标才能通过vfs参数指定原始分区
+    bool ok = sqlite3_open_v2(fullDbPath.c_str(), &source, SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI,
+                              nullptr) == SQLITE_OK;
+    if (ok) {
+        // 原数据库可能处于WAL模式：独占锁下才能在LittleFS上读取WAL，切回DELETE时合并WAL内容
+        sqlite3_exec(source, "PRAGMA locking_mode = EXCLUSIVE", nullptr, nullptr, nullptr);
+        sqlite3_exec(source, "PRAGMA journal_mode = DELETE", nullptr, nullptr, nullptr);
+        // 在线备份会沿用源数据库的页面大小，VACUUM INTO则按此设置重建页面
+        String pageSizeSql = "PRAGMA page_size = " + String(DB_RAW_SECTOR_SIZE);
+        sqlite3_exec(source, pageSizeSql.c_str(), nullptr, nullptr, nullptr);
+        String targetUri = "file:" + fullDbPath + "?vfs=" DB_RAW_VFS_NAME;
+        char* sql = sqlite3_mprintf("VACUUM INTO %Q", targetUri.c_str());
+        ok = sql != nullptr && sqlite3_exec(source, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+        sqlite3_free(sql);
+    }
+    if (!ok) {
+        setError("迁移数据库失败: " + String(sqlite3_errmsg(source)));
+    }
+    sqlite3_close(source);
+    if (!ok) {
+        return false;
+    }
+    
+    // 原文件改名保留，既不会再次迁移，需要时也可以改回原名恢复LittleFS存储
+    String littleFSPath = fullDbPath.substring(9);
+    fs::FS& fs = FilesystemManager::getInstance().getFS();
+    fs.remove(littleFSPath + DB_RAW_MIGRATED_SUFFIX);
+    if (!fs.rename(littleFSPath, littleFSPath + DB_RAW_MIGRATED_SUFFIX)) {
+        debugPrint("原数据库改名失败，下次启动不会重复迁移（原始分区已有数据库）");
+    }
+    fs.remove(littleFSPath + "-wal");
+    
+    debugPrint("迁移完成: " + String((unsigned long)FlashVfs::getInstance().getDatabaseSize()) + " 字节，耗时 " +
+               String(millis() - startTime) + "ms");
+    return true;
+}
+
+/**
+ * @brief 写入前加入提交窗口
+ */
+void DatabaseManager::joinGroupCommit() {
+    lastWriteAt = millis();
+    if (durability == DB_DURABILITY_FULL) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(groupMutex);
+    if (explicitTransaction) {
+        // 写入随显式事务一起提交
+        return;
+    }
+    if (groupOpen && groupWrites >= DB_GROUP_COMMIT_MAX_WRITES) {
+        commitGroupLocked();
+    }
+    if (!groupOpen) {
+        if (sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            // 无法开始事务时退回为独立提交
+            return;
+        }
+        groupOpen = true;
+        groupOpenedAt = millis();
+        groupWrites = 0;
+    }
+    groupWrites++;
+}
+
+/**
+ * @brief 提交当前提交窗口
+ * @return true 提交成功或没有打开的窗口
+ * @return false 提交失败
+ */
+bool DatabaseManager::commitGroupLocked() {
+    if (!groupOpen) {
+        return true;
+    }
+    // 语句出错时SQLite可能已自动回滚事务
+    if (db == nullptr || sqlite3_get_autocommit(db)) {
+        groupOpen = false;
+        return true;
+    }
+    
+    int rc = sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+    if (rc != SQLITE_OK) {
+        setError("合并提交失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    debugPrint("合并提交 " + String(groupWrites) + " 次写入");
+    groupOpen = false;
+    groupWrites = 0;
+    return true;
+}
+
 /**
  * @brief 在事务中删除转发规则（带回滚保护）
  * @param ruleId 规则ID
@@ -1363,7 +2913,8 @@ bool DatabaseManager::createTables() {
         "enabled INTEGER DEFAULT 1,"
         "is_default_forward INTEGER DEFAULT 0,"
         "created_at TEXT DEFAULT CURRENT_TIMESTAMP,"
-        "updated_at TEXT DEFAULT CURRENT_TIMESTAMP"
+        "updated_at TEXT DEFAULT CURRENT_TIMESTAMP,"
+        "priority INTEGER DEFAULT " + String(FORWARD_RULE_DEFAULT_PRIORITY) +
         ")";
     
     if (!executeSQLPrivate(createForwardRulesTable)) {
@@ -1371,6 +2922,14 @@ bool DatabaseManager::createTables() {
         return false;
     }
     
+    // 旧版本的规则表没有priority列，补上后已有规则取默认优先级
+    int priorityColumns = 0;
+    if (queryInt("SELECT COUNT(*) FROM pragma_table_info('forward_rules') WHERE name = 'priority'", priorityColumns) &&
+        priorityColumns == 0) {
+        executeSQLPrivate("ALTER TABLE forward_rules ADD COLUMN priority INTEGER DEFAULT " +
+                          String(FORWARD_RULE_DEFAULT_PRIORITY));
+    }
+    
     // 创建短信记录表
     String createSMSRecordsTable = 
         "CREATE TABLE IF NOT EXISTS sms_records ("
@@ -1390,16 +2949,145 @@ bool DatabaseManager::createTables() {
         return false;
     }
     
+    // 创建短信计数表，由触发器随插入与删除维护，getSMSRecordCount()无需COUNT(*)扫描
+    if (!executeSQLPrivate("CREATE TABLE IF NOT EXISTS sms_stats ("
+                           "id INTEGER PRIMARY KEY CHECK (id = 1),"
+                           "record_count INTEGER NOT NULL"
+                           ")")) {
+        setError("创建短信计数表失败");
+        return false;
+    }
+    // 计数行不存在时（新库或旧版本升级）按现有记录初始化一次
+    executeSQLPrivate("INSERT INTO sms_stats (id, record_count) "
+                      "SELECT 1, COUNT(*) FROM sms_records WHERE NOT EXISTS (SELECT 1 FROM sms_stats)");
+    executeSQLPrivate("CREATE TRIGGER IF NOT EXISTS trg_sms_records_count_insert AFTER INSERT ON sms_records "
+                      "BEGIN UPDATE sms_stats SET record_count = record_count + 1 WHERE id = 1; END");
+    executeSQLPrivate("CREATE TRIGGER IF NOT EXISTS trg_sms_records_count_delete AFTER DELETE ON sms_records "
+                      "BEGIN UPDATE sms_stats SET record_count = record_count - 1 WHERE id = 1; END");
+    
+    // 创建推送发件箱表（保存待重试的推送，保证至少一次投递）
+    String createPushOutboxTable = 
+        "CREATE TABLE IF NOT EXISTS push_outbox ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "sms_id INTEGER NOT NULL REFERENCES sms_records(id) ON DELETE CASCADE,"
+        "rule_id INTEGER NOT NULL,"
+        "attempt INTEGER DEFAULT 0,"
+        "next_attempt_at INTEGER NOT NULL,"
+        "last_error TEXT DEFAULT '',"
+        "created_at INTEGER NOT NULL,"
+        "follower_rule_ids TEXT DEFAULT ''"
+        ")";
+    
+    if (!executeSQLPrivate(createPushOutboxTable)) {
+        setError("创建推送发件箱表失败");
+        return false;
+    }
+    
+    // 旧版本的发件箱表没有follower_rule_ids列，已有条目视为没有同目标规则
+    int followerColumns = 0;
+    if (queryInt("SELECT COUNT(*) FROM pragma_table_info('push_outbox') WHERE name = 'follower_rule_ids'", followerColumns) &&
+        followerColumns == 0) {
+        executeSQLPrivate("ALTER TABLE push_outbox ADD COLUMN follower_rule_ids TEXT DEFAULT ''");
+    }
+    
+    // 创建来信指纹表（保存最近收到的短信指纹，重启后仍能识别网络重传的短信）
+    String createSmsFingerprintsTable = 
+        "CREATE TABLE IF NOT EXISTS sms_fingerprints ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "fingerprint INTEGER NOT NULL,"
+        "created_at INTEGER NOT NULL"
+        ")";
+    
+    if (!executeSQLPrivate(createSmsFingerprintsTable)) {
+        setError("创建来信指纹表失败");
+        return false;
+    }
+    
+    // 创建短信链路追踪表（每条短信一行，随短信记录一起删除）
+    String createSmsTracesTable = 
+        "CREATE TABLE IF NOT EXISTS sms_traces ("
+        "sms_id INTEGER PRIMARY KEY REFERENCES sms_records(id) ON DELETE CASCADE,"
+        "trace TEXT NOT NULL"
+        ")";
+    
+    if (!executeSQLPrivate(createSmsTracesTable)) {
+        setError("创建短信链路追踪表失败");
+        return false;
+    }
+    
+    // 创建号码名单表（规范化号码，名单规则加载为内存中的哈希集合；主键即按名单读取的索引）
+    String createNumberListTable = 
+        "CREATE TABLE IF NOT EXISTS number_list_entries ("
+        "list_name TEXT NOT NULL,"
+        "number TEXT NOT NULL,"
+        "created_at INTEGER NOT NULL,"
+        "PRIMARY KEY (list_name, number)"
+        ") WITHOUT ROWID";
+    
+    if (!executeSQLPrivate(createNumberListTable)) {
+        setError("创建号码名单表失败");
+        return false;
+    }
+    
     // 创建索引
+    executeSQLPrivate("CREATE INDEX IF NOT EXISTS idx_push_outbox_next_attempt ON push_outbox(next_attempt_at)");
     executeSQLPrivate("CREATE INDEX IF NOT EXISTS idx_forward_rules_enabled ON forward_rules(enabled)");
     executeSQLPrivate("CREATE INDEX IF NOT EXISTS idx_sms_records_from_number ON sms_records(from_number)");
-    executeSQLPrivate("CREATE INDEX IF NOT EXISTS idx_sms_records_content ON sms_records(content)");
+    // 内容的B树索引无法用于子串搜索，由全文索引取代
+    executeSQLPrivate("DROP INDEX IF EXISTS idx_sms_records_content");
+    // 索引项为(received_at, rowid)，覆盖游标分页的定位条件与排序
     executeSQLPrivate("CREATE INDEX IF NOT EXISTS idx_sms_records_received_at ON sms_records(received_at)");
     
+    // 全文索引失败不影响基本功能，搜索退回表扫描
+    createSearchIndex();
+    
     debugPrint("数据库表创建完成");
     return true;
 }
 
+/**
+ * @brief 创建短信全文索引及同步触发器
+ * @return true 创建成功
+ * @return false 创建失败
+ */
+bool DatabaseManager::createSearchIndex() {
+    // 检查索引是否已存在：新建时需要为现有记录建立索引
+    std::vector<std::map<String, String>> existing;
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        sqlite3_exec(db, "SELECT name FROM sqlite_master WHERE type='table' AND name='sms_fts'",
+                     queryCallback, &existing, nullptr);
+    }
+    
+    // 外部内容表：只保存索引，不重复存储短信内容；trigram分词支持中文与验证码等子串匹配
+    if (!executeSQLPrivate("CREATE VIRTUAL TABLE IF NOT EXISTS sms_fts USING fts5("
+                           "content, from_number, content='sms_records', content_rowid='id', tokenize='trigram')")) {
+        debugPrint("创建全文索引失败，搜索将使用表扫描");
+        ftsEnabled = false;
+        return false;
+    }
+    
+    executeSQLPrivate("CREATE TRIGGER IF NOT EXISTS trg_sms_fts_insert AFTER INSERT ON sms_records BEGIN "
+                      "INSERT INTO sms_fts (rowid, content, from_number) VALUES (new.id, new.content, new.from_number); END");
+    executeSQLPrivate("CREATE TRIGGER IF NOT EXISTS trg_sms_fts_delete AFTER DELETE ON sms_records BEGIN "
+                      "INSERT INTO sms_fts (sms_fts, rowid, content, from_number) "
+                      "VALUES ('delete', old.id, old.content, old.from_number); END");
+    // updateSMSRecord()每次都会写全部列，仅在内容或号码实际变化时更新索引
+    executeSQLPrivate("CREATE TRIGGER IF NOT EXISTS trg_sms_fts_update AFTER UPDATE OF content, from_number ON sms_records "
+                      "WHEN old.content IS NOT new.content OR old.from_number IS NOT new.from_number BEGIN "
+                      "INSERT INTO sms_fts (sms_fts, rowid, content, from_number) "
+                      "VALUES ('delete', old.id, old.content, old.from_number); "
+                      "INSERT INTO sms_fts (rowid, content, from_number) VALUES (new.id, new.content, new.from_number); END");
+    
+    if (existing.empty()) {
+        debugPrint("为现有短信记录建立全文索引");
+        executeSQLPrivate("INSERT INTO sms_fts (sms_fts) VALUES ('rebuild')");
+    }
+    
+    ftsEnabled = true;
+    return true;
+}
+
 /**
  * @brief 初始化默认数据
  * @return true 初始化成功
@@ -1618,6 +3306,68 @@ std::vector<std::map<String, String>> DatabaseManager::executeQuery(const String
     return results;
 }
 
+/**
+ * @brief 执行查询并逐行回调
+ * @param sql SQL查询语句
+ * @param visitor 行访问回调
+ * @return true 执行成功
+ * @return false 执行失败
+ */
+bool DatabaseManager::forEachRow(const String& sql, const RowVisitor& visitor) {
+    if (!isReady()) {
+        setError("数据库未就绪");
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(dbMutex);
+    
+    if (!db) {
+        setError("数据库连接无效");
+        return false;
+    }
+    
+    debugPrint("执行查询: " + sql);
+    
+    sqlite3_stmt* stmt;
+    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        setError("SQL准备失败: " + String(sqlite3_errmsg(db)));
+        return false;
+    }
+    
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!visitor(stmt)) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+    
+    bool success = rc == SQLITE_DONE;
+    if (!success) {
+        setError("查询执行失败: " + String(sqlite3_errmsg(db)));
+    }
+    
+    sqlite3_finalize(stmt);
+    return success;
+}
+
+/**
+ * @brief 执行返回单个整数的查询
+ * @param sql SQL查询语句
+ * @param value 输出：第一行第一列的值
+ * @return true 查询到结果
+ * @return false 执行失败或无结果
+ */
+bool DatabaseManager::queryInt(const String& sql, int& value) {
+    bool found = false;
+    bool ok = forEachRow(sql, [&](sqlite3_stmt* stmt) {
+        value = sqlite3_column_int(stmt, 0);
+        found = true;
+        return false;
+    });
+    return ok && found;
+}
+
 /**
  * @brief 执行查询SQL语句
  * @param sql SQL语句
@@ -1651,6 +3401,71 @@ bool DatabaseManager::executeQuery(const String& sql, int (*callback)(void*, int
     return true;
 }
 
+/**
+ * @brief 预编译所有缓存语句
+ * @return true 全部编译成功
+ * @return false 部分语句编译失败（使用时再次尝试）
+ */
+bool DatabaseManager::prepareStatements() {
+    bool allPrepared = true;
+    for (int i = 0; i < DB_STMT_COUNT; i++) {
+        std::lock_guard<std::mutex> lock(statementLocks[i]);
+        if (statements[i] != nullptr) {
+            continue;
+        }
+        if (sqlite3_prepare_v2(db, STATEMENT_SQL[i], -1, &statements[i], nullptr) != SQLITE_OK) {
+            debugPrint("预编译语句 " + String(i) + " 失败: " + String(sqlite3_errmsg(db)));
+            statements[i] = nullptr;
+            allPrepared = false;
+        }
+    }
+    return allPrepared;
+}
+
+/**
+ * @brief 释放所有缓存语句（关闭数据库连接前调用）
+ */
+void DatabaseManager::finalizeStatements() {
+    for (int i = 0; i < DB_STMT_COUNT; i++) {
+        std::lock_guard<std::mutex> lock(statementLocks[i]);
+        if (statements[i] != nullptr) {
+            sqlite3_finalize(statements[i]);
+            statements[i] = nullptr;
+        }
+    }
+    if (benchmarkStatement != nullptr) {
+        sqlite3_finalize(benchmarkStatement);
+        benchmarkStatement = nullptr;
+    }
+}
+
+/**
+ * @brief 取得缓存语句并独占使用
+ * @param manager 数据库管理器
+ * @param id 语句
+ */
+DatabaseManager::CachedStatement::CachedStatement(DatabaseManager& manager, DbStatement id)
+    : lock(manager.statementLocks[id]), stmt(manager.statements[id]) {
+    // 初始化时编译失败的语句在此重试
+    if (stmt == nullptr && manager.db != nullptr) {
+        if (sqlite3_prepare_v2(manager.db, STATEMENT_SQL[id], -1, &stmt, nullptr) != SQLITE_OK) {
+            manager.setError("准备SQL语句失败: " + String(sqlite3_errmsg(manager.db)));
+            stmt = nullptr;
+        }
+        manager.statements[id] = stmt;
+    }
+}
+
+/**
+ * @brief 重置语句并清除绑定，供下次使用
+ */
+DatabaseManager::CachedStatement::~CachedStatement() {
+    if (stmt != nullptr) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+}
+
 /**
  * @brief 设置错误信息
  * @param error 错误信息
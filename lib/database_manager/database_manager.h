@@ -19,6 +19,10 @@
 #include <vector>
 #include <map>
 #include <mutex>
+#include <functional>
+#include <atomic>
+#include "../../include/constants.h"
+#include "row_decoder.h"
 
 /**
  * @enum DatabaseStatus
@@ -60,6 +64,7 @@ struct ForwardRule {
     String pushConfig;     ///< 推送配置为json格式，支持配置模板
     bool enabled;          ///< 是否使用
     bool isDefaultForward; ///< 是否默认转发（忽略关键词匹配）
+    int priority = FORWARD_RULE_DEFAULT_PRIORITY; ///< 优先级（0-1000，数字越小越先推送）
     String createdAt;      ///< 创建时间
     String updatedAt;      ///< 修改时间
 };
@@ -80,6 +85,104 @@ struct SMSRecord {
     time_t receivedAt;     ///< 接收时间，time保存，支持索引，方便以后按照时间过滤短信
 };
 
+/**
+ * @struct PushOutboxEntry
+ * @brief 推送发件箱条目结构体（待重试的推送）
+ */
+struct PushOutboxEntry {
+    int id;                ///< 条目ID
+    int smsId;             ///< 关联的短信记录ID
+    int ruleId;            ///< 关联的转发规则ID
+    int attempt;           ///< 已失败的尝试次数
+    time_t nextAttemptAt;  ///< 下次尝试时间（Unix时间戳）
+    String lastError;      ///< 最后一次失败的错误信息
+    time_t createdAt;      ///< 创建时间（Unix时间戳）
+    String followerRuleIds; ///< 推送目标相同、复用本条目结果的规则ID（逗号分隔，空表示没有）
+};
+
+/**
+ * @struct DbBackupStatus
+ * @brief 在线备份进度
+ */
+struct DbBackupStatus {
+    bool active;            ///< 是否正在备份
+    String path;            ///< 备份文件路径
+    int totalPages;         ///< 源数据库总页数
+    int remainingPages;     ///< 尚未复制的页数
+    bool lastSucceeded;     ///< 最近一次备份是否成功
+    String lastError;       ///< 最近一次备份的失败原因
+    time_t finishedAt;      ///< 最近一次备份的完成时间（0表示尚未完成过）
+};
+
+/**
+ * @struct NumberListSummary
+ * @brief 号码名单摘要
+ */
+struct NumberListSummary {
+    String name;           ///< 名单名
+    int count;             ///< 号码数量
+};
+
+/**
+ * @enum DbStatement
+ * @brief 缓存的固定查询语句（初始化时预编译，使用时重置并重新绑定参数）
+ */
+enum DbStatement {
+    DB_STMT_INSERT_SMS,             ///< 插入短信记录
+    DB_STMT_UPDATE_SMS,             ///< 更新短信记录
+    DB_STMT_GET_SMS_BY_ID,          ///< 按ID查询短信记录
+    DB_STMT_GET_SMS_PAGE,           ///< 分页查询短信记录
+    DB_STMT_GET_SMS_LATEST,         ///< 游标分页：最新一页
+    DB_STMT_GET_SMS_BEFORE,         ///< 游标分页：游标之前的一页
+    DB_STMT_GET_SMS_AFTER_ID,       ///< 增量导出：ID大于水位的一批记录
+    DB_STMT_SEARCH_SMS,             ///< 全文索引搜索短信
+    DB_STMT_SEARCH_SMS_SCAN,        ///< 表扫描搜索短信（全文索引不可用或搜索词过短）
+    DB_STMT_SCAN_SMS_BEFORE_ID,     ///< 规则回测：ID小于游标的一批短信（只取匹配所需的列）
+    DB_STMT_SCAN_SMS_MATCH_BEFORE_ID, ///< 规则回测：全文索引命中且ID小于游标的一批短信
+    DB_STMT_DELETE_OLDEST_SMS,      ///< 按rowid删除最旧的一批短信
+    DB_STMT_DELETE_SMS_BEFORE,      ///< 按接收时间删除一批过期短信
+    DB_STMT_COUNT_SMS,              ///< 短信记录总数
+    DB_STMT_GET_RULE_BY_ID,         ///< 按ID查询转发规则
+    DB_STMT_GET_RULES,              ///< 按条件查询转发规则
+    DB_STMT_COUNT_RULES,            ///< 转发规则总数
+    DB_STMT_COUNT_ENABLED_RULES,    ///< 启用的转发规则数
+    DB_STMT_INSERT_OUTBOX,          ///< 插入发件箱条目
+    DB_STMT_UPDATE_OUTBOX,          ///< 更新发件箱条目
+    DB_STMT_DELETE_OUTBOX,          ///< 删除发件箱条目
+    DB_STMT_GET_OUTBOX_BY_ID,       ///< 按ID查询发件箱条目
+    DB_STMT_GET_DUE_OUTBOX,         ///< 查询到期的发件箱条目
+    DB_STMT_COUNT_OUTBOX,           ///< 发件箱条目总数
+    DB_STMT_INSERT_SMS_FINGERPRINT, ///< 插入来信指纹
+    DB_STMT_TRIM_SMS_FINGERPRINTS,  ///< 删除超出保留条数的旧指纹
+    DB_STMT_GET_SMS_FINGERPRINTS,   ///< 查询最近的来信指纹
+    DB_STMT_SAVE_SMS_TRACE,         ///< 保存短信链路追踪
+    DB_STMT_GET_SMS_TRACE,          ///< 查询短信链路追踪
+    DB_STMT_COUNT                   ///< 语句数量
+};
+
+/**
+ * @enum DbDurability
+ * @brief 写入持久性级别
+ */
+enum DbDurability {
+    DB_DURABILITY_FULL,             ///< 每次写入独立提交并同步（不合并提交）
+    DB_DURABILITY_NORMAL,           ///< 合并提交，WAL下synchronous=NORMAL（掉电最多丢失一个提交窗口）
+    DB_DURABILITY_RELAXED           ///< 合并提交，synchronous=OFF（写入最少，掉电可能丢失最近的提交）
+};
+
+/**
+ * @struct DbBenchmarkResult
+ * @brief 插入耗时测量结果
+ */
+struct DbBenchmarkResult {
+    int iterations;                 ///< 每种方式的插入次数
+    unsigned long uncachedAvgUs;    ///< 每次编译语句的平均耗时（微秒）
+    unsigned long cachedAvgUs;      ///< 复用预编译语句的平均耗时（微秒）
+    bool flashStatsAvailable;       ///< 是否统计了flash写入（原始分区，或启用了CONFIG_SPI_FLASH_ENABLE_COUNTERS）
+    float erasesPerInsert;          ///< 预编译插入平均每条擦除的扇区数
+    unsigned long bytesPerInsert;   ///< 预编译插入平均每条写入flash的字节数
+};
+
 /**
  * @struct DatabaseInfo
  * @brief 数据库信息结构体
@@ -91,7 +194,27 @@ struct DatabaseInfo {
     int recordCount;       ///< 总记录数
     String version;        ///< 数据库版本
     bool isOpen;           ///< 数据库是否打开
+    bool rawPartition;     ///< 是否存放在原始分区（否则为LittleFS文件）
     String lastModified;   ///< 最后修改时间
+    int pageSize;          ///< 实际页面大小（字节）
+    int cacheSizePages;    ///< 页面缓存容量（页）
+    bool psramPageCache;   ///< 页面缓存是否位于PSRAM
+    bool psramHeap;        ///< SQLite堆是否位于PSRAM
+    int cacheHits;         ///< 页面缓存命中次数
+    int cacheMisses;       ///< 页面缓存未命中次数
+    float cacheHitRatio;   ///< 页面缓存命中率（0-1）
+};
+
+/**
+ * @struct DbStorageProfile
+ * @brief 存储配置：页面布局与SQLite内存位置
+ */
+struct DbStorageProfile {
+    int pageSize;               ///< 新建数据库的页面大小（字节，应与LittleFS块大小一致）
+    int cacheSizePages;         ///< 页面缓存容量（页）
+    int psramPageCachePages;    ///< PSRAM中预分配的页面缓存槽数，0表示不使用
+    size_t psramHeapBytes;      ///< PSRAM中SQLite堆的大小，0表示使用系统malloc
+    size_t mmapSize;            ///< mmap_size（LittleFS VFS不支持内存映射，通常为0）
 };
 
 /**
@@ -124,6 +247,21 @@ public:
      */
     bool close();
 
+    /**
+     * @brief 设置存储配置（须在首次initialize()之前调用）
+     * 
+     * PSRAM页面缓存与堆通过sqlite3_config()设置，SQLite初始化后不能再更改；
+     * 页面大小只对新建的数据库生效
+     * @param profile 存储配置
+     */
+    void setStorageProfile(const DbStorageProfile& profile);
+
+    /**
+     * @brief 获取默认存储配置（由constants.h中的DB_*常量组成）
+     * @return DbStorageProfile 默认存储配置
+     */
+    static DbStorageProfile getDefaultStorageProfile();
+
     /**
      * @brief 检查数据库是否就绪
      * @return true 数据库就绪
@@ -204,6 +342,18 @@ public:
      */
     ForwardRule getForwardRuleById(int ruleId);
 
+    /**
+     * @brief 按条件查询转发规则（过滤、排序与分页在SQL中完成）
+     * @param enabledFilter 启用状态过滤：1只查启用，0只查禁用，-1不过滤
+     * @param pushType 推送类型过滤，为空时不过滤
+     * @param limit 限制数量，小于等于0时不限制
+     * @param offset 偏移量
+     * @param orderByPriority 是否先按优先级排序（否则只按ID升序）
+     * @return std::vector<ForwardRule> 转发规则列表
+     */
+    std::vector<ForwardRule> getForwardRules(int enabledFilter, const String& pushType, int limit = -1, int offset = 0,
+                                             bool orderByPriority = false);
+
     /**
      * @brief 获取转发规则总数
      * @return int 规则总数
@@ -248,7 +398,69 @@ public:
     SMSRecord getSMSRecordById(int recordId);
 
     /**
-     * @brief 获取短信记录总数
+     * @brief 按游标获取短信记录（按接收时间、ID倒序）
+     * 
+     * 游标为上一页最后一条记录的(receivedAt, id)，查询沿索引定位，
+     * 代价只与limit有关，与翻页深度无关
+     * @param beforeTs 游标接收时间
+     * @param beforeId 游标记录ID，小于等于0时返回最新一页
+     * @param limit 限制数量
+     * @return std::vector<SMSRecord> 短信记录列表
+     */
+    std::vector<SMSRecord> getSMSRecordsBefore(time_t beforeTs, int beforeId, int limit);
+
+    /**
+     * @brief 获取ID大于水位的短信记录（按ID正序，用于增量导出）
+     * 
+     * 调用方以上一批最后一条记录的ID作为下次的水位，只取新增记录；按主键定位，代价只与limit有关
+     * @param afterId 水位ID（不含）
+     * @param limit 限制数量
+     * @return std::vector<SMSRecord> 短信记录列表
+     */
+    std::vector<SMSRecord> getSMSRecordsAfterId(int afterId, int limit);
+
+    /**
+     * @brief 搜索短信内容与发送方号码（子串匹配）
+     * 
+     * 搜索词不少于SMS_SEARCH_MIN_INDEXED_CHARS个字符时使用全文索引，否则退回表扫描
+     * @param query 搜索词
+     * @param limit 限制数量
+     * @return std::vector<SMSRecord> 匹配的短信记录（最新的在前）
+     */
+    std::vector<SMSRecord> searchSMS(const String& query, int limit = DEFAULT_QUERY_LIMIT);
+
+    /**
+     * @brief 短信行回调（指针在回调返回后失效）
+     * @param id 记录ID
+     * @param fromNumber 发送方号码
+     * @param content 短信内容
+     * @param receivedAt 接收时间
+     */
+    typedef std::function<void(int id, const char* fromNumber, const char* content, time_t receivedAt)> SmsRowVisitor;
+
+    /**
+     * @brief 按ID倒序读取一批ID小于游标的短信并逐行回调（用于规则回测）
+     * 
+     * 只读取规则匹配需要的列，直接把SQLite的列指针交给回调，不构造SMSRecord；
+     * matchQuery非空且全文索引可用时只读取全文索引命中的记录
+     * @param beforeId 游标ID（不含），小于等于0时从最新的记录开始
+     * @param matchQuery FTS5查询表达式，空字符串表示不预筛选
+     * @param limit 本批最多读取的记录数
+     * @param visitor 行回调
+     * @param lastId 输出：本批最后一条记录的ID（下一批的游标）
+     * @return int 本批读取的记录数，失败返回-1
+     */
+    int scanSMSBatch(int beforeId, const String& matchQuery, int limit, const SmsRowVisitor& visitor, int& lastId);
+
+    /**
+     * @brief 全文索引是否可用
+     * @return true 可用
+     * @return false 不可用（搜索与回测退回表扫描）
+     */
+    bool isSearchIndexEnabled() const;
+
+    /**
+     * @brief 获取短信记录总数（读取由触发器维护的计数，不扫描表）
      * @return int 短信记录总数
      */
     int getSMSRecordCount();
@@ -275,6 +487,138 @@ public:
      */
     int checkAndCleanupSMSRecords(int maxCount = 10000, int keepCount = 8000);
 
+    /**
+     * @brief 执行一次后台保留清理（由定时任务调用）
+     * 
+     * 记录数超过MAX_SMS_RECORDS_COUNT后按rowid分批删除最旧的记录直到SMS_CLEANUP_KEEP_COUNT，
+     * 并删除超过DEFAULT_SMS_RETENTION_DAYS的记录；每批SMS_BATCH_SIZE条，用完时间预算即返回。
+     * 无待清理记录且空闲超过DB_VACUUM_IDLE_MS时回收空闲页
+     * @param budgetMs 本次最多占用的时间（毫秒）
+     * @return int 删除的记录数
+     */
+    int runRetentionStep(unsigned long budgetMs = DB_RETENTION_BUDGET_MS);
+
+    /**
+     * @brief 回收空闲页（PRAGMA incremental_vacuum）
+     * @param maxPages 最多回收的页数
+     * @return int 回收的页数
+     */
+    int reclaimFreePages(int maxPages);
+
+    /**
+     * @brief 添加推送发件箱条目
+     * @param entry 发件箱条目
+     * @return int 条目ID，-1表示失败
+     */
+    int addPushOutboxEntry(const PushOutboxEntry& entry);
+
+    /**
+     * @brief 更新推送发件箱条目（尝试次数、下次尝试时间、错误信息）
+     * @param entry 发件箱条目
+     * @return true 更新成功
+     * @return false 更新失败
+     */
+    bool updatePushOutboxEntry(const PushOutboxEntry& entry);
+
+    /**
+     * @brief 删除推送发件箱条目
+     * @param entryId 条目ID
+     * @return true 删除成功
+     * @return false 删除失败
+     */
+    bool deletePushOutboxEntry(int entryId);
+
+    /**
+     * @brief 根据ID获取推送发件箱条目
+     * @param entryId 条目ID
+     * @return PushOutboxEntry 发件箱条目，id为-1表示未找到
+     */
+    PushOutboxEntry getPushOutboxEntryById(int entryId);
+
+    /**
+     * @brief 获取到期的推送发件箱条目
+     * @param now 当前时间
+     * @param horizon 最大退避时长，next_attempt_at超过now+horizon的条目视为时钟回拨，同样返回
+     * @param limit 最大返回数量
+     * @return std::vector<PushOutboxEntry> 到期条目列表（按下次尝试时间升序）
+     */
+    std::vector<PushOutboxEntry> getDuePushOutboxEntries(time_t now, time_t horizon, int limit = 10);
+
+    /**
+     * @brief 获取推送发件箱条目数量
+     * @return int 条目数量
+     */
+    int getPushOutboxCount();
+
+    /**
+     * @brief 记录一条来信指纹（用于重传去重，随合并提交写入）
+     *
+     * 只保留最近SMS_DEDUP_PERSISTED_ENTRIES条，插入时顺带删除更早的指纹
+     * @param fingerprint 指纹
+     * @return true 记录成功
+     * @return false 记录失败
+     */
+    bool addSmsFingerprint(uint32_t fingerprint);
+
+    /**
+     * @brief 获取最近记录的来信指纹
+     * @param limit 最大返回数量
+     * @return std::vector<uint32_t> 指纹列表（从旧到新）
+     */
+    std::vector<uint32_t> getRecentSmsFingerprints(int limit);
+
+    /**
+     * @brief 保存短信的链路追踪（随合并提交写入，随短信记录一起删除）
+     * @param smsId 短信记录ID
+     * @param trace 追踪文本（SmsTrace::serialize()）
+     * @return true 保存成功
+     * @return false 保存失败
+     */
+    bool saveSmsTrace(int smsId, const String& trace);
+
+    /**
+     * @brief 获取短信的链路追踪
+     * @param smsId 短信记录ID
+     * @param trace 输出：追踪文本
+     * @return true 找到追踪
+     * @return false 没有追踪或查询失败
+     */
+    bool getSmsTrace(int smsId, String& trace);
+
+    /**
+     * @brief 批量导入号码名单（单个事务，已存在的号码忽略）
+     * @param listName 名单名
+     * @param numbers 已规范化的号码，以'\n'分隔
+     * @param replace 是否先清空该名单
+     * @return int 新增的号码数，-1表示导入失败（已回滚）
+     */
+    int importNumberList(const String& listName, const char* numbers, bool replace);
+
+    /**
+     * @brief 删除整个号码名单
+     * @param listName 名单名
+     * @return true 删除成功
+     * @return false 删除失败
+     */
+    bool deleteNumberList(const String& listName);
+
+    /**
+     * @brief 获取所有号码名单及其号码数量
+     * @return std::vector<NumberListSummary> 名单摘要（按名单名排序）
+     */
+    std::vector<NumberListSummary> getNumberListSummaries();
+
+    /**
+     * @brief 逐个读取名单中的号码
+     *
+     * 回调在持有数据库锁时执行，不得再调用DatabaseManager的其他接口
+     * @param listName 名单名
+     * @param visitor 号码回调
+     * @return true 读取成功
+     * @return false 读取失败
+     */
+    bool forEachNumberListEntry(const String& listName, const std::function<void(const char* number)>& visitor);
+
     /**
      * @brief 启用调试模式
      * @param enable 是否启用
@@ -297,13 +641,51 @@ public:
     bool repairDatabase(const String& backupPath = "");
     
     /**
-     * @brief 创建数据库备份
+     * @brief 创建数据库备份（一次完成，修复数据库前使用；运行中请使用beginBackup()）
      * @param backupPath 备份文件路径
      * @return true 备份成功
      * @return false 备份失败
      */
     bool createBackup(const String& backupPath);
     
+    /**
+     * @brief 开始在线备份
+     * 
+     * 只打开备份文件并初始化sqlite3_backup，页面由stepBackup()分批复制，
+     * 两批之间其他数据库请求照常执行；备份期间的写入由SQLite同步到备份中。
+     * 先写入临时文件，完成后才替换上一份备份
+     * @param backupPath 备份文件路径（为空时使用DB_BACKUP_PATH）
+     * @return true 已开始
+     * @return false 已有备份在进行或打开备份文件失败
+     */
+    bool beginBackup(const String& backupPath = "");
+    
+    /**
+     * @brief 复制一批页面（每DB_BACKUP_STEP_INTERVAL_MS由定时任务投递到数据库工作线程）
+     * @param pages 本批最多复制的页数
+     * @return true 备份仍在进行
+     * @return false 没有进行中的备份（已完成、失败或未开始）
+     */
+    bool stepBackup(int pages = DB_BACKUP_PAGES_PER_STEP);
+    
+    /**
+     * @brief 取消进行中的在线备份（删除临时文件，保留上一份备份）
+     */
+    void cancelBackup();
+    
+    /**
+     * @brief 是否有进行中的在线备份（可在任意任务中调用）
+     * @return true 正在备份
+     * @return false 没有进行中的备份
+     */
+    bool isBackupActive() const;
+    
+    /**
+     * @brief 获取在线备份进度
+     * @return DbBackupStatus 备份进度
+     */
+    DbBackupStatus getBackupStatus() const;
+    
     /**
      * @brief 重建损坏的数据库
      * @return true 重建成功
@@ -332,6 +714,42 @@ public:
      */
     bool rollbackTransaction();
     
+    /**
+     * @brief 设置写入持久性级别
+     * @param level 持久性级别
+     */
+    void setDurability(DbDurability level);
+    
+    /**
+     * @brief 获取写入持久性级别
+     * @return DbDurability 持久性级别
+     */
+    DbDurability getDurability() const;
+    
+    /**
+     * @brief 检查是否已启用WAL日志模式
+     * @return true 已启用WAL
+     * @return false 使用DELETE日志模式
+     */
+    bool isWalEnabled() const;
+    
+    /**
+     * @brief 提交合并的写入（由定时任务调用）
+     * 
+     * 短信插入、状态更新与发件箱写入在同一提交窗口内合并为一个事务，
+     * 窗口打开超过DB_GROUP_COMMIT_INTERVAL_MS或force为true时提交
+     * @param force 是否立即提交
+     * @return true 无待提交写入或提交成功
+     * @return false 提交失败（窗口保持打开，下次重试）
+     */
+    bool flushGroupCommit(bool force = false);
+    
+    /**
+     * @brief 释放页面缓存中未使用的内存（内存紧张时调用，须在数据库工作线程中执行）
+     * @return int 释放的字节数
+     */
+    int releaseMemory();
+    
     /**
      * @brief 在事务中删除转发规则（带回滚保护）
      * @param ruleId 规则ID
@@ -347,6 +765,72 @@ public:
      */
     std::vector<std::map<String, String>> executeQuery(const String& sql);
     
+    /**
+     * @brief 行访问回调
+     * @param stmt 已返回SQLITE_ROW的语句
+     * @return true 继续读取下一行
+     * @return false 停止读取
+     */
+    typedef std::function<bool(sqlite3_stmt* stmt)> RowVisitor;
+    
+    /**
+     * @brief 执行查询并逐行回调（按列序号读取，不构造中间结果）
+     *
+     * 回调在持有数据库锁时执行，不得再调用DatabaseManager的其他接口
+     * @param sql SQL查询语句
+     * @param visitor 行访问回调
+     * @return true 执行成功
+     * @return false 执行失败
+     */
+    bool forEachRow(const String& sql, const RowVisitor& visitor);
+    
+    /**
+     * @brief 执行查询并按解码器把每一行解码为结构体
+     * @tparam T 目标结构体类型
+     * @param sql SQL查询语句
+     * @param decoder 行解码器
+     * @param rows 输出：解码结果（追加）
+     * @return true 执行成功
+     * @return false 执行失败
+     */
+    template <typename T>
+    bool queryRows(const String& sql, const RowDecoder<T>& decoder, std::vector<T>& rows) {
+        return forEachRow(sql, [&](sqlite3_stmt* stmt) {
+            rows.emplace_back();
+            decoder.decode(stmt, rows.back());
+            return true;
+        });
+    }
+    
+    /**
+     * @brief 执行查询并把第一行解码为结构体
+     * @tparam T 目标结构体类型
+     * @param sql SQL查询语句
+     * @param decoder 行解码器
+     * @param row 输出：解码结果（无结果时保持原值）
+     * @return true 查询到一行
+     * @return false 执行失败或无结果
+     */
+    template <typename T>
+    bool queryRow(const String& sql, const RowDecoder<T>& decoder, T& row) {
+        bool found = false;
+        bool ok = forEachRow(sql, [&](sqlite3_stmt* stmt) {
+            decoder.decode(stmt, row);
+            found = true;
+            return false;
+        });
+        return ok && found;
+    }
+    
+    /**
+     * @brief 执行返回单个整数的查询
+     * @param sql SQL查询语句
+     * @param value 输出：第一行第一列的值
+     * @return true 查询到结果
+     * @return false 执行失败或无结果
+     */
+    bool queryInt(const String& sql, int& value);
+    
     /**
      * @brief 执行SQL语句（公共接口）
      * @param sql SQL语句
@@ -354,10 +838,68 @@ public:
      * @return false 执行失败
      */
     bool executeSQL(const String& sql);
+    
+    /**
+     * @brief 测量短信插入耗时：每次编译语句与复用预编译语句对比
+     * 
+     * 在结构相同的临时建表中逐条插入（各自独立提交），结束后删除该表
+     * @param iterations 每种方式的插入次数
+     * @return DbBenchmarkResult 测量结果
+     */
+    DbBenchmarkResult benchmarkInsert(int iterations);
+    
+    /**
+     * @brief 提交合并写入窗口，建立插入测量用的独立表（结构与sms_records相同）并预编译插入语句
+     * @return true 准备完成
+     * @return false 数据库未就绪或建表失败
+     */
+    bool prepareInsertBenchmark();
+    
+    /**
+     * @brief 以预编译语句向测量表插入一条样例短信（未处于事务中时单独提交）
+     * @return true 插入成功
+     * @return false 插入失败或未调用prepareInsertBenchmark()
+     */
+    bool insertBenchmarkRecord();
+    
+    /**
+     * @brief 释放插入语句并删除测量表
+     */
+    void finishInsertBenchmark();
 
 
 
 private:
+    /**
+     * @class CachedStatement
+     * @brief 缓存语句的使用凭据：构造时独占该语句，析构时重置并清除绑定
+     */
+    class CachedStatement {
+    public:
+        /**
+         * @brief 取得缓存语句并独占使用
+         * @param manager 数据库管理器
+         * @param id 语句
+         */
+        CachedStatement(DatabaseManager& manager, DbStatement id);
+        
+        /**
+         * @brief 重置语句并清除绑定，供下次使用
+         */
+        ~CachedStatement();
+        
+        /**
+         * @brief 获取语句句柄
+         * @return sqlite3_stmt* 语句句柄，编译失败时为nullptr
+         */
+        sqlite3_stmt* get() const { return stmt; }
+        
+    private:
+        std::unique_lock<std::mutex> lock;  ///< 该语句的独占锁
+        sqlite3_stmt* stmt;                 ///< 语句句柄
+    };
+    
+
     /**
      * @brief 私有构造函数（单例模式）
      */
@@ -410,6 +952,18 @@ private:
      */
     bool executeQuery(const String& sql, int (*callback)(void*, int, char**, char**), void* data);
 
+    /**
+     * @brief 预编译所有缓存语句
+     * @return true 全部编译成功
+     * @return false 部分语句编译失败（使用时再次尝试）
+     */
+    bool prepareStatements();
+
+    /**
+     * @brief 释放所有缓存语句（关闭数据库连接前调用）
+     */
+    void finalizeStatements();
+
     /**
      * @brief 设置错误信息
      * @param error 错误信息
@@ -442,6 +996,103 @@ private:
      * @return false 修复失败
      */
     bool repairDatabaseDirect(const String& backupPath = "");
+    
+    /**
+     * @brief 按rowid删除最旧的一批短信记录
+     * @param limit 最多删除的记录数
+     * @return int 删除的记录数，-1表示失败
+     */
+    int deleteOldestSMSBatch(int limit);
+    
+    /**
+     * @brief 删除一批接收时间在[notBefore, cutoff)内的短信记录
+     * @param notBefore 接收时间下限
+     * @param cutoff 接收时间上限（不含）
+     * @param limit 最多删除的记录数
+     * @return int 删除的记录数，-1表示失败
+     */
+    int deleteSMSBatchBefore(time_t notBefore, time_t cutoff, int limit);
+    
+    /**
+     * @brief 创建短信全文索引及同步触发器（createTables()中调用）
+     * @return true 创建成功
+     * @return false 创建失败（FTS5或trigram分词不可用）
+     */
+    bool createSearchIndex();
+    
+    /**
+     * @brief 计算UTF-8字符串的字符数
+     * @param text 字符串
+     * @return size_t 字符数
+     */
+    static size_t utf8Length(const String& text);
+    
+    /**
+     * @brief 按存储配置为SQLite分配PSRAM页面缓存与堆（sqlite3_initialize()之前调用，只执行一次）
+     */
+    void configureMemory();
+    
+    /**
+     * @brief 配置日志模式与同步级别（初始化阶段调用）
+     */
+    void configureJournal();
+    
+    /**
+     * @brief 挂载原始分区，分区为空且LittleFS上有数据库时迁移过去
+     * @param fullDbPath LittleFS上的数据库路径（也用作原始分区中数据库的文件名）
+     * @param dbExists 输入：LittleFS上是否有数据库；输出：原始分区中是否有数据库
+     * @return true 分区可用
+     * @return false 挂载或迁移失败
+     */
+    bool prepareRawPartition(const String& fullDbPath, bool& dbExists);
+    
+    /**
+     * @brief 把LittleFS上的数据库整体复制到原始分区，成功后原文件加DB_RAW_MIGRATED_SUFFIX后缀保留
+     * @param fullDbPath LittleFS上的数据库路径
+     * @return true 迁移成功
+     * @return false 迁移失败
+     */
+    bool migrateToRawPartition(const String& fullDbPath);
+    
+    /**
+     * @brief 重建插入测量表（结构与sms_records相同，不含索引与触发器）
+     * @return true 建表成功
+     * @return false 建表失败
+     */
+    bool createBenchmarkTable();
+    
+    /**
+     * @brief 插入测量表的SQL（与DB_STMT_INSERT_SMS相同，只换表名）
+     * @return String SQL
+     */
+    static String benchmarkInsertSql();
+    
+    /**
+     * @brief 绑定样例短信并执行插入
+     * @param stmt 插入语句
+     * @return true 插入成功
+     * @return false 插入失败
+     */
+    static bool bindBenchmarkRecord(sqlite3_stmt* stmt);
+    
+    /**
+     * @brief 写入前加入提交窗口：未打开时开始事务，写入数达到上限时先提交
+     */
+    void joinGroupCommit();
+    
+    /**
+     * @brief 结束在线备份，成功时用临时文件替换备份文件
+     * @param succeeded 页面是否已全部复制
+     * @param error 失败原因
+     */
+    void finishBackup(bool succeeded, const String& error);
+
+    /**
+     * @brief 提交当前提交窗口（调用方须持有groupMutex）
+     * @return true 提交成功或没有打开的窗口
+     * @return false 提交失败
+     */
+    bool commitGroupLocked();
 
 
 
@@ -453,6 +1104,28 @@ private:
     bool debugMode;                 ///< 调试模式
     DatabaseInfo dbInfo;            ///< 数据库信息
     mutable std::mutex dbMutex;     ///< 数据库操作互斥锁
+    sqlite3_stmt* statements[DB_STMT_COUNT];    ///< 缓存的预编译语句
+    std::mutex statementLocks[DB_STMT_COUNT];   ///< 每条缓存语句的独占锁
+    DbDurability durability;        ///< 写入持久性级别
+    bool walEnabled;                ///< 是否已启用WAL
+    bool groupOpen;                 ///< 提交窗口是否打开
+    bool explicitTransaction;       ///< 是否处于beginTransaction()开始的事务中
+    unsigned long groupOpenedAt;    ///< 提交窗口打开时间
+    int groupWrites;                ///< 提交窗口内的写入数
+    std::mutex groupMutex;          ///< 保护提交窗口状态
+    bool ftsEnabled;                ///< 全文索引是否可用
+    DbStorageProfile storageProfile;    ///< 存储配置
+    bool memoryConfigured;          ///< 是否已调用configureMemory()
+    bool psramPageCache;            ///< 页面缓存是否位于PSRAM
+    bool psramHeap;                 ///< SQLite堆是否位于PSRAM
+    bool retentionActive;           ///< 是否正在按数量清理（超过上限后直到回落到保留数量）
+    unsigned long lastWriteAt;      ///< 最近一次写入时间
+    sqlite3* backupDb;              ///< 在线备份的目标连接
+    sqlite3_backup* backupHandle;   ///< 进行中的在线备份
+    DbBackupStatus backupStatus;    ///< 在线备份进度
+    std::atomic<bool> backupActive; ///< 是否正在备份（供其他任务查询）
+    bool rawPartition;              ///< 数据库是否位于原始分区（FlashVfs）
+    sqlite3_stmt* benchmarkStatement;   ///< 插入测量表的预编译语句
 };
 
 #endif // DATABASE_MANAGER_H
\ No newline at end of file
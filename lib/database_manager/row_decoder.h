@@ -0,0 +1,154 @@
+/**
+ * @file row_decoder.h
+ * @brief 类型化行解码器 - 按列序号把查询结果直接写入结构体字段
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 取代基于std::map<String, String>的通用回调：
+ * 1. 列按序号读取，不再为每个单元格构造列名与值两个String并做红黑树插入
+ * 2. 整数与时间戳列直接读取数值，不经过文本往返
+ * 3. 解码器描述"列序号 → 结构体字段"的对应关系，可作为静态对象复用
+ *
+ * 使用方式：
+ * @code
+ * static const RowDecoder<APConfig> decoder = RowDecoder<APConfig>()
+ *     .text(0, &APConfig::ssid)
+ *     .integer(1, &APConfig::channel);
+ * decoder.decode(stmt, config);
+ * @endcode
+ */
+
+#ifndef ROW_DECODER_H
+#define ROW_DECODER_H
+
+#include <Arduino.h>
+#include <sqlite3.h>
+#include <vector>
+#include <time.h>
+
+/**
+ * @class RowDecoder
+ * @brief 结构体T的行解码器
+ * @tparam T 目标结构体类型
+ */
+template <typename T>
+class RowDecoder {
+public:
+    /**
+     * @brief 绑定文本列
+     * @param column 列序号
+     * @param field 目标字段
+     * @param fallback 列为NULL时的取值
+     * @return RowDecoder& 自身（链式调用）
+     */
+    RowDecoder& text(int column, String T::*field, const char* fallback = "") {
+        Binder binder = {};
+        binder.kind = BIND_TEXT;
+        binder.column = column;
+        binder.textField = field;
+        binder.fallback = fallback;
+        binders.push_back(binder);
+        return *this;
+    }
+
+    /**
+     * @brief 绑定整数列
+     * @param column 列序号
+     * @param field 目标字段
+     * @return RowDecoder& 自身（链式调用）
+     */
+    RowDecoder& integer(int column, int T::*field) {
+        Binder binder = {};
+        binder.kind = BIND_INTEGER;
+        binder.column = column;
+        binder.intField = field;
+        binders.push_back(binder);
+        return *this;
+    }
+
+    /**
+     * @brief 绑定布尔列（值为1时为true）
+     * @param column 列序号
+     * @param field 目标字段
+     * @return RowDecoder& 自身（链式调用）
+     */
+    RowDecoder& flag(int column, bool T::*field) {
+        Binder binder = {};
+        binder.kind = BIND_FLAG;
+        binder.column = column;
+        binder.flagField = field;
+        binders.push_back(binder);
+        return *this;
+    }
+
+    /**
+     * @brief 绑定Unix时间戳列
+     * @param column 列序号
+     * @param field 目标字段
+     * @return RowDecoder& 自身（链式调用）
+     */
+    RowDecoder& timestamp(int column, time_t T::*field) {
+        Binder binder = {};
+        binder.kind = BIND_TIMESTAMP;
+        binder.column = column;
+        binder.timeField = field;
+        binders.push_back(binder);
+        return *this;
+    }
+
+    /**
+     * @brief 解码当前行
+     * @param stmt 已返回SQLITE_ROW的语句
+     * @param target 目标结构体（未绑定的字段保持原值）
+     */
+    void decode(sqlite3_stmt* stmt, T& target) const {
+        for (const Binder& binder : binders) {
+            switch (binder.kind) {
+                case BIND_TEXT: {
+                    const char* value = (const char*)sqlite3_column_text(stmt, binder.column);
+                    target.*binder.textField = value ? value : binder.fallback;
+                    break;
+                }
+                case BIND_INTEGER:
+                    target.*binder.intField = sqlite3_column_int(stmt, binder.column);
+                    break;
+                case BIND_FLAG:
+                    target.*binder.flagField = sqlite3_column_int(stmt, binder.column) == 1;
+                    break;
+                case BIND_TIMESTAMP:
+                    target.*binder.timeField = (time_t)sqlite3_column_int64(stmt, binder.column);
+                    break;
+            }
+        }
+    }
+
+private:
+    /**
+     * @enum BindKind
+     * @brief 列的解码方式
+     */
+    enum BindKind {
+        BIND_TEXT,          ///< 文本
+        BIND_INTEGER,       ///< 整数
+        BIND_FLAG,          ///< 布尔
+        BIND_TIMESTAMP      ///< Unix时间戳
+    };
+
+    /**
+     * @struct Binder
+     * @brief 一列与一个字段的对应关系
+     */
+    struct Binder {
+        BindKind kind;              ///< 解码方式
+        int column;                 ///< 列序号
+        String T::*textField;       ///< 文本字段
+        int T::*intField;           ///< 整数字段
+        bool T::*flagField;         ///< 布尔字段
+        time_t T::*timeField;       ///< 时间戳字段
+        const char* fallback;       ///< 文本列为NULL时的取值
+    };
+
+    std::vector<Binder> binders;    ///< 按列顺序排列的绑定
+};
+
+#endif // ROW_DECODER_H
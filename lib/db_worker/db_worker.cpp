@@ -0,0 +1,272 @@
+/**
+ * @file db_worker.cpp
+ * @brief 数据库工作线程实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "db_worker.h"
+#include "../database_manager/database_manager.h"
+#include "../metrics/metrics.h"
+#include "../task_topology/task_topology.h"
+
+/**
+ * @brief 构造函数
+ * @param job 请求内容
+ */
+DbRequest::DbRequest(std::function<void()> job)
+    : job(std::move(job)), state(STATE_PENDING), doneSignal(xSemaphoreCreateBinary()), postedUs(micros()) {
+}
+
+/**
+ * @brief 析构函数
+ */
+DbRequest::~DbRequest() {
+    if (doneSignal != nullptr) {
+        vSemaphoreDelete(doneSignal);
+    }
+}
+
+/**
+ * @brief 请求是否已执行完毕
+ * @return true 已完成
+ * @return false 排队中或执行中
+ */
+bool DbRequest::isDone() const {
+    return state.load() == STATE_DONE;
+}
+
+/**
+ * @brief 限时等待请求完成
+ * @param timeoutMs 最长等待时间（毫秒，0表示只检查不等待）
+ * @return true 已完成
+ * @return false 超时
+ */
+bool DbRequest::wait(uint32_t timeoutMs) {
+    if (isDone()) {
+        return true;
+    }
+    if (timeoutMs == 0 || doneSignal == nullptr) {
+        return false;
+    }
+    // 完成信号只发出一次，取到后补回，其他等待方与后续wait()仍能看到
+    if (xSemaphoreTake(doneSignal, pdMS_TO_TICKS(timeoutMs)) == pdTRUE) {
+        xSemaphoreGive(doneSignal);
+    }
+    return isDone();
+}
+
+/**
+ * @brief 取消尚未开始执行的请求
+ * @return true 已取消，请求不会执行
+ * @return false 请求已开始或已完成
+ */
+bool DbRequest::cancel() {
+    int expected = STATE_PENDING;
+    return state.compare_exchange_strong(expected, STATE_CANCELLED);
+}
+
+/**
+ * @brief 私有构造函数（单例模式）
+ */
+DbWorker::DbWorker() : queue(nullptr), taskHandle(nullptr), lastError(""), debugMode(false) {
+}
+
+/**
+ * @brief 获取单例实例
+ * @return DbWorker& 单例引用
+ */
+DbWorker& DbWorker::getInstance() {
+    static DbWorker instance;
+    return instance;
+}
+
+/**
+ * @brief 创建请求队列并启动工作线程（数据库初始化完成后调用）
+ * @return true 启动成功
+ * @return false 启动失败（请求改为在调用方任务中执行）
+ */
+bool DbWorker::initialize() {
+    if (taskHandle != nullptr) {
+        return true;
+    }
+
+    queue = xQueueCreate(DB_WORKER_QUEUE_LENGTH, sizeof(std::shared_ptr<DbRequest>*));
+    if (queue == nullptr) {
+        setError("请求队列创建失败");
+        return false;
+    }
+    if (!TaskTopology::getInstance().createTask(SYSTEM_TASK_DB_WORKER, workerTask, this, &taskHandle)) {
+        vQueueDelete(queue);
+        queue = nullptr;
+        taskHandle = nullptr;
+        setError("工作线程创建失败");
+        return false;
+    }
+    debugPrint("数据库工作线程已启动");
+    return true;
+}
+
+/**
+ * @brief 工作线程是否在运行
+ * @return true 运行中
+ * @return false 未启动
+ */
+bool DbWorker::isRunning() const {
+    return taskHandle != nullptr;
+}
+
+/**
+ * @brief 当前是否在工作线程中执行
+ * @return true 在工作线程中
+ * @return false 在其他任务中
+ */
+bool DbWorker::inWorkerTask() const {
+    return taskHandle != nullptr && xTaskGetCurrentTaskHandle() == taskHandle;
+}
+
+/**
+ * @brief 投递请求，不等待执行
+ * @param job 请求内容
+ * @return std::shared_ptr<DbRequest> 请求（队列已满时为nullptr；工作线程未启动时已在此执行完毕）
+ */
+std::shared_ptr<DbRequest> DbWorker::post(std::function<void()> job) {
+    std::shared_ptr<DbRequest> request(new (std::nothrow) DbRequest(std::move(job)));
+    if (!request || request->doneSignal == nullptr) {
+        setError("请求分配失败");
+        return nullptr;
+    }
+
+    if (!isRunning() || inWorkerTask()) {
+        runRequest(*request);
+        return request;
+    }
+
+    std::shared_ptr<DbRequest>* slot = new (std::nothrow) std::shared_ptr<DbRequest>(request);
+    if (slot == nullptr) {
+        setError("请求分配失败");
+        return nullptr;
+    }
+    if (xQueueSend(queue, &slot, 0) != pdTRUE) {
+        delete slot;
+        setError("请求队列已满");
+        return nullptr;
+    }
+    return request;
+}
+
+/**
+ * @brief 投递请求并等待执行完毕
+ * @param job 请求内容
+ * @param timeoutMs 等待请求开始执行的最长时间（毫秒）
+ * @return true 请求已执行
+ * @return false 队列已满或等待超时（请求未执行）
+ */
+bool DbWorker::call(std::function<void()> job, uint32_t timeoutMs) {
+    if (!isRunning() || inWorkerTask()) {
+        job();
+        return true;
+    }
+
+    std::shared_ptr<DbRequest> request = post(std::move(job));
+    if (!request) {
+        return false;
+    }
+    if (request->wait(timeoutMs)) {
+        return true;
+    }
+    if (request->cancel()) {
+        setError("等待数据库工作线程超时");
+        return false;
+    }
+
+    // 已开始执行：请求可能引用调用方栈上的对象，必须等到它结束
+    while (!request->wait(DB_CALL_TIMEOUT_MS)) {
+        debugPrint("等待执行中的数据库请求结束");
+    }
+    return true;
+}
+
+/**
+ * @brief 获取排队中的请求数
+ * @return uint32_t 请求数
+ */
+uint32_t DbWorker::getPendingCount() const {
+    return queue != nullptr ? (uint32_t)uxQueueMessagesWaiting(queue) : 0;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String DbWorker::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void DbWorker::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief FreeRTOS任务入口
+ * @param parameter DbWorker实例指针
+ */
+void DbWorker::workerTask(void* parameter) {
+    DbWorker* worker = static_cast<DbWorker*>(parameter);
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    std::shared_ptr<DbRequest>* slot = nullptr;
+
+    while (true) {
+        if (xQueueReceive(worker->queue, &slot, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        std::shared_ptr<DbRequest> request = *slot;
+        delete slot;
+
+        metrics.observe(METRIC_DB_QUEUE_WAIT, micros() - request->postedUs);
+        runRequest(*request);
+
+        // 队列排空后提交已超过窗口时长的写入；连续排队的写入留在同一窗口内合并提交
+        if (uxQueueMessagesWaiting(worker->queue) == 0) {
+            DatabaseManager::getInstance().flushGroupCommit();
+        }
+    }
+}
+
+/**
+ * @brief 执行一个请求并发出完成信号
+ * @param request 请求
+ */
+void DbWorker::runRequest(DbRequest& request) {
+    int expected = DbRequest::STATE_PENDING;
+    if (request.state.compare_exchange_strong(expected, DbRequest::STATE_RUNNING)) {
+        request.job();
+        request.state.store(DbRequest::STATE_DONE);
+        xSemaphoreGive(request.doneSignal);
+    }
+    // 释放请求捕获的对象（Web流式响应的状态同时持有该请求，不释放会形成引用环）
+    request.job = nullptr;
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void DbWorker::setError(const String& error) {
+    lastError = error;
+    debugPrint("错误: " + error);
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void DbWorker::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[DbWorker] " + message);
+    }
+}
@@ -0,0 +1,208 @@
+/**
+ * @file db_worker.h
+ * @brief 数据库工作线程 - 独占SQLite连接，按序执行各任务提交的数据库请求
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以一个常驻任务执行所有经由它提交的数据库请求（SQLite以SQLITE_THREADSAFE=0编译，
+ *    同一连接不能被多个任务同时使用）
+ * 2. post()投递请求后立即返回DbRequest，调用方轮询或限时等待其完成（Web回调不必阻塞AsyncTCP）
+ * 3. call()投递请求并等待完成，超时前尚未开始执行的请求被取消，已开始的请求等待其结束
+ * 4. 连续排队的写入在同一提交窗口内执行，合并为一个事务
+ */
+
+#ifndef DB_WORKER_H
+#define DB_WORKER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "../../include/constants.h"
+
+/**
+ * @class DbRequest
+ * @brief 已投递的数据库请求（由DbWorker创建，调用方以它查询结果是否就绪）
+ */
+class DbRequest {
+public:
+    /**
+     * @brief 析构函数
+     */
+    ~DbRequest();
+
+    /**
+     * @brief 请求是否已执行完毕
+     * @return true 已完成
+     * @return false 排队中或执行中
+     */
+    bool isDone() const;
+
+    /**
+     * @brief 限时等待请求完成
+     * @param timeoutMs 最长等待时间（毫秒，0表示只检查不等待）
+     * @return true 已完成
+     * @return false 超时
+     */
+    bool wait(uint32_t timeoutMs);
+
+    /**
+     * @brief 取消尚未开始执行的请求
+     * @return true 已取消，请求不会执行
+     * @return false 请求已开始或已完成
+     */
+    bool cancel();
+
+private:
+    friend class DbWorker;
+
+    /**
+     * @enum State
+     * @brief 请求状态
+     */
+    enum State {
+        STATE_PENDING = 0,          ///< 排队中
+        STATE_RUNNING,              ///< 执行中
+        STATE_DONE,                 ///< 已完成
+        STATE_CANCELLED             ///< 已取消
+    };
+
+    /**
+     * @brief 构造函数
+     * @param job 请求内容
+     */
+    explicit DbRequest(std::function<void()> job);
+
+    std::function<void()> job;          ///< 请求内容（执行或取消后释放，解除对捕获对象的引用）
+    std::atomic<int> state;             ///< 请求状态
+    SemaphoreHandle_t doneSignal;       ///< 完成信号
+    uint32_t postedUs;                  ///< 投递时间（micros）
+};
+
+/**
+ * @class DbWorker
+ * @brief 数据库工作线程类（单例）
+ *
+ * 工作线程未启动时（初始化失败或启动早期）请求在调用方任务中直接执行
+ */
+class DbWorker {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return DbWorker& 单例引用
+     */
+    static DbWorker& getInstance();
+
+    /**
+     * @brief 创建请求队列并启动工作线程（数据库初始化完成后调用）
+     * @return true 启动成功
+     * @return false 启动失败（请求改为在调用方任务中执行）
+     */
+    bool initialize();
+
+    /**
+     * @brief 工作线程是否在运行
+     * @return true 运行中
+     * @return false 未启动
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 当前是否在工作线程中执行
+     * @return true 在工作线程中
+     * @return false 在其他任务中
+     */
+    bool inWorkerTask() const;
+
+    /**
+     * @brief 投递请求，不等待执行
+     *
+     * 请求捕获的对象须以值或shared_ptr持有，调用方返回后请求才可能执行
+     * @param job 请求内容
+     * @return std::shared_ptr<DbRequest> 请求（队列已满时为nullptr；工作线程未启动时已在此执行完毕）
+     */
+    std::shared_ptr<DbRequest> post(std::function<void()> job);
+
+    /**
+     * @brief 投递请求并等待执行完毕
+     *
+     * 在工作线程中调用时直接执行；超时前尚未开始的请求被取消，已开始的请求等待其结束，
+     * 因此请求可以引用调用方栈上的对象
+     * @param job 请求内容
+     * @param timeoutMs 等待请求开始执行的最长时间（毫秒）
+     * @return true 请求已执行
+     * @return false 队列已满或等待超时（请求未执行）
+     */
+    bool call(std::function<void()> job, uint32_t timeoutMs = DB_CALL_TIMEOUT_MS);
+
+    /**
+     * @brief 获取排队中的请求数
+     * @return uint32_t 请求数
+     */
+    uint32_t getPendingCount() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    DbWorker();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    DbWorker(const DbWorker&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    DbWorker& operator=(const DbWorker&) = delete;
+
+    /**
+     * @brief FreeRTOS任务入口
+     * @param parameter DbWorker实例指针
+     */
+    static void workerTask(void* parameter);
+
+    /**
+     * @brief 执行一个请求并发出完成信号
+     * @param request 请求
+     */
+    static void runRequest(DbRequest& request);
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    QueueHandle_t queue;                ///< 请求队列（元素为std::shared_ptr<DbRequest>*）
+    TaskHandle_t taskHandle;            ///< 工作线程句柄
+    String lastError;                   ///< 最后的错误信息
+    bool debugMode;                     ///< 调试模式
+};
+
+#endif // DB_WORKER_H
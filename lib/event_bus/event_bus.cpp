@@ -0,0 +1,82 @@
+/**
+ * @file event_bus.cpp
+ * @brief 系统事件总线实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "event_bus.h"
+
+/**
+ * @brief 获取单例实例
+ * @return EventBus& 单例引用
+ */
+EventBus& EventBus::getInstance() {
+    static EventBus instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+EventBus::EventBus() : nextSubscriptionId(1) {
+}
+
+/**
+ * @brief 订阅所有事件
+ * @param listener 订阅回调
+ * @return int 订阅ID
+ */
+int EventBus::subscribe(const EventListener& listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Subscription subscription;
+    subscription.id = nextSubscriptionId++;
+    subscription.listener = listener;
+    subscriptions.push_back(subscription);
+    return subscription.id;
+}
+
+/**
+ * @brief 取消订阅
+ * @param subscriptionId 订阅ID
+ */
+void EventBus::unsubscribe(int subscriptionId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = subscriptions.begin(); it != subscriptions.end(); ++it) {
+        if (it->id == subscriptionId) {
+            subscriptions.erase(it);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 发布事件
+ * @param type 事件类型
+ * @param data 事件数据（JSON）
+ */
+void EventBus::publish(const char* type, const String& data) {
+    // 在锁外调用回调，回调中订阅或取消订阅不会死锁
+    std::vector<EventListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listeners.reserve(subscriptions.size());
+        for (const Subscription& subscription : subscriptions) {
+            listeners.push_back(subscription.listener);
+        }
+    }
+
+    for (const EventListener& listener : listeners) {
+        listener(type, data);
+    }
+}
+
+/**
+ * @brief 检查是否有订阅者
+ * @return true 有订阅者
+ * @return false 无订阅者
+ */
+bool EventBus::hasSubscribers() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !subscriptions.empty();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file event_bus.h
+ * @brief 系统事件总线 - 将新短信、推送结果等事件分发给订阅者
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 业务模块（SmsHandler、PushManager）在事件发生时发布事件，无需依赖Web层
+ * 2. 订阅者（如WebServer的事件流端点）按事件类型与JSON数据转发给客户端
+ *
+ * 订阅回调在发布者的线程中同步执行，须快速返回且不得阻塞
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include "../../include/constants.h"
+
+/**
+ * @brief 事件订阅回调
+ * @param type 事件类型（EVENT_TYPE_*）
+ * @param data 事件数据（JSON）
+ */
+typedef std::function<void(const char* type, const String& data)> EventListener;
+
+/**
+ * @class EventBus
+ * @brief 系统事件总线（线程安全）
+ */
+class EventBus {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return EventBus& 单例引用
+     */
+    static EventBus& getInstance();
+
+    /**
+     * @brief 订阅所有事件
+     * @param listener 订阅回调
+     * @return int 订阅ID，用于取消订阅
+     */
+    int subscribe(const EventListener& listener);
+
+    /**
+     * @brief 取消订阅
+     * @param subscriptionId 订阅ID
+     */
+    void unsubscribe(int subscriptionId);
+
+    /**
+     * @brief 发布事件
+     * @param type 事件类型（EVENT_TYPE_*）
+     * @param data 事件数据（JSON）
+     */
+    void publish(const char* type, const String& data);
+
+    /**
+     * @brief 检查是否有订阅者（无订阅者时发布者可跳过构造事件数据）
+     * @return true 有订阅者
+     * @return false 无订阅者
+     */
+    bool hasSubscribers() const;
+
+private:
+    /**
+     * @struct Subscription
+     * @brief 一个订阅
+     */
+    struct Subscription {
+        int id;                     ///< 订阅ID
+        EventListener listener;     ///< 订阅回调
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    EventBus();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    EventBus(const EventBus&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    EventBus& operator=(const EventBus&) = delete;
+
+private:
+    std::vector<Subscription> subscriptions;    ///< 订阅列表
+    mutable std::mutex mutex;                   ///< 保护订阅列表
+    int nextSubscriptionId;                     ///< 下一个订阅ID
+};
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,901 @@
+/**
+ * @file flash_vfs.cpp
+ * @brief 原始分区SQLite VFS实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "flash_vfs.h"
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace {
+
+const uint32_t SECTOR_SIZE = DB_RAW_SECTOR_SIZE;
+const uint32_t SUPERBLOCK_MAGIC = 0x51444231;      // "QDB1"
+const uint16_t SUPERBLOCK_VERSION = 1;
+const uint32_t JOURNAL_LOG_FIRST_SECTOR = 2;       // 扇区2-3
+const uint32_t JOURNAL_OFFSET = 4 * SECTOR_SIZE;
+const uint32_t JOURNAL_CAPACITY = DB_RAW_JOURNAL_SECTORS * SECTOR_SIZE;
+const uint32_t MIN_DB_SECTORS = 16;
+const uint32_t ERASED_WORD = 0xFFFFFFFF;
+const uint32_t DB_HEADER_PAGE_SIZE_OFFSET = 16;  // SQLite数据库头中页面大小字段的偏移
+
+/**
+ * @struct Superblock
+ * @brief 超级块：记录数据库大小与分区布局
+ */
+struct Superblock {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t journalSectors;
+    uint32_t seq;
+    uint32_t dbSize;
+    uint32_t crc;
+};
+
+/**
+ * @struct JournalLogEntry
+ * @brief 日志长度记录
+ */
+struct JournalLogEntry {
+    uint32_t seq;
+    uint32_t start;
+    uint32_t size;
+    uint32_t crc;
+};
+
+const uint32_t JOURNAL_LOG_ENTRIES = SECTOR_SIZE / sizeof(JournalLogEntry);
+
+/**
+ * @struct FlashVfsFile
+ * @brief 打开的文件：主数据库或回滚日志（其他文件由默认VFS使用同一块内存）
+ */
+struct FlashVfsFile {
+    sqlite3_file base;
+    bool journal;
+};
+
+uint32_t superblockCrc(const Superblock& block) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&block, offsetof(Superblock, crc));
+}
+
+uint32_t journalLogCrc(const JournalLogEntry& entry) {
+    return esp_rom_crc32_le(SUPERBLOCK_MAGIC, (const uint8_t*)&entry, offsetof(JournalLogEntry, crc));
+}
+
+bool isErased(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @struct FlashVfsCallbacks
+ * @brief SQLite VFS与文件回调
+ */
+struct FlashVfsCallbacks {
+    static const sqlite3_io_methods ioMethods;
+
+    static FlashVfs& self() {
+        return FlashVfs::getInstance();
+    }
+
+    static bool isJournalName(const char* name) {
+        FlashVfs& vfs = self();
+        return vfs.mainOpen && name != nullptr && String(name) == vfs.mainName + "-journal";
+    }
+
+    static bool isWalName(const char* name) {
+        FlashVfs& vfs = self();
+        return vfs.mainOpen && name != nullptr && String(name) == vfs.mainName + "-wal";
+    }
+
+    /**
+     * @brief 事务结束：先持久化数据库大小，再清空日志
+     *
+     * 下一个事务的日志从本次日志之后的扇区开始，擦除分散到整个日志区
+     */
+    static int clearJournal() {
+        FlashVfs& vfs = self();
+        uint32_t used = (vfs.journalSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+        vfs.journalStart = (vfs.journalStart + used) % DB_RAW_JOURNAL_SECTORS;
+        vfs.journalSize = 0;
+        if (!vfs.persistDatabaseSize() || !vfs.persistJournalSize()) {
+            return SQLITE_IOERR_DELETE;
+        }
+        return SQLITE_OK;
+    }
+
+    static int xClose(sqlite3_file* file) {
+        FlashVfsFile* f = (FlashVfsFile*)file;
+        FlashVfs& vfs = self();
+        if (!f->journal) {
+            vfs.persistDatabaseSize();
+            vfs.mainOpen = false;
+            vfs.debugPrint("主数据库已关闭，大小 " + String(vfs.dbSize) + " 字节");
+        }
+        return SQLITE_OK;
+    }
+
+    static int xRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset) {
+        FlashVfsFile* f = (FlashVfsFile*)file;
+        FlashVfs& vfs = self();
+        uint32_t size = f->journal ? vfs.journalSize : vfs.dbSize;
+
+        size_t available = offset < size ? (size_t)(size - offset) : 0;
+        size_t length = (size_t)amount < available ? (size_t)amount : available;
+        bool ok = length == 0 ||
+                  (f->journal ? vfs.readJournal((uint32_t)offset, (uint8_t*)buffer, length)
+                              : vfs.readRange(vfs.dbRegionOffset + (uint32_t)offset, (uint8_t*)buffer, length));
+        if (!ok) {
+            return SQLITE_IOERR_READ;
+        }
+        if (length < (size_t)amount) {
+            // 读到文件末尾之外：SQLite要求补零并返回短读
+            memset((uint8_t*)buffer + length, 0, amount - length);
+            return SQLITE_IOERR_SHORT_READ;
+        }
+        return SQLITE_OK;
+    }
+
+    static int xWrite(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset) {
+        FlashVfsFile* f = (FlashVfsFile*)file;
+        FlashVfs& vfs = self();
+        uint64_t end = (uint64_t)offset + amount;
+        if (f->journal) {
+            if (end > JOURNAL_CAPACITY) {
+                vfs.lastError = "回滚日志超出日志区容量";
+                return SQLITE_FULL;
+            }
+            if (!vfs.writeJournal((uint32_t)offset, (const uint8_t*)buffer, amount)) {
+                return SQLITE_IOERR_WRITE;
+            }
+            if (end > vfs.journalSize) {
+                vfs.journalSize = (uint32_t)end;
+            }
+            return SQLITE_OK;
+        }
+
+        if (end > vfs.dbCapacity) {
+            vfs.lastError = "数据库超出分区容量";
+            return SQLITE_FULL;
+        }
+        // 覆盖数据库页面之前，日志中的原页面必须在掉电后仍可找到
+        if (!vfs.persistJournalSize()) {
+            return SQLITE_IOERR_WRITE;
+        }
+        if (!vfs.writeRange(vfs.dbRegionOffset + (uint32_t)offset, (const uint8_t*)buffer, amount,
+                            vfs.dbRegionOffset + vfs.dbSize)) {
+            return SQLITE_IOERR_WRITE;
+        }
+        if (end > vfs.dbSize) {
+            vfs.dbSize = (uint32_t)end;
+        }
+        if (offset < DB_HEADER_PAGE_SIZE_OFFSET + 2) {
+            // 数据库头被改写（新建或VACUUM改变页面大小），下次使用时重新读取
+            vfs.pageSize = 0;
+        }
+        return SQLITE_OK;
+    }
+
+    static int xTruncate(sqlite3_file* file, sqlite3_int64 size) {
+        FlashVfsFile* f = (FlashVfsFile*)file;
+        FlashVfs& vfs = self();
+        if (f->journal) {
+            if (size == 0) {
+                return clearJournal() == SQLITE_OK ? SQLITE_OK : SQLITE_IOERR_TRUNCATE;
+            }
+            if ((uint64_t)size < vfs.journalSize) {
+                vfs.journalSize = (uint32_t)size;
+            }
+            return SQLITE_OK;
+        }
+        if ((uint64_t)size < vfs.dbSize) {
+            vfs.dbSize = (uint32_t)size;
+            vfs.pageSize = 0;
+        }
+        return SQLITE_OK;
+    }
+
+    static int xSync(sqlite3_file* file, int flags) {
+        (void)flags;
+        FlashVfsFile* f = (FlashVfsFile*)file;
+        FlashVfs& vfs = self();
+        // 数据写入flash即已持久，同步只需记录文件大小
+        bool ok = f->journal ? vfs.persistJournalSize() : vfs.persistDatabaseSize();
+        return ok ? SQLITE_OK : SQLITE_IOERR_FSYNC;
+    }
+
+    static int xFileSize(sqlite3_file* file, sqlite3_int64* size) {
+        FlashVfsFile* f = (FlashVfsFile*)file;
+        *size = f->journal ? self().journalSize : self().dbSize;
+        return SQLITE_OK;
+    }
+
+    // 只有一个连接，锁操作无需实现
+    static int xLock(sqlite3_file*, int) {
+        return SQLITE_OK;
+    }
+
+    static int xUnlock(sqlite3_file*, int) {
+        return SQLITE_OK;
+    }
+
+    static int xCheckReservedLock(sqlite3_file*, int* result) {
+        *result = 0;
+        return SQLITE_OK;
+    }
+
+    static int xFileControl(sqlite3_file*, int, void*) {
+        return SQLITE_NOTFOUND;
+    }
+
+    static int xSectorSize(sqlite3_file*) {
+        return SECTOR_SIZE;
+    }
+
+    static int xDeviceCharacteristics(sqlite3_file*) {
+        // 文件大小只在数据写入后记录（追加安全）。
+        // 页面不小于扇区时写一页不影响相邻页；页面更小时擦除扇区会连带改写同扇区的其他页，
+        // 不能声明POWERSAFE_OVERWRITE，SQLite才会把同一扇区的页面一起写入日志。
+        // 不声明SEQUENTIAL：SQLite会因此省略日志同步
+        int characteristics = SQLITE_IOCAP_SAFE_APPEND;
+        if (self().getPageSize() >= SECTOR_SIZE) {
+            characteristics |= SQLITE_IOCAP_POWERSAFE_OVERWRITE;
+        }
+        return characteristics;
+    }
+
+    static int xOpen(sqlite3_vfs* pVfs, const char* name, sqlite3_file* file, int flags, int* outFlags) {
+        (void)pVfs;
+        FlashVfs& vfs = self();
+        FlashVfsFile* f = (FlashVfsFile*)file;
+
+        if (flags & SQLITE_OPEN_WAL) {
+            vfs.lastError = "原始分区不支持WAL";
+            return SQLITE_CANTOPEN;
+        }
+        if ((flags & SQLITE_OPEN_MAIN_DB) && name != nullptr) {
+            if (!vfs.mounted || vfs.mainOpen) {
+                vfs.lastError = vfs.mounted ? "原始分区数据库已被打开" : "原始分区未挂载";
+                return SQLITE_CANTOPEN;
+            }
+            vfs.mainName = name;
+            vfs.mainOpen = true;
+            f->journal = false;
+        } else if ((flags & SQLITE_OPEN_MAIN_JOURNAL) && isJournalName(name)) {
+            f->journal = true;
+        } else {
+            return vfs.defaultVfs->xOpen(vfs.defaultVfs, name, file, flags, outFlags);
+        }
+
+        f->base.pMethods = &ioMethods;
+        if (outFlags != nullptr) {
+            *outFlags = flags;
+        }
+        return SQLITE_OK;
+    }
+
+    static int xDelete(sqlite3_vfs* pVfs, const char* name, int syncDir) {
+        (void)pVfs;
+        if (isJournalName(name)) {
+            return clearJournal();
+        }
+        if (isWalName(name)) {
+            return SQLITE_OK;
+        }
+        return self().defaultVfs->xDelete(self().defaultVfs, name, syncDir);
+    }
+
+    static int xAccess(sqlite3_vfs* pVfs, const char* name, int flags, int* result) {
+        (void)pVfs;
+        FlashVfs& vfs = self();
+        if (isJournalName(name)) {
+            *result = vfs.journalSize > 0;
+            return SQLITE_OK;
+        }
+        if (isWalName(name)) {
+            *result = 0;
+            return SQLITE_OK;
+        }
+        return vfs.defaultVfs->xAccess(vfs.defaultVfs, name, flags, result);
+    }
+
+    static int xFullPathname(sqlite3_vfs* pVfs, const char* name, int size, char* out) {
+        (void)pVfs;
+        return self().defaultVfs->xFullPathname(self().defaultVfs, name, size, out);
+    }
+
+    static int xRandomness(sqlite3_vfs* pVfs, int size, char* out) {
+        (void)pVfs;
+        return self().defaultVfs->xRandomness(self().defaultVfs, size, out);
+    }
+
+    static int xSleep(sqlite3_vfs* pVfs, int microseconds) {
+        (void)pVfs;
+        return self().defaultVfs->xSleep(self().defaultVfs, microseconds);
+    }
+
+    static int xCurrentTime(sqlite3_vfs* pVfs, double* now) {
+        (void)pVfs;
+        return self().defaultVfs->xCurrentTime(self().defaultVfs, now);
+    }
+
+    static int xGetLastError(sqlite3_vfs* pVfs, int size, char* out) {
+        (void)pVfs;
+        return self().defaultVfs->xGetLastError(self().defaultVfs, size, out);
+    }
+};
+
+const sqlite3_io_methods FlashVfsCallbacks::ioMethods = {
+    1,                                          // iVersion
+    FlashVfsCallbacks::xClose,
+    FlashVfsCallbacks::xRead,
+    FlashVfsCallbacks::xWrite,
+    FlashVfsCallbacks::xTruncate,
+    FlashVfsCallbacks::xSync,
+    FlashVfsCallbacks::xFileSize,
+    FlashVfsCallbacks::xLock,
+    FlashVfsCallbacks::xUnlock,
+    FlashVfsCallbacks::xCheckReservedLock,
+    FlashVfsCallbacks::xFileControl,
+    FlashVfsCallbacks::xSectorSize,
+    FlashVfsCallbacks::xDeviceCharacteristics,
+    nullptr, nullptr, nullptr, nullptr,         // 无共享内存（WAL）
+    nullptr, nullptr                            // 无内存映射
+};
+
+/**
+ * @brief 获取单例实例
+ * @return FlashVfs& 单例引用
+ */
+FlashVfs& FlashVfs::getInstance() {
+    static FlashVfs instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+FlashVfs::FlashVfs()
+    : partition(nullptr),
+      defaultVfs(nullptr),
+      sectorBuffer(nullptr),
+      mounted(false),
+      registered(false),
+      debugMode(false),
+      mainOpen(false),
+      superblockSeq(0),
+      journalLogSeq(0),
+      journalLogSector(0),
+      journalLogOffset(0),
+      journalStart(0),
+      persistedJournalStart(0),
+      dbSize(0),
+      persistedDbSize(0),
+      journalSize(0),
+      persistedJournalSize(0),
+      dbRegionOffset(JOURNAL_OFFSET + JOURNAL_CAPACITY),
+      dbCapacity(0),
+      pageSize(0) {
+    memset(&vfs, 0, sizeof(vfs));
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief 挂载分区并注册VFS
+ * @param label 分区标签
+ * @return true 挂载成功
+ * @return false 分区不存在或布局不匹配
+ */
+bool FlashVfs::initialize(const char* label) {
+    if (mounted && registered) {
+        return true;
+    }
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == nullptr) {
+        lastError = "未找到数据库分区: " + String(label) + "（请使用partitions_rawdb.csv分区表）";
+        return false;
+    }
+    if (partition->size < dbRegionOffset + MIN_DB_SECTORS * SECTOR_SIZE) {
+        lastError = "数据库分区过小: " + String(partition->size) + " 字节";
+        return false;
+    }
+    dbCapacity = partition->size - dbRegionOffset;
+
+    if (sectorBuffer == nullptr) {
+        sectorBuffer = (uint8_t*)heap_caps_malloc(SECTOR_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (sectorBuffer == nullptr) {
+            lastError = "扇区缓冲区分配失败";
+            return false;
+        }
+    }
+
+    if (!mounted) {
+        if (!mount()) {
+            if (!lastError.isEmpty()) {
+                return false;
+            }
+            debugPrint("分区中没有有效超级块，格式化为空数据库");
+            if (!format()) {
+                return false;
+            }
+        }
+    }
+
+    if (!registered) {
+        defaultVfs = sqlite3_vfs_find(nullptr);
+        if (defaultVfs == nullptr) {
+            lastError = "未找到默认VFS";
+            return false;
+        }
+        vfs.iVersion = 1;
+        // 其他文件由默认VFS在同一块内存中打开
+        vfs.szOsFile = defaultVfs->szOsFile > (int)sizeof(FlashVfsFile) ? defaultVfs->szOsFile
+                                                                        : (int)sizeof(FlashVfsFile);
+        vfs.mxPathname = defaultVfs->mxPathname;
+        vfs.zName = DB_RAW_VFS_NAME;
+        vfs.xOpen = FlashVfsCallbacks::xOpen;
+        vfs.xDelete = FlashVfsCallbacks::xDelete;
+        vfs.xAccess = FlashVfsCallbacks::xAccess;
+        vfs.xFullPathname = FlashVfsCallbacks::xFullPathname;
+        vfs.xRandomness = FlashVfsCallbacks::xRandomness;
+        vfs.xSleep = FlashVfsCallbacks::xSleep;
+        vfs.xCurrentTime = FlashVfsCallbacks::xCurrentTime;
+        vfs.xGetLastError = FlashVfsCallbacks::xGetLastError;
+        // xDlOpen等保持为空：编译时已禁用扩展加载（SQLITE_OMIT_LOAD_EXTENSION）
+        int rc = sqlite3_vfs_register(&vfs, 0);
+        if (rc != SQLITE_OK) {
+            lastError = "注册VFS失败: " + String(rc);
+            return false;
+        }
+        registered = true;
+    }
+
+    debugPrint("分区 " + String(label) + " 已挂载：数据库 " + String(dbSize) + " / " + String(dbCapacity) +
+               " 字节，日志 " + String(journalSize) + " 字节");
+    return true;
+}
+
+/**
+ * @brief 是否已挂载
+ * @return true 已挂载
+ * @return false 未挂载
+ */
+bool FlashVfs::isMounted() const {
+    return mounted;
+}
+
+/**
+ * @brief 分区中是否已有数据库
+ * @return true 数据库大小大于0
+ * @return false 空分区
+ */
+bool FlashVfs::hasDatabase() const {
+    return mounted && dbSize > 0;
+}
+
+/**
+ * @brief 清空分区中的数据库与日志
+ * @return true 格式化成功
+ * @return false 格式化失败
+ */
+bool FlashVfs::format() {
+    if (partition == nullptr || mainOpen) {
+        lastError = partition == nullptr ? "原始分区未初始化" : "数据库打开时不能格式化";
+        return false;
+    }
+    // 数据区域不必擦除：大小为0后旧内容不再可见，写入时按需擦除
+    for (uint32_t sector = 0; sector < JOURNAL_LOG_FIRST_SECTOR + 2; sector++) {
+        if (!eraseSector(sector)) {
+            return false;
+        }
+    }
+    superblockSeq = 0;
+    dbSize = 0;
+    pageSize = 0;
+    journalSize = 0;
+    persistedJournalSize = 0;
+    journalLogSeq = 0;
+    journalLogSector = 0;
+    journalLogOffset = 0;
+    journalStart = 0;
+    persistedJournalStart = 0;
+    if (!writeSuperblock()) {
+        return false;
+    }
+    mounted = true;
+    debugPrint("原始分区已格式化");
+    return true;
+}
+
+/**
+ * @brief 获取数据库大小
+ * @return size_t 数据库大小（字节）
+ */
+size_t FlashVfs::getDatabaseSize() const {
+    return dbSize;
+}
+
+/**
+ * @brief 获取数据库区域容量
+ * @return size_t 容量（字节）
+ */
+size_t FlashVfs::getCapacity() const {
+    return dbCapacity;
+}
+
+/**
+ * @brief 获取写入统计
+ * @return FlashVfsStats 统计快照
+ */
+FlashVfsStats FlashVfs::getStats() const {
+    return stats;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String FlashVfs::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void FlashVfs::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief 读取超级块与日志长度记录
+ * @return true 找到有效超级块
+ * @return false 分区未格式化（lastError为空）或布局不匹配（lastError非空）
+ */
+bool FlashVfs::mount() {
+    lastError = "";
+    pageSize = 0;
+    bool found = false;
+    for (uint32_t sector = 0; sector < 2; sector++) {
+        Superblock block;
+        if (esp_partition_read(partition, sector * SECTOR_SIZE, &block, sizeof(block)) != ESP_OK) {
+            continue;
+        }
+        if (block.magic != SUPERBLOCK_MAGIC || block.version != SUPERBLOCK_VERSION ||
+            block.crc != superblockCrc(block)) {
+            continue;
+        }
+        if (block.journalSectors != DB_RAW_JOURNAL_SECTORS) {
+            lastError = "分区布局与DB_RAW_JOURNAL_SECTORS不一致（" + String(block.journalSectors) + "）";
+            return false;
+        }
+        if (!found || block.seq > superblockSeq) {
+            found = true;
+            superblockSeq = block.seq;
+            dbSize = block.dbSize;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    persistedDbSize = dbSize;
+
+    // 取序号最大的有效长度记录，追加位置为该扇区第一个未写入的槽位
+    bool logFound = false;
+    journalStart = 0;
+    journalSize = 0;
+    journalLogSeq = 0;
+    journalLogSector = 0;
+    uint32_t firstFree[2] = {JOURNAL_LOG_ENTRIES, JOURNAL_LOG_ENTRIES};
+    for (uint32_t s = 0; s < 2; s++) {
+        uint32_t base = (JOURNAL_LOG_FIRST_SECTOR + s) * SECTOR_SIZE;
+        if (esp_partition_read(partition, base, sectorBuffer, SECTOR_SIZE) != ESP_OK) {
+            continue;
+        }
+        const JournalLogEntry* entries = (const JournalLogEntry*)sectorBuffer;
+        for (uint32_t i = 0; i < JOURNAL_LOG_ENTRIES; i++) {
+            const JournalLogEntry& entry = entries[i];
+            if (isErased((const uint8_t*)&entry, sizeof(entry))) {
+                firstFree[s] = i;
+                break;
+            }
+            // 写到一半的记录校验不通过，跳过继续查找
+            if (entry.seq != ERASED_WORD && entry.crc == journalLogCrc(entry) &&
+                (!logFound || entry.seq > journalLogSeq)) {
+                logFound = true;
+                journalLogSeq = entry.seq;
+                journalStart = entry.start;
+                journalSize = entry.size;
+                journalLogSector = s;
+            }
+        }
+    }
+    journalLogOffset = firstFree[journalLogSector] * sizeof(JournalLogEntry);
+    if (journalSize > JOURNAL_CAPACITY || journalStart >= DB_RAW_JOURNAL_SECTORS) {
+        journalStart = 0;
+        journalSize = 0;
+    }
+    persistedJournalStart = journalStart;
+    persistedJournalSize = journalSize;
+    mounted = true;
+
+    if (journalSize > 0) {
+        debugPrint("发现未完成事务的回滚日志（" + String(journalSize) + " 字节），打开数据库时回滚");
+    }
+    return true;
+}
+
+/**
+ * @brief 在另一个超级块位置写入当前数据库大小
+ * @return true 写入成功
+ * @return false 写入失败
+ */
+bool FlashVfs::writeSuperblock() {
+    Superblock block;
+    memset(&block, 0xFF, sizeof(block));
+    block.magic = SUPERBLOCK_MAGIC;
+    block.version = SUPERBLOCK_VERSION;
+    block.journalSectors = DB_RAW_JOURNAL_SECTORS;
+    block.seq = superblockSeq + 1;
+    block.dbSize = dbSize;
+    block.crc = superblockCrc(block);
+
+    // 交替写入：擦除或写入中途掉电时另一个超级块仍然有效
+    uint32_t sector = block.seq & 1;
+    if (!eraseSector(sector)) {
+        return false;
+    }
+    if (esp_partition_write(partition, sector * SECTOR_SIZE, &block, sizeof(block)) != ESP_OK) {
+        lastError = "写入超级块失败";
+        return false;
+    }
+    superblockSeq = block.seq;
+    persistedDbSize = dbSize;
+    stats.bytesProgrammed += sizeof(block);
+    stats.superblockWrites++;
+    return true;
+}
+
+/**
+ * @brief 追加一条日志长度记录
+ * @param size 日志大小
+ * @return true 写入成功
+ * @return false 写入失败
+ */
+bool FlashVfs::appendJournalLog(uint32_t size) {
+    if (journalLogOffset + sizeof(JournalLogEntry) > SECTOR_SIZE) {
+        // 当前扇区已满：擦除另一个扇区继续追加，最新记录写入前旧扇区仍然有效
+        uint32_t next = journalLogSector ^ 1;
+        if (!eraseSector(JOURNAL_LOG_FIRST_SECTOR + next)) {
+            return false;
+        }
+        journalLogSector = next;
+        journalLogOffset = 0;
+    }
+
+    JournalLogEntry entry;
+    entry.seq = journalLogSeq + 1;
+    entry.start = journalStart;
+    entry.size = size;
+    entry.crc = journalLogCrc(entry);
+    uint32_t offset = (JOURNAL_LOG_FIRST_SECTOR + journalLogSector) * SECTOR_SIZE + journalLogOffset;
+    // 无论是否成功都不再使用该槽位（写到一半的记录不能再次编写）
+    journalLogOffset += sizeof(entry);
+    if (esp_partition_write(partition, offset, &entry, sizeof(entry)) != ESP_OK) {
+        lastError = "写入日志长度记录失败";
+        return false;
+    }
+    journalLogSeq = entry.seq;
+    persistedJournalStart = journalStart;
+    persistedJournalSize = size;
+    stats.bytesProgrammed += sizeof(entry);
+    stats.journalLogWrites++;
+    return true;
+}
+
+/**
+ * @brief 写入任意范围
+ * @param offset 分区内偏移
+ * @param data 数据
+ * @param length 长度
+ * @param validEnd 文件有效内容的结束偏移，其后的旧内容不需要保留
+ * @return true 写入成功
+ * @return false 写入失败
+ */
+bool FlashVfs::writeRange(uint32_t offset, const uint8_t* data, size_t length, uint32_t validEnd) {
+    while (length > 0) {
+        uint32_t sectorStart = offset - offset % SECTOR_SIZE;
+        uint32_t inSector = offset - sectorStart;
+        size_t chunk = SECTOR_SIZE - inSector < length ? SECTOR_SIZE - inSector : length;
+
+        if (esp_partition_read(partition, sectorStart, sectorBuffer, SECTOR_SIZE) != ESP_OK) {
+            lastError = "读取扇区失败";
+            return false;
+        }
+
+        if (memcmp(sectorBuffer + inSector, data, chunk) == 0) {
+            stats.skippedWrites++;
+        } else if (isErased(sectorBuffer + inSector, chunk)) {
+            // 目标已擦除（新页面或日志追加）：直接编写
+            if (esp_partition_write(partition, offset, data, chunk) != ESP_OK) {
+                lastError = "写入扇区失败";
+                return false;
+            }
+            stats.bytesProgrammed += chunk;
+        } else {
+            // 覆盖已写入的数据：保留扇区内仍有效的内容，其余位置保持擦除状态，
+            // 之后的追加写入不必再次擦除
+            uint32_t keep = validEnd > sectorStart ? validEnd - sectorStart : 0;
+            if (keep > SECTOR_SIZE) {
+                keep = SECTOR_SIZE;
+            }
+            if (keep < inSector) {
+                memset(sectorBuffer + keep, 0xFF, inSector - keep);
+            }
+            memcpy(sectorBuffer + inSector, data, chunk);
+            uint32_t writeEnd = inSector + chunk > keep ? inSector + chunk : keep;
+            if (!eraseSector(sectorStart / SECTOR_SIZE)) {
+                return false;
+            }
+            if (esp_partition_write(partition, sectorStart, sectorBuffer, writeEnd) != ESP_OK) {
+                lastError = "写入扇区失败";
+                return false;
+            }
+            stats.bytesProgrammed += writeEnd;
+        }
+
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief 获取数据库头中记录的页面大小（首次调用时从分区读取）
+ * @return uint32_t 页面大小，数据库为空时为0
+ */
+uint32_t FlashVfs::getPageSize() {
+    if (pageSize == 0 && dbSize >= DB_HEADER_PAGE_SIZE_OFFSET + 2) {
+        // 数据库头偏移16处为大端的页面大小，1表示65536
+        uint8_t header[2];
+        if (readRange(dbRegionOffset + DB_HEADER_PAGE_SIZE_OFFSET, header, sizeof(header))) {
+            uint32_t size = ((uint32_t)header[0] << 8) | header[1];
+            pageSize = size == 1 ? 65536 : size;
+        }
+    }
+    return pageSize;
+}
+
+/**
+ * @brief 读取任意范围
+ * @param offset 分区内偏移
+ * @param data 输出缓冲区
+ * @param length 长度
+ * @return true 读取成功
+ * @return false 读取失败
+ */
+bool FlashVfs::readRange(uint32_t offset, uint8_t* data, size_t length) {
+    if (esp_partition_read(partition, offset, data, length) != ESP_OK) {
+        lastError = "读取分区失败";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 日志文件中的扇区对应的分区偏移（日志从journalStart扇区开始，在日志区内循环）
+ * @param fileSector 日志文件中的扇区号
+ * @return uint32_t 分区内偏移
+ */
+uint32_t FlashVfs::journalSectorOffset(uint32_t fileSector) const {
+    return JOURNAL_OFFSET + ((journalStart + fileSector) % DB_RAW_JOURNAL_SECTORS) * SECTOR_SIZE;
+}
+
+/**
+ * @brief 写入日志文件（逐扇区映射到日志区）
+ * @param offset 日志文件中的偏移
+ * @param data 数据
+ * @param length 长度
+ * @return true 写入成功
+ * @return false 写入失败
+ */
+bool FlashVfs::writeJournal(uint32_t offset, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        uint32_t fileSector = offset / SECTOR_SIZE;
+        uint32_t inSector = offset % SECTOR_SIZE;
+        size_t chunk = SECTOR_SIZE - inSector < length ? SECTOR_SIZE - inSector : length;
+        uint32_t sectorStart = journalSectorOffset(fileSector);
+        uint32_t fileSectorStart = fileSector * SECTOR_SIZE;
+        uint32_t keep = journalSize > fileSectorStart ? journalSize - fileSectorStart : 0;
+        if (!writeRange(sectorStart + inSector, data, chunk, sectorStart + (keep < SECTOR_SIZE ? keep : SECTOR_SIZE))) {
+            return false;
+        }
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取日志文件
+ * @param offset 日志文件中的偏移
+ * @param data 输出缓冲区
+ * @param length 长度
+ * @return true 读取成功
+ * @return false 读取失败
+ */
+bool FlashVfs::readJournal(uint32_t offset, uint8_t* data, size_t length) {
+    while (length > 0) {
+        uint32_t inSector = offset % SECTOR_SIZE;
+        size_t chunk = SECTOR_SIZE - inSector < length ? SECTOR_SIZE - inSector : length;
+        if (!readRange(journalSectorOffset(offset / SECTOR_SIZE) + inSector, data, chunk)) {
+            return false;
+        }
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief 擦除扇区
+ * @param sector 扇区号
+ * @return true 擦除成功
+ * @return false 擦除失败
+ */
+bool FlashVfs::eraseSector(uint32_t sector) {
+    if (esp_partition_erase_range(partition, sector * SECTOR_SIZE, SECTOR_SIZE) != ESP_OK) {
+        lastError = "擦除扇区失败: " + String(sector);
+        return false;
+    }
+    stats.sectorsErased++;
+    return true;
+}
+
+/**
+ * @brief 数据库页面写入前持久化日志大小
+ * @return true 成功
+ * @return false 失败
+ */
+bool FlashVfs::persistJournalSize() {
+    if (journalSize == persistedJournalSize && journalStart == persistedJournalStart) {
+        return true;
+    }
+    return appendJournalLog(journalSize);
+}
+
+/**
+ * @brief 数据库大小变化后持久化
+ * @return true 成功
+ * @return false 失败
+ */
+bool FlashVfs::persistDatabaseSize() {
+    if (dbSize == persistedDbSize) {
+        return true;
+    }
+    return writeSuperblock();
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void FlashVfs::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[FlashVfs] " + message);
+    }
+}
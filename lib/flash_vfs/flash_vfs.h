@@ -0,0 +1,268 @@
+/**
+ * @file flash_vfs.h
+ * @brief 原始分区SQLite VFS - 数据库直接存放在专用flash分区上，不经过LittleFS
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 向SQLite注册名为DB_RAW_VFS_NAME的VFS，主数据库与回滚日志映射到DB_RAW_PARTITION_LABEL分区
+ * 2. 页面大小与扇区大小一致，每次写页正好对应一个扇区；写入目标已擦除时直接编写，
+ *    内容未变化时跳过，只有覆盖已写入的数据时才擦除扇区
+ * 3. 数据库大小记录在两个交替写入的超级块中，日志的起始扇区与长度记录在只追加的长度日志中，
+ *    掉电后以最后一个校验通过的记录为准
+ * 4. 每个事务的日志从上一个日志之后的扇区开始，在日志区内循环，擦除不集中在固定几个扇区
+ * 5. 统计编写字节数与擦除扇区数，用于与LittleFS比较写放大
+ *
+ * 分区布局（扇区为4KB）：
+ *   扇区0-1        超级块A/B（序号大者有效）
+ *   扇区2-3        日志长度记录（交替使用，写满一个后擦除另一个继续追加）
+ *   之后DB_RAW_JOURNAL_SECTORS个扇区  回滚日志数据（循环使用）
+ *   其余           数据库页面
+ *
+ * 只支持回滚日志（DELETE模式），不支持WAL；临时文件与其他文件交给默认VFS处理
+ */
+
+#ifndef FLASH_VFS_H
+#define FLASH_VFS_H
+
+#include <Arduino.h>
+#include <sqlite3.h>
+#include <esp_partition.h>
+#include "../../include/constants.h"
+
+/**
+ * @struct FlashVfsStats
+ * @brief 原始分区写入统计（自挂载起累计）
+ */
+struct FlashVfsStats {
+    uint32_t bytesProgrammed;   ///< 编写的字节数（含擦除后回写的整扇区）
+    uint32_t sectorsErased;     ///< 擦除的扇区数
+    uint32_t skippedWrites;     ///< 内容未变化而跳过的扇区写入数
+    uint32_t superblockWrites;  ///< 超级块写入数
+    uint32_t journalLogWrites;  ///< 日志长度记录写入数
+};
+
+/**
+ * @class FlashVfs
+ * @brief 原始分区SQLite VFS（只应由数据库工作线程使用）
+ */
+class FlashVfs {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return FlashVfs& 单例引用
+     */
+    static FlashVfs& getInstance();
+
+    /**
+     * @brief 挂载分区并注册VFS（须在sqlite3_initialize()之后调用，重复调用直接返回）
+     *
+     * 分区中没有有效超级块时格式化为空数据库
+     * @param label 分区标签
+     * @return true 挂载成功
+     * @return false 分区不存在或布局不匹配
+     */
+    bool initialize(const char* label = DB_RAW_PARTITION_LABEL);
+
+    /**
+     * @brief 是否已挂载
+     * @return true 已挂载
+     * @return false 未挂载
+     */
+    bool isMounted() const;
+
+    /**
+     * @brief 分区中是否已有数据库
+     * @return true 数据库大小大于0
+     * @return false 空分区
+     */
+    bool hasDatabase() const;
+
+    /**
+     * @brief 清空分区中的数据库与日志（数据库须已关闭）
+     * @return true 格式化成功
+     * @return false 格式化失败
+     */
+    bool format();
+
+    /**
+     * @brief 获取数据库大小
+     * @return size_t 数据库大小（字节）
+     */
+    size_t getDatabaseSize() const;
+
+    /**
+     * @brief 获取数据库区域容量
+     * @return size_t 容量（字节）
+     */
+    size_t getCapacity() const;
+
+    /**
+     * @brief 获取写入统计
+     * @return FlashVfsStats 统计快照
+     */
+    FlashVfsStats getStats() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    FlashVfs();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    FlashVfs(const FlashVfs&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    FlashVfs& operator=(const FlashVfs&) = delete;
+
+    /**
+     * @brief 读取超级块与日志长度记录，恢复数据库与日志大小
+     * @return true 找到有效超级块
+     * @return false 分区未格式化
+     */
+    bool mount();
+
+    /**
+     * @brief 获取数据库头中记录的页面大小（首次调用时从分区读取）
+     * @return uint32_t 页面大小，数据库为空时为0
+     */
+    uint32_t getPageSize();
+
+    /**
+     * @brief 在另一个超级块位置写入当前数据库大小
+     * @return true 写入成功
+     * @return false 写入失败
+     */
+    bool writeSuperblock();
+
+    /**
+     * @brief 追加一条日志长度记录，当前扇区写满时换用另一个扇区
+     * @param size 日志大小
+     * @return true 写入成功
+     * @return false 写入失败
+     */
+    bool appendJournalLog(uint32_t size);
+
+    /**
+     * @brief 写入任意范围：目标已擦除时直接编写，内容相同时跳过，否则读出扇区合并后擦除重写
+     * @param offset 分区内偏移
+     * @param data 数据
+     * @param length 长度
+     * @param validEnd 文件有效内容的结束偏移，其后的旧内容不需要保留
+     * @return true 写入成功
+     * @return false 写入失败
+     */
+    bool writeRange(uint32_t offset, const uint8_t* data, size_t length, uint32_t validEnd);
+
+    /**
+     * @brief 写入日志文件（逐扇区映射到日志区）
+     * @param offset 日志文件中的偏移
+     * @param data 数据
+     * @param length 长度
+     * @return true 写入成功
+     * @return false 写入失败
+     */
+    bool writeJournal(uint32_t offset, const uint8_t* data, size_t length);
+
+    /**
+     * @brief 读取日志文件
+     * @param offset 日志文件中的偏移
+     * @param data 输出缓冲区
+     * @param length 长度
+     * @return true 读取成功
+     * @return false 读取失败
+     */
+    bool readJournal(uint32_t offset, uint8_t* data, size_t length);
+
+    /**
+     * @brief 日志文件中的扇区对应的分区偏移
+     * @param fileSector 日志文件中的扇区号
+     * @return uint32_t 分区内偏移
+     */
+    uint32_t journalSectorOffset(uint32_t fileSector) const;
+
+    /**
+     * @brief 读取任意范围
+     * @param offset 分区内偏移
+     * @param data 输出缓冲区
+     * @param length 长度
+     * @return true 读取成功
+     * @return false 读取失败
+     */
+    bool readRange(uint32_t offset, uint8_t* data, size_t length);
+
+    /**
+     * @brief 擦除扇区
+     * @param sector 扇区号
+     * @return true 擦除成功
+     * @return false 擦除失败
+     */
+    bool eraseSector(uint32_t sector);
+
+    /**
+     * @brief 数据库页面写入前持久化日志起始扇区与大小，保证被覆盖页面的原内容可回滚
+     * @return true 成功
+     * @return false 失败
+     */
+    bool persistJournalSize();
+
+    /**
+     * @brief 数据库大小变化后持久化（同步、关闭及事务结束删除日志时调用）
+     * @return true 成功
+     * @return false 失败
+     */
+    bool persistDatabaseSize();
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+    // SQLite回调（定义于flash_vfs.cpp）
+    friend struct FlashVfsCallbacks;
+
+private:
+    const esp_partition_t* partition;   ///< 数据库分区
+    sqlite3_vfs vfs;                    ///< 注册给SQLite的VFS
+    sqlite3_vfs* defaultVfs;            ///< 处理其他文件的默认VFS
+    uint8_t* sectorBuffer;              ///< 读-改-写用的扇区缓冲区
+    bool mounted;                       ///< 是否已挂载
+    bool registered;                    ///< VFS是否已注册
+    bool debugMode;                     ///< 调试模式
+    String mainName;                    ///< 打开的主数据库文件名
+    bool mainOpen;                      ///< 主数据库是否已打开
+    uint32_t superblockSeq;             ///< 最新超级块序号
+    uint32_t journalLogSeq;             ///< 最新日志长度记录序号
+    uint32_t journalLogSector;          ///< 当前追加的日志长度记录扇区（0或1）
+    uint32_t journalLogOffset;          ///< 当前扇区内的追加位置
+    uint32_t journalStart;              ///< 回滚日志的起始扇区（日志区内编号）
+    uint32_t persistedJournalStart;     ///< 长度日志中记录的起始扇区
+    uint32_t dbSize;                    ///< 数据库当前大小
+    uint32_t persistedDbSize;           ///< 超级块中记录的数据库大小
+    uint32_t journalSize;               ///< 回滚日志当前大小
+    uint32_t persistedJournalSize;      ///< 长度日志中记录的日志大小
+    uint32_t dbRegionOffset;            ///< 数据库区域在分区内的偏移
+    uint32_t dbCapacity;                ///< 数据库区域容量
+    uint32_t pageSize;                  ///< 数据库头中的页面大小（0表示未读取）
+    FlashVfsStats stats;                ///< 写入统计
+    String lastError;                   ///< 最后的错误信息
+};
+
+#endif // FLASH_VFS_H
@@ -8,22 +8,29 @@
 #include "gsm_service.h"
 #include "config_manager.h"
 #include "log_manager.h"
+#include "../at_command_handler/at_command_handler.h"
 #include "../../include/config.h"
 #include "../../include/constants.h"
 #include <Arduino.h>
 #include <time.h>
 
-// 外部串口对象
-extern HardwareSerial simSerial;
-
 /**
  * @brief 构造函数
+ * @param atHandler 所属SIM模块的AT命令处理器
  */
-GsmService::GsmService() : 
+GsmService::GsmService(AtCommandHandler& atHandler) : 
+    atHandler(atHandler),
     moduleStatus(GSM_MODULE_OFFLINE),
     lastError(""),
     smsCenterNumber(""),
     initialized(false) {
+    status.valid = false;
+    status.online = false;
+    status.simReady = false;
+    status.networkStatus = GSM_NETWORK_UNKNOWN;
+    status.signalStrength = -1;
+    status.refreshedAt = 0;
+    status.networkUpdatedAt = 0;
 }
 
 /**
@@ -34,12 +41,29 @@ GsmService::~GsmService() {
 }
 
 /**
- * @brief 获取单例实例
- * @return GsmService& 单例引用
+ * @brief 获取主SIM模块的GSM服务
+ * @return GsmService& 实例引用
  */
 GsmService& GsmService::getInstance() {
-    static GsmService instance;
-    return instance;
+    return getModem(0);
+}
+
+/**
+ * @brief 获取指定SIM模块的GSM服务
+ * @param index 模块序号
+ * @return GsmService& 实例引用
+ */
+GsmService& GsmService::getModem(uint8_t index) {
+    static GsmService* const instances[SIM_MODEM_COUNT] = {
+        new GsmService(AtCommandHandler::getModem(0)),
+#if SIM_MODEM_COUNT > 1
+        new GsmService(AtCommandHandler::getModem(1)),
+#endif
+#if SIM_MODEM_COUNT > 2
+        new GsmService(AtCommandHandler::getModem(2)),
+#endif
+    };
+    return *instances[index < SIM_MODEM_COUNT ? index : 0];
 }
 
 /**
@@ -54,14 +78,13 @@ bool GsmService::initialize() {
     
     Serial.println("正在初始化GSM服务...");
     
-    // 获取配置
-    ConfigManager& configManager = ConfigManager::getInstance();
-    GsmConfig gsmConfig = configManager.getGsmConfig();
-    
     moduleStatus = GSM_MODULE_INITIALIZING;
     
     // 显示串口配置信息
-    Serial.printf("串口配置: 波特率=%d, RX引脚=%d, TX引脚=%d\n", SIM_BAUD_RATE, SIM_RX_PIN, SIM_TX_PIN);
+    uint8_t modem = atHandler.getArbiter().getIndex();
+    static const int RX_PINS[MODEM_MAX_COUNT] = { SIM_RX_PIN, SIM2_RX_PIN, SIM3_RX_PIN };
+    static const int TX_PINS[MODEM_MAX_COUNT] = { SIM_TX_PIN, SIM2_TX_PIN, SIM3_TX_PIN };
+    Serial.printf("SIM%d串口配置: 波特率=%d, RX引脚=%d, TX引脚=%d\n", modem + 1, SIM_BAUD_RATE, RX_PINS[modem], TX_PINS[modem]);
     
     // 清空串口缓冲区
     clearSerialBuffer();
@@ -78,16 +101,9 @@ bool GsmService::initialize() {
         // 彻底清空缓冲区
         clearSerialBuffer();
         
-        // 发送简单的AT命令，使用改进的发送方法
-        simSerial.print("AT\r\n");
-        simSerial.flush();
+        // 发送简单的AT命令
         Serial.println("发送: AT");
-        
-        // 等待模块处理
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-        
-        // 等待响应
-        String response = waitForResponse(DEFAULT_GSM_INIT_TIMEOUT_MS); // 增加超时时间
+        String response = sendAtCommandWithResponse("AT", DEFAULT_GSM_INIT_TIMEOUT_MS);
         Serial.printf("收到响应: '%s'\n", response.c_str());
         
         if (response.indexOf("OK") != -1) {
@@ -106,8 +122,8 @@ bool GsmService::initialize() {
     if (!moduleResponding) {
         Serial.println("⚠️ 模块无响应，尝试硬件复位...");
         
-        // 尝试硬件复位（如果DTR引脚已连接）
-        if (DTR_PIN != -1) {
+        // 尝试硬件复位（DTR引脚只连接主模块）
+        if (DTR_PIN != -1 && modem == 0) {
             pinMode(DTR_PIN, OUTPUT);
             digitalWrite(DTR_PIN, HIGH);
             vTaskDelay(1000 / portTICK_PERIOD_MS);
@@ -116,11 +132,7 @@ bool GsmService::initialize() {
             
             // 复位后再次尝试通信
             clearSerialBuffer();
-            simSerial.print("AT\r\n");
-            simSerial.flush();
-            vTaskDelay(500 / portTICK_PERIOD_MS);
-            
-            String resetResponse = waitForResponse(DEFAULT_GSM_INIT_TIMEOUT_MS);
+            String resetResponse = sendAtCommandWithResponse("AT", DEFAULT_GSM_INIT_TIMEOUT_MS);
             if (resetResponse.indexOf("OK") != -1) {
                 Serial.println("✓ 硬件复位后模块响应正常");
                 moduleResponding = true;
@@ -201,30 +213,18 @@ bool GsmService::initialize() {
  * @return false 命令执行失败
  */
 bool GsmService::sendAtCommand(const String& command, const String& expectedResponse, unsigned long timeout) {
-    // 清空缓冲区
-    clearSerialBuffer();
-    
-    // 发送命令前等待，确保模块准备就绪
-    vTaskDelay(200 / portTICK_PERIOD_MS);
-    
-    // 发送命令
-    simSerial.print(command);
-    simSerial.print("\r\n");
-    simSerial.flush(); // 确保数据发送完毕
     Serial.printf("发送AT命令: %s\n", command.c_str());
     
-    // 发送命令后等待，让模块开始处理
-    vTaskDelay(300 / portTICK_PERIOD_MS);
-    
-    String response = waitForResponse(timeout);
+    // 串口由仲裁器独占，命令以事务形式排队执行
+    AtResponse response = atHandler.sendCommand(command, expectedResponse, timeout);
     
-    if (response.indexOf(expectedResponse) != -1) {
-        Serial.printf("AT命令成功，响应: %s\n", response.c_str());
+    if (response.result == AT_RESULT_SUCCESS) {
+        Serial.printf("AT命令成功，响应: %s\n", response.response.c_str());
         return true;
     }
     
-    Serial.printf("AT命令失败，超时或响应不匹配。收到: %s\n", response.c_str());
-    setError("AT命令失败: " + command + ", 响应: " + response);
+    Serial.printf("AT命令失败，超时或响应不匹配。收到: %s\n", response.response.c_str());
+    setError("AT命令失败: " + command + ", 响应: " + response.response);
     return false;
 }
 
@@ -235,22 +235,13 @@ bool GsmService::sendAtCommand(const String& command, const String& expectedResp
  * @return String 响应内容
  */
 String GsmService::sendAtCommandWithResponse(const String& command, unsigned long timeout) {
-    // 清空缓冲区
-    clearSerialBuffer();
-    
-    // 发送命令前等待，确保模块准备就绪
-    vTaskDelay(200 / portTICK_PERIOD_MS);
-    
-    // 发送命令
-    simSerial.print(command);
-    simSerial.print("\r\n");
-    simSerial.flush(); // 确保数据发送完毕
     Serial.printf("发送AT命令: %s\n", command.c_str());
     
-    // 发送命令后等待，让模块开始处理
-    vTaskDelay(300 / portTICK_PERIOD_MS);
-    
-    return waitForResponse(timeout);
+    AtResponse response = atHandler.sendCommandWithFullResponse(command, timeout);
+    if (response.result == AT_RESULT_TIMEOUT) {
+        Serial.println("超时：未收到任何数据");
+    }
+    return response.response;
 }
 
 /**
@@ -259,7 +250,9 @@ String GsmService::sendAtCommandWithResponse(const String& command, unsigned lon
  * @return false 模块离线
  */
 bool GsmService::isModuleOnline() {
-    return sendAtCommand("AT", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    bool online = sendAtCommand("AT", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    storeOnline(online);
+    return online;
 }
 
 /**
@@ -268,7 +261,9 @@ bool GsmService::isModuleOnline() {
  */
 GsmNetworkStatus GsmService::getNetworkStatus() {
     String response = sendAtCommandWithResponse("AT+CREG?", DEFAULT_AT_COMMAND_TIMEOUT_MS);
-    return parseNetworkStatus(response);
+    GsmNetworkStatus networkStatus = parseNetworkStatus(response);
+    storeNetworkStatus(networkStatus);
+    return networkStatus;
 }
 
 /**
@@ -321,24 +316,11 @@ bool GsmService::waitForNetworkRegistration(unsigned long timeout) {
  */
 int GsmService::getSignalStrength() {
     String response = sendAtCommandWithResponse("AT+CSQ", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    int rssi = parseSignalStrength(response);
     
-    // 解析响应 +CSQ: <rssi>,<ber>
-    int csqIndex = response.indexOf("+CSQ:");
-    if (csqIndex != -1) {
-        int commaIndex = response.indexOf(',', csqIndex);
-        if (commaIndex != -1) {
-            String rssiStr = response.substring(csqIndex + 6, commaIndex);
-            rssiStr.trim();
-            int rssi = rssiStr.toInt();
-            
-            // RSSI值范围: 0-31 (99表示未知)
-            if (rssi >= 0 && rssi <= 31) {
-                return rssi;
-            }
-        }
-    }
-    
-    return -1; // 获取失败
+    std::lock_guard<std::mutex> lock(statusMutex);
+    status.signalStrength = rssi;
+    return rssi;
 }
 
 /**
@@ -348,7 +330,79 @@ int GsmService::getSignalStrength() {
  */
 bool GsmService::isSimCardReady() {
     String response = sendAtCommandWithResponse("AT+CPIN?", DEFAULT_AT_COMMAND_TIMEOUT_MS);
-    return response.indexOf("+CPIN: READY") != -1;
+    bool ready = response.indexOf("+CPIN: READY") != -1;
+    
+    std::lock_guard<std::mutex> lock(statusMutex);
+    status.simReady = ready;
+    return ready;
+}
+
+/**
+ * @brief 获取模块状态快照（只复制缓存，不访问串口）
+ * @return ModemStatus 状态快照
+ */
+ModemStatus GsmService::getStatusSnapshot() {
+    std::lock_guard<std::mutex> lock(statusMutex);
+    return status;
+}
+
+/**
+ * @brief 获取模块状态，快照过期时先同步刷新
+ * @param maxAgeMs 可接受的快照最大时长（毫秒）
+ * @return ModemStatus 状态快照
+ */
+ModemStatus GsmService::getStatus(unsigned long maxAgeMs) {
+    ModemStatus snapshot = getStatusSnapshot();
+    if (snapshot.valid && millis() - snapshot.refreshedAt < maxAgeMs) {
+        return snapshot;
+    }
+    refreshStatus();
+    return getStatusSnapshot();
+}
+
+/**
+ * @brief 以一条拼接命令查询SIM卡、网络注册与信号强度并更新快照
+ * @return true 模块有响应
+ * @return false 模块无响应
+ */
+bool GsmService::refreshStatus() {
+    
+    // 三个查询拼成一行，只占用一次串口事务
+    AtResponse response = atHandler.sendCommandWithFullResponse("AT+CPIN?;+CREG?;+CSQ", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    bool online = response.result != AT_RESULT_TIMEOUT;
+    String text = response.response;
+    bool simReady = text.indexOf("+CPIN: READY") != -1;
+    
+    // SIM卡未就绪时模块在+CPIN?处报错并停止执行后续命令，单独补查注册状态与信号
+    if (online && text.indexOf("+CSQ:") == -1) {
+        text += atHandler.sendCommandWithFullResponse("AT+CREG?;+CSQ", DEFAULT_AT_COMMAND_TIMEOUT_MS).response;
+    }
+    
+    GsmNetworkStatus networkStatus = online ? parseNetworkStatus(text) : GSM_NETWORK_UNKNOWN;
+    int signalStrength = online ? parseSignalStrength(text) : -1;
+    
+    std::lock_guard<std::mutex> lock(statusMutex);
+    unsigned long now = millis();
+    status.valid = true;
+    status.online = online;
+    status.simReady = simReady;
+    status.networkStatus = networkStatus;
+    status.signalStrength = signalStrength;
+    status.refreshedAt = now;
+    status.networkUpdatedAt = now;
+    return online;
+}
+
+/**
+ * @brief 以网络注册上报更新快照
+ * @param stat 上报中的注册状态值（3GPP 27.007 <stat>）
+ */
+void GsmService::updateNetworkRegistration(int stat) {
+    std::lock_guard<std::mutex> lock(statusMutex);
+    // 收到上报说明模块在线；完整刷新时间不变，其余字段仍按周期刷新
+    status.online = true;
+    status.networkStatus = networkStatusFromCode(stat);
+    status.networkUpdatedAt = millis();
 }
 
 /**
@@ -476,28 +530,11 @@ bool GsmService::resetModule() {
 
 /**
  * @brief 清空串口缓冲区
+ * 
+ * 串口由仲裁器独占，这里只丢弃仲裁器暂存的主动上报数据
  */
 void GsmService::clearSerialBuffer() {
-    // 更彻底的缓冲区清理
-    unsigned long startTime = millis();
-    int bytesCleared = 0;
-    
-    // 清理接收缓冲区
-    while (simSerial.available() && (millis() - startTime < 1000)) {
-        simSerial.read();
-        bytesCleared++;
-        vTaskDelay(1);
-    }
-    
-    // 确保发送缓冲区也被清空
-    simSerial.flush();
-    
-    // 额外等待，确保模块处理完毕
-    vTaskDelay(100 / portTICK_PERIOD_MS);
-    
-    if (bytesCleared > 0) {
-        Serial.printf("清理了 %d 字节的缓冲区数据\n", bytesCleared);
-    }
+    atHandler.clearBuffer();
 }
 
 /**
@@ -513,18 +550,19 @@ GsmNetworkStatus GsmService::parseNetworkStatus(const String& response) {
         // 查找第一个逗号（分隔n和stat）
         int firstCommaIndex = response.indexOf(',', cregIndex);
         if (firstCommaIndex != -1) {
-            // 查找第二个逗号（分隔stat和lac，如果存在）
+            // 查找第二个逗号（分隔stat和lac，如果存在）；只在本行内查找，拼接查询的响应中其后还有其他结果
+            int lineEnd = response.indexOf('\n', firstCommaIndex);
+            if (lineEnd == -1) lineEnd = response.length();
             int secondCommaIndex = response.indexOf(',', firstCommaIndex + 1);
             
             // 确定状态值的结束位置
             int statusEnd;
-            if (secondCommaIndex != -1) {
+            if (secondCommaIndex != -1 && secondCommaIndex < lineEnd) {
                 // 扩展格式：+CREG: <n>,<stat>,<lac>,<ci>
                 statusEnd = secondCommaIndex;
             } else {
                 // 基本格式：+CREG: <n>,<stat>
-                statusEnd = response.indexOf('\n', firstCommaIndex);
-                if (statusEnd == -1) statusEnd = response.length();
+                statusEnd = lineEnd;
             }
             
             // 提取状态值
@@ -535,14 +573,7 @@ GsmNetworkStatus GsmService::parseNetworkStatus(const String& response) {
             // 调试输出
             Serial.printf("解析CREG响应: %s, 状态值: %d\n", response.c_str(), status);
             
-            switch (status) {
-                case 0: return GSM_NETWORK_NOT_REGISTERED;
-                case 1: return GSM_NETWORK_REGISTERED_HOME;
-                case 2: return GSM_NETWORK_SEARCHING;
-                case 3: return GSM_NETWORK_REGISTRATION_DENIED;
-                case 5: return GSM_NETWORK_REGISTERED_ROAMING;
-                default: return GSM_NETWORK_UNKNOWN;
-            }
+            return networkStatusFromCode(status);
         }
     }
     
@@ -550,109 +581,72 @@ GsmNetworkStatus GsmService::parseNetworkStatus(const String& response) {
 }
 
 /**
- * @brief 设置错误信息
- * @param error 错误信息
+ * @brief 将注册状态值转换为网络状态
+ * @param stat 注册状态值
+ * @return GsmNetworkStatus 网络状态
  */
-void GsmService::setError(const String& error) {
-    lastError = error;
-    Serial.printf("GSM服务错误: %s\n", error.c_str());
+GsmNetworkStatus GsmService::networkStatusFromCode(int stat) {
+    switch (stat) {
+        case 0: return GSM_NETWORK_NOT_REGISTERED;
+        case 1: return GSM_NETWORK_REGISTERED_HOME;
+        case 2: return GSM_NETWORK_SEARCHING;
+        case 3: return GSM_NETWORK_REGISTRATION_DENIED;
+        case 5: return GSM_NETWORK_REGISTERED_ROAMING;
+        default: return GSM_NETWORK_UNKNOWN;
+    }
 }
 
 /**
- * @brief 等待串口响应
- * @param timeout 超时时间（毫秒）
- * @return String 响应内容
+ * @brief 解析信号强度响应
+ * @param response AT+CSQ的响应
+ * @return int 信号强度值（-1表示无法解析或未知）
  */
-String GsmService::waitForResponse(unsigned long timeout) {
-    unsigned long startTime = millis();
-    String response = "";
-    String line = "";
-    bool dataReceived = false;
-    
-    Serial.printf("等待响应，超时时间: %lu ms\n", timeout);
-    
-    while (millis() - startTime < timeout) {
-        if (simSerial.available()) {
-            if (!dataReceived) {
-                dataReceived = true;
-                Serial.println("开始接收数据...");
-            }
-            
-            char c = simSerial.read();
-            response += c;
-            
-            // 简化调试输出，只显示可打印字符
-            if (c >= 32 && c <= 126) {
-                Serial.printf("%c", c);
-            } else if (c == '\n') {
-                Serial.print("\n");
-            }
+int GsmService::parseSignalStrength(const String& response) {
+    // 解析响应 +CSQ: <rssi>,<ber>
+    int csqIndex = response.indexOf("+CSQ:");
+    if (csqIndex != -1) {
+        int commaIndex = response.indexOf(',', csqIndex);
+        if (commaIndex != -1) {
+            String rssiStr = response.substring(csqIndex + 6, commaIndex);
+            rssiStr.trim();
+            int rssi = rssiStr.toInt();
             
-            // 处理每一行
-            if (c == '\n') {
-                line.trim();
-                
-                // 检查是否收到结束标志
-                if (line == "OK" || line == "ERROR" || 
-                    line.startsWith("ERROR:") || line.startsWith("+CME ERROR:") || 
-                    line.startsWith("+CMS ERROR:")) {
-                    // 收到结束标志，立即返回
-                    Serial.printf("\n收到结束标志: %s\n", line.c_str());
-                    return response;
-                }
-                
-                // 对于某些命令，特定的响应行可以作为结束标志（关闭回显后可能不返回OK）
-                if (line.startsWith("+CPIN:") || line.startsWith("+CREG:") || 
-                    line.startsWith("+CSQ:") || line.startsWith("+CIMI")) {
-                    Serial.printf("\n收到有效响应: %s\n", line.c_str());
-                    // 等待一小段时间看是否还有OK，如果没有就直接返回
-                    unsigned long waitStart = millis();
-                    bool foundOK = false;
-                    while (millis() - waitStart < 500) { // 等待500ms
-                        if (simSerial.available()) {
-                            char c = simSerial.read();
-                            response += c;
-                            if (c == '\n') {
-                                String tempLine = "";
-                                // 从response末尾向前找到最后一行
-                                int lastLF = response.lastIndexOf('\n', response.length() - 2);
-                                if (lastLF != -1) {
-                                    tempLine = response.substring(lastLF + 1);
-                                    tempLine.trim();
-                                    if (tempLine == "OK") {
-                                        foundOK = true;
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                        vTaskDelay(1);
-                    }
-                    if (foundOK) {
-                        Serial.println("\n收到OK确认");
-                    } else {
-                        Serial.println("\n未收到OK，但有效响应已接收");
-                    }
-                    return response;
-                }
-                
-                // 重置行缓冲
-                line = "";
-            } else if (c != '\r') {
-                // 忽略回车符，只处理换行符
-                line += c;
+            // RSSI值范围: 0-31 (99表示未知)
+            if (rssi >= 0 && rssi <= 31) {
+                return rssi;
             }
         }
-        vTaskDelay(1);
-    }
-    
-    if (!dataReceived) {
-        Serial.println("超时：未收到任何数据");
-    } else {
-        Serial.println("\n超时：数据接收不完整");
     }
     
-    return response;
+    return -1; // 获取失败
+}
+
+/**
+ * @brief 记录模块是否响应
+ * @param online 是否在线
+ */
+void GsmService::storeOnline(bool online) {
+    std::lock_guard<std::mutex> lock(statusMutex);
+    status.online = online;
+}
+
+/**
+ * @brief 记录网络注册状态
+ * @param networkStatus 网络状态
+ */
+void GsmService::storeNetworkStatus(GsmNetworkStatus networkStatus) {
+    std::lock_guard<std::mutex> lock(statusMutex);
+    status.networkStatus = networkStatus;
+    status.networkUpdatedAt = millis();
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void GsmService::setError(const String& error) {
+    lastError = error;
+    Serial.printf("GSM服务错误: %s\n", error.c_str());
 }
 
 /**
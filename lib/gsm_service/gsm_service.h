@@ -9,14 +9,18 @@
  * 2. 网络注册状态管理
  * 3. 模块状态监控
  * 4. 基础配置管理
+ * 5. 维护模块状态快照：定期批量查询并随网络注册上报更新，读取方无需访问串口
  */
 
 #ifndef GSM_SERVICE_H
 #define GSM_SERVICE_H
 
 #include <Arduino.h>
+#include <mutex>
 #include "../../include/constants.h"
 
+class AtCommandHandler;
+
 /**
  * @enum GsmNetworkStatus
  * @brief GSM网络状态枚举
@@ -41,6 +45,29 @@ enum GsmModuleStatus {
     GSM_MODULE_INITIALIZING ///< 模块初始化中
 };
 
+/**
+ * @struct ModemStatus
+ * @brief 模块状态快照
+ */
+struct ModemStatus {
+    bool valid;                             ///< 是否已有数据（false表示从未查询）
+    bool online;                            ///< 模块是否响应AT命令
+    bool simReady;                          ///< SIM卡是否就绪
+    GsmNetworkStatus networkStatus;         ///< 网络注册状态
+    int signalStrength;                     ///< 信号强度（0-31，-1表示未知）
+    unsigned long refreshedAt;              ///< 最近一次完整查询的时间（millis）
+    unsigned long networkUpdatedAt;         ///< 网络注册状态最近更新的时间（含上报，millis）
+    
+    /**
+     * @brief 是否已注册到网络（本地或漫游）
+     * @return true 已注册
+     * @return false 未注册或未知
+     */
+    bool isRegistered() const {
+        return networkStatus == GSM_NETWORK_REGISTERED_HOME || networkStatus == GSM_NETWORK_REGISTERED_ROAMING;
+    }
+};
+
 /**
  * @class GsmService
  * @brief GSM基础服务类
@@ -51,8 +78,9 @@ class GsmService {
 public:
     /**
      * @brief 构造函数
+     * @param atHandler 所属SIM模块的AT命令处理器
      */
-    GsmService();
+    explicit GsmService(AtCommandHandler& atHandler);
     
     /**
      * @brief 析构函数
@@ -118,6 +146,32 @@ public:
      */
     bool isSimCardReady();
     
+    /**
+     * @brief 获取模块状态快照（只复制缓存，不访问串口）
+     * @return ModemStatus 状态快照
+     */
+    ModemStatus getStatusSnapshot();
+    
+    /**
+     * @brief 获取模块状态，快照过期时先同步刷新
+     * @param maxAgeMs 可接受的快照最大时长（毫秒）
+     * @return ModemStatus 状态快照
+     */
+    ModemStatus getStatus(unsigned long maxAgeMs = MODEM_STATUS_MAX_AGE_MS);
+    
+    /**
+     * @brief 以一条拼接命令查询SIM卡、网络注册与信号强度并更新快照
+     * @return true 模块有响应
+     * @return false 模块无响应
+     */
+    bool refreshStatus();
+    
+    /**
+     * @brief 以网络注册上报更新快照
+     * @param stat 上报中的注册状态值（3GPP 27.007 <stat>）
+     */
+    void updateNetworkRegistration(int stat);
+    
     /**
      * @brief 获取IMSI号码
      * @return String IMSI号码，失败返回空字符串
@@ -182,18 +236,28 @@ public:
     unsigned long getUnixTimestamp();
     
     /**
-     * @brief 获取单例实例
-     * @return GsmService& 单例引用
+     * @brief 获取主SIM模块的GSM服务
+     * @return GsmService& 实例引用
      */
     static GsmService& getInstance();
     
+    /**
+     * @brief 获取指定SIM模块的GSM服务
+     * @param index 模块序号（0为主模块，超出SIM_MODEM_COUNT时返回主模块）
+     * @return GsmService& 实例引用
+     */
+    static GsmService& getModem(uint8_t index);
+    
     // 公共成员变量（供其他模块访问）
     String smsCenterNumber;        ///< 短信中心号码（缓存，避免重复获取）
 
 private:
+    AtCommandHandler& atHandler;    ///< 所属SIM模块的AT命令处理器
     GsmModuleStatus moduleStatus;   ///< 模块状态
     String lastError;              ///< 最后的错误信息
     bool initialized;              ///< 是否已初始化
+    ModemStatus status;            ///< 模块状态快照
+    std::mutex statusMutex;        ///< 保护status
     
     /**
      * @brief 解析网络注册状态响应
@@ -203,17 +267,36 @@ private:
     GsmNetworkStatus parseNetworkStatus(const String& response);
     
     /**
-     * @brief 设置错误信息
-     * @param error 错误信息
+     * @brief 将注册状态值转换为网络状态
+     * @param stat 注册状态值
+     * @return GsmNetworkStatus 网络状态
      */
-    void setError(const String& error);
+    static GsmNetworkStatus networkStatusFromCode(int stat);
     
     /**
-     * @brief 等待串口响应
-     * @param timeout 超时时间（毫秒）
-     * @return String 响应内容
+     * @brief 解析信号强度响应
+     * @param response AT+CSQ的响应
+     * @return int 信号强度值（-1表示无法解析或未知）
+     */
+    static int parseSignalStrength(const String& response);
+    
+    /**
+     * @brief 记录模块是否响应
+     * @param online 是否在线
+     */
+    void storeOnline(bool online);
+    
+    /**
+     * @brief 记录网络注册状态
+     * @param networkStatus 网络状态
+     */
+    void storeNetworkStatus(GsmNetworkStatus networkStatus);
+    
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
      */
-    String waitForResponse(unsigned long timeout);
+    void setError(const String& error);
 };
 
 #endif // GSM_SERVICE_H
\ No newline at end of file
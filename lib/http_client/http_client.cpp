@@ -7,8 +7,76 @@
 
 #include "http_client.h"
 #include "gsm_service.h"
+#include "../../include/config.h"
 #include "../../include/constants.h"
+#include "../modem_arbiter/modem_arbiter.h"
+#include "native_http_transport.h"
+#include "../metrics/metrics.h"
+#include "../sms_trace/sms_trace.h"
+#include "../log_manager/log_manager.h"
 #include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <atomic>
+
+namespace {
+
+/**
+ * @struct BodyStream
+ * @brief 流式请求体的写入进度（供仲裁任务中的写入回调使用）
+ */
+struct BodyStream {
+    const HttpBodyWriter* writer;   ///< 请求体写入回调
+    size_t length;                  ///< 请求体总长度
+    size_t offset;                  ///< 已写入的长度
+};
+
+/**
+ * @brief 仲裁器载荷写入回调：从请求体写入回调取下一块数据
+ * @param context BodyStream指针
+ * @param buffer 输出缓冲区
+ * @param capacity 缓冲区容量
+ * @return size_t 写入的字节数，0表示结束
+ */
+size_t writeBodyChunk(void* context, uint8_t* buffer, size_t capacity) {
+    BodyStream* stream = static_cast<BodyStream*>(context);
+    if (stream->offset >= stream->length) {
+        return 0;
+    }
+    size_t remaining = stream->length - stream->offset;
+    size_t written = (*stream->writer)(stream->offset, buffer, remaining < capacity ? remaining : capacity);
+    stream->offset += written;
+    return written;
+}
+
+/**
+ * @struct BodySink
+ * @brief 响应体的读取进度（供仲裁任务中的读取回调使用）
+ */
+struct BodySink {
+    const HttpBodyReader* reader;   ///< 响应体读取回调
+    size_t received;                ///< 本次AT+HTTPREAD收到的长度
+    bool stopped;                   ///< 读取回调要求不再接收
+};
+
+/**
+ * @brief 仲裁器数据段读取回调：把"+HTTPREAD: <n>"之后的原始字节交给响应体读取回调
+ * @param context BodySink指针
+ * @param data 数据
+ * @param length 数据长度
+ * @return true 继续接收
+ * @return false 不再接收
+ */
+bool readBodyChunk(void* context, const uint8_t* data, size_t length) {
+    BodySink* sink = static_cast<BodySink*>(context);
+    sink->received += length;
+    if (!(*sink->reader)((const char*)data, length)) {
+        sink->stopped = true;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
 
 /**
  * @brief 构造函数
@@ -18,8 +86,11 @@
 HttpClient::HttpClient(AtCommandHandler& atHandler, GsmService& gsmService) 
     : atCommandHandler(atHandler), gsmService(gsmService), lastError(""), 
       debugMode(false), initialized(false), httpServiceActive(false), 
-      defaultTimeout(DEFAULT_HTTP_TIMEOUT_MS), debugLog(""), maxLogSize(8192), 
-      requestCount(0), lastLogTime(0) {
+      defaultTimeout(DEFAULT_HTTP_TIMEOUT_MS), sessionMode(true), sessionStale(false),
+      sessionSslBound(false), sslContextState(-1), lastActivityAt(0),
+      cachedNetworkState(-1), networkCheckedAt(0), cachedPdpState(-1), pdpCheckedAt(0),
+      statusUrcQueue(nullptr), preferredTransport(&NativeHttpTransport::getInstance()), loadBalanced(false), debugRing(nullptr),
+      debugRingWritten(0), requestCount(0), lastLogTime(0) {
     // 构造函数实现
 }
 
@@ -30,20 +101,32 @@ HttpClient::~HttpClient() {
     if (httpServiceActive) {
         terminateHttpService();
     }
+    heap_caps_free(debugRing);
 }
 
 /**
- * @brief 获取单例实例
- * @return HttpClient& 单例引用
+ * @brief 获取主SIM模块的HTTP客户端
+ * @return HttpClient& 实例引用
  */
 HttpClient& HttpClient::getInstance() {
-    static HttpClient* instance = nullptr;
-    if (!instance) {
-        AtCommandHandler& atHandler = AtCommandHandler::getInstance();
-        GsmService& gsmSvc = GsmService::getInstance();
-        instance = new HttpClient(atHandler, gsmSvc);
-    }
-    return *instance;
+    return getModem(0);
+}
+
+/**
+ * @brief 获取指定SIM模块的HTTP客户端
+ * @param index 模块序号
+ * @return HttpClient& 实例引用
+ */
+HttpClient& HttpClient::getModem(uint8_t index) {
+    static HttpClient* const* instances = []() {
+        static HttpClient* clients[SIM_MODEM_COUNT];
+        for (uint8_t i = 0; i < SIM_MODEM_COUNT; i++) {
+            clients[i] = new HttpClient(AtCommandHandler::getModem(i), GsmService::getModem(i));
+            clients[i]->loadBalanced = true;
+        }
+        return clients;
+    }();
+    return *instances[index < SIM_MODEM_COUNT ? index : 0];
 }
 
 /**
@@ -56,12 +139,15 @@ bool HttpClient::initialize() {
         return true;
     }
     
-    debugPrint("正在初始化HTTP客户端...");
+    LOG_DEBUG_PRINT("正在初始化HTTP客户端...");
+    
+    // 网络注册与PDP变化由模块主动上报，状态缓存据此更新
+    subscribeStatusUrcs();
     
     // 检查AT命令处理器是否已初始化
     if (!atCommandHandler.getLastError().isEmpty() && atCommandHandler.getLastError() != "") {
         // AT命令处理器可能有错误，但我们继续尝试
-        debugPrint("警告: AT命令处理器可能存在问题: " + atCommandHandler.getLastError());
+        LOG_DEBUG_PRINT("警告: AT命令处理器可能存在问题: " + atCommandHandler.getLastError());
     }
     
     // 检查网络连接
@@ -79,7 +165,7 @@ bool HttpClient::initialize() {
     }
     
     initialized = true;
-    debugPrint("HTTP客户端初始化完成");
+    LOG_DEBUG_PRINT("HTTP客户端初始化完成");
     return true;
 }
 
@@ -89,6 +175,64 @@ bool HttpClient::initialize() {
  * @return HttpResponse 响应结果
  */
 HttpResponse HttpClient::request(const HttpRequest& request) {
+    // 网络层失败时请求未完整发出，服务端不会处理，可以安全地改经模块重发
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    SmsTrace::mark(SMS_TRACE_HTTP);
+    if (preferredTransport != nullptr && preferredTransport->isAvailable()) {
+        HttpResponse response = preferredTransport->execute(request);
+        metrics.observe(METRIC_HTTP_REQUEST, (uint32_t)response.duration * 1000, preferredTransport->getName());
+        if (response.error != HTTP_ERROR_NETWORK) {
+            SmsTrace::mark(SMS_TRACE_HTTP_DONE);
+            return response;
+        }
+        LOG_DEBUG_PRINT(String(preferredTransport->getName()) + "传输失败，改经模块发送: " + preferredTransport->getLastError());
+    }
+    
+    HttpClient& modem = loadBalanced ? selectModem() : *this;
+    HttpResponse response = modem.requestViaModem(request);
+    metrics.observe(METRIC_HTTP_REQUEST, (uint32_t)response.duration * 1000, "modem");
+    SmsTrace::mark(SMS_TRACE_HTTP_DONE);
+    return response;
+}
+
+/**
+ * @brief 从下一个轮到的模块起，选择第一个有数据连接的模块
+ * @return HttpClient& 选中模块的HTTP客户端
+ */
+HttpClient& HttpClient::selectModem() {
+    static std::atomic<uint8_t> nextModem(0);
+    if (SIM_MODEM_COUNT == 1) {
+        return getModem(0);
+    }
+    
+    // 每次请求从下一个模块开始查找，推送工作线程的并发请求分摊到各模块
+    uint8_t start = nextModem.fetch_add(1) % SIM_MODEM_COUNT;
+    for (uint8_t i = 0; i < SIM_MODEM_COUNT; i++) {
+        HttpClient& candidate = getModem((start + i) % SIM_MODEM_COUNT);
+        if (candidate.hasDataConnectivity()) {
+            return candidate;
+        }
+    }
+    return getModem(0);
+}
+
+/**
+ * @brief 检查所属模块是否有数据连接
+ * @return true 模块在线且已注册网络
+ * @return false 无数据连接
+ */
+bool HttpClient::hasDataConnectivity() {
+    ModemStatus status = gsmService.getStatusSnapshot();
+    return status.valid && status.online && status.isRegistered();
+}
+
+/**
+ * @brief 经模块AT HTTP栈执行请求
+ * @param request 请求参数
+ * @return HttpResponse 响应结果
+ */
+HttpResponse HttpClient::requestViaModem(const HttpRequest& request) {
+    std::lock_guard<std::mutex> lock(requestMutex);
     HttpResponse response;
     unsigned long startTime = millis();
     const int maxRetries = 2;  // 最大重试次数（针对网络连接问题）
@@ -111,13 +255,13 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
     
     for (int attempt = 0; attempt <= maxRetries; attempt++) {
         if (attempt > 0) {
-            debugPrint("HTTP请求重试第 " + String(attempt) + " 次");
+            LOG_DEBUG_PRINT("HTTP请求重试第 " + String(attempt) + " 次");
             delay(retryDelay);
         }
         
         // 检查网络连接状态
         if (!isNetworkConnected()) {
-            debugPrint("网络未连接，尝试等待网络恢复...");
+            LOG_DEBUG_PRINT("网络未连接，尝试等待网络恢复...");
             
             // 等待网络恢复，最多等待10秒
             unsigned long networkWaitStart = millis();
@@ -127,7 +271,7 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
             
             if (!isNetworkConnected()) {
                 if (attempt < maxRetries) {
-                    debugPrint("网络仍未连接，将在 " + String(retryDelay) + " 毫秒后重试");
+                    LOG_DEBUG_PRINT("网络仍未连接，将在 " + String(retryDelay) + " 毫秒后重试");
                     continue;
                 } else {
                     response.error = HTTP_ERROR_NETWORK;
@@ -141,10 +285,10 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
         
         // 检查PDP上下文状态
         if (!isPdpContextActive()) {
-            debugPrint("PDP上下文未激活，尝试激活...");
+            LOG_DEBUG_PRINT("PDP上下文未激活，尝试激活...");
             if (!activatePdpContext()) {
                 if (attempt < maxRetries) {
-                    debugPrint("PDP上下文激活失败，将重试");
+                    LOG_DEBUG_PRINT("PDP上下文激活失败，将重试");
                     continue;
                 } else {
                     response.error = HTTP_ERROR_NETWORK;
@@ -164,10 +308,16 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
             return response;
         }
         
-        // 初始化HTTP服务
+        // 保留的会话空闲过久或PDP已断开时先关闭，重新初始化
+        if (httpServiceActive && (sessionStale || millis() - lastActivityAt >= HTTP_SESSION_IDLE_TIMEOUT_MS)) {
+            LOG_DEBUG_PRINT("HTTP会话已失效，重新初始化");
+            terminateHttpService();
+        }
+        
+        // 初始化HTTP服务（会话模式下已初始化时直接复用）
         if (!initHttpService()) {
             if (attempt < maxRetries) {
-                debugPrint("HTTP服务初始化失败，将重试");
+                LOG_DEBUG_PRINT("HTTP服务初始化失败，将重试");
                 continue;
             } else {
                 response.error = HTTP_ERROR_INIT;
@@ -177,13 +327,29 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
             }
         }
         
-        // 设置URL
-        if (!setHttpParameter("URL", request.url)) {
+        // 设置URL和请求头：所有AT+HTTPPARA合并为一行发送，只需一次往返
+        std::vector<std::pair<String, String>> parameters;
+        parameters.reserve(request.headers.size() + 2);
+        parameters.push_back(std::make_pair(String("URL"), request.url));
+        for (const auto& header : request.headers) {
+            parameters.push_back(std::make_pair(String("USERDATA"), header.first + ": " + header.second));
+        }
+        // 会话中HTTP参数会保留到下一次请求，没有请求头时清空上次的USERDATA
+        if (request.headers.empty() && sessionMode) {
+            parameters.push_back(std::make_pair(String("USERDATA"), String("")));
+        }
+        // SSL上下文只需在每个HTTP服务周期内绑定一次
+        bool bindSsl = detectProtocol(request.url) == HTTPS_PROTOCOL && !sessionSslBound && ensureSslContext();
+        if (bindSsl) {
+            parameters.push_back(std::make_pair(String("SSLCFG"), String(HTTP_SSL_CONTEXT_ID)));
+        }
+        
+        if (!setHttpParameters(parameters)) {
             response.error = HTTP_ERROR_AT_COMMAND;
             terminateHttpService();
             
             if (attempt < maxRetries) {
-                debugPrint("设置URL失败，将重试");
+                LOG_DEBUG_PRINT("设置HTTP参数失败，将重试");
                 continue;
             } else {
                 response.duration = millis() - startTime;
@@ -191,40 +357,23 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
                 return response;
             }
         }
-        
-        // 设置请求头
-        bool headerSetSuccess = true;
-        for (const auto& header : request.headers) {
-            String headerParam = header.first + ": " + header.second;
-            if (!setHttpParameter("USERDATA", headerParam)) {
-                debugPrint("设置请求头失败: " + headerParam);
-                headerSetSuccess = false;
-                break;
-            }
-        }
-        
-        if (!headerSetSuccess) {
-            terminateHttpService();
-            if (attempt < maxRetries) {
-                debugPrint("设置请求头失败，将重试");
-                continue;
-            } else {
-                response.error = HTTP_ERROR_AT_COMMAND;
-                setError("设置请求头失败");
-                return response;
-            }
+        if (bindSsl) {
+            sessionSslBound = true;
         }
         
         // 根据请求方法执行不同操作
         if (request.method == HTTP_CLIENT_POST || request.method == HTTP_CLIENT_PUT) {
             // POST/PUT请求需要先发送数据
-            if (!request.body.isEmpty()) {
-                if (!sendHttpData(request.body, request.timeout)) {
+            bool hasBody = request.bodyWriter ? request.bodyLength > 0 : !request.body.isEmpty();
+            if (hasBody) {
+                bool sent = request.bodyWriter ? sendHttpData(request.bodyLength, request.bodyWriter, request.timeout)
+                                               : sendHttpData(request.body, request.timeout);
+                if (!sent) {
                     response.error = HTTP_ERROR_AT_COMMAND;
                     terminateHttpService();
                     
                     if (attempt < maxRetries) {
-                        debugPrint("发送HTTP数据失败，将重试");
+                        LOG_DEBUG_PRINT("发送HTTP数据失败，将重试");
                         continue;
                     } else {
                         return response;
@@ -235,16 +384,26 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
         
         // 执行HTTP动作
         response = executeHttpAction(request.method, request.timeout);
+        SmsTrace::mark(SMS_TRACE_HTTP_ACTION);
         
         // 检查响应结果
         if (response.error == HTTP_SUCCESS) {
-            // 如果请求成功，读取响应内容
-            if (response.contentLength > 0) {
-                response.body = readHttpResponse(0, response.contentLength);
+            // 如果请求成功，读取响应内容（调用方只关心状态码时跳过）
+            if (response.contentLength > 0 && request.readBody) {
+                // 有上限时只从模块读取前maxBodyBytes字节，其余留在模块缓冲区中随会话结束丢弃
+                size_t readLength = response.contentLength;
+                if (request.maxBodyBytes > 0 && readLength > request.maxBodyBytes) {
+                    readLength = request.maxBodyBytes;
+                }
+                if (request.bodyReader) {
+                    streamHttpResponse(0, readLength, request.bodyReader);
+                } else {
+                    response.body = readHttpResponse(0, readLength);
+                }
             }
             
-            // 终止HTTP服务
-            terminateHttpService();
+            // 结束请求（会话模式下保留HTTP服务）
+            finishHttpService();
             
             response.duration = millis() - startTime;
             logResponseDetails(response);
@@ -254,7 +413,7 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
             terminateHttpService();
             
             if (attempt < maxRetries) {
-                debugPrint("HTTP请求失败（错误: " + String(response.error) + "），将重试");
+                LOG_DEBUG_PRINT("HTTP请求失败（错误: " + String(response.error) + "），将重试");
                 continue;
             }
         } else {
@@ -278,12 +437,14 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
  * @param body 请求体
  * @param headers 请求头（可选）
  * @param timeout 超时时间（可选）
+ * @param readBody 是否读取响应体
  * @return HttpResponse 响应结果
  */
 HttpResponse HttpClient::post(const String& url, 
                              const String& body,
                              const std::map<String, String>& headers,
-                             unsigned long timeout) {
+                             unsigned long timeout,
+                             bool readBody) {
     HttpRequest request;
     request.url = url;
     request.method = HTTP_CLIENT_POST;
@@ -291,21 +452,253 @@ HttpResponse HttpClient::post(const String& url,
     request.body = body;
     request.headers = headers;
     request.timeout = timeout;
+    request.readBody = readBody;
     
     return this->request(request);
 }
 
+/**
+ * @brief 执行POST请求，请求体由调用方持有（不复制为String，流式写出）
+ * @param url 请求URL
+ * @param body 请求体（请求返回前须保持有效）
+ * @param bodyLength 请求体长度
+ * @param headers 请求头
+ * @param timeout 超时时间
+ * @param readBody 是否读取响应体
+ * @return HttpResponse 响应结果
+ */
+HttpResponse HttpClient::post(const String& url,
+                             const char* body,
+                             size_t bodyLength,
+                             const std::map<String, String>& headers,
+                             unsigned long timeout,
+                             bool readBody) {
+    HttpRequest request;
+    request.url = url;
+    request.method = HTTP_CLIENT_POST;
+    request.protocol = detectProtocol(url);
+    request.bodyWriter = [body, bodyLength](size_t offset, uint8_t* buffer, size_t capacity) -> size_t {
+        size_t count = bodyLength - offset < capacity ? bodyLength - offset : capacity;
+        memcpy(buffer, body + offset, count);
+        return count;
+    };
+    request.bodyLength = bodyLength;
+    request.headers = headers;
+    request.timeout = timeout;
+    request.readBody = readBody;
+    
+    return this->request(request);
+}
+
+/**
+ * @brief 设置首选传输后端
+ * @param transport 传输后端（nullptr表示始终使用模块）
+ */
+void HttpClient::setPreferredTransport(HttpTransport* transport) {
+    preferredTransport = transport;
+}
+
+/**
+ * @brief 设置会话模式
+ * @param enabled 是否启用
+ */
+void HttpClient::setSessionMode(bool enabled) {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    sessionMode = enabled;
+    if (!enabled) {
+        terminateHttpService();
+    }
+}
+
+/**
+ * @brief 检查是否处于会话模式
+ * @return true 会话模式
+ * @return false 非会话模式
+ */
+bool HttpClient::isSessionMode() const {
+    return sessionMode;
+}
+
+/**
+ * @brief 关闭空闲超时的HTTP会话
+ * @return true 已关闭会话
+ * @return false 会话不存在、未超时或正忙
+ */
+bool HttpClient::closeIdleSession() {
+    std::unique_lock<std::mutex> lock(requestMutex, std::try_to_lock);
+    if (!lock.owns_lock() || !httpServiceActive) {
+        return false;
+    }
+    
+    if (millis() - lastActivityAt < HTTP_SESSION_IDLE_TIMEOUT_MS) {
+        return false;
+    }
+    
+    LOG_DEBUG_PRINT("HTTP会话空闲超时，终止HTTP服务");
+    terminateHttpService();
+    return true;
+}
+
+/**
+ * @brief 丢弃缓存的网络注册与PDP状态
+ */
+void HttpClient::invalidateStatusCache() {
+    cachedNetworkState = -1;
+    cachedPdpState = -1;
+}
+
+/**
+ * @brief 描述缓存的连接状态（只读取缓存，不发送AT命令）
+ * @return String 状态描述
+ */
+String HttpClient::describeCachedState() {
+    unsigned long now = millis();
+    String state = "网络: ";
+    if (cachedNetworkState < 0) {
+        state += "未知";
+    } else {
+        state += cachedNetworkState ? "已注册" : "未注册";
+        state += "（" + String((now - networkCheckedAt) / 1000) + "秒前）";
+    }
+    state += "，PDP: ";
+    if (cachedPdpState < 0) {
+        state += "未知";
+    } else {
+        state += cachedPdpState ? "已激活" : "未激活";
+        state += "（" + String((now - pdpCheckedAt) / 1000) + "秒前）";
+    }
+    state += "，HTTP服务: ";
+    if (!httpServiceActive) {
+        state += "未启动";
+    } else {
+        state += sessionStale ? "待重建" : "保持中";
+        if (sessionSslBound) {
+            state += "（已绑定SSL）";
+        }
+    }
+    return state;
+}
+
+/**
+ * @brief 检查缓存的状态是否仍有效
+ * @param state 缓存状态
+ * @param checkedAt 缓存时间
+ * @return true 缓存为已连接且未过期
+ * @return false 需重新查询
+ */
+bool HttpClient::isCacheFresh(int8_t state, unsigned long checkedAt) {
+    // 只缓存正向结果，断开时每次都重新查询以便尽快发现恢复
+    return state == 1 && millis() - checkedAt < HTTP_STATUS_CACHE_TTL_MS;
+}
+
+/**
+ * @brief 订阅网络注册与PDP事件上报
+ */
+void HttpClient::subscribeStatusUrcs() {
+    ModemArbiter& arbiter = atCommandHandler.getArbiter();
+    if (statusUrcQueue != nullptr || !arbiter.isRunning()) {
+        return;
+    }
+    
+    statusUrcQueue = ModemArbiter::createLineQueue(HTTP_STATUS_URC_QUEUE_LENGTH);
+    if (statusUrcQueue == nullptr) {
+        LOG_DEBUG_PRINT("状态上报队列创建失败，网络状态将按TTL轮询");
+        return;
+    }
+    
+    // AT+CREG?的查询响应同样以"+CREG:"开头，订阅会截走其他模块的查询结果，
+    // 因此改用没有其他查询方的EPS注册上报+CEREG
+    arbiter.subscribe("+CEREG:", statusUrcQueue);
+    arbiter.subscribe("+CGEV:", statusUrcQueue);
+    
+    std::vector<String> commands;
+    commands.push_back("AT+CEREG=1");
+    commands.push_back("AT+CGEREP=2,0");
+    AtResponse response = atCommandHandler.sendCommandBatch(commands, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    if (response.result != AT_RESULT_SUCCESS) {
+        LOG_DEBUG_PRINT("开启网络状态上报失败: " + response.response);
+    }
+}
+
+/**
+ * @brief 处理积压的+CEREG/+CGEV上报，更新状态缓存
+ */
+void HttpClient::processStatusUrcs() {
+    if (statusUrcQueue == nullptr) {
+        return;
+    }
+    
+    ModemLine line;
+    while (xQueueReceive(statusUrcQueue, &line, 0) == pdTRUE) {
+        LOG_DEBUG_PRINT("网络状态上报: " + String(line.data));
+        
+        if (strncmp(line.data, "+CEREG:", 7) == 0) {
+            // 上报格式 +CEREG: <stat>[,...]
+            int stat = atoi(line.data + 7);
+            gsmService.updateNetworkRegistration(stat);
+            if (stat == 1 || stat == 5) {
+                cachedNetworkState = 1;
+                networkCheckedAt = millis();
+            } else {
+                cachedNetworkState = 0;
+                cachedPdpState = -1;
+            }
+        } else if (strstr(line.data, "DEACT") != nullptr || strstr(line.data, "DETACH") != nullptr) {
+            // +CGEV: NW/ME PDN DEACT、NW DETACH：PDP已断开，现有HTTP会话不可再用
+            cachedPdpState = 0;
+            sessionStale = true;
+        } else if (strstr(line.data, "PDN ACT") != nullptr) {
+            cachedPdpState = 1;
+            pdpCheckedAt = millis();
+        }
+    }
+}
+
+/**
+ * @brief 配置模块SSL上下文（只在首次HTTPS请求时执行）
+ * @return true SSL上下文可用
+ * @return false 配置失败，使用模块默认SSL设置
+ */
+bool HttpClient::ensureSslContext() {
+    if (sslContextState >= 0) {
+        return sslContextState == 1;
+    }
+    
+    String context = String(HTTP_SSL_CONTEXT_ID);
+    std::vector<String> commands;
+    commands.push_back("AT+CSSLCFG=\"sslversion\"," + context + ",4");
+    commands.push_back("AT+CSSLCFG=\"authmode\"," + context + ",0");
+    commands.push_back("AT+CSSLCFG=\"enableSNI\"," + context + ",1");
+    
+    unsigned long cmdStartTime = millis();
+    AtResponse response = atCommandHandler.sendCommandBatch(commands, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    logAtCommandDetails("[CSSLCFG x" + String((unsigned long)commands.size()) + "]", response.response, millis() - cmdStartTime);
+    
+    // 配置保存在模块中，失败时也不再重复尝试
+    sslContextState = response.result == AT_RESULT_SUCCESS ? 1 : 0;
+    if (sslContextState == 0) {
+        LOG_DEBUG_PRINT("SSL上下文配置失败，使用模块默认设置: " + response.response);
+    }
+    return sslContextState == 1;
+}
+
 /**
  * @brief 检查网络连接状态
  * @return true 网络已连接
  * @return false 网络未连接
  */
 bool HttpClient::isNetworkConnected() {
-    GsmService& gsmService = GsmService::getInstance();
-    GsmNetworkStatus status = gsmService.getNetworkStatus();
+    processStatusUrcs();
+    if (isCacheFresh(cachedNetworkState, networkCheckedAt)) {
+        return true;
+    }
     
-    return (status == GSM_NETWORK_REGISTERED_HOME || 
-            status == GSM_NETWORK_REGISTERED_ROAMING);
+    // 读取定期刷新并随上报更新的状态快照，快照过期时才同步查询
+    ModemStatus status = gsmService.getStatus();
+    bool connected = status.isRegistered();
+    cachedNetworkState = connected ? 1 : 0;
+    networkCheckedAt = status.networkUpdatedAt;
+    return connected;
 }
 
 /**
@@ -314,14 +707,18 @@ bool HttpClient::isNetworkConnected() {
  * @return false PDP上下文未激活
  */
 bool HttpClient::isPdpContextActive() {
-    AtResponse response = atCommandHandler.sendCommandWithFullResponse("AT+CGACT?", DEFAULT_AT_COMMAND_TIMEOUT_MS);
-    
-    if (response.result == AT_RESULT_SUCCESS) {
-        // 检查响应中是否包含激活的PDP上下文
-        return response.response.indexOf("+CGACT: 1,1") != -1;
+    processStatusUrcs();
+    if (isCacheFresh(cachedPdpState, pdpCheckedAt)) {
+        return true;
     }
     
-    return false;
+    AtResponse response = atCommandHandler.sendCommandWithFullResponse("AT+CGACT?", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    
+    // 检查响应中是否包含激活的PDP上下文
+    bool active = response.result == AT_RESULT_SUCCESS && response.response.indexOf("+CGACT: 1,1") != -1;
+    cachedPdpState = active ? 1 : 0;
+    pdpCheckedAt = millis();
+    return active;
 }
 
 /**
@@ -333,7 +730,7 @@ bool HttpClient::isPdpContextActive() {
  * @return false 配置失败
  */
 bool HttpClient::configureApn(const String& apn, const String& username, const String& password) {
-    debugPrint("正在配置APN: " + apn);
+    LOG_DEBUG_PRINT("正在配置APN: " + apn);
     
     // 配置PDP上下文
     String command = "AT+CGDCONT=1,\"IP\",\"" + apn + "\"";
@@ -350,13 +747,13 @@ bool HttpClient::configureApn(const String& apn, const String& username, const S
         response = atCommandHandler.sendCommand(authCommand, "OK", DEFAULT_HTTP_TIMEOUT_MS);
         
         if (response.result != AT_RESULT_SUCCESS) {
-            debugPrint("警告: 配置认证失败，但继续执行: " + response.response);
+            LOG_DEBUG_PRINT("警告: 配置认证失败，但继续执行: " + response.response);
         } else {
-            debugPrint("APN认证配置成功");
+            LOG_DEBUG_PRINT("APN认证配置成功");
         }
     }
     
-    debugPrint("APN配置成功: " + apn);
+    LOG_DEBUG_PRINT("APN配置成功: " + apn);
     return true;
 }
 
@@ -366,13 +763,15 @@ bool HttpClient::configureApn(const String& apn, const String& username, const S
  * @return false 激活失败
  */
 bool HttpClient::activatePdpContext() {
-    debugPrint("正在激活PDP上下文...");
+    LOG_DEBUG_PRINT("正在激活PDP上下文...");
     
     // 激活PDP上下文
     AtResponse response = atCommandHandler.sendCommand("AT+CGACT=1,1", "OK", DEFAULT_HTTP_TIMEOUT_MS);
     
     if (response.result == AT_RESULT_SUCCESS) {
-        debugPrint("PDP上下文激活成功");
+        LOG_DEBUG_PRINT("PDP上下文激活成功");
+        cachedPdpState = 1;
+        pdpCheckedAt = millis();
         return true;
     }
     
@@ -413,6 +812,14 @@ String HttpClient::getLastError() {
 void HttpClient::setDebugMode(bool enabled) {
     debugMode = enabled;
     atCommandHandler.setDebugMode(enabled);
+    
+    // 调试关闭后不再记录日志，释放缓冲区
+    if (!enabled) {
+        std::lock_guard<std::mutex> lock(debugLogMutex);
+        heap_caps_free(debugRing);
+        debugRing = nullptr;
+        debugRingWritten = 0;
+    }
 }
 
 /**
@@ -433,15 +840,25 @@ bool HttpClient::initHttpService() {
         return true;
     }
     
-    debugPrint("初始化HTTP服务...");
+    LOG_DEBUG_PRINT("初始化HTTP服务...");
     
     unsigned long cmdStartTime = millis();
     AtResponse response = atCommandHandler.sendCommand("AT+HTTPINIT", "OK", DEFAULT_HTTP_TIMEOUT_MS);
     logAtCommandDetails("AT+HTTPINIT", response.response, millis() - cmdStartTime);
     
+    // 模块中可能残留未终止的HTTP服务（如诊断流程所留），终止后重试一次
+    if (response.result != AT_RESULT_SUCCESS) {
+        atCommandHandler.sendCommand("AT+HTTPTERM", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        response = atCommandHandler.sendCommand("AT+HTTPINIT", "OK", DEFAULT_HTTP_TIMEOUT_MS);
+        logAtCommandDetails("AT+HTTPINIT", response.response, millis() - cmdStartTime);
+    }
+    
     if (response.result == AT_RESULT_SUCCESS) {
         httpServiceActive = true;
-        debugPrint("HTTP服务初始化成功");
+        sessionStale = false;
+        sessionSslBound = false;
+        lastActivityAt = millis();
+        LOG_DEBUG_PRINT("HTTP服务初始化成功");
         return true;
     }
     
@@ -459,23 +876,35 @@ bool HttpClient::terminateHttpService() {
         return true;
     }
     
-    debugPrint("终止HTTP服务...");
+    LOG_DEBUG_PRINT("终止HTTP服务...");
     
     unsigned long cmdStartTime = millis();
     AtResponse response = atCommandHandler.sendCommand("AT+HTTPTERM", "OK", DEFAULT_HTTP_TIMEOUT_MS);
     logAtCommandDetails("AT+HTTPTERM", response.response, millis() - cmdStartTime);
     
     httpServiceActive = false;
+    sessionSslBound = false;
     
     if (response.result == AT_RESULT_SUCCESS) {
-        debugPrint("HTTP服务终止成功");
+        LOG_DEBUG_PRINT("HTTP服务终止成功");
         return true;
     }
     
-    debugPrint("HTTP服务终止失败: " + response.response);
+    LOG_DEBUG_PRINT("HTTP服务终止失败: " + response.response);
     return false;
 }
 
+/**
+ * @brief 结束一次请求：会话模式下保留HTTP服务，否则终止
+ */
+void HttpClient::finishHttpService() {
+    if (sessionMode && httpServiceActive) {
+        lastActivityAt = millis();
+        return;
+    }
+    terminateHttpService();
+}
+
 /**
  * @brief 设置HTTP参数
  * @param parameter 参数名
@@ -491,7 +920,7 @@ bool HttpClient::setHttpParameter(const String& parameter, const String& value)
     logAtCommandDetails(command, response.response, millis() - cmdStartTime);
     
     if (response.result == AT_RESULT_SUCCESS) {
-        debugPrint("设置HTTP参数成功: " + parameter + " = " + value);
+        LOG_DEBUG_PRINT("设置HTTP参数成功: " + parameter + " = " + value);
         return true;
     }
     
@@ -499,6 +928,32 @@ bool HttpClient::setHttpParameter(const String& parameter, const String& value)
     return false;
 }
 
+/**
+ * @brief 批量设置HTTP参数（多条AT+HTTPPARA拼接为一行发送）
+ * @param parameters 参数名与参数值列表，按顺序设置
+ * @return true 全部设置成功
+ * @return false 设置失败
+ */
+bool HttpClient::setHttpParameters(const std::vector<std::pair<String, String>>& parameters) {
+    std::vector<String> commands;
+    commands.reserve(parameters.size());
+    for (const auto& parameter : parameters) {
+        commands.push_back("AT+HTTPPARA=\"" + parameter.first + "\",\"" + parameter.second + "\"");
+    }
+    
+    unsigned long cmdStartTime = millis();
+    AtResponse response = atCommandHandler.sendCommandBatch(commands, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    logAtCommandDetails("[HTTPPARA x" + String((unsigned long)commands.size()) + "]", response.response, millis() - cmdStartTime);
+    
+    if (response.result == AT_RESULT_SUCCESS) {
+        LOG_DEBUG_PRINT("设置HTTP参数成功，数量: " + String((unsigned long)parameters.size()));
+        return true;
+    }
+    
+    setError("设置HTTP参数失败, 响应: " + response.response);
+    return false;
+}
+
 /**
  * @brief 执行HTTP动作
  * @param method HTTP方法
@@ -514,19 +969,19 @@ HttpResponse HttpClient::executeHttpAction(HttpClientMethod method, unsigned lon
     
     for (int attempt = 0; attempt <= maxRetries; attempt++) {
         if (attempt > 0) {
-            debugPrint("HTTP动作重试第 " + String(attempt) + " 次");
+            LOG_DEBUG_PRINT("HTTP动作重试第 " + String(attempt) + " 次");
             delay(retryDelay);
             
             // 重试前重新初始化HTTP服务
             terminateHttpService();
             delay(500);
             if (!initHttpService()) {
-                debugPrint("重试时HTTP服务初始化失败");
+                LOG_DEBUG_PRINT("重试时HTTP服务初始化失败");
                 continue;
             }
         }
         
-        debugPrint("执行HTTP动作: " + getMethodString(method) + (attempt > 0 ? " (重试 " + String(attempt) + ")" : ""));
+        LOG_DEBUG_PRINT("执行HTTP动作: " + getMethodString(method) + (attempt > 0 ? " (重试 " + String(attempt) + ")" : ""));
         
         // 发送HTTP动作命令
         unsigned long cmdStartTime = millis();
@@ -551,7 +1006,7 @@ HttpResponse HttpClient::executeHttpAction(HttpClientMethod method, unsigned lon
         
         if (atResponse.result == AT_RESULT_SUCCESS) {
             if (parseHttpActionResponse(atResponse.response, response)) {
-                debugPrint("HTTP请求完成，状态码: " + String(response.statusCode));
+                LOG_DEBUG_PRINT("HTTP请求完成，状态码: " + String(response.statusCode));
                 
                 // 检查HTTP状态码，某些错误状态码需要重试
                 if (response.statusCode >= 200 && response.statusCode < 300) {
@@ -560,7 +1015,7 @@ HttpResponse HttpClient::executeHttpAction(HttpClientMethod method, unsigned lon
                 } else if (response.statusCode >= 500 || response.statusCode == 408 || response.statusCode == 429) {
                     // 服务器错误、请求超时或请求过多，可以重试
                     if (attempt < maxRetries) {
-                        debugPrint("HTTP状态码 " + String(response.statusCode) + " 需要重试");
+                        LOG_DEBUG_PRINT("HTTP状态码 " + String(response.statusCode) + " 需要重试");
                         continue;
                     }
                 }
@@ -598,64 +1053,69 @@ HttpResponse HttpClient::executeHttpAction(HttpClientMethod method, unsigned lon
  * @return false 发送失败
  */
 bool HttpClient::sendHttpData(const String& data, unsigned long timeout) {
+    const char* bytes = data.c_str();
+    size_t length = data.length();
+    
+    // 直接从原字符串分块写出，不复制请求体
+    return sendHttpData(length, [bytes, length](size_t offset, uint8_t* buffer, size_t capacity) -> size_t {
+        size_t count = length - offset < capacity ? length - offset : capacity;
+        memcpy(buffer, bytes + offset, count);
+        return count;
+    }, timeout);
+}
+
+/**
+ * @brief 流式发送HTTP数据（用于POST请求）
+ * @param length 数据总长度
+ * @param writer 数据写入回调
+ * @param timeout 超时时间
+ * @return true 发送成功
+ * @return false 发送失败
+ */
+bool HttpClient::sendHttpData(size_t length, const HttpBodyWriter& writer, unsigned long timeout) {
     const int MAX_RETRY_COUNT = 3;
     const int httpRetryDelay = 1000;  // HTTP数据发送重试间隔（毫秒）
     
-    String command = "AT+HTTPDATA=" + String(data.length()) + "," + String(timeout);
+    String command = "AT+HTTPDATA=" + String((unsigned long)length) + "," + String(timeout);
     
-    debugPrint("准备发送HTTP数据，长度: " + String(data.length()));
+    LOG_DEBUG_PRINT("准备发送HTTP数据，长度: " + String((unsigned long)length));
     
     for (int attempt = 1; attempt <= MAX_RETRY_COUNT; attempt++) {
-        debugPrint("HTTP数据发送尝试 " + String(attempt) + "/" + String(MAX_RETRY_COUNT));
+        LOG_DEBUG_PRINT("HTTP数据发送尝试 " + String(attempt) + "/" + String(MAX_RETRY_COUNT));
         
-        // 发送数据长度命令
+        // 命令、DOWNLOAD提示与请求体在一个仲裁事务内完成，其他命令不会混入请求体；每次重试从头开始
+        BodyStream stream = {&writer, length, 0};
         unsigned long cmdStartTime = millis();
-        AtResponse response = atCommandHandler.sendCommand(command, "DOWNLOAD", DEFAULT_AT_COMMAND_TIMEOUT_MS);
-        logAtCommandDetails(command, response.response, millis() - cmdStartTime);
+        AtResponse response = atCommandHandler.sendCommandWithData(command, "DOWNLOAD", "", writeBodyChunk, &stream,
+                                                                   DEFAULT_AT_COMMAND_TIMEOUT_MS, timeout);
+        logAtCommandDetails(command + " [DATA: " + String((unsigned long)length) + " bytes]",
+                            response.response, millis() - cmdStartTime);
         
-        if (response.result != AT_RESULT_SUCCESS) {
-            String errorMsg = "HTTP数据准备失败 (尝试 " + String(attempt) + "): " + command + " -> " + response.response;
-            debugPrint(errorMsg);
-            
-            if (attempt < MAX_RETRY_COUNT) {
-                debugPrint("等待 " + String(httpRetryDelay) + "ms 后重试...");
-                delay(httpRetryDelay);
-                
-                // 尝试重新初始化HTTP服务
-                terminateHttpService();
-                delay(500);
-                if (!initHttpService()) {
-                    debugPrint("重新初始化HTTP服务失败");
-                    continue;
-                }
-            } else {
-                setError(errorMsg);
-                return false;
-            }
-            continue;
-        }
-        
-        // 发送实际数据
-        debugPrint("开始发送HTTP数据内容...");
-        cmdStartTime = millis();
-        response = atCommandHandler.sendRawData(data, timeout);
-        logAtCommandDetails("[RAW DATA: " + String(data.length()) + " bytes]", response.response, millis() - cmdStartTime);
-        
-        if (response.result == AT_RESULT_SUCCESS && response.response.indexOf("OK") != -1) {
-            debugPrint("HTTP数据发送成功 (尝试 " + String(attempt) + ")");
+        if (response.result == AT_RESULT_SUCCESS) {
+            LOG_DEBUG_PRINT("HTTP数据发送成功 (尝试 " + String(attempt) + ")");
             return true;
         }
         
-        String errorMsg = "HTTP数据发送失败 (尝试 " + String(attempt) + "): " + response.response;
-        debugPrint(errorMsg);
+        // 未收到DOWNLOAD说明HTTP服务状态异常，重试前重新初始化
+        bool prepared = response.response.indexOf("DOWNLOAD") != -1;
+        String errorMsg = String(prepared ? "HTTP数据发送失败" : "HTTP数据准备失败") +
+                          " (尝试 " + String(attempt) + "): " + command + " -> " + response.response;
+        LOG_DEBUG_PRINT(errorMsg);
         
-        if (attempt < MAX_RETRY_COUNT) {
-            debugPrint("等待 " + String(httpRetryDelay) + "ms 后重试...");
-            delay(httpRetryDelay);
-        } else {
+        if (attempt >= MAX_RETRY_COUNT) {
             setError(errorMsg);
             return false;
         }
+        
+        LOG_DEBUG_PRINT("等待 " + String(httpRetryDelay) + "ms 后重试...");
+        delay(httpRetryDelay);
+        if (!prepared) {
+            terminateHttpService();
+            delay(500);
+            if (!initHttpService()) {
+                LOG_DEBUG_PRINT("重新初始化HTTP服务失败");
+            }
+        }
     }
     
     return false;
@@ -668,33 +1128,54 @@ bool HttpClient::sendHttpData(const String& data, unsigned long timeout) {
  * @return String 响应内容
  */
 String HttpClient::readHttpResponse(int startPos, int length) {
-    String command = "AT+HTTPREAD=" + String(startPos) + "," + String(length);
+    String content;
+    content.reserve(length);
     
-    debugPrint("读取HTTP响应，起始位置: " + String(startPos) + ", 长度: " + String(length));
+    bool success = streamHttpResponse(startPos, length, [&content](const char* data, size_t count) {
+        content.concat(data, count);
+        return true;
+    });
     
-    AtResponse response = atCommandHandler.sendCommandWithFullResponse(command, DEFAULT_HTTP_TIMEOUT_MS);
+    if (!success) {
+        return "";
+    }
+    LOG_DEBUG_PRINT("成功读取HTTP响应内容");
+    return content;
+}
+
+/**
+ * @brief 分块读取HTTP响应
+ * @param startPos 开始位置
+ * @param length 读取长度
+ * @param reader 数据读取回调
+ * @return true 读取成功（含回调提前结束）
+ * @return false 读取失败
+ */
+bool HttpClient::streamHttpResponse(size_t startPos, size_t length, const HttpBodyReader& reader) {
+    size_t end = startPos + length;
     
-    if (response.result == AT_RESULT_SUCCESS) {
-        // 解析响应内容
-        int readIndex = response.response.indexOf("+HTTPREAD:");
-        if (readIndex != -1) {
-            int contentStart = response.response.indexOf('\n', readIndex);
-            if (contentStart != -1) {
-                contentStart++; // 跳过换行符
-                int contentEnd = response.response.lastIndexOf("\n+HTTPREAD: 0");
-                if (contentEnd == -1) {
-                    contentEnd = response.response.length();
-                }
-                
-                String content = response.response.substring(contentStart, contentEnd);
-                debugPrint("成功读取HTTP响应内容");
-                return content;
-            }
+    for (size_t offset = startPos; offset < end; offset += HTTP_READ_CHUNK_SIZE) {
+        size_t chunk = end - offset < HTTP_READ_CHUNK_SIZE ? end - offset : HTTP_READ_CHUNK_SIZE;
+        String command = "AT+HTTPREAD=" + String((unsigned long)offset) + "," + String((unsigned long)chunk);
+        
+        LOG_DEBUG_PRINT("读取HTTP响应，起始位置: " + String((unsigned long)offset) + ", 长度: " + String((unsigned long)chunk));
+        
+        // 数据在OK之后以"+HTTPREAD: <n>"声明长度输出，仲裁器按长度原样交给回调，以"+HTTPREAD: 0"作为结束行
+        BodySink sink = {&reader, 0, false};
+        AtResponse response = atCommandHandler.sendCommandReadData(command, "+HTTPREAD:", "+HTTPREAD: 0",
+                                                                   readBodyChunk, &sink, DEFAULT_HTTP_TIMEOUT_MS);
+        if (response.result != AT_RESULT_SUCCESS || (sink.received == 0 && !sink.stopped)) {
+            setError("读取HTTP响应失败: " + response.response);
+            return false;
+        }
+        
+        // 回调不再需要数据，或模块返回的数据少于请求长度（响应体已读完）
+        if (sink.stopped || sink.received < chunk) {
+            break;
         }
     }
     
-    setError("读取HTTP响应失败: " + response.response);
-    return "";
+    return true;
 }
 
 /**
@@ -807,16 +1288,45 @@ String HttpClient::getMethodString(HttpClientMethod method) {
  * @return String 调试日志内容
  */
 String HttpClient::getDebugLog() {
-    return debugLog;
+    std::lock_guard<std::mutex> lock(debugLogMutex);
+    String log;
+    if (debugRing == nullptr || debugRingWritten == 0) {
+        return log;
+    }
+    
+    if (debugRingWritten <= HTTP_DEBUG_LOG_SIZE) {
+        log.concat(debugRing, debugRingWritten);
+        return log;
+    }
+    
+    // 已回绕：从最旧的完整行开始，按写入顺序拼接两段
+    size_t start = debugRingWritten % HTTP_DEBUG_LOG_SIZE;
+    size_t skipped = 0;
+    while (skipped < HTTP_DEBUG_LOG_SIZE && debugRing[(start + skipped) % HTTP_DEBUG_LOG_SIZE] != '\n') {
+        skipped++;
+    }
+    start = (start + skipped) % HTTP_DEBUG_LOG_SIZE;
+    log.reserve(HTTP_DEBUG_LOG_SIZE + 16);
+    log = "[日志已截断]";
+    if (start < debugRingWritten % HTTP_DEBUG_LOG_SIZE) {
+        log.concat(debugRing + start, debugRingWritten % HTTP_DEBUG_LOG_SIZE - start);
+    } else {
+        log.concat(debugRing + start, HTTP_DEBUG_LOG_SIZE - start);
+        log.concat(debugRing, debugRingWritten % HTTP_DEBUG_LOG_SIZE);
+    }
+    return log;
 }
 
 /**
  * @brief 清空调试日志
  */
 void HttpClient::clearDebugLog() {
-    debugLog = "";
+    {
+        std::lock_guard<std::mutex> lock(debugLogMutex);
+        debugRingWritten = 0;
+    }
     lastLogTime = millis();
-    debugPrint("调试日志已清空");
+    LOG_DEBUG_PRINT("调试日志已清空");
 }
 
 /**
@@ -921,15 +1431,19 @@ void HttpClient::logResponseDetails(const HttpResponse& response) {
 void HttpClient::logNetworkStatus() {
     if (!debugMode) return;
     
-    String logEntry = "\n[" + String(millis()) + "] === 网络状态检查 ===\n";
-    
-    // 检查网络连接
-    bool networkConnected = isNetworkConnected();
-    logEntry += "网络连接: " + String(networkConnected ? "已连接" : "未连接") + "\n";
-    
-    // 检查PDP上下文
-    bool pdpActive = isPdpContextActive();
-    logEntry += "PDP上下文: " + String(pdpActive ? "已激活" : "未激活") + "\n";
+    // 只记录缓存中已知的状态，为写日志而查询会给每次请求增加AT往返
+    unsigned long now = millis();
+    String logEntry = "\n[" + String(now) + "] === 网络状态 ===\n";
+    logEntry += "网络注册: " + String(cachedNetworkState < 0 ? "未知" : (cachedNetworkState == 1 ? "已注册" : "未注册"));
+    if (cachedNetworkState >= 0) {
+        logEntry += "（" + String(now - networkCheckedAt) + "ms前）";
+    }
+    logEntry += "\n";
+    logEntry += "PDP上下文: " + String(cachedPdpState < 0 ? "未知" : (cachedPdpState == 1 ? "已激活" : "未激活"));
+    if (cachedPdpState >= 0) {
+        logEntry += "（" + String(now - pdpCheckedAt) + "ms前）";
+    }
+    logEntry += "\n";
     
     // 检查HTTP服务状态
     logEntry += "HTTP服务: " + String(httpServiceActive ? "已激活" : "未激活") + "\n";
@@ -981,16 +1495,30 @@ void HttpClient::logAtCommandDetails(const String& command, const String& respon
  * @param logEntry 日志条目
  */
 void HttpClient::appendToDebugLog(const String& logEntry) {
-    // 检查日志大小，如果超过限制则清理旧日志
-    if (debugLog.length() + logEntry.length() > maxLogSize) {
-        // 保留最后一半的日志
-        int keepSize = maxLogSize / 2;
-        if (debugLog.length() > keepSize) {
-            debugLog = debugLog.substring(debugLog.length() - keepSize);
-            debugLog = "\n[日志已截断]\n" + debugLog;
+    std::lock_guard<std::mutex> lock(debugLogMutex);
+    if (debugRing == nullptr) {
+        debugRing = (char*)heap_caps_malloc(HTTP_DEBUG_LOG_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (debugRing == nullptr) {
+            debugRing = (char*)heap_caps_malloc(HTTP_DEBUG_LOG_SIZE, MALLOC_CAP_8BIT);
+        }
+        if (debugRing == nullptr) {
+            return;
         }
+        debugRingWritten = 0;
+    }
+    
+    // 超过缓冲区的条目只保留末尾部分
+    const char* data = logEntry.c_str();
+    size_t length = logEntry.length();
+    if (length > HTTP_DEBUG_LOG_SIZE) {
+        data += length - HTTP_DEBUG_LOG_SIZE;
+        length = HTTP_DEBUG_LOG_SIZE;
     }
     
-    debugLog += logEntry;
+    size_t offset = debugRingWritten % HTTP_DEBUG_LOG_SIZE;
+    size_t first = length < HTTP_DEBUG_LOG_SIZE - offset ? length : HTTP_DEBUG_LOG_SIZE - offset;
+    memcpy(debugRing + offset, data, first);
+    memcpy(debugRing, data + first, length - first);
+    debugRingWritten += length;
     lastLogTime = millis();
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
  * 3. 支持自定义请求头配置
  * 4. 提供完整的响应处理
  * 5. 网络状态检查和错误处理
+ * 6. 会话模式：请求之间保持HTTP服务与SSL配置，网络/PDP状态短时缓存
+ * 7. 流式请求体上传与分块读取响应体，大报文不必整体驻留内存
  */
 
 #ifndef HTTP_CLIENT_H
@@ -17,10 +19,17 @@
 
 #include <Arduino.h>
 #include <map>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "at_command_handler.h"
 #include "gsm_service.h"
 #include "../../include/constants.h"
 
+class HttpTransport;
+
 /**
  * @enum HttpClientMethod
  * @brief HTTP请求方法枚举
@@ -55,6 +64,26 @@ enum HttpClientError {
     HTTP_ERROR_AT_COMMAND = 6   ///< AT命令错误
 };
 
+/**
+ * @brief 请求体写入回调：把从offset开始的请求体数据写入buffer
+ * 
+ * 按偏移取数据，重试时会从0重新读取
+ * @param offset 请求体内的偏移
+ * @param buffer 输出缓冲区
+ * @param capacity 本次最多写入的字节数
+ * @return size_t 实际写入的字节数
+ */
+typedef std::function<size_t(size_t offset, uint8_t* buffer, size_t capacity)> HttpBodyWriter;
+
+/**
+ * @brief 响应体读取回调：按块接收响应体
+ * @param data 数据
+ * @param length 数据长度
+ * @return true 继续读取
+ * @return false 不再读取剩余内容
+ */
+typedef std::function<bool(const char* data, size_t length)> HttpBodyReader;
+
 /**
  * @struct HttpRequest
  * @brief HTTP请求结构体
@@ -65,6 +94,11 @@ struct HttpRequest {
     HttpProtocol protocol;              ///< 协议类型
     std::map<String, String> headers;  ///< 请求头
     String body;                        ///< 请求体（POST/PUT使用）
+    HttpBodyWriter bodyWriter;          ///< 流式请求体（非空时代替body）
+    size_t bodyLength;                  ///< 流式请求体总长度
+    HttpBodyReader bodyReader;          ///< 非空时响应体分块交给回调，不写入HttpResponse::body
+    bool readBody;                      ///< 是否读取响应体（只关心状态码时设为false）
+    size_t maxBodyBytes;                ///< 响应体最多读取的字节数（0表示不限制），超出部分不读取
     unsigned long timeout;              ///< 超时时间(ms)
     
     /**
@@ -73,6 +107,9 @@ struct HttpRequest {
     HttpRequest() : 
         method(HTTP_CLIENT_GET), 
         protocol(HTTP_PROTOCOL), 
+        bodyLength(0),
+        readBody(true),
+        maxBodyBytes(0),
         timeout(DEFAULT_HTTP_TIMEOUT_MS) {}
 };
 
@@ -127,6 +164,10 @@ public:
     
     /**
      * @brief 执行HTTP请求
+     * 
+     * 首选传输后端可用时（如WiFi STA已连接）优先经其发送，可并行执行；
+     * 后端不可用或网络层失败时回退到模块的AT HTTP栈（同一模块上串行）。
+     * 经getModem()获取的实例在多个SIM模块间轮流选择已注册网络的模块发送
      * @param request 请求参数
      * @return HttpResponse 响应结果
      */
@@ -138,12 +179,31 @@ public:
      * @param body 请求体
      * @param headers 请求头（可选）
      * @param timeout 超时时间（可选）
+     * @param readBody 是否读取响应体（可选，只关心状态码时传false省去AT+HTTPREAD）
      * @return HttpResponse 响应结果
      */
     HttpResponse post(const String& url, 
                      const String& body,
                      const std::map<String, String>& headers = {},
-                     unsigned long timeout = DEFAULT_HTTP_TIMEOUT_MS);
+                     unsigned long timeout = DEFAULT_HTTP_TIMEOUT_MS,
+                     bool readBody = true);
+    
+    /**
+     * @brief 执行POST请求，请求体由调用方持有（不复制为String，流式写出）
+     * @param url 请求URL
+     * @param body 请求体（请求返回前须保持有效）
+     * @param bodyLength 请求体长度
+     * @param headers 请求头（可选）
+     * @param timeout 超时时间（可选）
+     * @param readBody 是否读取响应体（可选）
+     * @return HttpResponse 响应结果
+     */
+    HttpResponse post(const String& url,
+                     const char* body,
+                     size_t bodyLength,
+                     const std::map<String, String>& headers = {},
+                     unsigned long timeout = DEFAULT_HTTP_TIMEOUT_MS,
+                     bool readBody = true);
     
     /**
      * @brief 检查网络连接状态
@@ -186,6 +246,46 @@ public:
      */
     bool configureAndActivateApn(const String& apn, const String& username = "", const String& password = "");
     
+    /**
+     * @brief 设置会话模式（默认开启）
+     * 
+     * 会话模式下请求完成后保留模块HTTP服务（AT+HTTPINIT）及其SSL绑定，
+     * 连续请求不再重复初始化；空闲超过HTTP_SESSION_IDLE_TIMEOUT_MS后由closeIdleSession()关闭
+     * @param enabled 是否启用
+     */
+    void setSessionMode(bool enabled);
+    
+    /**
+     * @brief 检查是否处于会话模式
+     * @return true 会话模式
+     * @return false 每次请求后终止HTTP服务
+     */
+    bool isSessionMode() const;
+    
+    /**
+     * @brief 关闭空闲超时的HTTP会话（由定时任务调用，有请求进行中时直接返回）
+     * @return true 已关闭会话
+     * @return false 会话不存在、未超时或正忙
+     */
+    bool closeIdleSession();
+    
+    /**
+     * @brief 丢弃缓存的网络注册与PDP状态，下次检查时重新查询模块
+     */
+    void invalidateStatusCache();
+    
+    /**
+     * @brief 描述缓存的连接状态（只读取缓存，不发送AT命令，可在任意线程调用）
+     * @return String 网络注册、PDP及HTTP会话状态
+     */
+    String describeCachedState();
+    
+    /**
+     * @brief 设置首选传输后端
+     * @param transport 传输后端（nullptr表示始终使用模块）
+     */
+    void setPreferredTransport(HttpTransport* transport);
+    
     /**
      * @brief 获取最后的错误信息
      * @return String 错误信息
@@ -193,13 +293,13 @@ public:
     String getLastError();
     
     /**
-     * @brief 设置调试模式
+     * @brief 设置调试模式（关闭时释放调试日志缓冲区）
      * @param enabled 是否启用调试模式
      */
     void setDebugMode(bool enabled);
     
     /**
-     * @brief 获取详细的调试日志
+     * @brief 获取详细的调试日志（最近HTTP_DEBUG_LOG_SIZE字节）
      * @return String 调试日志内容
      */
     String getDebugLog();
@@ -222,7 +322,7 @@ public:
     void logResponseDetails(const HttpResponse& response);
     
     /**
-     * @brief 记录网络状态信息
+     * @brief 记录网络状态信息（只使用已缓存的状态，不发送AT命令）
      */
     void logNetworkStatus();
     
@@ -241,10 +341,24 @@ public:
     void setDefaultTimeout(unsigned long timeout);
     
     /**
-     * @brief 获取单例实例
-     * @return HttpClient& 单例引用
+     * @brief 检查所属模块是否有数据连接（只读状态快照，不访问串口）
+     * @return true 模块在线且已注册网络
+     * @return false 无数据连接
+     */
+    bool hasDataConnectivity();
+    
+    /**
+     * @brief 获取主SIM模块的HTTP客户端
+     * @return HttpClient& 实例引用
      */
     static HttpClient& getInstance();
+    
+    /**
+     * @brief 获取指定SIM模块的HTTP客户端
+     * @param index 模块序号（0为主模块，超出SIM_MODEM_COUNT时返回主模块）
+     * @return HttpClient& 实例引用
+     */
+    static HttpClient& getModem(uint8_t index);
 
 private:
     AtCommandHandler& atCommandHandler; ///< AT命令处理器引用
@@ -255,11 +369,40 @@ private:
     bool httpServiceActive;             ///< HTTP服务是否激活
     unsigned long defaultTimeout;       ///< 默认超时时间
     
+    // 会话相关成员
+    bool sessionMode;                   ///< 是否在请求之间保持HTTP服务
+    bool sessionStale;                  ///< PDP上下文已断开，会话需重建
+    bool sessionSslBound;               ///< 当前HTTP服务是否已绑定SSL上下文
+    int8_t sslContextState;             ///< SSL上下文配置状态（-1未配置，0配置失败，1已配置）
+    unsigned long lastActivityAt;       ///< 最近一次请求完成的时间
+    int8_t cachedNetworkState;          ///< 缓存的网络注册状态（-1未知，0未注册，1已注册）
+    unsigned long networkCheckedAt;     ///< 网络注册状态的缓存时间
+    int8_t cachedPdpState;              ///< 缓存的PDP状态（-1未知，0未激活，1已激活）
+    unsigned long pdpCheckedAt;         ///< PDP状态的缓存时间
+    QueueHandle_t statusUrcQueue;       ///< +CEREG/+CGEV上报队列
+    std::mutex requestMutex;            ///< 串行化经模块的请求与closeIdleSession()
+    HttpTransport* preferredTransport;  ///< 首选传输后端（默认WiFi原生传输）
+    bool loadBalanced;                  ///< 经模块发送时是否在各SIM模块间轮流选择（getModem()创建的实例）
+    
     // 调试日志相关成员
-    String debugLog;                   ///< 调试日志缓冲区
-    unsigned long maxLogSize;          ///< 最大日志大小
-    unsigned long requestCount;       ///< 请求计数
-    unsigned long lastLogTime;        ///< 最后日志时间
+    char* debugRing;                    ///< 调试日志环形缓冲区（HTTP_DEBUG_LOG_SIZE字节，调试模式下才分配）
+    size_t debugRingWritten;            ///< 累计写入调试日志的字节数
+    std::mutex debugLogMutex;           ///< 保护调试日志缓冲区
+    unsigned long requestCount;         ///< 请求计数
+    unsigned long lastLogTime;          ///< 最后日志时间
+    
+    /**
+     * @brief 经模块AT HTTP栈执行请求
+     * @param request 请求参数
+     * @return HttpResponse 响应结果
+     */
+    HttpResponse requestViaModem(const HttpRequest& request);
+    
+    /**
+     * @brief 从下一个轮到的模块起，选择第一个有数据连接的模块
+     * @return HttpClient& 选中模块的HTTP客户端（都没有数据连接时为主模块）
+     */
+    static HttpClient& selectModem();
     
     /**
      * @brief 初始化HTTP服务
@@ -275,6 +418,37 @@ private:
      */
     bool terminateHttpService();
     
+    /**
+     * @brief 结束一次请求：会话模式下保留HTTP服务，否则终止
+     */
+    void finishHttpService();
+    
+    /**
+     * @brief 配置模块SSL上下文（只在首次HTTPS请求时执行）
+     * @return true SSL上下文可用
+     * @return false 配置失败，使用模块默认SSL设置
+     */
+    bool ensureSslContext();
+    
+    /**
+     * @brief 订阅网络注册与PDP事件上报（首次初始化时调用）
+     */
+    void subscribeStatusUrcs();
+    
+    /**
+     * @brief 处理积压的+CEREG/+CGEV上报，更新状态缓存
+     */
+    void processStatusUrcs();
+    
+    /**
+     * @brief 检查缓存的状态是否仍有效
+     * @param state 缓存状态
+     * @param checkedAt 缓存时间
+     * @return true 缓存为已连接且未过期
+     * @return false 需重新查询
+     */
+    static bool isCacheFresh(int8_t state, unsigned long checkedAt);
+    
     /**
      * @brief 设置HTTP参数
      * @param parameter 参数名
@@ -284,6 +458,14 @@ private:
      */
     bool setHttpParameter(const String& parameter, const String& value);
     
+    /**
+     * @brief 批量设置HTTP参数（多条AT+HTTPPARA拼接为一行发送）
+     * @param parameters 参数名与参数值列表，按顺序设置
+     * @return true 全部设置成功
+     * @return false 设置失败
+     */
+    bool setHttpParameters(const std::vector<std::pair<String, String>>& parameters);
+    
     /**
      * @brief 执行HTTP动作
      * @param method HTTP方法
@@ -301,6 +483,16 @@ private:
      */
     bool sendHttpData(const String& data, unsigned long timeout);
     
+    /**
+     * @brief 流式发送HTTP数据（用于POST请求）
+     * @param length 数据总长度
+     * @param writer 数据写入回调
+     * @param timeout 超时时间
+     * @return true 发送成功
+     * @return false 发送失败
+     */
+    bool sendHttpData(size_t length, const HttpBodyWriter& writer, unsigned long timeout);
+    
     /**
      * @brief 读取HTTP响应
      * @param startPos 开始位置
@@ -309,6 +501,16 @@ private:
      */
     String readHttpResponse(int startPos = 0, int length = 1000);
     
+    /**
+     * @brief 分块读取HTTP响应（每次AT+HTTPREAD最多HTTP_READ_CHUNK_SIZE字节）
+     * @param startPos 开始位置
+     * @param length 读取长度
+     * @param reader 数据读取回调
+     * @return true 读取成功（含回调提前结束）
+     * @return false 读取失败
+     */
+    bool streamHttpResponse(size_t startPos, size_t length, const HttpBodyReader& reader);
+    
     /**
      * @brief 解析HTTP动作响应
      * @param response AT+HTTPACTION的响应
@@ -353,7 +555,7 @@ private:
     String getMethodString(HttpClientMethod method);
     
     /**
-     * @brief 向调试日志添加内容
+     * @brief 向调试日志环形缓冲区添加内容（写满后覆盖最旧的内容）
      * @param message 要添加的消息
      */
     void appendToDebugLog(const String& message);
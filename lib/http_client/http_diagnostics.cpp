@@ -124,14 +124,14 @@ HttpDiagnosticStatus HttpDiagnostics::checkAtCommandHandler() {
  * @return HttpDiagnosticStatus 诊断状态
  */
 HttpDiagnosticStatus HttpDiagnostics::checkGsmModule() {
-    GsmService& gsmService = GsmService::getInstance();
+    ModemStatus status = GsmService::getInstance().getStatus();
     
-    if (!gsmService.isModuleOnline()) {
+    if (!status.online) {
         return HTTP_DIAG_ERROR;
     }
     
     // 检查信号强度
-    int signalStrength = gsmService.getSignalStrength();
+    int signalStrength = status.signalStrength;
     debugPrint("信号强度: " + String(signalStrength));
     
     if (signalStrength < 0) {
@@ -148,15 +148,15 @@ HttpDiagnosticStatus HttpDiagnostics::checkGsmModule() {
  * @return HttpDiagnosticStatus 诊断状态
  */
 HttpDiagnosticStatus HttpDiagnostics::checkNetworkConnection() {
-    GsmService& gsmService = GsmService::getInstance();
     AtCommandHandler& atHandler = AtCommandHandler::getInstance();
+    ModemStatus status = GsmService::getInstance().getStatus();
     
     // 检查网络注册状态
-    GsmNetworkStatus networkStatus = gsmService.getNetworkStatus();
+    GsmNetworkStatus networkStatus = status.networkStatus;
     debugPrint("网络注册状态: " + String(networkStatus));
     
     // 检查信号强度
-    int signalStrength = gsmService.getSignalStrength();
+    int signalStrength = status.signalStrength;
     debugPrint("信号强度: " + String(signalStrength) + " dBm");
     
     // 检查运营商信息
@@ -292,17 +292,14 @@ HttpDiagnosticStatus HttpDiagnostics::testHttpFunction() {
     
     debugPrint("测试HTTP数据命令: " + command);
     
-    AtResponse response = atHandler.sendCommand(command, "DOWNLOAD", 10000);
+    // 收到DOWNLOAD后在同一事务内发送测试数据
+    AtResponse response = atHandler.sendCommandWithData(command, "DOWNLOAD", testData, nullptr, nullptr, 10000, 5000);
     
     if (response.result == AT_RESULT_SUCCESS) {
-        // 发送测试数据
-        AtResponse dataResponse = atHandler.sendRawData(testData, 5000);
-        if (dataResponse.result == AT_RESULT_SUCCESS) {
-            return HTTP_DIAG_OK;
-        } else {
-            debugPrint("HTTP数据发送失败: " + dataResponse.response);
-            return HTTP_DIAG_ERROR;
-        }
+        return HTTP_DIAG_OK;
+    } else if (response.response.indexOf("DOWNLOAD") != -1) {
+        debugPrint("HTTP数据发送失败: " + response.response);
+        return HTTP_DIAG_ERROR;
     } else {
         debugPrint("HTTP数据准备失败: " + response.response);
         return HTTP_DIAG_ERROR;
@@ -0,0 +1,55 @@
+/**
+ * @file http_transport.h
+ * @brief HTTP传输后端接口 - HttpClient据此在WiFi与蜂窝模块之间选择发送路径
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <Arduino.h>
+#include "http_client.h"
+
+/**
+ * @class HttpTransport
+ * @brief HTTP传输后端基类
+ *
+ * 实现须可被多个任务同时调用；不可用或网络层失败（HTTP_ERROR_NETWORK）时，
+ * HttpClient回退到蜂窝模块的AT HTTP栈
+ */
+class HttpTransport {
+public:
+    /**
+     * @brief 虚析构函数
+     */
+    virtual ~HttpTransport() = default;
+
+    /**
+     * @brief 获取后端名称
+     * @return const char* 名称
+     */
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief 检查后端当前是否可用
+     * @return true 可用
+     * @return false 不可用
+     */
+    virtual bool isAvailable() = 0;
+
+    /**
+     * @brief 执行HTTP请求
+     * @param request 请求参数
+     * @return HttpResponse 响应结果
+     */
+    virtual HttpResponse execute(const HttpRequest& request) = 0;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    virtual String getLastError() const = 0;
+};
+
+#endif // HTTP_TRANSPORT_H
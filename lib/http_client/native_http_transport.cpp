@@ -0,0 +1,356 @@
+/**
+ * @file native_http_transport.cpp
+ * @brief 原生HTTP传输后端实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "native_http_transport.h"
+#include <WiFi.h>
+#include <esp_crt_bundle.h>
+
+/**
+ * @brief 获取单例实例
+ * @return NativeHttpTransport& 单例引用
+ */
+NativeHttpTransport& NativeHttpTransport::getInstance() {
+    static NativeHttpTransport instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+NativeHttpTransport::NativeHttpTransport() : debugMode(false) {
+    for (Connection& connection : connections) {
+        connection.handle = nullptr;
+        connection.inUse = false;
+        connection.lastUsedAt = 0;
+    }
+}
+
+/**
+ * @brief 析构函数
+ */
+NativeHttpTransport::~NativeHttpTransport() {
+    for (Connection& connection : connections) {
+        if (connection.handle != nullptr) {
+            esp_http_client_cleanup(connection.handle);
+            connection.handle = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief 获取后端名称
+ * @return const char* 名称
+ */
+const char* NativeHttpTransport::getName() const {
+    return "wifi";
+}
+
+/**
+ * @brief WiFi STA已连接时可用
+ * @return true 可用
+ * @return false 不可用
+ */
+bool NativeHttpTransport::isAvailable() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+/**
+ * @brief 执行HTTP请求
+ * @param request 请求参数
+ * @return HttpResponse 响应结果
+ */
+HttpResponse NativeHttpTransport::execute(const HttpRequest& request) {
+    HttpResponse response;
+    unsigned long startTime = millis();
+
+    String origin = extractOrigin(request.url);
+    Connection* connection = acquire(origin, request);
+    if (connection == nullptr) {
+        response.error = HTTP_ERROR_NETWORK;
+        response.duration = millis() - startTime;
+        return response;
+    }
+
+    debugPrint("请求: " + request.url);
+
+    bool reusable = perform(connection->handle, request, response);
+    if (reusable) {
+        // 清除本次请求设置的请求头，避免带到下一次请求
+        for (const auto& header : request.headers) {
+            esp_http_client_delete_header(connection->handle, header.first.c_str());
+        }
+    }
+    release(connection, reusable);
+
+    response.duration = millis() - startTime;
+    debugPrint("响应状态码: " + String(response.statusCode) + "，耗时: " + String(response.duration) + "ms");
+    return response;
+}
+
+/**
+ * @brief 执行请求的各个阶段（连接已取得）
+ * @param handle 客户端句柄
+ * @param request 请求参数
+ * @param response 响应结果
+ * @return true 连接可继续复用
+ * @return false 连接应关闭
+ */
+bool NativeHttpTransport::perform(esp_http_client_handle_t handle, const HttpRequest& request, HttpResponse& response) {
+    esp_http_client_set_url(handle, request.url.c_str());
+    esp_http_client_set_method(handle, toNativeMethod(request.method));
+    esp_http_client_set_timeout_ms(handle, request.timeout);
+    for (const auto& header : request.headers) {
+        esp_http_client_set_header(handle, header.first.c_str(), header.second.c_str());
+    }
+
+    size_t bodyLength = request.bodyWriter ? request.bodyLength : request.body.length();
+    esp_err_t err = esp_http_client_open(handle, bodyLength);
+    if (err != ESP_OK) {
+        setError("建立连接失败: " + String(esp_err_to_name(err)));
+        response.error = HTTP_ERROR_NETWORK;
+        return false;
+    }
+
+    // 请求体：流式写入回调按块取数据，普通请求体直接写出
+    if (request.bodyWriter) {
+        uint8_t buffer[NATIVE_HTTP_BUFFER_SIZE];
+        size_t offset = 0;
+        while (offset < bodyLength) {
+            size_t remaining = bodyLength - offset;
+            size_t chunk = request.bodyWriter(offset, buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+            if (chunk == 0 || esp_http_client_write(handle, (const char*)buffer, chunk) != (int)chunk) {
+                setError("发送请求体失败");
+                response.error = HTTP_ERROR_NETWORK;
+                return false;
+            }
+            offset += chunk;
+        }
+    } else if (bodyLength > 0 &&
+               esp_http_client_write(handle, request.body.c_str(), bodyLength) != (int)bodyLength) {
+        setError("发送请求体失败");
+        response.error = HTTP_ERROR_NETWORK;
+        return false;
+    }
+
+    int contentLength = esp_http_client_fetch_headers(handle);
+    if (contentLength < 0) {
+        setError("读取响应头失败");
+        response.error = HTTP_ERROR_TIMEOUT;
+        return false;
+    }
+
+    response.statusCode = esp_http_client_get_status_code(handle);
+    response.contentLength = contentLength;
+    if (response.statusCode >= 400) {
+        response.error = HTTP_ERROR_SERVER;
+    } else {
+        response.error = HTTP_SUCCESS;
+    }
+
+    // 读取响应体；不需要时也要读完丢弃，连接才能继续复用
+    // 有上限时超出部分同样读完丢弃
+    size_t remaining = request.maxBodyBytes > 0 ? request.maxBodyBytes : SIZE_MAX;
+    if (request.readBody && !request.bodyReader && contentLength > 0) {
+        response.body.reserve(remaining < (size_t)contentLength ? remaining : (size_t)contentLength);
+    }
+    char buffer[NATIVE_HTTP_BUFFER_SIZE];
+    bool wantBody = request.readBody;
+    int readCount;
+    while ((readCount = esp_http_client_read(handle, buffer, sizeof(buffer))) > 0) {
+        if (!wantBody) {
+            continue;
+        }
+        size_t keep = (size_t)readCount < remaining ? (size_t)readCount : remaining;
+        remaining -= keep;
+        if (request.bodyReader) {
+            wantBody = request.bodyReader(buffer, keep);
+        } else {
+            response.body.concat(buffer, keep);
+        }
+        if (remaining == 0) {
+            wantBody = false;
+        }
+    }
+    if (readCount < 0) {
+        setError("读取响应体失败");
+        return false;
+    }
+    if (response.contentLength == 0) {
+        response.contentLength = response.body.length();
+    }
+
+    return esp_http_client_is_complete_data_received(handle);
+}
+
+/**
+ * @brief 取得一条连接：优先复用同源站的空闲连接，否则新建
+ * @param origin 源站
+ * @param request 请求参数
+ * @return Connection* 连接，连接池已满或创建失败时返回nullptr
+ */
+NativeHttpTransport::Connection* NativeHttpTransport::acquire(const String& origin, const HttpRequest& request) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    unsigned long now = millis();
+    Connection* emptySlot = nullptr;
+    Connection* oldestIdle = nullptr;
+
+    for (Connection& connection : connections) {
+        if (connection.handle == nullptr) {
+            if (emptySlot == nullptr) {
+                emptySlot = &connection;
+            }
+            continue;
+        }
+        if (connection.inUse) {
+            continue;
+        }
+        // 空闲过久的连接可能已被服务端关闭，直接回收
+        if (now - connection.lastUsedAt >= NATIVE_HTTP_IDLE_TIMEOUT_MS) {
+            esp_http_client_cleanup(connection.handle);
+            connection.handle = nullptr;
+            if (emptySlot == nullptr) {
+                emptySlot = &connection;
+            }
+            continue;
+        }
+        if (connection.origin == origin) {
+            connection.inUse = true;
+            return &connection;
+        }
+        if (oldestIdle == nullptr || connection.lastUsedAt < oldestIdle->lastUsedAt) {
+            oldestIdle = &connection;
+        }
+    }
+
+    // 没有空槽时淘汰最久未用的其他源站连接
+    Connection* slot = emptySlot;
+    if (slot == nullptr && oldestIdle != nullptr) {
+        esp_http_client_cleanup(oldestIdle->handle);
+        oldestIdle->handle = nullptr;
+        slot = oldestIdle;
+    }
+    if (slot == nullptr) {
+        setError("连接池已满");
+        return nullptr;
+    }
+
+    esp_http_client_config_t config = {};
+    config.url = request.url.c_str();
+    config.timeout_ms = request.timeout;
+    config.keep_alive_enable = true;
+    config.buffer_size = NATIVE_HTTP_BUFFER_SIZE;
+    config.crt_bundle_attach = esp_crt_bundle_attach;
+
+    slot->handle = esp_http_client_init(&config);
+    if (slot->handle == nullptr) {
+        setError("创建HTTP客户端失败");
+        return nullptr;
+    }
+    slot->origin = origin;
+    slot->inUse = true;
+    return slot;
+}
+
+/**
+ * @brief 归还连接
+ * @param connection 连接
+ * @param reusable 连接是否可继续复用（否则关闭）
+ */
+void NativeHttpTransport::release(Connection* connection, bool reusable) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    if (!reusable) {
+        esp_http_client_cleanup(connection->handle);
+        connection->handle = nullptr;
+    } else {
+        connection->lastUsedAt = millis();
+    }
+    connection->inUse = false;
+}
+
+/**
+ * @brief 关闭空闲超过NATIVE_HTTP_IDLE_TIMEOUT_MS的连接（由定时任务调用）
+ */
+void NativeHttpTransport::closeIdleConnections() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    unsigned long now = millis();
+    for (Connection& connection : connections) {
+        if (connection.handle != nullptr && !connection.inUse &&
+            now - connection.lastUsedAt >= NATIVE_HTTP_IDLE_TIMEOUT_MS) {
+            esp_http_client_cleanup(connection.handle);
+            connection.handle = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief 从URL中提取源站
+ * @param url URL
+ * @return String 源站（协议://主机:端口）
+ */
+String NativeHttpTransport::extractOrigin(const String& url) {
+    int schemeEnd = url.indexOf("://");
+    int hostStart = schemeEnd == -1 ? 0 : schemeEnd + 3;
+    int pathStart = url.indexOf('/', hostStart);
+    return pathStart == -1 ? url : url.substring(0, pathStart);
+}
+
+/**
+ * @brief 转换请求方法
+ * @param method 请求方法
+ * @return esp_http_client_method_t esp_http_client请求方法
+ */
+esp_http_client_method_t NativeHttpTransport::toNativeMethod(HttpClientMethod method) {
+    switch (method) {
+        case HTTP_CLIENT_POST:   return HTTP_METHOD_POST;
+        case HTTP_CLIENT_PUT:    return HTTP_METHOD_PUT;
+        case HTTP_CLIENT_DELETE: return HTTP_METHOD_DELETE;
+        case HTTP_CLIENT_GET:
+        default:                 return HTTP_METHOD_GET;
+    }
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String NativeHttpTransport::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void NativeHttpTransport::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void NativeHttpTransport::setError(const String& error) {
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = error;
+    }
+    debugPrint("错误: " + error);
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void NativeHttpTransport::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[NativeHttp] " + message);
+    }
+}
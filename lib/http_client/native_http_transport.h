@@ -0,0 +1,162 @@
+/**
+ * @file native_http_transport.h
+ * @brief 原生HTTP传输后端 - WiFi STA连接可用时经lwIP/esp_http_client直接发送
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 按源站（协议+主机+端口）维护长连接池，连续请求复用已建立的TCP/TLS连接
+ * 2. 连接池中的连接互不依赖，多个任务可并行发送请求
+ * 3. 支持HttpRequest的流式请求体与分块响应读取
+ */
+
+#ifndef NATIVE_HTTP_TRANSPORT_H
+#define NATIVE_HTTP_TRANSPORT_H
+
+#include <Arduino.h>
+#include <mutex>
+#include <esp_http_client.h>
+#include "http_transport.h"
+#include "../../include/constants.h"
+
+/**
+ * @class NativeHttpTransport
+ * @brief 基于esp_http_client的HTTP传输后端
+ */
+class NativeHttpTransport : public HttpTransport {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return NativeHttpTransport& 单例引用
+     */
+    static NativeHttpTransport& getInstance();
+
+    /**
+     * @brief 获取后端名称
+     * @return const char* 名称
+     */
+    const char* getName() const override;
+
+    /**
+     * @brief WiFi STA已连接时可用
+     * @return true 可用
+     * @return false 不可用
+     */
+    bool isAvailable() override;
+
+    /**
+     * @brief 执行HTTP请求
+     * @param request 请求参数
+     * @return HttpResponse 响应结果
+     */
+    HttpResponse execute(const HttpRequest& request) override;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const override;
+
+    /**
+     * @brief 关闭空闲超过NATIVE_HTTP_IDLE_TIMEOUT_MS的连接（由定时任务调用）
+     */
+    void closeIdleConnections();
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @struct Connection
+     * @brief 连接池中的一条连接
+     */
+    struct Connection {
+        String origin;                      ///< 源站（协议://主机:端口）
+        esp_http_client_handle_t handle;    ///< 客户端句柄（nullptr表示空槽）
+        bool inUse;                         ///< 是否正被某个请求使用
+        unsigned long lastUsedAt;           ///< 最近一次使用完毕的时间
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    NativeHttpTransport();
+
+    /**
+     * @brief 析构函数
+     */
+    ~NativeHttpTransport();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    NativeHttpTransport(const NativeHttpTransport&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    NativeHttpTransport& operator=(const NativeHttpTransport&) = delete;
+
+    /**
+     * @brief 取得一条连接：优先复用同源站的空闲连接，否则新建
+     * @param origin 源站
+     * @param request 请求参数
+     * @return Connection* 连接，连接池已满或创建失败时返回nullptr
+     */
+    Connection* acquire(const String& origin, const HttpRequest& request);
+
+    /**
+     * @brief 归还连接
+     * @param connection 连接
+     * @param reusable 连接是否可继续复用（否则关闭）
+     */
+    void release(Connection* connection, bool reusable);
+
+    /**
+     * @brief 执行请求的各个阶段（连接已取得）
+     * @param handle 客户端句柄
+     * @param request 请求参数
+     * @param response 响应结果
+     * @return true 连接可继续复用
+     * @return false 连接应关闭
+     */
+    bool perform(esp_http_client_handle_t handle, const HttpRequest& request, HttpResponse& response);
+
+    /**
+     * @brief 从URL中提取源站
+     * @param url URL
+     * @return String 源站（协议://主机:端口）
+     */
+    static String extractOrigin(const String& url);
+
+    /**
+     * @brief 转换请求方法
+     * @param method 请求方法
+     * @return esp_http_client_method_t esp_http_client请求方法
+     */
+    static esp_http_client_method_t toNativeMethod(HttpClientMethod method);
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    Connection connections[NATIVE_HTTP_MAX_CONNECTIONS]; ///< 连接池
+    std::mutex poolMutex;           ///< 保护连接池
+    String lastError;               ///< 最后的错误信息
+    mutable std::mutex errorMutex;  ///< 保护lastError（多个请求可能同时出错）
+    bool debugMode;                 ///< 调试模式
+};
+
+#endif // NATIVE_HTTP_TRANSPORT_H
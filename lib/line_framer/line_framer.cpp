@@ -0,0 +1,315 @@
+/**
+ * @file line_framer.cpp
+ * @brief 串口行分帧器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "line_framer.h"
+#include <string.h>
+
+const size_t LineFramer::CAPACITY;
+
+namespace {
+
+/**
+ * @struct UrcPrefix
+ * @brief URC前缀表项
+ */
+struct UrcPrefix {
+    const char* prefix;     ///< 前缀
+    size_t length;          ///< 前缀长度
+    UrcType type;           ///< 对应的URC类型
+};
+
+/**
+ * @brief 编译期计算字符串字面量长度
+ */
+template <size_t N>
+constexpr size_t literalLength(const char (&)[N]) {
+    return N - 1;
+}
+
+/// 短信相关URC前缀表，按首个差异字符区分，无需依赖匹配顺序
+constexpr UrcPrefix URC_PREFIX_TABLE[] = {
+    { "+CMT:",  literalLength("+CMT:"),  URC_CMT  },
+    { "+CMTI:", literalLength("+CMTI:"), URC_CMTI },
+    { "+CDSI:", literalLength("+CDSI:"), URC_CDSI },
+    { "+CBM:",  literalLength("+CBM:"),  URC_CBM  },
+};
+
+constexpr size_t URC_PREFIX_COUNT = sizeof(URC_PREFIX_TABLE) / sizeof(URC_PREFIX_TABLE[0]);
+
+/**
+ * @struct FinalResultEntry
+ * @brief 最终结果码表项
+ */
+struct FinalResultEntry {
+    const char* text;       ///< 结果码文本
+    size_t length;          ///< 文本长度
+    bool exact;             ///< 是否要求整行完全匹配（否则按前缀匹配）
+    FinalResultCode code;   ///< 对应的结果码类型
+};
+
+/// 最终结果码表（V.25ter与3GPP 27.007/27.005定义的结束响应）
+constexpr FinalResultEntry FINAL_RESULT_TABLE[] = {
+    { "OK",           literalLength("OK"),           true,  FINAL_OK    },
+    { "ERROR",        literalLength("ERROR"),        true,  FINAL_ERROR },
+    { "+CME ERROR:",  literalLength("+CME ERROR:"),  false, FINAL_ERROR },
+    { "+CMS ERROR:",  literalLength("+CMS ERROR:"),  false, FINAL_ERROR },
+    { "NO CARRIER",   literalLength("NO CARRIER"),   true,  FINAL_ERROR },
+    { "BUSY",         literalLength("BUSY"),         true,  FINAL_ERROR },
+    { "NO ANSWER",    literalLength("NO ANSWER"),    true,  FINAL_ERROR },
+    { "NO DIALTONE",  literalLength("NO DIALTONE"),  true,  FINAL_ERROR },
+};
+
+constexpr size_t FINAL_RESULT_COUNT = sizeof(FINAL_RESULT_TABLE) / sizeof(FINAL_RESULT_TABLE[0]);
+
+/**
+ * @brief 判断是否为需要去除的空白字符
+ */
+inline bool isLineSpace(char c) {
+    return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+} // namespace
+
+/**
+ * @brief 识别行的URC类型
+ * @param data 行内容
+ * @param length 行长度
+ * @return UrcType URC类型，非短信相关URC返回URC_NONE
+ */
+UrcType classifyUrc(const char* data, size_t length) {
+    // 所有短信URC都以"+C"开头，先做一次廉价过滤
+    if (data == nullptr || length < 5 || data[0] != '+' || data[1] != 'C') {
+        return URC_NONE;
+    }
+
+    for (size_t i = 0; i < URC_PREFIX_COUNT; i++) {
+        const UrcPrefix& entry = URC_PREFIX_TABLE[i];
+        if (length >= entry.length && memcmp(data, entry.prefix, entry.length) == 0) {
+            return entry.type;
+        }
+    }
+    return URC_NONE;
+}
+
+/**
+ * @brief 识别行是否为AT命令的最终结果码
+ * @param data 行内容
+ * @param length 行长度
+ * @return FinalResultCode 结果码类型，非最终结果码返回FINAL_NONE
+ */
+FinalResultCode classifyFinalResult(const char* data, size_t length) {
+    // 所有结果码都以'O'、'E'、'+'、'N'、'B'开头，其余行直接跳过
+    if (data == nullptr || length < 2) {
+        return FINAL_NONE;
+    }
+    char first = data[0];
+    if (first != 'O' && first != 'E' && first != '+' && first != 'N' && first != 'B') {
+        return FINAL_NONE;
+    }
+
+    for (size_t i = 0; i < FINAL_RESULT_COUNT; i++) {
+        const FinalResultEntry& entry = FINAL_RESULT_TABLE[i];
+        if (entry.exact ? length != entry.length : length < entry.length) {
+            continue;
+        }
+        if (memcmp(data, entry.text, entry.length) == 0) {
+            return entry.code;
+        }
+    }
+    return FINAL_NONE;
+}
+
+/**
+ * @brief 检查行是否以指定前缀开头
+ * @param data 行内容
+ * @param length 行长度
+ * @param prefix 前缀（以'\0'结尾）
+ * @return true 以该前缀开头
+ * @return false 不以该前缀开头
+ */
+bool lineStartsWith(const char* data, size_t length, const char* prefix) {
+    size_t prefixLength = strlen(prefix);
+    return length >= prefixLength && memcmp(data, prefix, prefixLength) == 0;
+}
+
+/**
+ * @brief 构造函数
+ */
+LineFramer::LineFramer()
+    : head(0), tail(0), count(0), scanned(0), overflowCount(0) {
+}
+
+/**
+ * @brief 写入接收到的字节
+ * @param data 数据
+ * @param length 数据长度
+ * @return size_t 实际写入的字节数
+ */
+size_t LineFramer::feed(const uint8_t* data, size_t length) {
+    size_t space = CAPACITY - count;
+    size_t toWrite = length < space ? length : space;
+
+    // 最多分两段写入（到缓冲区末尾、从头开始）
+    size_t firstPart = CAPACITY - head;
+    if (firstPart > toWrite) {
+        firstPart = toWrite;
+    }
+    memcpy(ring + head, data, firstPart);
+    if (toWrite > firstPart) {
+        memcpy(ring, data + firstPart, toWrite - firstPart);
+    }
+
+    head = (head + toWrite) % CAPACITY;
+    count += toWrite;
+    return toWrite;
+}
+
+/**
+ * @brief 取出下一行
+ * @param line 输出的行视图
+ * @return true 取到一行
+ * @return false 没有完整的行
+ */
+bool LineFramer::nextLine(LineView& line) {
+    // 从上次扫描结束的位置继续查找换行符，避免重复扫描
+    while (scanned < count) {
+        size_t index = (tail + scanned) % CAPACITY;
+        scanned++;
+        if (ring[index] == '\n') {
+            size_t start = tail;
+            size_t length = scanned;
+            tail = (tail + length) % CAPACITY;
+            count -= length;
+            scanned = 0;
+            makeView(start, length, line);
+            line.truncated = false;
+            return true;
+        }
+    }
+
+    // 缓冲区已满仍没有换行符：整体作为一行交付，避免数据流卡死
+    if (count == CAPACITY) {
+        size_t start = tail;
+        size_t length = count;
+        tail = head;
+        count = 0;
+        scanned = 0;
+        overflowCount++;
+        makeView(start, length, line);
+        line.truncated = true;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 按长度取出缓冲区开头的原始字节
+ * @param data 输出：指向缓冲区内部的数据
+ * @param maxLength 最多取出的字节数
+ * @return size_t 取出的字节数
+ */
+size_t LineFramer::takeRaw(const char*& data, size_t maxLength) {
+    size_t length = count < maxLength ? count : maxLength;
+    size_t contiguous = CAPACITY - tail;
+    if (length > contiguous) {
+        length = contiguous;
+    }
+
+    data = ring + tail;
+    tail = (tail + length) % CAPACITY;
+    count -= length;
+    // 已扫描过的字节随数据一起取出，剩余部分不必重新扫描
+    scanned = scanned > length ? scanned - length : 0;
+    return length;
+}
+
+/**
+ * @brief 清空缓冲区
+ */
+void LineFramer::reset() {
+    head = 0;
+    tail = 0;
+    count = 0;
+    scanned = 0;
+}
+
+/**
+ * @brief 获取缓冲区中尚未成行的字节数
+ * @return size_t 字节数
+ */
+size_t LineFramer::buffered() const {
+    return count;
+}
+
+/**
+ * @brief 检查尚未成行的数据中是否包含指定标记
+ * @param token 标记（以'\0'结尾）
+ * @return true 包含该标记
+ * @return false 不包含
+ */
+bool LineFramer::pendingContains(const char* token) const {
+    size_t tokenLength = strlen(token);
+    if (tokenLength == 0 || tokenLength > count) {
+        return false;
+    }
+
+    for (size_t offset = 0; offset + tokenLength <= count; offset++) {
+        size_t matched = 0;
+        while (matched < tokenLength &&
+               ring[(tail + offset + matched) % CAPACITY] == token[matched]) {
+            matched++;
+        }
+        if (matched == tokenLength) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 获取因超长被截断的行数
+ * @return unsigned long 截断次数
+ */
+unsigned long LineFramer::getOverflowCount() const {
+    return overflowCount;
+}
+
+/**
+ * @brief 将指定范围的行去除首尾空白后生成视图
+ * @param start 行在环形缓冲区中的起始位置
+ * @param length 行长度（含换行符）
+ * @param line 输出的行视图
+ */
+void LineFramer::makeView(size_t start, size_t length, LineView& line) {
+    size_t begin = 0;
+    while (begin < length && isLineSpace(ring[(start + begin) % CAPACITY])) {
+        begin++;
+    }
+    size_t end = length;
+    while (end > begin && isLineSpace(ring[(start + end - 1) % CAPACITY])) {
+        end--;
+    }
+
+    size_t trimmedLength = end - begin;
+    size_t from = (start + begin) % CAPACITY;
+
+    // 行未跨越缓冲区末尾且末尾有空白可覆盖为'\0'时，直接返回缓冲区内的视图
+    if (end < length && from + trimmedLength < CAPACITY) {
+        ring[from + trimmedLength] = '\0';
+        line.data = ring + from;
+        line.length = trimmedLength;
+        return;
+    }
+
+    for (size_t i = 0; i < trimmedLength; i++) {
+        scratch[i] = ring[(from + i) % CAPACITY];
+    }
+    scratch[trimmedLength] = '\0';
+    line.data = scratch;
+    line.length = trimmedLength;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file line_framer.h
+ * @brief 串口行分帧器 - 固定容量环形缓冲区，按行输出零拷贝视图
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 将模块串口字节流按'\n'切分为行，整个过程不分配堆内存
+ * 2. 以指针+长度视图的形式交付已去除首尾空白的行
+ * 3. 通过编译期前缀表识别短信相关URC（+CMT:, +CMTI:, +CDSI:, +CBM:）
+ * 4. 识别AT命令的最终结果码（OK, ERROR, +CME ERROR:等）
+ * 5. 按长度交付数据段的原始字节，供长度已知的响应绕过分行
+ */
+
+#ifndef LINE_FRAMER_H
+#define LINE_FRAMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../include/constants.h"
+
+/**
+ * @enum UrcType
+ * @brief 短信相关URC类型
+ */
+enum UrcType {
+    URC_NONE = 0,   ///< 非短信相关URC
+    URC_CMT,        ///< +CMT: 新短信直接上报（PDU在下一行）
+    URC_CMTI,       ///< +CMTI: 新短信存储通知
+    URC_CDSI,       ///< +CDSI: 状态报告存储通知
+    URC_CBM         ///< +CBM: 小区广播
+};
+
+/**
+ * @enum FinalResultCode
+ * @brief AT命令最终结果码类型
+ */
+enum FinalResultCode {
+    FINAL_NONE = 0,     ///< 不是最终结果码（中间响应或URC）
+    FINAL_OK,           ///< 成功结束（OK）
+    FINAL_ERROR         ///< 失败结束（ERROR, +CME ERROR:, +CMS ERROR:, NO CARRIER等）
+};
+
+/**
+ * @struct LineView
+ * @brief 一行数据的只读视图
+ *
+ * data始终以'\0'结尾（data[length] == '\0'），
+ * 仅在下一次调用LineFramer::feed()/nextLine()之前有效
+ */
+struct LineView {
+    const char* data;   ///< 行内容（已去除首尾空白）
+    size_t length;      ///< 行长度
+    bool truncated;     ///< 是否因超出缓冲区容量被截断
+};
+
+/**
+ * @brief 识别行的URC类型
+ * @param data 行内容
+ * @param length 行长度
+ * @return UrcType URC类型，非短信相关URC返回URC_NONE
+ */
+UrcType classifyUrc(const char* data, size_t length);
+
+/**
+ * @brief 识别行是否为AT命令的最终结果码
+ * @param data 行内容
+ * @param length 行长度
+ * @return FinalResultCode 结果码类型，非最终结果码返回FINAL_NONE
+ */
+FinalResultCode classifyFinalResult(const char* data, size_t length);
+
+/**
+ * @brief 检查行是否以指定前缀开头
+ * @param data 行内容
+ * @param length 行长度
+ * @param prefix 前缀（以'\0'结尾）
+ * @return true 以该前缀开头
+ * @return false 不以该前缀开头
+ */
+bool lineStartsWith(const char* data, size_t length, const char* prefix);
+
+/**
+ * @class LineFramer
+ * @brief 固定容量的环形缓冲区行分帧器
+ *
+ * 行未跨越环形缓冲区末尾时直接返回指向缓冲区内部的视图，
+ * 跨越末尾时复制到内部线性缓冲区，两种情况都不分配堆内存
+ */
+class LineFramer {
+public:
+    /**
+     * @brief 缓冲区容量
+     */
+    static const size_t CAPACITY = UART_LINE_BUFFER_SIZE;
+
+    /**
+     * @brief 构造函数
+     */
+    LineFramer();
+
+    /**
+     * @brief 写入接收到的字节
+     * @param data 数据
+     * @param length 数据长度
+     * @return size_t 实际写入的字节数（缓冲区满时可能小于length，需先调用nextLine()取出数据）
+     */
+    size_t feed(const uint8_t* data, size_t length);
+
+    /**
+     * @brief 取出下一行
+     *
+     * 缓冲区已满但仍无换行符时，整个缓冲区作为一行（truncated=true）交付
+     * @param line 输出的行视图
+     * @return true 取到一行
+     * @return false 没有完整的行
+     */
+    bool nextLine(LineView& line);
+
+    /**
+     * @brief 按长度取出缓冲区开头的原始字节（不查找换行、不去除空白）
+     *
+     * 用于模块以长度声明的数据段（如"+HTTPREAD: <n>"之后的n字节），
+     * 数据跨越环形缓冲区末尾时分两次取出
+     * @param data 输出：指向缓冲区内部的数据，仅在下一次调用feed()之前有效
+     * @param maxLength 最多取出的字节数
+     * @return size_t 取出的字节数（0表示缓冲区为空）
+     */
+    size_t takeRaw(const char*& data, size_t maxLength);
+
+    /**
+     * @brief 清空缓冲区
+     */
+    void reset();
+
+    /**
+     * @brief 获取缓冲区中尚未成行的字节数
+     * @return size_t 字节数
+     */
+    size_t buffered() const;
+
+    /**
+     * @brief 检查尚未成行的数据中是否包含指定标记
+     *
+     * 用于识别不以换行结尾的提示符（如AT+CMGS后的"> "）
+     * @param token 标记（以'\0'结尾）
+     * @return true 包含该标记
+     * @return false 不包含
+     */
+    bool pendingContains(const char* token) const;
+
+    /**
+     * @brief 获取因超长被截断的行数
+     * @return unsigned long 截断次数
+     */
+    unsigned long getOverflowCount() const;
+
+private:
+    /**
+     * @brief 将指定范围的行去除首尾空白后生成视图
+     * @param start 行在环形缓冲区中的起始位置
+     * @param length 行长度（含换行符）
+     * @param line 输出的行视图
+     */
+    void makeView(size_t start, size_t length, LineView& line);
+
+    char ring[CAPACITY];            ///< 环形缓冲区
+    char scratch[CAPACITY + 1];     ///< 跨越环形缓冲区末尾的行的线性副本
+    size_t head;                    ///< 写入位置
+    size_t tail;                    ///< 读取位置
+    size_t count;                   ///< 已缓冲字节数
+    size_t scanned;                 ///< 从tail开始已确认不含换行符的字节数
+    unsigned long overflowCount;    ///< 截断次数
+};
+
+#endif // LINE_FRAMER_H
@@ -6,7 +6,9 @@
  */
 
 #include "log_manager.h"
+#include "log_ring.h"
 #include "config_manager.h"
+#include "../task_topology/task_topology.h"
 #include "../../include/constants.h"
 #include <Arduino.h>
 #include <stdarg.h>
@@ -18,7 +20,11 @@ LogManager::LogManager() :
     currentLogLevel(LOG_LEVEL_INFO),
     timestampEnabled(true),
     moduleTagEnabled(true),
-    initialized(false) {
+    initialized(false),
+    sinkRunning(false),
+    sinkHandle(nullptr),
+    serialSeq(0),
+    droppedCount(0) {
 }
 
 /**
@@ -47,9 +53,9 @@ bool LogManager::initialize() {
         return true;
     }
     
-    // 从配置管理器获取日志配置
-    ConfigManager& configManager = ConfigManager::getInstance();
-    SystemConfig sysConfig = configManager.getSystemConfig();
+    // 从运行配置快照获取日志配置
+    std::shared_ptr<const RuntimeConfig> config = ConfigManager::getInstance().getSnapshot();
+    const SystemConfig& sysConfig = config->system;
     
     // 设置日志级别
     setLogLevel(static_cast<LogLevel>(sysConfig.logLevel));
@@ -58,8 +64,15 @@ bool LogManager::initialize() {
     enableTimestamp(sysConfig.enableDebug);
     enableModuleTag(sysConfig.enableDebug);
     
+    // 分配内存日志缓冲区（供/api/logs查询）
+    bool ringReady = LogRing::getInstance().initialize();
+    
     initialized = true;
     
+    if (!ringReady) {
+        logWarn(LOG_MODULE_SYSTEM, "内存日志缓冲区分配失败，/api/logs不可用");
+    }
+    
     // 输出初始化信息
     logInfo(LOG_MODULE_SYSTEM, "日志管理器初始化完成");
     logInfo(LOG_MODULE_SYSTEM, "日志级别: " + getLevelName(currentLogLevel));
@@ -99,6 +112,16 @@ void LogManager::enableModuleTag(bool enable) {
     moduleTagEnabled = enable;
 }
 
+/**
+ * @brief 记录指定级别的日志
+ * @param level 日志级别
+ * @param module 模块标识
+ * @param message 日志消息
+ */
+void LogManager::write(LogLevel level, LogModule module, const String& message) {
+    output(level, module, message);
+}
+
 /**
  * @brief 记录错误日志
  * @param module 模块标识
@@ -194,26 +217,145 @@ void LogManager::output(LogLevel level, LogModule module, const String& message)
         return;
     }
     
-    String logLine = "";
+    LogRing& ring = LogRing::getInstance();
     
-    // 添加时间戳
+    // 异步模式：只写入内存日志缓冲区，由输出任务写串口
+    if (sinkRunning.load(std::memory_order_acquire)) {
+        ring.append((uint8_t)level, (uint8_t)module, message.c_str(), message.length());
+        return;
+    }
+    
+    // 输出任务启动前同步输出，行在栈上格式化，不做String拼接
+    char line[LOG_RING_MAX_MESSAGE + 64];
+    size_t length = formatLine(line, sizeof(line), millis(), level, module, message.c_str(), message.length());
+    Serial.write((const uint8_t*)line, length);
+    ring.append((uint8_t)level, (uint8_t)module, message.c_str(), message.length());
+}
+
+/**
+ * @brief 格式化一行日志（含前缀与行尾）
+ * @param out 输出缓冲区
+ * @param capacity 缓冲区容量
+ * @param uptimeMs 运行时间（毫秒）
+ * @param level 日志级别
+ * @param module 模块标识
+ * @param message 日志消息
+ * @param length 消息长度
+ * @return size_t 行长度
+ */
+size_t LogManager::formatLine(char* out, size_t capacity, uint32_t uptimeMs, LogLevel level, LogModule module,
+                              const char* message, size_t length) {
+    size_t used = 0;
     if (timestampEnabled) {
-        logLine += "[" + getTimestamp() + "] ";
+        unsigned long seconds = uptimeMs / 1000;
+        used += snprintf(out, capacity, "[%02lu:%02lu:%02lu.%03lu] ",
+                         (seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60, (unsigned long)(uptimeMs % 1000));
+    }
+    used += snprintf(out + used, capacity - used, "[%s] ", getLevelTag(level));
+    if (moduleTagEnabled) {
+        used += snprintf(out + used, capacity - used, "[%s] ", getModuleTag(module));
     }
     
-    // 添加日志级别
-    logLine += "[" + getLevelName(level) + "] ";
+    // 预留行尾，消息过长时截断
+    size_t room = capacity - used - 2;
+    if (length > room) {
+        length = room;
+    }
+    memcpy(out + used, message, length);
+    used += length;
+    out[used++] = '\r';
+    out[used++] = '\n';
+    return used;
+}
+
+/**
+ * @brief 启动异步输出任务
+ * @return true 启动成功
+ * @return false 启动失败
+ */
+bool LogManager::startAsyncSink() {
+    if (sinkRunning.load()) {
+        return true;
+    }
+    LogRing& ring = LogRing::getInstance();
+    if (!ring.isReady()) {
+        return false;
+    }
     
-    // 添加模块标识
-    if (moduleTagEnabled) {
-        logLine += "[" + getModuleName(module) + "] ";
+    {
+        // 已同步输出过的日志不再重复输出
+        std::lock_guard<std::mutex> lock(drainMutex);
+        serialSeq = ring.getNextSeq();
     }
     
-    // 添加消息内容
-    logLine += message;
+    if (!TaskTopology::getInstance().createTask(SYSTEM_TASK_LOG_SINK, sinkTask, this, &sinkHandle)) {
+        return false;
+    }
     
-    // 输出到串口
-    Serial.println(logLine);
+    sinkRunning.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief 异步输出任务入口
+ * @param parameter LogManager实例
+ */
+void LogManager::sinkTask(void* parameter) {
+    LogManager* manager = static_cast<LogManager*>(parameter);
+    while (true) {
+        if (manager->drainToSerial(LOG_SINK_BATCH) == 0) {
+            vTaskDelay(pdMS_TO_TICKS(LOG_SINK_POLL_MS));
+        }
+    }
+}
+
+/**
+ * @brief 将内存日志缓冲区中待输出的日志写到串口
+ * @param maxEntries 最多输出的条数
+ * @return size_t 输出的条数
+ */
+size_t LogManager::drainToSerial(size_t maxEntries) {
+    std::lock_guard<std::mutex> lock(drainMutex);
+    
+    char line[LOG_RING_MAX_MESSAGE + 64];
+    size_t printed = 0;
+    uint32_t lost = 0;
+    serialSeq = LogRing::getInstance().read(serialSeq, maxEntries, [&](const LogRecord& record) {
+        size_t length = formatLine(line, sizeof(line), record.uptimeMs, (LogLevel)record.level,
+                                   (LogModule)record.module, record.message, record.length);
+        Serial.write((const uint8_t*)line, length);
+        printed++;
+    }, lost);
+    
+    // 缓冲区在输出前被覆盖：记录丢弃数量，调用方从未因此阻塞
+    if (lost > 0) {
+        droppedCount.fetch_add(lost, std::memory_order_relaxed);
+        int length = snprintf(line, sizeof(line), "[LOG] %lu entries dropped\r\n", (unsigned long)lost);
+        Serial.write((const uint8_t*)line, length);
+    }
+    return printed + lost;
+}
+
+/**
+ * @brief 在调用方任务中输出所有待输出的日志
+ * @param timeoutMs 最长等待时间（毫秒）
+ */
+void LogManager::flush(unsigned long timeoutMs) {
+    if (!sinkRunning.load()) {
+        return;
+    }
+    unsigned long start = millis();
+    while (drainToSerial(LOG_SINK_BATCH) > 0 && millis() - start < timeoutMs) {
+    }
+    Serial.flush();
+}
+
+/**
+ * @brief 获取因串口输出跟不上而丢弃的日志条数
+ * @return uint32_t 丢弃条数
+ */
+uint32_t LogManager::getDroppedCount() const {
+    return droppedCount.load(std::memory_order_relaxed);
 }
 
 /**
@@ -222,6 +364,24 @@ void LogManager::output(LogLevel level, LogModule module, const String& message)
  * @return String 级别名称
  */
 String LogManager::getLevelName(LogLevel level) {
+    return String(getLevelTag(level));
+}
+
+/**
+ * @brief 获取模块名称
+ * @param module 模块标识
+ * @return String 模块名称
+ */
+String LogManager::getModuleName(LogModule module) {
+    return String(getModuleTag(module));
+}
+
+/**
+ * @brief 获取日志级别标识
+ * @param level 日志级别
+ * @return const char* 级别标识
+ */
+const char* LogManager::getLevelTag(LogLevel level) {
     switch (level) {
         case LOG_LEVEL_ERROR: return "ERROR";
         case LOG_LEVEL_WARN: return "WARN";
@@ -233,11 +393,11 @@ String LogManager::getLevelName(LogLevel level) {
 }
 
 /**
- * @brief 获取模块名称
+ * @brief 获取模块标识
  * @param module 模块标识
- * @return String 模块名称
+ * @return const char* 模块标识
  */
-String LogManager::getModuleName(LogModule module) {
+const char* LogManager::getModuleTag(LogModule module) {
     switch (module) {
         case LOG_MODULE_SYSTEM: return "SYS";
         case LOG_MODULE_GSM: return "GSM";
@@ -307,8 +467,8 @@ void LogManager::printStartupInfo() {
     printSeparator("ESP-SMS-Relay 系统启动");
     
     // 获取配置信息
-    ConfigManager& configManager = ConfigManager::getInstance();
-    SystemConfig sysConfig = configManager.getSystemConfig();
+    std::shared_ptr<const RuntimeConfig> config = ConfigManager::getInstance().getSnapshot();
+    const SystemConfig& sysConfig = config->system;
     
     logInfo(LOG_MODULE_SYSTEM, "设备名称: " + sysConfig.deviceName);
     logInfo(LOG_MODULE_SYSTEM, "固件版本: v1.0.0");
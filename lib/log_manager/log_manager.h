@@ -9,12 +9,19 @@
  * 2. 日志级别管理
  * 3. 日志格式化
  * 4. 日志过滤和控制
+ * 5. 异步输出：调用方只写入内存日志缓冲区，由低优先级任务输出到串口，
+ *    串口跟不上时丢弃并计数，不阻塞调用方
  */
 
 #ifndef LOG_MANAGER_H
 #define LOG_MANAGER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "../../include/constants.h"
 
 /**
  * @enum LogLevel
@@ -69,6 +76,27 @@ public:
      */
     bool initialize();
     
+    /**
+     * @brief 启动异步输出任务（此后日志不再在调用方的任务中写串口）
+     *
+     * 内存日志缓冲区不可用时保持同步输出
+     * @return true 启动成功
+     * @return false 启动失败
+     */
+    bool startAsyncSink();
+    
+    /**
+     * @brief 在调用方任务中输出所有待输出的日志（重启前调用）
+     * @param timeoutMs 最长等待时间（毫秒）
+     */
+    void flush(unsigned long timeoutMs = LOG_SINK_FLUSH_TIMEOUT_MS);
+    
+    /**
+     * @brief 获取因串口输出跟不上而丢弃的日志条数
+     * @return uint32_t 丢弃条数
+     */
+    uint32_t getDroppedCount() const;
+    
     /**
      * @brief 设置日志级别
      * @param level 日志级别
@@ -93,6 +121,24 @@ public:
      */
     void enableModuleTag(bool enable);
     
+    /**
+     * @brief 检查日志级别是否启用（供LOG_*宏在构造消息前判断）
+     * @param level 日志级别
+     * @return true 启用
+     * @return false 被过滤
+     */
+    bool isEnabled(LogLevel level) const {
+        return level <= currentLogLevel;
+    }
+    
+    /**
+     * @brief 记录指定级别的日志
+     * @param level 日志级别
+     * @param module 模块标识
+     * @param message 日志消息
+     */
+    void write(LogLevel level, LogModule module, const String& message);
+    
     /**
      * @brief 记录错误日志
      * @param module 模块标识
@@ -153,12 +199,58 @@ public:
      * @brief 打印系统启动信息
      */
     void printStartupInfo();
+    
+    /**
+     * @brief 获取日志级别标识
+     * @param level 日志级别
+     * @return const char* 级别标识（如"ERROR"）
+     */
+    static const char* getLevelTag(LogLevel level);
+    
+    /**
+     * @brief 获取模块标识
+     * @param module 模块标识
+     * @return const char* 模块标识（如"SMS"）
+     */
+    static const char* getModuleTag(LogModule module);
 
 private:
     LogLevel currentLogLevel;   ///< 当前日志级别
     bool timestampEnabled;      ///< 是否启用时间戳
     bool moduleTagEnabled;      ///< 是否启用模块标识
     bool initialized;           ///< 是否已初始化
+    std::atomic<bool> sinkRunning;          ///< 异步输出任务是否已启动
+    TaskHandle_t sinkHandle;                ///< 异步输出任务句柄
+    uint32_t serialSeq;                     ///< 下一条待输出到串口的日志序号
+    std::atomic<uint32_t> droppedCount;     ///< 丢弃的日志条数
+    std::mutex drainMutex;                  ///< 保证同一时刻只有一个任务输出日志
+    
+    /**
+     * @brief 异步输出任务入口
+     * @param parameter LogManager实例
+     */
+    static void sinkTask(void* parameter);
+    
+    /**
+     * @brief 将内存日志缓冲区中待输出的日志写到串口
+     * @param maxEntries 最多输出的条数
+     * @return size_t 输出的条数
+     */
+    size_t drainToSerial(size_t maxEntries);
+    
+    /**
+     * @brief 格式化一行日志（含前缀与行尾）
+     * @param out 输出缓冲区
+     * @param capacity 缓冲区容量
+     * @param uptimeMs 运行时间（毫秒）
+     * @param level 日志级别
+     * @param module 模块标识
+     * @param message 日志消息
+     * @param length 消息长度
+     * @return size_t 行长度
+     */
+    size_t formatLine(char* out, size_t capacity, uint32_t uptimeMs, LogLevel level, LogModule module,
+                      const char* message, size_t length);
     
     /**
      * @brief 输出日志
@@ -197,13 +289,54 @@ private:
     bool shouldLog(LogLevel level);
 };
 
+/**
+ * @def LOG_COMPILE_LEVEL
+ * @brief 编译期最低保留的日志级别（数值同LogLevel，可通过-DLOG_COMPILE_LEVEL=3等覆盖）
+ *
+ * 高于该级别的LOG_*宏调用在编译期即被消除，消息表达式不会生成代码
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 5
+#endif
+
+/**
+ * @brief 按级别记录日志：先做编译期与运行期级别检查，通过后才求值消息表达式
+ * @param level 日志级别
+ * @param module 模块标识
+ * @param message 消息表达式（被过滤时不求值，不产生String拼接）
+ */
+#define LOG_AT(level, module, message) \
+    do { \
+        if ((int)(level) <= LOG_COMPILE_LEVEL && LogManager::getInstance().isEnabled(level)) { \
+            LogManager::getInstance().write(level, module, message); \
+        } \
+    } while (0)
+
 // 便捷宏定义
-#define LOG_ERROR(module, message) LogManager::getInstance().logError(module, message)
-#define LOG_WARN(module, message) LogManager::getInstance().logWarn(module, message)
-#define LOG_INFO(module, message) LogManager::getInstance().logInfo(module, message)
-#define LOG_DEBUG(module, message) LogManager::getInstance().logDebug(module, message)
-#define LOG_VERBOSE(module, message) LogManager::getInstance().logVerbose(module, message)
+#define LOG_ERROR(module, message) LOG_AT(LOG_LEVEL_ERROR, module, message)
+#define LOG_WARN(module, message) LOG_AT(LOG_LEVEL_WARN, module, message)
+#define LOG_INFO(module, message) LOG_AT(LOG_LEVEL_INFO, module, message)
+#define LOG_DEBUG(module, message) LOG_AT(LOG_LEVEL_DEBUG, module, message)
+#define LOG_VERBOSE(module, message) LOG_AT(LOG_LEVEL_VERBOSE, module, message)
 
-#define LOGF(level, module, format, ...) LogManager::getInstance().logf(level, module, format, ##__VA_ARGS__)
+#define LOGF(level, module, format, ...) \
+    do { \
+        if ((int)(level) <= LOG_COMPILE_LEVEL && LogManager::getInstance().isEnabled(level)) { \
+            LogManager::getInstance().logf(level, module, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * @brief 模块调试输出：在具有debugMode成员与debugPrint()方法的类中使用
+ *
+ * 调试模式关闭或LOG_COMPILE_LEVEL低于LOG_LEVEL_DEBUG时不求值消息表达式
+ * @param message 消息表达式
+ */
+#define LOG_DEBUG_PRINT(message) \
+    do { \
+        if (LOG_COMPILE_LEVEL >= 4 && debugMode) { \
+            debugPrint(message); \
+        } \
+    } while (0)
 
 #endif // LOG_MANAGER_H
\ No newline at end of file
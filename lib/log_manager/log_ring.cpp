@@ -0,0 +1,210 @@
+/**
+ * @file log_ring.cpp
+ * @brief 内存日志环形缓冲区实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "log_ring.h"
+#include <esp_heap_caps.h>
+#include <time.h>
+#include <new>
+
+/**
+ * @brief 获取单例实例
+ * @return LogRing& 单例引用
+ */
+LogRing& LogRing::getInstance() {
+    static LogRing instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+LogRing::LogRing() : slots(nullptr), text(nullptr), nextSeq(0), textHead(0) {
+}
+
+/**
+ * @brief 分配条目槽位与文本区（优先PSRAM）
+ * @return true 分配成功
+ * @return false 分配失败
+ */
+bool LogRing::initialize() {
+    if (isReady()) {
+        return true;
+    }
+
+    size_t slotBytes = sizeof(Slot) * LOG_RING_ENTRIES;
+    void* slotMemory = heap_caps_malloc(slotBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    void* textMemory = heap_caps_malloc(LOG_RING_TEXT_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (slotMemory == nullptr || textMemory == nullptr) {
+        // 没有PSRAM时不占用内部内存，日志仍输出到串口
+        heap_caps_free(slotMemory);
+        heap_caps_free(textMemory);
+        return false;
+    }
+
+    Slot* newSlots = static_cast<Slot*>(slotMemory);
+    for (size_t i = 0; i < LOG_RING_ENTRIES; i++) {
+        new (&newSlots[i]) Slot();
+        newSlots[i].commit.store(0, std::memory_order_relaxed);
+    }
+    text = static_cast<char*>(textMemory);
+    std::atomic_thread_fence(std::memory_order_release);
+    slots = newSlots;
+    return true;
+}
+
+/**
+ * @brief 检查缓冲区是否可用
+ * @return true 可用
+ * @return false 不可用
+ */
+bool LogRing::isReady() const {
+    return slots != nullptr;
+}
+
+/**
+ * @brief 写入一条日志
+ * @param level 日志级别
+ * @param module 日志模块
+ * @param message 消息内容
+ * @param length 消息长度
+ */
+void LogRing::append(uint8_t level, uint8_t module, const char* message, size_t length) {
+    if (!isReady()) {
+        return;
+    }
+    if (length > LOG_RING_MAX_MESSAGE) {
+        length = LOG_RING_MAX_MESSAGE;
+    }
+
+    // 预留序号与文本空间后各写各的，写者之间互不等待
+    uint32_t seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+    uint32_t offset = textHead.fetch_add(length, std::memory_order_relaxed);
+    Slot& slot = slots[seq % LOG_RING_ENTRIES];
+
+    // 先撤销槽位上的旧条目，读者不会把新旧内容拼在一起
+    slot.commit.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    writeText(offset, message, length);
+    time_t now = time(nullptr);
+    slot.uptimeMs = millis();
+    slot.unixTime = now >= LOG_RING_MIN_VALID_TIME ? (uint32_t)now : 0;
+    slot.textOffset = offset;
+    slot.length = (uint16_t)length;
+    slot.level = level;
+    slot.module = module;
+
+    slot.commit.store(seq + 1, std::memory_order_release);
+}
+
+/**
+ * @brief 从指定序号开始读取日志
+ * @param since 起始序号
+ * @param limit 最多读取的条数
+ * @param visitor 读取回调
+ * @param lost 输出：已被覆盖而无法读取的条数
+ * @return uint32_t 下一次读取应使用的起始序号
+ */
+uint32_t LogRing::read(uint32_t since, size_t limit, const LogRecordVisitor& visitor, uint32_t& lost) const {
+    lost = 0;
+    uint32_t end = nextSeq.load(std::memory_order_acquire);
+    if (!isReady()) {
+        return end;
+    }
+
+    // 早于最旧槽位的条目已被覆盖
+    uint32_t oldest = end > LOG_RING_ENTRIES ? end - LOG_RING_ENTRIES : 0;
+    if (since > end) {
+        since = end;
+    }
+    if (since < oldest) {
+        lost += oldest - since;
+        since = oldest;
+    }
+
+    char buffer[LOG_RING_MAX_MESSAGE + 1];
+    size_t delivered = 0;
+    uint32_t seq = since;
+    for (; seq < end && delivered < limit; seq++) {
+        const Slot& slot = slots[seq % LOG_RING_ENTRIES];
+        uint32_t committed = slot.commit.load(std::memory_order_acquire);
+        if (committed != seq + 1) {
+            if (committed > seq + 1) {
+                // 槽位已被更新的条目覆盖
+                lost++;
+                continue;
+            }
+            // 仍在写入中：停在这里，下次从该序号继续
+            break;
+        }
+
+        LogRecord record;
+        record.seq = seq;
+        record.uptimeMs = slot.uptimeMs;
+        record.unixTime = slot.unixTime;
+        record.level = slot.level;
+        record.module = slot.module;
+        record.length = slot.length;
+        uint32_t offset = slot.textOffset;
+        readText(offset, buffer, record.length);
+        buffer[record.length] = '\0';
+
+        // 复制期间槽位或文本被覆盖时丢弃
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool slotIntact = slot.commit.load(std::memory_order_relaxed) == committed;
+        bool textIntact = textHead.load(std::memory_order_relaxed) - offset <= LOG_RING_TEXT_BYTES;
+        if (!slotIntact || !textIntact) {
+            lost++;
+            continue;
+        }
+
+        record.message = buffer;
+        visitor(record);
+        delivered++;
+    }
+    return seq;
+}
+
+/**
+ * @brief 获取下一条日志将使用的序号
+ * @return uint32_t 序号
+ */
+uint32_t LogRing::getNextSeq() const {
+    return nextSeq.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 在文本区的绝对偏移处写入数据
+ * @param offset 绝对偏移
+ * @param data 数据
+ * @param length 长度
+ */
+void LogRing::writeText(uint32_t offset, const char* data, size_t length) {
+    size_t start = offset % LOG_RING_TEXT_BYTES;
+    size_t first = LOG_RING_TEXT_BYTES - start;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(text + start, data, first);
+    memcpy(text, data + first, length - first);
+}
+
+/**
+ * @brief 从文本区的绝对偏移处读取数据
+ * @param offset 绝对偏移
+ * @param out 输出缓冲区
+ * @param length 长度
+ */
+void LogRing::readText(uint32_t offset, char* out, size_t length) const {
+    size_t start = offset % LOG_RING_TEXT_BYTES;
+    size_t first = LOG_RING_TEXT_BYTES - start;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(out, text + start, first);
+    memcpy(out + first, text, length - first);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file log_ring.h
+ * @brief 内存日志环形缓冲区 - 在PSRAM中保存最近的结构化日志，供/api/logs查询
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 固定数量的条目槽位（序号、时间、级别、模块、文本偏移与长度）与独立的文本区，
+ *    初始化时一次性分配，运行期不再申请堆内存
+ * 2. 任意任务无锁写入：序号与文本空间通过原子计数预留，写完后提交槽位序号
+ * 3. 按序号增量读取：读取时校验槽位序号与文本区位置，被覆盖的条目计为丢失
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+#include "../../include/constants.h"
+
+/**
+ * @struct LogRecord
+ * @brief 读取到的一条日志
+ */
+struct LogRecord {
+    uint32_t seq;           ///< 序号（从0开始连续递增）
+    uint32_t uptimeMs;      ///< 写入时的运行时间（毫秒）
+    uint32_t unixTime;      ///< 写入时的Unix时间（系统时间未同步时为0）
+    uint8_t level;          ///< 日志级别（LogLevel）
+    uint8_t module;         ///< 日志模块（LogModule）
+    const char* message;    ///< 消息内容（以'\0'结尾，仅在回调期间有效）
+    uint16_t length;        ///< 消息长度
+};
+
+/**
+ * @brief 日志读取回调
+ * @param record 日志
+ */
+typedef std::function<void(const LogRecord& record)> LogRecordVisitor;
+
+/**
+ * @class LogRing
+ * @brief 无锁多写者日志环形缓冲区
+ */
+class LogRing {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return LogRing& 单例引用
+     */
+    static LogRing& getInstance();
+
+    /**
+     * @brief 分配条目槽位与文本区（优先PSRAM）
+     * @return true 分配成功
+     * @return false 分配失败（写入将被忽略）
+     */
+    bool initialize();
+
+    /**
+     * @brief 检查缓冲区是否可用
+     * @return true 可用
+     * @return false 不可用
+     */
+    bool isReady() const;
+
+    /**
+     * @brief 写入一条日志（可在任意任务中调用）
+     * @param level 日志级别
+     * @param module 日志模块
+     * @param message 消息内容
+     * @param length 消息长度（超过LOG_RING_MAX_MESSAGE时截断）
+     */
+    void append(uint8_t level, uint8_t module, const char* message, size_t length);
+
+    /**
+     * @brief 从指定序号开始读取日志
+     * @param since 起始序号（早于最旧可用条目时从最旧条目开始）
+     * @param limit 最多读取的条数
+     * @param visitor 读取回调
+     * @param lost 输出：起始序号之后已被覆盖而无法读取的条数
+     * @return uint32_t 下一次读取应使用的起始序号
+     */
+    uint32_t read(uint32_t since, size_t limit, const LogRecordVisitor& visitor, uint32_t& lost) const;
+
+    /**
+     * @brief 获取下一条日志将使用的序号
+     * @return uint32_t 序号
+     */
+    uint32_t getNextSeq() const;
+
+private:
+    /**
+     * @struct Slot
+     * @brief 条目槽位
+     */
+    struct Slot {
+        std::atomic<uint32_t> commit;   ///< 已提交条目的序号+1（0表示写入中或为空）
+        uint32_t uptimeMs;              ///< 运行时间（毫秒）
+        uint32_t unixTime;              ///< Unix时间
+        uint32_t textOffset;            ///< 文本在文本流中的绝对偏移
+        uint16_t length;                ///< 文本长度
+        uint8_t level;                  ///< 日志级别
+        uint8_t module;                 ///< 日志模块
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    LogRing();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    LogRing(const LogRing&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    LogRing& operator=(const LogRing&) = delete;
+
+    /**
+     * @brief 在文本区的绝对偏移处写入数据（跨越末尾时回绕）
+     * @param offset 绝对偏移
+     * @param data 数据
+     * @param length 长度
+     */
+    void writeText(uint32_t offset, const char* data, size_t length);
+
+    /**
+     * @brief 从文本区的绝对偏移处读取数据（跨越末尾时回绕）
+     * @param offset 绝对偏移
+     * @param out 输出缓冲区
+     * @param length 长度
+     */
+    void readText(uint32_t offset, char* out, size_t length) const;
+
+private:
+    Slot* slots;                        ///< 条目槽位（LOG_RING_ENTRIES个）
+    char* text;                         ///< 文本区（LOG_RING_TEXT_BYTES字节）
+    std::atomic<uint32_t> nextSeq;      ///< 下一条日志的序号
+    std::atomic<uint32_t> textHead;     ///< 文本流已预留的总字节数
+};
+
+#endif // LOG_RING_H
@@ -0,0 +1,182 @@
+/**
+ * @file memory_pressure.cpp
+ * @brief 内存压力管理实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "memory_pressure.h"
+#include "../database_manager/database_manager.h"
+#include "../db_worker/db_worker.h"
+#include "../log_manager/log_manager.h"
+#include "../push_manager/push_manager.h"
+#include "../web_server/web_server.h"
+#include "../../include/constants.h"
+#include <esp_heap_caps.h>
+
+/**
+ * @brief 各等级的进入阈值（最大连续空闲块低于该值时进入）
+ */
+static const size_t LEVEL_THRESHOLDS[] = {
+    0,
+    MEMORY_PRESSURE_ELEVATED_BYTES,
+    MEMORY_PRESSURE_HIGH_BYTES,
+    MEMORY_PRESSURE_CRITICAL_BYTES,
+    MEMORY_PRESSURE_FATAL_BYTES
+};
+
+/**
+ * @brief 获取单例实例
+ * @return MemoryPressureManager& 单例引用
+ */
+MemoryPressureManager& MemoryPressureManager::getInstance() {
+    static MemoryPressureManager instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+MemoryPressureManager::MemoryPressureManager()
+    : level(MEMORY_PRESSURE_NORMAL), fatalChecks(0), lastFreeHeap(0), lastLargestBlock(0) {
+}
+
+/**
+ * @brief 采样内部堆并按压力等级降载或恢复
+ */
+void MemoryPressureManager::check() {
+    lastFreeHeap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    lastLargestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    MemoryPressureLevel next = classify(lastLargestBlock);
+    if (next != level) {
+        applyLevel(next);
+    } else if (level >= MEMORY_PRESSURE_ELEVATED && level < MEMORY_PRESSURE_FATAL) {
+        // 维持在紧张状态时持续回收缓存，新打开的页面不会一直占用
+        trimCaches();
+    }
+
+    if (level != MEMORY_PRESSURE_FATAL) {
+        fatalChecks = 0;
+        return;
+    }
+    if (++fatalChecks >= MEMORY_PRESSURE_FATAL_CHECKS) {
+        restartAfterCommit();
+    }
+}
+
+/**
+ * @brief 获取当前压力等级
+ * @return MemoryPressureLevel 压力等级
+ */
+MemoryPressureLevel MemoryPressureManager::getLevel() const {
+    return level;
+}
+
+/**
+ * @brief 获取压力等级名称
+ * @param level 压力等级
+ * @return const char* 等级名称
+ */
+const char* MemoryPressureManager::getLevelName(MemoryPressureLevel level) {
+    switch (level) {
+        case MEMORY_PRESSURE_NORMAL: return "normal";
+        case MEMORY_PRESSURE_ELEVATED: return "elevated";
+        case MEMORY_PRESSURE_HIGH: return "high";
+        case MEMORY_PRESSURE_CRITICAL: return "critical";
+        case MEMORY_PRESSURE_FATAL: return "fatal";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief 获取内存压力状态描述
+ * @return String 状态描述
+ */
+String MemoryPressureManager::getStatusInfo() const {
+    return String(getLevelName(level)) + " (free " + String(lastFreeHeap) +
+           " bytes, largest block " + String(lastLargestBlock) + " bytes)";
+}
+
+/**
+ * @brief 按最大连续空闲块计算压力等级
+ * @param largestBlock 最大连续空闲块（字节）
+ * @return MemoryPressureLevel 压力等级
+ */
+MemoryPressureLevel MemoryPressureManager::classify(size_t largestBlock) const {
+    int next = MEMORY_PRESSURE_NORMAL;
+    for (int i = MEMORY_PRESSURE_ELEVATED; i <= MEMORY_PRESSURE_FATAL; i++) {
+        // 已进入的等级需回升到阈值加回差以上才退出，避免在阈值附近来回切换
+        size_t threshold = LEVEL_THRESHOLDS[i];
+        if (i <= level) {
+            threshold += MEMORY_PRESSURE_HYSTERESIS_BYTES;
+        }
+        if (largestBlock < threshold) {
+            next = i;
+        }
+    }
+    return (MemoryPressureLevel)next;
+}
+
+/**
+ * @brief 切换压力等级，执行进入或离开各等级时的降载与恢复
+ * @param next 新等级
+ */
+void MemoryPressureManager::applyLevel(MemoryPressureLevel next) {
+    LogManager& logManager = LogManager::getInstance();
+    String message = "内存压力 " + String(getLevelName(level)) + " -> " + String(getLevelName(next)) +
+                     "（空闲 " + String(lastFreeHeap) + " 字节，最大连续块 " + String(lastLargestBlock) + " 字节）";
+    if (next > level) {
+        logManager.logWarn(LOG_MODULE_SYSTEM, message);
+    } else {
+        logManager.logInfo(LOG_MODULE_SYSTEM, message);
+    }
+
+    if (next >= MEMORY_PRESSURE_ELEVATED) {
+        trimCaches();
+    }
+
+    WebServer& webServer = WebServer::getInstance();
+    if (next >= MEMORY_PRESSURE_HIGH) {
+        webServer.pause();
+    } else {
+        webServer.resume();
+    }
+
+    PushManager::getInstance().setPushPaused(next >= MEMORY_PRESSURE_CRITICAL);
+    level = next;
+}
+
+/**
+ * @brief 释放SQLite页面缓存并输出积压日志
+ */
+void MemoryPressureManager::trimCaches() {
+    // 页面缓存只能在持有连接的数据库工作线程中释放；队列已满时本轮跳过
+    DbWorker::getInstance().post([]() {
+        DatabaseManager::getInstance().releaseMemory();
+    });
+    LogManager::getInstance().flush();
+}
+
+/**
+ * @brief 提交合并写入窗口，成功后重启系统
+ * @return false 提交失败（不重启，下次检查时重试）
+ */
+bool MemoryPressureManager::restartAfterCommit() {
+    LogManager& logManager = LogManager::getInstance();
+    bool committed = false;
+    bool executed = DbWorker::getInstance().call([&committed]() {
+        committed = DatabaseManager::getInstance().flushGroupCommit(true);
+    });
+    if (!executed || !committed) {
+        logManager.logError(LOG_MODULE_SYSTEM, "内存耗尽，但数据库提交未完成，暂不重启: " +
+                            (executed ? DatabaseManager::getInstance().getLastError()
+                                      : DbWorker::getInstance().getLastError()));
+        return false;
+    }
+
+    logManager.logError(LOG_MODULE_SYSTEM, "内存耗尽，数据库已提交，重启系统: " + getStatusInfo());
+    logManager.flush();
+    ESP.restart();
+    return true;
+}
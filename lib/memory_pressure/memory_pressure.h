@@ -0,0 +1,114 @@
+/**
+ * @file memory_pressure.h
+ * @brief 内存压力管理 - 内部堆紧张时逐级降载，必要时提交数据库后重启
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以内部堆最大连续空闲块（而非空闲总量）判断内存压力，碎片化导致的分配失败也能提前发现
+ * 2. 逐级降载：释放SQLite页面缓存并输出积压日志 → 暂停Web服务器 → 暂停推送（写入发件箱稍后补发）
+ * 3. 内存回升超过阈值加回差后逐级恢复
+ * 4. 持续处于最低档时，先提交合并写入窗口，提交成功后才重启系统
+ */
+
+#ifndef MEMORY_PRESSURE_H
+#define MEMORY_PRESSURE_H
+
+#include <Arduino.h>
+
+/**
+ * @enum MemoryPressureLevel
+ * @brief 内存压力等级（数值越大越紧张，各级包含更低等级的降载措施）
+ */
+enum MemoryPressureLevel {
+    MEMORY_PRESSURE_NORMAL = 0,     ///< 正常
+    MEMORY_PRESSURE_ELEVATED,       ///< 偏紧：释放页面缓存、输出积压日志
+    MEMORY_PRESSURE_HIGH,           ///< 紧张：暂停Web服务器
+    MEMORY_PRESSURE_CRITICAL,       ///< 严重：暂停推送
+    MEMORY_PRESSURE_FATAL           ///< 耗尽：提交数据库后重启
+};
+
+/**
+ * @class MemoryPressureManager
+ * @brief 内存压力管理类（由定时任务在loop()中驱动）
+ */
+class MemoryPressureManager {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return MemoryPressureManager& 单例引用
+     */
+    static MemoryPressureManager& getInstance();
+
+    /**
+     * @brief 采样内部堆并按压力等级降载或恢复（每MEMORY_PRESSURE_CHECK_INTERVAL_MS调用一次）
+     */
+    void check();
+
+    /**
+     * @brief 获取当前压力等级
+     * @return MemoryPressureLevel 压力等级
+     */
+    MemoryPressureLevel getLevel() const;
+
+    /**
+     * @brief 获取压力等级名称
+     * @param level 压力等级
+     * @return const char* 等级名称
+     */
+    static const char* getLevelName(MemoryPressureLevel level);
+
+    /**
+     * @brief 获取内存压力状态描述
+     * @return String 状态描述
+     */
+    String getStatusInfo() const;
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    MemoryPressureManager();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    MemoryPressureManager(const MemoryPressureManager&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    MemoryPressureManager& operator=(const MemoryPressureManager&) = delete;
+
+    /**
+     * @brief 按最大连续空闲块计算压力等级（当前等级以下的阈值需高出回差才算恢复）
+     * @param largestBlock 最大连续空闲块（字节）
+     * @return MemoryPressureLevel 压力等级
+     */
+    MemoryPressureLevel classify(size_t largestBlock) const;
+
+    /**
+     * @brief 切换压力等级，执行进入或离开各等级时的降载与恢复
+     * @param level 新等级
+     */
+    void applyLevel(MemoryPressureLevel level);
+
+    /**
+     * @brief 释放SQLite页面缓存并输出积压日志
+     */
+    void trimCaches();
+
+    /**
+     * @brief 提交合并写入窗口，成功后重启系统
+     * @return false 提交失败（不重启，下次检查时重试）
+     */
+    bool restartAfterCommit();
+
+private:
+    MemoryPressureLevel level;          ///< 当前压力等级
+    int fatalChecks;                    ///< 连续处于最低档的检查次数
+    size_t lastFreeHeap;                ///< 最近一次采样的内部堆空闲总量
+    size_t lastLargestBlock;            ///< 最近一次采样的最大连续空闲块
+};
+
+#endif // MEMORY_PRESSURE_H
@@ -0,0 +1,431 @@
+/**
+ * @file message_arena.cpp
+ * @brief 单条短信的推送内存区实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "message_arena.h"
+#include "../metrics/metrics.h"
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// 每块内存前的头部（记录块大小），同时决定对齐
+static const size_t BLOCK_HEADER_SIZE = 8;
+
+/// lastBlock无效值
+static const size_t NO_BLOCK = (size_t)-1;
+
+/**
+ * @brief 按块头部大小向上对齐
+ * @param size 字节数
+ * @return size_t 对齐后的字节数
+ */
+static size_t alignBlock(size_t size) {
+    return (size + BLOCK_HEADER_SIZE - 1) & ~(BLOCK_HEADER_SIZE - 1);
+}
+
+std::atomic<MessageArena*> MessageArena::bound(nullptr);
+std::atomic<MessageArena*> MessageArena::registered(nullptr);
+
+/**
+ * @brief 构造函数（未分配内存）
+ */
+MessageArena::MessageArena()
+    : buffer(nullptr), capacity(0), used(0), lastBlock(NO_BLOCK), owner(nullptr), stats(), overflows(0) {
+}
+
+/**
+ * @brief 析构函数
+ */
+MessageArena::~MessageArena() {
+    if (buffer != nullptr) {
+        heap_caps_free(buffer);
+    }
+}
+
+/**
+ * @brief 分配内存区（优先使用PSRAM）
+ * @param capacity 容量（字节）
+ * @return true 分配成功
+ * @return false 分配失败（此后的分配全部回退到堆）
+ */
+bool MessageArena::initialize(size_t capacity) {
+    if (buffer != nullptr) {
+        return true;
+    }
+    capacity = alignBlock(capacity);
+    buffer = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buffer == nullptr) {
+        buffer = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_8BIT);
+    }
+    if (buffer == nullptr) {
+        return false;
+    }
+    this->capacity = capacity;
+    stats.capacity = capacity;
+    registered.store(this);
+    return true;
+}
+
+/**
+ * @brief 当前任务启用的内存区
+ * @return MessageArena* 内存区，当前任务未启用时返回nullptr
+ */
+MessageArena* MessageArena::current() {
+    MessageArena* arena = bound.load();
+    return (arena != nullptr && arena->owner == xTaskGetCurrentTaskHandle()) ? arena : nullptr;
+}
+
+/**
+ * @brief 分配内存：优先从当前任务的内存区分配，否则从堆分配
+ * @param size 字节数
+ * @return void* 内存，失败返回nullptr
+ */
+void* MessageArena::allocateBlock(size_t size) {
+    MessageArena* arena = current();
+    if (arena != nullptr) {
+        void* block = arena->allocate(size);
+        if (block != nullptr) {
+            return block;
+        }
+        arena->overflows++;
+        MetricsRegistry::getInstance().increment(METRIC_MESSAGE_ARENA_OVERFLOWS);
+    }
+    return malloc(size);
+}
+
+/**
+ * @brief 调整allocateBlock()所分配内存的大小
+ * @param ptr 原内存（nullptr时等同allocateBlock）
+ * @param size 新字节数
+ * @return void* 新内存，失败返回nullptr（原内存保持不变）
+ */
+void* MessageArena::reallocateBlock(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return allocateBlock(size);
+    }
+
+    MessageArena* arena = registered.load();
+    if (arena == nullptr || !arena->owns(ptr)) {
+        return realloc(ptr, size);
+    }
+
+    void* block = arena->reallocate(ptr, size);
+    if (block != nullptr) {
+        return block;
+    }
+
+    // 内存区容量不足：迁移到堆
+    arena->overflows++;
+    MetricsRegistry::getInstance().increment(METRIC_MESSAGE_ARENA_OVERFLOWS);
+    block = malloc(size);
+    if (block != nullptr) {
+        size_t oldSize = blockSize(ptr);
+        memcpy(block, ptr, oldSize < size ? oldSize : size);
+        arena->release(ptr);
+    }
+    return block;
+}
+
+/**
+ * @brief 释放allocateBlock()所分配的内存（内存区中的内存只有最后一块会被收回）
+ * @param ptr 内存
+ */
+void MessageArena::releaseBlock(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    MessageArena* arena = registered.load();
+    if (arena != nullptr && arena->owns(ptr)) {
+        arena->release(ptr);
+        return;
+    }
+    free(ptr);
+}
+
+/**
+ * @brief 获取统计信息
+ * @return MessageArenaStats 统计信息
+ */
+MessageArenaStats MessageArena::getStats() const {
+    MessageArenaStats result = stats;
+    result.overflows = overflows.load();
+    return result;
+}
+
+/**
+ * @brief 从内存区分配
+ * @param size 字节数
+ * @return void* 内存，容量不足时返回nullptr
+ */
+void* MessageArena::allocate(size_t size) {
+    size_t needed = BLOCK_HEADER_SIZE + alignBlock(size);
+    if (size > capacity || needed > capacity - used) {
+        return nullptr;
+    }
+    uint8_t* header = buffer + used;
+    *reinterpret_cast<size_t*>(header) = size;
+    lastBlock = used;
+    used += needed;
+    return header + BLOCK_HEADER_SIZE;
+}
+
+/**
+ * @brief 调整内存区中一块内存的大小（最后一块原地扩展）
+ * @param ptr 原内存
+ * @param size 新字节数
+ * @return void* 新内存，容量不足时返回nullptr
+ */
+void* MessageArena::reallocate(void* ptr, size_t size) {
+    uint8_t* header = static_cast<uint8_t*>(ptr) - BLOCK_HEADER_SIZE;
+    size_t offset = header - buffer;
+
+    if (offset == lastBlock) {
+        size_t needed = BLOCK_HEADER_SIZE + alignBlock(size);
+        if (size > capacity || needed > capacity - offset) {
+            return nullptr;
+        }
+        *reinterpret_cast<size_t*>(header) = size;
+        used = offset + needed;
+        return ptr;
+    }
+
+    size_t oldSize = blockSize(ptr);
+    if (size <= oldSize) {
+        *reinterpret_cast<size_t*>(header) = size;
+        return ptr;
+    }
+    void* block = allocate(size);
+    if (block != nullptr) {
+        memcpy(block, ptr, oldSize);
+    }
+    return block;
+}
+
+/**
+ * @brief 释放内存区中的一块内存
+ * @param ptr 内存
+ */
+void MessageArena::release(void* ptr) {
+    size_t offset = static_cast<uint8_t*>(ptr) - BLOCK_HEADER_SIZE - buffer;
+    if (offset == lastBlock) {
+        // 只有最后一块可以收回；此前的块要等复位时一并释放
+        used = offset;
+        lastBlock = NO_BLOCK;
+    }
+}
+
+/**
+ * @brief 内存是否位于内存区中
+ * @param ptr 内存
+ * @return true 位于内存区
+ * @return false 来自堆
+ */
+bool MessageArena::owns(const void* ptr) const {
+    const uint8_t* address = static_cast<const uint8_t*>(ptr);
+    return buffer != nullptr && address >= buffer && address < buffer + capacity;
+}
+
+/**
+ * @brief 复位内存区，记录本次用量
+ */
+void MessageArena::reset() {
+    stats.lastUsed = used;
+    if (used > stats.peakUsed) {
+        stats.peakUsed = used;
+        MetricsRegistry::getInstance().setGauge(METRIC_MESSAGE_ARENA_PEAK, (int64_t)stats.peakUsed);
+    }
+    stats.resets++;
+    used = 0;
+    lastBlock = NO_BLOCK;
+}
+
+/**
+ * @brief 获取一块内存的大小
+ * @param ptr 内存
+ * @return size_t 字节数
+ */
+size_t MessageArena::blockSize(const void* ptr) {
+    return *reinterpret_cast<const size_t*>(static_cast<const uint8_t*>(ptr) - BLOCK_HEADER_SIZE);
+}
+
+/**
+ * @brief 构造函数：在当前任务中启用内存区
+ * @param arena 内存区（未分配内存时不启用）
+ */
+ArenaScope::ArenaScope(MessageArena& arena) : arena(nullptr) {
+    if (arena.buffer == nullptr) {
+        return;
+    }
+    MessageArena* expected = nullptr;
+    if (MessageArena::bound.compare_exchange_strong(expected, &arena)) {
+        arena.owner = xTaskGetCurrentTaskHandle();
+        this->arena = &arena;
+    }
+}
+
+/**
+ * @brief 析构函数：停用并复位内存区
+ */
+ArenaScope::~ArenaScope() {
+    if (arena == nullptr) {
+        return;
+    }
+    MessageArena::bound.store(nullptr);
+    arena->owner = nullptr;
+    arena->reset();
+}
+
+/**
+ * @brief 构造函数（空缓冲区）
+ */
+ArenaText::ArenaText() : data(nullptr), len(0), capacity(0) {
+}
+
+/**
+ * @brief 析构函数
+ */
+ArenaText::~ArenaText() {
+    MessageArena::releaseBlock(data);
+}
+
+/**
+ * @brief 预留容量
+ * @param size 字节数（不含结尾的'\0'）
+ * @return true 预留成功
+ * @return false 内存不足
+ */
+bool ArenaText::reserve(size_t size) {
+    if (data != nullptr && size <= capacity) {
+        return true;
+    }
+    char* grown = static_cast<char*>(MessageArena::reallocateBlock(data, size + 1));
+    if (grown == nullptr) {
+        return false;
+    }
+    if (data == nullptr) {
+        grown[0] = '\0';
+    }
+    data = grown;
+    capacity = size;
+    return true;
+}
+
+/**
+ * @brief 追加数据
+ * @param text 数据
+ * @param length 长度
+ * @return true 追加成功
+ * @return false 内存不足（内容保持不变）
+ */
+bool ArenaText::concat(const char* text, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+    if (len + length > capacity) {
+        // 按1.5倍增长；最后一块在内存区中原地扩展，不产生复制
+        size_t grownCapacity = capacity + capacity / 2;
+        if (!reserve(grownCapacity > len + length ? grownCapacity : len + length)) {
+            return false;
+        }
+    }
+    memcpy(data + len, text, length);
+    len += length;
+    data[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief 追加字符串
+ * @param text 字符串
+ * @return true 追加成功
+ * @return false 内存不足
+ */
+bool ArenaText::concat(const String& text) {
+    return concat(text.c_str(), text.length());
+}
+
+/**
+ * @brief 追加C字符串
+ * @param text 以'\0'结尾的字符串
+ * @return true 追加成功
+ * @return false 内存不足
+ */
+bool ArenaText::concat(const char* text) {
+    return concat(text, strlen(text));
+}
+
+/**
+ * @brief 清空内容（保留容量）
+ */
+void ArenaText::clear() {
+    len = 0;
+    if (data != nullptr) {
+        data[0] = '\0';
+    }
+}
+
+/**
+ * @brief 获取内容
+ * @return const char* 以'\0'结尾的内容
+ */
+const char* ArenaText::c_str() const {
+    return data != nullptr ? data : "";
+}
+
+/**
+ * @brief 获取长度
+ * @return size_t 字节数
+ */
+size_t ArenaText::length() const {
+    return len;
+}
+
+/**
+ * @brief 是否为空
+ * @return true 空
+ * @return false 非空
+ */
+bool ArenaText::isEmpty() const {
+    return len == 0;
+}
+
+/**
+ * @brief 复制为堆上的String（调试输出等需要String的场合）
+ * @return String 内容副本
+ */
+String ArenaText::toString() const {
+    return String(c_str());
+}
+
+size_t ArenaText::write(uint8_t c) {
+    char ch = (char)c;
+    return concat(&ch, 1) ? 1 : 0;
+}
+
+size_t ArenaText::write(const uint8_t* buffer, size_t length) {
+    return concat(reinterpret_cast<const char*>(buffer), length) ? length : 0;
+}
+
+/**
+ * @brief 获取分配器实例
+ * @return ArenaJsonAllocator* 分配器
+ */
+ArenaJsonAllocator* ArenaJsonAllocator::instance() {
+    static ArenaJsonAllocator allocator;
+    return &allocator;
+}
+
+void* ArenaJsonAllocator::allocate(size_t size) {
+    return MessageArena::allocateBlock(size);
+}
+
+void ArenaJsonAllocator::deallocate(void* ptr) {
+    MessageArena::releaseBlock(ptr);
+}
+
+void* ArenaJsonAllocator::reallocate(void* ptr, size_t newSize) {
+    return MessageArena::reallocateBlock(ptr, newSize);
+}
@@ -0,0 +1,303 @@
+/**
+ * @file message_arena.h
+ * @brief 单条短信的推送内存区 - 推送期间的临时字符串与JSON分配在一块PSRAM中顺序分配，推送结束后整体释放
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. MessageArena：启动时一次性分配的定长内存区，按序分配、不单独释放，一条短信推送完成后整体复位，
+ *    推送过程中的短命对象不再在内部RAM中反复分配释放造成碎片
+ * 2. ArenaScope：在当前任务中启用内存区，离开作用域时复位
+ * 3. ArenaText：可增长的字符缓冲区（可作为Print输出目标，serializeJson可直接写入）
+ * 4. ArenaJsonAllocator：ArduinoJson分配器，JsonDocument的内存池分配在内存区中
+ *
+ * 未启用内存区的任务（Web、CLI中的测试推送等）或内存区用尽时自动回退到堆分配
+ */
+
+#ifndef MESSAGE_ARENA_H
+#define MESSAGE_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "../../include/constants.h"
+
+/**
+ * @struct MessageArenaStats
+ * @brief 内存区统计信息
+ */
+struct MessageArenaStats {
+    size_t capacity;                ///< 容量（字节）
+    size_t lastUsed;                ///< 上一条短信用量（字节）
+    size_t peakUsed;                ///< 单条短信最大用量（字节）
+    uint32_t resets;                ///< 复位次数（即处理的短信数）
+    uint32_t overflows;             ///< 内存区用尽、回退到堆的分配次数
+};
+
+/**
+ * @class MessageArena
+ * @brief 顺序分配的定长内存区
+ *
+ * 系统中只有一个内存区（由推送工作线程持有），只在启用它的任务中使用（非线程安全）；
+ * 复位后此前分配的内存全部失效，分配在其中的对象不得越过ArenaScope的生命周期
+ */
+class MessageArena {
+public:
+    /**
+     * @brief 构造函数（未分配内存）
+     */
+    MessageArena();
+
+    /**
+     * @brief 析构函数
+     */
+    ~MessageArena();
+
+    /**
+     * @brief 分配内存区（优先使用PSRAM）
+     * @param capacity 容量（字节）
+     * @return true 分配成功
+     * @return false 分配失败（此后的分配全部回退到堆）
+     */
+    bool initialize(size_t capacity);
+
+    /**
+     * @brief 当前任务启用的内存区
+     * @return MessageArena* 内存区，当前任务未启用时返回nullptr
+     */
+    static MessageArena* current();
+
+    /**
+     * @brief 分配内存：优先从当前任务的内存区分配，否则从堆分配
+     * @param size 字节数
+     * @return void* 内存，失败返回nullptr
+     */
+    static void* allocateBlock(size_t size);
+
+    /**
+     * @brief 调整allocateBlock()所分配内存的大小
+     * @param ptr 原内存（nullptr时等同allocateBlock）
+     * @param size 新字节数
+     * @return void* 新内存，失败返回nullptr（原内存保持不变）
+     */
+    static void* reallocateBlock(void* ptr, size_t size);
+
+    /**
+     * @brief 释放allocateBlock()所分配的内存（内存区中的内存只有最后一块会被收回）
+     * @param ptr 内存
+     */
+    static void releaseBlock(void* ptr);
+
+    /**
+     * @brief 获取统计信息
+     * @return MessageArenaStats 统计信息
+     */
+    MessageArenaStats getStats() const;
+
+private:
+    friend class ArenaScope;
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    MessageArena(const MessageArena&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    MessageArena& operator=(const MessageArena&) = delete;
+
+    /**
+     * @brief 从内存区分配
+     * @param size 字节数
+     * @return void* 内存，容量不足时返回nullptr
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief 调整内存区中一块内存的大小（最后一块原地扩展）
+     * @param ptr 原内存
+     * @param size 新字节数
+     * @return void* 新内存，容量不足时返回nullptr
+     */
+    void* reallocate(void* ptr, size_t size);
+
+    /**
+     * @brief 释放内存区中的一块内存
+     * @param ptr 内存
+     */
+    void release(void* ptr);
+
+    /**
+     * @brief 内存是否位于内存区中
+     * @param ptr 内存
+     * @return true 位于内存区
+     * @return false 来自堆
+     */
+    bool owns(const void* ptr) const;
+
+    /**
+     * @brief 复位内存区，记录本次用量
+     */
+    void reset();
+
+    /**
+     * @brief 获取一块内存的大小
+     * @param ptr 内存
+     * @return size_t 字节数
+     */
+    static size_t blockSize(const void* ptr);
+
+private:
+    uint8_t* buffer;                        ///< 内存区起始地址
+    size_t capacity;                        ///< 容量（字节）
+    size_t used;                            ///< 已用字节数
+    size_t lastBlock;                       ///< 最后一块内存的头部偏移（可原地扩展或收回）
+    TaskHandle_t owner;                     ///< 启用内存区的任务
+    MessageArenaStats stats;                ///< 统计信息
+    std::atomic<uint32_t> overflows;        ///< 回退到堆的分配次数
+
+    static std::atomic<MessageArena*> bound;        ///< 已启用的内存区（同一时刻只有一个任务启用）
+    static std::atomic<MessageArena*> registered;   ///< 已分配的内存区（用于判断一块内存的来源）
+};
+
+/**
+ * @class ArenaScope
+ * @brief 在当前任务中启用内存区，析构时复位（作用域内分配的对象须先于它销毁）
+ */
+class ArenaScope {
+public:
+    /**
+     * @brief 构造函数：在当前任务中启用内存区
+     * @param arena 内存区（未分配内存时不启用）
+     */
+    explicit ArenaScope(MessageArena& arena);
+
+    /**
+     * @brief 析构函数：停用并复位内存区
+     */
+    ~ArenaScope();
+
+private:
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    MessageArena* arena;                    ///< 已启用的内存区（未启用时为nullptr）
+};
+
+/**
+ * @class ArenaText
+ * @brief 分配在内存区中的可增长字符缓冲区
+ *
+ * 接口与String的常用部分一致；内容始终以'\0'结尾
+ */
+class ArenaText : public Print {
+public:
+    /**
+     * @brief 构造函数（空缓冲区）
+     */
+    ArenaText();
+
+    /**
+     * @brief 析构函数
+     */
+    ~ArenaText();
+
+    /**
+     * @brief 预留容量
+     * @param size 字节数（不含结尾的'\0'）
+     * @return true 预留成功
+     * @return false 内存不足
+     */
+    bool reserve(size_t size);
+
+    /**
+     * @brief 追加数据
+     * @param data 数据
+     * @param length 长度
+     * @return true 追加成功
+     * @return false 内存不足（内容保持不变）
+     */
+    bool concat(const char* data, size_t length);
+
+    /**
+     * @brief 追加字符串
+     * @param text 字符串
+     * @return true 追加成功
+     * @return false 内存不足
+     */
+    bool concat(const String& text);
+
+    /**
+     * @brief 追加C字符串
+     * @param text 以'\0'结尾的字符串
+     * @return true 追加成功
+     * @return false 内存不足
+     */
+    bool concat(const char* text);
+
+    /**
+     * @brief 清空内容（保留容量）
+     */
+    void clear();
+
+    /**
+     * @brief 获取内容
+     * @return const char* 以'\0'结尾的内容
+     */
+    const char* c_str() const;
+
+    /**
+     * @brief 获取长度
+     * @return size_t 字节数
+     */
+    size_t length() const;
+
+    /**
+     * @brief 是否为空
+     * @return true 空
+     * @return false 非空
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief 复制为堆上的String（调试输出等需要String的场合）
+     * @return String 内容副本
+     */
+    String toString() const;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+
+private:
+    ArenaText(const ArenaText&) = delete;
+    ArenaText& operator=(const ArenaText&) = delete;
+
+    char* data;                             ///< 内容（nullptr表示尚未分配）
+    size_t len;                             ///< 长度
+    size_t capacity;                        ///< 容量（不含结尾的'\0'）
+};
+
+/**
+ * @class ArenaJsonAllocator
+ * @brief ArduinoJson分配器：JsonDocument doc(ArenaJsonAllocator::instance())
+ */
+class ArenaJsonAllocator : public ArduinoJson::Allocator {
+public:
+    /**
+     * @brief 获取分配器实例
+     * @return ArenaJsonAllocator* 分配器
+     */
+    static ArenaJsonAllocator* instance();
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+private:
+    ArenaJsonAllocator() = default;
+};
+
+#endif // MESSAGE_ARENA_H
@@ -0,0 +1,361 @@
+/**
+ * @file metrics.cpp
+ * @brief 运行指标注册表实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "metrics.h"
+#include <esp_heap_caps.h>
+#include <string.h>
+
+/// 指标名称前缀
+#define METRICS_NAME_PREFIX "sms_relay_"
+
+/**
+ * @brief 快速路径桶上界（微秒）：规则匹配等纯内存操作
+ */
+static const uint32_t FAST_BUCKETS_US[] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000
+};
+
+/**
+ * @brief 慢速路径桶上界（微秒）：数据库、串口与网络操作
+ */
+static const uint32_t SLOW_BUCKETS_US[] = {
+    1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 10000000, 30000000
+};
+
+#define FAST_BUCKET_COUNT (sizeof(FAST_BUCKETS_US) / sizeof(FAST_BUCKETS_US[0]))
+#define SLOW_BUCKET_COUNT (sizeof(SLOW_BUCKETS_US) / sizeof(SLOW_BUCKETS_US[0]))
+
+static_assert(FAST_BUCKET_COUNT <= METRICS_MAX_BUCKETS, "FAST_BUCKETS_US超过METRICS_MAX_BUCKETS");
+static_assert(SLOW_BUCKET_COUNT <= METRICS_MAX_BUCKETS, "SLOW_BUCKETS_US超过METRICS_MAX_BUCKETS");
+
+/**
+ * @brief 指标定义表（按MetricId顺序）
+ */
+static const MetricSpec METRIC_SPECS[METRIC_COUNT] = {
+    { "sms_line_to_db_seconds", "PDU line arrival to SMS row committed", METRIC_TYPE_HISTOGRAM, nullptr, true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "db_insert_seconds", "SMS record insert duration", METRIC_TYPE_HISTOGRAM, nullptr, true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "rule_match_seconds", "Forward rule matching duration", METRIC_TYPE_HISTOGRAM, nullptr, true, FAST_BUCKETS_US, FAST_BUCKET_COUNT },
+    { "push_seconds", "Single push attempt duration", METRIC_TYPE_HISTOGRAM, "channel", true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "http_request_seconds", "HTTP request duration", METRIC_TYPE_HISTOGRAM, "transport", true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "at_command_seconds", "AT transaction duration including arbiter queue wait", METRIC_TYPE_HISTOGRAM, "command", true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "forward_seconds", "Push job enqueue to forward completion, by priority lane", METRIC_TYPE_HISTOGRAM, "lane", true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "db_queue_wait_seconds", "Database request queue wait before the worker ran it", METRIC_TYPE_HISTOGRAM, nullptr, true, SLOW_BUCKETS_US, SLOW_BUCKET_COUNT },
+    { "boot_stage_seconds", "Boot stage duration", METRIC_TYPE_GAUGE, "stage", true, nullptr, 0 },
+    { "message_arena_peak_bytes", "Largest per-message push arena usage", METRIC_TYPE_GAUGE, nullptr, false, nullptr, 0 },
+    { "sms_received_total", "SMS PDUs decoded", METRIC_TYPE_COUNTER, nullptr, false, nullptr, 0 },
+    { "db_insert_failures_total", "SMS record inserts that failed", METRIC_TYPE_COUNTER, nullptr, false, nullptr, 0 },
+    { "push_failures_total", "Push attempts that failed", METRIC_TYPE_COUNTER, "channel", false, nullptr, 0 },
+    { "at_timeouts_total", "AT transactions that timed out", METRIC_TYPE_COUNTER, "command", false, nullptr, 0 },
+    { "push_deferred_total", "Pushes deferred to the outbox by rate limit or open circuit", METRIC_TYPE_COUNTER, "channel", false, nullptr, 0 },
+    { "message_arena_overflows_total", "Push arena allocations that fell back to the heap", METRIC_TYPE_COUNTER, nullptr, false, nullptr, 0 },
+    { "modem_lines_dropped_total", "URC lines dropped because the subscriber queue was full", METRIC_TYPE_COUNTER, "modem", false, nullptr, 0 },
+};
+
+/**
+ * @brief 输出以微秒表示的值（换算为秒）
+ * @param out 输出目标
+ * @param micros 微秒数
+ */
+static void printSeconds(Print& out, int64_t micros) {
+    char buffer[32];
+    const char* sign = micros < 0 ? "-" : "";
+    uint64_t magnitude = micros < 0 ? (uint64_t)(-micros) : (uint64_t)micros;
+    snprintf(buffer, sizeof(buffer), "%s%lu.%06lu", sign,
+             (unsigned long)(magnitude / 1000000), (unsigned long)(magnitude % 1000000));
+    out.print(buffer);
+}
+
+/**
+ * @brief 输出64位整数
+ * @param out 输出目标
+ * @param value 值
+ */
+static void printInteger(Print& out, int64_t value) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+    out.print(buffer);
+}
+
+/**
+ * @brief 输出一行无标签的仪表
+ * @param out 输出目标
+ * @param name 指标名称（不含前缀）
+ * @param help 说明
+ * @param value 值
+ */
+static void printPlainGauge(Print& out, const char* name, const char* help, int64_t value) {
+    out.print("# HELP " METRICS_NAME_PREFIX);
+    out.print(name);
+    out.print(" ");
+    out.print(help);
+    out.print("\n# TYPE " METRICS_NAME_PREFIX);
+    out.print(name);
+    out.print(" gauge\n" METRICS_NAME_PREFIX);
+    out.print(name);
+    out.print(" ");
+    printInteger(out, value);
+    out.print("\n");
+}
+
+/**
+ * @brief 获取单例实例
+ * @return MetricsRegistry& 单例引用
+ */
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+MetricsRegistry::MetricsRegistry() : droppedCount(0) {
+    memset(series, 0, sizeof(series));
+}
+
+/**
+ * @brief 记录一次耗时
+ * @param id 直方图指标ID
+ * @param micros 耗时（微秒）
+ * @param label 标签值（无标签指标传nullptr）
+ */
+void MetricsRegistry::observe(MetricId id, uint32_t micros, const char* label) {
+    const MetricSpec& spec = METRIC_SPECS[id];
+    if (spec.type != METRIC_TYPE_HISTOGRAM) {
+        return;
+    }
+
+    // 找到第一个上界不小于耗时的桶，超出所有上界的只计入+Inf（count）
+    uint8_t bucket = 0;
+    while (bucket < spec.bucketCount && micros > spec.buckets[bucket]) {
+        bucket++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    MetricSeries* target = findSeries(id, label);
+    if (target == nullptr) {
+        return;
+    }
+    target->value += micros;
+    target->count++;
+    if (bucket < spec.bucketCount) {
+        target->buckets[bucket]++;
+    }
+}
+
+/**
+ * @brief 计数器加一（或加delta）
+ * @param id 计数器指标ID
+ * @param label 标签值（无标签指标传nullptr）
+ * @param delta 增量
+ */
+void MetricsRegistry::increment(MetricId id, const char* label, uint32_t delta) {
+    if (METRIC_SPECS[id].type != METRIC_TYPE_COUNTER) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    MetricSeries* target = findSeries(id, label);
+    if (target != nullptr) {
+        target->value += delta;
+    }
+}
+
+/**
+ * @brief 设置仪表值
+ * @param id 仪表指标ID
+ * @param value 仪表值（以秒输出的指标传微秒）
+ * @param label 标签值（无标签指标传nullptr）
+ */
+void MetricsRegistry::setGauge(MetricId id, int64_t value, const char* label) {
+    if (METRIC_SPECS[id].type != METRIC_TYPE_GAUGE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    MetricSeries* target = findSeries(id, label);
+    if (target != nullptr) {
+        target->value = value;
+    }
+}
+
+/**
+ * @brief 获取因序列池已满而丢弃的记录数
+ * @return uint32_t 丢弃数
+ */
+uint32_t MetricsRegistry::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return droppedCount;
+}
+
+/**
+ * @brief 查找或分配序列（调用方须持有mutex）
+ * @param id 指标ID
+ * @param label 标签值
+ * @return MetricSeries* 序列，池已满时返回nullptr
+ */
+MetricsRegistry::MetricSeries* MetricsRegistry::findSeries(MetricId id, const char* label) {
+    // 无标签指标忽略传入的标签值；标签值按截断后的内容比较，与分配时一致
+    if (METRIC_SPECS[id].labelName == nullptr || label == nullptr) {
+        label = "";
+    }
+    size_t labelLength = strnlen(label, METRICS_LABEL_MAX_LENGTH);
+
+    MetricSeries* freeSlot = nullptr;
+    for (int i = 0; i < METRICS_MAX_SERIES; i++) {
+        MetricSeries& candidate = series[i];
+        if (!candidate.used) {
+            // 序列只分配不释放，第一个空位之后不会再有已分配的序列
+            freeSlot = &candidate;
+            break;
+        }
+        if (candidate.metric == id && strncmp(candidate.label, label, labelLength) == 0 &&
+            candidate.label[labelLength] == '\0') {
+            return &candidate;
+        }
+    }
+
+    if (freeSlot == nullptr) {
+        droppedCount++;
+        return nullptr;
+    }
+    freeSlot->used = true;
+    freeSlot->metric = (uint8_t)id;
+    memcpy(freeSlot->label, label, labelLength);
+    freeSlot->label[labelLength] = '\0';
+    return freeSlot;
+}
+
+/**
+ * @brief 以Prometheus文本格式输出全部指标
+ * @param out 输出目标（如AsyncResponseStream）
+ */
+void MetricsRegistry::render(Print& out) {
+    renderSystemGauges(out);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    char le[24];
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        const MetricSpec& spec = METRIC_SPECS[id];
+        const char* typeName = spec.type == METRIC_TYPE_COUNTER ? "counter" :
+                               spec.type == METRIC_TYPE_GAUGE ? "gauge" : "histogram";
+        out.print("# HELP " METRICS_NAME_PREFIX);
+        out.print(spec.name);
+        out.print(" ");
+        out.print(spec.help);
+        out.print("\n# TYPE " METRICS_NAME_PREFIX);
+        out.print(spec.name);
+        out.print(" ");
+        out.print(typeName);
+        out.print("\n");
+
+        for (int i = 0; i < METRICS_MAX_SERIES && series[i].used; i++) {
+            const MetricSeries& entry = series[i];
+            if (entry.metric != id) {
+                continue;
+            }
+
+            if (spec.type != METRIC_TYPE_HISTOGRAM) {
+                printSeriesName(out, spec, entry, "", nullptr);
+                if (spec.seconds) {
+                    printSeconds(out, entry.value);
+                } else {
+                    printInteger(out, entry.value);
+                }
+                out.print("\n");
+                continue;
+            }
+
+            // Prometheus的桶计数是累积的
+            uint32_t cumulative = 0;
+            for (uint8_t bucket = 0; bucket < spec.bucketCount; bucket++) {
+                cumulative += entry.buckets[bucket];
+                uint32_t bound = spec.buckets[bucket];
+                snprintf(le, sizeof(le), "%lu.%06lu", (unsigned long)(bound / 1000000), (unsigned long)(bound % 1000000));
+                printSeriesName(out, spec, entry, "_bucket", le);
+                printInteger(out, cumulative);
+                out.print("\n");
+            }
+            printSeriesName(out, spec, entry, "_bucket", "+Inf");
+            printInteger(out, entry.count);
+            out.print("\n");
+            printSeriesName(out, spec, entry, "_sum", nullptr);
+            printSeconds(out, entry.value);
+            out.print("\n");
+            printSeriesName(out, spec, entry, "_count", nullptr);
+            printInteger(out, entry.count);
+            out.print("\n");
+        }
+    }
+
+    out.print("# HELP " METRICS_NAME_PREFIX "metrics_dropped_total Observations dropped because the series pool was full\n");
+    out.print("# TYPE " METRICS_NAME_PREFIX "metrics_dropped_total counter\n");
+    out.print(METRICS_NAME_PREFIX "metrics_dropped_total ");
+    printInteger(out, droppedCount);
+    out.print("\n");
+}
+
+/**
+ * @brief 输出序列名称与标签部分
+ * @param out 输出目标
+ * @param spec 指标定义
+ * @param series 序列
+ * @param suffix 名称后缀（如"_bucket"）
+ * @param le 桶上界（nullptr表示无le标签）
+ */
+void MetricsRegistry::printSeriesName(Print& out, const MetricSpec& spec, const MetricSeries& series,
+                                      const char* suffix, const char* le) {
+    out.print(METRICS_NAME_PREFIX);
+    out.print(spec.name);
+    out.print(suffix);
+
+    bool hasLabel = spec.labelName != nullptr;
+    if (hasLabel || le != nullptr) {
+        out.print("{");
+        if (hasLabel) {
+            out.print(spec.labelName);
+            out.print("=\"");
+            // 标签值来自渠道名与AT命令，按Prometheus规则转义
+            for (const char* c = series.label; *c != '\0'; c++) {
+                if (*c == '\\' || *c == '"') {
+                    out.write((uint8_t)'\\');
+                    out.write((uint8_t)*c);
+                } else if (*c == '\n') {
+                    out.print("\\n");
+                } else {
+                    out.write((uint8_t)*c);
+                }
+            }
+            out.print("\"");
+        }
+        if (le != nullptr) {
+            out.print(hasLabel ? ",le=\"" : "le=\"");
+            out.print(le);
+            out.print("\"");
+        }
+        out.print("}");
+    }
+    out.print(" ");
+}
+
+/**
+ * @brief 输出系统仪表（运行时间、堆与PSRAM水位）
+ * @param out 输出目标
+ */
+void MetricsRegistry::renderSystemGauges(Print& out) {
+    printPlainGauge(out, "uptime_seconds", "Seconds since boot", millis() / 1000);
+    printPlainGauge(out, "heap_free_bytes", "Free internal heap", ESP.getFreeHeap());
+    printPlainGauge(out, "heap_min_free_bytes", "Lowest free internal heap since boot", ESP.getMinFreeHeap());
+    size_t internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    printPlainGauge(out, "heap_largest_free_block_bytes", "Largest allocatable internal block", largestBlock);
+    // 空闲内存中不属于最大连续块的比例；持续上升说明内部堆正在碎片化
+    printPlainGauge(out, "heap_fragmentation_percent", "Share of free internal heap outside the largest block",
+                    internalFree > 0 ? 100 - (int64_t)(largestBlock * 100 / internalFree) : 0);
+    printPlainGauge(out, "psram_free_bytes", "Free PSRAM", ESP.getFreePsram());
+    printPlainGauge(out, "psram_min_free_bytes", "Lowest free PSRAM since boot",
+                    heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+}
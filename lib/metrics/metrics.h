@@ -0,0 +1,177 @@
+/**
+ * @file metrics.h
+ * @brief 运行指标注册表 - 计数器、仪表与定长桶延迟直方图
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以一张表登记所有指标（名称、类型、标签名与桶边界），各模块按指标ID记录数据
+ * 2. 所有序列存放在定长池中，记录数据时不分配内存；池满时丢弃新序列并计数
+ * 3. 以Prometheus文本格式输出全部指标（延迟以秒为单位），并附带堆与PSRAM水位及内部堆碎片率
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <mutex>
+#include "../../include/constants.h"
+
+/**
+ * @enum MetricId
+ * @brief 指标ID
+ */
+enum MetricId {
+    METRIC_SMS_LINE_TO_DB = 0,          ///< 直方图：PDU行到达至短信入库的延迟
+    METRIC_DB_INSERT,                   ///< 直方图：短信记录写入数据库的耗时
+    METRIC_RULE_MATCH,                  ///< 直方图：转发规则匹配耗时
+    METRIC_PUSH_LATENCY,                ///< 直方图：单次推送耗时（按渠道）
+    METRIC_HTTP_REQUEST,                ///< 直方图：HTTP请求耗时（按传输方式）
+    METRIC_AT_COMMAND,                  ///< 直方图：AT事务耗时（按命令，含排队等待）
+    METRIC_FORWARD_LATENCY,             ///< 直方图：短信推送任务入队至推送完成的延迟（按优先级队列）
+    METRIC_DB_QUEUE_WAIT,               ///< 直方图：数据库请求投递至开始执行的等待时间
+    METRIC_BOOT_STAGE,                  ///< 仪表：启动阶段耗时（按阶段，秒）
+    METRIC_MESSAGE_ARENA_PEAK,          ///< 仪表：单条短信推送内存区的最大用量（字节）
+    METRIC_SMS_RECEIVED,                ///< 计数器：收到的短信PDU数
+    METRIC_DB_INSERT_FAILURES,          ///< 计数器：短信入库失败次数
+    METRIC_PUSH_FAILURES,               ///< 计数器：推送失败次数（按渠道）
+    METRIC_AT_TIMEOUTS,                 ///< 计数器：AT事务超时次数（按命令）
+    METRIC_PUSH_DEFERRED,               ///< 计数器：因端点限流或熔断推迟到发件箱的推送数（按渠道）
+    METRIC_MESSAGE_ARENA_OVERFLOWS,     ///< 计数器：推送内存区用尽、回退到堆的分配次数
+    METRIC_MODEM_LINES_DROPPED,         ///< 计数器：订阅者队列已满、仲裁器丢弃的上报行数（按模块）
+    METRIC_COUNT
+};
+
+/**
+ * @enum MetricType
+ * @brief 指标类型
+ */
+enum MetricType {
+    METRIC_TYPE_COUNTER,                ///< 单调递增计数器
+    METRIC_TYPE_GAUGE,                  ///< 仪表（可任意设置）
+    METRIC_TYPE_HISTOGRAM               ///< 延迟直方图（以微秒记录）
+};
+
+/**
+ * @struct MetricSpec
+ * @brief 指标定义
+ */
+struct MetricSpec {
+    const char* name;                   ///< 指标名称（不含前缀）
+    const char* help;                   ///< 说明
+    MetricType type;                    ///< 类型
+    const char* labelName;              ///< 标签名（nullptr表示无标签）
+    bool seconds;                       ///< 值以微秒记录、以秒输出
+    const uint32_t* buckets;            ///< 直方图桶上界（微秒，升序）
+    uint8_t bucketCount;                ///< 桶数（不含+Inf）
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief 运行指标注册表
+ */
+class MetricsRegistry {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return MetricsRegistry& 单例引用
+     */
+    static MetricsRegistry& getInstance();
+
+    /**
+     * @brief 记录一次耗时
+     * @param id 直方图指标ID
+     * @param micros 耗时（微秒）
+     * @param label 标签值（无标签指标传nullptr）
+     */
+    void observe(MetricId id, uint32_t micros, const char* label = nullptr);
+
+    /**
+     * @brief 计数器加一（或加delta）
+     * @param id 计数器指标ID
+     * @param label 标签值（无标签指标传nullptr）
+     * @param delta 增量
+     */
+    void increment(MetricId id, const char* label = nullptr, uint32_t delta = 1);
+
+    /**
+     * @brief 设置仪表值
+     * @param id 仪表指标ID
+     * @param value 仪表值（以秒输出的指标传微秒）
+     * @param label 标签值（无标签指标传nullptr）
+     */
+    void setGauge(MetricId id, int64_t value, const char* label = nullptr);
+
+    /**
+     * @brief 以Prometheus文本格式输出全部指标
+     * @param out 输出目标（如AsyncResponseStream）
+     */
+    void render(Print& out);
+
+    /**
+     * @brief 获取因序列池已满而丢弃的记录数
+     * @return uint32_t 丢弃数
+     */
+    uint32_t getDroppedCount() const;
+
+private:
+    /**
+     * @struct MetricSeries
+     * @brief 一个指标与标签值组合的数据
+     */
+    struct MetricSeries {
+        bool used;                                  ///< 是否已分配
+        uint8_t metric;                             ///< 指标ID
+        char label[METRICS_LABEL_MAX_LENGTH + 1];   ///< 标签值
+        int64_t value;                              ///< 计数器/仪表值，直方图为耗时总和（微秒）
+        uint32_t count;                             ///< 直方图记录次数
+        uint32_t buckets[METRICS_MAX_BUCKETS];      ///< 直方图各桶计数（非累积）
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    MetricsRegistry();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    MetricsRegistry(const MetricsRegistry&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /**
+     * @brief 查找或分配序列（调用方须持有mutex）
+     * @param id 指标ID
+     * @param label 标签值
+     * @return MetricSeries* 序列，池已满时返回nullptr
+     */
+    MetricSeries* findSeries(MetricId id, const char* label);
+
+    /**
+     * @brief 输出序列名称与标签部分
+     * @param out 输出目标
+     * @param spec 指标定义
+     * @param series 序列
+     * @param suffix 名称后缀（如"_bucket"）
+     * @param le 桶上界（nullptr表示无le标签）
+     */
+    static void printSeriesName(Print& out, const MetricSpec& spec, const MetricSeries& series,
+                                const char* suffix, const char* le);
+
+    /**
+     * @brief 输出系统仪表（运行时间、堆与PSRAM水位）
+     * @param out 输出目标
+     */
+    static void renderSystemGauges(Print& out);
+
+private:
+    MetricSeries series[METRICS_MAX_SERIES];        ///< 序列池
+    uint32_t droppedCount;                          ///< 因池满丢弃的记录数
+    mutable std::mutex mutex;                       ///< 保护序列池
+};
+
+#endif // METRICS_H
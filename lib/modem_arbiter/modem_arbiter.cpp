@@ -0,0 +1,611 @@
+/**
+ * @file modem_arbiter.cpp
+ * @brief 调制解调器仲裁器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "modem_arbiter.h"
+#include "../../include/config.h"
+#include "../metrics/metrics.h"
+#include "../power_manager/power_manager.h"
+#include "../task_topology/task_topology.h"
+#include <esp_heap_caps.h>
+#include <string.h>
+
+static_assert(SIM_MODEM_COUNT >= 1 && SIM_MODEM_COUNT <= MODEM_MAX_COUNT, "SIM_MODEM_COUNT超出范围");
+
+// 外部串口对象
+extern HardwareSerial simSerial;
+#if SIM_MODEM_COUNT > 1
+extern HardwareSerial sim2Serial;
+#endif
+#if SIM_MODEM_COUNT > 2
+extern HardwareSerial sim3Serial;
+#endif
+
+/**
+ * @brief 各SIM模块仲裁任务的任务ID（按模块序号）
+ */
+static const SystemTaskId ARBITER_TASKS[MODEM_MAX_COUNT] = {
+    SYSTEM_TASK_MODEM_ARBITER,
+    SYSTEM_TASK_MODEM2_ARBITER,
+    SYSTEM_TASK_MODEM3_ARBITER
+};
+
+/**
+ * @brief 各SIM模块在指标中的标签值（按模块序号）
+ */
+static const char* const MODEM_METRIC_LABELS[MODEM_MAX_COUNT] = { "0", "1", "2" };
+
+/**
+ * @brief 获取主SIM模块的仲裁器
+ * @return ModemArbiter& 实例引用
+ */
+ModemArbiter& ModemArbiter::getInstance() {
+    return getModem(0);
+}
+
+/**
+ * @brief 获取指定SIM模块的仲裁器
+ * @param index 模块序号
+ * @return ModemArbiter& 实例引用
+ */
+ModemArbiter& ModemArbiter::getModem(uint8_t index) {
+    // 所有实例在首次访问时一并创建（函数内静态变量的初始化是线程安全的）
+    static ModemArbiter* const instances[SIM_MODEM_COUNT] = {
+        new ModemArbiter(0, simSerial),
+#if SIM_MODEM_COUNT > 1
+        new ModemArbiter(1, sim2Serial),
+#endif
+#if SIM_MODEM_COUNT > 2
+        new ModemArbiter(2, sim3Serial),
+#endif
+    };
+    return *instances[index < SIM_MODEM_COUNT ? index : 0];
+}
+
+/**
+ * @brief 获取配置的SIM模块数量
+ * @return uint8_t 模块数量
+ */
+uint8_t ModemArbiter::getModemCount() {
+    return SIM_MODEM_COUNT;
+}
+
+/**
+ * @brief 获取本实例对应的模块序号
+ * @return uint8_t 模块序号
+ */
+uint8_t ModemArbiter::getIndex() const {
+    return index;
+}
+
+/**
+ * @brief 构造函数
+ * @param index 模块序号
+ * @param serial 模块串口
+ */
+ModemArbiter::ModemArbiter(uint8_t index, HardwareSerial& serial)
+    : index(index), serial(serial), loopback(nullptr), transactionQueue(nullptr), taskHandle(nullptr),
+      active(nullptr), activeStartedAt(0), debugMode(false), initialized(false) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief 析构函数
+ */
+ModemArbiter::~ModemArbiter() {
+}
+
+/**
+ * @brief 创建事务队列并启动仲裁任务
+ * @return true 启动成功
+ * @return false 启动失败
+ */
+bool ModemArbiter::initialize() {
+    if (initialized) {
+        return true;
+    }
+
+    transactionQueue = xQueueCreate(MODEM_TRANSACTION_QUEUE_LENGTH, sizeof(ModemTransaction*));
+    if (transactionQueue == nullptr) {
+        setError("AT事务队列创建失败");
+        return false;
+    }
+
+    if (!TaskTopology::getInstance().createTask(ARBITER_TASKS[index], arbiterTask, this, &taskHandle)) {
+        vQueueDelete(transactionQueue);
+        transactionQueue = nullptr;
+        setError("仲裁任务创建失败");
+        return false;
+    }
+
+    initialized = true;
+    debugPrint("调制解调器仲裁器已启动");
+    return true;
+}
+
+/**
+ * @brief 检查仲裁任务是否已运行
+ * @return true 已运行
+ * @return false 未运行
+ */
+bool ModemArbiter::isRunning() const {
+    return initialized;
+}
+
+/**
+ * @brief 提交AT事务并阻塞等待其完成
+ * @param transaction 事务描述
+ * @return ModemTransactionStatus 执行结果
+ */
+ModemTransactionStatus ModemArbiter::execute(ModemTransaction& transaction) {
+    transaction.status = MODEM_TXN_BUSY;
+    transaction.response = "";
+    transaction.duration = 0;
+    transaction.queueWait = 0;
+    if (transaction.expected == nullptr) {
+        transaction.expected = "";
+    }
+    if (transaction.terminator != nullptr && transaction.terminator[0] == '\0') {
+        transaction.terminator = nullptr;
+    }
+    if (transaction.prompt != nullptr && transaction.prompt[0] == '\0') {
+        transaction.prompt = nullptr;
+    }
+
+    if (!initialized) {
+        setError("仲裁器未初始化");
+        return transaction.status;
+    }
+    // 仲裁任务自身提交事务会永久阻塞
+    if (xTaskGetCurrentTaskHandle() == taskHandle) {
+        setError("不能在仲裁任务内提交事务");
+        return transaction.status;
+    }
+
+    transaction.done = xSemaphoreCreateBinaryStatic(&transaction.doneBuffer);
+    transaction.submittedAt = millis();
+
+    ModemTransaction* pointer = &transaction;
+    if (xQueueSend(transactionQueue, &pointer, pdMS_TO_TICKS(transaction.timeout)) != pdTRUE) {
+        vSemaphoreDelete(transaction.done);
+        setError("AT事务队列已满");
+        return transaction.status;
+    }
+    xTaskNotifyGive(taskHandle);
+
+    // 仲裁任务保证在事务超时后结束它，调用方在此之前不能释放事务结构体
+    xSemaphoreTake(transaction.done, portMAX_DELAY);
+    vSemaphoreDelete(transaction.done);
+    return transaction.status;
+}
+
+/**
+ * @brief 订阅以指定前缀开头的URC行
+ * @param prefix 行前缀
+ * @param queue 接收ModemLine的队列
+ * @param captureNextLine 是否同时投递紧随其后的一行
+ * @param enabled 是否立即生效
+ * @return true 订阅成功
+ * @return false 订阅数已达上限
+ */
+bool ModemArbiter::subscribe(const char* prefix, QueueHandle_t queue, bool captureNextLine, bool enabled) {
+    if (prefix == nullptr || queue == nullptr) {
+        setError("订阅参数无效");
+        return false;
+    }
+    if (!router.subscribe(prefix, queue, captureNextLine, enabled)) {
+        setError("URC订阅数已达上限");
+        return false;
+    }
+
+    debugPrint("新增URC订阅: " + String(prefix));
+    return true;
+}
+
+/**
+ * @brief 启用或停用一项订阅
+ * @param prefix 订阅时的行前缀
+ * @param queue 订阅时的队列
+ * @param enabled 是否启用
+ * @return true 已更新
+ * @return false 没有该订阅
+ */
+bool ModemArbiter::setSubscriptionEnabled(const char* prefix, QueueHandle_t queue, bool enabled) {
+    if (prefix == nullptr || !router.setSubscriptionEnabled(prefix, queue, enabled)) {
+        setError("没有该URC订阅");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 创建用于接收ModemLine的队列（存储区优先分配在PSRAM）
+ * @param length 队列长度
+ * @return QueueHandle_t 队列句柄，失败返回nullptr
+ */
+QueueHandle_t ModemArbiter::createLineQueue(size_t length) {
+    size_t storageSize = length * sizeof(ModemLine);
+    uint8_t* storage = (uint8_t*)heap_caps_malloc(storageSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (storage == nullptr) {
+        storage = (uint8_t*)heap_caps_malloc(storageSize, MALLOC_CAP_8BIT);
+    }
+    StaticQueue_t* control = (StaticQueue_t*)heap_caps_malloc(sizeof(StaticQueue_t), MALLOC_CAP_8BIT);
+    if (storage == nullptr || control == nullptr) {
+        heap_caps_free(storage);
+        heap_caps_free(control);
+        return nullptr;
+    }
+    return xQueueCreateStatic(length, sizeof(ModemLine), storage, control);
+}
+
+/**
+ * @brief 以回环Stream代替SIM模块串口
+ * @param loopback 回环Stream（nullptr恢复使用串口）
+ */
+void ModemArbiter::attachLoopback(Stream* loopback) {
+    this->loopback.store(loopback);
+    debugPrint(loopback != nullptr ? "串口已切换到回环Stream" : "串口已恢复");
+    // 唤醒仲裁任务读取新端口上已有的数据
+    notifyLoopbackData();
+}
+
+/**
+ * @brief 是否正在使用回环Stream
+ * @return true 使用回环Stream
+ * @return false 使用SIM模块串口
+ */
+bool ModemArbiter::isLoopbackAttached() const {
+    return loopback.load() != nullptr;
+}
+
+/**
+ * @brief 通知仲裁任务回环Stream有新数据
+ */
+void ModemArbiter::notifyLoopbackData() {
+    if (taskHandle != nullptr) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+/**
+ * @brief 获取当前读写的端口
+ * @return Stream& 端口
+ */
+Stream& ModemArbiter::port() {
+    Stream* current = loopback.load();
+    return current != nullptr ? *current : serial;
+}
+
+/**
+ * @brief 获取统计信息
+ * @return ModemArbiterStats 统计信息
+ */
+ModemArbiterStats ModemArbiter::getStats() const {
+    ModemArbiterStats snapshot = stats;
+    snapshot.framerOverflows = framer.getOverflowCount();
+    return snapshot;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String ModemArbiter::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void ModemArbiter::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief 串口接收回调（在UART驱动的事件任务中执行）
+ */
+void ModemArbiter::onSerialReceive() {
+    // 一行URC或响应可能分多次到达，接收期间不进入浅睡眠
+    PowerManager::getInstance().notifyActivity();
+    TaskHandle_t handle = taskHandle;
+    if (handle != nullptr) {
+        xTaskNotifyGive(handle);
+    }
+}
+
+/**
+ * @brief FreeRTOS任务入口
+ * @param parameter ModemArbiter实例指针
+ */
+void ModemArbiter::arbiterTask(void* parameter) {
+    ModemArbiter* arbiter = static_cast<ModemArbiter*>(parameter);
+
+    // RX空闲超过若干符号时间即产生数据事件，数据到达或有新事务时唤醒
+    arbiter->serial.setRxTimeout(SIM_UART_RX_TIMEOUT_SYMBOLS);
+    arbiter->serial.onReceive([arbiter]() { arbiter->onSerialReceive(); }, false);
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, arbiter->nextWaitTicks());
+
+        arbiter->pumpSerial();
+
+        if (arbiter->active != nullptr) {
+            arbiter->checkActiveTransaction();
+        }
+
+        // 空闲时取出下一个事务；等待型事务可能从暂存区立即完成
+        ModemTransaction* next = nullptr;
+        while (arbiter->active == nullptr &&
+               xQueueReceive(arbiter->transactionQueue, &next, 0) == pdTRUE) {
+            arbiter->beginTransaction(next);
+        }
+    }
+}
+
+/**
+ * @brief 计算本轮最长阻塞时间
+ * @return TickType_t 阻塞时间
+ */
+TickType_t ModemArbiter::nextWaitTicks() const {
+    if (active == nullptr) {
+        return portMAX_DELAY;
+    }
+    return pdMS_TO_TICKS(router.nextWaitMs(millis())) + 1;
+}
+
+/**
+ * @brief 读取串口数据并逐行分发
+ */
+void ModemArbiter::pumpSerial() {
+    Stream& input = port();
+    int available;
+
+    while ((available = input.available()) > 0) {
+        size_t toRead = (size_t)available < sizeof(readChunk) ? (size_t)available : sizeof(readChunk);
+        // 只读取已到达的字节数，不会因等待数据而阻塞
+        size_t readCount = input.readBytes(readChunk, toRead);
+        if (readCount == 0) {
+            break;
+        }
+
+        size_t offset = 0;
+        while (offset < readCount) {
+            offset += framer.feed(readChunk + offset, readCount - offset);
+            drainFramer();
+        }
+    }
+}
+
+/**
+ * @brief 依次取出分帧器中的数据段与完整行并分发
+ */
+void ModemArbiter::drainFramer() {
+    LineView line;
+    while (true) {
+        // 声明了长度的数据段按字节数取出，其中的空行、结果码与URC前缀都不参与分行与路由
+        size_t pending = router.pendingData();
+        if (pending > 0) {
+            const char* data;
+            size_t length = framer.takeRaw(data, pending);
+            if (length == 0) {
+                return;
+            }
+            router.consumeData(length);
+            deliverData(data, length);
+            continue;
+        }
+
+        if (!framer.nextLine(line)) {
+            return;
+        }
+        routeLine(line);
+    }
+}
+
+/**
+ * @brief 将数据段交给当前事务的读取回调
+ * @param data 数据
+ * @param length 数据长度
+ */
+void ModemArbiter::deliverData(const char* data, size_t length) {
+    if (active == nullptr || active->reader == nullptr) {
+        return;
+    }
+    // 调用方不再需要剩余数据：清除回调，其余字节照常按长度读完
+    if (!active->reader(active->readerContext, (const uint8_t*)data, length)) {
+        active->reader = nullptr;
+    }
+}
+
+/**
+ * @brief 分发一行数据（订阅者、当前事务或暂存区）
+ * @param line 行视图
+ */
+void ModemArbiter::routeLine(const LineView& line) {
+    void* subscriber = nullptr;
+    ModemTransactionStatus status;
+
+    switch (router.route(line, subscriber)) {
+        case MODEM_ROUTE_SUBSCRIBER:
+            deliver((QueueHandle_t)subscriber, line);
+            break;
+
+        case MODEM_ROUTE_RESPONSE:
+            if (router.appendResponse(line, active->response, millis(), status)) {
+                finishTransaction(status);
+            } else if (router.takePromptReached()) {
+                writeBody();
+            }
+            break;
+
+        case MODEM_ROUTE_WAIT_MATCH:
+            active->response = line.data;
+            finishTransaction(MODEM_TXN_OK);
+            break;
+
+        case MODEM_ROUTE_UNSOLICITED:
+            stats.unsolicitedLines++;
+            debugPrint("主动上报: " + String(line.data));
+            break;
+
+        case MODEM_ROUTE_IGNORED:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 检查当前事务的提示符、静默与超时条件
+ */
+void ModemArbiter::checkActiveTransaction() {
+    // 提示符（如"> "）不以换行结尾，需要在未成行的数据中查找
+    const char* prompt = router.getPendingPrompt();
+    if (prompt != nullptr && framer.pendingContains(prompt)) {
+        framer.reset();
+        active->response += prompt;
+        active->response += "\r\n";
+        writeBody();
+        return;
+    }
+
+    // 期望响应之后的静默或超时由路由判定
+    ModemTransactionStatus status;
+    bool timedOut;
+    if (router.checkTimers(millis(), status, timedOut)) {
+        if (timedOut) {
+            stats.timeouts++;
+        }
+        finishTransaction(status);
+    }
+}
+
+/**
+ * @brief 开始执行一个事务
+ * @param transaction 事务描述
+ */
+void ModemArbiter::beginTransaction(ModemTransaction* transaction) {
+    PowerManager::getInstance().notifyActivity();
+    active = transaction;
+    activeStartedAt = millis();
+
+    active->queueWait = activeStartedAt - active->submittedAt;
+    if (active->queueWait > stats.maxQueueWaitMs) {
+        stats.maxQueueWaitMs = active->queueWait;
+    }
+
+    switch (active->kind) {
+        case MODEM_TXN_DISCARD:
+            router.clearBacklog();
+            finishTransaction(MODEM_TXN_OK);
+            break;
+
+        case MODEM_TXN_WAIT:
+            router.beginWait(active->expected, active->timeout, activeStartedAt);
+            if (router.takeUnsolicited(active->expected, active->response)) {
+                finishTransaction(MODEM_TXN_OK);
+            }
+            break;
+
+        case MODEM_TXN_COMMAND:
+        default:
+            router.beginCommand(active->payload, active->payloadLength, active->expected, active->terminator,
+                                active->dataHeader, active->timeout, activeStartedAt);
+            port().write((const uint8_t*)active->payload, active->payloadLength);
+            // 有提示符时数据在收到提示符后写入，在此之前事务一直占用串口
+            if (active->prompt != nullptr) {
+                router.expectPrompt(active->prompt);
+            } else {
+                writeStream();
+            }
+            break;
+    }
+}
+
+/**
+ * @brief 写入流式载荷
+ */
+void ModemArbiter::writeStream() {
+    if (active->writer == nullptr) {
+        return;
+    }
+    // 流式载荷在同一事务内写完，其他事务不会插入到数据中间
+    Stream& output = port();
+    size_t chunk;
+    while ((chunk = active->writer(active->writerContext, writeChunk, sizeof(writeChunk))) > 0) {
+        output.write(writeChunk, chunk);
+    }
+}
+
+/**
+ * @brief 收到提示符后写入数据，事务继续等待结果
+ */
+void ModemArbiter::writeBody() {
+    router.continueAfterPrompt(active->bodyTimeout, millis());
+    if (active->bodyLength > 0) {
+        port().write((const uint8_t*)active->body, active->bodyLength);
+    }
+    writeStream();
+}
+
+/**
+ * @brief 结束当前事务并唤醒调用方
+ * @param status 执行结果
+ */
+void ModemArbiter::finishTransaction(ModemTransactionStatus status) {
+    ModemTransaction* finished = active;
+    active = nullptr;
+    router.endTransaction();
+
+    finished->status = status;
+    finished->duration = millis() - activeStartedAt;
+    stats.transactions++;
+    xSemaphoreGive(finished->done);
+}
+
+/**
+ * @brief 将行投递到订阅者队列
+ * @param queue 订阅者队列
+ * @param line 行视图
+ */
+void ModemArbiter::deliver(QueueHandle_t queue, const LineView& line) {
+    size_t length = line.length < MODEM_LINE_MAX_LENGTH ? line.length : MODEM_LINE_MAX_LENGTH;
+    memcpy(outgoing.data, line.data, length);
+    outgoing.data[length] = '\0';
+    outgoing.length = (uint16_t)length;
+    outgoing.truncated = line.truncated || length < line.length;
+    outgoing.receivedUs = micros();
+
+    if (xQueueSend(queue, &outgoing, 0) == pdTRUE) {
+        stats.routedLines++;
+    } else {
+        // 订阅者处理不过来时仲裁任务不能阻塞：只计数，调试模式下才拼接输出内容
+        stats.droppedLines++;
+        MetricsRegistry::getInstance().increment(METRIC_MODEM_LINES_DROPPED, MODEM_METRIC_LABELS[index]);
+        if (debugMode) {
+            debugPrint("订阅者队列已满，丢弃: " + String(outgoing.data));
+        }
+    }
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void ModemArbiter::setError(const String& error) {
+    lastError = error;
+    debugPrint("错误: " + error);
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void ModemArbiter::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[ModemArbiter] " + message);
+    }
+}
@@ -0,0 +1,373 @@
+/**
+ * @file modem_arbiter.h
+ * @brief 调制解调器仲裁器 - 独占SIM模块串口，串行化AT事务并分发URC
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 作为唯一读写SIM模块串口的任务，消除多任务抢读串口导致的URC/响应丢失
+ * 2. 按提交顺序逐个执行AT事务（写入命令、收集响应、超时判定），
+ *    收到最终结果码、提示符或事务指定的结束行时立即完成，无需等待超时
+ * 3. 带提示符的命令与其后的数据（如AT+CMGS与PDU、AT+HTTPDATA与请求体）在同一事务内完成，
+ *    等待提示符期间其他事务不会写入串口、混入数据
+ * 4. 按长度读取响应中声明了长度的数据段（如AT+HTTPREAD的响应体），原样交给事务的读取回调
+ * 5. 将订阅的URC行（如+CMT:及其后的PDU行）投递到订阅者队列，事务进行中也不受影响
+ * 6. 暂存最近一条命令之后的其他主动上报行，供等待型事务（如+HTTPACTION:）匹配
+ * 7. 可临时改为读写一个回环Stream（如调制解调器模拟器），上层模块无需任何改动
+ * 8. 每个SIM模块（SIM_MODEM_COUNT个，各占一个UART）对应一个实例与一个仲裁任务
+ */
+
+#ifndef MODEM_ARBITER_H
+#define MODEM_ARBITER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "../line_framer/line_framer.h"
+#include "modem_router.h"
+#include "../../include/constants.h"
+
+/**
+ * @brief 流式载荷写入回调（在仲裁任务中调用）
+ * @param context 调用方上下文
+ * @param buffer 输出缓冲区
+ * @param capacity 缓冲区容量
+ * @return size_t 写入的字节数，0表示载荷结束
+ */
+typedef size_t (*ModemPayloadWriter)(void* context, uint8_t* buffer, size_t capacity);
+
+/**
+ * @brief 数据段读取回调（在仲裁任务中调用）
+ * @param context 调用方上下文
+ * @param data 数据（未经分行与去除空白）
+ * @param length 数据长度
+ * @return true 继续接收
+ * @return false 不再接收，剩余数据仍按长度读完后丢弃
+ */
+typedef bool (*ModemDataReader)(void* context, const uint8_t* data, size_t length);
+
+/**
+ * @struct ModemTransaction
+ * @brief AT事务描述
+ *
+ * 由调用方在自己的栈上构造，execute()返回前仲裁器不会再访问它
+ */
+struct ModemTransaction {
+    ModemTransactionKind kind;          ///< 事务类型
+    const char* payload;                ///< 写入串口的数据（MODEM_TXN_COMMAND）
+    size_t payloadLength;               ///< 写入数据长度
+    const char* prompt;                 ///< 提示符（如">"、"DOWNLOAD"）：非空时写完payload先等待提示符，再写入body与writer的数据
+    const char* body;                   ///< 收到提示符后写入的数据（prompt非空时有效）
+    size_t bodyLength;                  ///< body长度
+    unsigned long bodyTimeout;          ///< 数据写入后等待结果的超时时间（毫秒，prompt非空时有效）
+    ModemPayloadWriter writer;          ///< 写完payload（有提示符时为body）后继续分块取数据写入（nullptr表示无）
+    void* writerContext;                ///< 传给writer的上下文
+    const char* expected;               ///< 期望的响应内容，""表示以最终结果码为准（有提示符时指数据写入后的响应）
+    const char* terminator;             ///< 结束行（非空时OK不结束事务，收到与之完全相同的行才结束）
+    const char* dataHeader;             ///< 声明数据长度的行前缀（如"+HTTPREAD:"），其后的数据段交给reader（nullptr表示无）
+    ModemDataReader reader;             ///< 数据段读取回调（数据段不写入response）
+    void* readerContext;                ///< 传给reader的上下文
+    unsigned long timeout;              ///< 超时时间（毫秒，从开始执行时计）
+
+    ModemTransactionStatus status;      ///< 执行结果
+    String response;                    ///< 响应内容（每行以"\r\n"分隔）
+    unsigned long duration;             ///< 执行时长（毫秒，不含排队时间）
+    unsigned long queueWait;            ///< 排队等待时长（毫秒）
+
+    SemaphoreHandle_t done;             ///< 完成信号（由execute()创建）
+    StaticSemaphore_t doneBuffer;       ///< 完成信号的静态存储
+    unsigned long submittedAt;          ///< 提交时间（millis）
+};
+
+/**
+ * @struct ModemLine
+ * @brief 投递给订阅者的一行数据（定长，按值入队）
+ */
+struct ModemLine {
+    uint16_t length;                        ///< 行长度
+    bool truncated;                         ///< 是否被截断
+    uint32_t receivedUs;                    ///< 仲裁器读到该行的时间（micros）
+    char data[MODEM_LINE_MAX_LENGTH + 1];   ///< 行内容（以'\0'结尾）
+};
+
+/**
+ * @struct ModemArbiterStats
+ * @brief 仲裁器统计信息
+ */
+struct ModemArbiterStats {
+    unsigned long transactions;         ///< 已执行的事务数
+    unsigned long timeouts;             ///< 超时的事务数
+    unsigned long routedLines;          ///< 投递给订阅者的行数
+    unsigned long droppedLines;         ///< 订阅者队列已满被丢弃的行数
+    unsigned long unsolicitedLines;     ///< 无人订阅的主动上报行数
+    unsigned long maxQueueWaitMs;       ///< 事务最大排队等待时间
+    unsigned long framerOverflows;      ///< 行分帧器截断次数
+};
+
+/**
+ * @class ModemArbiter
+ * @brief 调制解调器仲裁器类
+ *
+ * 所有模块通过execute()（通常经由AtCommandHandler）提交AT事务，
+ * 通过subscribe()订阅URC，任何其他代码都不应直接读写SIM串口
+ */
+class ModemArbiter {
+public:
+    /**
+     * @brief 获取主SIM模块（SIM_SERIAL_NUM）的仲裁器
+     * @return ModemArbiter& 实例引用
+     */
+    static ModemArbiter& getInstance();
+
+    /**
+     * @brief 获取指定SIM模块的仲裁器
+     * @param index 模块序号（0为主模块，超出SIM_MODEM_COUNT时返回主模块）
+     * @return ModemArbiter& 实例引用
+     */
+    static ModemArbiter& getModem(uint8_t index);
+
+    /**
+     * @brief 获取配置的SIM模块数量
+     * @return uint8_t 模块数量（SIM_MODEM_COUNT）
+     */
+    static uint8_t getModemCount();
+
+    /**
+     * @brief 获取本实例对应的模块序号
+     * @return uint8_t 模块序号（0为主模块）
+     */
+    uint8_t getIndex() const;
+
+    /**
+     * @brief 创建事务队列并启动仲裁任务（须在串口begin()之后调用）
+     * @return true 启动成功
+     * @return false 启动失败
+     */
+    bool initialize();
+
+    /**
+     * @brief 检查仲裁任务是否已运行
+     * @return true 已运行
+     * @return false 未运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 提交AT事务并阻塞等待其完成
+     * @param transaction 事务描述（结果写回同一结构体）
+     * @return ModemTransactionStatus 执行结果
+     */
+    ModemTransactionStatus execute(ModemTransaction& transaction);
+
+    /**
+     * @brief 订阅以指定前缀开头的URC行
+     *
+     * 订阅不可撤销，只能以setSubscriptionEnabled()临时停用
+     * @param prefix 行前缀（须为静态字符串）
+     * @param queue 接收ModemLine的队列
+     * @param captureNextLine 是否同时投递紧随其后的一行（如+CMT:后的PDU行）
+     * @param enabled 是否立即生效
+     * @return true 订阅成功
+     * @return false 订阅数已达上限
+     */
+    bool subscribe(const char* prefix, QueueHandle_t queue, bool captureNextLine = false, bool enabled = true);
+
+    /**
+     * @brief 启用或停用一项订阅
+     *
+     * 停用期间以该前缀开头的行按无人订阅处理（如作为进行中命令的最终结果码），
+     * 用于只在特定阶段才属于订阅者的行（如通话期间的NO CARRIER）
+     * @param prefix 订阅时的行前缀
+     * @param queue 订阅时的队列
+     * @param enabled 是否启用
+     * @return true 已更新
+     * @return false 没有该订阅
+     */
+    bool setSubscriptionEnabled(const char* prefix, QueueHandle_t queue, bool enabled);
+
+    /**
+     * @brief 创建用于接收ModemLine的队列（存储区优先分配在PSRAM）
+     * @param length 队列长度
+     * @return QueueHandle_t 队列句柄，失败返回nullptr
+     */
+    static QueueHandle_t createLineQueue(size_t length);
+
+    /**
+     * @brief 以回环Stream代替SIM模块串口（nullptr恢复使用串口）
+     *
+     * 切换时进行中的事务可能因收不到响应而超时，应在模块空闲时切换
+     * @param loopback 回环Stream（须在恢复串口前保持有效）
+     */
+    void attachLoopback(Stream* loopback);
+
+    /**
+     * @brief 是否正在使用回环Stream
+     * @return true 使用回环Stream
+     * @return false 使用SIM模块串口
+     */
+    bool isLoopbackAttached() const;
+
+    /**
+     * @brief 通知仲裁任务回环Stream有新数据（可在任意任务中调用）
+     */
+    void notifyLoopbackData();
+
+    /**
+     * @brief 获取统计信息
+     * @return ModemArbiterStats 统计信息
+     */
+    ModemArbiterStats getStats() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @brief 私有构造函数（每个SIM模块一个实例）
+     * @param index 模块序号
+     * @param serial 模块串口
+     */
+    ModemArbiter(uint8_t index, HardwareSerial& serial);
+
+    /**
+     * @brief 析构函数
+     */
+    ~ModemArbiter();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    ModemArbiter(const ModemArbiter&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    ModemArbiter& operator=(const ModemArbiter&) = delete;
+
+    /**
+     * @brief 串口接收回调（在UART驱动的事件任务中执行）
+     */
+    void onSerialReceive();
+
+    /**
+     * @brief FreeRTOS任务入口
+     * @param parameter ModemArbiter实例指针
+     */
+    static void arbiterTask(void* parameter);
+
+    /**
+     * @brief 计算本轮最长阻塞时间
+     * @return TickType_t 阻塞时间
+     */
+    TickType_t nextWaitTicks() const;
+
+    /**
+     * @brief 获取当前读写的端口（回环Stream或SIM模块串口）
+     * @return Stream& 端口
+     */
+    Stream& port();
+
+    /**
+     * @brief 读取串口数据并逐行分发
+     */
+    void pumpSerial();
+
+    /**
+     * @brief 依次取出分帧器中的数据段与完整行并分发
+     */
+    void drainFramer();
+
+    /**
+     * @brief 将数据段交给当前事务的读取回调
+     * @param data 数据
+     * @param length 数据长度
+     */
+    void deliverData(const char* data, size_t length);
+
+    /**
+     * @brief 分发一行数据（订阅者、当前事务或暂存区）
+     * @param line 行视图
+     */
+    void routeLine(const LineView& line);
+
+    /**
+     * @brief 检查当前事务的提示符、静默与超时条件
+     */
+    void checkActiveTransaction();
+
+    /**
+     * @brief 开始执行一个事务
+     * @param transaction 事务描述
+     */
+    void beginTransaction(ModemTransaction* transaction);
+
+    /**
+     * @brief 写入流式载荷（writer提供的全部数据）
+     */
+    void writeStream();
+
+    /**
+     * @brief 收到提示符后写入数据，事务继续等待结果
+     */
+    void writeBody();
+
+    /**
+     * @brief 结束当前事务并唤醒调用方
+     * @param status 执行结果
+     */
+    void finishTransaction(ModemTransactionStatus status);
+
+    /**
+     * @brief 将行投递到订阅者队列
+     * @param queue 订阅者队列
+     * @param line 行视图
+     */
+    void deliver(QueueHandle_t queue, const LineView& line);
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    uint8_t index;                                      ///< 模块序号（0为主模块）
+    HardwareSerial& serial;                             ///< SIM模块串口
+    std::atomic<Stream*> loopback;                      ///< 代替串口的回环Stream（nullptr表示使用串口）
+    QueueHandle_t transactionQueue;                     ///< 事务队列（存放ModemTransaction指针）
+    TaskHandle_t taskHandle;                            ///< 仲裁任务句柄
+    LineFramer framer;                                  ///< 行分帧器
+    uint8_t readChunk[UART_READ_CHUNK_SIZE];            ///< 串口读取缓冲
+    uint8_t writeChunk[MODEM_WRITE_CHUNK_SIZE];         ///< 流式载荷写入缓冲
+    ModemLine outgoing;                                 ///< 待投递行的暂存（避免占用任务栈）
+
+    ModemRouter router;                                 ///< 行路由（订阅表、事务结果判定与暂存区）
+
+    ModemTransaction* active;                           ///< 正在执行的事务
+    unsigned long activeStartedAt;                      ///< 当前事务开始时间
+
+    ModemArbiterStats stats;                            ///< 统计信息
+    String lastError;                                   ///< 最后的错误信息
+    bool debugMode;                                     ///< 调试模式
+    bool initialized;                                   ///< 是否已初始化
+};
+
+#endif // MODEM_ARBITER_H
@@ -0,0 +1,437 @@
+/**
+ * @file modem_router.cpp
+ * @brief 调制解调器行路由实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "modem_router.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 解析数据长度声明行中的长度（取最后一个逗号之后的数字，如"+HTTPREAD: 512"、"+HTTPREAD: DATA,512"）
+ * @param text 行前缀之后的内容
+ * @return size_t 数据长度
+ */
+static size_t parseDataLength(const char* text) {
+    const char* comma = strrchr(text, ',');
+    return (size_t)strtoul(comma != nullptr ? comma + 1 : text, nullptr, 10);
+}
+
+/**
+ * @brief 构造函数
+ */
+ModemRouter::ModemRouter()
+    : subscriptionCount(0), captureSubscriber(nullptr), backlogNext(0),
+      active(false), kind(MODEM_TXN_COMMAND), payload(nullptr), echoLength(0), expected(""),
+      terminator(nullptr), prompt(nullptr), promptReached(false), dataHeader(nullptr), dataRemaining(0), timeout(0), startedAt(0), lastMatchAt(0), receivedData(false) {
+    memset(subscriptions, 0, sizeof(subscriptions));
+    memset(backlog, 0, sizeof(backlog));
+}
+
+/**
+ * @brief 订阅以指定前缀开头的行
+ * @param prefix 行前缀
+ * @param subscriber 订阅者
+ * @param captureNextLine 是否同时投递紧随其后的一行
+ * @param enabled 是否立即生效
+ * @return true 订阅成功
+ * @return false 订阅数已达上限
+ */
+bool ModemRouter::subscribe(const char* prefix, void* subscriber, bool captureNextLine, bool enabled) {
+    if (subscriptionCount >= MODEM_MAX_SUBSCRIPTIONS) {
+        return false;
+    }
+
+    // 先写完整项再增加计数，路由时只读取计数以内的项
+    Subscription& entry = subscriptions[subscriptionCount];
+    entry.prefix = prefix;
+    entry.subscriber = subscriber;
+    entry.captureNextLine = captureNextLine;
+    entry.enabled = enabled;
+    subscriptionCount = subscriptionCount + 1;
+    return true;
+}
+
+/**
+ * @brief 启用或停用一项订阅
+ * @param prefix 订阅时的行前缀
+ * @param subscriber 订阅者
+ * @param enabled 是否启用
+ * @return true 已更新
+ * @return false 没有该订阅
+ */
+bool ModemRouter::setSubscriptionEnabled(const char* prefix, void* subscriber, bool enabled) {
+    size_t count = subscriptionCount;
+    for (size_t i = 0; i < count; i++) {
+        Subscription& entry = subscriptions[i];
+        if (entry.subscriber == subscriber && strcmp(entry.prefix, prefix) == 0) {
+            entry.enabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 获取订阅数量
+ * @return size_t 订阅数量
+ */
+size_t ModemRouter::getSubscriptionCount() const {
+    return subscriptionCount;
+}
+
+/**
+ * @brief 决定一行数据的去向
+ * @param line 行视图
+ * @param subscriber 输出：订阅者
+ * @return ModemRouteKind 去向
+ */
+ModemRouteKind ModemRouter::route(const LineView& line, void*& subscriber) {
+    if (line.length == 0) {
+        return MODEM_ROUTE_IGNORED;
+    }
+
+    // 上一行是需要携带下一行的URC（如+CMT:），本行直接投递给同一订阅者
+    if (captureSubscriber != nullptr) {
+        subscriber = captureSubscriber;
+        captureSubscriber = nullptr;
+        return MODEM_ROUTE_SUBSCRIBER;
+    }
+
+    // 订阅的URC无论是否有事务进行中都投递给订阅者；停用的订阅不截取，行仍可作为事务的响应
+    size_t count = subscriptionCount;
+    for (size_t i = 0; i < count; i++) {
+        const Subscription& entry = subscriptions[i];
+        if (entry.enabled && lineStartsWith(line.data, line.length, entry.prefix)) {
+            subscriber = entry.subscriber;
+            if (entry.captureNextLine) {
+                captureSubscriber = entry.subscriber;
+            }
+            return MODEM_ROUTE_SUBSCRIBER;
+        }
+    }
+
+    if (active && kind == MODEM_TXN_COMMAND) {
+        return MODEM_ROUTE_RESPONSE;
+    }
+    if (active && kind == MODEM_TXN_WAIT && strstr(line.data, expected) != nullptr) {
+        return MODEM_ROUTE_WAIT_MATCH;
+    }
+
+    rememberUnsolicited(line);
+    return MODEM_ROUTE_UNSOLICITED;
+}
+
+/**
+ * @brief 开始跟踪一个命令事务
+ * @param payload 写入的数据
+ * @param payloadLength 数据长度
+ * @param expected 期望的响应内容
+ * @param terminator 结束行
+ * @param dataHeader 声明数据长度的行前缀
+ * @param timeout 超时时间
+ * @param now 当前时间
+ */
+void ModemRouter::beginCommand(const char* payload, size_t payloadLength, const char* expected,
+                               const char* terminator, const char* dataHeader,
+                               unsigned long timeout, unsigned long now) {
+    // 新命令开始前的主动上报行视为陈旧数据（等同于原先发送前清空缓冲区）
+    clearBacklog();
+    active = true;
+    kind = MODEM_TXN_COMMAND;
+    this->payload = payload;
+    this->expected = expected != nullptr ? expected : "";
+    this->terminator = terminator != nullptr && terminator[0] != '\0' ? terminator : nullptr;
+    this->dataHeader = dataHeader != nullptr && dataHeader[0] != '\0' ? dataHeader : nullptr;
+    dataRemaining = 0;
+    prompt = nullptr;
+    promptReached = false;
+    this->timeout = timeout;
+    startedAt = now;
+    lastMatchAt = 0;
+    receivedData = false;
+
+    echoLength = 0;
+    while (echoLength < payloadLength && payload[echoLength] != '\r' && payload[echoLength] != '\n') {
+        echoLength++;
+    }
+}
+
+/**
+ * @brief 开始跟踪一个等待型事务
+ * @param expected 期望内容
+ * @param timeout 超时时间
+ * @param now 当前时间
+ */
+void ModemRouter::beginWait(const char* expected, unsigned long timeout, unsigned long now) {
+    active = true;
+    kind = MODEM_TXN_WAIT;
+    payload = nullptr;
+    echoLength = 0;
+    this->expected = expected != nullptr ? expected : "";
+    terminator = nullptr;
+    dataHeader = nullptr;
+    dataRemaining = 0;
+    prompt = nullptr;
+    promptReached = false;
+    this->timeout = timeout;
+    startedAt = now;
+    lastMatchAt = 0;
+    receivedData = false;
+}
+
+/**
+ * @brief 结束当前事务
+ */
+void ModemRouter::endTransaction() {
+    active = false;
+    lastMatchAt = 0;
+    // 未读完的数据段（如超时）不再按长度读取，剩余字节按行处理
+    dataRemaining = 0;
+    prompt = nullptr;
+    promptReached = false;
+}
+
+/**
+ * @brief 令当前命令事务先等待提示符
+ * @param prompt 提示符
+ */
+void ModemRouter::expectPrompt(const char* prompt) {
+    this->prompt = prompt != nullptr && prompt[0] != '\0' ? prompt : nullptr;
+    promptReached = false;
+}
+
+/**
+ * @brief 获取正在等待的提示符
+ * @return const char* 提示符，未在等待时为nullptr
+ */
+const char* ModemRouter::getPendingPrompt() const {
+    return active ? prompt : nullptr;
+}
+
+/**
+ * @brief 取出"已收到完整一行提示符"的标记
+ * @return true 已收到提示符
+ * @return false 未收到
+ */
+bool ModemRouter::takePromptReached() {
+    bool reached = promptReached;
+    promptReached = false;
+    return reached;
+}
+
+/**
+ * @brief 提示符之后的数据已写入，重新计时
+ * @param timeout 数据写入后的超时时间
+ * @param now 当前时间
+ */
+void ModemRouter::continueAfterPrompt(unsigned long timeout, unsigned long now) {
+    prompt = nullptr;
+    promptReached = false;
+    // 写入的数据可能被模块回显，但不会与命令回显相同
+    echoLength = 0;
+    this->timeout = timeout;
+    startedAt = now;
+    lastMatchAt = 0;
+    receivedData = false;
+}
+
+/**
+ * @brief 是否有事务在跟踪中
+ * @return true 有事务
+ * @return false 空闲
+ */
+bool ModemRouter::isActive() const {
+    return active;
+}
+
+/**
+ * @brief 将一行追加到命令事务的响应并判断是否完成
+ * @param line 行视图
+ * @param response 事务的响应内容
+ * @param now 当前时间
+ * @param status 输出：完成时的执行结果
+ * @return true 事务已完成
+ * @return false 仍在进行
+ */
+bool ModemRouter::appendResponse(const LineView& line, String& response, unsigned long now,
+                                 ModemTransactionStatus& status) {
+    response += line.data;
+    response += "\r\n";
+
+    // 命令回显不算作模块的响应
+    bool isEcho = line.length == echoLength && echoLength > 0 && memcmp(line.data, payload, echoLength) == 0;
+    if (!isEcho) {
+        receivedData = true;
+    }
+
+    FinalResultCode code = classifyFinalResult(line.data, line.length);
+
+    // 等待提示符：数据还没有写入，提示符之前的最终结果码说明命令被拒绝
+    if (prompt != nullptr) {
+        if (!isEcho && strstr(line.data, prompt) != nullptr) {
+            promptReached = true;
+        } else if (code != FINAL_NONE) {
+            status = code == FINAL_ERROR ? MODEM_TXN_ERROR : MODEM_TXN_INVALID;
+            return true;
+        }
+        return false;
+    }
+
+    // 声明数据长度的行：其后的字节是数据段（可能含空行、ERROR或URC前缀），由仲裁器按长度读取
+    if (dataHeader != nullptr && !isEcho && lineStartsWith(line.data, line.length, dataHeader)) {
+        dataRemaining = parseDataLength(line.data + strlen(dataHeader));
+    }
+
+    // 指定了结束行的命令（如AT+HTTPREAD在OK之后才输出数据）：OK不结束事务
+    if (terminator != nullptr && code != FINAL_ERROR) {
+        if (strcmp(line.data, terminator) == 0) {
+            status = MODEM_TXN_OK;
+            return true;
+        }
+        return false;
+    }
+
+    bool hasExpected = expected[0] != '\0';
+    if (hasExpected && !isEcho && strstr(line.data, expected) != nullptr) {
+        lastMatchAt = now;
+    }
+
+    if (code != FINAL_NONE) {
+        if (lastMatchAt != 0 || (!hasExpected && code == FINAL_OK)) {
+            status = MODEM_TXN_OK;
+        } else if (code == FINAL_ERROR) {
+            status = MODEM_TXN_ERROR;
+        } else {
+            status = MODEM_TXN_INVALID;
+        }
+        return true;
+    }
+
+    // 已匹配但后续仍有中间行：推迟静默判定
+    if (lastMatchAt != 0) {
+        lastMatchAt = now;
+    }
+    return false;
+}
+
+/**
+ * @brief 获取尚待按长度读取的数据字节数
+ * @return size_t 字节数
+ */
+size_t ModemRouter::pendingData() const {
+    return dataRemaining;
+}
+
+/**
+ * @brief 记录已按长度读取的数据字节
+ * @param length 字节数
+ */
+void ModemRouter::consumeData(size_t length) {
+    dataRemaining = length < dataRemaining ? dataRemaining - length : 0;
+}
+
+/**
+ * @brief 检查期望响应之后的静默与超时条件
+ * @param now 当前时间
+ * @param status 输出：完成时的执行结果
+ * @param timedOut 输出：是否因超时完成
+ * @return true 事务已完成
+ * @return false 仍在进行
+ */
+bool ModemRouter::checkTimers(unsigned long now, ModemTransactionStatus& status, bool& timedOut) const {
+    timedOut = false;
+    if (!active) {
+        return false;
+    }
+
+    // 期望响应不是最终结果码（如DOWNLOAD）时，其后静默一小段时间即认为完成
+    if (lastMatchAt != 0 && now - lastMatchAt >= MODEM_RESPONSE_SETTLE_MS) {
+        status = MODEM_TXN_OK;
+        return true;
+    }
+
+    if (now - startedAt >= timeout) {
+        timedOut = true;
+        if (!receivedData) {
+            status = MODEM_TXN_TIMEOUT;
+        } else if (prompt != nullptr) {
+            // 有响应但一直没有提示符，数据未写入
+            status = MODEM_TXN_INVALID;
+        } else if (expected[0] == '\0') {
+            // 未指定期望响应时返回已收到的内容
+            status = MODEM_TXN_OK;
+        } else {
+            status = MODEM_TXN_INVALID;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 距离下一个静默或超时判定的时间
+ * @param now 当前时间
+ * @return unsigned long 毫秒
+ */
+unsigned long ModemRouter::nextWaitMs(unsigned long now) const {
+    if (!active) {
+        return 0;
+    }
+
+    unsigned long elapsed = now - startedAt;
+    unsigned long remaining = elapsed >= timeout ? 0 : timeout - elapsed;
+
+    if (lastMatchAt != 0) {
+        unsigned long sinceMatch = now - lastMatchAt;
+        unsigned long settle = sinceMatch >= MODEM_RESPONSE_SETTLE_MS ? 0 : MODEM_RESPONSE_SETTLE_MS - sinceMatch;
+        if (settle < remaining) {
+            remaining = settle;
+        }
+    }
+    return remaining;
+}
+
+/**
+ * @brief 暂存一条主动上报行（满时覆盖最旧的一条）
+ * @param line 行视图
+ */
+void ModemRouter::rememberUnsolicited(const LineView& line) {
+    BacklogEntry& entry = backlog[backlogNext];
+    size_t length = line.length < MODEM_UNSOLICITED_LINE_LENGTH ? line.length : MODEM_UNSOLICITED_LINE_LENGTH;
+    memcpy(entry.data, line.data, length);
+    entry.data[length] = '\0';
+    entry.used = true;
+    backlogNext = (backlogNext + 1) % MODEM_UNSOLICITED_BACKLOG_SIZE;
+}
+
+/**
+ * @brief 在暂存区中查找并取出包含指定内容的行
+ * @param expected 期望内容
+ * @param response 输出的行内容
+ * @return true 找到
+ * @return false 未找到
+ */
+bool ModemRouter::takeUnsolicited(const char* expected, String& response) {
+    // 从最旧的一条开始查找，保持上报顺序
+    for (size_t i = 0; i < MODEM_UNSOLICITED_BACKLOG_SIZE; i++) {
+        BacklogEntry& entry = backlog[(backlogNext + i) % MODEM_UNSOLICITED_BACKLOG_SIZE];
+        if (entry.used && strstr(entry.data, expected) != nullptr) {
+            response = entry.data;
+            entry.used = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 清空暂存区
+ */
+void ModemRouter::clearBacklog() {
+    for (size_t i = 0; i < MODEM_UNSOLICITED_BACKLOG_SIZE; i++) {
+        backlog[i].used = false;
+    }
+}
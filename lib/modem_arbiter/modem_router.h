@@ -0,0 +1,276 @@
+/**
+ * @file modem_router.h
+ * @brief 调制解调器行路由 - 决定串口上每一行交给订阅者、当前事务还是暂存区，并判定事务何时完成
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 维护URC订阅表，按前缀匹配行，并让需要携带下一行的订阅（如+CMT:）收到紧随其后的PDU行
+ * 2. 跟踪当前事务（命令或等待型），按回显、期望响应、结束行与最终结果码判定结果
+ * 3. 判定期望响应之后的静默与事务超时（时间以参数传入，不读取时钟）
+ * 4. 暂存最近的主动上报行，供等待型事务匹配
+ * 5. 带提示符的命令（如AT+CMGS的"> "、AT+HTTPDATA的DOWNLOAD）先等待提示符，再在同一事务内判定数据写入后的结果
+ * 6. 识别声明数据长度的响应行（如"+HTTPREAD: <n>"），其后n字节由仲裁器按长度读取，不经过分行
+ *
+ * 不依赖FreeRTOS与串口，由ModemArbiter在仲裁任务中调用，主机测试直接回放串口记录
+ */
+
+#ifndef MODEM_ROUTER_H
+#define MODEM_ROUTER_H
+
+#include <Arduino.h>
+#include "../line_framer/line_framer.h"
+#include "../../include/constants.h"
+
+/**
+ * @enum ModemTransactionKind
+ * @brief AT事务类型
+ */
+enum ModemTransactionKind {
+    MODEM_TXN_COMMAND = 0,     ///< 写入载荷并收集响应，直到最终结果码/期望响应/超时
+    MODEM_TXN_WAIT,            ///< 不写入数据，等待包含期望内容的主动上报行
+    MODEM_TXN_DISCARD          ///< 丢弃暂存的主动上报行
+};
+
+/**
+ * @enum ModemTransactionStatus
+ * @brief AT事务执行结果
+ */
+enum ModemTransactionStatus {
+    MODEM_TXN_OK = 0,          ///< 收到期望响应（未指定期望响应时为收到OK）
+    MODEM_TXN_TIMEOUT,         ///< 超时且未收到任何响应
+    MODEM_TXN_ERROR,           ///< 收到错误类最终结果码
+    MODEM_TXN_INVALID,         ///< 收到响应但不包含期望内容
+    MODEM_TXN_BUSY             ///< 仲裁器未运行或事务队列已满
+};
+
+/**
+ * @enum ModemRouteKind
+ * @brief 一行数据的去向
+ */
+enum ModemRouteKind {
+    MODEM_ROUTE_IGNORED = 0,   ///< 空行，丢弃
+    MODEM_ROUTE_SUBSCRIBER,    ///< 投递给订阅者
+    MODEM_ROUTE_RESPONSE,      ///< 属于当前命令事务的响应
+    MODEM_ROUTE_WAIT_MATCH,    ///< 匹配当前等待型事务的期望内容
+    MODEM_ROUTE_UNSOLICITED    ///< 无人处理的主动上报（已暂存）
+};
+
+/**
+ * @class ModemRouter
+ * @brief 调制解调器行路由类
+ *
+ * subscribe()与setSubscriptionEnabled()可在其他任务中调用，其余方法只应由同一个任务（仲裁任务）调用
+ */
+class ModemRouter {
+public:
+    /**
+     * @brief 构造函数
+     */
+    ModemRouter();
+
+    /**
+     * @brief 订阅以指定前缀开头的行
+     * @param prefix 行前缀（须为静态字符串）
+     * @param subscriber 订阅者（仲裁器中为队列句柄）
+     * @param captureNextLine 是否同时投递紧随其后的一行
+     * @param enabled 是否立即生效（停用的订阅不截取行，行按无人订阅处理）
+     * @return true 订阅成功
+     * @return false 订阅数已达上限
+     */
+    bool subscribe(const char* prefix, void* subscriber, bool captureNextLine, bool enabled = true);
+
+    /**
+     * @brief 启用或停用一项订阅
+     * @param prefix 订阅时的行前缀
+     * @param subscriber 订阅者
+     * @param enabled 是否启用
+     * @return true 已更新
+     * @return false 没有该订阅
+     */
+    bool setSubscriptionEnabled(const char* prefix, void* subscriber, bool enabled);
+
+    /**
+     * @brief 获取订阅数量
+     * @return size_t 订阅数量
+     */
+    size_t getSubscriptionCount() const;
+
+    /**
+     * @brief 决定一行数据的去向（无人处理的行同时存入暂存区）
+     * @param line 行视图
+     * @param subscriber 输出：MODEM_ROUTE_SUBSCRIBER时为订阅者
+     * @return ModemRouteKind 去向
+     */
+    ModemRouteKind route(const LineView& line, void*& subscriber);
+
+    /**
+     * @brief 开始跟踪一个命令事务（新命令之前的暂存行视为陈旧数据，一并清空）
+     * @param payload 写入的数据（首行为命令回显）
+     * @param payloadLength 数据长度
+     * @param expected 期望的响应内容，""表示以最终结果码为准
+     * @param terminator 结束行（nullptr表示无）
+     * @param dataHeader 声明数据长度的行前缀（如"+HTTPREAD:"，nullptr表示无）
+     * @param timeout 超时时间（毫秒）
+     * @param now 当前时间（millis）
+     */
+    void beginCommand(const char* payload, size_t payloadLength, const char* expected, const char* terminator,
+                      const char* dataHeader, unsigned long timeout, unsigned long now);
+
+    /**
+     * @brief 令当前命令事务先等待提示符（在beginCommand()之后调用）
+     *
+     * 等待期间提示符之前的最终结果码结束事务（ERROR为失败，OK为响应无效）；
+     * 收到提示符后由调用方写入数据并调用continueAfterPrompt()
+     * @param prompt 提示符（须在事务期间保持有效）
+     */
+    void expectPrompt(const char* prompt);
+
+    /**
+     * @brief 获取正在等待的提示符
+     * @return const char* 提示符，未在等待时为nullptr
+     */
+    const char* getPendingPrompt() const;
+
+    /**
+     * @brief 取出"已收到完整一行提示符"的标记（appendResponse()在提示符行上设置）
+     * @return true 已收到提示符
+     * @return false 未收到
+     */
+    bool takePromptReached();
+
+    /**
+     * @brief 提示符之后的数据已写入：重新计时，按期望响应与最终结果码判定结果
+     * @param timeout 数据写入后的超时时间（毫秒）
+     * @param now 当前时间（millis）
+     */
+    void continueAfterPrompt(unsigned long timeout, unsigned long now);
+
+    /**
+     * @brief 开始跟踪一个等待型事务
+     * @param expected 期望内容
+     * @param timeout 超时时间（毫秒）
+     * @param now 当前时间（millis）
+     */
+    void beginWait(const char* expected, unsigned long timeout, unsigned long now);
+
+    /**
+     * @brief 结束当前事务
+     */
+    void endTransaction();
+
+    /**
+     * @brief 是否有事务在跟踪中
+     * @return true 有事务
+     * @return false 空闲
+     */
+    bool isActive() const;
+
+    /**
+     * @brief 将一行追加到命令事务的响应并判断是否完成
+     * @param line 行视图（route()返回MODEM_ROUTE_RESPONSE的行）
+     * @param response 事务的响应内容（追加本行与"\r\n"）
+     * @param now 当前时间（millis）
+     * @param status 输出：完成时的执行结果
+     * @return true 事务已完成
+     * @return false 仍在进行
+     */
+    bool appendResponse(const LineView& line, String& response, unsigned long now, ModemTransactionStatus& status);
+
+    /**
+     * @brief 获取尚待按长度读取的数据字节数
+     *
+     * 非0时串口上的后续字节属于数据段，应通过LineFramer::takeRaw()取出并调用consumeData()，
+     * 不能交给route()
+     * @return size_t 字节数
+     */
+    size_t pendingData() const;
+
+    /**
+     * @brief 记录已按长度读取的数据字节
+     * @param length 字节数（不超过pendingData()）
+     */
+    void consumeData(size_t length);
+
+    /**
+     * @brief 检查期望响应之后的静默与超时条件
+     * @param now 当前时间（millis）
+     * @param status 输出：完成时的执行结果
+     * @param timedOut 输出：是否因超时完成
+     * @return true 事务已完成
+     * @return false 仍在进行
+     */
+    bool checkTimers(unsigned long now, ModemTransactionStatus& status, bool& timedOut) const;
+
+    /**
+     * @brief 距离下一个静默或超时判定的时间
+     * @param now 当前时间（millis）
+     * @return unsigned long 毫秒（空闲时为0）
+     */
+    unsigned long nextWaitMs(unsigned long now) const;
+
+    /**
+     * @brief 暂存一条主动上报行（满时覆盖最旧的一条）
+     * @param line 行视图
+     */
+    void rememberUnsolicited(const LineView& line);
+
+    /**
+     * @brief 在暂存区中查找并取出包含指定内容的行
+     * @param expected 期望内容
+     * @param response 输出的行内容
+     * @return true 找到
+     * @return false 未找到
+     */
+    bool takeUnsolicited(const char* expected, String& response);
+
+    /**
+     * @brief 清空暂存区
+     */
+    void clearBacklog();
+
+private:
+    /**
+     * @struct Subscription
+     * @brief URC订阅项
+     */
+    struct Subscription {
+        const char* prefix;             ///< 行前缀
+        void* subscriber;               ///< 订阅者
+        bool captureNextLine;           ///< 是否投递紧随其后的一行
+        volatile bool enabled;          ///< 是否生效
+    };
+
+    /**
+     * @struct BacklogEntry
+     * @brief 暂存的主动上报行
+     */
+    struct BacklogEntry {
+        bool used;                                      ///< 是否有效
+        char data[MODEM_UNSOLICITED_LINE_LENGTH + 1];   ///< 行内容
+    };
+
+    Subscription subscriptions[MODEM_MAX_SUBSCRIPTIONS]; ///< URC订阅表
+    volatile size_t subscriptionCount;                  ///< 订阅数量
+    void* captureSubscriber;                            ///< 需要接收下一行的订阅者
+
+    BacklogEntry backlog[MODEM_UNSOLICITED_BACKLOG_SIZE]; ///< 主动上报行暂存区
+    size_t backlogNext;                                 ///< 下一个写入位置
+
+    bool active;                                        ///< 是否有事务在跟踪中
+    ModemTransactionKind kind;                          ///< 当前事务类型
+    const char* payload;                                ///< 当前命令的载荷（用于识别回显）
+    size_t echoLength;                                  ///< 当前命令回显的长度（不含换行）
+    const char* expected;                               ///< 期望的响应内容
+    const char* terminator;                             ///< 结束行（nullptr表示无）
+    const char* prompt;                                 ///< 正在等待的提示符（nullptr表示无）
+    bool promptReached;                                 ///< 已收到完整一行提示符，等待写入数据
+    const char* dataHeader;                             ///< 声明数据长度的行前缀（nullptr表示无）
+    size_t dataRemaining;                               ///< 尚待按长度读取的数据字节数
+    unsigned long timeout;                              ///< 超时时间
+    unsigned long startedAt;                            ///< 事务开始时间
+    unsigned long lastMatchAt;                          ///< 最近一次匹配到期望响应的时间（0表示未匹配）
+    bool receivedData;                                  ///< 是否收到过非回显数据
+};
+
+#endif // MODEM_ROUTER_H
@@ -0,0 +1,256 @@
+/**
+ * @file modem_script.cpp
+ * @brief 调制解调器回放脚本与命令应答实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "modem_script.h"
+#include <string.h>
+
+/// 生成短信的正文前缀（UTF-16："压测短信 #"）
+static const uint16_t SYNTHETIC_TEXT_PREFIX[] = { 0x538B, 0x6D4B, 0x77ED, 0x4FE1, 0x0020, 0x0023 };
+
+/**
+ * @brief 追加一个字节的十六进制表示
+ * @param output 输出
+ * @param value 字节
+ */
+static void appendHexByte(String& output, uint8_t value) {
+    static const char digits[] = "0123456789ABCDEF";
+    output += digits[value >> 4];
+    output += digits[value & 0x0F];
+}
+
+/**
+ * @brief 追加两位十进制数的半字节反序编码（如时间戳中的"24"编码为"42"）
+ * @param output 输出
+ * @param value 0-99
+ */
+static void appendSwappedDecimal(String& output, int value) {
+    output += (char)('0' + value % 10);
+    output += (char)('0' + value / 10 % 10);
+}
+
+/**
+ * @brief 清空已解析的内容
+ */
+void ModemScript::clear() {
+    events.clear();
+    dialogues.clear();
+    current = "";
+}
+
+/**
+ * @brief 解析脚本的一行
+ * @param line 脚本行
+ */
+void ModemScript::addLine(const String& line) {
+    String text = line;
+    if (text.endsWith("\r")) {
+        text.remove(text.length() - 1);
+    }
+
+    // 标记字符后的一个空格不属于内容
+    char marker = text.length() > 0 ? text[0] : '\0';
+    String content = text.length() > 1 ? text.substring(text[1] == ' ' ? 2 : 1) : String();
+
+    if (marker != '<' && current.length() > 0) {
+        events.push_back(current);
+        current = "";
+    }
+    if (marker == '<') {
+        current += content + "\r\n";
+    } else if (marker == '?') {
+        ModemDialogue dialogue;
+        dialogue.prefix = content;
+        dialogues.push_back(dialogue);
+    } else if (marker == '=' && !dialogues.empty()) {
+        dialogues.back().reply += content + "\r\n";
+    }
+}
+
+/**
+ * @brief 结束解析
+ */
+void ModemScript::finish() {
+    if (current.length() > 0) {
+        events.push_back(current);
+        current = "";
+    }
+}
+
+/**
+ * @brief 获取主动上报事件
+ * @return const std::vector<String>& 事件列表
+ */
+const std::vector<String>& ModemScript::getEvents() const {
+    return events;
+}
+
+/**
+ * @brief 获取命令对话
+ * @return const std::vector<ModemDialogue>& 对话列表
+ */
+const std::vector<ModemDialogue>& ModemScript::getDialogues() const {
+    return dialogues;
+}
+
+/**
+ * @brief 生成一条各不相同的+CMT:短信（UCS2编码）
+ *
+ * 发送方号码随序号变化、时间戳取回放开始时间，短信去重不会把它们当作网络重传
+ * @param index 事件序号
+ * @param baseTime 短信时间戳
+ * @param output 输出：+CMT:行与PDU行
+ */
+void ModemScript::buildSyntheticSms(uint32_t index, time_t baseTime, String& output) {
+    char sender[16];
+    snprintf(sender, sizeof(sender), "86138%08lu", (unsigned long)(index % 100000000UL));
+    size_t senderDigits = strlen(sender);
+
+    String pdu;
+    pdu.reserve(128);
+    pdu += "0004";                              // 无短信中心地址，SMS-DELIVER
+    appendHexByte(pdu, (uint8_t)senderDigits);
+    pdu += "91";                                // 国际号码
+    for (size_t i = 0; i < senderDigits; i += 2) {
+        pdu += i + 1 < senderDigits ? sender[i + 1] : 'F';
+        pdu += sender[i];
+    }
+    pdu += "0008";                              // PID 0，UCS2编码
+
+    struct tm parts;
+    gmtime_r(&baseTime, &parts);
+    appendSwappedDecimal(pdu, parts.tm_year % 100);
+    appendSwappedDecimal(pdu, parts.tm_mon + 1);
+    appendSwappedDecimal(pdu, parts.tm_mday);
+    appendSwappedDecimal(pdu, parts.tm_hour);
+    appendSwappedDecimal(pdu, parts.tm_min);
+    appendSwappedDecimal(pdu, parts.tm_sec);
+    pdu += "00";                                // 时区
+
+    char number[12];
+    snprintf(number, sizeof(number), "%lu", (unsigned long)index);
+    size_t prefixLength = sizeof(SYNTHETIC_TEXT_PREFIX) / sizeof(SYNTHETIC_TEXT_PREFIX[0]);
+    size_t units = prefixLength + strlen(number);
+    appendHexByte(pdu, (uint8_t)(units * 2));
+    for (size_t i = 0; i < prefixLength; i++) {
+        appendHexByte(pdu, SYNTHETIC_TEXT_PREFIX[i] >> 8);
+        appendHexByte(pdu, SYNTHETIC_TEXT_PREFIX[i] & 0xFF);
+    }
+    for (const char* digit = number; *digit != '\0'; digit++) {
+        appendHexByte(pdu, 0x00);
+        appendHexByte(pdu, (uint8_t)*digit);
+    }
+
+    // +CMT:中的长度不含短信中心地址（此处为1字节）
+    output = "+CMT: ," + String((unsigned long)(pdu.length() / 2 - 1)) + "\r\n";
+    output += pdu;
+    output += "\r\n";
+}
+
+/**
+ * @brief 构造函数
+ */
+ModemResponder::ModemResponder()
+    : dialogues(nullptr), pendingDataBytes(0), awaitingSmsPdu(false), skipLineFeed(false) {
+}
+
+/**
+ * @brief 清空接收状态并设置对话表
+ * @param dialogues 脚本中的对话
+ */
+void ModemResponder::reset(const std::vector<ModemDialogue>* dialogues) {
+    this->dialogues = dialogues;
+    commandLine = "";
+    pendingDataBytes = 0;
+    awaitingSmsPdu = false;
+    skipLineFeed = false;
+}
+
+/**
+ * @brief 接收主机写入的数据并生成回复
+ * @param buffer 数据
+ * @param size 数据长度
+ * @param replies 输出：追加的回复
+ * @return size_t 本次应答的命令数
+ */
+size_t ModemResponder::receive(const uint8_t* buffer, size_t size, String& replies) {
+    size_t answered = 0;
+    for (size_t i = 0; i < size; i++) {
+        uint8_t byte = buffer[i];
+
+        // 命令以"\r\n"结尾时'\n'不属于随后的请求体或PDU
+        if (skipLineFeed) {
+            skipLineFeed = false;
+            if (byte == '\n') {
+                continue;
+            }
+        }
+
+        // AT+HTTPDATA之后的请求体：收满声明的长度后回复OK
+        if (pendingDataBytes > 0) {
+            if (--pendingDataBytes == 0) {
+                replies += "OK\r\n";
+            }
+            continue;
+        }
+
+        // AT+CMGS之后的PDU：Ctrl+Z结束并回复消息参考号，ESC取消
+        if (awaitingSmsPdu) {
+            if (byte == 0x1A) {
+                awaitingSmsPdu = false;
+                replies += "\r\n+CMGS: 1\r\n\r\nOK\r\n";
+            } else if (byte == 0x1B) {
+                awaitingSmsPdu = false;
+                replies += "OK\r\n";
+            }
+            continue;
+        }
+
+        if (byte == '\r' || byte == '\n') {
+            if (commandLine.length() > 0) {
+                String command = commandLine;
+                commandLine = "";
+                answerCommand(command, replies);
+                answered++;
+                skipLineFeed = byte == '\r';
+            }
+        } else if (commandLine.length() < MODEM_SIM_COMMAND_MAX_LENGTH) {
+            commandLine += (char)byte;
+        }
+    }
+    return answered;
+}
+
+/**
+ * @brief 应答一条命令
+ * @param command 命令
+ * @param replies 输出：追加的回复
+ */
+void ModemResponder::answerCommand(const String& command, String& replies) {
+    if (dialogues != nullptr) {
+        for (const ModemDialogue& dialogue : *dialogues) {
+            if (command.startsWith(dialogue.prefix)) {
+                replies += dialogue.reply;
+                return;
+            }
+        }
+    }
+
+    if (command.startsWith("AT+HTTPDATA=")) {
+        pendingDataBytes = (size_t)command.substring(12).toInt();
+        replies += pendingDataBytes > 0 ? "DOWNLOAD\r\n" : "DOWNLOAD\r\nOK\r\n";
+    } else if (command.startsWith("AT+HTTPACTION=")) {
+        // 响应体为"{}"，随后由AT+HTTPREAD读取
+        replies += "OK\r\n+HTTPACTION: " + command.substring(14) + ",200,2\r\n";
+    } else if (command.startsWith("AT+HTTPREAD")) {
+        replies += "OK\r\n+HTTPREAD: 2\r\n{}\r\n+HTTPREAD: 0\r\n";
+    } else if (command.startsWith("AT+CMGS=")) {
+        awaitingSmsPdu = true;
+        replies += "\r\n> ";
+    } else {
+        replies += "OK\r\n";
+    }
+}
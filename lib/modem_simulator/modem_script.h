@@ -0,0 +1,121 @@
+/**
+ * @file modem_script.h
+ * @brief 调制解调器回放脚本与命令应答 - 解析抓取的串口记录、生成压测短信并应答主机的AT命令
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 不依赖FreeRTOS与文件系统：ModemSimulator负责读文件、限速与写入接收缓冲，
+ * 主机测试直接用同样的脚本与应答逻辑回放串口记录
+ *
+ * 脚本格式见modem_simulator.h
+ */
+
+#ifndef MODEM_SCRIPT_H
+#define MODEM_SCRIPT_H
+
+#include <Arduino.h>
+#include <time.h>
+#include <vector>
+#include "../../include/constants.h"
+
+/**
+ * @struct ModemDialogue
+ * @brief 脚本中的命令对话
+ */
+struct ModemDialogue {
+    String prefix;              ///< 命令前缀
+    String reply;               ///< 回复（每行以"\r\n"结尾）
+};
+
+/**
+ * @class ModemScript
+ * @brief 回放脚本：主动上报事件与命令对话
+ */
+class ModemScript {
+public:
+    /**
+     * @brief 清空已解析的内容
+     */
+    void clear();
+
+    /**
+     * @brief 解析脚本的一行
+     * @param line 脚本行（可带结尾的'\r'）
+     */
+    void addLine(const String& line);
+
+    /**
+     * @brief 结束解析（收尾最后一个事件）
+     */
+    void finish();
+
+    /**
+     * @brief 获取主动上报事件
+     * @return const std::vector<String>& 事件列表（每行以"\r\n"结尾）
+     */
+    const std::vector<String>& getEvents() const;
+
+    /**
+     * @brief 获取命令对话
+     * @return const std::vector<ModemDialogue>& 对话列表
+     */
+    const std::vector<ModemDialogue>& getDialogues() const;
+
+    /**
+     * @brief 生成一条各不相同的+CMT:短信（UCS2编码）
+     * @param index 事件序号
+     * @param baseTime 短信时间戳
+     * @param output 输出：+CMT:行与PDU行
+     */
+    static void buildSyntheticSms(uint32_t index, time_t baseTime, String& output);
+
+private:
+    std::vector<String> events;                     ///< 主动上报事件
+    std::vector<ModemDialogue> dialogues;           ///< 命令对话
+    String current;                                 ///< 正在累积的事件
+};
+
+/**
+ * @class ModemResponder
+ * @brief 命令应答：AT命令按行应答，数据阶段按长度或结束符应答
+ *
+ * 脚本中的对话优先，其次是内置的HTTP与短信发送对话，其余命令一律回复OK
+ */
+class ModemResponder {
+public:
+    /**
+     * @brief 构造函数
+     */
+    ModemResponder();
+
+    /**
+     * @brief 清空接收状态并设置对话表
+     * @param dialogues 脚本中的对话（须在应答期间保持有效，nullptr表示无）
+     */
+    void reset(const std::vector<ModemDialogue>* dialogues);
+
+    /**
+     * @brief 接收主机写入的数据并生成回复
+     * @param buffer 数据
+     * @param size 数据长度
+     * @param replies 输出：追加的回复
+     * @return size_t 本次应答的命令数
+     */
+    size_t receive(const uint8_t* buffer, size_t size, String& replies);
+
+private:
+    /**
+     * @brief 应答一条命令
+     * @param command 命令（不含换行）
+     * @param replies 输出：追加的回复
+     */
+    void answerCommand(const String& command, String& replies);
+
+    const std::vector<ModemDialogue>* dialogues;    ///< 脚本中的对话
+    String commandLine;                             ///< 正在接收的命令
+    size_t pendingDataBytes;                        ///< AT+HTTPDATA之后仍待接收的数据字节数
+    bool awaitingSmsPdu;                            ///< AT+CMGS之后正在接收PDU（以Ctrl+Z结束）
+    bool skipLineFeed;                              ///< 上一条命令以'\r'结束，紧随的'\n'属于同一结束符
+};
+
+#endif // MODEM_SCRIPT_H
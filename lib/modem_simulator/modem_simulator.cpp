@@ -0,0 +1,424 @@
+/**
+ * @file modem_simulator.cpp
+ * @brief 调制解调器模拟器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "modem_simulator.h"
+#include "../modem_arbiter/modem_arbiter.h"
+#include "../event_bus/event_bus.h"
+#include "../filesystem_manager/filesystem_manager.h"
+#include "../task_topology/task_topology.h"
+#include "../log_manager/log_manager.h"
+#include "../../include/config.h"
+#include <time.h>
+#include <string.h>
+
+// 单例实例
+ModemSimulator& ModemSimulator::getInstance() {
+    static ModemSimulator instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+ModemSimulator::ModemSimulator()
+    : rxBuffer(nullptr), emitMutex(nullptr), taskHandle(nullptr), peeked(-1),
+      baseTime(0),
+      running(false), stopRequested(false), sentEvents(0), droppedEvents(0),
+      lateEvents(0), maxLagMs(0), answeredCommands(0), storedSms(0), completedPushes(0),
+      startedAt(0), lastStoredAt(0), baselineDroppedLines(0), eventSubscription(-1),
+      debugMode(false) {
+    options.ratePerSecond = 0;
+    options.eventCount = 0;
+}
+
+/**
+ * @brief 接管仲裁器串口并开始回放
+ * @param options 回放参数
+ * @return true 已开始
+ * @return false 参数无效、脚本无法加载或已在回放
+ */
+bool ModemSimulator::start(const ModemSimulatorOptions& options) {
+    if (running.load()) {
+        setError("回放正在进行中");
+        return false;
+    }
+    if (options.eventCount == 0 || options.eventCount > MODEM_SIM_MAX_EVENTS) {
+        setError("事件数应在1-" + String(MODEM_SIM_MAX_EVENTS) + "之间");
+        return false;
+    }
+    ModemArbiter& arbiter = ModemArbiter::getInstance();
+    if (!arbiter.isRunning()) {
+        setError("调制解调器仲裁器未运行");
+        return false;
+    }
+
+    // 接收缓冲与回放任务在第一次回放时创建，之后常驻
+    if (rxBuffer == nullptr) {
+        rxBuffer = xStreamBufferCreate(SIM_UART_RX_BUFFER_SIZE, 1);
+        emitMutex = xSemaphoreCreateMutex();
+        if (rxBuffer == nullptr || emitMutex == nullptr) {
+            setError("模拟器缓冲区创建失败");
+            return false;
+        }
+    }
+    if (taskHandle == nullptr &&
+        !TaskTopology::getInstance().createTask(SYSTEM_TASK_MODEM_SIMULATOR, simulatorTask, this, &taskHandle)) {
+        setError("回放任务创建失败");
+        return false;
+    }
+
+    script.clear();
+    if (options.scriptPath.length() > 0 && !loadScript(options.scriptPath)) {
+        return false;
+    }
+
+    this->options = options;
+    sentEvents = 0;
+    droppedEvents = 0;
+    lateEvents = 0;
+    maxLagMs = 0;
+    answeredCommands = 0;
+    storedSms = 0;
+    completedPushes = 0;
+    startedAt = millis();
+    lastStoredAt = 0;
+    ModemArbiterStats stats = arbiter.getStats();
+    baselineDroppedLines = stats.droppedLines + stats.framerOverflows;
+    baseTime = time(nullptr);
+
+    xStreamBufferReset(rxBuffer);
+    peeked = -1;
+    responder.reset(&script.getDialogues());
+
+    // 通过事件总线统计端到端结果，无需在短信与推送流程中埋点
+    eventSubscription = EventBus::getInstance().subscribe([this](const char* type, const String& data) {
+        if (strcmp(type, EVENT_TYPE_SMS) == 0) {
+            storedSms++;
+            lastStoredAt = millis();
+        } else if (strcmp(type, EVENT_TYPE_PUSH) == 0) {
+            completedPushes++;
+        }
+    });
+
+    stopRequested = false;
+    running = true;
+    arbiter.attachLoopback(this);
+    xTaskNotifyGive(taskHandle);
+
+    LOG_INFO(LOG_MODULE_UART, "调制解调器模拟器开始回放: " + String(options.eventCount) + " 个事件，" +
+             (options.ratePerSecond > 0 ? String(options.ratePerSecond) + " 个/秒" : String("不限速")) +
+             (options.scriptPath.length() > 0 ? "，脚本 " + options.scriptPath : String("")));
+    return true;
+}
+
+/**
+ * @brief 请求停止回放
+ */
+void ModemSimulator::stop() {
+    stopRequested = true;
+}
+
+/**
+ * @brief 是否正在回放
+ * @return true 正在回放
+ * @return false 空闲
+ */
+bool ModemSimulator::isRunning() const {
+    return running.load();
+}
+
+/**
+ * @brief 获取回放报告
+ * @return ModemSimulatorReport 回放报告
+ */
+ModemSimulatorReport ModemSimulator::getReport() const {
+    ModemSimulatorReport report;
+    report.running = running.load();
+    report.plannedEvents = options.eventCount;
+    report.sentEvents = sentEvents.load();
+    report.droppedEvents = droppedEvents.load();
+    report.lateEvents = lateEvents.load();
+    report.maxLagMs = maxLagMs.load();
+    report.answeredCommands = answeredCommands.load();
+    report.storedSms = storedSms.load();
+    report.completedPushes = completedPushes.load();
+
+    ModemArbiterStats stats = ModemArbiter::getInstance().getStats();
+    unsigned long droppedLines = stats.droppedLines + stats.framerOverflows;
+    report.droppedLines = droppedLines >= baselineDroppedLines ? droppedLines - baselineDroppedLines : 0;
+
+    unsigned long lastStored = lastStoredAt.load();
+    report.elapsedMs = report.storedSms > 0 ? lastStored - startedAt.load() : 0;
+    return report;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String ModemSimulator::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void ModemSimulator::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief 可读取的字节数
+ * @return int 字节数
+ */
+int ModemSimulator::available() {
+    if (rxBuffer == nullptr) {
+        return 0;
+    }
+    return (int)xStreamBufferBytesAvailable(rxBuffer) + (peeked >= 0 ? 1 : 0);
+}
+
+/**
+ * @brief 读取一个字节
+ * @return int 字节，无数据时返回-1
+ */
+int ModemSimulator::read() {
+    if (peeked >= 0) {
+        int value = peeked;
+        peeked = -1;
+        return value;
+    }
+    uint8_t value;
+    if (rxBuffer == nullptr || xStreamBufferReceive(rxBuffer, &value, 1, 0) != 1) {
+        return -1;
+    }
+    return value;
+}
+
+/**
+ * @brief 查看下一个字节但不取出
+ * @return int 字节，无数据时返回-1
+ */
+int ModemSimulator::peek() {
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+/**
+ * @brief 读取已到达的数据（不等待）
+ * @param buffer 输出缓冲区
+ * @param length 缓冲区容量
+ * @return size_t 读取的字节数
+ */
+size_t ModemSimulator::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    if (length > 0 && peeked >= 0) {
+        buffer[count++] = (char)peeked;
+        peeked = -1;
+    }
+    if (rxBuffer != nullptr && count < length) {
+        count += xStreamBufferReceive(rxBuffer, buffer + count, length - count, 0);
+    }
+    return count;
+}
+
+/**
+ * @brief 接收主机写入的一个字节
+ * @param byte 字节
+ * @return size_t 1
+ */
+size_t ModemSimulator::write(uint8_t byte) {
+    return write(&byte, 1);
+}
+
+/**
+ * @brief 接收主机写入的数据：AT命令按行应答，数据阶段按长度或结束符应答
+ * @param buffer 数据
+ * @param size 数据长度
+ * @return size_t 接收的字节数（总是全部接收）
+ */
+size_t ModemSimulator::write(const uint8_t* buffer, size_t size) {
+    String replies;
+    answeredCommands += (uint32_t)responder.receive(buffer, size, replies);
+    if (replies.length() > 0) {
+        emit(replies.c_str(), replies.length(), false);
+    }
+    return size;
+}
+
+/**
+ * @brief 刷新输出（应答已同步写入接收缓冲，无需处理）
+ */
+void ModemSimulator::flush() {
+}
+
+/**
+ * @brief FreeRTOS任务入口
+ * @param parameter ModemSimulator实例指针
+ */
+void ModemSimulator::simulatorTask(void* parameter) {
+    ModemSimulator* simulator = static_cast<ModemSimulator*>(parameter);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (simulator->running.load()) {
+            simulator->runReplay();
+        }
+    }
+}
+
+/**
+ * @brief 执行一次回放
+ */
+void ModemSimulator::runReplay() {
+    uint32_t rate = options.ratePerSecond;
+    uint32_t intervalMs = rate > 0 ? 1000 / rate : 0;
+    unsigned long origin = millis();
+    startedAt = origin;
+    String event;
+
+    for (uint32_t i = 0; i < options.eventCount && !stopRequested.load(); i++) {
+        // 按计划时间发出；落后时立即发出并记录迟发
+        if (rate > 0) {
+            unsigned long due = origin + (unsigned long)((uint64_t)i * 1000 / rate);
+            unsigned long now = millis();
+            if ((long)(due - now) > 0) {
+                vTaskDelay(pdMS_TO_TICKS(due - now));
+            } else {
+                uint32_t lag = now - due;
+                if (lag > intervalMs) {
+                    lateEvents++;
+                }
+                if (lag > maxLagMs.load()) {
+                    maxLagMs = lag;
+                }
+            }
+        }
+
+        const std::vector<String>& events = script.getEvents();
+        if (events.empty()) {
+            ModemScript::buildSyntheticSms(i, baseTime, event);
+        } else {
+            event = events[i % events.size()];
+        }
+
+        // 限速回放模拟真实串口，接收缓冲满时事件丢失；不限速时等待缓冲腾出空间以测量最大吞吐
+        bool sent = emit(event.c_str(), event.length(), true);
+        while (!sent && rate == 0 && !stopRequested.load()) {
+            vTaskDelay(1);
+            sent = emit(event.c_str(), event.length(), true);
+        }
+        if (sent) {
+            sentEvents++;
+        } else {
+            droppedEvents++;
+        }
+    }
+
+    // 保持接管一段时间，让进行中的推送对话完成
+    unsigned long settleStart = millis();
+    while (!stopRequested.load() && millis() - settleStart < MODEM_SIM_SETTLE_MS) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    ModemArbiter::getInstance().attachLoopback(nullptr);
+    EventBus::getInstance().unsubscribe(eventSubscription);
+    eventSubscription = -1;
+    running = false;
+
+    ModemSimulatorReport report = getReport();
+    LOG_INFO(LOG_MODULE_UART, "调制解调器模拟器回放结束: 发出 " + String(report.sentEvents) +
+             "，丢弃 " + String(report.droppedEvents) + "，迟发 " + String(report.lateEvents) +
+             "，入库 " + String(report.storedSms));
+}
+
+/**
+ * @brief 加载回放脚本
+ * @param path 脚本路径
+ * @return true 加载成功且至少有一个事件
+ * @return false 加载失败
+ */
+bool ModemSimulator::loadScript(const String& path) {
+    FilesystemManager& fsManager = FilesystemManager::getInstance();
+    if (!fsManager.isReady()) {
+        setError("文件系统未就绪");
+        return false;
+    }
+    File file = fsManager.getFS().open(path, "r");
+    if (!file) {
+        setError("无法打开脚本: " + path);
+        return false;
+    }
+    if (file.size() > MODEM_SIM_SCRIPT_MAX_BYTES) {
+        file.close();
+        setError("脚本超过 " + String(MODEM_SIM_SCRIPT_MAX_BYTES) + " 字节");
+        return false;
+    }
+
+    while (file.available()) {
+        script.addLine(file.readStringUntil('\n'));
+    }
+    script.finish();
+    file.close();
+
+    if (script.getEvents().empty()) {
+        setError("脚本中没有主动上报事件: " + path);
+        return false;
+    }
+    debugPrint("已加载脚本 " + path + "：" + String((int)script.getEvents().size()) + " 个事件，" +
+               String((int)script.getDialogues().size()) + " 段对话");
+    return true;
+}
+
+/**
+ * @brief 写入接收缓冲并唤醒仲裁任务
+ * @param data 数据
+ * @param length 数据长度
+ * @param wholeOnly 空间不足以容纳全部数据时不写入
+ * @return true 已写入
+ * @return false 空间不足
+ */
+bool ModemSimulator::emit(const char* data, size_t length, bool wholeOnly) {
+    if (rxBuffer == nullptr || length == 0) {
+        return false;
+    }
+
+    bool written;
+    xSemaphoreTake(emitMutex, portMAX_DELAY);
+    if (wholeOnly && xStreamBufferSpacesAvailable(rxBuffer) < length) {
+        written = false;
+    } else {
+        written = xStreamBufferSend(rxBuffer, data, length, 0) == length;
+    }
+    xSemaphoreGive(emitMutex);
+
+    if (written || !wholeOnly) {
+        ModemArbiter::getInstance().notifyLoopbackData();
+    }
+    return written;
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void ModemSimulator::setError(const String& error) {
+    lastError = error;
+    debugPrint("错误: " + error);
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void ModemSimulator::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[ModemSimulator] " + message);
+    }
+}
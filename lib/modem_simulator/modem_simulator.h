@@ -0,0 +1,214 @@
+/**
+ * @file modem_simulator.h
+ * @brief 调制解调器模拟器 - 以回环Stream代替SIM模块串口，按指定速率回放串口流量
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 接管调制解调器仲裁器的串口，AtCommandHandler与UART监控任务照常工作，察觉不到区别
+ * 2. 按指定速率发出主动上报事件（默认生成各不相同的+CMT:短信，也可回放脚本中抓取的流量），
+ *    接收缓冲与硬件串口同样大小，主机处理不过来时事件被丢弃
+ * 3. 应答主机发出的AT命令：脚本中的对话优先，其次是内置的HTTP与短信发送对话，其余命令一律回复OK
+ * 4. 统计发出、丢弃与迟发的事件数，并经由事件总线统计入库短信数与推送数，计算端到端吞吐
+ *
+ * 脚本解析、压测短信生成与命令应答见modem_script.h（不依赖FreeRTOS，主机测试也使用）
+ *
+ * 回放脚本为文本文件，每行以一个标记字符开头：
+ *   "< 行"      主动上报的一行；连续的"<"行构成一个事件，以空行分隔
+ *   "? 前缀"    对话：主机发出以该前缀开头的命令时回复其后的"="行
+ *   "= 行"      对话的一行回复
+ *   "#"         注释
+ */
+
+#ifndef MODEM_SIMULATOR_H
+#define MODEM_SIMULATOR_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "modem_script.h"
+#include "../../include/constants.h"
+
+/**
+ * @struct ModemSimulatorOptions
+ * @brief 回放参数
+ */
+struct ModemSimulatorOptions {
+    uint32_t ratePerSecond;         ///< 每秒发出的事件数（0表示不限速）
+    uint32_t eventCount;            ///< 发出的事件总数（回放脚本时循环使用脚本中的事件）
+    String scriptPath;              ///< 回放脚本路径（空表示生成+CMT:短信）
+};
+
+/**
+ * @struct ModemSimulatorReport
+ * @brief 回放报告
+ */
+struct ModemSimulatorReport {
+    bool running;                   ///< 是否正在回放
+    uint32_t plannedEvents;         ///< 计划发出的事件数
+    uint32_t sentEvents;            ///< 已发出的事件数
+    uint32_t droppedEvents;         ///< 接收缓冲已满被丢弃的事件数
+    uint32_t lateEvents;            ///< 晚于计划时间超过一个发送间隔的事件数
+    uint32_t maxLagMs;              ///< 最大迟发时间（毫秒）
+    uint32_t droppedLines;          ///< 仲裁器因订阅者队列已满或行过长丢弃的行数
+    uint32_t answeredCommands;      ///< 已应答的AT命令数
+    uint32_t storedSms;             ///< 入库的短信数
+    uint32_t completedPushes;       ///< 完成的推送数（含失败）
+    unsigned long elapsedMs;        ///< 第一个事件发出到最后一条短信入库的时间（毫秒）
+};
+
+/**
+ * @class ModemSimulator
+ * @brief 调制解调器模拟器类（单例）
+ *
+ * 作为Stream由仲裁任务读写：read()/available()只在仲裁任务中调用，
+ * write()在仲裁任务中调用并同步生成应答
+ */
+class ModemSimulator : public Stream {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return ModemSimulator& 单例引用
+     */
+    static ModemSimulator& getInstance();
+
+    /**
+     * @brief 接管仲裁器串口并开始回放
+     * @param options 回放参数
+     * @return true 已开始
+     * @return false 参数无效、脚本无法加载或已在回放
+     */
+    bool start(const ModemSimulatorOptions& options);
+
+    /**
+     * @brief 请求停止回放（回放任务随后恢复串口）
+     */
+    void stop();
+
+    /**
+     * @brief 是否正在回放
+     * @return true 正在回放
+     * @return false 空闲
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 获取回放报告
+     * @return ModemSimulatorReport 回放报告
+     */
+    ModemSimulatorReport getReport() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+    // Stream接口（模拟器 -> 主机）
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char* buffer, size_t length) override;
+
+    // Print接口（主机 -> 模拟器）
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void flush() override;
+    using Print::write;
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    ModemSimulator();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    ModemSimulator(const ModemSimulator&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    ModemSimulator& operator=(const ModemSimulator&) = delete;
+
+    /**
+     * @brief FreeRTOS任务入口（常驻，每次回放由start()唤醒）
+     * @param parameter ModemSimulator实例指针
+     */
+    static void simulatorTask(void* parameter);
+
+    /**
+     * @brief 执行一次回放
+     */
+    void runReplay();
+
+    /**
+     * @brief 加载回放脚本
+     * @param path 脚本路径
+     * @return true 加载成功且至少有一个事件
+     * @return false 加载失败
+     */
+    bool loadScript(const String& path);
+
+    /**
+     * @brief 写入接收缓冲并唤醒仲裁任务
+     * @param data 数据
+     * @param length 数据长度
+     * @param wholeOnly 空间不足以容纳全部数据时不写入
+     * @return true 已写入
+     * @return false 空间不足
+     */
+    bool emit(const char* data, size_t length, bool wholeOnly);
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    StreamBufferHandle_t rxBuffer;                  ///< 模拟器发往主机的数据（与硬件串口接收缓冲同样大小）
+    SemaphoreHandle_t emitMutex;                    ///< 串行化回放任务与应答对接收缓冲的写入
+    TaskHandle_t taskHandle;                        ///< 回放任务句柄
+    int peeked;                                     ///< peek()取出的字节（-1表示无）
+
+    ModemSimulatorOptions options;                  ///< 当前回放参数
+    ModemScript script;                             ///< 回放脚本
+    ModemResponder responder;                       ///< 命令应答
+    time_t baseTime;                                ///< 生成短信的时间戳基准
+
+    std::atomic<bool> running;                      ///< 是否正在回放
+    std::atomic<bool> stopRequested;                ///< 是否请求停止
+    std::atomic<uint32_t> sentEvents;               ///< 已发出的事件数
+    std::atomic<uint32_t> droppedEvents;            ///< 被丢弃的事件数
+    std::atomic<uint32_t> lateEvents;               ///< 迟发的事件数
+    std::atomic<uint32_t> maxLagMs;                 ///< 最大迟发时间
+    std::atomic<uint32_t> answeredCommands;         ///< 已应答的命令数
+    std::atomic<uint32_t> storedSms;                ///< 入库的短信数
+    std::atomic<uint32_t> completedPushes;          ///< 完成的推送数
+    std::atomic<unsigned long> startedAt;           ///< 第一个事件的计划发出时间
+    std::atomic<unsigned long> lastStoredAt;        ///< 最后一条短信入库的时间
+    unsigned long baselineDroppedLines;             ///< 回放开始时仲裁器的丢行数
+    int eventSubscription;                          ///< 事件总线订阅ID（-1表示未订阅）
+
+    String lastError;                               ///< 最后的错误信息
+    bool debugMode;                                 ///< 调试模式
+};
+
+#endif // MODEM_SIMULATOR_H
@@ -7,6 +7,7 @@
 
 #include "network_config.h"
 #include "../at_command_handler/at_command_handler.h"
+#include "../config_manager/config_manager.h"
 #include <Arduino.h>
 
 /**
@@ -39,8 +40,7 @@ bool NetworkConfig::initialize() {
     debugPrint("初始化网络配置管理器...");
     
     // 检查GSM服务是否可用
-    GsmService& gsmService = GsmService::getInstance();
-    if (!gsmService.isModuleOnline()) {
+    if (!GsmService::getInstance().getStatus().online) {
         setError("GSM模块未在线");
         return false;
     }
@@ -59,8 +59,9 @@ NetworkConfigResult NetworkConfig::autoConfigureNetwork() {
     configStatus = NETWORK_CONFIG_IN_PROGRESS;
     resetConfigResult();
     
-    // 获取IMSI号码
-    String imsi = getImsiNumber();
+    // 优先使用启动时写入运行配置快照的IMSI
+    std::shared_ptr<const RuntimeConfig> config = ConfigManager::getInstance().getSnapshot();
+    String imsi = config->imsi.length() > 0 ? config->imsi : getImsiNumber();
     if (imsi.length() == 0) {
         setError("无法获取IMSI号码");
         lastResult.status = NETWORK_CONFIG_FAILED;
@@ -72,9 +73,13 @@ NetworkConfigResult NetworkConfig::autoConfigureNetwork() {
     lastResult.imsi = imsi;
     debugPrint("获取到IMSI: " + imsi);
     
-    // 识别运营商
-    CarrierConfig& carrierConfig = CarrierConfig::getInstance();
-    CarrierType carrierType = carrierConfig.identifyCarrier(imsi);
+    // 识别运营商（快照中已有解析结果时直接使用）
+    CarrierInfo carrierInfo = config->carrier;
+    if (imsi != config->imsi) {
+        carrierInfo = CarrierConfig::getInstance().resolveCarrier(imsi);
+        ConfigManager::getInstance().setCarrier(imsi, carrierInfo);
+    }
+    CarrierType carrierType = carrierInfo.type;
     
     if (carrierType == CARRIER_UNKNOWN) {
         setError("无法识别运营商类型");
@@ -84,8 +89,6 @@ NetworkConfigResult NetworkConfig::autoConfigureNetwork() {
         return lastResult;
     }
     
-    // 获取运营商信息
-    CarrierInfo carrierInfo = carrierConfig.getCarrierInfo(carrierType);
     currentCarrierInfo = carrierInfo;
     lastResult.carrierType = carrierType;
     lastResult.carrierName = carrierInfo.name;
@@ -223,11 +226,7 @@ NetworkConfigResult NetworkConfig::reconfigureNetwork() {
  * @return false 网络未连接
  */
 bool NetworkConfig::isNetworkReady() {
-    GsmService& gsmService = GsmService::getInstance();
-    GsmNetworkStatus networkStatus = gsmService.getNetworkStatus();
-    
-    return (networkStatus == GSM_NETWORK_REGISTERED_HOME || 
-            networkStatus == GSM_NETWORK_REGISTERED_ROAMING);
+    return GsmService::getInstance().getStatus().isRegistered();
 }
 
 /**
@@ -0,0 +1,517 @@
+/**
+ * @file pdu_decoder.cpp
+ * @brief 短信PDU解码器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "pdu_decoder.h"
+#include <Arduino.h>
+#include <pdulib.h>
+#include <string.h>
+
+namespace {
+
+/// GSM 7位默认字母表（3GPP TS 23.038），下标为septet值，0x1B为扩展表转义符
+const uint16_t GSM7_BASIC[128] = {
+    0x0040, 0x00A3, 0x0024, 0x00A5, 0x00E8, 0x00E9, 0x00F9, 0x00EC,
+    0x00F2, 0x00C7, 0x000A, 0x00D8, 0x00F8, 0x000D, 0x00C5, 0x00E5,
+    0x0394, 0x005F, 0x03A6, 0x0393, 0x039B, 0x03A9, 0x03A0, 0x03A8,
+    0x03A3, 0x0398, 0x039E, 0x00A0, 0x00C6, 0x00E6, 0x00DF, 0x00C9,
+    0x0020, 0x0021, 0x0022, 0x0023, 0x00A4, 0x0025, 0x0026, 0x0027,
+    0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+    0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,
+    0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+    0x00A1, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
+    0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+    0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
+    0x0058, 0x0059, 0x005A, 0x00C4, 0x00D6, 0x00D1, 0x00DC, 0x00A7,
+    0x00BF, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,
+    0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+    0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,
+    0x0078, 0x0079, 0x007A, 0x00E4, 0x00F6, 0x00F1, 0x00FC, 0x00E0
+};
+
+/**
+ * @brief GSM 7位扩展表（转义符之后的septet）
+ * @param septet septet值
+ * @return uint16_t Unicode码点，未定义时返回0
+ */
+uint16_t gsm7Extension(uint8_t septet) {
+    switch (septet) {
+        case 0x0A: return 0x000C;
+        case 0x14: return 0x005E;
+        case 0x28: return 0x007B;
+        case 0x29: return 0x007D;
+        case 0x2F: return 0x005C;
+        case 0x3C: return 0x005B;
+        case 0x3D: return 0x007E;
+        case 0x3E: return 0x005D;
+        case 0x40: return 0x007C;
+        case 0x65: return 0x20AC;
+        default: return 0;
+    }
+}
+
+/**
+ * @class HexReader
+ * @brief 按八位组读取十六进制字符串
+ */
+class HexReader {
+public:
+    HexReader(const char* hex, size_t length) : hex(hex), octets(length / 2), position(0) {}
+
+    /**
+     * @brief 读取下一个八位组
+     * @param value 输出：八位组
+     * @return true 读取成功
+     * @return false 已到末尾或不是十六进制字符
+     */
+    bool next(uint8_t& value) {
+        if (position >= octets || !at(position, value)) {
+            return false;
+        }
+        position++;
+        return true;
+    }
+
+    /**
+     * @brief 读取指定位置的八位组（不移动读取位置）
+     * @param index 八位组下标
+     * @param value 输出：八位组
+     * @return true 读取成功
+     * @return false 越界或不是十六进制字符
+     */
+    bool at(size_t index, uint8_t& value) const {
+        if (index >= octets) {
+            return false;
+        }
+        int high = nibble(hex[index * 2]);
+        int low = nibble(hex[index * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        value = (uint8_t)((high << 4) | low);
+        return true;
+    }
+
+    /**
+     * @brief 跳过若干八位组
+     * @param count 八位组数
+     * @return true 跳过成功
+     * @return false 剩余长度不足
+     */
+    bool skip(size_t count) {
+        if (remaining() < count) {
+            return false;
+        }
+        position += count;
+        return true;
+    }
+
+    size_t tell() const { return position; }
+    size_t remaining() const { return octets - position; }
+
+private:
+    static int nibble(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    const char* hex;
+    size_t octets;
+    size_t position;
+};
+
+/**
+ * @class Utf8Writer
+ * @brief 向定长缓冲区写入UTF-8，容量不足时丢弃后续字符并标记截断
+ */
+class Utf8Writer {
+public:
+    Utf8Writer(char* buffer, size_t capacity) : buffer(buffer), capacity(capacity), length(0), truncated(false) {
+        if (capacity > 0) {
+            buffer[0] = '\0';
+        }
+    }
+
+    void put(uint32_t codepoint) {
+        char encoded[4];
+        size_t size;
+        if (codepoint < 0x80) {
+            encoded[0] = (char)codepoint;
+            size = 1;
+        } else if (codepoint < 0x800) {
+            encoded[0] = (char)(0xC0 | (codepoint >> 6));
+            encoded[1] = (char)(0x80 | (codepoint & 0x3F));
+            size = 2;
+        } else if (codepoint < 0x10000) {
+            encoded[0] = (char)(0xE0 | (codepoint >> 12));
+            encoded[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            encoded[2] = (char)(0x80 | (codepoint & 0x3F));
+            size = 3;
+        } else {
+            encoded[0] = (char)(0xF0 | (codepoint >> 18));
+            encoded[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            encoded[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            encoded[3] = (char)(0x80 | (codepoint & 0x3F));
+            size = 4;
+        }
+        // 不写入半个字符，始终保留结尾'\0'的位置
+        if (truncated || length + size + 1 > capacity) {
+            truncated = true;
+            return;
+        }
+        memcpy(buffer + length, encoded, size);
+        length += size;
+        buffer[length] = '\0';
+    }
+
+    size_t size() const { return length; }
+    bool isTruncated() const { return truncated; }
+
+private:
+    char* buffer;
+    size_t capacity;
+    size_t length;
+    bool truncated;
+};
+
+/**
+ * @brief 解码打包的GSM 7位septet
+ * @param reader 读取器（用户数据从readerStart处开始）
+ * @param dataStart 打包数据起始八位组下标
+ * @param firstSeptet 第一个有效septet的序号（跳过用户数据头及填充位）
+ * @param septetCount septet总数（含被跳过的部分）
+ * @param writer UTF-8输出
+ * @return true 解码成功
+ * @return false 数据不足
+ */
+bool decodeGsm7(const HexReader& reader, size_t dataStart, size_t firstSeptet, size_t septetCount, Utf8Writer& writer) {
+    bool escape = false;
+    for (size_t i = firstSeptet; i < septetCount; i++) {
+        size_t bit = i * 7;
+        uint8_t low = 0;
+        uint8_t high = 0;
+        if (!reader.at(dataStart + bit / 8, low)) {
+            return false;
+        }
+        size_t shift = bit % 8;
+        if (shift > 1 && !reader.at(dataStart + bit / 8 + 1, high)) {
+            return false;
+        }
+        uint8_t septet = (uint8_t)((((uint16_t)high << 8 | low) >> shift) & 0x7F);
+
+        if (escape) {
+            uint16_t extended = gsm7Extension(septet);
+            // 未定义的扩展字符按规范显示为基本表中的字符
+            writer.put(extended != 0 ? extended : GSM7_BASIC[septet]);
+            escape = false;
+        } else if (septet == 0x1B) {
+            escape = true;
+        } else {
+            writer.put(GSM7_BASIC[septet]);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 解析发送方地址
+ * @param reader 读取器
+ * @param pdu 输出
+ * @return true 解析成功
+ * @return false 格式错误
+ */
+bool decodeAddress(HexReader& reader, SmsPdu& pdu) {
+    uint8_t digits = 0;
+    uint8_t type = 0;
+    if (!reader.next(digits) || !reader.next(type)) {
+        return false;
+    }
+    size_t octets = (digits + 1) / 2;
+    size_t start = reader.tell();
+    if (!reader.skip(octets)) {
+        return false;
+    }
+
+    if (((type >> 4) & 0x07) == 0x05) {
+        // 字母数字地址：以GSM 7位编码
+        Utf8Writer writer(pdu.sender, sizeof(pdu.sender));
+        return decodeGsm7(reader, start, 0, digits * 4 / 7, writer);
+    }
+
+    size_t length = 0;
+    if (((type >> 4) & 0x07) == 0x01) {
+        pdu.sender[length++] = '+';
+    }
+    for (size_t i = 0; i < digits && length < SMS_PDU_SENDER_MAX_LENGTH; i++) {
+        uint8_t octet = 0;
+        reader.at(start + i / 2, octet);
+        uint8_t nibble = (i % 2 == 0) ? (octet & 0x0F) : (octet >> 4);
+        if (nibble == 0x0F) {
+            break;
+        }
+        pdu.sender[length++] = "0123456789*#abc"[nibble];
+    }
+    pdu.sender[length] = '\0';
+    return true;
+}
+
+/**
+ * @brief 解析SCTS时间戳
+ * @param reader 读取器
+ * @param pdu 输出
+ * @return true 解析成功
+ * @return false 数据不足
+ */
+bool decodeTimestamp(HexReader& reader, SmsPdu& pdu) {
+    for (int i = 0; i < 6; i++) {
+        uint8_t octet = 0;
+        if (!reader.next(octet)) {
+            return false;
+        }
+        // 半字节交换：低半字节为十位
+        pdu.timestamp[i * 2] = (char)('0' + (octet & 0x0F) % 10);
+        pdu.timestamp[i * 2 + 1] = (char)('0' + (octet >> 4) % 10);
+    }
+    pdu.timestamp[12] = '\0';
+
+    uint8_t zone = 0;
+    if (!reader.next(zone)) {
+        return false;
+    }
+    // 低半字节的第3位为符号位
+    int quarters = (zone & 0x07) * 10 + (zone >> 4);
+    pdu.timezoneQuarters = (int8_t)((zone & 0x08) ? -quarters : quarters);
+    return true;
+}
+
+/**
+ * @brief 根据DCS确定用户数据编码
+ * @param dcs 数据编码方案
+ * @param alphabet 输出：编码
+ * @return true 可解码
+ * @return false 压缩编码等不支持的方案
+ */
+bool alphabetFromDcs(uint8_t dcs, SmsAlphabet& alphabet) {
+    if ((dcs & 0x80) == 0) {
+        // 通用编码组：第5位为压缩标志，第3-2位为字母表
+        if (dcs & 0x20) {
+            return false;
+        }
+        switch ((dcs >> 2) & 0x03) {
+            case 0x01: alphabet = SMS_ALPHABET_8BIT; break;
+            case 0x02: alphabet = SMS_ALPHABET_UCS2; break;
+            default: alphabet = SMS_ALPHABET_GSM7; break;
+        }
+        return true;
+    }
+    switch (dcs & 0xF0) {
+        case 0xE0:
+            alphabet = SMS_ALPHABET_UCS2;
+            break;
+        case 0xF0:
+            alphabet = (dcs & 0x04) ? SMS_ALPHABET_8BIT : SMS_ALPHABET_GSM7;
+            break;
+        default:
+            // 0xC0/0xD0为等待消息指示组（GSM 7位），保留组按GSM 7位处理
+            alphabet = SMS_ALPHABET_GSM7;
+            break;
+    }
+    return true;
+}
+
+/**
+ * @brief 解析用户数据头中的长短信信息
+ * @param reader 读取器
+ * @param headerStart 用户数据头长度字段的八位组下标
+ * @param headerLength 用户数据头长度（不含长度字段本身）
+ * @param pdu 输出
+ * @return true 解析成功
+ * @return false 数据不足
+ */
+bool decodeUserDataHeader(const HexReader& reader, size_t headerStart, uint8_t headerLength, SmsPdu& pdu) {
+    size_t position = headerStart + 1;
+    size_t end = position + headerLength;
+    while (position + 2 <= end) {
+        uint8_t iei = 0;
+        uint8_t length = 0;
+        if (!reader.at(position, iei) || !reader.at(position + 1, length)) {
+            return false;
+        }
+        position += 2;
+        if (position + length > end) {
+            return false;
+        }
+
+        uint8_t value[4] = {0, 0, 0, 0};
+        for (size_t i = 0; i < length && i < sizeof(value); i++) {
+            reader.at(position + i, value[i]);
+        }
+        if (iei == 0x00 && length == 3) {
+            pdu.concatRef = value[0];
+            pdu.concatTotal = value[1];
+            pdu.concatPart = value[2];
+        } else if (iei == 0x08 && length == 4) {
+            pdu.concatRef = (uint16_t)((value[0] << 8) | value[1]);
+            pdu.concatTotal = value[2];
+            pdu.concatPart = value[3];
+        }
+        position += length;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief 解码SMS-DELIVER十六进制PDU
+ * @param hex PDU十六进制字符串
+ * @param length 字符串长度
+ * @param pdu 输出：解码结果
+ * @param textBuffer 正文输出缓冲区
+ * @param capacity 缓冲区容量
+ * @return true 解码成功
+ * @return false 解码失败
+ */
+bool decodeSmsPdu(const char* hex, size_t length, SmsPdu& pdu, char* textBuffer, size_t capacity) {
+    memset(&pdu, 0, sizeof(pdu));
+    pdu.text = textBuffer;
+    if (hex == nullptr || textBuffer == nullptr || capacity == 0) {
+        return false;
+    }
+    textBuffer[0] = '\0';
+
+    HexReader reader(hex, length);
+    uint8_t smscLength = 0;
+    uint8_t firstOctet = 0;
+    if (!reader.next(smscLength) || !reader.skip(smscLength) || !reader.next(firstOctet)) {
+        return false;
+    }
+    // 只处理SMS-DELIVER（MTI = 00）
+    if ((firstOctet & 0x03) != 0x00) {
+        return false;
+    }
+    bool hasHeader = (firstOctet & 0x40) != 0;
+
+    if (!decodeAddress(reader, pdu) || !reader.next(pdu.pid) || !reader.next(pdu.dcs) ||
+        !decodeTimestamp(reader, pdu) || !alphabetFromDcs(pdu.dcs, pdu.alphabet)) {
+        return false;
+    }
+
+    uint8_t userDataLength = 0;
+    if (!reader.next(userDataLength)) {
+        return false;
+    }
+    size_t dataStart = reader.tell();
+    // GSM 7位时长度以septet计
+    size_t dataOctets = pdu.alphabet == SMS_ALPHABET_GSM7 ? (userDataLength * 7 + 7) / 8 : userDataLength;
+    if (reader.remaining() < dataOctets) {
+        return false;
+    }
+
+    size_t headerOctets = 0;
+    if (hasHeader) {
+        uint8_t headerLength = 0;
+        if (!reader.at(dataStart, headerLength) || headerLength + 1u > dataOctets ||
+            !decodeUserDataHeader(reader, dataStart, headerLength, pdu)) {
+            return false;
+        }
+        headerOctets = headerLength + 1;
+    }
+
+    Utf8Writer writer(textBuffer, capacity);
+    switch (pdu.alphabet) {
+        case SMS_ALPHABET_GSM7: {
+            // 用户数据头之后填充到septet边界
+            size_t firstSeptet = (headerOctets * 8 + 6) / 7;
+            if (!decodeGsm7(reader, dataStart, firstSeptet, userDataLength, writer)) {
+                return false;
+            }
+            break;
+        }
+        case SMS_ALPHABET_UCS2: {
+            for (size_t i = headerOctets; i + 1 < dataOctets; i += 2) {
+                uint8_t high = 0;
+                uint8_t low = 0;
+                reader.at(dataStart + i, high);
+                reader.at(dataStart + i + 1, low);
+                uint32_t unit = ((uint32_t)high << 8) | low;
+                if (unit >= 0xD800 && unit <= 0xDBFF && i + 3 < dataOctets) {
+                    uint8_t nextHigh = 0;
+                    uint8_t nextLow = 0;
+                    reader.at(dataStart + i + 2, nextHigh);
+                    reader.at(dataStart + i + 3, nextLow);
+                    uint32_t next = ((uint32_t)nextHigh << 8) | nextLow;
+                    if (next >= 0xDC00 && next <= 0xDFFF) {
+                        writer.put(0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00));
+                        i += 2;
+                        continue;
+                    }
+                }
+                // 不成对的代理项替换为U+FFFD
+                writer.put(unit >= 0xD800 && unit <= 0xDFFF ? 0xFFFD : unit);
+            }
+            break;
+        }
+        case SMS_ALPHABET_8BIT:
+        default:
+            // 8位数据按Latin-1显示
+            for (size_t i = headerOctets; i < dataOctets; i++) {
+                uint8_t octet = 0;
+                reader.at(dataStart + i, octet);
+                writer.put(octet);
+            }
+            break;
+    }
+
+    pdu.textLength = writer.size();
+    pdu.textTruncated = writer.isTruncated();
+    return true;
+}
+
+/**
+ * @brief 测量同一PDU分别由pdulib与原地解码器解码的耗时
+ * @param hex PDU十六进制字符串
+ * @param iterations 每种方式的解码次数
+ * @return PduBenchmarkResult 测量结果
+ */
+PduBenchmarkResult benchmarkPduDecode(const char* hex, int iterations) {
+    PduBenchmarkResult result;
+    result.iterations = 0;
+    result.pdulibAvgUs = 0;
+    result.inPlaceAvgUs = 0;
+
+    static char text[SMS_PDU_TEXT_BUFFER_SIZE];
+    SmsPdu pdu;
+    size_t length = strlen(hex);
+    if (iterations <= 0 || !decodeSmsPdu(hex, length, pdu, text, sizeof(text))) {
+        return result;
+    }
+
+    // 原先的做法：每条短信构造PDU对象并把各字段复制为String
+    unsigned long start = micros();
+    for (int i = 0; i < iterations; i++) {
+        PDU decoder;
+        if (decoder.decodePDU(hex)) {
+            String sender = decoder.getSender();
+            String content = decoder.getText();
+            String timestamp = decoder.getTimeStamp();
+        }
+    }
+    unsigned long pdulibTotal = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < iterations; i++) {
+        decodeSmsPdu(hex, length, pdu, text, sizeof(text));
+    }
+    unsigned long inPlaceTotal = micros() - start;
+
+    result.iterations = iterations;
+    result.pdulibAvgUs = pdulibTotal / iterations;
+    result.inPlaceAvgUs = inPlaceTotal / iterations;
+    return result;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file pdu_decoder.h
+ * @brief 短信PDU解码器 - 原地解析SMS-DELIVER十六进制PDU，不分配堆内存
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 直接在十六进制字符串上解析SMSC、发送方地址、PID/DCS、SCTS时间戳与用户数据头
+ * 2. 识别8位与16位参考号的长短信分片信息（IEI 0x00 / 0x08）
+ * 3. 将GSM 7位默认字母表（含扩展表）、UCS2（含代理对）与8位数据解码为UTF-8，
+ *    写入调用方提供的缓冲区
+ * 4. 提供与pdulib对比的解码耗时测量
+ */
+
+#ifndef PDU_DECODER_H
+#define PDU_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../include/constants.h"
+
+/**
+ * @enum SmsAlphabet
+ * @brief 用户数据编码
+ */
+enum SmsAlphabet {
+    SMS_ALPHABET_GSM7 = 0,     ///< GSM 7位默认字母表
+    SMS_ALPHABET_8BIT,         ///< 8位数据
+    SMS_ALPHABET_UCS2          ///< UCS2
+};
+
+/**
+ * @struct SmsPdu
+ * @brief 解码后的SMS-DELIVER
+ */
+struct SmsPdu {
+    char sender[SMS_PDU_SENDER_MAX_LENGTH + 1];    ///< 发送方（国际号码带'+'，字母数字地址为UTF-8）
+    char timestamp[13];                             ///< SCTS时间戳（YYMMDDhhmmss）
+    int8_t timezoneQuarters;                        ///< SCTS时区（以15分钟为单位）
+    uint8_t pid;                                    ///< 协议标识
+    uint8_t dcs;                                    ///< 数据编码方案
+    SmsAlphabet alphabet;                           ///< 用户数据编码
+    uint16_t concatRef;                             ///< 长短信参考号（非长短信为0）
+    uint8_t concatPart;                             ///< 长短信分片序号（从1开始，非长短信为0）
+    uint8_t concatTotal;                            ///< 长短信总分片数（非长短信为0）
+    const char* text;                               ///< 正文（UTF-8，以'\0'结尾，指向调用方缓冲区）
+    size_t textLength;                              ///< 正文字节数
+    bool textTruncated;                             ///< 缓冲区不足导致正文被截断
+};
+
+/**
+ * @struct PduBenchmarkResult
+ * @brief 解码耗时测量结果
+ */
+struct PduBenchmarkResult {
+    int iterations;                 ///< 每种方式的解码次数
+    unsigned long pdulibAvgUs;      ///< pdulib的平均耗时（微秒，含复制为String）
+    unsigned long inPlaceAvgUs;     ///< 原地解码的平均耗时（微秒）
+};
+
+/**
+ * @brief 解码SMS-DELIVER十六进制PDU（含SMSC前缀，即AT+CMGR/+CMT/+CMGL输出的格式）
+ * @param hex PDU十六进制字符串
+ * @param length 字符串长度
+ * @param pdu 输出：解码结果
+ * @param textBuffer 正文输出缓冲区
+ * @param capacity 缓冲区容量（含结尾'\0'，SMS_PDU_TEXT_BUFFER_SIZE可容纳任意单条短信）
+ * @return true 解码成功
+ * @return false PDU格式错误、不是SMS-DELIVER或使用了压缩编码
+ */
+bool decodeSmsPdu(const char* hex, size_t length, SmsPdu& pdu, char* textBuffer, size_t capacity);
+
+/**
+ * @brief 测量同一PDU分别由pdulib与原地解码器解码的耗时
+ * @param hex PDU十六进制字符串
+ * @param iterations 每种方式的解码次数
+ * @return PduBenchmarkResult 测量结果（PDU无法解码时iterations为0）
+ */
+PduBenchmarkResult benchmarkPduDecode(const char* hex, int iterations);
+
+#endif // PDU_DECODER_H
@@ -0,0 +1,475 @@
+/**
+ * @file pdu_encoder.cpp
+ * @brief 短信PDU编码器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "pdu_encoder.h"
+#include <string.h>
+
+namespace {
+
+/// 查表结果：无法以GSM 7位编码
+const uint8_t GSM7_NONE = 0xFF;
+
+/// 查表结果标志：扩展表字符（低7位为转义符之后的septet）
+const uint8_t GSM7_EXTENSION = 0x80;
+
+/// 扩展表转义符
+const uint8_t GSM7_ESCAPE = 0x1B;
+
+/// U+0000至U+00FF对应的GSM 7位编码（3GPP TS 23.038，由默认字母表与扩展表反查得到）
+const uint8_t GSM7_FROM_LATIN1[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x0A, 0xFF, 0x8A, 0x0D, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x20, 0x21, 0x22, 0x23, 0x02, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x00, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0xBC, 0xAF, 0xBE, 0x94, 0x11,
+    0xFF, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0xA8, 0xC0, 0xA9, 0xBD, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x40, 0xFF, 0x01, 0x24, 0x03, 0xFF, 0x5F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x60,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x5B, 0x0E, 0x1C, 0x09, 0xFF, 0x1F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x5D, 0xFF, 0xFF, 0xFF, 0xFF, 0x5C, 0xFF, 0x0B, 0xFF, 0xFF, 0xFF, 0x5E, 0xFF, 0xFF, 0x1E,
+    0x7F, 0xFF, 0xFF, 0xFF, 0x7B, 0x0F, 0x1D, 0xFF, 0x04, 0x05, 0xFF, 0xFF, 0x07, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x7D, 0x08, 0xFF, 0xFF, 0xFF, 0x7C, 0xFF, 0x0C, 0x06, 0xFF, 0xFF, 0x7E, 0xFF, 0xFF, 0xFF
+};
+
+/// 默认字母表中希腊字母的起始码点
+const uint32_t GSM7_GREEK_FIRST = 0x0393;
+
+/// U+0393至U+03A9对应的GSM 7位编码
+const uint8_t GSM7_FROM_GREEK[23] = {
+    0x13, 0x10, 0xFF, 0xFF, 0xFF, 0x19, 0xFF, 0xFF, 0x14, 0xFF, 0xFF, 0x1A,
+    0xFF, 0x16, 0xFF, 0xFF, 0x18, 0xFF, 0xFF, 0x12, 0xFF, 0x17, 0x15
+};
+
+/// 欧元符号（唯一不在上面两张表范围内的扩展表字符）
+const uint32_t GSM7_EURO = 0x20AC;
+
+/// UTF-8首字节高4位对应的字符字节数（孤立的续字节按单字节处理）
+const uint8_t UTF8_LENGTH[16] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4};
+
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+/// 长短信用户数据头（05 00 03 参考号 总数 序号）的八位组数
+const size_t CONCAT_UDH_OCTETS = 6;
+
+/// 用户数据的最大八位组数
+const size_t USER_DATA_MAX_OCTETS = 140;
+
+/// 号码的最大位数
+const size_t ADDRESS_MAX_DIGITS = 20;
+
+/**
+ * @brief 查询字符的GSM 7位编码
+ * @param codepoint Unicode码点
+ * @return uint8_t septet值，扩展表字符带GSM7_EXTENSION标志，无法编码时为GSM7_NONE
+ */
+inline uint8_t gsm7Code(uint32_t codepoint) {
+    if (codepoint < 0x100) {
+        return GSM7_FROM_LATIN1[codepoint];
+    }
+    if (codepoint >= GSM7_GREEK_FIRST && codepoint < GSM7_GREEK_FIRST + sizeof(GSM7_FROM_GREEK)) {
+        return GSM7_FROM_GREEK[codepoint - GSM7_GREEK_FIRST];
+    }
+    return codepoint == GSM7_EURO ? (GSM7_EXTENSION | 0x65) : GSM7_NONE;
+}
+
+/**
+ * @brief 读取一个UTF-8字符
+ * @param bytes 字符起始位置
+ * @param remaining 剩余字节数（大于0）
+ * @param codepoint 输出：Unicode码点
+ * @return size_t 字符占用的字节数
+ */
+inline size_t nextCodepoint(const uint8_t* bytes, size_t remaining, uint32_t& codepoint) {
+    uint8_t lead = bytes[0];
+    size_t size = UTF8_LENGTH[lead >> 4];
+    if (size > remaining) {
+        size = remaining;
+    }
+    codepoint = size == 1 ? lead : lead & (0xFF >> (size + 1));
+    for (size_t k = 1; k < size; k++) {
+        codepoint = (codepoint << 6) | (bytes[k] & 0x3F);
+    }
+    return size;
+}
+
+/**
+ * @class HexWriter
+ * @brief 按八位组写入十六进制字符串
+ */
+class HexWriter {
+public:
+    HexWriter(char* output, size_t capacity) : output(output), capacity(capacity), position(0), overflow(false) {}
+
+    /**
+     * @brief 写入一个八位组（缓冲区不足时只记录溢出）
+     * @param value 八位组
+     */
+    void octet(uint8_t value) {
+        if (position + 2 > capacity) {
+            overflow = true;
+            return;
+        }
+        output[position] = HEX_DIGITS[value >> 4];
+        output[position + 1] = HEX_DIGITS[value & 0x0F];
+        position += 2;
+    }
+
+    /**
+     * @brief 改写已写入的八位组
+     * @param at 十六进制字符位置
+     * @param value 八位组
+     */
+    void patch(size_t at, uint8_t value) {
+        output[at] = HEX_DIGITS[value >> 4];
+        output[at + 1] = HEX_DIGITS[value & 0x0F];
+    }
+
+    /**
+     * @brief 追加Ctrl+Z与结尾'\0'
+     * @return true 成功
+     * @return false 缓冲区不足
+     */
+    bool terminate() {
+        if (overflow || position + 2 > capacity) {
+            return false;
+        }
+        output[position] = 0x1A;
+        output[position + 1] = '\0';
+        return true;
+    }
+
+    size_t tell() const { return position; }
+    bool overflowed() const { return overflow; }
+
+private:
+    char* output;
+    size_t capacity;
+    size_t position;
+    bool overflow;
+};
+
+/**
+ * @class SeptetPacker
+ * @brief GSM 7位打包：每8个septet组成一个56位字，一次写出7个八位组
+ */
+class SeptetPacker {
+public:
+    explicit SeptetPacker(HexWriter& writer) : writer(writer), word(0), bits(0), count(0) {}
+
+    /**
+     * @brief 写入用户数据头，并补齐填充位使正文从septet边界开始
+     * @param octets 用户数据头
+     * @param length 八位组数（小于7）
+     */
+    void header(const uint8_t* octets, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            word |= (uint64_t)octets[i] << (8 * i);
+        }
+        count = (length * 8 + 6) / 7;
+        bits = count * 7;
+    }
+
+    /**
+     * @brief 追加一个septet
+     * @param septet septet值
+     */
+    void push(uint8_t septet) {
+        word |= (uint64_t)septet << bits;
+        bits += 7;
+        count++;
+        if (bits == 56) {
+            flush(7);
+        }
+    }
+
+    /**
+     * @brief 写出剩余的位
+     * @return size_t septet总数（含用户数据头占用的septet），即TP-UDL
+     */
+    size_t finish() {
+        if (bits > 0) {
+            flush((bits + 7) / 8);
+        }
+        return count;
+    }
+
+    size_t septets() const { return count; }
+
+private:
+    void flush(size_t octets) {
+        for (size_t i = 0; i < octets; i++) {
+            writer.octet((uint8_t)(word >> (8 * i)));
+        }
+        word = 0;
+        bits = 0;
+    }
+
+    HexWriter& writer;
+    uint64_t word;
+    size_t bits;
+    size_t count;
+};
+
+/**
+ * @brief 写入号码（长度、号码类型与半八位组交换的BCD）
+ * @param writer 输出
+ * @param number 号码（国际格式带'+'）
+ * @param smsc true为短信中心地址（长度按八位组计），false为TP-DA（长度按位数计）
+ * @return true 成功
+ * @return false 号码为空、过长或含非数字字符
+ */
+bool writeAddress(HexWriter& writer, const char* number, bool smsc) {
+    bool international = number[0] == '+';
+    const char* digits = number + (international ? 1 : 0);
+    size_t count = strlen(digits);
+    if (count == 0 || count > ADDRESS_MAX_DIGITS) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (digits[i] < '0' || digits[i] > '9') {
+            return false;
+        }
+    }
+
+    writer.octet(smsc ? (uint8_t)(1 + (count + 1) / 2) : (uint8_t)count);
+    writer.octet(international ? 0x91 : 0x81);
+    for (size_t i = 0; i < count; i += 2) {
+        uint8_t low = digits[i] - '0';
+        uint8_t high = i + 1 < count ? digits[i + 1] - '0' : 0x0F;
+        writer.octet((uint8_t)((high << 4) | low));
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief 获取字符以GSM 7位默认字母表编码所需的septet数
+ * @param codepoint Unicode码点
+ * @return uint8_t septet数，0表示无法编码
+ */
+uint8_t gsm7SeptetLength(uint32_t codepoint) {
+    uint8_t code = gsm7Code(codepoint);
+    if (code == GSM7_NONE) {
+        return 0;
+    }
+    return (code & GSM7_EXTENSION) ? 2 : 1;
+}
+
+/**
+ * @brief 规划短信分段
+ * @param text UTF-8正文
+ * @param length 正文字节数
+ * @param plan 输出：分段方案
+ * @return true 规划成功
+ * @return false 正文为空或分段过多
+ */
+bool planSmsSegments(const char* text, size_t length, SmsSegmentPlan& plan) {
+    plan.count = 0;
+    if (text == nullptr || length == 0 || length > UINT16_MAX) {
+        return false;
+    }
+    const uint8_t* bytes = (const uint8_t*)text;
+
+    // 整条能放入一条短信时不分段，优先GSM 7位
+    bool gsm7 = true;
+    size_t totalSeptets = 0;
+    size_t totalUnits = 0;
+    for (size_t i = 0; i < length;) {
+        uint32_t codepoint;
+        i += nextCodepoint(bytes + i, length - i, codepoint);
+        uint8_t septets = gsm7SeptetLength(codepoint);
+        gsm7 = gsm7 && septets > 0;
+        totalSeptets += septets;
+        totalUnits += codepoint > 0xFFFF ? 2 : 1;
+    }
+    if ((gsm7 && totalSeptets <= SMS_TEXT_MAX_LENGTH) || totalUnits <= SMS_UNICODE_MAX_LENGTH) {
+        SmsSegment& part = plan.parts[0];
+        part.offset = 0;
+        part.length = (uint16_t)length;
+        part.alphabet = (gsm7 && totalSeptets <= SMS_TEXT_MAX_LENGTH) ? SMS_ALPHABET_GSM7 : SMS_ALPHABET_UCS2;
+        part.units = (uint16_t)(part.alphabet == SMS_ALPHABET_GSM7 ? totalSeptets : totalUnits);
+        plan.count = 1;
+        return true;
+    }
+
+    // 从每个分段起点同时推进两种编码，取覆盖更远的一种；两种编码能覆盖到的位置都随起点单调不减，
+    // 因此每段取最远即可得到最少的分段数
+    size_t start = 0;
+    while (start < length) {
+        if (plan.count >= SMS_SEND_MAX_PARTS) {
+            plan.count = 0;
+            return false;
+        }
+
+        size_t gsm7End = start;
+        size_t gsm7Units = 0;
+        bool gsm7Open = true;
+        size_t ucs2End = start;
+        size_t ucs2Units = 0;
+        bool ucs2Open = true;
+        for (size_t i = start; i < length && (gsm7Open || ucs2Open);) {
+            uint32_t codepoint;
+            size_t size = nextCodepoint(bytes + i, length - i, codepoint);
+            if (gsm7Open) {
+                size_t cost = gsm7SeptetLength(codepoint);
+                if (cost == 0 || gsm7Units + cost > SMS_TEXT_PART_LENGTH) {
+                    gsm7Open = false;
+                } else {
+                    gsm7Units += cost;
+                    gsm7End = i + size;
+                }
+            }
+            if (ucs2Open) {
+                size_t cost = codepoint > 0xFFFF ? 2 : 1;
+                if (ucs2Units + cost > SMS_UNICODE_PART_LENGTH) {
+                    ucs2Open = false;
+                } else {
+                    ucs2Units += cost;
+                    ucs2End = i + size;
+                }
+            }
+            i += size;
+        }
+
+        SmsSegment& part = plan.parts[plan.count++];
+        part.offset = (uint16_t)start;
+        if (gsm7End >= ucs2End) {
+            part.alphabet = SMS_ALPHABET_GSM7;
+            part.length = (uint16_t)(gsm7End - start);
+            part.units = (uint16_t)gsm7Units;
+        } else {
+            part.alphabet = SMS_ALPHABET_UCS2;
+            part.length = (uint16_t)(ucs2End - start);
+            part.units = (uint16_t)ucs2Units;
+        }
+        start += part.length;
+    }
+    return true;
+}
+
+/**
+ * @brief 编码一个SMS-SUBMIT十六进制PDU
+ * @param sca 短信中心号码
+ * @param recipient 接收方号码
+ * @param text UTF-8正文
+ * @param length 正文字节数
+ * @param alphabet 编码
+ * @param refNumber 长短信参考号
+ * @param totalParts 总分段数
+ * @param partNumber 分段序号
+ * @param output 十六进制输出缓冲区
+ * @param capacity 缓冲区容量
+ * @return int TPDU长度，失败时为PduEncodeError
+ */
+int encodeSmsSubmit(const char* sca, const char* recipient, const char* text, size_t length,
+                    SmsAlphabet alphabet, uint8_t refNumber, uint8_t totalParts, uint8_t partNumber,
+                    char* output, size_t capacity) {
+    bool multipart = totalParts > 0;
+    if (multipart && (partNumber == 0 || partNumber > totalParts)) {
+        return PDU_ENCODE_MULTIPART;
+    }
+    if (alphabet != SMS_ALPHABET_GSM7 && alphabet != SMS_ALPHABET_UCS2) {
+        return PDU_ENCODE_UNENCODABLE;
+    }
+    if (recipient == nullptr || (text == nullptr && length > 0)) {
+        return PDU_ENCODE_ADDRESS_FORMAT;
+    }
+    if (output == nullptr) {
+        return PDU_ENCODE_BUFFER_TOO_SMALL;
+    }
+
+    HexWriter writer(output, capacity);
+    if (sca == nullptr || sca[0] == '\0') {
+        writer.octet(0x00);
+    } else if (!writeAddress(writer, sca, true)) {
+        return PDU_ENCODE_ADDRESS_FORMAT;
+    }
+
+    size_t tpduStart = writer.tell();
+    writer.octet(multipart ? 0x41 : 0x01);     // SMS-SUBMIT，分段时置TP-UDHI
+    writer.octet(0x00);                         // TP-MR由模块分配
+    if (!writeAddress(writer, recipient, false)) {
+        return PDU_ENCODE_ADDRESS_FORMAT;
+    }
+    writer.octet(0x00);                         // TP-PID
+    writer.octet(alphabet == SMS_ALPHABET_UCS2 ? 0x08 : 0x00);
+    size_t udlAt = writer.tell();
+    writer.octet(0x00);                         // TP-UDL，写完用户数据后回填
+
+    const uint8_t header[CONCAT_UDH_OCTETS] = {0x05, 0x00, 0x03, refNumber, totalParts, partNumber};
+    const uint8_t* bytes = (const uint8_t*)text;
+    size_t userDataLength;
+
+    if (alphabet == SMS_ALPHABET_GSM7) {
+        SeptetPacker packer(writer);
+        if (multipart) {
+            packer.header(header, sizeof(header));
+        }
+        for (size_t i = 0; i < length;) {
+            uint32_t codepoint;
+            i += nextCodepoint(bytes + i, length - i, codepoint);
+            uint8_t code = gsm7Code(codepoint);
+            if (code == GSM7_NONE) {
+                return PDU_ENCODE_UNENCODABLE;
+            }
+            if (code & GSM7_EXTENSION) {
+                packer.push(GSM7_ESCAPE);
+                code &= ~GSM7_EXTENSION;
+            }
+            packer.push(code);
+            if (packer.septets() > SMS_TEXT_MAX_LENGTH) {
+                return PDU_ENCODE_TOO_LONG;
+            }
+        }
+        userDataLength = packer.finish();
+    } else {
+        userDataLength = 0;
+        if (multipart) {
+            for (uint8_t octet : header) {
+                writer.octet(octet);
+            }
+            userDataLength = sizeof(header);
+        }
+        for (size_t i = 0; i < length;) {
+            uint32_t codepoint;
+            i += nextCodepoint(bytes + i, length - i, codepoint);
+            if (codepoint > 0xFFFF) {
+                // 基本多文种平面以外的字符写为代理对
+                codepoint -= 0x10000;
+                uint16_t high = (uint16_t)(0xD800 | ((codepoint >> 10) & 0x3FF));
+                uint16_t low = (uint16_t)(0xDC00 | (codepoint & 0x3FF));
+                writer.octet((uint8_t)(high >> 8));
+                writer.octet((uint8_t)high);
+                writer.octet((uint8_t)(low >> 8));
+                writer.octet((uint8_t)low);
+                userDataLength += 4;
+            } else {
+                writer.octet((uint8_t)(codepoint >> 8));
+                writer.octet((uint8_t)codepoint);
+                userDataLength += 2;
+            }
+            if (userDataLength > USER_DATA_MAX_OCTETS) {
+                return PDU_ENCODE_TOO_LONG;
+            }
+        }
+    }
+
+    if (writer.overflowed()) {
+        return PDU_ENCODE_BUFFER_TOO_SMALL;
+    }
+    writer.patch(udlAt, (uint8_t)userDataLength);
+    int tpduLength = (int)((writer.tell() - tpduStart) / 2);
+    if (!writer.terminate()) {
+        return PDU_ENCODE_BUFFER_TOO_SMALL;
+    }
+    return tpduLength;
+}
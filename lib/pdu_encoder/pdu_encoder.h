@@ -0,0 +1,93 @@
+/**
+ * @file pdu_encoder.h
+ * @brief 短信PDU编码器 - 将UTF-8正文直接编码为SMS-SUBMIT十六进制PDU，不分配堆内存
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以查表方式判断字符能否以GSM 7位默认字母表（含扩展表）编码，不再逐项比对字母表
+ * 2. 规划长短信分段：每个分段独立选择GSM 7位或UCS2，在总分段数最少的前提下
+ *    尽量使用GSM 7位；分段不会切开字符、扩展表转义或代理对
+ * 3. 按分段编码SMS-SUBMIT：septet每8个组成一个56位字再一次写出7个八位组，
+ *    UCS2直接由UTF-8转换，均直接写入调用方提供的十六进制缓冲区
+ */
+
+#ifndef PDU_ENCODER_H
+#define PDU_ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../pdu_decoder/pdu_decoder.h"
+#include "../../include/constants.h"
+
+/**
+ * @enum PduEncodeError
+ * @brief 编码失败原因（encodeSmsSubmit()返回的负数）
+ */
+enum PduEncodeError {
+    PDU_ENCODE_TOO_LONG = -1,          ///< 正文超过单个分段的容量
+    PDU_ENCODE_ADDRESS_FORMAT = -2,    ///< 接收方或短信中心号码格式错误
+    PDU_ENCODE_BUFFER_TOO_SMALL = -3,  ///< 输出缓冲区不足
+    PDU_ENCODE_UNENCODABLE = -4,       ///< 正文含无法以GSM 7位编码的字符
+    PDU_ENCODE_MULTIPART = -5          ///< 分段序号或总分段数错误
+};
+
+/**
+ * @struct SmsSegment
+ * @brief 一个分段在正文中的位置与编码
+ */
+struct SmsSegment {
+    uint16_t offset;            ///< 在UTF-8正文中的起始字节
+    uint16_t length;            ///< 字节数
+    uint16_t units;             ///< septet数（GSM 7位）或UTF-16单元数（UCS2）
+    SmsAlphabet alphabet;       ///< 编码（SMS_ALPHABET_GSM7或SMS_ALPHABET_UCS2）
+};
+
+/**
+ * @struct SmsSegmentPlan
+ * @brief 一条短信的分段方案
+ */
+struct SmsSegmentPlan {
+    SmsSegment parts[SMS_SEND_MAX_PARTS];   ///< 各分段
+    uint8_t count;                          ///< 分段数（1表示不需要用户数据头）
+};
+
+/**
+ * @brief 获取字符以GSM 7位默认字母表编码所需的septet数
+ * @param codepoint Unicode码点
+ * @return uint8_t 1（基本表）、2（扩展表）或0（无法以GSM 7位编码，需使用UCS2）
+ */
+uint8_t gsm7SeptetLength(uint32_t codepoint);
+
+/**
+ * @brief 规划短信分段
+ *
+ * 整条能放入一条短信时不分段（GSM 7位160个septet或UCS2 70个单元）；否则按带用户数据头的
+ * 分段容量，从每个分段起点分别计算两种编码能覆盖到的位置并取更远者
+ * @param text UTF-8正文
+ * @param length 正文字节数
+ * @param plan 输出：分段方案
+ * @return true 规划成功
+ * @return false 正文为空或超过SMS_SEND_MAX_PARTS个分段
+ */
+bool planSmsSegments(const char* text, size_t length, SmsSegmentPlan& plan);
+
+/**
+ * @brief 编码一个SMS-SUBMIT十六进制PDU（含短信中心前缀，以Ctrl+Z结尾，供AT+CMGS直接发送）
+ * @param sca 短信中心号码（为空时使用模块设置的短信中心）
+ * @param recipient 接收方号码（国际格式带'+'）
+ * @param text UTF-8正文
+ * @param length 正文字节数
+ * @param alphabet 编码（由planSmsSegments()给出）
+ * @param refNumber 长短信参考号（单条短信时忽略）
+ * @param totalParts 总分段数（单条短信为0）
+ * @param partNumber 分段序号（从1开始，单条短信为0）
+ * @param output 十六进制输出缓冲区
+ * @param capacity 缓冲区容量（SMS_SEND_PDU_BUFFER_SIZE可容纳任意分段）
+ * @return int TPDU长度（不含短信中心部分的八位组数，即AT+CMGS的参数），失败时为PduEncodeError
+ */
+int encodeSmsSubmit(const char* sca, const char* recipient, const char* text, size_t length,
+                    SmsAlphabet alphabet, uint8_t refNumber, uint8_t totalParts, uint8_t partNumber,
+                    char* output, size_t capacity);
+
+#endif // PDU_ENCODER_H
@@ -1,128 +1,113 @@
 /**
  * @file phone_caller.cpp
- * @brief 电话拨打模块实现 - 提供拨打电话、等待和挂断功能
+ * @brief 电话拨打模块实现 - 提供拨打电话、保持通话和挂断功能
  * @author ESP-SMS-Relay Project
- * @version 1.0.0
+ * @version 1.1.0
  * @date 2024
  * 
  * 该模块实现了完整的电话拨打功能，包括：
  * - 拨打电话
- * - 等待指定时间
- * - 挂断电话
+ * - 由通话上报驱动的状态机
+ * - 到时挂断
  * - 错误处理
  */
 
 #include "phone_caller.h"
+#include "../at_command_handler/at_command_handler.h"
+#include "../modem_arbiter/modem_arbiter.h"
+#include "../task_scheduler/task_scheduler.h"
+#include "../log_manager/log_manager.h"
 #include "../../include/constants.h"
-#include <HardwareSerial.h>
 
-// 外部串口对象声明
-extern HardwareSerial simSerial;
+/// 通话结束时的结果码，同时也是其他命令的最终结果码，只在通话期间作为上报截取
+static const char* const CALL_RESULT_PREFIXES[] = {"NO CARRIER", "BUSY", "NO ANSWER"};
 
 /**
- * @brief 构造函数
+ * @brief 获取单例实例
+ * @return PhoneCaller& 单例引用
  */
-PhoneCaller::PhoneCaller() {
-    last_error_ = "";
+PhoneCaller& PhoneCaller::getInstance() {
+    static PhoneCaller instance;
+    return instance;
 }
 
 /**
- * @brief 析构函数
+ * @brief 构造函数
  */
-PhoneCaller::~PhoneCaller() {
-    // 清理资源
+PhoneCaller::PhoneCaller()
+    : state_(CALL_STATE_IDLE), dialed_at_(0), hold_ms_(0), urc_queue_(nullptr),
+      poll_task_id_(-1), clcc_enabled_(false) {
+    last_error_ = "";
 }
 
 /**
- * @brief 拨打电话
+ * @brief 发起通话，保持指定时间后挂断
  * @param phone_number 电话号码（支持国际格式，如+8610086）
- * @return PhoneCallResult 拨打结果
+ * @param hold_seconds 从拨号起保持的时间（秒）
+ * @param callback 通话结束回调
+ * @return PhoneCallResult CALL_SUCCESS表示模块已受理拨号
  */
-PhoneCallResult PhoneCaller::makeCall(const String& phone_number) {
+PhoneCallResult PhoneCaller::startCall(const String& phone_number, int hold_seconds,
+                                       PhoneCallCallback callback) {
     // 验证电话号码格式
     if (!validatePhoneNumber(phone_number)) {
+        std::lock_guard<std::mutex> lock(mutex_);
         last_error_ = "Invalid phone number format";
         return CALL_ERROR_INVALID_NUMBER;
     }
     
-    // 检查网络状态
-    if (!isNetworkReady()) {
-        last_error_ = "Network not ready";
-        return CALL_ERROR_NETWORK_NOT_READY;
-    }
-    
-    // 构造拨打电话的AT命令
-    String call_command = "ATD" + phone_number + ";";
-    
-    // 拨打电话
-    
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
+    // 先占用通话槽位，拨号期间其他调用方直接返回
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != CALL_STATE_IDLE) {
+            last_error_ = "Call in progress";
+            return CALL_ERROR_IN_PROGRESS;
+        }
+        state_ = CALL_STATE_DIALING;
     }
     
-    // 发送拨打命令
-    simSerial.println(call_command);
-    
-    // 等待拨打响应
-    unsigned long start_time = millis();
-    String response = "";
-    bool call_initiated = false;
-    
-    while (millis() - start_time < 15000) { // 15秒超时
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-            // 读取响应
-            
-            // 检查拨打成功的响应
-            if (response.indexOf("OK") != -1) {
-                call_initiated = true;
-                break;
-            }
-            
-            // 检查错误响应
-            if (response.indexOf("ERROR") != -1 || 
-                response.indexOf("BUSY") != -1 ||
-                response.indexOf("NO ANSWER") != -1 ||
-                response.indexOf("NO CARRIER") != -1) {
-                last_error_ = "Call failed: " + response;
-                return CALL_ERROR_AT_COMMAND_FAILED;
-            }
+    PhoneCallResult result = CALL_SUCCESS;
+    String error;
+    if (!ensureInitialized()) {
+        result = CALL_ERROR_AT_COMMAND_FAILED;
+        error = "Call status reporting unavailable";
+    } else if (!isNetworkReady()) {
+        result = CALL_ERROR_NETWORK_NOT_READY;
+        error = "Network not ready";
+    } else {
+        // 丢弃空闲期间积压的上报（如来电），之后的上报都属于本次通话
+        xQueueReset(urc_queue_);
+        
+        // ATD只等待模块受理；接通、忙线、无应答均以上报形式到达
+        AtResponse response = AtCommandHandler::getInstance().sendCommand(
+            "ATD" + phone_number + ";", "OK", PHONE_CALL_DIAL_TIMEOUT_MS);
+        if (response.result == AT_RESULT_TIMEOUT) {
+            // 呼叫可能已经发出，挂断以免留下无人管理的通话
+            hangupCall();
+            result = CALL_ERROR_CALL_TIMEOUT;
+            error = "Call timeout";
+        } else if (response.result != AT_RESULT_SUCCESS) {
+            result = CALL_ERROR_AT_COMMAND_FAILED;
+            error = "Call failed: " + response.response;
         }
-        delay(10);
     }
     
-    if (call_initiated) {
-        return CALL_SUCCESS;
-    } else {
-        last_error_ = "Call timeout";
-        return CALL_ERROR_AT_COMMAND_FAILED;
+    if (result == CALL_SUCCESS) {
+        // 模块已受理拨号，之后的NO CARRIER/BUSY/NO ANSWER属于本次通话
+        setCallResultReporting(true);
     }
-}
-
-/**
- * @brief 拨打电话并等待指定时间后挂断
- * @param phone_number 电话号码
- * @param wait_seconds 等待时间（秒）
- * @return PhoneCallResult 拨打结果
- */
-PhoneCallResult PhoneCaller::makeCallAndWait(const String& phone_number, int wait_seconds) {
-    // 拨打电话
-    PhoneCallResult result = makeCall(phone_number);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
     if (result != CALL_SUCCESS) {
+        state_ = CALL_STATE_IDLE;
+        last_error_ = error;
         return result;
     }
     
-    // 等待指定时间
-    for (int i = wait_seconds; i > 0; i--) {
-        delay(1000);
-    }
-    
-    // 挂断电话
-    if (!hangupCall()) {
-        return CALL_ERROR_HANGUP_FAILED;
-    }
+    dialed_at_ = millis();
+    hold_ms_ = hold_seconds > 0 ? (unsigned long)hold_seconds * 1000UL : 0;
+    callback_ = callback;
+    TaskScheduler::getInstance().setTaskEnabled(poll_task_id_, true);
     return CALL_SUCCESS;
 }
 
@@ -132,86 +117,198 @@ PhoneCallResult PhoneCaller::makeCallAndWait(const String& phone_number, int wai
  * @return false 挂断失败
  */
 bool PhoneCaller::hangupCall() {
-    // 挂断电话
-    
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
+    // 挂断后的VOICE CALL: END、NO CARRIER在通话期间订阅为上报，响应只剩最终结果码
+    AtResponse response = AtCommandHandler::getInstance().sendCommand(
+        "AT+CHUP", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    if (response.result == AT_RESULT_SUCCESS) {
+        return true;
     }
     
-    // 发送AT+CHUP挂断命令
-    simSerial.println("AT+CHUP");
-    
-    // 等待响应
-    unsigned long start_time = millis();
-    String response = "";
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_error_ = response.result == AT_RESULT_TIMEOUT ? "挂断超时" : "挂断失败";
+    return false;
+}
+
+/**
+ * @brief 获取当前通话状态
+ * @return PhoneCallState 通话状态
+ */
+PhoneCallState PhoneCaller::getState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+/**
+ * @brief 首次拨号时订阅通话上报并注册处理任务
+ * @return true 已就绪
+ * @return false 仲裁器未运行或资源创建失败
+ */
+bool PhoneCaller::ensureInitialized() {
+    AtCommandHandler& atHandler = AtCommandHandler::getInstance();
+    if (urc_queue_ == nullptr) {
+        ModemArbiter& arbiter = atHandler.getArbiter();
+        if (!arbiter.isRunning()) {
+            return false;
+        }
+        
+        QueueHandle_t queue = ModemArbiter::createLineQueue(PHONE_CALL_URC_QUEUE_LENGTH);
+        if (queue == nullptr) {
+            return false;
+        }
+        
+        // 订阅后"+CLCC:"开头的行全部投递到本队列，AT+CLCC查询的结果同样会被截走，
+        // 因此通话状态只依赖AT+CLCC=1的主动上报
+        static const char* const prefixes[] = {"+CLCC:", "VOICE CALL:"};
+        for (const char* prefix : prefixes) {
+            if (!arbiter.subscribe(prefix, queue)) {
+                LOG_DEBUG(LOG_MODULE_PHONE, "订阅通话上报失败: " + String(prefix));
+            }
+        }
+        // NO CARRIER/BUSY/NO ANSWER先停用订阅：空闲时它们是其他命令（如数据连接）的最终结果码，
+        // 被截走会让那些命令等到超时；通话期间才作为上报处理，对方挂断时进行中的其他事务不会被判为失败
+        for (const char* prefix : CALL_RESULT_PREFIXES) {
+            if (!arbiter.subscribe(prefix, queue, false, false)) {
+                LOG_DEBUG(LOG_MODULE_PHONE, "订阅通话上报失败: " + String(prefix));
+            }
+        }
+        urc_queue_ = queue;
+        
+        AtResponse response = atHandler.sendCommand("AT+CLCC=1", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        clcc_enabled_ = response.result == AT_RESULT_SUCCESS;
+        if (!clcc_enabled_) {
+            LOG_DEBUG(LOG_MODULE_PHONE, "开启通话状态上报失败，保持时间到后按已接通处理: " + response.response);
+        }
+    }
     
-    while (millis() - start_time < DEFAULT_PHONE_CALL_TIMEOUT_MS) { // 电话呼叫超时
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
+    if (poll_task_id_ < 0) {
+        TaskScheduler& scheduler = TaskScheduler::getInstance();
+        int taskId = scheduler.addPeriodicTask("phone_call", PHONE_CALL_POLL_INTERVAL_MS,
+                                               [this]() { poll(); }, false, TASK_DISPATCH_WORKER);
+        if (taskId < 0) {
+            return false;
+        }
+        scheduler.setTaskEnabled(taskId, false);
+        poll_task_id_ = taskId;
+    }
+    return true;
+}
+
+/**
+ * @brief 处理积压的通话上报，到时挂断（由周期任务调用）
+ */
+void PhoneCaller::poll() {
+    PhoneCallResult result = CALL_SUCCESS;
+    String error;
+    bool finished = false;
+    bool holdExpired = false;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == CALL_STATE_IDLE) {
+            return;
+        }
+        
+        ModemLine line;
+        while (!finished && xQueueReceive(urc_queue_, &line, 0) == pdTRUE) {
+            LOG_DEBUG(LOG_MODULE_PHONE, "通话上报: " + String(line.data));
             
-            // 检查成功响应
-            if (response.indexOf("OK") != -1 ||
-                response.indexOf("NO CARRIER") != -1 ||
-                response.indexOf("VOICE CALL: END") != -1 ||
-                response.indexOf("ERROR") != -1) {
-                break;
+            bool connected = false;
+            bool ended = false;
+            classifyLine(line.data, connected, ended);
+            if (connected && state_ == CALL_STATE_DIALING) {
+                state_ = CALL_STATE_ACTIVE;
+            } else if (ended) {
+                // 接通后对方挂断同样算作成功；接通前结束说明忙线、无应答或被拒接
+                finished = true;
+                if (state_ != CALL_STATE_ACTIVE) {
+                    result = CALL_ERROR_NOT_CONNECTED;
+                    error = "Call not connected: " + String(line.data);
+                }
             }
         }
-        delay(10);
+        
+        holdExpired = !finished && millis() - dialed_at_ >= hold_ms_;
     }
     
-    // 检查响应
-    if (response.indexOf("OK") != -1 ||
-        response.indexOf("NO CARRIER") != -1 ||
-        response.indexOf("VOICE CALL: END") != -1) {
-        return true;
-    } else if (response.indexOf("ERROR") != -1) {
-        last_error_ = "挂断失败";
-        return false;
+    if (holdExpired) {
+        bool hungUp = hangupCall();
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished = true;
+        if (!hungUp) {
+            result = CALL_ERROR_HANGUP_FAILED;
+            error = last_error_;
+        } else if (state_ != CALL_STATE_ACTIVE && clcc_enabled_) {
+            result = CALL_ERROR_NOT_CONNECTED;
+            error = "Call not answered within hold time";
+        }
+    }
+    
+    if (finished) {
+        finishCall(result, error);
+    }
+}
+
+/**
+ * @brief 解析一行通话上报
+ * @param line 上报行
+ * @param connected 输出：是否表示已接通
+ * @param ended 输出：是否表示通话结束
+ */
+void PhoneCaller::classifyLine(const char* line, bool& connected, bool& ended) {
+    connected = false;
+    ended = false;
+    
+    if (strncmp(line, "+CLCC:", 6) == 0) {
+        // +CLCC: <id>,<dir>,<stat>,<mode>,<mpty>[,<number>,<type>]，只关心本机呼出(dir=0)的通话
+        int id = 0;
+        int dir = 0;
+        int stat = 0;
+        if (sscanf(line + 6, "%d,%d,%d", &id, &dir, &stat) == 3 && dir == 0) {
+            connected = stat == 0;
+            ended = stat == 6;
+        }
+    } else if (strncmp(line, "VOICE CALL:", 11) == 0) {
+        connected = strstr(line, "BEGIN") != nullptr;
+        ended = strstr(line, "END") != nullptr;
     } else {
-        last_error_ = "挂断超时";
-        return false;
+        // NO CARRIER、BUSY、NO ANSWER
+        ended = true;
     }
 }
 
 /**
- * @brief 检查通话状态
- * @return true 无通话进行中
- * @return false 有通话进行中
+ * @brief 结束当前通话并调用回调
+ * @param result 通话结果
+ * @param error 错误描述
  */
-bool PhoneCaller::checkCallStatus() {
-    // 检查通话状态
-    
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
+void PhoneCaller::finishCall(PhoneCallResult result, const String& error) {
+    PhoneCallCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_ = CALL_STATE_IDLE;
+        callback = callback_;
+        callback_ = nullptr;
+        if (result != CALL_SUCCESS) {
+            last_error_ = error;
+        }
     }
     
-    // 发送查询通话状态命令
-    simSerial.println("AT+CLCC");
-    
-    unsigned long start_time = millis();
-    String response = "";
-    
-    while (millis() - start_time < DEFAULT_AT_COMMAND_TIMEOUT_MS) {
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-            
-            if (response.indexOf("OK") != -1) {
-                // 如果响应中包含+CLCC:，说明有通话进行中
-                if (response.indexOf("+CLCC:") != -1) {
-                    return false;
-                } else {
-                    return true;
-                }
-            }
-        }
-        delay(10);
+    setCallResultReporting(false);
+    TaskScheduler::getInstance().setTaskEnabled(poll_task_id_, false);
+    if (callback) {
+        callback(result, error);
+    }
+}
+
+/**
+ * @brief 启用或停用NO CARRIER/BUSY/NO ANSWER的订阅
+ * @param enabled 是否启用
+ */
+void PhoneCaller::setCallResultReporting(bool enabled) {
+    ModemArbiter& arbiter = AtCommandHandler::getInstance().getArbiter();
+    for (const char* prefix : CALL_RESULT_PREFIXES) {
+        arbiter.setSubscriptionEnabled(prefix, urc_queue_, enabled);
     }
-    return true;
 }
 
 /**
@@ -220,31 +317,10 @@ bool PhoneCaller::checkCallStatus() {
  * @return false 网络未注册
  */
 bool PhoneCaller::isNetworkReady() {
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
-    }
-    
-    // 发送AT+CREG?命令
-    simSerial.println("AT+CREG?");
-    
-    unsigned long start_time = millis();
-    String response = "";
-    
-    // 等待响应
-    while (millis() - start_time < DEFAULT_AT_COMMAND_TIMEOUT_MS) {
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-        }
-        
-        // 检查是否收到完整响应
-        if (response.indexOf("OK") != -1 || response.indexOf("ERROR") != -1) {
-            break;
-        }
-        
-        vTaskDelay(1);
-    }
+    // 发送AT+CREG?命令，等待到最终结果码
+    AtResponse atResponse = AtCommandHandler::getInstance().sendCommandWithFullResponse(
+        "AT+CREG?", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    String response = atResponse.response;
     
     // 解析CREG响应
     int cregIndex = response.indexOf("+CREG:");
@@ -290,51 +366,11 @@ bool PhoneCaller::isNetworkReady() {
  * @brief 获取最后一次错误的详细信息
  * @return String 错误描述
  */
-String PhoneCaller::getLastError() const {
+String PhoneCaller::getLastError() {
+    std::lock_guard<std::mutex> lock(mutex_);
     return last_error_;
 }
 
-/**
- * @brief 发送AT命令并等待响应
- * @param command AT命令
- * @param expected_response 期望的响应
- * @param timeout 超时时间（毫秒）
- * @return true 命令执行成功
- * @return false 命令执行失败
- */
-bool PhoneCaller::sendAtCommand(const String& command, const String& expected_response, unsigned long timeout) {
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
-    }
-    
-    // 发送AT命令
-    simSerial.println(command);
-    
-    unsigned long start_time = millis();
-    String response = "";
-    
-    // 等待响应
-    while (millis() - start_time < timeout) {
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-            
-            // 检查是否收到期望的响应
-            if (response.indexOf(expected_response) != -1) {
-                return true;
-            }
-            
-            // 检查是否收到错误响应
-            if (response.indexOf("ERROR") != -1) {
-                return false;
-            }
-        }
-        delay(10);
-    }
-    return false;
-}
-
 /**
  * @brief 验证电话号码格式
  * @param phone_number 电话号码
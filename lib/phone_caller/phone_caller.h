@@ -1,21 +1,27 @@
 /**
  * @file phone_caller.h
- * @brief 电话拨打模块 - 提供拨打电话、等待和挂断功能
+ * @brief 电话拨打模块 - 提供拨打电话、保持通话和挂断功能
  * @author ESP-SMS-Relay Project
- * @version 1.0.0
+ * @version 1.1.0
  * @date 2024
- * 
+ *
  * 该模块提供了完整的电话拨打功能，包括：
- * - 拨打电话
- * - 等待指定时间
- * - 挂断电话
+ * - 拨打电话（ATD只等待模块受理，不等待接通）
+ * - 由仲裁器投递的+CLCC、VOICE CALL、NO CARRIER等上报驱动通话状态
+ * - 保持指定时间后挂断，结果通过回调通知
  * - 错误处理
+ *
+ * 通话期间不占用模块串口，短信接收与推送可以同时进行
  */
 
 #ifndef PHONE_CALLER_H
 #define PHONE_CALLER_H
 
 #include <Arduino.h>
+#include <functional>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 
 /**
  * @brief 电话拨打结果枚举
@@ -26,74 +32,127 @@ enum PhoneCallResult {
     CALL_ERROR_INVALID_NUMBER,      ///< 号码格式无效
     CALL_ERROR_AT_COMMAND_FAILED,   ///< AT命令执行失败
     CALL_ERROR_CALL_TIMEOUT,        ///< 拨打超时
-    CALL_ERROR_HANGUP_FAILED        ///< 挂断失败
+    CALL_ERROR_HANGUP_FAILED,       ///< 挂断失败
+    CALL_ERROR_NOT_CONNECTED,       ///< 对方未接通（忙线、无应答或接通前挂断）
+    CALL_ERROR_IN_PROGRESS          ///< 已有通话进行中
 };
 
+/**
+ * @brief 通话状态枚举
+ */
+enum PhoneCallState {
+    CALL_STATE_IDLE,                ///< 空闲
+    CALL_STATE_DIALING,             ///< 已拨号，等待接通
+    CALL_STATE_ACTIVE               ///< 通话中
+};
+
+/**
+ * @brief 通话结束回调（在调度工作线程中调用）
+ * @param result 通话结果
+ * @param error 错误描述（成功时为空）
+ */
+typedef std::function<void(PhoneCallResult result, const String& error)> PhoneCallCallback;
+
 /**
  * @brief 电话拨打器类
- * 
- * 该类封装了完整的电话拨打功能，提供简洁的API接口用于拨打电话。
+ *
+ * 同一时间只有一路通话。startCall()发出ATD并在模块受理后立即返回，
+ * 之后由调度工作线程上的"phone_call"周期任务处理上报、到时挂断并调用回调；
+ * 空闲时该任务处于禁用状态
  */
 class PhoneCaller {
 public:
     /**
-     * @brief 构造函数
-     */
-    PhoneCaller();
-    
-    /**
-     * @brief 析构函数
+     * @brief 获取单例实例
+     * @return PhoneCaller& 单例引用
      */
-    ~PhoneCaller();
-    
+    static PhoneCaller& getInstance();
+
     /**
-     * @brief 拨打电话
+     * @brief 发起通话，保持指定时间后挂断
      * @param phone_number 电话号码（支持国际格式，如+8610086）
-     * @return PhoneCallResult 拨打结果
-     */
-    PhoneCallResult makeCall(const String& phone_number);
-    
-    /**
-     * @brief 拨打电话并等待指定时间后挂断
-     * @param phone_number 电话号码
-     * @param wait_seconds 等待时间（秒）
-     * @return PhoneCallResult 拨打结果
+     * @param hold_seconds 从拨号起保持的时间（秒），到时仍未结束则挂断
+     * @param callback 通话结束回调（只在返回CALL_SUCCESS时调用）
+     * @return PhoneCallResult CALL_SUCCESS表示模块已受理拨号，其余为立即失败的原因
      */
-    PhoneCallResult makeCallAndWait(const String& phone_number, int wait_seconds);
-    
+    PhoneCallResult startCall(const String& phone_number, int hold_seconds,
+                              PhoneCallCallback callback = nullptr);
+
     /**
      * @brief 挂断电话
      * @return true 挂断成功
      * @return false 挂断失败
      */
     bool hangupCall();
-    
+
     /**
      * @brief 检查网络状态
      * @return true 网络已注册
      * @return false 网络未注册
      */
     bool isNetworkReady();
-    
+
+    /**
+     * @brief 获取当前通话状态
+     * @return PhoneCallState 通话状态
+     */
+    PhoneCallState getState();
+
     /**
      * @brief 获取最后一次错误的详细信息
      * @return String 错误描述
      */
-    String getLastError() const;
-    
+    String getLastError();
+
 private:
-    String last_error_;             ///< 最后一次错误信息
-    
     /**
-     * @brief 发送AT命令并等待响应
-     * @param command AT命令
-     * @param expected_response 期望的响应
-     * @param timeout 超时时间（毫秒）
-     * @return true 命令执行成功
-     * @return false 命令执行失败
+     * @brief 私有构造函数（单例模式）
      */
-    bool sendAtCommand(const String& command, const String& expected_response, unsigned long timeout);
-    
+    PhoneCaller();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    PhoneCaller(const PhoneCaller&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    PhoneCaller& operator=(const PhoneCaller&) = delete;
+
+    /**
+     * @brief 首次拨号时订阅通话上报并注册处理任务
+     * @return true 已就绪
+     * @return false 仲裁器未运行或资源创建失败
+     */
+    bool ensureInitialized();
+
+    /**
+     * @brief 处理积压的通话上报，到时挂断（由周期任务调用）
+     */
+    void poll();
+
+    /**
+     * @brief 解析一行通话上报
+     * @param line 上报行
+     * @param connected 输出：是否表示已接通
+     * @param ended 输出：是否表示通话结束
+     */
+    static void classifyLine(const char* line, bool& connected, bool& ended);
+
+    /**
+     * @brief 结束当前通话并调用回调
+     * @param result 通话结果
+     * @param error 错误描述
+     */
+    void finishCall(PhoneCallResult result, const String& error);
+
+    /**
+     * @brief 启用或停用NO CARRIER/BUSY/NO ANSWER的订阅（只在通话期间截取）
+     * @param enabled 是否启用
+     */
+    void setCallResultReporting(bool enabled);
+
     /**
      * @brief 验证电话号码格式
      * @param phone_number 电话号码
@@ -101,13 +160,16 @@ private:
      * @return false 格式错误
      */
     bool validatePhoneNumber(const String& phone_number);
-    
-    /**
-     * @brief 检查通话状态
-     * @return true 无通话进行中
-     * @return false 有通话进行中
-     */
-    bool checkCallStatus();
+
+    String last_error_;                 ///< 最后一次错误信息
+    std::mutex mutex_;                  ///< 保护通话状态与last_error_
+    PhoneCallState state_;              ///< 当前通话状态
+    unsigned long dialed_at_;           ///< 拨号时间（millis）
+    unsigned long hold_ms_;             ///< 保持时长（毫秒）
+    PhoneCallCallback callback_;        ///< 当前通话的结束回调
+    QueueHandle_t urc_queue_;           ///< 通话上报队列
+    int poll_task_id_;                  ///< 周期任务ID（-1表示未注册）
+    bool clcc_enabled_;                 ///< 模块是否接受AT+CLCC=1（否则无法得知是否接通）
 };
 
-#endif // PHONE_CALLER_H
\ No newline at end of file
+#endif // PHONE_CALLER_H
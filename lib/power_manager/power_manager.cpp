@@ -0,0 +1,178 @@
+/**
+ * @file power_manager.cpp
+ * @brief 电源管理实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "power_manager.h"
+#include "../../include/config.h"
+#include "../../include/constants.h"
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+/**
+ * @brief 获取单例实例
+ * @return PowerManager& 单例引用
+ */
+PowerManager& PowerManager::getInstance() {
+    static PowerManager instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+PowerManager::PowerManager()
+    : apbLock(nullptr), awakeLock(nullptr), holdTimer(nullptr), awakeHeld(false),
+      initialized(false), lightSleepEnabled(false) {
+}
+
+/**
+ * @brief 按配置启用电源管理
+ * @return true 已启用或按配置不启用
+ * @return false 启用失败
+ */
+bool PowerManager::initialize() {
+#if POWER_SAVE_ENABLED
+    if (initialized) {
+        return true;
+    }
+
+    // SIM串口以APB为时钟源，常驻该锁后只降低CPU频率，浅睡眠不受影响
+    esp_err_t err = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "sim_uart", &apbLock);
+    if (err == ESP_OK) {
+        err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "modem_io", &awakeLock);
+    }
+    if (err != ESP_OK) {
+        setError("电源管理锁创建失败（固件未启用CONFIG_PM_ENABLE？）: " + String(esp_err_to_name(err)));
+        return false;
+    }
+    esp_pm_lock_acquire(apbLock);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onHoldExpired;
+    timerArgs.arg = this;
+    timerArgs.name = "pm_hold";
+    err = esp_timer_create(&timerArgs, &holdTimer);
+    if (err != ESP_OK) {
+        setError("保持唤醒定时器创建失败: " + String(esp_err_to_name(err)));
+        return false;
+    }
+
+    configureWakeupSources();
+
+    esp_pm_config_esp32s3_t pmConfig = {};
+    pmConfig.max_freq_mhz = POWER_CPU_MAX_FREQ_MHZ;
+    pmConfig.min_freq_mhz = POWER_CPU_MIN_FREQ_MHZ;
+    pmConfig.light_sleep_enable = true;
+    err = esp_pm_configure(&pmConfig);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        // 固件未启用tickless idle时不支持自动浅睡眠，退回仅动态调频
+        pmConfig.light_sleep_enable = false;
+        err = esp_pm_configure(&pmConfig);
+    }
+    if (err != ESP_OK) {
+        setError("电源管理配置失败: " + String(esp_err_to_name(err)));
+        return false;
+    }
+
+    lightSleepEnabled = pmConfig.light_sleep_enable;
+    initialized = true;
+    return true;
+#else
+    return true;
+#endif
+}
+
+/**
+ * @brief 通知有串口活动，在POWER_WAKE_HOLD_MS内不进入浅睡眠
+ */
+void PowerManager::notifyActivity() {
+    if (!lightSleepEnabled) {
+        return;
+    }
+
+    // 每次由未持有变为持有时获取一次，定时器到期时对应释放一次
+    if (!awakeHeld.exchange(true)) {
+        esp_pm_lock_acquire(awakeLock);
+    }
+    esp_timer_stop(holdTimer);
+    esp_timer_start_once(holdTimer, (uint64_t)POWER_WAKE_HOLD_MS * 1000);
+}
+
+/**
+ * @brief 检查是否已启用自动浅睡眠
+ * @return true 已启用
+ * @return false 未启用
+ */
+bool PowerManager::isLightSleepEnabled() const {
+    return lightSleepEnabled;
+}
+
+/**
+ * @brief 获取loop()无到期任务时的最长休眠时间
+ * @return unsigned long 休眠时间（毫秒）
+ */
+unsigned long PowerManager::getMaxIdleMs() const {
+    return lightSleepEnabled ? POWER_IDLE_MAX_SLEEP_MS : TASK_SCHEDULER_MAX_IDLE_MS;
+}
+
+/**
+ * @brief 获取电源管理状态描述
+ * @return String 状态描述
+ */
+String PowerManager::getStatusInfo() const {
+    if (!initialized) {
+        return "未启用";
+    }
+    String info = "动态调频 " + String(POWER_CPU_MIN_FREQ_MHZ) + "-" + String(POWER_CPU_MAX_FREQ_MHZ) + "MHz";
+    info += lightSleepEnabled ? "，自动浅睡眠" : "，固件不支持自动浅睡眠";
+    return info;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String PowerManager::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 配置浅睡眠唤醒源（RI引脚与各SIM串口RX）
+ */
+void PowerManager::configureWakeupSources() {
+    // 模块收到短信或来电时拉低RI，低电平持续期间不会再次进入浅睡眠
+    pinMode(RI_PIN, INPUT_PULLUP);
+    gpio_wakeup_enable((gpio_num_t)RI_PIN, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    // RX边沿唤醒会丢失触发唤醒的前几个字符，只作为RI之外的兜底（RI只连接主模块，其余模块只靠RX唤醒）
+    static const int MODEM_UARTS[MODEM_MAX_COUNT] = { SIM_SERIAL_NUM, SIM2_SERIAL_NUM, SIM3_SERIAL_NUM };
+    for (int i = 0; i < SIM_MODEM_COUNT; i++) {
+        if (uart_set_wakeup_threshold((uart_port_t)MODEM_UARTS[i], POWER_UART_WAKEUP_THRESHOLD) == ESP_OK) {
+            esp_sleep_enable_uart_wakeup(MODEM_UARTS[i]);
+        }
+    }
+}
+
+/**
+ * @brief 保持唤醒定时器到期回调，释放浅睡眠锁
+ * @param arg PowerManager实例指针
+ */
+void PowerManager::onHoldExpired(void* arg) {
+    PowerManager* manager = static_cast<PowerManager*>(arg);
+    if (manager->awakeHeld.exchange(false)) {
+        esp_pm_lock_release(manager->awakeLock);
+    }
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void PowerManager::setError(const String& error) {
+    lastError = error;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file power_manager.h
+ * @brief 电源管理 - 空闲时动态降频并自动进入浅睡眠
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 配置ESP-IDF电源管理（动态调频 + 自动浅睡眠，POWER_SAVE_ENABLED见config.h）
+ * 2. 常驻APB_FREQ_MAX锁，SIM串口波特率不受降频影响
+ * 3. 模块RI引脚低电平与SIM串口RX作为浅睡眠唤醒源
+ * 4. 串口收发后保持POWER_WAKE_HOLD_MS不进入浅睡眠，完整接收URC与命令响应
+ *
+ * 各任务在无事可做时阻塞在队列或通知上（定时任务按调度器给出的到期时间休眠），
+ * FreeRTOS据此计算唤醒时间，空闲期间系统自动进入浅睡眠
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_pm.h>
+#include <esp_timer.h>
+
+/**
+ * @class PowerManager
+ * @brief 电源管理类
+ */
+class PowerManager {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return PowerManager& 单例引用
+     */
+    static PowerManager& getInstance();
+
+    /**
+     * @brief 按配置启用电源管理（须在SIM串口begin()之后调用）
+     * @return true 已启用或按配置不启用
+     * @return false 启用失败
+     */
+    bool initialize();
+
+    /**
+     * @brief 通知有串口活动，在POWER_WAKE_HOLD_MS内不进入浅睡眠（可在任意任务中调用，不可在中断中调用）
+     */
+    void notifyActivity();
+
+    /**
+     * @brief 检查是否已启用自动浅睡眠
+     * @return true 已启用
+     * @return false 未启用
+     */
+    bool isLightSleepEnabled() const;
+
+    /**
+     * @brief 获取loop()无到期任务时的最长休眠时间
+     * @return unsigned long 休眠时间（毫秒）
+     */
+    unsigned long getMaxIdleMs() const;
+
+    /**
+     * @brief 获取电源管理状态描述
+     * @return String 状态描述
+     */
+    String getStatusInfo() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    PowerManager();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    PowerManager(const PowerManager&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    PowerManager& operator=(const PowerManager&) = delete;
+
+    /**
+     * @brief 配置浅睡眠唤醒源（RI引脚与SIM串口RX）
+     */
+    void configureWakeupSources();
+
+    /**
+     * @brief 保持唤醒定时器到期回调，释放浅睡眠锁
+     * @param arg PowerManager实例指针
+     */
+    static void onHoldExpired(void* arg);
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+private:
+    esp_pm_lock_handle_t apbLock;       ///< 常驻的APB_FREQ_MAX锁（保证串口波特率）
+    esp_pm_lock_handle_t awakeLock;     ///< 串口活动期间持有的NO_LIGHT_SLEEP锁
+    esp_timer_handle_t holdTimer;       ///< 保持唤醒定时器
+    std::atomic<bool> awakeHeld;        ///< awakeLock是否已持有
+    bool initialized;                   ///< 是否已启用电源管理
+    bool lightSleepEnabled;             ///< 是否已启用自动浅睡眠
+    String lastError;                   ///< 最后的错误信息
+};
+
+#endif // POWER_MANAGER_H
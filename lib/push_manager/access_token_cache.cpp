@@ -0,0 +1,279 @@
+/**
+ * @file access_token_cache.cpp
+ * @brief 访问令牌缓存服务实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "access_token_cache.h"
+#include "../sms_trace/sms_trace.h"
+#include <Preferences.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief 获取单例实例
+ * @return AccessTokenCache& 单例引用
+ */
+AccessTokenCache& AccessTokenCache::getInstance() {
+    static AccessTokenCache instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+AccessTokenCache::AccessTokenCache() : debugMode(false) {
+}
+
+/**
+ * @brief 从NVS加载持久化的令牌
+ * @return true 加载成功
+ * @return false 加载失败
+ */
+bool AccessTokenCache::initialize() {
+    Preferences preferences;
+    if (!preferences.begin(TOKEN_CACHE_NVS_NAMESPACE, true)) {
+        // 首次运行时命名空间尚不存在
+        return true;
+    }
+    String stored = preferences.getString(TOKEN_CACHE_NVS_KEY, "");
+    preferences.end();
+
+    if (stored.isEmpty()) {
+        return true;
+    }
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, stored);
+    if (error) {
+        setError("解析持久化令牌失败: " + String(error.c_str()));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    for (JsonObject item : doc.as<JsonArray>()) {
+        if (entries.size() >= TOKEN_CACHE_MAX_ENTRIES) {
+            break;
+        }
+        Entry entry;
+        entry.key = item["k"].as<String>();
+        entry.token = item["t"].as<String>();
+        entry.expiresAt = item["e"].as<long>();
+        if (!entry.key.isEmpty() && !entry.token.isEmpty()) {
+            entries.push_back(entry);
+        }
+    }
+
+    debugPrint("已加载 " + String(entries.size()) + " 个持久化令牌");
+    return true;
+}
+
+/**
+ * @brief 获取令牌：缓存有效时直接返回，否则调用fetcher获取并缓存
+ * @param key 缓存键
+ * @param fetcher 令牌获取回调
+ * @return String 令牌，获取失败返回空字符串
+ */
+String AccessTokenCache::getToken(const String& key, const AccessTokenFetcher& fetcher) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry* entry = findEntry(key);
+        if (entry != nullptr) {
+            entry->fetcher = fetcher;
+            time_t now = time(nullptr);
+            if (isClockValid(now) && now + TOKEN_EXPIRY_MARGIN_S < entry->expiresAt) {
+                SmsTrace::mark(SMS_TRACE_TOKEN);
+                return entry->token;
+            }
+        }
+    }
+
+    debugPrint("缓存未命中，获取令牌: " + key);
+    SmsTrace::mark(SMS_TRACE_TOKEN_FETCH);
+    String token = fetchAndStore(key, fetcher);
+    SmsTrace::mark(SMS_TRACE_TOKEN);
+    return token;
+}
+
+/**
+ * @brief 使令牌失效
+ * @param key 缓存键
+ */
+void AccessTokenCache::invalidate(const String& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry* entry = findEntry(key);
+    if (entry != nullptr) {
+        entry->expiresAt = 0;
+        persist();
+    }
+}
+
+/**
+ * @brief 刷新即将过期的令牌
+ * @return int 刷新成功的数量
+ */
+int AccessTokenCache::refreshExpiring() {
+    time_t now = time(nullptr);
+    if (!isClockValid(now)) {
+        return 0;
+    }
+
+    // 在锁外执行HTTP请求，只复制需要刷新的键和回调
+    std::vector<std::pair<String, AccessTokenFetcher>> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Entry& entry : entries) {
+            if (entry.fetcher && entry.expiresAt - now <= TOKEN_REFRESH_AHEAD_S) {
+                due.push_back(std::make_pair(entry.key, entry.fetcher));
+            }
+        }
+    }
+
+    int refreshed = 0;
+    for (const auto& item : due) {
+        debugPrint("提前刷新令牌: " + item.first);
+        if (!fetchAndStore(item.first, item.second).isEmpty()) {
+            refreshed++;
+        }
+    }
+    return refreshed;
+}
+
+/**
+ * @brief 调用fetcher获取令牌并写入缓存
+ * @param key 缓存键
+ * @param fetcher 令牌获取回调
+ * @return String 令牌，失败返回空字符串
+ */
+String AccessTokenCache::fetchAndStore(const String& key, const AccessTokenFetcher& fetcher) {
+    String token;
+    uint32_t expiresIn = 0;
+    String error;
+    if (!fetcher || !fetcher(token, expiresIn, error) || token.isEmpty()) {
+        setError("获取令牌失败(" + key + "): " + error);
+        return "";
+    }
+
+    time_t now = time(nullptr);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Entry* entry = findEntry(key);
+    if (entry == nullptr) {
+        // 超出容量时淘汰最早过期的条目
+        if (entries.size() >= TOKEN_CACHE_MAX_ENTRIES) {
+            auto oldest = entries.begin();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it->expiresAt < oldest->expiresAt) {
+                    oldest = it;
+                }
+            }
+            entries.erase(oldest);
+        }
+        entries.push_back(Entry());
+        entry = &entries.back();
+        entry->key = key;
+    }
+    entry->token = token;
+    entry->expiresAt = now + expiresIn;
+    entry->fetcher = fetcher;
+
+    // 系统时间未同步时过期时间不可靠，不写入NVS
+    if (isClockValid(now)) {
+        persist();
+    }
+
+    debugPrint("令牌已缓存: " + key + "，有效期: " + String(expiresIn) + "秒");
+    return token;
+}
+
+/**
+ * @brief 查找缓存条目
+ * @param key 缓存键
+ * @return Entry* 条目，不存在时返回nullptr
+ */
+AccessTokenCache::Entry* AccessTokenCache::findEntry(const String& key) {
+    for (Entry& entry : entries) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 检查系统时间是否已同步
+ * @param now 当前时间
+ * @return true 已同步
+ * @return false 未同步
+ */
+bool AccessTokenCache::isClockValid(time_t now) {
+    return now >= TOKEN_CACHE_MIN_VALID_TIME;
+}
+
+/**
+ * @brief 将有效的令牌写入NVS
+ */
+void AccessTokenCache::persist() {
+    JsonDocument doc;
+    JsonArray array = doc.to<JsonArray>();
+    for (const Entry& entry : entries) {
+        if (entry.expiresAt == 0) {
+            continue;
+        }
+        JsonObject item = array.add<JsonObject>();
+        item["k"] = entry.key;
+        item["t"] = entry.token;
+        item["e"] = (long)entry.expiresAt;
+    }
+
+    String serialized;
+    serializeJson(doc, serialized);
+
+    Preferences preferences;
+    if (!preferences.begin(TOKEN_CACHE_NVS_NAMESPACE, false)) {
+        lastError = "打开NVS命名空间失败";
+        return;
+    }
+    preferences.putString(TOKEN_CACHE_NVS_KEY, serialized);
+    preferences.end();
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String AccessTokenCache::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void AccessTokenCache::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void AccessTokenCache::setError(const String& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastError = error;
+    }
+    debugPrint("错误: " + error);
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void AccessTokenCache::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[TokenCache] " + message);
+    }
+}
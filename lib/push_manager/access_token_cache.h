@@ -0,0 +1,164 @@
+/**
+ * @file access_token_cache.h
+ * @brief 访问令牌缓存服务 - 在渠道实例之间共享接口access_token
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 按键（如"wechat:<appId>"）缓存令牌及其过期时间，渠道实例销毁后缓存仍保留
+ * 2. 将令牌持久化到NVS，重启后在有效期内继续使用
+ * 3. 由定时任务在令牌过期前主动刷新，推送路径不再等待获取令牌的HTTPS请求
+ *
+ * 过期时间以Unix时间记录，系统时间未同步前不使用持久化的令牌
+ */
+
+#ifndef ACCESS_TOKEN_CACHE_H
+#define ACCESS_TOKEN_CACHE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <time.h>
+#include "../../include/constants.h"
+
+/**
+ * @brief 令牌获取回调
+ *
+ * 可能在定时任务中被调用，不得引用渠道实例
+ * @param token 输出：获取到的令牌
+ * @param expiresIn 输出：有效期（秒）
+ * @param error 输出：失败原因
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+typedef std::function<bool(String& token, uint32_t& expiresIn, String& error)> AccessTokenFetcher;
+
+/**
+ * @class AccessTokenCache
+ * @brief 访问令牌缓存（线程安全）
+ */
+class AccessTokenCache {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return AccessTokenCache& 单例引用
+     */
+    static AccessTokenCache& getInstance();
+
+    /**
+     * @brief 从NVS加载持久化的令牌
+     * @return true 加载成功
+     * @return false 加载失败
+     */
+    bool initialize();
+
+    /**
+     * @brief 获取令牌：缓存有效时直接返回，否则调用fetcher获取并缓存
+     *
+     * fetcher同时被登记为该键的刷新方式，供refreshExpiring()使用
+     * @param key 缓存键
+     * @param fetcher 令牌获取回调
+     * @return String 令牌，获取失败返回空字符串（原因见getLastError()）
+     */
+    String getToken(const String& key, const AccessTokenFetcher& fetcher);
+
+    /**
+     * @brief 使令牌失效（接口返回令牌无效时调用）
+     * @param key 缓存键
+     */
+    void invalidate(const String& key);
+
+    /**
+     * @brief 刷新即将在TOKEN_REFRESH_AHEAD_S内过期的令牌（由定时任务调用）
+     * @return int 刷新成功的数量
+     */
+    int refreshExpiring();
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @struct Entry
+     * @brief 一条缓存的令牌
+     */
+    struct Entry {
+        String key;                     ///< 缓存键
+        String token;                   ///< 令牌
+        time_t expiresAt;               ///< 过期时间（Unix时间，0表示需要重新获取）
+        AccessTokenFetcher fetcher;     ///< 刷新方式（重启后在首次getToken()时登记）
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    AccessTokenCache();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    AccessTokenCache(const AccessTokenCache&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    AccessTokenCache& operator=(const AccessTokenCache&) = delete;
+
+    /**
+     * @brief 调用fetcher获取令牌并写入缓存
+     * @param key 缓存键
+     * @param fetcher 令牌获取回调
+     * @return String 令牌，失败返回空字符串
+     */
+    String fetchAndStore(const String& key, const AccessTokenFetcher& fetcher);
+
+    /**
+     * @brief 查找缓存条目（调用方须持有mutex）
+     * @param key 缓存键
+     * @return Entry* 条目，不存在时返回nullptr
+     */
+    Entry* findEntry(const String& key);
+
+    /**
+     * @brief 检查系统时间是否已同步
+     * @param now 当前时间
+     * @return true 已同步
+     * @return false 未同步
+     */
+    static bool isClockValid(time_t now);
+
+    /**
+     * @brief 将有效的令牌写入NVS（调用方须持有mutex）
+     */
+    void persist();
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    std::vector<Entry> entries;     ///< 缓存的令牌
+    mutable std::mutex mutex;       ///< 保护entries与lastError
+    String lastError;               ///< 最后的错误信息
+    bool debugMode;                 ///< 调试模式
+};
+
+#endif // ACCESS_TOKEN_CACHE_H
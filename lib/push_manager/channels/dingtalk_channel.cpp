@@ -10,8 +10,6 @@
 #include "../http_client/http_client.h"
 #include "../../../include/constants.h"
 #include <ArduinoJson.h>
-#include <mbedtls/md.h>
-#include <base64.h>
 #include <time.h>
 
 /**
@@ -50,52 +48,139 @@ String DingtalkChannel::getChannelDescription() const {
  * @return PushResult 推送结果
  */
 PushResult DingtalkChannel::push(const String& config, const PushContext& context) {
-    std::map<String, String> configMap = parseConfig(config);
-    
-    if (!validateConfig(configMap)) {
+    std::shared_ptr<const PushChannelConfig> prepared = prepareConfig(config);
+    if (!prepared) {
         return PUSH_CONFIG_ERROR;
     }
     
-    String webhookUrl = configMap["webhook_url"];
-    String secret = configMap["secret"];
+    return pushPrepared(*prepared, context);
+}
+
+/**
+ * @brief 解析并校验推送配置
+ * @param config 推送配置（JSON格式）
+ * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+ */
+std::shared_ptr<const PushChannelConfig> DingtalkChannel::prepareConfig(const String& config) {
+    std::map<String, String> configMap = parseConfig(config);
     
-    // 如果配置了secret，需要生成签名
-    if (!secret.isEmpty()) {
-        String timestamp = String(time(nullptr) * 1000); // 使用Unix时间戳（毫秒）
-        String sign = generateSign(timestamp, secret);
-        
-        // 添加签名参数到URL
-        char separator = (webhookUrl.indexOf('?') == -1) ? '?' : '&';
-        webhookUrl += separator + "timestamp=" + timestamp + "&sign=" + sign;
+    if (!validateConfig(configMap)) {
+        return nullptr;
     }
     
+    std::shared_ptr<DingtalkConfig> prepared = std::make_shared<DingtalkConfig>();
+    prepared->webhookUrl = configMap["webhook_url"];
+    prepared->secret = configMap["secret"];
+    
     // 获取消息模板
     String messageTemplate = configMap["template"];
     if (messageTemplate.isEmpty()) {
         // 使用默认模板
         messageTemplate = "📱 收到新短信\n\n📞 发送方: {sender}\n🕐 时间: {timestamp}\n📄 内容: {content}";
     }
-    
-    String message = applyTemplate(messageTemplate, context);
+    prepared->messageTemplate.compile(messageTemplate);
     
     // 获取消息类型
-    String msgType = configMap["msg_type"];
-    if (msgType.isEmpty()) {
-        msgType = "text";
+    prepared->msgType = configMap["msg_type"];
+    if (prepared->msgType.isEmpty()) {
+        prepared->msgType = "text";
     }
     
-    String messageBody = buildMessageBody(message, msgType);
+    return prepared;
+}
+
+/**
+ * @brief 使用预解析的配置执行推送
+ * @param config 由prepareConfig()生成的配置
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult DingtalkChannel::pushPrepared(const PushChannelConfig& config, const PushContext& context) {
+    const DingtalkConfig& dingtalkConfig = static_cast<const DingtalkConfig&>(config);
+    
+    ArenaText message;
+    renderTemplate(message, dingtalkConfig.messageTemplate, context);
+    
+    ArenaText messageBody;
+    buildMessageBody(messageBody, message.c_str(), dingtalkConfig.msgType);
     
+    return postMessage(buildSignedUrl(dingtalkConfig), messageBody);
+}
+
+/**
+ * @brief 渠道是否支持汇总推送
+ * @return true 支持
+ */
+bool DingtalkChannel::supportsDigest() const {
+    return true;
+}
+
+/**
+ * @brief 推送多条短信的汇总消息（始终以markdown发送）
+ * @param config 由prepareConfig()生成的配置
+ * @param title 汇总标题
+ * @param body 汇总正文
+ * @return PushResult 推送结果
+ */
+PushResult DingtalkChannel::pushDigest(const PushChannelConfig& config, const String& title, const String& body) {
+    const DingtalkConfig& dingtalkConfig = static_cast<const DingtalkConfig&>(config);
+    
+    ArenaText message;
+    message.concat("### ");
+    message.concat(title);
+    message.concat("\n\n");
+    message.concat(body);
+    
+    ArenaText messageBody;
+    buildMessageBody(messageBody, message.c_str(), "markdown", title);
+    
+    return postMessage(buildSignedUrl(dingtalkConfig), messageBody);
+}
+
+/**
+ * @brief 生成带签名参数的Webhook地址
+ * @param config 钉钉配置
+ * @return String Webhook地址
+ */
+String DingtalkChannel::buildSignedUrl(const DingtalkConfig& config) {
+    String webhookUrl = config.webhookUrl;
+    
+    // 如果配置了secret，需要生成签名（签名含时间戳，每次推送都要重新计算）
+    if (!config.secret.isEmpty()) {
+        time_t now = time(nullptr);
+        char sign[HMAC_SIGN_URL_SIZE];
+        generateSign(now, config.secret, sign);
+        
+        // 添加签名参数到URL（时间戳为毫秒）
+        char query[HMAC_SIGN_URL_SIZE + 48];
+        snprintf(query, sizeof(query), "%ctimestamp=%lld000&sign=%s",
+                 (webhookUrl.indexOf('?') == -1) ? '?' : '&', (long long)now, sign);
+        webhookUrl += query;
+    }
+    
+    return webhookUrl;
+}
+
+/**
+ * @brief 发送消息体到钉钉机器人
+ * @param webhookUrl Webhook地址（已含签名参数）
+ * @param messageBody JSON消息体
+ * @return PushResult 推送结果
+ */
+PushResult DingtalkChannel::postMessage(const String& webhookUrl, const ArenaText& messageBody) {
     // 设置请求头
     std::map<String, String> headers;
     headers["Content-Type"] = "application/json";
     
-    debugPrint("推送到钉钉: " + webhookUrl);
-    debugPrint("消息内容: " + messageBody);
+    if (debugMode) {
+        debugPrint("推送到钉钉: " + webhookUrl);
+        debugPrint("消息内容: " + messageBody.toString());
+    }
     
-    // 发送HTTP请求
+    // 发送HTTP请求（只凭状态码判断结果，响应体仅在调试时读取）
     HttpClient& httpClient = HttpClient::getInstance();
-    HttpResponse response = httpClient.post(webhookUrl, messageBody, headers, DEFAULT_HTTP_TIMEOUT_MS);
+    HttpResponse response = httpClient.post(webhookUrl, messageBody.c_str(), messageBody.length(), headers,
+                                            DEFAULT_HTTP_TIMEOUT_MS, debugMode);
     
     debugPrint("钉钉响应 - 状态码: " + String(response.statusCode) + ", 错误码: " + String(response.error));
     debugPrint("响应内容: " + response.body);
@@ -227,58 +312,56 @@ bool DingtalkChannel::validateConfig(const std::map<String, String>& configMap)
 
 /**
  * @brief 构建钉钉消息体
+ * @param output 输出的JSON消息体
  * @param message 消息内容
  * @param msgType 消息类型（text/markdown）
- * @return String JSON消息体
+ * @param title markdown消息标题
  */
-String DingtalkChannel::buildMessageBody(const String& message, const String& msgType) {
-    JsonDocument doc;
+void DingtalkChannel::buildMessageBody(ArenaText& output, const char* message, const String& msgType,
+                                       const String& title) {
+    JsonDocument doc(ArenaJsonAllocator::instance());
     doc["msgtype"] = msgType;
     
     if (msgType == "markdown") {
-        doc["markdown"]["title"] = "短信通知";
+        doc["markdown"]["title"] = title;
         doc["markdown"]["text"] = message;
     } else {
         doc["text"]["content"] = message;
     }
     
-    String messageBody;
-    serializeJson(doc, messageBody);
-    
-    return messageBody;
+    serializeJson(doc, output);
 }
 
 /**
- * @brief 生成签名（如果配置了secret）
- * @param timestamp 时间戳
+ * @brief 生成URL编码的签名
+ * @param timestamp 秒级时间戳（签名使用其毫秒值）
  * @param secret 密钥
- * @return String 签名
+ * @param output 输出的URL编码签名
+ * @return bool 签名是否成功
  */
-String DingtalkChannel::generateSign(const String& timestamp, const String& secret) {
-    // 钉钉签名算法：HMAC-SHA256
-    String stringToSign = timestamp + "\n" + secret;
-    
-    // 使用mbedtls计算HMAC-SHA256
-    unsigned char hmac[32];
-    mbedtls_md_context_t ctx;
-    mbedtls_md_type_t md_type = MBEDTLS_MD_SHA256;
-    
-    mbedtls_md_init(&ctx);
-    mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(md_type), 1);
-    mbedtls_md_hmac_starts(&ctx, (const unsigned char*)secret.c_str(), secret.length());
-    mbedtls_md_hmac_update(&ctx, (const unsigned char*)stringToSign.c_str(), stringToSign.length());
-    mbedtls_md_hmac_finish(&ctx, hmac);
-    mbedtls_md_free(&ctx);
-    
-    // Base64编码
-    String encoded = base64::encode((uint8_t*)hmac, 32);
-    
-    // URL编码（简单实现）
-    encoded.replace("+", "%2B");
-    encoded.replace("/", "%2F");
-    encoded.replace("=", "%3D");
-    
-    return encoded;
+bool DingtalkChannel::generateSign(time_t timestamp, const String& secret, char (&output)[HMAC_SIGN_URL_SIZE]) {
+    // 钉钉签名算法：以secret为密钥对 timestamp + "\n" + secret 做HMAC-SHA256
+    char signature[HMAC_SIGN_TEXT_SIZE];
+    output[0] = '\0';
+    if (!HmacSignCache::getInstance().sign(HMAC_SIGN_DINGTALK, secret, timestamp, signature)) {
+        debugPrint("签名计算失败（密钥长度超过" + String(HMAC_SIGN_MAX_SECRET_LENGTH) + "字节或摘要计算出错）");
+        return false;
+    }
+    
+    // URL编码（Base64中只有+、/、=需要转义）
+    size_t length = 0;
+    for (const char* p = signature; *p != '\0'; p++) {
+        const char* escaped = (*p == '+') ? "%2B" : (*p == '/') ? "%2F" : (*p == '=') ? "%3D" : nullptr;
+        if (escaped != nullptr) {
+            memcpy(output + length, escaped, 3);
+            length += 3;
+        } else {
+            output[length++] = *p;
+        }
+    }
+    output[length] = '\0';
+    
+    return true;
 }
 
 /**
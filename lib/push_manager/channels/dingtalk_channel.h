@@ -12,6 +12,18 @@
 
 #include "../push_channel_base.h"
 #include "../push_channel_registry.h"
+#include "../hmac_sign_cache.h"
+
+/**
+ * @struct DingtalkConfig
+ * @brief 钉钉渠道的类型化配置
+ */
+struct DingtalkConfig : public PushChannelConfig {
+    String webhookUrl;          ///< 机器人Webhook地址
+    String secret;              ///< 签名密钥（为空时不签名）
+    CompiledTemplate messageTemplate; ///< 预编译的消息模板（未配置时为默认模板）
+    String msgType;             ///< 消息类型（text/markdown）
+};
 
 /**
  * @class DingtalkChannel
@@ -51,6 +63,36 @@ public:
      */
     PushResult push(const String& config, const PushContext& context) override;
 
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+     */
+    std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) override;
+
+    /**
+     * @brief 使用预解析的配置执行推送
+     * @param config 由prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) override;
+
+    /**
+     * @brief 渠道是否支持汇总推送
+     * @return true 支持
+     */
+    bool supportsDigest() const override;
+
+    /**
+     * @brief 推送多条短信的汇总消息
+     * @param config 由prepareConfig()生成的配置
+     * @param title 汇总标题
+     * @param body 汇总正文（Markdown）
+     * @return PushResult 推送结果
+     */
+    PushResult pushDigest(const PushChannelConfig& config, const String& title, const String& body) override;
+
     /**
      * @brief 测试推送配置
      * @param config 推送配置（JSON格式）
@@ -99,19 +141,37 @@ private:
 
     /**
      * @brief 构建钉钉消息体
+     * @param output 输出的JSON消息体
      * @param message 消息内容
      * @param msgType 消息类型（text/markdown）
-     * @return String JSON消息体
+     * @param title markdown消息标题
+     */
+    void buildMessageBody(ArenaText& output, const char* message, const String& msgType = "text",
+                          const String& title = "短信通知");
+
+    /**
+     * @brief 生成带签名参数的Webhook地址（未配置secret时原样返回）
+     * @param config 钉钉配置
+     * @return String Webhook地址
+     */
+    String buildSignedUrl(const DingtalkConfig& config);
+
+    /**
+     * @brief 发送消息体到钉钉机器人
+     * @param webhookUrl Webhook地址（已含签名参数）
+     * @param messageBody JSON消息体
+     * @return PushResult 推送结果
      */
-    String buildMessageBody(const String& message, const String& msgType = "text");
+    PushResult postMessage(const String& webhookUrl, const ArenaText& messageBody);
 
     /**
-     * @brief 生成签名（如果配置了secret）
-     * @param timestamp 时间戳
+     * @brief 生成URL编码的签名（由HmacSignCache计算，同一秒内的重复推送复用结果）
+     * @param timestamp 秒级时间戳（签名使用其毫秒值）
      * @param secret 密钥
-     * @return String 签名
+     * @param output 输出的URL编码签名
+     * @return bool 签名是否成功
      */
-    String generateSign(const String& timestamp, const String& secret);
+    bool generateSign(time_t timestamp, const String& secret, char (&output)[HMAC_SIGN_URL_SIZE]);
 };
 
 #endif // DINGTALK_CHANNEL_H
\ No newline at end of file
@@ -11,8 +11,6 @@
 #include "../../gsm_service/gsm_service.h"
 #include "../../../include/constants.h"
 #include <ArduinoJson.h>
-#include <mbedtls/md.h>
-#include <mbedtls/base64.h>
 #include <time.h>
 
 /**
@@ -51,41 +49,67 @@ String FeishuBotChannel::getChannelDescription() const {
  * @return PushResult 推送结果
  */
 PushResult FeishuBotChannel::push(const String& config, const PushContext& context) {
+    std::shared_ptr<const PushChannelConfig> prepared = prepareConfig(config);
+    if (!prepared) {
+        return PUSH_CONFIG_ERROR;
+    }
+    
+    return pushPrepared(*prepared, context);
+}
+
+/**
+ * @brief 解析并校验推送配置
+ * @param config 推送配置（JSON格式）
+ * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+ */
+std::shared_ptr<const PushChannelConfig> FeishuBotChannel::prepareConfig(const String& config) {
     std::map<String, String> configMap = parseConfig(config);
     
     if (!validateConfig(configMap)) {
-        return PUSH_CONFIG_ERROR;
+        return nullptr;
     }
     
-    String webhookUrl = configMap["webhook_url"];
-    String messageType = configMap["message_type"];
-    if (messageType.isEmpty()) {
-        messageType = "text"; // 默认使用文本消息类型
-    }
-    String secret = configMap["secret"];
-    String title = configMap["title"];
+    std::shared_ptr<FeishuBotConfig> prepared = std::make_shared<FeishuBotConfig>();
+    prepared->webhookUrl = configMap["webhook_url"];
+    prepared->secret = configMap["secret"];
     
-    // 应用消息模板
+    // 消息模板
     String messageTemplate = configMap["message_template"];
     if (messageTemplate.isEmpty()) {
         messageTemplate = "短信转发通知\n发送方：{sender}\n内容：{content}\n时间：{timestamp}";
     }
+    prepared->messageTemplate.compile(messageTemplate);
     
-    String content = applyTemplate(messageTemplate, context, false);
-    
-    // 应用标题模板
+    // 标题模板
+    String title = configMap["title"];
     if (title.isEmpty()) {
         title = "短信转发通知";
     }
-    title = applyTemplate(title, context, false);
+    prepared->title.compile(title);
     
-    debugPrint("推送到飞书机器人: " + webhookUrl);
-    debugPrint("消息类型: " + messageType);
-    debugPrint("标题: " + title);
+    return prepared;
+}
+
+/**
+ * @brief 使用预解析的配置执行推送
+ * @param config 由prepareConfig()生成的配置
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult FeishuBotChannel::pushPrepared(const PushChannelConfig& config, const PushContext& context) {
+    const FeishuBotConfig& feishuConfig = static_cast<const FeishuBotConfig&>(config);
+    
+    String content = renderTemplate(feishuConfig.messageTemplate, context, false);
+    
+    debugPrint("推送到飞书机器人: " + feishuConfig.webhookUrl);
+    debugPrint("消息类型: text");
+    if (debugMode) {
+        debugPrint("标题: " + renderTemplate(feishuConfig.title, context, false));
+    }
     debugPrint("内容: " + content);
     
     // 只支持文本消息类型
-    bool success = sendTextMessage(webhookUrl, content, secret);
+    bool success = sendTextMessage(feishuConfig.webhookUrl, content, feishuConfig.secret);
     
     if (success) {
         debugPrint("✅ 飞书机器人推送成功");
@@ -95,6 +119,33 @@ PushResult FeishuBotChannel::push(const String& config, const PushContext& conte
     }
 }
 
+/**
+ * @brief 渠道是否支持汇总推送
+ * @return true 支持
+ */
+bool FeishuBotChannel::supportsDigest() const {
+    return true;
+}
+
+/**
+ * @brief 推送多条短信的汇总消息（飞书渠道只支持文本消息，Markdown原样发送）
+ * @param config 由prepareConfig()生成的配置
+ * @param title 汇总标题
+ * @param body 汇总正文
+ * @return PushResult 推送结果
+ */
+PushResult FeishuBotChannel::pushDigest(const PushChannelConfig& config, const String& title, const String& body) {
+    const FeishuBotConfig& feishuConfig = static_cast<const FeishuBotConfig&>(config);
+    
+    debugPrint("推送汇总到飞书机器人: " + feishuConfig.webhookUrl);
+    
+    if (sendTextMessage(feishuConfig.webhookUrl, title + "\n\n" + body, feishuConfig.secret)) {
+        debugPrint("✅ 飞书机器人汇总推送成功");
+        return PUSH_SUCCESS;
+    }
+    return PUSH_FAILED;
+}
+
 /**
  * @brief 测试推送配置
  * @param config 推送配置（JSON格式）
@@ -271,45 +322,18 @@ bool FeishuBotChannel::sendTextMessage(const String& webhookUrl, const String& c
 
 /**
  * @brief 生成签名
- * @param timestamp 时间戳
+ * @param timestamp 秒级时间戳
  * @param secret 签名密钥
- * @return String 签名字符串
+ * @param output 输出的Base64签名
+ * @return bool 签名是否成功
  */
-String FeishuBotChannel::generateSignature(const String& timestamp, const String& secret) {
+bool FeishuBotChannel::generateSignature(time_t timestamp, const String& secret, char (&output)[HMAC_SIGN_TEXT_SIZE]) {
     // 根据飞书官方文档：使用 timestamp + "\n" + secret 作为密钥，空字符串作为消息
-    String key = timestamp + "\n" + secret;
-    String message = ""; // 空字符串
-    
-    debugPrint("HMAC密钥: " + key);
-    debugPrint("HMAC消息: [空字符串]");
-    
-    // 使用HMAC-SHA256生成签名
-    unsigned char hmacResult[32];
-    mbedtls_md_context_t ctx;
-    mbedtls_md_type_t md_type = MBEDTLS_MD_SHA256;
-    
-    mbedtls_md_init(&ctx);
-    mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(md_type), 1);
-    
-    // 使用key作为密钥，空字符串作为消息
-    mbedtls_md_hmac_starts(&ctx, (const unsigned char*)key.c_str(), key.length());
-    mbedtls_md_hmac_update(&ctx, (const unsigned char*)message.c_str(), message.length());
-    mbedtls_md_hmac_finish(&ctx, hmacResult);
-    mbedtls_md_free(&ctx);
-    
-    // Base64编码
-    size_t olen = 0;
-    unsigned char base64Buffer[64]; // 足够存储32字节的base64编码结果
-    
-    int ret = mbedtls_base64_encode(base64Buffer, sizeof(base64Buffer), &olen, hmacResult, 32);
-    if (ret != 0) {
-        debugPrint("Base64编码失败");
-        return ""; // 编码失败
+    if (!HmacSignCache::getInstance().sign(HMAC_SIGN_FEISHU, secret, timestamp, output)) {
+        debugPrint("签名计算失败（密钥长度超过" + String(HMAC_SIGN_MAX_SECRET_LENGTH) + "字节或摘要计算出错）");
+        return false;
     }
-    
-    String signature = String((char*)base64Buffer);
-    debugPrint("生成的签名: " + signature);
-    return signature;
+    return true;
 }
 
 /**
@@ -355,8 +379,12 @@ bool FeishuBotChannel::sendToFeishu(const String& webhookUrl, const String& mess
     
     // 如果提供了签名密钥，添加签名
     if (!secret.isEmpty()) {
-        String timestamp = getCurrentTimestamp();
-        String signature = generateSignature(timestamp, secret);
+        // 直接使用系统UTC时间戳
+        time_t now = time(nullptr);
+        char timestamp[24];
+        snprintf(timestamp, sizeof(timestamp), "%lld", (long long)now);
+        char signature[HMAC_SIGN_TEXT_SIZE];
+        generateSignature(now, secret, signature);
         
         // 修改请求体，添加签名信息
         JsonDocument doc;
@@ -367,20 +395,29 @@ bool FeishuBotChannel::sendToFeishu(const String& webhookUrl, const String& mess
         requestBody = "";
         serializeJson(doc, requestBody);
         
-        debugPrint("添加签名 - 时间戳: " + timestamp + ", 签名: " + signature);
+        if (debugMode) {
+            debugPrint("添加签名 - 时间戳: " + String(timestamp) + ", 签名: " + String(signature));
+        }
     }
     
     debugPrint("发送到飞书的请求体: " + requestBody);
     
-    HttpResponse response = httpClient.post(webhookUrl, requestBody, headers, DEFAULT_HTTP_TIMEOUT_MS);
+    HttpRequest request;
+    request.url = webhookUrl;
+    request.method = HTTP_CLIENT_POST;
+    request.headers = headers;
+    request.body = requestBody;
+    request.maxBodyBytes = PUSH_RESPONSE_MAX_BYTES;
+    request.timeout = DEFAULT_HTTP_TIMEOUT_MS;
+    HttpResponse response = httpClient.request(request);
     
     debugPrint("飞书响应 - 状态码: " + String(response.statusCode) + ", 错误码: " + String(response.error));
     debugPrint("响应内容: " + response.body);
     
     if (response.statusCode == 200) {
-        // 解析飞书响应
+        // 只解析code与msg
         JsonDocument responseDoc;
-        DeserializationError error = deserializeJson(responseDoc, response.body);
+        DeserializationError error = parseResponseFields(response.body, {"code", "msg"}, responseDoc);
         
         if (!error) {
             int code = responseDoc["code"] | -1;
@@ -402,19 +439,6 @@ bool FeishuBotChannel::sendToFeishu(const String& webhookUrl, const String& mess
     }
 }
 
-/**
- * @brief 获取当前时间戳（秒）
- * @return String 时间戳字符串
- */
-String FeishuBotChannel::getCurrentTimestamp() {
-    // 直接使用系统UTC时间戳，确保时间准确性
-    time_t now;
-    time(&now);
-    
-    debugPrint("使用系统UTC时间戳: " + String(now));
-    return String(now);
-}
-
 /**
  * @brief 转义JSON字符串
  * @param str 原始字符串
@@ -16,6 +16,7 @@
 
 #include "../push_channel_base.h"
 #include "../push_channel_registry.h"
+#include "../hmac_sign_cache.h"
 #include <map>
 
 /**
@@ -26,6 +27,17 @@ enum FeishuMessageType {
     FEISHU_TEXT = 0         ///< 文本消息
 };
 
+/**
+ * @struct FeishuBotConfig
+ * @brief 飞书机器人渠道的类型化配置
+ */
+struct FeishuBotConfig : public PushChannelConfig {
+    String webhookUrl;          ///< 机器人Webhook地址
+    String secret;              ///< 签名密钥（为空时不签名）
+    CompiledTemplate title;     ///< 预编译的标题模板（未配置时为默认标题）
+    CompiledTemplate messageTemplate; ///< 预编译的消息模板（未配置时为默认模板）
+};
+
 /**
  * @class FeishuBotChannel
  * @brief 飞书机器人推送渠道类
@@ -68,6 +80,36 @@ public:
      */
     PushResult push(const String& config, const PushContext& context) override;
 
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+     */
+    std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) override;
+
+    /**
+     * @brief 使用预解析的配置执行推送
+     * @param config 由prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) override;
+
+    /**
+     * @brief 渠道是否支持汇总推送
+     * @return true 支持
+     */
+    bool supportsDigest() const override;
+
+    /**
+     * @brief 推送多条短信的汇总消息
+     * @param config 由prepareConfig()生成的配置
+     * @param title 汇总标题
+     * @param body 汇总正文（Markdown）
+     * @return PushResult 推送结果
+     */
+    PushResult pushDigest(const PushChannelConfig& config, const String& title, const String& body) override;
+
     /**
      * @brief 测试推送配置
      * @param config 推送配置（JSON格式）
@@ -126,12 +168,13 @@ private:
 
 
     /**
-     * @brief 生成签名
-     * @param timestamp 时间戳
+     * @brief 生成签名（由HmacSignCache计算，同一秒内的重复推送复用结果）
+     * @param timestamp 秒级时间戳
      * @param secret 签名密钥
-     * @return String 签名字符串
+     * @param output 输出的Base64签名
+     * @return bool 签名是否成功
      */
-    String generateSignature(const String& timestamp, const String& secret);
+    bool generateSignature(time_t timestamp, const String& secret, char (&output)[HMAC_SIGN_TEXT_SIZE]);
 
     /**
      * @brief 构建文本消息JSON
@@ -158,12 +201,6 @@ private:
      */
     bool sendToFeishu(const String& webhookUrl, const String& messageJson, const String& secret = "");
 
-    /**
-     * @brief 获取当前时间戳（秒）
-     * @return String 时间戳字符串
-     */
-    String getCurrentTimestamp();
-
     /**
      * @brief 转义JSON字符串
      * @param str 原始字符串
@@ -0,0 +1,374 @@
+/**
+ * @file mqtt_channel.cpp
+ * @brief MQTT推送渠道实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "mqtt_channel.h"
+#include "../push_channel_registry.h"
+#include "../mqtt_session.h"
+#include "../../../include/constants.h"
+#include <ArduinoJson.h>
+
+/**
+ * @brief 构造函数
+ */
+MqttChannel::MqttChannel() {
+    debugMode = false;
+}
+
+/**
+ * @brief 析构函数
+ */
+MqttChannel::~MqttChannel() {
+}
+
+/**
+ * @brief 获取渠道名称
+ * @return String 渠道名称
+ */
+String MqttChannel::getChannelName() const {
+    return "mqtt";
+}
+
+/**
+ * @brief 获取渠道描述
+ * @return String 渠道描述
+ */
+String MqttChannel::getChannelDescription() const {
+    return "MQTT推送（长连接，QoS1）";
+}
+
+/**
+ * @brief 执行推送
+ * @param config 推送配置（JSON格式）
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult MqttChannel::push(const String& config, const PushContext& context) {
+    std::shared_ptr<const PushChannelConfig> prepared = prepareConfig(config);
+    if (!prepared) {
+        return PUSH_CONFIG_ERROR;
+    }
+
+    return pushPrepared(*prepared, context);
+}
+
+/**
+ * @brief 解析并校验推送配置
+ * @param config 推送配置（JSON格式）
+ * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+ */
+std::shared_ptr<const PushChannelConfig> MqttChannel::prepareConfig(const String& config) {
+    std::map<String, String> configMap = parseConfig(config);
+
+    std::shared_ptr<MqttConfig> prepared = std::make_shared<MqttConfig>();
+    MqttEndpoint& endpoint = prepared->endpoint;
+    endpoint.port = 0;
+    endpoint.tls = configMap["tls"] == "true" || configMap["tls"] == "1";
+    if (!parseBroker(configMap["broker"], endpoint)) {
+        return nullptr;
+    }
+    if (!configMap["port"].isEmpty()) {
+        long port = configMap["port"].toInt();
+        if (port <= 0 || port > 65535) {
+            setError("MQTT端口无效: " + configMap["port"]);
+            return nullptr;
+        }
+        endpoint.port = (uint16_t)port;
+    }
+    if (endpoint.port == 0) {
+        endpoint.port = endpoint.tls ? MQTT_DEFAULT_TLS_PORT : MQTT_DEFAULT_PORT;
+    }
+
+    endpoint.clientId = configMap["client_id"];
+    if (endpoint.clientId.isEmpty()) {
+        endpoint.clientId = defaultClientId();
+    }
+    endpoint.username = configMap["username"];
+    endpoint.password = configMap["password"];
+
+    long keepalive = configMap["keepalive"].isEmpty() ? MQTT_DEFAULT_KEEPALIVE_S : configMap["keepalive"].toInt();
+    if (keepalive < 10 || keepalive > 3600) {
+        setError("MQTT心跳间隔应在10-3600秒之间: " + configMap["keepalive"]);
+        return nullptr;
+    }
+    endpoint.keepalive = (uint16_t)keepalive;
+
+    long maxInflight = configMap["max_inflight"].isEmpty() ? MQTT_DEFAULT_MAX_INFLIGHT : configMap["max_inflight"].toInt();
+    if (maxInflight < 1 || maxInflight > MQTT_MAX_INFLIGHT_LIMIT) {
+        setError("max_inflight应在1-" + String(MQTT_MAX_INFLIGHT_LIMIT) + "之间: " + configMap["max_inflight"]);
+        return nullptr;
+    }
+    endpoint.maxInflight = (uint8_t)maxInflight;
+
+    prepared->transportName = configMap["transport"];
+    if (prepared->transportName.isEmpty()) {
+        prepared->transportName = "auto";
+    }
+    if (prepared->transportName.equalsIgnoreCase("auto")) {
+        endpoint.transport = MQTT_TRANSPORT_AUTO;
+    } else if (prepared->transportName.equalsIgnoreCase("wifi")) {
+        endpoint.transport = MQTT_TRANSPORT_WIFI;
+    } else if (prepared->transportName.equalsIgnoreCase("modem")) {
+        endpoint.transport = MQTT_TRANSPORT_MODEM;
+    } else {
+        setError("不支持的传输方式: " + prepared->transportName + "，仅支持auto、wifi和modem");
+        return nullptr;
+    }
+
+    String topic = configMap["topic"];
+    if (topic.isEmpty()) {
+        topic = "sms-relay/" + endpoint.clientId + "/sms";
+    }
+    if (topic.indexOf('#') != -1 || topic.indexOf('+') != -1) {
+        setError("MQTT发布主题不能包含通配符: " + topic);
+        return nullptr;
+    }
+    prepared->topicTemplate.compile(topic);
+
+    String payloadTemplate = configMap["payload_template"];
+    if (payloadTemplate.isEmpty()) {
+        // 使用默认JSON模板
+        payloadTemplate = "{\"sender\":\"{sender}\",\"content\":\"{content}\",\"timestamp\":\"{timestamp}\",\"sms_id\":{sms_id}}";
+    }
+    prepared->payloadTemplate.compile(payloadTemplate);
+
+    return prepared;
+}
+
+/**
+ * @brief 使用预解析的配置执行推送
+ * @param config 由prepareConfig()生成的配置
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult MqttChannel::pushPrepared(const PushChannelConfig& config, const PushContext& context) {
+    const MqttConfig& mqttConfig = static_cast<const MqttConfig&>(config);
+
+    ArenaText topic;
+    renderTemplate(topic, mqttConfig.topicTemplate, context, false);
+    if (topic.length() == 0 || topic.length() > MQTT_MAX_TOPIC_LENGTH) {
+        setError("MQTT主题为空或过长: " + String((unsigned long)topic.length()));
+        return PUSH_CONFIG_ERROR;
+    }
+
+    ArenaText payload;
+    renderTemplate(payload, mqttConfig.payloadTemplate, context, true); // 默认载荷为JSON，对占位符的值做JSON转义
+
+    if (debugMode) {
+        debugPrint("发布到MQTT: " + mqttConfig.endpoint.host + ":" + String(mqttConfig.endpoint.port) +
+                   (mqttConfig.endpoint.tls ? " (TLS)" : "") + "，传输方式: " + mqttConfig.transportName);
+        debugPrint("主题: " + topic.toString());
+        debugPrint("消息内容: " + payload.toString());
+    }
+
+    String error;
+    PushResult result = MqttSessionManager::getInstance().publish(mqttConfig.endpoint, topic.c_str(),
+                                                                  payload.c_str(), payload.length(),
+                                                                  context.outboxId, error);
+    if (result == PUSH_SUCCESS) {
+        debugPrint("✅ MQTT发布成功");
+    } else if (result == PUSH_PENDING) {
+        debugPrint("📤 MQTT消息已发布，等待PUBACK");
+    } else {
+        setError("MQTT推送失败: " + error);
+    }
+    return result;
+}
+
+/**
+ * @brief 测试推送配置
+ * @param config 推送配置（JSON格式）
+ * @param testMessage 测试消息
+ * @return PushResult 推送结果
+ */
+PushResult MqttChannel::testConfig(const String& config, const String& testMessage) {
+    PushContext testContext;
+    testContext.sender = "测试号码";
+    testContext.content = testMessage;
+    testContext.timestamp = "240101120000"; // 2024-01-01 12:00:00
+    testContext.smsRecordId = -1;
+
+    return push(config, testContext);
+}
+
+/**
+ * @brief 获取配置示例
+ * @return PushChannelExample 配置示例
+ */
+PushChannelExample MqttChannel::getConfigExample() const {
+    PushChannelExample example;
+    example.channelName = "MQTT";
+    example.description = "通过MQTT长连接发布短信通知";
+    example.configExample = R"({
+  "broker": "mqtts://mqtt.example.com:8883",
+  "client_id": "relay-01",
+  "username": "relay",
+  "password": "YOUR_PASSWORD",
+  "topic": "sms/relay-01/{sender}",
+  "payload_template": "{\"from\":\"{sender}\",\"text\":\"{content}\",\"time\":\"{timestamp}\"}",
+  "transport": "auto"
+})";
+    example.usage = R"(使用说明：
+1. broker填写服务器地址，mqtts://表示TLS（默认端口8883），mqtt://或只写主机名为明文（默认端口1883）
+2. client_id在所有设备之间须唯一，默认为"sms-relay-"加MAC地址后6位
+3. topic与payload_template支持占位符：{sender}、{content}、{timestamp}、{sms_id}
+4. 每条短信以QoS1发布一条消息，连接长期保持，不再为每条短信建立连接
+5. transport：auto（WiFi已连接时走WiFi，否则走模块）、wifi、modem
+6. max_inflight：WiFi连接未收到PUBACK时最多继续发布的消息数（默认8）；模块连接每条消息都等待PUBACK)";
+
+    return example;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String MqttChannel::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void MqttChannel::setDebugMode(bool enable) {
+    debugMode = enable;
+    MqttSessionManager::getInstance().setDebugMode(enable);
+}
+
+/**
+ * @brief 获取CLI演示代码
+ * @return String CLI演示代码
+ */
+String MqttChannel::getCliDemo() const {
+    String demo = "// MQTT推送演示\n";
+    demo += "void demoMqttPush() {\n";
+    demo += "    MqttChannel mqtt;\n";
+    demo += "    mqtt.setDebugMode(true);\n";
+    demo += "    \n";
+    demo += "    String config = \"{\n";
+    demo += "        \\\"broker\\\": \\\"mqtts://mqtt.example.com:8883\\\",\n";
+    demo += "        \\\"client_id\\\": \\\"relay-01\\\",\n";
+    demo += "        \\\"username\\\": \\\"relay\\\",\n";
+    demo += "        \\\"password\\\": \\\"YOUR_PASSWORD\\\",\n";
+    demo += "        \\\"topic\\\": \\\"sms/relay-01/{sender}\\\"\n";
+    demo += "    }\";\n";
+    demo += "    \n";
+    demo += "    PushResult result = mqtt.testConfig(config, \\\"这是一条MQTT测试消息\\\");\n";
+    demo += "    if (result == PUSH_SUCCESS) {\n";
+    demo += "        Serial.println(\\\"✅ MQTT推送测试成功\\\");\n";
+    demo += "    } else {\n";
+    demo += "        Serial.println(\\\"❌ MQTT推送测试失败: \\\" + mqtt.getLastError());\n";
+    demo += "    }\n";
+    demo += "    \n";
+    demo += "    // 连接在推送之间保持，可查看当前连接\n";
+    demo += "    Serial.println(MqttSessionManager::getInstance().getStatusInfo());\n";
+    demo += "}";
+
+    return demo;
+}
+
+/**
+ * @brief 获取渠道帮助信息
+ * @return PushChannelHelp 帮助信息
+ */
+PushChannelHelp MqttChannel::getHelp() const {
+    PushChannelHelp help;
+    help.channelName = "mqtt";
+    help.description = "MQTT推送渠道，保持长连接，每条短信以QoS1发布一条消息";
+
+    help.configFields = "配置字段说明:\n"
+                       "- broker: 服务器地址，如mqtt.example.com、mqtt://host:1883、mqtts://host:8883 (必填)\n"
+                       "- port: 端口，覆盖broker中的端口 (默认1883，TLS为8883)\n"
+                       "- tls: 是否使用TLS，true/false (mqtts://时自动开启)\n"
+                       "- client_id: 客户端ID，各设备须唯一 (默认sms-relay-加MAC后6位)\n"
+                       "- username/password: 认证信息 (可选)\n"
+                       "- topic: 发布主题，支持占位符 (默认sms-relay/<client_id>/sms)\n"
+                       "- payload_template: 消息模板，支持占位符{sender},{content},{timestamp},{sms_id} (默认JSON)\n"
+                       "- keepalive: 心跳间隔秒数 (默认60)\n"
+                       "- max_inflight: WiFi连接未确认消息上限 (默认8，最大32)\n"
+                       "- transport: auto/wifi/modem (默认auto)\n";
+
+    help.ruleExample = "转发规则示例:\n"
+                      "1. 基本配置:\n"
+                      "   {\"broker\":\"mqtt.example.com\",\"topic\":\"sms/relay-01\"}\n\n"
+                      "2. TLS与认证:\n"
+                      "   {\"broker\":\"mqtts://mqtt.example.com\",\"username\":\"relay\",\"password\":\"secret\",\"client_id\":\"relay-01\"}\n\n"
+                      "3. 按发送方分主题并只走模块:\n"
+                      "   {\"broker\":\"mqtt.example.com\",\"topic\":\"sms/relay-01/{sender}\",\"transport\":\"modem\"}";
+
+    help.troubleshooting = "常见问题解决:\n"
+                          "1. 连接超时: 检查服务器地址与端口，WiFi或模块数据连接是否可用\n"
+                          "2. 模块连接失败: 确认模块固件支持AT+CMQTT命令\n"
+                          "3. 多台设备互相踢下线: client_id重复，为每台设备设置不同的client_id\n"
+                          "4. 等待PUBACK超时: 服务器处理过慢，可调大max_inflight\n"
+                          "5. 格式错误: 确保配置为有效的JSON格式，主题不能包含#或+";
+
+    return help;
+}
+
+/**
+ * @brief 解析服务器地址
+ * @param broker 服务器地址
+ * @param endpoint 输出：host、port与tls
+ * @return bool 地址是否有效
+ */
+bool MqttChannel::parseBroker(const String& broker, MqttEndpoint& endpoint) {
+    String address = broker;
+    address.trim();
+    if (address.isEmpty()) {
+        setError("MQTT配置缺少broker");
+        return false;
+    }
+
+    if (address.startsWith("mqtts://")) {
+        endpoint.tls = true;
+        address = address.substring(8);
+    } else if (address.startsWith("mqtt://")) {
+        address = address.substring(7);
+    } else if (address.indexOf("://") != -1) {
+        setError("MQTT服务器地址格式不正确，应以mqtt://或mqtts://开头");
+        return false;
+    }
+
+    int slashIndex = address.indexOf('/');
+    if (slashIndex != -1) {
+        address = address.substring(0, slashIndex);
+    }
+    int colonIndex = address.lastIndexOf(':');
+    if (colonIndex != -1) {
+        long port = address.substring(colonIndex + 1).toInt();
+        if (port <= 0 || port > 65535) {
+            setError("MQTT服务器端口无效: " + broker);
+            return false;
+        }
+        endpoint.port = (uint16_t)port;
+        address = address.substring(0, colonIndex);
+    }
+    if (address.isEmpty()) {
+        setError("MQTT服务器地址为空: " + broker);
+        return false;
+    }
+
+    endpoint.host = address;
+    return true;
+}
+
+/**
+ * @brief 生成默认客户端ID
+ * @return String 客户端ID
+ */
+String MqttChannel::defaultClientId() {
+    char clientId[24];
+    uint64_t mac = ESP.getEfuseMac();
+    // 低字节在前，取MAC地址后3个字节
+    snprintf(clientId, sizeof(clientId), "sms-relay-%02x%02x%02x",
+             (unsigned)((mac >> 24) & 0xff), (unsigned)((mac >> 32) & 0xff), (unsigned)((mac >> 40) & 0xff));
+    return String(clientId);
+}
+
+// 自动注册MQTT渠道
+REGISTER_PUSH_CHANNEL("mqtt", MqttChannel, (std::vector<String>{"mqtt", "mqtts", "broker"}));
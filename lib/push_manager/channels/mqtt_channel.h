@@ -0,0 +1,137 @@
+/**
+ * @file mqtt_channel.h
+ * @brief MQTT推送渠道实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该文件实现MQTT推送功能：每条短信以QoS1发布一条消息，
+ * 连接由MqttSessionManager长期保持，不再为每条消息建立连接
+ */
+
+#ifndef MQTT_CHANNEL_H
+#define MQTT_CHANNEL_H
+
+#include "../push_channel_base.h"
+#include "../push_channel_registry.h"
+#include "../mqtt_session.h"
+#include <map>
+
+/**
+ * @struct MqttConfig
+ * @brief MQTT渠道的类型化配置
+ */
+struct MqttConfig : public PushChannelConfig {
+    MqttEndpoint endpoint;                  ///< 连接参数
+    String transportName;                   ///< 传输方式名称（用于日志）
+    CompiledTemplate topicTemplate;         ///< 预编译的主题模板
+    CompiledTemplate payloadTemplate;       ///< 预编译的载荷模板（未配置时为默认JSON模板）
+};
+
+/**
+ * @class MqttChannel
+ * @brief MQTT推送渠道类
+ *
+ * 通过WiFi或模块TCP协议栈向MQTT服务器发布短信，适合集中汇聚多台设备的消息
+ */
+class MqttChannel : public PushChannelBase {
+public:
+    /**
+     * @brief 构造函数
+     */
+    MqttChannel();
+
+    /**
+     * @brief 析构函数
+     */
+    virtual ~MqttChannel();
+
+    /**
+     * @brief 获取渠道名称
+     * @return String 渠道名称
+     */
+    String getChannelName() const override;
+
+    /**
+     * @brief 获取渠道描述
+     * @return String 渠道描述
+     */
+    String getChannelDescription() const override;
+
+    /**
+     * @brief 执行推送
+     * @param config 推送配置（JSON格式）
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult push(const String& config, const PushContext& context) override;
+
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+     */
+    std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) override;
+
+    /**
+     * @brief 使用预解析的配置执行推送
+     * @param config 由prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) override;
+
+    /**
+     * @brief 测试推送配置
+     * @param config 推送配置（JSON格式）
+     * @param testMessage 测试消息
+     * @return PushResult 推送结果
+     */
+    PushResult testConfig(const String& config, const String& testMessage = "测试消息") override;
+
+    /**
+     * @brief 获取配置示例
+     * @return PushChannelExample 配置示例
+     */
+    PushChannelExample getConfigExample() const override;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const override;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable) override;
+
+    /**
+     * @brief 获取CLI演示代码
+     * @return String CLI演示代码
+     */
+    String getCliDemo() const override;
+
+    /**
+     * @brief 获取渠道帮助信息
+     * @return PushChannelHelp 帮助信息
+     */
+    PushChannelHelp getHelp() const override;
+
+private:
+    /**
+     * @brief 解析服务器地址（"host"、"mqtt://host:port"或"mqtts://host:port"）
+     * @param broker 服务器地址
+     * @param endpoint 输出：host、port与tls（端口与TLS未在地址中给出时保持原值）
+     * @return bool 地址是否有效
+     */
+    bool parseBroker(const String& broker, MqttEndpoint& endpoint);
+
+    /**
+     * @brief 生成默认客户端ID（"sms-relay-"加MAC地址后6位）
+     * @return String 客户端ID
+     */
+    static String defaultClientId();
+};
+
+#endif // MQTT_CHANNEL_H
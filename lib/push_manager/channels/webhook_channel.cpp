@@ -47,16 +47,43 @@ String WebhookChannel::getChannelDescription() const {
  * @return PushResult 推送结果
  */
 PushResult WebhookChannel::push(const String& config, const PushContext& context) {
+    std::shared_ptr<const PushChannelConfig> prepared = prepareConfig(config);
+    if (!prepared) {
+        return PUSH_CONFIG_ERROR;
+    }
+    
+    return pushPrepared(*prepared, context);
+}
+
+/**
+ * @brief 解析并校验推送配置
+ * @param config 推送配置（JSON格式）
+ * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+ */
+std::shared_ptr<const PushChannelConfig> WebhookChannel::prepareConfig(const String& config) {
     std::map<String, String> configMap = parseConfig(config);
     
     if (!validateConfig(configMap)) {
-        return PUSH_CONFIG_ERROR;
+        return nullptr;
     }
     
-    String webhookUrl = configMap["webhook_url"];
-    String method = configMap["method"];
-    if (method.isEmpty()) {
-        method = "POST";
+    std::shared_ptr<WebhookConfig> prepared = std::make_shared<WebhookConfig>();
+    prepared->webhookUrl = configMap["webhook_url"];
+    
+    prepared->methodName = configMap["method"];
+    if (prepared->methodName.isEmpty()) {
+        prepared->methodName = "POST";
+    }
+    
+    if (prepared->methodName.equalsIgnoreCase("POST")) {
+        prepared->method = HTTP_CLIENT_POST;
+    } else if (prepared->methodName.equalsIgnoreCase("PUT")) {
+        prepared->method = HTTP_CLIENT_PUT;
+    } else if (prepared->methodName.equalsIgnoreCase("GET")) {
+        prepared->method = HTTP_CLIENT_GET;
+    } else {
+        setError("不支持的HTTP方法: " + prepared->methodName + "，仅支持POST、GET和PUT");
+        return nullptr;
     }
     
     String contentType = configMap["content_type"];
@@ -70,46 +97,60 @@ PushResult WebhookChannel::push(const String& config, const PushContext& context
         // 使用默认JSON模板
         bodyTemplate = "{\"sender\":\"{sender}\",\"content\":\"{content}\",\"timestamp\":\"{timestamp}\"}";
     }
-    
-    String messageBody = applyTemplate(bodyTemplate, context, true); // Webhook需要JSON转义
+    prepared->bodyTemplate.compile(bodyTemplate);
     
     // 设置请求头
-    std::map<String, String> headers;
-    headers["Content-Type"] = contentType;
+    prepared->headers["Content-Type"] = contentType;
     
     // 添加自定义头部
     String customHeaders = configMap["headers"];
     if (!customHeaders.isEmpty()) {
         std::map<String, String> customHeadersMap = parseCustomHeaders(customHeaders);
         for (const auto& header : customHeadersMap) {
-            headers[header.first] = header.second;
+            prepared->headers[header.first] = header.second;
         }
     }
     
-    debugPrint("推送到Webhook: " + webhookUrl);
-    debugPrint("方法: " + method + ", 内容类型: " + contentType);
-    debugPrint("消息内容: " + messageBody);
+    return prepared;
+}
+
+/**
+ * @brief 使用预解析的配置执行推送
+ * @param config 由prepareConfig()生成的配置
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult WebhookChannel::pushPrepared(const PushChannelConfig& config, const PushContext& context) {
+    const WebhookConfig& webhookConfig = static_cast<const WebhookConfig&>(config);
+    
+    ArenaText messageBody;
+    renderTemplate(messageBody, webhookConfig.bodyTemplate, context, true); // Webhook需要对占位符的值做JSON转义
+    
+    if (debugMode) {
+        debugPrint("推送到Webhook: " + webhookConfig.webhookUrl);
+        debugPrint("方法: " + webhookConfig.methodName + ", 内容类型: " + webhookConfig.headers.at("Content-Type"));
+        debugPrint("消息内容: " + messageBody.toString());
+    }
     
     // 发送HTTP请求
     HttpClient& httpClient = HttpClient::getInstance();
     HttpResponse response;
     
     HttpRequest httpRequest;
-    httpRequest.url = webhookUrl;
-    httpRequest.headers = headers;
+    httpRequest.url = webhookConfig.webhookUrl;
+    httpRequest.method = webhookConfig.method;
+    httpRequest.headers = webhookConfig.headers;
     httpRequest.timeout = DEFAULT_HTTP_TIMEOUT_MS;
-
-    if (method.equalsIgnoreCase("POST")) {
-        httpRequest.method = HTTP_CLIENT_POST;
-        httpRequest.body = messageBody;
-    } else if (method.equalsIgnoreCase("PUT")) {
-        httpRequest.method = HTTP_CLIENT_PUT;
-        httpRequest.body = messageBody;
-    } else if (method.equalsIgnoreCase("GET")) {
-        httpRequest.method = HTTP_CLIENT_GET;
-    } else {
-        setError("不支持的HTTP方法: " + method + "，仅支持POST、GET和PUT");
-        return PUSH_CONFIG_ERROR;
+    if (webhookConfig.method != HTTP_CLIENT_GET) {
+        // 请求体留在内存区中按块写出，不复制为String
+        const char* body = messageBody.c_str();
+        size_t bodyLength = messageBody.length();
+        httpRequest.bodyLength = bodyLength;
+        httpRequest.bodyWriter = [body, bodyLength](size_t offset, uint8_t* buffer, size_t capacity) -> size_t {
+            size_t count = bodyLength - offset < capacity ? bodyLength - offset : capacity;
+            memcpy(buffer, body + offset, count);
+            return count;
+        };
     }
 
     response = httpClient.request(httpRequest);
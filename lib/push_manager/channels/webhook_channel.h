@@ -12,6 +12,20 @@
 
 #include "../push_channel_base.h"
 #include "../push_channel_registry.h"
+#include "../http_client/http_client.h"
+#include <map>
+
+/**
+ * @struct WebhookConfig
+ * @brief 通用Webhook渠道的类型化配置
+ */
+struct WebhookConfig : public PushChannelConfig {
+    String webhookUrl;                      ///< 目标地址
+    HttpClientMethod method;                ///< 请求方法（POST/PUT/GET）
+    String methodName;                      ///< 请求方法名称（用于日志）
+    CompiledTemplate bodyTemplate;          ///< 预编译的请求体模板（未配置时为默认JSON模板）
+    std::map<String, String> headers;       ///< 请求头（含Content-Type与自定义头部）
+};
 
 /**
  * @class WebhookChannel
@@ -51,6 +65,21 @@ public:
      */
     PushResult push(const String& config, const PushContext& context) override;
 
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+     */
+    std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) override;
+
+    /**
+     * @brief 使用预解析的配置执行推送
+     * @param config 由prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) override;
+
     /**
      * @brief 测试推送配置
      * @param config 推送配置（JSON格式）
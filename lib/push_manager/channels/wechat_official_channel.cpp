@@ -7,6 +7,7 @@
 
 #include "wechat_official_channel.h"
 #include "../push_channel_registry.h"
+#include "../access_token_cache.h"
 #include "../../http_client/http_client.h"
 #include "../../../include/constants.h"
 #include <ArduinoJson.h>
@@ -16,7 +17,7 @@
  */
 WechatOfficialChannel::WechatOfficialChannel() {
     debugMode = false;
-    tokenExpireTime = 0;
+    tokenRejected = false;
 }
 
 /**
@@ -48,46 +49,75 @@ String WechatOfficialChannel::getChannelDescription() const {
  * @return PushResult 推送结果
  */
 PushResult WechatOfficialChannel::push(const String& config, const PushContext& context) {
-    std::map<String, String> configMap = parseConfig(config);
-    
-    if (!validateConfig(configMap)) {
+    std::shared_ptr<const PushChannelConfig> prepared = prepareConfig(config);
+    if (!prepared) {
         return PUSH_CONFIG_ERROR;
     }
     
-    String appId = configMap["app_id"];
-    String appSecret = configMap["app_secret"];
-    String openIds = configMap["open_ids"];
+    return pushPrepared(*prepared, context);
+}
+
+/**
+ * @brief 解析并校验推送配置
+ * @param config 推送配置（JSON格式）
+ * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+ */
+std::shared_ptr<const PushChannelConfig> WechatOfficialChannel::prepareConfig(const String& config) {
+    std::map<String, String> configMap = parseConfig(config);
     
-    // 获取access_token
-    String accessToken = getAccessToken(appId, appSecret);
-    if (accessToken.isEmpty()) {
-        setError("获取微信公众号access_token失败");
-        return PUSH_NETWORK_ERROR;
+    if (!validateConfig(configMap)) {
+        return nullptr;
     }
     
-    debugPrint("获取到access_token: " + accessToken.substring(0, 20) + "...");
+    std::shared_ptr<WechatOfficialConfig> prepared = std::make_shared<WechatOfficialConfig>();
+    prepared->appId = configMap["app_id"];
+    prepared->appSecret = configMap["app_secret"];
     
     // 解析openid列表
-    std::vector<String> openIdList = parseOpenIds(openIds);
-    if (openIdList.empty()) {
+    prepared->openIds = parseOpenIds(configMap["open_ids"]);
+    if (prepared->openIds.empty()) {
         setError("openid列表为空");
-        return PUSH_CONFIG_ERROR;
+        return nullptr;
     }
     
     // 获取模板ID（必需）
-    String templateId = configMap["template_id"];
-    if (templateId.isEmpty()) {
+    prepared->templateId = configMap["template_id"];
+    if (prepared->templateId.isEmpty()) {
         setError("模板ID不能为空，微信公众号推送仅支持模板消息");
-        return PUSH_CONFIG_ERROR;
+        return nullptr;
     }
     
+    return prepared;
+}
+
+/**
+ * @brief 使用预解析的配置执行推送
+ * @param config 由prepareConfig()生成的配置
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult WechatOfficialChannel::pushPrepared(const PushChannelConfig& config, const PushContext& context) {
+    const WechatOfficialConfig& wechatConfig = static_cast<const WechatOfficialConfig&>(config);
+    
+    // 获取access_token
+    tokenRejected = false;
+    String accessToken = getAccessToken(wechatConfig.appId, wechatConfig.appSecret);
+    if (accessToken.isEmpty()) {
+        setError("获取微信公众号access_token失败");
+        return PUSH_NETWORK_ERROR;
+    }
+    
+    debugPrint("获取到access_token: " + accessToken.substring(0, 20) + "...");
+    
     int successCount = 0;
-    int totalCount = openIdList.size();
+    int totalCount = wechatConfig.openIds.size();
+    
+    // 模板数据只与短信内容有关，所有接收者共用
+    String templateData = buildTemplateData(context);
     
-    for (const String& openId : openIdList) {
+    for (const String& openId : wechatConfig.openIds) {
         // 发送模板消息
-        String templateData = buildTemplateData(context);
-        bool success = sendTemplateMessage(accessToken, openId, templateId, templateData, "");
+        bool success = sendTemplateMessage(accessToken, openId, wechatConfig.templateId, templateData, "");
         debugPrint("向 " + openId + " 发送模板消息: " + (success ? "成功" : "失败"));
         
         if (success) {
@@ -102,6 +132,11 @@ PushResult WechatOfficialChannel::push(const String& config, const PushContext&
     
     debugPrint("推送完成，成功: " + String(successCount) + "/" + String(totalCount));
     
+    // 缓存的令牌被拒绝时丢弃，发件箱重试时会重新获取
+    if (tokenRejected) {
+        AccessTokenCache::getInstance().invalidate("wechat:" + wechatConfig.appId);
+    }
+    
     if (successCount == 0) {
         setError("所有用户推送失败");
         return PUSH_FAILED;
@@ -276,62 +311,71 @@ bool WechatOfficialChannel::validateConfig(const std::map<String, String>& confi
  * @return String access_token，失败返回空字符串
  */
 String WechatOfficialChannel::getAccessToken(const String& appId, const String& appSecret) {
-    // 检查缓存的token是否有效
-    if (!cachedAccessToken.isEmpty() && millis() < tokenExpireTime) {
-        debugPrint("使用缓存的access_token");
-        return cachedAccessToken;
-    }
+    // 令牌按appId缓存在渠道实例之外，由定时任务在过期前刷新
+    AccessTokenCache& tokenCache = AccessTokenCache::getInstance();
+    String accessToken = tokenCache.getToken("wechat:" + appId,
+        [appId, appSecret](String& token, uint32_t& expiresIn, String& error) {
+            return requestAccessToken(appId, appSecret, token, expiresIn, error);
+        });
     
+    if (accessToken.isEmpty()) {
+        setError(tokenCache.getLastError());
+    }
+    return accessToken;
+}
+
+/**
+ * @brief 向微信接口请求新的access_token
+ * @param appId 应用ID
+ * @param appSecret 应用密钥
+ * @param token 输出：access_token
+ * @param expiresIn 输出：有效期（秒）
+ * @param error 输出：失败原因
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+bool WechatOfficialChannel::requestAccessToken(const String& appId, const String& appSecret,
+                                               String& token, uint32_t& expiresIn, String& error) {
     String url = "https://api.weixin.qq.com/cgi-bin/token?grant_type=client_credential&appid=" + appId + "&secret=" + appSecret;
     
-    debugPrint("获取access_token: " + url);
-    
     HttpClient& httpClient = HttpClient::getInstance();
     HttpRequest request;
     request.url = url;
     request.method = HTTP_CLIENT_GET;
     request.timeout = DEFAULT_HTTP_TIMEOUT_MS;
+    request.maxBodyBytes = PUSH_RESPONSE_MAX_BYTES;
     HttpResponse response = httpClient.request(request);
     
-    debugPrint("access_token响应 - 状态码: " + String(response.statusCode));
-    debugPrint("响应内容: " + response.body);
-    
     if (response.statusCode != 200) {
-        setError("获取access_token失败，HTTP状态码: " + String(response.statusCode));
-        return "";
+        error = "获取access_token失败，HTTP状态码: " + String(response.statusCode);
+        return false;
     }
     
-    // 解析JSON响应
+    // 只解析需要的字段
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response.body);
+    DeserializationError jsonError = parseResponseFields(response.body,
+                                                         {"errcode", "errmsg", "access_token", "expires_in"}, doc);
     
-    if (error) {
-        setError("解析access_token响应失败: " + String(error.c_str()));
-        return "";
+    if (jsonError) {
+        error = "解析access_token响应失败: " + String(jsonError.c_str());
+        return false;
     }
     
     if (doc["errcode"].is<int>()) {
         int errcode = doc["errcode"];
         String errmsg = doc["errmsg"].as<String>();
-        setError("微信API错误: " + String(errcode) + " - " + errmsg);
-        return "";
+        error = "微信API错误: " + String(errcode) + " - " + errmsg;
+        return false;
     }
     
     if (!doc["access_token"].is<String>()) {
-        setError("响应中未找到access_token");
-        return "";
+        error = "响应中未找到access_token";
+        return false;
     }
     
-    String accessToken = doc["access_token"].as<String>();
-    int expiresIn = doc["expires_in"].as<int>();
-    
-    // 缓存token，提前5分钟过期
-    cachedAccessToken = accessToken;
-    tokenExpireTime = millis() + (expiresIn - 300) * 1000;
-    
-    debugPrint("获取access_token成功，有效期: " + String(expiresIn) + "秒");
-    
-    return accessToken;
+    token = doc["access_token"].as<String>();
+    expiresIn = doc["expires_in"].as<uint32_t>();
+    return true;
 }
 
 /**
@@ -375,7 +419,14 @@ bool WechatOfficialChannel::sendTemplateMessage(const String& accessToken, const
     headers["Content-Type"] = "application/json";
     
     HttpClient& httpClient = HttpClient::getInstance();
-    HttpResponse response = httpClient.post(apiUrl, requestBody, headers, DEFAULT_HTTP_TIMEOUT_MS);
+    HttpRequest request;
+    request.url = apiUrl;
+    request.method = HTTP_CLIENT_POST;
+    request.headers = headers;
+    request.body = requestBody;
+    request.maxBodyBytes = PUSH_RESPONSE_MAX_BYTES;
+    request.timeout = DEFAULT_HTTP_TIMEOUT_MS;
+    HttpResponse response = httpClient.request(request);
     
     debugPrint("模板消息响应 - 状态码: " + String(response.statusCode));
     debugPrint("响应内容: " + response.body);
@@ -385,9 +436,9 @@ bool WechatOfficialChannel::sendTemplateMessage(const String& accessToken, const
         return false;
     }
     
-    // 解析响应
+    // 只解析errcode与errmsg
     JsonDocument responseDoc;
-    error = deserializeJson(responseDoc, response.body);
+    error = parseResponseFields(response.body, {"errcode", "errmsg"}, responseDoc);
     
     if (error) {
         setError("解析模板消息响应失败: " + String(error.c_str()));
@@ -396,6 +447,10 @@ bool WechatOfficialChannel::sendTemplateMessage(const String& accessToken, const
     
     int errcode = responseDoc["errcode"].as<int>();
     if (errcode != 0) {
+        // 40001/40014/42001: access_token无效或已过期（如在其他地方被刷新）
+        if (errcode == 40001 || errcode == 40014 || errcode == 42001) {
+            tokenRejected = true;
+        }
         String errmsg = responseDoc["errmsg"].as<String>();
         setError("模板消息发送失败: " + String(errcode) + " - " + errmsg);
         return false;
@@ -15,6 +15,17 @@
 #include <map>
 #include <vector>
 
+/**
+ * @struct WechatOfficialConfig
+ * @brief 微信公众号渠道的类型化配置
+ */
+struct WechatOfficialConfig : public PushChannelConfig {
+    String appId;                   ///< 公众号AppID
+    String appSecret;               ///< 公众号AppSecret
+    std::vector<String> openIds;    ///< 接收用户openid列表（已拆分）
+    String templateId;              ///< 模板消息ID
+};
+
 /**
  * @class WechatOfficialChannel
  * @brief 微信公众号推送渠道类
@@ -56,6 +67,21 @@ public:
      */
     PushResult push(const String& config, const PushContext& context) override;
 
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+     */
+    std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) override;
+
+    /**
+     * @brief 使用预解析的配置执行推送
+     * @param config 由prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) override;
+
     /**
      * @brief 测试推送配置
      * @param config 推送配置（JSON格式）
@@ -103,13 +129,26 @@ private:
     bool validateConfig(const std::map<String, String>& configMap);
 
     /**
-     * @brief 获取微信公众号access_token
+     * @brief 获取微信公众号access_token（经共享的令牌缓存）
      * @param appId 应用ID
      * @param appSecret 应用密钥
      * @return String access_token，失败返回空字符串
      */
     String getAccessToken(const String& appId, const String& appSecret);
 
+    /**
+     * @brief 向微信接口请求新的access_token（供令牌缓存调用，不依赖渠道实例）
+     * @param appId 应用ID
+     * @param appSecret 应用密钥
+     * @param token 输出：access_token
+     * @param expiresIn 输出：有效期（秒）
+     * @param error 输出：失败原因
+     * @return true 获取成功
+     * @return false 获取失败
+     */
+    static bool requestAccessToken(const String& appId, const String& appSecret,
+                                   String& token, uint32_t& expiresIn, String& error);
+
     /**
      * @brief 发送模板消息
      * @param accessToken 访问令牌
@@ -182,9 +221,7 @@ private:
 private:
     String lastError;            ///< 最后的错误信息
     bool debugMode;              ///< 调试模式
-    String cachedAccessToken;    ///< 缓存的access_token
-    unsigned long tokenExpireTime; ///< token过期时间
-    static const unsigned long TOKEN_CACHE_DURATION = 7000000; ///< token缓存时长（毫秒，约2小时）
+    bool tokenRejected;          ///< 本次推送中接口是否返回access_token无效
     static const int WECHAT_TEMPLATE_CONTENT_MAX_LENGTH = 180; ///< 微信模板消息内容最大长度（预留20字符给其他模板内容）
 };
 
@@ -47,13 +47,28 @@ String WecomChannel::getChannelDescription() const {
  * @return PushResult 推送结果
  */
 PushResult WecomChannel::push(const String& config, const PushContext& context) {
+    std::shared_ptr<const PushChannelConfig> prepared = prepareConfig(config);
+    if (!prepared) {
+        return PUSH_CONFIG_ERROR;
+    }
+    
+    return pushPrepared(*prepared, context);
+}
+
+/**
+ * @brief 解析并校验推送配置
+ * @param config 推送配置（JSON格式）
+ * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+ */
+std::shared_ptr<const PushChannelConfig> WecomChannel::prepareConfig(const String& config) {
     std::map<String, String> configMap = parseConfig(config);
     
     if (!validateConfig(configMap)) {
-        return PUSH_CONFIG_ERROR;
+        return nullptr;
     }
     
-    String webhookUrl = configMap["webhook_url"];
+    std::shared_ptr<WecomConfig> prepared = std::make_shared<WecomConfig>();
+    prepared->webhookUrl = configMap["webhook_url"];
     
     // 获取消息模板
     String messageTemplate = configMap["template"];
@@ -61,34 +76,100 @@ PushResult WecomChannel::push(const String& config, const PushContext& context)
         // 使用默认模板
         messageTemplate = "📱 收到新短信\n\n📞 发送方: {sender}\n🕐 时间: {timestamp}\n📄 内容: {content}";
     }
+    prepared->messageTemplate.compile(messageTemplate);
+    
+    // 获取消息类型
+    prepared->msgType = configMap["msg_type"];
+    if (prepared->msgType.isEmpty()) {
+        prepared->msgType = "text";
+    }
     
-    String message = applyTemplate(messageTemplate, context);
+    return prepared;
+}
+
+/**
+ * @brief 使用预解析的配置执行推送
+ * @param config 由prepareConfig()生成的配置
+ * @param context 推送上下文
+ * @return PushResult 推送结果
+ */
+PushResult WecomChannel::pushPrepared(const PushChannelConfig& config, const PushContext& context) {
+    const WecomConfig& wecomConfig = static_cast<const WecomConfig&>(config);
+    
+    ArenaText message;
+    renderTemplate(message, wecomConfig.messageTemplate, context);
     
     // 如果没有配置webhook_url，则只进行本地文字处理
-    if (webhookUrl.isEmpty()) {
-        debugPrint("企业微信纯文字模式 - 消息内容: " + message);
+    if (wecomConfig.webhookUrl.isEmpty()) {
+        if (debugMode) {
+            debugPrint("企业微信纯文字模式 - 消息内容: " + message.toString());
+        }
         debugPrint("✅ 企业微信纯文字处理成功");
         return PUSH_SUCCESS;
     }
     
-    // 获取消息类型
-    String msgType = configMap["msg_type"];
-    if (msgType.isEmpty()) {
-        msgType = "text";
-    }
+    ArenaText messageBody;
+    buildMessageBody(messageBody, message.c_str(), wecomConfig.msgType);
     
-    String messageBody = buildMessageBody(message, msgType);
+    return postMessage(wecomConfig.webhookUrl, messageBody);
+}
+
+/**
+ * @brief 渠道是否支持汇总推送
+ * @return true 支持
+ */
+bool WecomChannel::supportsDigest() const {
+    return true;
+}
+
+/**
+ * @brief 推送多条短信的汇总消息（始终以markdown发送）
+ * @param config 由prepareConfig()生成的配置
+ * @param title 汇总标题
+ * @param body 汇总正文
+ * @return PushResult 推送结果
+ */
+PushResult WecomChannel::pushDigest(const PushChannelConfig& config, const String& title, const String& body) {
+    const WecomConfig& wecomConfig = static_cast<const WecomConfig&>(config);
+    
+    ArenaText message;
+    message.concat("### ");
+    message.concat(title);
+    message.concat("\n\n");
+    message.concat(body);
     
+    if (wecomConfig.webhookUrl.isEmpty()) {
+        if (debugMode) {
+            debugPrint("企业微信纯文字模式 - 汇总内容: " + message.toString());
+        }
+        return PUSH_SUCCESS;
+    }
+    
+    ArenaText messageBody;
+    buildMessageBody(messageBody, message.c_str(), "markdown");
+    return postMessage(wecomConfig.webhookUrl, messageBody);
+}
+
+/**
+ * @brief 发送消息体到企业微信机器人
+ * @param webhookUrl Webhook地址
+ * @param messageBody JSON消息体
+ * @return PushResult 推送结果
+ */
+PushResult WecomChannel::postMessage(const String& webhookUrl, const ArenaText& messageBody) {
     // 设置请求头
     std::map<String, String> headers;
     headers["Content-Type"] = "application/json";
     
-    debugPrint("推送到企业微信: " + webhookUrl);
-    debugPrint("消息内容: " + messageBody);
+    if (debugMode) {
+        debugPrint("推送到企业微信: " + webhookUrl);
+        debugPrint("消息内容: " + messageBody.toString());
+    }
     
-    // 发送HTTP请求
+    // 发送HTTP请求（只凭状态码判断结果，响应体仅在调试时读取）
     HttpClient& httpClient = HttpClient::getInstance();
-    HttpResponse response = httpClient.post(webhookUrl, messageBody, headers, DEFAULT_HTTP_TIMEOUT_MS);
+    HttpResponse response = httpClient.post(webhookUrl, messageBody.c_str(), messageBody.length(), headers,
+                                            DEFAULT_HTTP_TIMEOUT_MS, debugMode);
     
     debugPrint("企业微信响应 - 状态码: " + String(response.statusCode) + ", 错误码: " + String(response.error));
     debugPrint("响应内容: " + response.body);
@@ -248,12 +329,12 @@ bool WecomChannel::validateConfig(const std::map<String, String>& configMap) {
 
 /**
  * @brief 构建企业微信消息体
+ * @param output 输出的JSON消息体
  * @param message 消息内容
  * @param msgType 消息类型（text/markdown）
- * @return String JSON消息体
  */
-String WecomChannel::buildMessageBody(const String& message, const String& msgType) {
-    JsonDocument doc;
+void WecomChannel::buildMessageBody(ArenaText& output, const char* message, const String& msgType) {
+    JsonDocument doc(ArenaJsonAllocator::instance());
     doc["msgtype"] = msgType;
     
     if (msgType == "markdown") {
@@ -262,10 +343,7 @@ String WecomChannel::buildMessageBody(const String& message, const String& msgTy
         doc["text"]["content"] = message;
     }
     
-    String messageBody;
-    serializeJson(doc, messageBody);
-    
-    return messageBody;
+    serializeJson(doc, output);
 }
 
 // 自动注册企业微信渠道
@@ -13,6 +13,16 @@
 #include "../push_channel_base.h"
 #include "../push_channel_registry.h"
 
+/**
+ * @struct WecomConfig
+ * @brief 企业微信渠道的类型化配置
+ */
+struct WecomConfig : public PushChannelConfig {
+    String webhookUrl;          ///< 机器人Webhook地址（为空时仅做本地文字处理）
+    CompiledTemplate messageTemplate; ///< 预编译的消息模板（未配置时为默认模板）
+    String msgType;             ///< 消息类型（text/markdown）
+};
+
 /**
  * @class WechatChannel
  * @brief 企业微信推送渠道类
@@ -51,6 +61,36 @@ public:
      */
     PushResult push(const String& config, const PushContext& context) override;
 
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr
+     */
+    std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) override;
+
+    /**
+     * @brief 使用预解析的配置执行推送
+     * @param config 由prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) override;
+
+    /**
+     * @brief 渠道是否支持汇总推送
+     * @return true 支持
+     */
+    bool supportsDigest() const override;
+
+    /**
+     * @brief 推送多条短信的汇总消息
+     * @param config 由prepareConfig()生成的配置
+     * @param title 汇总标题
+     * @param body 汇总正文（Markdown）
+     * @return PushResult 推送结果
+     */
+    PushResult pushDigest(const PushChannelConfig& config, const String& title, const String& body) override;
+
     /**
      * @brief 测试推送配置
      * @param config 推送配置（JSON格式）
@@ -99,11 +139,19 @@ private:
 
     /**
      * @brief 构建企业微信消息体
+     * @param output 输出的JSON消息体
      * @param message 消息内容
      * @param msgType 消息类型（text/markdown）
-     * @return String JSON消息体
      */
-    String buildMessageBody(const String& message, const String& msgType = "text");
+    void buildMessageBody(ArenaText& output, const char* message, const String& msgType = "text");
+
+    /**
+     * @brief 发送消息体到企业微信机器人
+     * @param webhookUrl Webhook地址
+     * @param messageBody JSON消息体
+     * @return PushResult 推送结果
+     */
+    PushResult postMessage(const String& webhookUrl, const ArenaText& messageBody);
 };
 
 #endif // WECOM_CHANNEL_H
\ No newline at end of file
@@ -0,0 +1,218 @@
+/**
+ * @file hmac_sign_cache.cpp
+ * @brief 机器人签名缓存实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "hmac_sign_cache.h"
+#include <mbedtls/version.h>
+#include <mbedtls/base64.h>
+#include <string.h>
+
+// mbedtls 3.x去掉了_ret后缀（arduino-esp32 2.x使用的是2.28）
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#define HMAC_SHA256_STARTS mbedtls_sha256_starts
+#define HMAC_SHA256_UPDATE mbedtls_sha256_update
+#define HMAC_SHA256_FINISH mbedtls_sha256_finish
+#define HMAC_SHA256 mbedtls_sha256
+#else
+#define HMAC_SHA256_STARTS mbedtls_sha256_starts_ret
+#define HMAC_SHA256_UPDATE mbedtls_sha256_update_ret
+#define HMAC_SHA256_FINISH mbedtls_sha256_finish_ret
+#define HMAC_SHA256 mbedtls_sha256_ret
+#endif
+
+/// SHA-256分组长度
+static const size_t SHA256_BLOCK_SIZE = 64;
+
+/**
+ * @brief 获取单例实例
+ * @return HmacSignCache& 单例引用
+ */
+HmacSignCache& HmacSignCache::getInstance() {
+    static HmacSignCache instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+HmacSignCache::HmacSignCache() : useCounter(0) {
+    // 预留全部容量，条目中的摘要状态不会因扩容而搬移
+    entries.reserve(HMAC_SIGN_CACHE_MAX_ENTRIES);
+}
+
+/**
+ * @brief 析构函数
+ */
+HmacSignCache::~HmacSignCache() {
+    for (Entry& entry : entries) {
+        releaseEntry(entry);
+    }
+}
+
+/**
+ * @brief 计算Base64编码的签名（未做URL编码）
+ * @param scheme 签名方式
+ * @param secret 密钥
+ * @param timestamp 秒级Unix时间戳
+ * @param output 输出缓冲区
+ * @return true 签名成功
+ * @return false 密钥过长或摘要计算失败
+ */
+bool HmacSignCache::sign(HmacSignScheme scheme, const String& secret, time_t timestamp,
+                         char (&output)[HMAC_SIGN_TEXT_SIZE]) {
+    output[0] = '\0';
+    if (secret.length() > HMAC_SIGN_MAX_SECRET_LENGTH) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = acquireEntry(scheme, secret);
+    entry.lastUsed = ++useCounter;
+
+    if (entry.signedAt == timestamp && entry.signature[0] != '\0') {
+        memcpy(output, entry.signature, sizeof(output));
+        return true;
+    }
+
+    // 时间戳最多20位，加上换行符与密钥
+    char text[HMAC_SIGN_MAX_SECRET_LENGTH + 24];
+    uint8_t digest[32];
+    bool ok = false;
+
+    if (scheme == HMAC_SIGN_DINGTALK) {
+        // 密钥固定，内外层状态只在首次使用该密钥时计算
+        if (!entry.keyed) {
+            entry.keyed = prepareKey(entry, (const uint8_t*)secret.c_str(), secret.length());
+        }
+        int length = snprintf(text, sizeof(text), "%lld000\n%s", (long long)timestamp, secret.c_str());
+        ok = entry.keyed && finishHmac(entry, (const uint8_t*)text, length, digest);
+    } else {
+        // 飞书的密钥含时间戳，每秒都要重新计算内外层状态，只能复用同一秒内的签名
+        int length = snprintf(text, sizeof(text), "%lld\n%s", (long long)timestamp, secret.c_str());
+        ok = prepareKey(entry, (const uint8_t*)text, length) && finishHmac(entry, nullptr, 0, digest);
+    }
+
+    size_t encodedLength = 0;
+    if (!ok || mbedtls_base64_encode((unsigned char*)entry.signature, sizeof(entry.signature),
+                                     &encodedLength, digest, sizeof(digest)) != 0) {
+        entry.signedAt = 0;
+        entry.signature[0] = '\0';
+        return false;
+    }
+
+    entry.signedAt = timestamp;
+    memcpy(output, entry.signature, sizeof(output));
+    return true;
+}
+
+/**
+ * @brief 查找条目，不存在时占用空位或淘汰最久未用的条目（调用方须持有mutex）
+ * @param scheme 签名方式
+ * @param secret 密钥
+ * @return Entry& 条目
+ */
+HmacSignCache::Entry& HmacSignCache::acquireEntry(HmacSignScheme scheme, const String& secret) {
+    Entry* oldest = nullptr;
+    for (Entry& entry : entries) {
+        if (entry.scheme == scheme && entry.secret == secret) {
+            return entry;
+        }
+        if (oldest == nullptr || entry.lastUsed < oldest->lastUsed) {
+            oldest = &entry;
+        }
+    }
+
+    Entry* target;
+    if (entries.size() < HMAC_SIGN_CACHE_MAX_ENTRIES) {
+        entries.emplace_back();
+        target = &entries.back();
+    } else {
+        releaseEntry(*oldest);
+        target = oldest;
+    }
+
+    target->scheme = scheme;
+    target->secret = secret;
+    target->keyed = false;
+    mbedtls_sha256_init(&target->inner);
+    mbedtls_sha256_init(&target->outer);
+    target->signedAt = 0;
+    target->signature[0] = '\0';
+    target->lastUsed = 0;
+    return *target;
+}
+
+/**
+ * @brief 按密钥预计算内外层状态
+ * @param entry 条目
+ * @param key 密钥
+ * @param keyLength 密钥长度
+ * @return true 成功
+ * @return false 摘要计算失败
+ */
+bool HmacSignCache::prepareKey(Entry& entry, const uint8_t* key, size_t keyLength) {
+    // 超过分组长度的密钥先做一次摘要（RFC 2104）
+    uint8_t hashedKey[32];
+    if (keyLength > SHA256_BLOCK_SIZE) {
+        if (HMAC_SHA256(key, keyLength, hashedKey, 0) != 0) {
+            return false;
+        }
+        key = hashedKey;
+        keyLength = sizeof(hashedKey);
+    }
+
+    uint8_t innerPad[SHA256_BLOCK_SIZE];
+    uint8_t outerPad[SHA256_BLOCK_SIZE];
+    memset(innerPad, 0x36, sizeof(innerPad));
+    memset(outerPad, 0x5c, sizeof(outerPad));
+    for (size_t i = 0; i < keyLength; i++) {
+        innerPad[i] ^= key[i];
+        outerPad[i] ^= key[i];
+    }
+
+    return HMAC_SHA256_STARTS(&entry.inner, 0) == 0 &&
+           HMAC_SHA256_UPDATE(&entry.inner, innerPad, sizeof(innerPad)) == 0 &&
+           HMAC_SHA256_STARTS(&entry.outer, 0) == 0 &&
+           HMAC_SHA256_UPDATE(&entry.outer, outerPad, sizeof(outerPad)) == 0;
+}
+
+/**
+ * @brief 从预计算的状态完成HMAC
+ * @param entry 已预计算的条目
+ * @param data 消息
+ * @param dataLength 消息长度
+ * @param output 输出的32字节摘要
+ * @return true 成功
+ * @return false 摘要计算失败
+ */
+bool HmacSignCache::finishHmac(const Entry& entry, const uint8_t* data, size_t dataLength, uint8_t output[32]) {
+    uint8_t innerHash[32];
+    mbedtls_sha256_context context;
+    mbedtls_sha256_init(&context);
+
+    mbedtls_sha256_clone(&context, &entry.inner);
+    bool ok = (dataLength == 0 || HMAC_SHA256_UPDATE(&context, data, dataLength) == 0) &&
+              HMAC_SHA256_FINISH(&context, innerHash) == 0;
+
+    if (ok) {
+        mbedtls_sha256_clone(&context, &entry.outer);
+        ok = HMAC_SHA256_UPDATE(&context, innerHash, sizeof(innerHash)) == 0 &&
+             HMAC_SHA256_FINISH(&context, output) == 0;
+    }
+
+    mbedtls_sha256_free(&context);
+    return ok;
+}
+
+/**
+ * @brief 释放条目的摘要状态
+ * @param entry 条目
+ */
+void HmacSignCache::releaseEntry(Entry& entry) {
+    mbedtls_sha256_free(&entry.inner);
+    mbedtls_sha256_free(&entry.outer);
+    entry.keyed = false;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file hmac_sign_cache.h
+ * @brief 机器人签名缓存 - 钉钉、飞书等渠道的HMAC-SHA256签名在渠道实例之间共享
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 按密钥缓存HMAC的内外两个SHA-256状态（ipad/opad块已压缩），签名时复制状态后
+ *    只需处理消息本身，不再重复建立摘要上下文与填充密钥
+ * 2. 按（签名方式, 密钥, 秒级时间戳）记忆最近一次的签名，同一秒内的连续推送直接复用
+ * 3. 签名与待签名字符串都写入固定缓冲区，不拼接String
+ *
+ * SHA-256使用mbedtls接口，ESP32-S3上由硬件SHA加速器计算
+ */
+
+#ifndef HMAC_SIGN_CACHE_H
+#define HMAC_SIGN_CACHE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <mutex>
+#include <time.h>
+#include <mbedtls/sha256.h>
+#include "../../include/constants.h"
+
+/**
+ * @enum HmacSignScheme
+ * @brief 签名方式
+ */
+enum HmacSignScheme {
+    HMAC_SIGN_DINGTALK = 0,    ///< 钉钉：密钥为secret，消息为"毫秒时间戳\nsecret"
+    HMAC_SIGN_FEISHU = 1       ///< 飞书：密钥为"秒级时间戳\nsecret"，消息为空
+};
+
+/**
+ * @class HmacSignCache
+ * @brief 机器人签名缓存（线程安全）
+ */
+class HmacSignCache {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return HmacSignCache& 单例引用
+     */
+    static HmacSignCache& getInstance();
+
+    /**
+     * @brief 计算Base64编码的签名（未做URL编码）
+     *
+     * 同一密钥在同一秒内重复签名时直接返回记忆的结果
+     * @param scheme 签名方式
+     * @param secret 密钥
+     * @param timestamp 秒级Unix时间戳
+     * @param output 输出缓冲区（至少HMAC_SIGN_TEXT_SIZE字节）
+     * @return true 签名成功
+     * @return false 密钥过长或摘要计算失败
+     */
+    bool sign(HmacSignScheme scheme, const String& secret, time_t timestamp,
+              char (&output)[HMAC_SIGN_TEXT_SIZE]);
+
+private:
+    /**
+     * @struct Entry
+     * @brief 一个密钥的缓存状态
+     */
+    struct Entry {
+        HmacSignScheme scheme;                  ///< 签名方式
+        String secret;                          ///< 密钥
+        bool keyed;                             ///< inner/outer是否已按密钥预计算
+        mbedtls_sha256_context inner;           ///< 已处理ipad块的内层状态
+        mbedtls_sha256_context outer;           ///< 已处理opad块的外层状态
+        time_t signedAt;                        ///< 记忆签名对应的时间戳（0表示无）
+        char signature[HMAC_SIGN_TEXT_SIZE];    ///< 记忆的签名
+        uint32_t lastUsed;                      ///< 最近使用序号（用于淘汰）
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    HmacSignCache();
+
+    /**
+     * @brief 析构函数
+     */
+    ~HmacSignCache();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    HmacSignCache(const HmacSignCache&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    HmacSignCache& operator=(const HmacSignCache&) = delete;
+
+    /**
+     * @brief 查找条目，不存在时占用空位或淘汰最久未用的条目（调用方须持有mutex）
+     * @param scheme 签名方式
+     * @param secret 密钥
+     * @return Entry& 条目
+     */
+    Entry& acquireEntry(HmacSignScheme scheme, const String& secret);
+
+    /**
+     * @brief 按密钥预计算内外层状态
+     * @param entry 条目
+     * @param key 密钥
+     * @param keyLength 密钥长度
+     * @return true 成功
+     * @return false 摘要计算失败
+     */
+    static bool prepareKey(Entry& entry, const uint8_t* key, size_t keyLength);
+
+    /**
+     * @brief 从预计算的状态完成HMAC
+     * @param entry 已预计算的条目
+     * @param data 消息
+     * @param dataLength 消息长度
+     * @param output 输出的32字节摘要
+     * @return true 成功
+     * @return false 摘要计算失败
+     */
+    static bool finishHmac(const Entry& entry, const uint8_t* data, size_t dataLength, uint8_t output[32]);
+
+    /**
+     * @brief 释放条目的摘要状态
+     * @param entry 条目
+     */
+    static void releaseEntry(Entry& entry);
+
+private:
+    std::vector<Entry> entries;     ///< 缓存条目（最多HMAC_SIGN_CACHE_MAX_ENTRIES个）
+    std::mutex mutex;               ///< 保护entries
+    uint32_t useCounter;            ///< 使用序号
+};
+
+#endif // HMAC_SIGN_CACHE_H
@@ -0,0 +1,255 @@
+/**
+ * @file message_template.cpp
+ * @brief 预编译消息模板实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "message_template.h"
+#include "../message_arena/message_arena.h"
+#include <string.h>
+
+namespace {
+
+/**
+ * @struct PlaceholderEntry
+ * @brief 占位符表项
+ */
+struct PlaceholderEntry {
+    const char* name;       ///< 占位符（含花括号）
+    size_t length;          ///< 占位符长度
+    uint8_t type;           ///< 片段类型
+};
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+CompiledTemplate::CompiledTemplate() : literalLength(0), hasTimestamp(false) {
+}
+
+/**
+ * @brief 构造并编译模板
+ * @param templateStr 模板字符串
+ */
+CompiledTemplate::CompiledTemplate(const String& templateStr) : literalLength(0), hasTimestamp(false) {
+    compile(templateStr);
+}
+
+/**
+ * @brief 编译模板
+ * @param templateStr 模板字符串
+ */
+void CompiledTemplate::compile(const String& templateStr) {
+    static const PlaceholderEntry PLACEHOLDERS[] = {
+        {"{sender}", 8, SEGMENT_SENDER},
+        {"{content}", 9, SEGMENT_CONTENT},
+        {"{timestamp}", 11, SEGMENT_TIMESTAMP},
+        {"{sms_id}", 8, SEGMENT_SMS_ID}
+    };
+
+    source = templateStr;
+    segments.clear();
+    literalLength = 0;
+    hasTimestamp = false;
+
+    const char* data = source.c_str();
+    size_t length = source.length();
+    size_t literalStart = 0;
+    size_t pos = 0;
+
+    while (pos < length) {
+        const char* brace = static_cast<const char*>(memchr(data + pos, '{', length - pos));
+        if (brace == nullptr) {
+            break;
+        }
+        pos = brace - data;
+
+        const PlaceholderEntry* matched = nullptr;
+        for (const PlaceholderEntry& entry : PLACEHOLDERS) {
+            if (length - pos >= entry.length && memcmp(data + pos, entry.name, entry.length) == 0) {
+                matched = &entry;
+                break;
+            }
+        }
+
+        if (matched == nullptr) {
+            pos++;
+            continue;
+        }
+
+        if (pos > literalStart) {
+            segments.push_back(Segment{SEGMENT_LITERAL, static_cast<uint32_t>(literalStart),
+                                       static_cast<uint32_t>(pos - literalStart)});
+            literalLength += pos - literalStart;
+        }
+        segments.push_back(Segment{matched->type, 0, 0});
+        if (matched->type == SEGMENT_TIMESTAMP) {
+            hasTimestamp = true;
+        }
+
+        pos += matched->length;
+        literalStart = pos;
+    }
+
+    if (length > literalStart) {
+        segments.push_back(Segment{SEGMENT_LITERAL, static_cast<uint32_t>(literalStart),
+                                   static_cast<uint32_t>(length - literalStart)});
+        literalLength += length - literalStart;
+    }
+}
+
+/**
+ * @brief 渲染模板
+ * @param sender 发送方号码
+ * @param content 短信内容
+ * @param timestamp 已格式化的时间
+ * @param smsId 短信记录ID
+ * @param escapeForJson 是否对占位符的值做JSON转义
+ * @return String 渲染结果
+ */
+String CompiledTemplate::render(const String& sender, const String& content, const String& timestamp,
+                                int smsId, bool escapeForJson) const {
+    String output;
+    renderInto(output, sender, content, timestamp.c_str(), timestamp.length(), smsId, escapeForJson);
+    return output;
+}
+
+/**
+ * @brief 渲染模板到内存区缓冲区
+ * @param output 输出缓冲区（追加写入）
+ * @param sender 发送方号码
+ * @param content 短信内容
+ * @param timestamp 已格式化的时间（以'\0'结尾）
+ * @param smsId 短信记录ID
+ * @param escapeForJson 是否对占位符的值做JSON转义
+ */
+void CompiledTemplate::renderTo(ArenaText& output, const String& sender, const String& content,
+                                const char* timestamp, int smsId, bool escapeForJson) const {
+    renderInto(output, sender, content, timestamp, strlen(timestamp), smsId, escapeForJson);
+}
+
+/**
+ * @brief 渲染模板到输出缓冲区
+ * @param output 输出缓冲区（String或ArenaText）
+ * @param sender 发送方号码
+ * @param content 短信内容
+ * @param timestamp 已格式化的时间
+ * @param timestampLength 时间长度
+ * @param smsId 短信记录ID
+ * @param escapeForJson 是否对占位符的值做JSON转义
+ */
+template <typename Output>
+void CompiledTemplate::renderInto(Output& output, const String& sender, const String& content,
+                                  const char* timestamp, size_t timestampLength, int smsId,
+                                  bool escapeForJson) const {
+    char smsIdText[12];
+    size_t smsIdLength = snprintf(smsIdText, sizeof(smsIdText), "%d", smsId);
+
+    // 先计算输出长度并一次性预留，转义时额外留出1/8的余量
+    size_t valueLength = 0;
+    for (const Segment& segment : segments) {
+        switch (segment.type) {
+            case SEGMENT_SENDER:    valueLength += sender.length(); break;
+            case SEGMENT_CONTENT:   valueLength += content.length(); break;
+            case SEGMENT_TIMESTAMP: valueLength += timestampLength; break;
+            case SEGMENT_SMS_ID:    valueLength += smsIdLength; break;
+            default: break;
+        }
+    }
+    if (escapeForJson) {
+        valueLength += valueLength / 8 + 8;
+    }
+
+    output.reserve(output.length() + literalLength + valueLength);
+
+    const char* data = source.c_str();
+    for (const Segment& segment : segments) {
+        switch (segment.type) {
+            case SEGMENT_LITERAL:
+                output.concat(data + segment.offset, segment.length);
+                break;
+            case SEGMENT_SENDER:
+                appendValue(output, sender.c_str(), sender.length(), escapeForJson);
+                break;
+            case SEGMENT_CONTENT:
+                appendValue(output, content.c_str(), content.length(), escapeForJson);
+                break;
+            case SEGMENT_TIMESTAMP:
+                appendValue(output, timestamp, timestampLength, escapeForJson);
+                break;
+            case SEGMENT_SMS_ID:
+                output.concat(smsIdText, smsIdLength);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief 模板是否引用了{timestamp}
+ * @return true 引用了时间
+ * @return false 未引用
+ */
+bool CompiledTemplate::usesTimestamp() const {
+    return hasTimestamp;
+}
+
+/**
+ * @brief 模板是否为空
+ * @return true 空模板
+ * @return false 非空
+ */
+bool CompiledTemplate::isEmpty() const {
+    return source.isEmpty();
+}
+
+/**
+ * @brief 获取原始模板字符串
+ * @return const String& 模板字符串
+ */
+const String& CompiledTemplate::getSource() const {
+    return source;
+}
+
+/**
+ * @brief 追加一个值，必要时做JSON转义
+ * @param output 输出缓冲区（String或ArenaText）
+ * @param value 值
+ * @param length 值长度
+ * @param escapeForJson 是否JSON转义
+ */
+template <typename Output>
+void CompiledTemplate::appendValue(Output& output, const char* value, size_t length, bool escapeForJson) {
+    if (!escapeForJson) {
+        output.concat(value, length);
+        return;
+    }
+
+    // 连续的普通字符整段追加，只在需要转义的字符处断开
+    size_t runStart = 0;
+    for (size_t i = 0; i < length; i++) {
+        const char* escaped = nullptr;
+        switch (value[i]) {
+            case '\\': escaped = "\\\\"; break;
+            case '"':  escaped = "\\\""; break;
+            case '\n': escaped = "\\n"; break;
+            case '\r': escaped = "\\r"; break;
+            case '\t': escaped = "\\t"; break;
+            default: break;
+        }
+        if (escaped == nullptr) {
+            continue;
+        }
+        if (i > runStart) {
+            output.concat(value + runStart, i - runStart);
+        }
+        output.concat(escaped, 2);
+        runStart = i + 1;
+    }
+    if (length > runStart) {
+        output.concat(value + runStart, length - runStart);
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * @file message_template.h
+ * @brief 预编译消息模板 - 模板只解析一次，渲染时单遍写入预分配缓冲区
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 将推送模板切分为字面量片段与占位符片段（{sender}, {content}, {timestamp}, {sms_id}）
+ * 2. 渲染前按片段长度一次性预留输出缓冲区，避免逐个String::replace()导致的反复重分配
+ * 3. 需要时在写入占位符值的同时完成JSON转义
+ */
+
+#ifndef MESSAGE_TEMPLATE_H
+#define MESSAGE_TEMPLATE_H
+
+#include <Arduino.h>
+#include <vector>
+
+class ArenaText;
+
+/**
+ * @class CompiledTemplate
+ * @brief 预编译的消息模板
+ *
+ * compile()之后只读，可在多个推送之间共享
+ */
+class CompiledTemplate {
+public:
+    /**
+     * @brief 构造函数（空模板）
+     */
+    CompiledTemplate();
+
+    /**
+     * @brief 构造并编译模板
+     * @param templateStr 模板字符串
+     */
+    explicit CompiledTemplate(const String& templateStr);
+
+    /**
+     * @brief 编译模板
+     * @param templateStr 模板字符串
+     */
+    void compile(const String& templateStr);
+
+    /**
+     * @brief 渲染模板
+     * @param sender 发送方号码
+     * @param content 短信内容
+     * @param timestamp 已格式化的时间
+     * @param smsId 短信记录ID
+     * @param escapeForJson 是否对占位符的值做JSON转义（字面量部分原样输出）
+     * @return String 渲染结果
+     */
+    String render(const String& sender, const String& content, const String& timestamp,
+                  int smsId, bool escapeForJson) const;
+
+    /**
+     * @brief 渲染模板到内存区缓冲区（推送路径使用，不在堆上分配）
+     * @param output 输出缓冲区（追加写入）
+     * @param sender 发送方号码
+     * @param content 短信内容
+     * @param timestamp 已格式化的时间（以'\0'结尾）
+     * @param smsId 短信记录ID
+     * @param escapeForJson 是否对占位符的值做JSON转义
+     */
+    void renderTo(ArenaText& output, const String& sender, const String& content, const char* timestamp,
+                  int smsId, bool escapeForJson) const;
+
+    /**
+     * @brief 模板是否引用了{timestamp}（未引用时调用方可跳过时间格式化）
+     * @return true 引用了时间
+     * @return false 未引用
+     */
+    bool usesTimestamp() const;
+
+    /**
+     * @brief 模板是否为空
+     * @return true 空模板
+     * @return false 非空
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief 获取原始模板字符串
+     * @return const String& 模板字符串
+     */
+    const String& getSource() const;
+
+private:
+    /**
+     * @enum SegmentType
+     * @brief 模板片段类型
+     */
+    enum SegmentType {
+        SEGMENT_LITERAL = 0,    ///< 字面量
+        SEGMENT_SENDER,         ///< {sender}
+        SEGMENT_CONTENT,        ///< {content}
+        SEGMENT_TIMESTAMP,      ///< {timestamp}
+        SEGMENT_SMS_ID          ///< {sms_id}
+    };
+
+    /**
+     * @struct Segment
+     * @brief 模板片段
+     */
+    struct Segment {
+        uint8_t type;           ///< 片段类型（SegmentType）
+        uint32_t offset;        ///< 字面量在source中的偏移
+        uint32_t length;        ///< 字面量长度
+    };
+
+    /**
+     * @brief 渲染模板到输出缓冲区（String或ArenaText）
+     * @param output 输出缓冲区
+     * @param sender 发送方号码
+     * @param content 短信内容
+     * @param timestamp 已格式化的时间
+     * @param timestampLength 时间长度
+     * @param smsId 短信记录ID
+     * @param escapeForJson 是否对占位符的值做JSON转义
+     */
+    template <typename Output>
+    void renderInto(Output& output, const String& sender, const String& content, const char* timestamp,
+                    size_t timestampLength, int smsId, bool escapeForJson) const;
+
+    /**
+     * @brief 追加一个值，必要时做JSON转义
+     * @param output 输出缓冲区（String或ArenaText）
+     * @param value 值
+     * @param length 值长度
+     * @param escapeForJson 是否JSON转义
+     */
+    template <typename Output>
+    static void appendValue(Output& output, const char* value, size_t length, bool escapeForJson);
+
+    String source;                  ///< 原始模板字符串（字面量片段指向其中）
+    std::vector<Segment> segments;  ///< 片段列表
+    size_t literalLength;           ///< 字面量总长度
+    bool hasTimestamp;              ///< 是否引用了{timestamp}
+};
+
+#endif // MESSAGE_TEMPLATE_H
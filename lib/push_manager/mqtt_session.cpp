@@ -0,0 +1,810 @@
+/**
+ * @file mqtt_session.cpp
+ * @brief MQTT会话管理实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "mqtt_session.h"
+#include "../at_command_handler/at_command_handler.h"
+#include "../http_client/http_client.h"
+#include "../modem_arbiter/modem_arbiter.h"
+#include "../log_manager/log_manager.h"
+#include <WiFi.h>
+#include <atomic>
+#include <map>
+#include <mqtt_client.h>
+#include <esp_crt_bundle.h>
+
+/**
+ * @class MqttSession
+ * @brief 一条长期保持的MQTT连接
+ */
+class MqttSession {
+public:
+    /**
+     * @brief 构造函数
+     * @param endpoint 连接参数
+     * @param key 会话键
+     */
+    MqttSession(const MqttEndpoint& endpoint, const String& key)
+        : endpoint(endpoint), key(key), lastUsed(millis()), closed(false) {
+    }
+
+    /**
+     * @brief 虚析构函数
+     */
+    virtual ~MqttSession() {
+    }
+
+    /**
+     * @brief 以QoS1发布一条消息，未连接时先建立连接
+     * @param topic 主题
+     * @param payload 载荷
+     * @param length 载荷长度
+     * @param deliveryTag 确认标记（异步确认的连接收到PUBACK或放弃消息时随结果报告，-1表示不报告）
+     * @param error 输出：失败原因
+     * @return true 发布成功（异步确认的连接表示已交给客户端）
+     * @return false 发布失败
+     */
+    virtual bool publish(const char* topic, const char* payload, size_t length, int deliveryTag, String& error) = 0;
+
+    /**
+     * @brief 发布成功时是否已收到PUBACK
+     * @return true 发布返回前已确认
+     * @return false PUBACK随后经MqttSessionManager::notifyDelivery()报告
+     */
+    virtual bool confirmsOnPublish() const {
+        return true;
+    }
+
+    /**
+     * @brief 关闭连接，之后的发布均失败
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief 获取连接状态描述
+     * @return String 状态描述
+     */
+    virtual String describe() const = 0;
+
+    /**
+     * @brief 获取会话键
+     * @return const String& 会话键
+     */
+    const String& getKey() const {
+        return key;
+    }
+
+    /**
+     * @brief 获取最近一次发布的时间
+     * @return unsigned long millis()时间
+     */
+    unsigned long getLastUsed() const {
+        return lastUsed.load();
+    }
+
+    /**
+     * @brief 获取连接所用的模块编号
+     * @return int 模块编号，WiFi连接返回-1
+     */
+    virtual int getModemIndex() const {
+        return -1;
+    }
+
+protected:
+    MqttEndpoint endpoint;                  ///< 连接参数
+    String key;                             ///< 会话键
+    std::atomic<unsigned long> lastUsed;    ///< 最近一次发布的时间
+    bool closed;                            ///< 已关闭（由各子类的锁保护）
+};
+
+namespace {
+
+/**
+ * @brief 等待条件成立
+ * @param condition 条件
+ * @param timeout 超时时间（毫秒）
+ * @return true 条件成立
+ * @return false 超时
+ */
+template <typename Condition>
+bool waitUntil(Condition condition, unsigned long timeout) {
+    unsigned long start = millis();
+    while (!condition()) {
+        if (millis() - start >= timeout) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(MQTT_WAIT_POLL_MS));
+    }
+    return true;
+}
+
+/**
+ * @brief 解析"+CMQTTXXX: <client>,<err>"形式上报中的结果码
+ * @param response 响应内容
+ * @param prefix 上报前缀（含客户端编号与逗号）
+ * @return int 结果码，未找到时返回-1
+ */
+int parseResultCode(const String& response, const String& prefix) {
+    int index = response.indexOf(prefix);
+    if (index < 0) {
+        return -1;
+    }
+    return response.substring(index + prefix.length()).toInt();
+}
+
+/**
+ * @struct PayloadStream
+ * @brief 分块写入模块的载荷
+ */
+struct PayloadStream {
+    const char* data;   ///< 载荷
+    size_t length;      ///< 载荷长度
+    size_t offset;      ///< 已写入的长度
+};
+
+/**
+ * @brief 串口写入回调：从载荷中取下一块
+ * @param context PayloadStream
+ * @param buffer 输出缓冲区
+ * @param capacity 缓冲区容量
+ * @return size_t 写入的字节数
+ */
+size_t writePayloadChunk(void* context, uint8_t* buffer, size_t capacity) {
+    PayloadStream* stream = static_cast<PayloadStream*>(context);
+    size_t count = stream->length - stream->offset < capacity ? stream->length - stream->offset : capacity;
+    memcpy(buffer, stream->data + stream->offset, count);
+    stream->offset += count;
+    return count;
+}
+
+/**
+ * @class MqttWifiSession
+ * @brief 经WiFi的MQTT连接（ESP-IDF MQTT客户端，自带重连与心跳）
+ *
+ * 发布只把消息交给客户端，不等待PUBACK；未确认的消息达到发布窗口时才等待，
+ * 断线期间客户端保留未确认的消息，重连后重发。每条消息的确认标记按msg_id记录，
+ * 收到PUBACK、消息被客户端丢弃或连接关闭时报告结果
+ */
+class MqttWifiSession : public MqttSession {
+public:
+    /**
+     * @brief 构造函数
+     * @param endpoint 连接参数
+     * @param key 会话键
+     */
+    MqttWifiSession(const MqttEndpoint& endpoint, const String& key)
+        : MqttSession(endpoint, key), client(nullptr), connected(false), inflight(0), dropped(0) {
+    }
+
+    /**
+     * @brief 析构函数
+     */
+    ~MqttWifiSession() override {
+        close();
+    }
+
+    bool publish(const char* topic, const char* payload, size_t length, int deliveryTag, String& error) override {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        if (closed) {
+            error = "MQTT连接已关闭";
+            return false;
+        }
+        if (client == nullptr && !start(error)) {
+            return false;
+        }
+
+        uint32_t lost = dropped.exchange(0);
+        if (lost > 0) {
+            LogManager::getInstance().logWarn(LOG_MODULE_SYSTEM, "MQTT " + endpoint.host + " 有 " + String(lost) +
+                                              " 条消息长时间未确认，已被客户端丢弃");
+        }
+
+        if (!waitUntil([this]() { return connected.load(); }, MQTT_CONNECT_TIMEOUT_MS)) {
+            error = "连接MQTT服务器超时: " + endpoint.host + ":" + String(endpoint.port);
+            return false;
+        }
+        if (!waitUntil([this]() { return inflight.load() < endpoint.maxInflight; }, MQTT_PUBACK_TIMEOUT_MS)) {
+            error = "等待PUBACK超时，未确认消息数: " + String(inflight.load());
+            return false;
+        }
+
+        inflight++;
+        int msgId = esp_mqtt_client_publish(client, topic, payload, (int)length, 1, 0);
+        if (msgId < 0) {
+            inflight--;
+            error = "MQTT发布失败: " + endpoint.host;
+            return false;
+        }
+        lastUsed = millis();
+        if (deliveryTag >= 0) {
+            trackDelivery(msgId, deliveryTag);
+        }
+        return true;
+    }
+
+    bool confirmsOnPublish() const override {
+        return false;
+    }
+
+    void close() override {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        closed = true;
+        if (client != nullptr) {
+            esp_mqtt_client_stop(client);
+            esp_mqtt_client_destroy(client);
+            client = nullptr;
+        }
+        connected = false;
+
+        // 客户端销毁后未确认的消息不会再重发
+        std::map<int, int> abandoned;
+        {
+            std::lock_guard<std::mutex> tagLock(tagMutex);
+            abandoned.swap(pendingTags);
+            earlyResults.clear();
+        }
+        for (const auto& item : abandoned) {
+            MqttSessionManager::getInstance().notifyDelivery(item.second, false);
+        }
+    }
+
+    String describe() const override {
+        return "wifi " + endpoint.host + ":" + String(endpoint.port) + (connected.load() ? " 已连接" : " 未连接") +
+               "，未确认 " + String(inflight.load());
+    }
+
+private:
+    /**
+     * @brief 创建并启动MQTT客户端（调用方须持有sessionMutex）
+     * @param error 输出：失败原因
+     * @return true 启动成功
+     * @return false 启动失败
+     */
+    bool start(String& error) {
+        esp_mqtt_client_config_t config = {};
+        config.host = endpoint.host.c_str();
+        config.port = endpoint.port;
+        config.transport = endpoint.tls ? MQTT_TRANSPORT_OVER_SSL : MQTT_TRANSPORT_OVER_TCP;
+        config.client_id = endpoint.clientId.c_str();
+        config.username = endpoint.username.isEmpty() ? nullptr : endpoint.username.c_str();
+        config.password = endpoint.password.isEmpty() ? nullptr : endpoint.password.c_str();
+        config.keepalive = endpoint.keepalive;
+        config.buffer_size = MQTT_WIFI_BUFFER_SIZE;
+        config.network_timeout_ms = MQTT_CONNECT_TIMEOUT_MS;
+        if (endpoint.tls) {
+            config.crt_bundle_attach = esp_crt_bundle_attach;
+        }
+
+        client = esp_mqtt_client_init(&config);
+        if (client == nullptr) {
+            error = "创建MQTT客户端失败（内存不足）";
+            return false;
+        }
+        esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, onEvent, this);
+        if (esp_mqtt_client_start(client) != ESP_OK) {
+            esp_mqtt_client_destroy(client);
+            client = nullptr;
+            error = "启动MQTT客户端失败";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 记录msg_id对应的确认标记；PUBACK先于记录到达时直接报告
+     * @param msgId 消息ID
+     * @param deliveryTag 确认标记
+     */
+    void trackDelivery(int msgId, int deliveryTag) {
+        bool resolved = false;
+        bool delivered = false;
+        {
+            std::lock_guard<std::mutex> tagLock(tagMutex);
+            auto early = earlyResults.find(msgId);
+            if (early != earlyResults.end()) {
+                resolved = true;
+                delivered = early->second;
+                earlyResults.erase(early);
+            } else {
+                pendingTags[msgId] = deliveryTag;
+            }
+        }
+        if (resolved) {
+            MqttSessionManager::getInstance().notifyDelivery(deliveryTag, delivered);
+        }
+    }
+
+    /**
+     * @brief 报告msg_id的确认结果（在MQTT客户端任务中执行）
+     *
+     * esp_mqtt_client_publish()返回前PUBACK就可能已被处理，此时标记尚未记录，
+     * 结果先暂存，由trackDelivery()取走
+     * @param msgId 消息ID
+     * @param delivered 是否已收到PUBACK
+     */
+    void resolveDelivery(int msgId, bool delivered) {
+        int deliveryTag = -1;
+        {
+            std::lock_guard<std::mutex> tagLock(tagMutex);
+            auto pending = pendingTags.find(msgId);
+            if (pending != pendingTags.end()) {
+                deliveryTag = pending->second;
+                pendingTags.erase(pending);
+            } else if (earlyResults.size() < (size_t)MQTT_MAX_INFLIGHT_LIMIT) {
+                // 不需要报告的消息（如测试推送）也会留下暂存结果，超出窗口上限时不再暂存
+                earlyResults[msgId] = delivered;
+            }
+        }
+        if (deliveryTag >= 0) {
+            MqttSessionManager::getInstance().notifyDelivery(deliveryTag, delivered);
+        }
+    }
+
+    /**
+     * @brief MQTT客户端事件回调（在MQTT客户端任务中执行）
+     * @param handlerArgs MqttWifiSession
+     * @param base 事件基
+     * @param eventId 事件ID
+     * @param eventData 事件数据
+     */
+    static void onEvent(void* handlerArgs, esp_event_base_t base, int32_t eventId, void* eventData) {
+        MqttWifiSession* session = static_cast<MqttWifiSession*>(handlerArgs);
+        esp_mqtt_event_handle_t event = static_cast<esp_mqtt_event_handle_t>(eventData);
+        switch ((esp_mqtt_event_id_t)eventId) {
+            case MQTT_EVENT_CONNECTED:
+                session->connected = true;
+                break;
+            case MQTT_EVENT_DISCONNECTED:
+                session->connected = false;
+                break;
+            case MQTT_EVENT_PUBLISHED:
+                if (session->inflight.load() > 0) {
+                    session->inflight--;
+                }
+                session->resolveDelivery(event->msg_id, true);
+                break;
+            case MQTT_EVENT_DELETED:
+                // 未确认的消息超过客户端的保留时间被移出发件箱
+                if (session->inflight.load() > 0) {
+                    session->inflight--;
+                }
+                session->dropped++;
+                session->resolveDelivery(event->msg_id, false);
+                break;
+            default:
+                break;
+        }
+    }
+
+    esp_mqtt_client_handle_t client;    ///< MQTT客户端
+    std::atomic<bool> connected;        ///< 是否已连接
+    std::atomic<int> inflight;          ///< 未收到PUBACK的消息数
+    std::atomic<uint32_t> dropped;      ///< 被客户端丢弃的未确认消息数
+    std::mutex sessionMutex;            ///< 保护client与closed
+    std::map<int, int> pendingTags;     ///< 未确认消息的msg_id到确认标记
+    std::map<int, bool> earlyResults;   ///< 记录标记前已到达的确认结果
+    std::mutex tagMutex;                ///< 保护pendingTags与earlyResults（不与sessionMutex嵌套等待）
+};
+
+/**
+ * @brief 各模块MQTT客户端的互斥锁（同一模块只保持一个连接，新旧连接的建立与关闭不能交错）
+ */
+std::mutex modemLocks[MODEM_MAX_COUNT];
+
+/**
+ * @class MqttModemSession
+ * @brief 经模块TCP协议栈的MQTT连接（SIMCom AT+CMQTT*命令）
+ *
+ * 连接与TLS会话长期保持；模块一次只接受一条待发布消息，每条消息发布后等待PUBACK
+ */
+class MqttModemSession : public MqttSession {
+public:
+    /**
+     * @brief 构造函数
+     * @param endpoint 连接参数
+     * @param key 会话键
+     * @param modem 模块编号
+     */
+    MqttModemSession(const MqttEndpoint& endpoint, const String& key, uint8_t modem)
+        : MqttSession(endpoint, key), modem(modem), connected(false) {
+    }
+
+    /**
+     * @brief 析构函数
+     */
+    ~MqttModemSession() override {
+        close();
+    }
+
+    int getModemIndex() const override {
+        return modem;
+    }
+
+    bool publish(const char* topic, const char* payload, size_t length, int deliveryTag, String& error) override {
+        std::lock_guard<std::mutex> lock(modemLocks[modem]);
+        if (closed) {
+            error = "MQTT连接已关闭";
+            return false;
+        }
+        if (length > MQTT_MAX_PAYLOAD_LENGTH) {
+            error = "MQTT载荷超过模块上限: " + String((unsigned long)length);
+            return false;
+        }
+
+        // 连接可能已被服务器或网络断开而未被发现，发布失败时重连一次
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (!connected && !connect(error)) {
+                return false;
+            }
+            if (publishOnce(topic, payload, length, error)) {
+                lastUsed = millis();
+                return true;
+            }
+            connected = false;
+        }
+        return false;
+    }
+
+    void close() override {
+        std::lock_guard<std::mutex> lock(modemLocks[modem]);
+        if (closed) {
+            return;
+        }
+        closed = true;
+        if (connected) {
+            AtCommandHandler& atHandler = AtCommandHandler::getModem(modem);
+            String index = String(MQTT_MODEM_CLIENT_INDEX);
+            if (atHandler.sendCommand("AT+CMQTTDISC=" + index + ",60").result == AT_RESULT_SUCCESS) {
+                atHandler.waitForResponse("+CMQTTDISC: " + index + ",", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+            }
+            atHandler.sendCommand("AT+CMQTTREL=" + index);
+            if (atHandler.sendCommand("AT+CMQTTSTOP").result == AT_RESULT_SUCCESS) {
+                atHandler.waitForResponse("+CMQTTSTOP:", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+            }
+            connected = false;
+        }
+    }
+
+    String describe() const override {
+        return "SIM" + String(modem + 1) + " " + endpoint.host + ":" + String(endpoint.port) +
+               (connected ? " 已连接" : " 未连接");
+    }
+
+private:
+    /**
+     * @brief 启动模块MQTT服务并连接服务器（调用方须持有模块锁）
+     * @param error 输出：失败原因
+     * @return true 连接成功
+     * @return false 连接失败
+     */
+    bool connect(String& error) {
+        AtCommandHandler& atHandler = AtCommandHandler::getModem(modem);
+        String index = String(MQTT_MODEM_CLIENT_INDEX);
+
+        // 服务已由之前的连接启动时返回ERROR，可以忽略
+        if (atHandler.sendCommand("AT+CMQTTSTART").result == AT_RESULT_SUCCESS) {
+            atHandler.waitForResponse("+CMQTTSTART:", MQTT_CONNECT_TIMEOUT_MS);
+        }
+        // 释放上次未正常关闭的客户端（没有时返回ERROR）
+        atHandler.sendCommand("AT+CMQTTREL=" + index);
+
+        AtResponse response = atHandler.sendCommand("AT+CMQTTACCQ=" + index + ",\"" + endpoint.clientId + "\"," +
+                                                    String(endpoint.tls ? 1 : 0));
+        if (response.result != AT_RESULT_SUCCESS) {
+            error = "获取模块MQTT客户端失败: " + response.response;
+            return false;
+        }
+
+        if (endpoint.tls) {
+            // 与HTTP共用SSL上下文（不校验服务器证书，启用SNI）
+            String context = String(HTTP_SSL_CONTEXT_ID);
+            std::vector<String> commands;
+            commands.push_back("AT+CSSLCFG=\"sslversion\"," + context + ",4");
+            commands.push_back("AT+CSSLCFG=\"authmode\"," + context + ",0");
+            commands.push_back("AT+CSSLCFG=\"enableSNI\"," + context + ",1");
+            commands.push_back("AT+CMQTTSSLCFG=" + index + "," + context);
+            response = atHandler.sendCommandBatch(commands, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+            if (response.result != AT_RESULT_SUCCESS) {
+                error = "配置模块MQTT TLS失败: " + response.response;
+                return false;
+            }
+        }
+
+        String command = "AT+CMQTTCONNECT=" + index + ",\"tcp://" + endpoint.host + ":" + String(endpoint.port) +
+                         "\"," + String(endpoint.keepalive) + ",1";
+        if (!endpoint.username.isEmpty()) {
+            command += ",\"" + endpoint.username + "\",\"" + endpoint.password + "\"";
+        }
+        response = atHandler.sendCommand(command, "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        if (response.result != AT_RESULT_SUCCESS) {
+            error = "模块MQTT连接命令失败: " + response.response;
+            return false;
+        }
+        response = atHandler.waitForResponse("+CMQTTCONNECT: " + index + ",", MQTT_CONNECT_TIMEOUT_MS);
+        int code = parseResultCode(response.response, "+CMQTTCONNECT: " + index + ",");
+        if (response.result != AT_RESULT_SUCCESS || code != 0) {
+            error = "模块MQTT连接失败: " + endpoint.host + "，结果码: " + String(code);
+            return false;
+        }
+
+        LOG_DEBUG(LOG_MODULE_SYSTEM, "SIM" + String(modem + 1) + " MQTT已连接: " + endpoint.host);
+        connected = true;
+        return true;
+    }
+
+    /**
+     * @brief 写入主题与载荷并以QoS1发布（调用方须持有模块锁）
+     * @param topic 主题
+     * @param payload 载荷
+     * @param length 载荷长度
+     * @param error 输出：失败原因
+     * @return true 已收到PUBACK
+     * @return false 发布失败
+     */
+    bool publishOnce(const char* topic, const char* payload, size_t length, String& error) {
+        AtCommandHandler& atHandler = AtCommandHandler::getModem(modem);
+        String index = String(MQTT_MODEM_CLIENT_INDEX);
+
+        // 提示符与其后的数据在同一事务内写入，其他命令不会混入主题或载荷
+        AtResponse response = atHandler.sendCommandWithData(
+            "AT+CMQTTTOPIC=" + index + "," + String((unsigned long)strlen(topic)), ">", String(topic),
+            nullptr, nullptr, DEFAULT_AT_COMMAND_TIMEOUT_MS, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        if (response.result != AT_RESULT_SUCCESS) {
+            error = "写入MQTT主题失败: " + response.response;
+            return false;
+        }
+
+        PayloadStream stream = {payload, length, 0};
+        response = atHandler.sendCommandWithData(
+            "AT+CMQTTPAYLOAD=" + index + "," + String((unsigned long)length), ">", "",
+            writePayloadChunk, &stream, DEFAULT_AT_COMMAND_TIMEOUT_MS, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        if (response.result != AT_RESULT_SUCCESS) {
+            error = "写入MQTT载荷失败: " + response.response;
+            return false;
+        }
+
+        response = atHandler.sendCommand("AT+CMQTTPUB=" + index + ",1," + String(MQTT_MODEM_PUB_TIMEOUT_S),
+                                         "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        if (response.result != AT_RESULT_SUCCESS) {
+            error = "MQTT发布命令失败: " + response.response;
+            return false;
+        }
+        response = atHandler.waitForResponse("+CMQTTPUB: " + index + ",",
+                                             (unsigned long)MQTT_MODEM_PUB_TIMEOUT_S * 1000 + DEFAULT_AT_COMMAND_TIMEOUT_MS);
+        int code = parseResultCode(response.response, "+CMQTTPUB: " + index + ",");
+        if (response.result != AT_RESULT_SUCCESS || code != 0) {
+            error = "MQTT发布未确认，结果码: " + String(code);
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t modem;      ///< 模块编号
+    bool connected;     ///< 是否已连接（由模块锁保护）
+};
+
+} // namespace
+
+/**
+ * @brief 获取单例实例
+ * @return MqttSessionManager& 单例引用
+ */
+MqttSessionManager& MqttSessionManager::getInstance() {
+    static MqttSessionManager instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+MqttSessionManager::MqttSessionManager() : debugMode(false) {
+}
+
+/**
+ * @brief 以QoS1发布一条消息
+ * @param endpoint 连接参数
+ * @param topic 主题
+ * @param payload 载荷
+ * @param length 载荷长度
+ * @param deliveryTag 确认标记（-1表示不需要确认结果）
+ * @param error 输出：失败原因
+ * @return PushResult 推送结果
+ */
+PushResult MqttSessionManager::publish(const MqttEndpoint& endpoint, const char* topic, const char* payload,
+                                       size_t length, int deliveryTag, String& error) {
+    std::shared_ptr<MqttSession> session = acquire(endpoint, error);
+    if (!session) {
+        return PUSH_NETWORK_ERROR;
+    }
+    if (!session->publish(topic, payload, length, deliveryTag, error)) {
+        debugPrint("发布失败: " + error);
+        return PUSH_NETWORK_ERROR;
+    }
+    if (deliveryTag >= 0 && !session->confirmsOnPublish()) {
+        return PUSH_PENDING;
+    }
+    return PUSH_SUCCESS;
+}
+
+/**
+ * @brief 设置确认结果监听器
+ * @param listener 监听器
+ */
+void MqttSessionManager::setDeliveryListener(DeliveryListener listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    deliveryListener = listener;
+}
+
+/**
+ * @brief 报告一条异步确认消息的结果
+ * @param deliveryTag 确认标记
+ * @param delivered 是否已收到PUBACK
+ */
+void MqttSessionManager::notifyDelivery(int deliveryTag, bool delivered) {
+    DeliveryListener listener;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listener = deliveryListener;
+    }
+    if (listener) {
+        listener(deliveryTag, delivered);
+    }
+}
+
+/**
+ * @brief 查找或创建端点对应的连接
+ * @param endpoint 连接参数
+ * @param error 输出：失败原因
+ * @return std::shared_ptr<MqttSession> 连接
+ */
+std::shared_ptr<MqttSession> MqttSessionManager::acquire(const MqttEndpoint& endpoint, String& error) {
+    bool useWifi = endpoint.transport == MQTT_TRANSPORT_WIFI ||
+                   (endpoint.transport == MQTT_TRANSPORT_AUTO && WiFi.status() == WL_CONNECTED);
+    if (endpoint.transport == MQTT_TRANSPORT_WIFI && WiFi.status() != WL_CONNECTED) {
+        error = "WiFi未连接";
+        return nullptr;
+    }
+    uint8_t modem = useWifi ? 0 : selectModem();
+    String key = (useWifi ? String("wifi") : "sim" + String(modem + 1)) + "|" + endpoint.host + ":" +
+                 String(endpoint.port) + (endpoint.tls ? "|tls|" : "|tcp|") + endpoint.clientId + "|" +
+                 endpoint.username + "|" + String(endpoint.keepalive);
+
+    std::shared_ptr<MqttSession> session;
+    std::vector<std::shared_ptr<MqttSession>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::shared_ptr<MqttSession>& existing : sessions) {
+            if (existing->getKey() == key) {
+                return existing;
+            }
+        }
+
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            // 每个模块只保持一个MQTT客户端，连到其他端点的旧连接让位
+            if (!useWifi && (*it)->getModemIndex() == modem) {
+                evicted.push_back(*it);
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (sessions.size() >= MQTT_MAX_SESSIONS) {
+            auto oldest = sessions.begin();
+            for (auto it = sessions.begin(); it != sessions.end(); ++it) {
+                if ((*it)->getLastUsed() < (*oldest)->getLastUsed()) {
+                    oldest = it;
+                }
+            }
+            evicted.push_back(*oldest);
+            sessions.erase(oldest);
+        }
+
+        if (useWifi) {
+            session = std::make_shared<MqttWifiSession>(endpoint, key);
+        } else {
+            session = std::make_shared<MqttModemSession>(endpoint, key, modem);
+        }
+        sessions.push_back(session);
+    }
+
+    // 在锁外关闭被替换的连接（模块连接需要发送AT命令）
+    for (const std::shared_ptr<MqttSession>& old : evicted) {
+        debugPrint("关闭连接: " + old->describe());
+        old->close();
+    }
+    debugPrint("新建连接: " + session->describe());
+    return session;
+}
+
+/**
+ * @brief 关闭空闲过久的连接
+ * @return int 关闭的连接数
+ */
+int MqttSessionManager::closeIdleSessions() {
+    std::vector<std::shared_ptr<MqttSession>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        unsigned long now = millis();
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            if (now - (*it)->getLastUsed() >= MQTT_SESSION_IDLE_TIMEOUT_MS) {
+                idle.push_back(*it);
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (const std::shared_ptr<MqttSession>& session : idle) {
+        debugPrint("关闭空闲连接: " + session->describe());
+        session->close();
+    }
+    return (int)idle.size();
+}
+
+/**
+ * @brief 关闭所有连接
+ */
+void MqttSessionManager::closeAll() {
+    std::vector<std::shared_ptr<MqttSession>> all;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        all.swap(sessions);
+    }
+    for (const std::shared_ptr<MqttSession>& session : all) {
+        session->close();
+    }
+}
+
+/**
+ * @brief 获取连接状态描述
+ * @return String 状态描述
+ */
+String MqttSessionManager::getStatusInfo() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sessions.empty()) {
+        return "无MQTT连接";
+    }
+    String info;
+    for (const std::shared_ptr<MqttSession>& session : sessions) {
+        if (!info.isEmpty()) {
+            info += "; ";
+        }
+        info += session->describe();
+    }
+    return info;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void MqttSessionManager::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief 选择模块：优先使用已注册且数据连接可用的模块
+ * @return uint8_t 模块编号
+ */
+uint8_t MqttSessionManager::selectModem() {
+    for (uint8_t modem = 0; modem < ModemArbiter::getModemCount(); modem++) {
+        if (HttpClient::getModem(modem).hasDataConnectivity()) {
+            return modem;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void MqttSessionManager::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[MqttSession] " + message);
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file mqtt_session.h
+ * @brief MQTT会话管理 - 在渠道实例之间共享长期保持的MQTT连接
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 按端点（传输方式、服务器、客户端ID、用户名）保持MQTT连接，渠道实例销毁后连接仍保留，
+ *    每条短信只发布一条QoS1消息，不再为每条消息建立TCP/TLS连接
+ * 2. WiFi连接使用ESP-IDF的MQTT客户端：发布后不等待PUBACK，未确认的消息不超过发布窗口时
+ *    连续发布，断线重连后由客户端重发未确认的消息；PUBACK到达或消息被放弃时按确认标记
+ *    报告给监听器，由推送管理器据此结算发件箱条目
+ * 3. 模块连接使用SIMCom的AT+CMQTT*命令：连接长期保持，每条消息在模块内发布并等待PUBACK
+ * 4. 关闭空闲过久的连接，连接数超出上限时关闭最久未用的连接
+ */
+
+#ifndef MQTT_SESSION_H
+#define MQTT_SESSION_H
+
+#include <Arduino.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include "push_channel_base.h"
+#include "../../include/constants.h"
+
+/**
+ * @enum MqttTransport
+ * @brief MQTT连接的传输方式
+ */
+enum MqttTransport {
+    MQTT_TRANSPORT_AUTO = 0,    ///< WiFi已连接时走WiFi，否则走模块
+    MQTT_TRANSPORT_WIFI,        ///< 只走WiFi
+    MQTT_TRANSPORT_MODEM        ///< 只走模块TCP协议栈
+};
+
+/**
+ * @struct MqttEndpoint
+ * @brief MQTT连接参数
+ */
+struct MqttEndpoint {
+    MqttTransport transport;    ///< 传输方式
+    String host;                ///< 服务器地址
+    uint16_t port;              ///< 服务器端口
+    bool tls;                   ///< 是否使用TLS
+    String clientId;            ///< 客户端ID
+    String username;            ///< 用户名（可为空）
+    String password;            ///< 密码（可为空）
+    uint16_t keepalive;         ///< 心跳间隔（秒）
+    uint8_t maxInflight;        ///< 发布窗口：未收到PUBACK的消息上限（仅WiFi连接）
+};
+
+class MqttSession;
+
+/**
+ * @class MqttSessionManager
+ * @brief MQTT会话管理器（线程安全）
+ */
+class MqttSessionManager {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return MqttSessionManager& 单例引用
+     */
+    static MqttSessionManager& getInstance();
+
+    /**
+     * @brief 确认结果监听器（在MQTT客户端任务或关闭连接的任务中调用，不应阻塞）
+     * @param deliveryTag 发布时传入的确认标记
+     * @param delivered true表示已收到PUBACK，false表示消息已被放弃
+     */
+    typedef std::function<void(int deliveryTag, bool delivered)> DeliveryListener;
+
+    /**
+     * @brief 以QoS1发布一条消息，需要时建立或重建连接
+     *
+     * WiFi连接在消息交给MQTT客户端后即返回，给出确认标记时返回PUSH_PENDING，
+     * 确认结果随后报告给监听器；模块连接在收到PUBACK后返回PUSH_SUCCESS
+     * @param endpoint 连接参数
+     * @param topic 主题
+     * @param payload 载荷
+     * @param length 载荷长度
+     * @param deliveryTag 确认标记（-1表示不需要确认结果，如测试推送）
+     * @param error 输出：失败原因
+     * @return PushResult PUSH_SUCCESS、PUSH_PENDING，或连接/发布失败时的PUSH_NETWORK_ERROR
+     */
+    PushResult publish(const MqttEndpoint& endpoint, const char* topic, const char* payload, size_t length,
+                       int deliveryTag, String& error);
+
+    /**
+     * @brief 设置确认结果监听器
+     * @param listener 监听器
+     */
+    void setDeliveryListener(DeliveryListener listener);
+
+    /**
+     * @brief 报告一条异步确认消息的结果（由WiFi连接调用）
+     * @param deliveryTag 确认标记
+     * @param delivered 是否已收到PUBACK
+     */
+    void notifyDelivery(int deliveryTag, bool delivered);
+
+    /**
+     * @brief 关闭空闲超过MQTT_SESSION_IDLE_TIMEOUT_MS的连接（由定时任务调用）
+     * @return int 关闭的连接数
+     */
+    int closeIdleSessions();
+
+    /**
+     * @brief 关闭所有连接
+     */
+    void closeAll();
+
+    /**
+     * @brief 获取连接状态描述
+     * @return String 状态描述
+     */
+    String getStatusInfo();
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    MqttSessionManager();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    MqttSessionManager(const MqttSessionManager&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    MqttSessionManager& operator=(const MqttSessionManager&) = delete;
+
+    /**
+     * @brief 查找或创建端点对应的连接
+     * @param endpoint 连接参数
+     * @param error 输出：失败原因
+     * @return std::shared_ptr<MqttSession> 连接，无可用传输时返回nullptr
+     */
+    std::shared_ptr<MqttSession> acquire(const MqttEndpoint& endpoint, String& error);
+
+    /**
+     * @brief 选择模块：优先使用已注册且数据连接可用的模块
+     * @return uint8_t 模块编号
+     */
+    static uint8_t selectModem();
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    std::vector<std::shared_ptr<MqttSession>> sessions;    ///< 保持中的连接
+    std::mutex mutex;                                       ///< 保护sessions与deliveryListener
+    DeliveryListener deliveryListener;                      ///< 确认结果监听器
+    bool debugMode;                                         ///< 调试模式
+};
+
+#endif // MQTT_SESSION_H
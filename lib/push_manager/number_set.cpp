@@ -0,0 +1,231 @@
+/**
+ * @file number_set.cpp
+ * @brief 号码名单集合实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "number_set.h"
+#include <esp_heap_caps.h>
+#include <string.h>
+
+namespace {
+
+/**
+ * @brief 64位FNV-1a哈希
+ * @param data 字符串
+ * @return uint64_t 哈希值
+ */
+uint64_t hashNumber(const char* data) {
+    uint64_t hash = 14695981039346656037ULL;
+    while (*data != '\0') {
+        hash ^= static_cast<uint8_t>(*data++);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief 号码键在哈希表中的起始槽位（混合高位，低位相近的键也能分散）
+ * @param key 号码键
+ * @param mask 槽位数-1
+ * @return size_t 槽位
+ */
+size_t slotOf(uint64_t key, size_t mask) {
+    return static_cast<size_t>(key ^ (key >> 29)) & mask;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数，按预计号码数分配哈希表
+ * @param expected 预计号码数
+ */
+NumberSet::NumberSet(size_t expected)
+    : slots(nullptr), mask(0), count(0) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) {
+        capacity <<= 1;
+    }
+    size_t bytes = capacity * sizeof(uint64_t);
+    slots = (uint64_t*)heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (slots == nullptr) {
+        slots = (uint64_t*)heap_caps_calloc(1, bytes, MALLOC_CAP_8BIT);
+    }
+    if (slots != nullptr) {
+        mask = capacity - 1;
+    }
+}
+
+/**
+ * @brief 析构函数
+ */
+NumberSet::~NumberSet() {
+    if (slots != nullptr) {
+        heap_caps_free(slots);
+    }
+}
+
+/**
+ * @brief 哈希表是否分配成功
+ * @return true 可用
+ * @return false 分配失败
+ */
+bool NumberSet::isReady() const {
+    return slots != nullptr;
+}
+
+/**
+ * @brief 加入一个号码
+ * @param number 号码
+ * @return true 已加入或已存在
+ * @return false 号码无效或哈希表已满
+ */
+bool NumberSet::insert(const char* number) {
+    uint64_t key = keyOf(number);
+    if (key == 0 || slots == nullptr) {
+        return false;
+    }
+    // 装载率超过3/4时探测链过长，拒绝继续插入
+    if ((count + 1) * 4 > (mask + 1) * 3) {
+        return false;
+    }
+    size_t slot = slotOf(key, mask);
+    while (slots[slot] != 0) {
+        if (slots[slot] == key) {
+            return true;
+        }
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = key;
+    count++;
+    return true;
+}
+
+/**
+ * @brief 检查号码键是否在集合中
+ * @param key 号码键
+ * @return true 在集合中
+ * @return false 不在集合中或键无效
+ */
+bool NumberSet::contains(uint64_t key) const {
+    if (key == 0 || slots == nullptr) {
+        return false;
+    }
+    size_t slot = slotOf(key, mask);
+    while (slots[slot] != 0) {
+        if (slots[slot] == key) {
+            return true;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return false;
+}
+
+/**
+ * @brief 获取号码数量
+ * @return size_t 号码数量
+ */
+size_t NumberSet::size() const {
+    return count;
+}
+
+/**
+ * @brief 获取哈希表占用的字节数
+ * @return size_t 字节数
+ */
+size_t NumberSet::getMemoryBytes() const {
+    return slots != nullptr ? (mask + 1) * sizeof(uint64_t) : 0;
+}
+
+/**
+ * @brief 将号码规范化为E.164格式
+ * @param number 号码
+ * @param out 输出缓冲区
+ * @param outSize 缓冲区大小
+ * @return true 规范化成功
+ * @return false 号码无效
+ */
+bool NumberSet::normalize(const char* number, char* out, size_t outSize) {
+    if (number == nullptr || outSize < NUMBER_LIST_MAX_NUMBER_LENGTH) {
+        return false;
+    }
+
+    char digits[NUMBER_LIST_MAX_NUMBER_LENGTH];
+    size_t length = 0;
+    bool international = false;
+    for (const char* p = number; *p != '\0'; p++) {
+        char ch = *p;
+        if (ch >= '0' && ch <= '9') {
+            if (length + 1 >= NUMBER_LIST_MAX_NUMBER_LENGTH - 1) {
+                return false;
+            }
+            digits[length++] = ch;
+        } else if (ch == '+' && length == 0 && !international) {
+            international = true;
+        } else if (ch != ' ' && ch != '-' && ch != '(' && ch != ')' && ch != '\t' && ch != '\r') {
+            return false;
+        }
+    }
+    digits[length] = '\0';
+    if (length == 0) {
+        return false;
+    }
+
+    const char* countryCode = NUMBER_LIST_COUNTRY_CODE;
+    size_t countryLength = strlen(countryCode);
+    const char* national = nullptr;
+    if (international) {
+        snprintf(out, outSize, "+%s", digits);
+    } else if (length > 2 && digits[0] == '0' && digits[1] == '0') {
+        snprintf(out, outSize, "+%s", digits + 2);
+    } else if (length == 11 && digits[0] == '1') {
+        national = digits;                      // 手机号
+    } else if (length >= 10 && length <= 12 && digits[0] == '0') {
+        national = digits + 1;                  // 带长途前缀0的固话
+    } else if (length == countryLength + 11 && strncmp(digits, countryCode, countryLength) == 0 &&
+               digits[countryLength] == '1') {
+        snprintf(out, outSize, "+%s", digits);  // 省略了"+"的国际格式手机号
+    } else {
+        snprintf(out, outSize, "%s", digits);   // 短号、服务号
+    }
+    if (national != nullptr) {
+        snprintf(out, outSize, "+%s%s", countryCode, national);
+    }
+    return true;
+}
+
+/**
+ * @brief 计算号码键
+ * @param number 号码
+ * @return uint64_t 号码键，号码无效时为0
+ */
+uint64_t NumberSet::keyOf(const char* number) {
+    char normalized[NUMBER_LIST_MAX_NUMBER_LENGTH];
+    if (!normalize(number, normalized, sizeof(normalized))) {
+        return 0;
+    }
+    uint64_t key = hashNumber(normalized);
+    return key != 0 ? key : 1;
+}
+
+/**
+ * @brief 解析规则来源号码中的名单引用
+ * @param pattern 来源号码
+ * @param listName 输出：名单名
+ * @param negated 输出：true表示"不在名单中"
+ * @return true 是名单引用
+ * @return false 普通号码模式
+ */
+bool NumberSet::parseListPattern(const String& pattern, String& listName, bool& negated) {
+    static const char* prefix = NUMBER_LIST_PATTERN_PREFIX;
+    size_t prefixLength = strlen(prefix);
+    negated = pattern.startsWith("!");
+    size_t start = negated ? 1 : 0;
+    if (pattern.length() <= start + prefixLength || strncmp(pattern.c_str() + start, prefix, prefixLength) != 0) {
+        return false;
+    }
+    listName = pattern.substring(start + prefixLength);
+    listName.trim();
+    return !listName.isEmpty();
+}
@@ -0,0 +1,128 @@
+/**
+ * @file number_set.h
+ * @brief 号码名单集合 - 规范化号码的开放寻址哈希集合，供名单规则O(1)判断发送方是否在名单中
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 将号码规范化为E.164格式（国内手机号与带长途前缀的固话补全国家码，短号与服务号保持原样）
+ * 2. 以规范化号码的64位哈希为键，线性探测的定长哈希表保存在PSRAM中，构建后只读
+ * 3. 解析规则来源号码中的名单引用："list:名单名"（在名单中）与"!list:名单名"（不在名单中）
+ */
+
+#ifndef NUMBER_SET_H
+#define NUMBER_SET_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include "../../include/constants.h"
+
+class NumberSet;
+
+/**
+ * @brief 名单名到号码集合的映射（随规则快照整体发布，集合构建后不再修改）
+ */
+typedef std::map<String, std::shared_ptr<const NumberSet>> NumberListMap;
+
+/**
+ * @class NumberSet
+ * @brief 只读号码哈希集合
+ *
+ * 插入完成后可被多个任务同时调用contains()
+ */
+class NumberSet {
+public:
+    /**
+     * @brief 构造函数，按预计号码数分配哈希表（装载率不超过1/2）
+     * @param expected 预计号码数
+     */
+    explicit NumberSet(size_t expected);
+
+    /**
+     * @brief 析构函数，释放哈希表
+     */
+    ~NumberSet();
+
+    /**
+     * @brief 哈希表是否分配成功
+     * @return true 可用
+     * @return false 分配失败
+     */
+    bool isReady() const;
+
+    /**
+     * @brief 加入一个号码（先规范化）
+     * @param number 号码
+     * @return true 已加入或已存在
+     * @return false 号码无效或哈希表已满
+     */
+    bool insert(const char* number);
+
+    /**
+     * @brief 检查号码键是否在集合中
+     * @param key 号码键（keyOf()的结果）
+     * @return true 在集合中
+     * @return false 不在集合中或键无效
+     */
+    bool contains(uint64_t key) const;
+
+    /**
+     * @brief 获取号码数量
+     * @return size_t 号码数量
+     */
+    size_t size() const;
+
+    /**
+     * @brief 获取哈希表占用的字节数
+     * @return size_t 字节数
+     */
+    size_t getMemoryBytes() const;
+
+    /**
+     * @brief 将号码规范化为E.164格式
+     *
+     * 忽略空格、横线与括号；"+"或"00"开头为国际号码；11位1开头的手机号与0开头的固话
+     * 补NUMBER_LIST_COUNTRY_CODE；其余（短号、服务号）只保留数字
+     * @param number 号码
+     * @param out 输出缓冲区
+     * @param outSize 缓冲区大小（至少NUMBER_LIST_MAX_NUMBER_LENGTH）
+     * @return true 规范化成功
+     * @return false 号码为空、含其他字符或过长
+     */
+    static bool normalize(const char* number, char* out, size_t outSize);
+
+    /**
+     * @brief 计算号码键（规范化后哈希）
+     * @param number 号码
+     * @return uint64_t 号码键，号码无效时为0
+     */
+    static uint64_t keyOf(const char* number);
+
+    /**
+     * @brief 解析规则来源号码中的名单引用
+     * @param pattern 来源号码
+     * @param listName 输出：名单名
+     * @param negated 输出：true表示"不在名单中"
+     * @return true 是名单引用
+     * @return false 普通号码模式
+     */
+    static bool parseListPattern(const String& pattern, String& listName, bool& negated);
+
+private:
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    NumberSet(const NumberSet&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    NumberSet& operator=(const NumberSet&) = delete;
+
+    uint64_t* slots;        ///< 哈希表（0表示空槽）
+    size_t mask;            ///< 槽位数-1（槽位数为2的幂）
+    size_t count;           ///< 号码数量
+};
+
+#endif // NUMBER_SET_H
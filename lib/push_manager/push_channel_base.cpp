@@ -6,7 +6,6 @@
  */
 
 #include "push_channel_base.h"
-#include <ArduinoJson.h>
 
 /**
  * @brief 解析推送配置
@@ -44,24 +43,57 @@ std::map<String, String> PushChannelBase::parseConfig(const String& configJson)
  * @return String 应用模板后的消息
  */
 String PushChannelBase::applyTemplate(const String& templateStr, const PushContext& context, bool escapeForJson) {
-    String result = templateStr;
-    
-    // 替换占位符
-    result.replace("{sender}", context.sender);
-    result.replace("{content}", context.content);
-    result.replace("{timestamp}", formatTimestamp(context.timestamp));
-    result.replace("{sms_id}", String(context.smsRecordId));
-    
-    // 只有在需要JSON转义时才转义特殊字符
-    if (escapeForJson) {
-        result.replace("\\", "\\\\");
-        result.replace("\"", "\\\"");
-        result.replace("\n", "\\n");
-        result.replace("\r", "\\r");
-        result.replace("\t", "\\t");
+    return renderTemplate(CompiledTemplate(templateStr), context, escapeForJson);
+}
+
+/**
+ * @brief 渲染预编译的消息模板
+ * @param messageTemplate 预编译模板
+ * @param context 推送上下文
+ * @param escapeForJson 是否对占位符的值做JSON转义
+ * @return String 渲染后的消息
+ */
+String PushChannelBase::renderTemplate(const CompiledTemplate& messageTemplate, const PushContext& context, bool escapeForJson) {
+    // 模板未引用时间时跳过格式化
+    String timestamp = messageTemplate.usesTimestamp() ? formatTimestamp(context.timestamp) : String();
+    return messageTemplate.render(context.sender, context.content, timestamp, context.smsRecordId, escapeForJson);
+}
+
+/**
+ * @brief 渲染预编译的消息模板到内存区缓冲区
+ * @param output 输出缓冲区（追加写入）
+ * @param messageTemplate 预编译模板
+ * @param context 推送上下文
+ * @param escapeForJson 是否对占位符的值做JSON转义
+ */
+void PushChannelBase::renderTemplate(ArenaText& output, const CompiledTemplate& messageTemplate,
+                                     const PushContext& context, bool escapeForJson) {
+    char timestamp[PUSH_TIMESTAMP_TEXT_SIZE] = "";
+    if (messageTemplate.usesTimestamp()) {
+        formatTimestamp(context.timestamp, timestamp);
     }
-    
-    return result;
+    messageTemplate.renderTo(output, context.sender, context.content, timestamp, context.smsRecordId, escapeForJson);
+}
+
+/**
+ * @brief 渠道是否支持汇总推送
+ * @return true 支持
+ * @return false 不支持
+ */
+bool PushChannelBase::supportsDigest() const {
+    return false;
+}
+
+/**
+ * @brief 推送多条短信的汇总消息
+ * @param config 渠道配置
+ * @param title 汇总标题
+ * @param body 汇总正文
+ * @return PushResult 推送结果
+ */
+PushResult PushChannelBase::pushDigest(const PushChannelConfig& config, const String& title, const String& body) {
+    setError("渠道 " + getChannelName() + " 不支持汇总推送");
+    return PUSH_CONFIG_ERROR;
 }
 
 /**
@@ -70,34 +102,50 @@ String PushChannelBase::applyTemplate(const String& templateStr, const PushConte
  * @return String 格式化后的时间
  */
 String PushChannelBase::formatTimestamp(const String& timestamp) {
+    char formatted[PUSH_TIMESTAMP_TEXT_SIZE];
+    formatTimestamp(timestamp, formatted);
+    return String(formatted);
+}
+
+/**
+ * @brief 格式化时间戳到字符数组（不分配内存）
+ * @param timestamp PDU时间戳
+ * @param output 输出（YYYY-MM-DD HH:mm:ss）
+ * @return size_t 输出长度
+ */
+size_t PushChannelBase::formatTimestamp(const String& timestamp, char (&output)[PUSH_TIMESTAMP_TEXT_SIZE]) {
     // PDU时间戳格式: YYMMDDhhmmss (12位数字)
     if (timestamp.length() < 12) {
-        return "时间格式错误";
+        return snprintf(output, sizeof(output), "%s", "时间格式错误");
     }
     
-    // 提取各个时间组件
-    String year = timestamp.substring(0, 2);
-    String month = timestamp.substring(2, 4);
-    String day = timestamp.substring(4, 6);
-    String hour = timestamp.substring(6, 8);
-    String minute = timestamp.substring(8, 10);
-    String second = timestamp.substring(10, 12);
-    
-    // 转换年份 (假设20xx年)
-    int yearInt = year.toInt();
-    if (yearInt >= 0 && yearInt <= 99) {
-        yearInt += 2000;
-    }
+    // 年份只有两位，按20xx年处理；其余字段原样取两位
+    const char* digits = timestamp.c_str();
+    int year = 2000 + (digits[0] - '0') * 10 + (digits[1] - '0');
     
     // 格式化为可读格式: YYYY-MM-DD HH:mm:ss
-    String formattedTime = String(yearInt) + "-" + 
-                          (month.length() == 1 ? "0" + month : month) + "-" +
-                          (day.length() == 1 ? "0" + day : day) + " " +
-                          (hour.length() == 1 ? "0" + hour : hour) + ":" +
-                          (minute.length() == 1 ? "0" + minute : minute) + ":" +
-                          (second.length() == 1 ? "0" + second : second);
-    
-    return formattedTime;
+    return snprintf(output, sizeof(output), "%04d-%.2s-%.2s %.2s:%.2s:%.2s",
+                    year, digits + 2, digits + 4, digits + 6, digits + 8, digits + 10);
+}
+
+/**
+ * @brief 只解析接口响应中的指定顶层字段
+ * @param body 响应体
+ * @param fields 需要的字段名
+ * @param doc 输出：只含所需字段的文档
+ * @return DeserializationError 解析结果
+ */
+DeserializationError PushChannelBase::parseResponseFields(const String& body, std::initializer_list<const char*> fields,
+                                                          JsonDocument& doc) {
+    JsonDocument filter;
+    for (const char* field : fields) {
+        filter[field] = true;
+    }
+
+    // 被maxBodyBytes截断的响应会返回IncompleteInput，由调用方按解析失败处理
+    return deserializeJson(doc, body.c_str(), body.length(),
+                           DeserializationOption::Filter(filter),
+                           DeserializationOption::NestingLimit(PUSH_RESPONSE_NESTING_LIMIT));
 }
 
 /**
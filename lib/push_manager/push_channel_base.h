@@ -12,6 +12,12 @@
 
 #include <Arduino.h>
 #include <map>
+#include <memory>
+#include <initializer_list>
+#include <ArduinoJson.h>
+#include "message_template.h"
+#include "../message_arena/message_arena.h"
+#include "../sms_trace/sms_trace.h"
 
 /**
  * @enum PushResult
@@ -23,7 +29,9 @@ enum PushResult {
     PUSH_NO_RULE = 2,      ///< 没有匹配的规则
     PUSH_RULE_DISABLED = 3, ///< 规则已禁用
     PUSH_CONFIG_ERROR = 4,  ///< 配置错误
-    PUSH_NETWORK_ERROR = 5  ///< 网络错误
+    PUSH_NETWORK_ERROR = 5, ///< 网络错误
+    PUSH_DEFERRED = 6,      ///< 端点限流或熔断，已推迟到发件箱稍后重试
+    PUSH_PENDING = 7        ///< 已交给渠道的客户端，等待服务器确认后再结算发件箱
 };
 
 /**
@@ -35,6 +43,19 @@ struct PushContext {
     String content;        ///< 短信内容
     String timestamp;      ///< 接收时间戳
     int smsRecordId;       ///< 短信记录ID
+    int outboxId = -1;     ///< 发件箱条目ID（异步确认的渠道以此作为确认标记，-1表示无）
+    SmsTrace trace;        ///< 链路追踪（只有刚收到的短信才启动）
+};
+
+/**
+ * @struct PushChannelConfig
+ * @brief 已解析并校验的渠道配置基类
+ *
+ * 各渠道派生自己的类型化配置结构体，由prepareConfig()生成，
+ * 生成后只读，可在多个推送之间共享
+ */
+struct PushChannelConfig {
+    virtual ~PushChannelConfig() = default;
 };
 
 /**
@@ -94,6 +115,37 @@ public:
      */
     virtual PushResult push(const String& config, const PushContext& context) = 0;
 
+    /**
+     * @brief 解析并校验推送配置
+     * @param config 推送配置（JSON格式）
+     * @return std::shared_ptr<const PushChannelConfig> 类型化配置，配置无效时返回nullptr（错误信息见getLastError()）
+     */
+    virtual std::shared_ptr<const PushChannelConfig> prepareConfig(const String& config) = 0;
+
+    /**
+     * @brief 使用预解析的配置执行推送（不再解析JSON）
+     * @param config 由同一渠道的prepareConfig()生成的配置
+     * @param context 推送上下文
+     * @return PushResult 推送结果
+     */
+    virtual PushResult pushPrepared(const PushChannelConfig& config, const PushContext& context) = 0;
+
+    /**
+     * @brief 渠道是否支持汇总推送
+     * @return true 支持
+     * @return false 不支持（默认）
+     */
+    virtual bool supportsDigest() const;
+
+    /**
+     * @brief 推送多条短信的汇总消息
+     * @param config 由同一渠道的prepareConfig()生成的配置
+     * @param title 汇总标题
+     * @param body 汇总正文（Markdown）
+     * @return PushResult 推送结果
+     */
+    virtual PushResult pushDigest(const PushChannelConfig& config, const String& title, const String& body);
+
     /**
      * @brief 测试推送配置
      * @param config 推送配置（JSON格式）
@@ -149,6 +201,25 @@ protected:
      */
     String applyTemplate(const String& templateStr, const PushContext& context, bool escapeForJson = false);
 
+    /**
+     * @brief 渲染预编译的消息模板
+     * @param messageTemplate 预编译模板
+     * @param context 推送上下文
+     * @param escapeForJson 是否对占位符的值做JSON转义
+     * @return String 渲染后的消息
+     */
+    String renderTemplate(const CompiledTemplate& messageTemplate, const PushContext& context, bool escapeForJson = false);
+
+    /**
+     * @brief 渲染预编译的消息模板到内存区缓冲区（推送路径使用）
+     * @param output 输出缓冲区（追加写入）
+     * @param messageTemplate 预编译模板
+     * @param context 推送上下文
+     * @param escapeForJson 是否对占位符的值做JSON转义
+     */
+    void renderTemplate(ArenaText& output, const CompiledTemplate& messageTemplate, const PushContext& context,
+                        bool escapeForJson = false);
+
     /**
      * @brief 格式化时间戳
      * @param timestamp PDU时间戳
@@ -156,6 +227,27 @@ protected:
      */
     String formatTimestamp(const String& timestamp);
 
+    /**
+     * @brief 格式化时间戳到字符数组（不分配内存）
+     * @param timestamp PDU时间戳
+     * @param output 输出（YYYY-MM-DD HH:mm:ss）
+     * @return size_t 输出长度
+     */
+    static size_t formatTimestamp(const String& timestamp, char (&output)[PUSH_TIMESTAMP_TEXT_SIZE]);
+
+    /**
+     * @brief 只解析接口响应中的指定顶层字段
+     *
+     * 以过滤器解析，其余字段（含嵌套对象）在解析时直接跳过，不占用文档内存；
+     * 响应体应已由HttpRequest::maxBodyBytes限制为PUSH_RESPONSE_MAX_BYTES
+     * @param body 响应体
+     * @param fields 需要的字段名
+     * @param doc 输出：只含所需字段的文档
+     * @return DeserializationError 解析结果
+     */
+    static DeserializationError parseResponseFields(const String& body, std::initializer_list<const char*> fields,
+                                                    JsonDocument& doc);
+
     /**
      * @brief 设置错误信息
      * @param error 错误信息
@@ -124,6 +124,67 @@ std::unique_ptr<PushChannelBase> PushChannelRegistry::createChannel(const String
     }
 }
 
+/**
+ * @brief 租用渠道实例
+ * @param name 渠道名称或别名
+ * @return ChannelLease 渠道实例，渠道不存在时为空
+ */
+PushChannelRegistry::ChannelLease PushChannelRegistry::acquireChannel(const String& name) {
+    ChannelMetadata* metadata = findChannel(name);
+    if (metadata == nullptr) {
+        setError("Channel not found: " + name);
+        return ChannelLease(nullptr, ChannelReleaser{name});
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        auto it = idleChannels.find(metadata->name);
+        if (it != idleChannels.end() && !it->second.empty()) {
+            PushChannelBase* channel = it->second.back().release();
+            it->second.pop_back();
+            return ChannelLease(channel, ChannelReleaser{metadata->name});
+        }
+    }
+    
+    // 池中没有空闲实例时新建，归还后进入池中
+    std::unique_ptr<PushChannelBase> channel = createChannel(metadata->name);
+    return ChannelLease(channel.release(), ChannelReleaser{metadata->name});
+}
+
+/**
+ * @brief 归还实例
+ * @param channel 渠道实例
+ */
+void PushChannelRegistry::ChannelReleaser::operator()(PushChannelBase* channel) const {
+    PushChannelRegistry::getInstance().releaseChannel(name, channel);
+}
+
+/**
+ * @brief 归还租用的实例
+ * @param name 渠道名称（规范名）
+ * @param channel 渠道实例
+ */
+void PushChannelRegistry::releaseChannel(const String& name, PushChannelBase* channel) {
+    std::unique_ptr<PushChannelBase> owned(channel);
+    if (findChannel(name) == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::vector<std::unique_ptr<PushChannelBase>>& pool = idleChannels[name];
+    if (pool.size() < PUSH_CHANNEL_POOL_SIZE) {
+        pool.push_back(std::move(owned));
+    }
+}
+
+/**
+ * @brief 释放所有空闲的池化实例
+ */
+void PushChannelRegistry::clearChannelPool() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    idleChannels.clear();
+}
+
 /**
  * @brief 检查渠道是否支持
  * @param name 渠道名称或别名
@@ -179,6 +240,8 @@ bool PushChannelRegistry::unregisterChannel(const String& name) {
     if (it != channels.end()) {
         debugPrint("Channel unregistered: " + name);
         channels.erase(it);
+        std::lock_guard<std::mutex> lock(poolMutex);
+        idleChannels.erase(name);
         return true;
     }
     
@@ -192,6 +255,7 @@ bool PushChannelRegistry::unregisterChannel(const String& name) {
 void PushChannelRegistry::clear() {
     size_t count = channels.size();
     channels.clear();
+    clearChannelPool();
     debugPrint("All channels cleared (" + String(count) + " channels)");
 }
 
@@ -14,7 +14,10 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <map>
+#include <mutex>
 #include "push_channel_base.h"
+#include "../../include/constants.h"
 
 /**
  * @class PushChannelRegistry
@@ -33,6 +36,24 @@ public:
      */
     using ChannelFactory = std::function<std::unique_ptr<PushChannelBase>()>;
     
+    /**
+     * @brief 池化实例的归还器：租用结束时把实例放回注册器的空闲池
+     */
+    struct ChannelReleaser {
+        String name;    ///< 渠道名称（规范名）
+        
+        /**
+         * @brief 归还实例
+         * @param channel 渠道实例
+         */
+        void operator()(PushChannelBase* channel) const;
+    };
+    
+    /**
+     * @brief 租用的渠道实例，离开作用域或reset()时归还到空闲池
+     */
+    using ChannelLease = std::unique_ptr<PushChannelBase, ChannelReleaser>;
+    
     /**
      * @brief 渠道元数据结构
      */
@@ -74,6 +95,20 @@ public:
      */
     std::unique_ptr<PushChannelBase> createChannel(const String& name);
     
+    /**
+     * @brief 租用渠道实例：优先取空闲池中的实例，池空时新建
+     * 
+     * 实例在租用期间独占，归还后保留已解析的配置等预热状态供下次使用
+     * @param name 渠道名称或别名
+     * @return ChannelLease 渠道实例，渠道不存在时为空
+     */
+    ChannelLease acquireChannel(const String& name);
+    
+    /**
+     * @brief 释放所有空闲的池化实例
+     */
+    void clearChannelPool();
+    
     /**
      * @brief 检查渠道是否支持
      * @param name 渠道名称或别名
@@ -158,6 +193,13 @@ private:
      */
     ChannelMetadata* findChannel(const String& name);
     
+    /**
+     * @brief 归还租用的实例（空闲池已满或渠道已注销时销毁）
+     * @param name 渠道名称（规范名）
+     * @param channel 渠道实例
+     */
+    void releaseChannel(const String& name, PushChannelBase* channel);
+    
     /**
      * @brief 检查渠道名称是否有效
      * @param name 渠道名称
@@ -179,6 +221,8 @@ private:
 
 private:
     std::vector<ChannelMetadata> channels;  ///< 注册的渠道列表
+    std::map<String, std::vector<std::unique_ptr<PushChannelBase>>> idleChannels; ///< 按渠道名的空闲实例池
+    std::mutex poolMutex;                   ///< 保护idleChannels
     bool debugMode;                         ///< 调试模式
     String lastError;                       ///< 最后的错误信息
 };
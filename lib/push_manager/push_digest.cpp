@@ -0,0 +1,180 @@
+/**
+ * @file push_digest.cpp
+ * @brief 推送汇总缓冲实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "push_digest.h"
+#include <limits.h>
+
+/**
+ * @brief 构造函数
+ */
+PushDigestBuffer::PushDigestBuffer() {
+}
+
+/**
+ * @brief 将一条短信加入规则的汇总
+ * @param rule 转发规则
+ * @param config 预解析的渠道配置
+ * @param policy 汇总策略
+ * @param context 推送上下文
+ * @param formattedTime 格式化后的接收时间
+ * @param outboxId 该短信的发件箱条目ID
+ * @param followerRuleIds 推送目标相同的规则ID
+ * @param ready 输出：应立即发送的汇总
+ * @return true 已加入汇总
+ * @return false 并发汇总数已达上限
+ */
+bool PushDigestBuffer::add(const ForwardRule& rule, const std::shared_ptr<const PushChannelConfig>& config,
+                           const DigestPolicy& policy, const PushContext& context, const String& formattedTime,
+                           int outboxId, const String& followerRuleIds, std::vector<PendingDigest>& ready) {
+    String item;
+    item.reserve(context.sender.length() + formattedTime.length() + context.content.length() + 16);
+    item += "**";
+    item += context.sender;
+    item += "**  ";
+    item += formattedTime;
+    item += "\n";
+    item += context.content;
+    item += "\n\n";
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = pending.begin();
+    while (it != pending.end() && it->rule.id != rule.id) {
+        ++it;
+    }
+
+    // 正文放不下时先交出已有内容
+    if (it != pending.end() && it->body.length() + item.length() > PUSH_MESSAGE_MAX_LENGTH) {
+        markFlushingLocked(*it);
+        ready.push_back(std::move(*it));
+        pending.erase(it);
+        it = pending.end();
+    }
+
+    if (it == pending.end()) {
+        if (pending.size() >= DIGEST_MAX_PENDING) {
+            return false;
+        }
+        PendingDigest digest;
+        digest.rule = rule;
+        digest.config = config;
+        digest.policy = policy;
+        digest.openedAt = millis();
+        pending.push_back(std::move(digest));
+        it = pending.end() - 1;
+    }
+
+    it->entries.push_back(DigestEntry{context.smsRecordId, context.timestamp, outboxId, followerRuleIds});
+    it->body += item;
+
+    if (it->entries.size() >= it->policy.maxMessages) {
+        markFlushingLocked(*it);
+        ready.push_back(std::move(*it));
+        pending.erase(it);
+    }
+
+    return true;
+}
+
+/**
+ * @brief 取出到期的汇总
+ * @param now 当前时间（millis）
+ * @param ready 输出的汇总
+ * @return size_t 取出的数量
+ */
+size_t PushDigestBuffer::takeDue(unsigned long now, std::vector<PendingDigest>& ready) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t taken = 0;
+    auto it = pending.begin();
+    while (it != pending.end()) {
+        if (now - it->openedAt >= it->policy.windowMs) {
+            markFlushingLocked(*it);
+            ready.push_back(std::move(*it));
+            it = pending.erase(it);
+            taken++;
+        } else {
+            ++it;
+        }
+    }
+    return taken;
+}
+
+/**
+ * @brief 交出的汇总发送并结算完毕后调用
+ * @param digest 已发送的汇总
+ */
+void PushDigestBuffer::release(const PendingDigest& digest) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const DigestEntry& entry : digest.entries) {
+        flushing.erase(entry.outboxId);
+    }
+}
+
+/**
+ * @brief 发件箱条目是否仍由汇总持有
+ * @param outboxId 发件箱条目ID
+ * @return true 由汇总持有
+ * @return false 未被持有
+ */
+bool PushDigestBuffer::holds(int outboxId) const {
+    if (outboxId <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (flushing.count(outboxId) > 0) {
+        return true;
+    }
+    for (const PendingDigest& digest : pending) {
+        for (const DigestEntry& entry : digest.entries) {
+            if (entry.outboxId == outboxId) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 把交出的汇总中的发件箱条目记为发送中（调用方持有mutex）
+ * @param digest 交出的汇总
+ */
+void PushDigestBuffer::markFlushingLocked(const PendingDigest& digest) {
+    for (const DigestEntry& entry : digest.entries) {
+        if (entry.outboxId > 0) {
+            flushing.insert(entry.outboxId);
+        }
+    }
+}
+
+/**
+ * @brief 计算距离最近一个汇总到期的时间
+ * @param now 当前时间（millis）
+ * @return unsigned long 毫秒数，没有待发送的汇总时返回ULONG_MAX
+ */
+unsigned long PushDigestBuffer::nextDueIn(unsigned long now) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    unsigned long nearest = ULONG_MAX;
+    for (const PendingDigest& digest : pending) {
+        unsigned long elapsed = now - digest.openedAt;
+        unsigned long remaining = elapsed >= digest.policy.windowMs ? 0 : digest.policy.windowMs - elapsed;
+        if (remaining < nearest) {
+            nearest = remaining;
+        }
+    }
+    return nearest;
+}
+
+/**
+ * @brief 获取待发送的汇总数量
+ * @return size_t 数量
+ */
+size_t PushDigestBuffer::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
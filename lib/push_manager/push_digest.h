@@ -0,0 +1,140 @@
+/**
+ * @file push_digest.h
+ * @brief 推送汇总缓冲 - 将短时间内命中同一规则的短信合并为一条汇总消息
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 按规则暂存命中的短信，并预先拼接好汇总正文
+ * 2. 汇总窗口到期或条数达到上限时交出待发送的汇总
+ * 3. 计算最近的到期时间，供推送工作线程按需唤醒
+ * 4. 记录暂存及正在发送的汇总所含的发件箱条目，发件箱重试时跳过它们
+ *
+ * 汇总通过规则推送配置中的digest_window（秒）与digest_max（条）开启，
+ * 实际发送由PushManager完成；加入汇总的短信已写入发件箱，缓冲区内容
+ * 在重启后丢失时由发件箱逐条重试
+ */
+
+#ifndef PUSH_DIGEST_H
+#define PUSH_DIGEST_H
+
+#include <Arduino.h>
+#include <vector>
+#include <set>
+#include <memory>
+#include <mutex>
+#include "push_channel_base.h"
+#include "../database_manager/database_manager.h"
+#include "../../include/constants.h"
+
+/**
+ * @struct DigestPolicy
+ * @brief 规则的汇总策略
+ */
+struct DigestPolicy {
+    uint32_t windowMs = 0;          ///< 汇总窗口（毫秒，0表示不汇总）
+    uint16_t maxMessages = 0;       ///< 单条汇总最多包含的短信数
+};
+
+/**
+ * @struct DigestEntry
+ * @brief 汇总中的一条短信
+ */
+struct DigestEntry {
+    int smsRecordId;                ///< 短信记录ID
+    String timestamp;               ///< PDU时间戳（用于更新转发状态）
+    int outboxId;                   ///< 发件箱条目ID（-1表示未写入）
+    String followerRuleIds;         ///< 推送目标相同、随本条汇总记录结果的规则ID（逗号分隔）
+};
+
+/**
+ * @struct PendingDigest
+ * @brief 待发送的汇总
+ */
+struct PendingDigest {
+    ForwardRule rule;                                   ///< 所属规则
+    std::shared_ptr<const PushChannelConfig> config;    ///< 预解析的渠道配置
+    DigestPolicy policy;                                ///< 汇总策略
+    unsigned long openedAt = 0;                         ///< 第一条短信加入的时间（millis）
+    std::vector<DigestEntry> entries;                   ///< 包含的短信
+    String body;                                        ///< 已拼接的汇总正文（Markdown）
+};
+
+/**
+ * @class PushDigestBuffer
+ * @brief 推送汇总缓冲区（线程安全）
+ */
+class PushDigestBuffer {
+public:
+    /**
+     * @brief 构造函数
+     */
+    PushDigestBuffer();
+
+    /**
+     * @brief 将一条短信加入规则的汇总
+     *
+     * 正文超出PUSH_MESSAGE_MAX_LENGTH时，先把已有内容交出再开始新的汇总
+     * @param rule 转发规则
+     * @param config 预解析的渠道配置
+     * @param policy 汇总策略
+     * @param context 推送上下文
+     * @param formattedTime 格式化后的接收时间
+     * @param outboxId 该短信的发件箱条目ID
+     * @param followerRuleIds 推送目标相同、随本条汇总记录结果的规则ID（逗号分隔）
+     * @param ready 输出：已满或被挤出、应立即发送的汇总
+     * @return true 已加入汇总
+     * @return false 并发汇总数已达上限，调用方应直接推送
+     */
+    bool add(const ForwardRule& rule, const std::shared_ptr<const PushChannelConfig>& config,
+             const DigestPolicy& policy, const PushContext& context, const String& formattedTime,
+             int outboxId, const String& followerRuleIds, std::vector<PendingDigest>& ready);
+
+    /**
+     * @brief 取出到期的汇总
+     * @param now 当前时间（millis）
+     * @param ready 输出的汇总
+     * @return size_t 取出的数量
+     */
+    size_t takeDue(unsigned long now, std::vector<PendingDigest>& ready);
+
+    /**
+     * @brief 交出的汇总发送并结算完毕后调用，其发件箱条目不再视为由汇总持有
+     * @param digest 已发送的汇总
+     */
+    void release(const PendingDigest& digest);
+
+    /**
+     * @brief 发件箱条目是否仍由汇总持有（暂存中或已交出尚未结算）
+     * @param outboxId 发件箱条目ID
+     * @return true 由汇总持有，发件箱不应重试
+     * @return false 未被持有
+     */
+    bool holds(int outboxId) const;
+
+    /**
+     * @brief 计算距离最近一个汇总到期的时间
+     * @param now 当前时间（millis）
+     * @return unsigned long 毫秒数，没有待发送的汇总时返回ULONG_MAX
+     */
+    unsigned long nextDueIn(unsigned long now) const;
+
+    /**
+     * @brief 获取待发送的汇总数量
+     * @return size_t 数量
+     */
+    size_t pendingCount() const;
+
+private:
+    /**
+     * @brief 把交出的汇总中的发件箱条目记为发送中（调用方持有mutex）
+     * @param digest 交出的汇总
+     */
+    void markFlushingLocked(const PendingDigest& digest);
+
+    std::vector<PendingDigest> pending;     ///< 正在收集的汇总（每条规则最多一个）
+    std::set<int> flushing;                 ///< 已交出、尚未结算的汇总中的发件箱条目ID
+    mutable std::mutex mutex;               ///< 保护pending与flushing
+};
+
+#endif // PUSH_DIGEST_H
@@ -6,11 +6,18 @@
  */
 
 #include "push_manager.h"
+#include "push_worker.h"
+#include "mqtt_session.h"
 #include "../log_manager/log_manager.h"
 #include "../database_manager/database_manager.h"
-#include "../http_client/http_diagnostics.h"
+#include "../db_worker/db_worker.h"
+#include "../http_client/http_client.h"
+#include "../gsm_service/gsm_service.h"
+#include "../event_bus/event_bus.h"
+#include "../metrics/metrics.h"
 #include "../../include/constants.h"
 #include <ArduinoJson.h>
+#include <limits.h>
 
 // 包含所有推送渠道实现以触发自动注册
 #include "channels/wecom_channel.cpp"
@@ -18,6 +25,7 @@
 #include "channels/dingtalk_channel.cpp"
 #include "channels/webhook_channel.cpp"
 #include "channels/feishu_bot_channel.cpp"
+#include "channels/mqtt_channel.cpp"
 
 // 单例实例
 PushManager& PushManager::getInstance() {
@@ -29,7 +37,7 @@ PushManager& PushManager::getInstance() {
  * @brief 构造函数
  */
 PushManager::PushManager() 
-    : debugMode(false), initialized(false), cacheLoaded(false) {
+    : debugMode(false), initialized(false), pushPaused(false) {
 }
 
 /**
@@ -51,44 +59,54 @@ bool PushManager::initialize() {
     // 首先启用推送管理器的调试模式
     debugMode = true;
     
-    debugPrint("初始化推送管理器...");
+    LOG_DEBUG_PRINT("初始化推送管理器...");
     
     // 启用渠道注册器的调试模式
     PushChannelRegistry& registry = PushChannelRegistry::getInstance();
     registry.setDebugMode(true);
     
     // 渠道通过REGISTER_PUSH_CHANNEL宏自动注册，无需手动注册
-    debugPrint("检查自动注册的推送渠道...");
+    LOG_DEBUG_PRINT("检查自动注册的推送渠道...");
     
     // 检查渠道注册状态
     size_t channelCount = registry.getChannelCount();
-    debugPrint("当前已注册渠道数量: " + String(channelCount));
+    LOG_DEBUG_PRINT("当前已注册渠道数量: " + String(channelCount));
     
     std::vector<String> availableChannels = registry.getAvailableChannels();
-    debugPrint("可用渠道列表:");
+    LOG_DEBUG_PRINT("可用渠道列表:");
     for (const String& channel : availableChannels) {
-        debugPrint("  - " + channel);
+        LOG_DEBUG_PRINT("  - " + channel);
     }
     
     if (channelCount == 0) {
-        debugPrint("警告: 没有注册任何推送渠道！");
+        LOG_DEBUG_PRINT("警告: 没有注册任何推送渠道！");
     }
     
+    // WiFi MQTT连接的PUBACK异步到达，确认后才结算发件箱条目
+    MqttSessionManager::getInstance().setDeliveryListener([this](int outboxId, bool delivered) {
+        reportDelivery(outboxId, delivered);
+    });
+    
     initialized = true;
-    debugPrint("推送管理器初始化成功");
+    LOG_DEBUG_PRINT("推送管理器初始化成功");
     
     // 测试数据库查询功能 - 主动触发一次规则缓存更新
-    debugPrint("=== 测试数据库查询功能 ===");
+    LOG_DEBUG_PRINT("=== 测试数据库查询功能 ===");
     PushContext testContext;
     testContext.sender = "测试发送方";
     testContext.content = "测试内容";
     testContext.timestamp = "240101120000";
     testContext.smsRecordId = -1;
     
-    // 这将触发matchForwardRules方法，从而执行数据库查询
-    std::vector<ForwardRule> testRules = matchForwardRules(testContext);
-    debugPrint("测试查询完成，获取到 " + String(testRules.size()) + " 条匹配规则");
-    debugPrint("=== 数据库查询测试结束 ===");
+    // 这将触发规则缓存加载，从而执行数据库查询
+    size_t testMatches = 0;
+    std::shared_ptr<const ForwardRuleSnapshot> testSnapshot = acquireRuleSnapshot();
+    if (testSnapshot) {
+        uint16_t testIndices[RULE_MATCH_MAX_RESULTS];
+        testMatches = matchForwardRules(testContext, *testSnapshot, testIndices, RULE_MATCH_MAX_RESULTS);
+    }
+    LOG_DEBUG_PRINT("测试查询完成，获取到 " + String(testMatches) + " 条匹配规则");
+    LOG_DEBUG_PRINT("=== 数据库查询测试结束 ===");
     
     return true;
 }
@@ -96,41 +114,275 @@ bool PushManager::initialize() {
 /**
  * @brief 处理短信推送
  * @param context 推送上下文
+ * @param matched 已有的规则匹配结果
  * @return PushResult 推送结果
  */
-PushResult PushManager::processSmsForward(const PushContext& context) {
+PushResult PushManager::processSmsForward(const PushContext& context, const MatchedRules* matched) {
+    PushResult result = forwardByMatchedRules(context, matched);
+    finishTrace(context);
+    return result;
+}
+
+/**
+ * @brief 以当前规则快照匹配短信（只匹配，不推送）
+ * @param context 推送上下文
+ * @param matched 输出：匹配结果
+ * @return int 命中规则的最小priority值，没有命中规则或规则不可用时返回-1
+ */
+int PushManager::matchRules(const PushContext& context, MatchedRules& matched) {
+    matched.snapshot = initialized ? acquireRuleSnapshot() : nullptr;
+    matched.count = 0;
+    if (!matched.snapshot) {
+        return -1;
+    }
+    
+    uint32_t matchStartUs = micros();
+    matched.count = matchForwardRules(context, *matched.snapshot, matched.indices, RULE_MATCH_MAX_RESULTS);
+    MetricsRegistry::getInstance().observe(METRIC_RULE_MATCH, micros() - matchStartUs);
+    SmsTrace::mark(SMS_TRACE_MATCHED);
+    
+    int priority = -1;
+    for (size_t i = 0; i < matched.count; i++) {
+        int rulePriority = matched.snapshot->rules[matched.indices[i]].priority;
+        if (priority < 0 || rulePriority < priority) {
+            priority = rulePriority;
+        }
+    }
+    return priority;
+}
+
+/**
+ * @brief 记录推送结束并保存当前任务的链路追踪
+ * @param context 推送上下文
+ */
+void PushManager::finishTrace(const PushContext& context) {
+    SmsTrace* trace = SmsTrace::current();
+    if (trace == nullptr || context.smsRecordId <= 0) {
+        return;
+    }
+    trace->record(SMS_TRACE_FINISHED);
+    String text = trace->serialize();
+    LOG_DEBUG_PRINT("短信 " + String(context.smsRecordId) + " 链路追踪: " + text);
+    // 追踪只用于诊断，投递后不等待；队列已满时丢弃
+    int smsRecordId = context.smsRecordId;
+    DbWorker::getInstance().post([this, smsRecordId, text]() {
+        DatabaseManager& db = DatabaseManager::getInstance();
+        if (!db.saveSmsTrace(smsRecordId, text)) {
+            LOG_DEBUG_PRINT("保存链路追踪失败: " + db.getLastError());
+        }
+    });
+}
+
+/**
+ * @brief 按匹配的转发规则推送短信（processSmsForward的主体）
+ * @param context 推送上下文
+ * @param matched 已有的规则匹配结果
+ * @return PushResult 推送结果
+ */
+PushResult PushManager::forwardByMatchedRules(const PushContext& context, const MatchedRules* matched) {
     if (!initialized) {
         setError("推送管理器未初始化");
         return PUSH_FAILED;
     }
     
-    debugPrint("开始处理短信推送，发送方: " + context.sender + ", 内容: " + context.content.substring(0, 50) + "...");
+    LOG_DEBUG_PRINT("开始处理短信推送，发送方: " + context.sender + ", 内容: " + context.content.substring(0, 50) + "...");
+    
+    // 匹配转发规则（只得到规则下标，不复制规则内容）；推送工作线程分队列时已匹配过的直接使用其结果。
+    // 持有匹配所用的规则快照，推送过程中即使规则缓存被刷新也不会失效
+    MatchedRules local;
+    if (matched == nullptr || !matched->snapshot) {
+        matchRules(context, local);
+        matched = &local;
+    }
+    std::shared_ptr<const ForwardRuleSnapshot> snapshot = matched->snapshot;
+    if (!snapshot) {
+        LOG_DEBUG_PRINT("加载规则缓存失败: " + lastError);
+        return PUSH_NO_RULE;
+    }
+    
+    // 同步推送路径下工作线程可能未被唤醒，顺带发送已到期的汇总
+    flushDueDigests();
     
-    // 匹配转发规则
-    std::vector<ForwardRule> matchedRules = matchForwardRules(context);
+    // 下标按优先级重排，复制一份，不修改任务中保存的匹配结果
+    uint16_t matchedIndices[RULE_MATCH_MAX_RESULTS];
+    size_t matchedCount = matched->count;
+    memcpy(matchedIndices, matched->indices, matchedCount * sizeof(uint16_t));
     
-    if (matchedRules.empty()) {
-        debugPrint("没有匹配的转发规则");
+    if (matchedCount == 0) {
+        LOG_DEBUG_PRINT("没有匹配的转发规则");
         return PUSH_NO_RULE;
     }
     
+    // 按规则优先级推送（插入排序保持同优先级规则的原有顺序，匹配数不超过RULE_MATCH_MAX_RESULTS）
+    for (size_t i = 1; i < matchedCount; i++) {
+        uint16_t index = matchedIndices[i];
+        int priority = snapshot->rules[index].priority;
+        size_t j = i;
+        while (j > 0 && snapshot->rules[matchedIndices[j - 1]].priority > priority) {
+            matchedIndices[j] = matchedIndices[j - 1];
+            j--;
+        }
+        matchedIndices[j] = index;
+    }
+    
     // 执行所有匹配的规则
     bool hasSuccess = false;
+    bool hasPending = false;
     PushResult lastResult = PUSH_FAILED;
     
-    for (const auto& rule : matchedRules) {
-        debugPrint("执行转发规则: " + rule.ruleName + " (ID: " + String(rule.id) + ")");
+    // 本条短信已推送过的目标（以推送渠道与配置相同的首条规则标识）及其结果
+    uint16_t pushedLeaders[RULE_MATCH_MAX_RESULTS];
+    PushResult pushedResults[RULE_MATCH_MAX_RESULTS];
+    bool pushedDeferred[RULE_MATCH_MAX_RESULTS];
+    size_t pushedCount = 0;
+    std::vector<PendingDigest> readyDigests;
+    String formattedTime;
+    
+    for (size_t i = 0; i < matchedCount; i++) {
+        const ForwardRule& rule = snapshot->rules[matchedIndices[i]];
+        LOG_DEBUG_PRINT("执行转发规则: " + rule.ruleName + " (ID: " + String(rule.id) + ")");
+        
+        // 渠道与配置相同的规则渲染出的请求完全一致，同一条短信只发送一次，复用结果
+        uint16_t leader = snapshot->destinationLeaders[matchedIndices[i]];
+        size_t pushed = 0;
+        while (pushed < pushedCount && pushedLeaders[pushed] != leader) {
+            pushed++;
+        }
+        // 汇总、推迟或等待确认的结果由首条规则的发件箱条目结算时一并记录
+        if (pushed < pushedCount && pushedDeferred[pushed]) {
+            LOG_DEBUG_PRINT("规则 " + rule.ruleName + " 与规则 " + snapshot->rules[leader].ruleName + " 推送目标相同，已随其汇总发送");
+            hasSuccess = true;
+            continue;
+        }
+        if (pushed < pushedCount) {
+            PushResult result = pushedResults[pushed];
+            LOG_DEBUG_PRINT("规则 " + rule.ruleName + " 与规则 " + snapshot->rules[leader].ruleName + " 推送目标相同，复用推送结果");
+            if (result != PUSH_DEFERRED && result != PUSH_PENDING) {
+                recordForwardResult(rule, context, result);
+            }
+            if (result == PUSH_SUCCESS) {
+                hasSuccess = true;
+            } else if (result == PUSH_PENDING) {
+                hasPending = true;
+            }
+            lastResult = result;
+            continue;
+        }
+        
+        // 之后推送目标相同的规则复用本次结果，记在发件箱条目上，条目结算或重试时一并记录
+        String followerRuleIds;
+        for (size_t j = i + 1; j < matchedCount; j++) {
+            if (snapshot->destinationLeaders[matchedIndices[j]] == leader) {
+                if (!followerRuleIds.isEmpty()) {
+                    followerRuleIds += ",";
+                }
+                followerRuleIds += String(snapshot->rules[matchedIndices[j]].id);
+            }
+        }
+        
+        // 开启汇总的规则先暂存，窗口到期或条数达到上限时合并为一条推送；
+        // 发件箱条目的首次重试推迟到窗口之后，期间重启时由drainOutbox逐条补发
+        const DigestPolicy& policy = snapshot->digestPolicies[matchedIndices[i]];
+        int outboxId = -1;
+        if (policy.windowMs > 0 && context.smsRecordId > 0) {
+            if (formattedTime.isEmpty()) {
+                formattedTime = formatTimestamp(context.timestamp);
+            }
+            outboxId = journalOutboxEntry(rule, context, policy.windowMs / 1000 + PUSH_OUTBOX_BASE_DELAY_S,
+                                          followerRuleIds);
+            if (digestBuffer.add(rule, snapshot->channelConfigs[matchedIndices[i]], policy, context,
+                                 formattedTime, outboxId, followerRuleIds, readyDigests)) {
+                LOG_DEBUG_PRINT("规则 " + rule.ruleName + " 已开启汇总，短信暂存待合并推送");
+                pushedLeaders[pushedCount] = leader;
+                pushedResults[pushedCount] = PUSH_SUCCESS;
+                pushedDeferred[pushedCount] = true;
+                pushedCount++;
+                hasSuccess = true;
+                continue;
+            }
+            LOG_DEBUG_PRINT("待发送汇总数已达上限，规则 " + rule.ruleName + " 改为直接推送");
+        }
+        
+        // 先写入发件箱，推送成功后删除；失败或中途重启时由drainOutbox重试
+        if (outboxId <= 0) {
+            outboxId = journalOutboxEntry(rule, context, PUSH_OUTBOX_BASE_DELAY_S, followerRuleIds);
+        }
+        PushOutboxEntry entry;
+        entry.id = outboxId;
+        entry.smsId = context.smsRecordId;
+        entry.ruleId = rule.id;
+        entry.attempt = 0;
+        entry.nextAttemptAt = 0;
+        entry.createdAt = 0;
+        entry.followerRuleIds = followerRuleIds;
+        
+        // 端点限流或熔断时不发起请求：有发件箱条目的推迟到之后重试，否则直接算作失败
+        PushResult result = PUSH_FAILED;
+        uint32_t endpoint = 0;
+        unsigned long retryInMs = 0;
+        if (!admitEndpoint(rule, endpoint, retryInMs)) {
+            if (outboxId > 0) {
+                deferOutboxEntry(entry, retryInMs);
+                result = PUSH_DEFERRED;
+            } else {
+                recordForwardResult(rule, context, result);
+            }
+        } else {
+            result = executePush(rule, context, snapshot->channelConfigs[matchedIndices[i]].get(), outboxId);
+            if (result == PUSH_PENDING) {
+                // 发件箱条目保留到服务器确认，期间重启时由drainOutbox重发
+                awaitDelivery(rule, context, entry, endpoint);
+            } else {
+                endpointGuard.report(endpoint, result, millis());
+                if (outboxId > 0) {
+                    settleOutboxEntry(entry, result);
+                }
+            }
+        }
+        
+        pushedLeaders[pushedCount] = leader;
+        pushedResults[pushedCount] = result;
+        pushedDeferred[pushedCount] = false;
+        pushedCount++;
         
-        PushResult result = executePush(rule, context);
         if (result == PUSH_SUCCESS) {
             hasSuccess = true;
             lastResult = PUSH_SUCCESS;
         } else {
+            hasPending = hasPending || result == PUSH_PENDING;
             lastResult = result;
         }
     }
     
-    return hasSuccess ? PUSH_SUCCESS : lastResult;
+    // 已满或因正文超长被挤出的汇总立即发送
+    for (PendingDigest& digest : readyDigests) {
+        flushDigest(digest);
+        digestBuffer.release(digest);
+    }
+    
+    if (hasSuccess) {
+        return PUSH_SUCCESS;
+    }
+    return hasPending ? PUSH_PENDING : lastResult;
+}
+
+/**
+ * @brief 测量以当前规则快照匹配一条短信的耗时（只匹配，不推送）
+ * @param name 测量项名称
+ * @param context 推送上下文
+ * @param iterations 执行次数
+ * @return BenchmarkResult 测量结果（规则快照不可用时iterations为0）
+ */
+BenchmarkResult PushManager::benchmarkRuleMatch(const String& name, const PushContext& context, int iterations) {
+    std::shared_ptr<const ForwardRuleSnapshot> snapshot = initialized ? acquireRuleSnapshot() : nullptr;
+    if (!snapshot) {
+        return Benchmark::run(name, 0, nullptr);
+    }
+    
+    uint16_t matchedIndices[RULE_MATCH_MAX_RESULTS];
+    return Benchmark::run(name + " (" + String((int)snapshot->rules.size()) + "条规则)", iterations, [&]() {
+        matchForwardRules(context, *snapshot, matchedIndices, RULE_MATCH_MAX_RESULTS);
+    });
 }
 
 /**
@@ -145,8 +397,14 @@ PushResult PushManager::pushByRule(int ruleId, const PushContext& context) {
         return PUSH_FAILED;
     }
     
-    DatabaseManager& dbManager = DatabaseManager::getInstance();
-    ForwardRule rule = dbManager.getForwardRuleById(ruleId);
+    ForwardRule rule;
+    rule.id = 0;
+    if (!DbWorker::getInstance().call([&rule, ruleId]() {
+            rule = DatabaseManager::getInstance().getForwardRuleById(ruleId);
+        })) {
+        setError("读取转发规则失败: " + DbWorker::getInstance().getLastError());
+        return PUSH_FAILED;
+    }
     
     if (rule.id <= 0) {
         setError("转发规则不存在: " + String(ruleId));
@@ -161,6 +419,261 @@ PushResult PushManager::pushByRule(int ruleId, const PushContext& context) {
     return executePush(rule, context);
 }
 
+/**
+ * @brief 处理发件箱中到期的重试条目
+ * @param maxEntries 本轮最多处理的条目数
+ * @return int 本轮实际重试的条目数
+ */
+int PushManager::drainOutbox(int maxEntries) {
+    if (!initialized) {
+        setError("推送管理器未初始化");
+        return 0;
+    }
+    
+    DbWorker& dbWorker = DbWorker::getInstance();
+    time_t now = time(nullptr);
+    std::vector<PushOutboxEntry> entries;
+    if (!dbWorker.call([&]() {
+            entries = DatabaseManager::getInstance().getDuePushOutboxEntries(now, PUSH_OUTBOX_MAX_DELAY_S, maxEntries);
+        })) {
+        setError("读取发件箱失败: " + dbWorker.getLastError());
+        return 0;
+    }
+    
+    int retried = 0;
+    for (auto& entry : entries) {
+        // 上次发布的确认还未到达，确认失败或超时后再按退避重试
+        if (isAwaitingDelivery(entry.id)) {
+            continue;
+        }
+        // 仍在汇总中或汇总正在发送：首次重试时间按窗口推迟，但时钟同步前写入的条目
+        // 同步后会立即到期，由汇总结算而不是在这里重发
+        if (digestBuffer.holds(entry.id)) {
+            continue;
+        }
+        
+        // 关联的短信或规则已失效时在同一请求中丢弃条目
+        SMSRecord record;
+        record.id = 0;
+        ForwardRule rule;
+        rule.id = 0;
+        rule.enabled = false;
+        if (!dbWorker.call([&]() {
+                DatabaseManager& dbManager = DatabaseManager::getInstance();
+                record = dbManager.getSMSRecordById(entry.smsId);
+                if (record.id > 0) {
+                    rule = dbManager.getForwardRuleById(entry.ruleId);
+                }
+                if (record.id <= 0 || rule.id <= 0 || !rule.enabled) {
+                    dbManager.deletePushOutboxEntry(entry.id);
+                }
+            })) {
+            setError("读取发件箱条目失败: " + dbWorker.getLastError());
+            break;
+        }
+        if (record.id <= 0) {
+            LOG_DEBUG_PRINT("发件箱条目 " + String(entry.id) + " 关联的短信已删除，丢弃");
+            continue;
+        }
+        if (rule.id <= 0 || !rule.enabled) {
+            LOG_DEBUG_PRINT("发件箱条目 " + String(entry.id) + " 关联的规则不存在或已禁用，丢弃");
+            continue;
+        }
+        
+        // 由短信记录重建推送上下文，时间戳还原为PDU格式供模板使用
+        PushContext context;
+        context.sender = record.fromNumber;
+        context.content = record.content;
+        context.smsRecordId = record.id;
+        context.outboxId = entry.id;
+        struct tm timeinfo;
+        time_t receivedAt = record.receivedAt;
+        localtime_r(&receivedAt, &timeinfo);
+        char pduTime[16];
+        strftime(pduTime, sizeof(pduTime), "%y%m%d%H%M%S", &timeinfo);
+        context.timestamp = String(pduTime);
+        
+        uint32_t endpoint = 0;
+        unsigned long retryInMs = 0;
+        if (!admitEndpoint(rule, endpoint, retryInMs)) {
+            deferOutboxEntry(entry, retryInMs);
+            continue;
+        }
+        
+        LOG_DEBUG_PRINT("重试发件箱条目 " + String(entry.id) + "，规则: " + rule.ruleName +
+                   "，第 " + String(entry.attempt + 1) + " 次");
+        
+        PushResult result = executePush(rule, context);
+        if (result == PUSH_PENDING) {
+            awaitDelivery(rule, context, entry, endpoint);
+        } else {
+            endpointGuard.report(endpoint, result, millis());
+            recordFollowerResults(entry.followerRuleIds, context, result);
+            settleOutboxEntry(entry, result);
+        }
+        retried++;
+    }
+    
+    return retried;
+}
+
+/**
+ * @brief 发送所有已到期的汇总
+ * @return int 发送的汇总数
+ */
+int PushManager::flushDueDigests() {
+    std::vector<PendingDigest> ready;
+    digestBuffer.takeDue(millis(), ready);
+    
+    for (PendingDigest& digest : ready) {
+        flushDigest(digest);
+        digestBuffer.release(digest);
+    }
+    return static_cast<int>(ready.size());
+}
+
+/**
+ * @brief 获取距离下一个汇总到期的时间
+ * @return unsigned long 毫秒数，没有待发送的汇总时返回ULONG_MAX
+ */
+unsigned long PushManager::getNextDigestDelayMs() const {
+    return digestBuffer.nextDueIn(millis());
+}
+
+/**
+ * @brief 报告一条异步确认推送的结果
+ * @param outboxId 发件箱条目ID
+ * @param delivered 是否已被服务器确认
+ */
+void PushManager::reportDelivery(int outboxId, bool delivered) {
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        deliveryReports.push_back(DeliveryReport{outboxId, delivered, millis()});
+    }
+    PushWorker::getInstance().wake();
+}
+
+/**
+ * @brief 结算已收到确认结果或等待超时的推送
+ * @return int 结算的推送数
+ */
+int PushManager::settleDeliveries() {
+    std::vector<std::pair<PendingDelivery, PushResult>> finished;
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        unsigned long now = millis();
+        
+        // 同步推送路径可能在登记前就收到确认，未匹配的结果保留到超时
+        std::vector<DeliveryReport> unmatched;
+        for (const DeliveryReport& report : deliveryReports) {
+            auto it = pendingDeliveries.find(report.outboxId);
+            if (it != pendingDeliveries.end()) {
+                finished.emplace_back(it->second, report.delivered ? PUSH_SUCCESS : PUSH_NETWORK_ERROR);
+                pendingDeliveries.erase(it);
+            } else if (now - report.receivedAt < PUSH_DELIVERY_TIMEOUT_MS) {
+                unmatched.push_back(report);
+            }
+        }
+        deliveryReports.swap(unmatched);
+        
+        for (auto it = pendingDeliveries.begin(); it != pendingDeliveries.end();) {
+            if ((long)(now - it->second.deadline) >= 0) {
+                finished.emplace_back(it->second, PUSH_NETWORK_ERROR);
+                it = pendingDeliveries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    for (auto& item : finished) {
+        PendingDelivery& delivery = item.first;
+        PushResult result = item.second;
+        if (result != PUSH_SUCCESS) {
+            setError("服务器未确认推送（连接断开或等待超时）: " + delivery.rule.pushType);
+        }
+        LOG_DEBUG_PRINT("发件箱条目 " + String(delivery.entry.id) + (result == PUSH_SUCCESS ? " 已确认" : " 未确认"));
+        
+        endpointGuard.report(delivery.endpoint, result, millis());
+        PushContext context;
+        context.smsRecordId = delivery.smsRecordId;
+        context.timestamp = delivery.timestamp;
+        recordForwardResult(delivery.rule, context, result);
+        recordFollowerResults(delivery.entry.followerRuleIds, context, result);
+        settleOutboxEntry(delivery.entry, result);
+    }
+    return static_cast<int>(finished.size());
+}
+
+/**
+ * @brief 获取距离下一个等待确认的推送超时的时间
+ * @return unsigned long 毫秒数，没有等待确认的推送时返回ULONG_MAX
+ */
+unsigned long PushManager::getNextDeliveryDelayMs() {
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+    unsigned long now = millis();
+    unsigned long next = ULONG_MAX;
+    for (const auto& item : pendingDeliveries) {
+        long remaining = (long)(item.second.deadline - now);
+        unsigned long delay = remaining > 0 ? (unsigned long)remaining : 0;
+        if (delay < next) {
+            next = delay;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief 登记等待服务器确认的推送
+ * @param rule 转发规则
+ * @param context 推送上下文
+ * @param entry 发件箱条目
+ * @param endpoint 端点标识
+ */
+void PushManager::awaitDelivery(const ForwardRule& rule, const PushContext& context, const PushOutboxEntry& entry,
+                                uint32_t endpoint) {
+    PendingDelivery delivery;
+    delivery.rule = rule;
+    delivery.smsRecordId = context.smsRecordId;
+    delivery.timestamp = context.timestamp;
+    delivery.entry = entry;
+    delivery.endpoint = endpoint;
+    delivery.deadline = millis() + PUSH_DELIVERY_TIMEOUT_MS;
+    
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+    pendingDeliveries[entry.id] = delivery;
+}
+
+/**
+ * @brief 发件箱条目是否正在等待服务器确认
+ * @param outboxId 发件箱条目ID
+ * @return true 正在等待
+ * @return false 未在等待
+ */
+bool PushManager::isAwaitingDelivery(int outboxId) {
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+    return pendingDeliveries.find(outboxId) != pendingDeliveries.end();
+}
+
+/**
+ * @brief 暂停或恢复推送（内存紧张时由MemoryPressureManager调用）
+ * @param paused 是否暂停
+ */
+void PushManager::setPushPaused(bool paused) {
+    if (pushPaused.exchange(paused) != paused) {
+        LOG_DEBUG_PRINT(paused ? "⏸️ 内存紧张，推送暂停" : "▶️ 推送恢复");
+    }
+}
+
+/**
+ * @brief 推送是否已暂停
+ * @return true 已暂停
+ * @return false 正常推送
+ */
+bool PushManager::isPushPaused() const {
+    return pushPaused.load();
+}
+
 /**
  * @brief 测试推送配置
  * @param pushType 推送类型
@@ -202,29 +715,35 @@ PushResult PushManager::testPushConfig(int ruleId, const String& testMessage) {
 /**
  * @brief 匹配转发规则
  * @param context 推送上下文
- * @return std::vector<ForwardRule> 匹配的规则列表
+ * @param snapshot 规则快照
+ * @param indices 输出的匹配规则在snapshot.rules中的下标
+ * @param capacity indices容量
+ * @return size_t 匹配的规则数
  */
-std::vector<ForwardRule> PushManager::matchForwardRules(const PushContext& context) {
-    std::vector<ForwardRule> matchedRules;
+size_t PushManager::matchForwardRules(const PushContext& context, const ForwardRuleSnapshot& snapshot,
+                                      uint16_t* indices, size_t capacity) {
+    LOG_DEBUG_PRINT("开始匹配规则，缓存中共有 " + String(snapshot.rules.size()) + " 条规则");
+    LOG_DEBUG_PRINT("短信发送方: " + context.sender);
+    
+    size_t count = 0;
     
-    // 检查缓存是否已加载，如果没有则加载
-    if (!cacheLoaded) {
-        debugPrint("规则缓存未加载，开始加载缓存...");
-        if (!loadRulesToCache()) {
-            debugPrint("加载规则缓存失败: " + lastError);
-            return matchedRules; // 返回空列表
+    if (snapshot.matcherReady) {
+        count = snapshot.matcher.match(context.sender.c_str(), context.content.c_str(), indices, capacity);
+        for (size_t i = 0; i < count; i++) {
+            LOG_DEBUG_PRINT("✓ 规则匹配成功: " + snapshot.rules[indices[i]].ruleName);
         }
+        LOG_DEBUG_PRINT("规则匹配完成，共匹配到 " + String(count) + " 条规则");
+        return count;
     }
     
-    debugPrint("开始匹配规则，缓存中共有 " + String(cachedRules.size()) + " 条规则");
-    debugPrint("短信发送方: " + context.sender);
-    
-    for (const auto& rule : cachedRules) {
-        debugPrint("检查规则 [" + String(rule.id) + "] " + rule.ruleName + ", 启用状态: " + String(rule.enabled ? "是" : "否"));
+    // 匹配器不可用时逐条解析规则
+    for (size_t index = 0; index < snapshot.rules.size() && count < capacity; index++) {
+        const ForwardRule& rule = snapshot.rules[index];
+        LOG_DEBUG_PRINT("检查规则 [" + String(rule.id) + "] " + rule.ruleName + ", 启用状态: " + String(rule.enabled ? "是" : "否"));
         
         // 跳过禁用的规则
         if (!rule.enabled) {
-            debugPrint("跳过禁用的规则: " + rule.ruleName);
+            LOG_DEBUG_PRINT("跳过禁用的规则: " + rule.ruleName);
             continue;
         }
         
@@ -232,36 +751,46 @@ std::vector<ForwardRule> PushManager::matchForwardRules(const PushContext& conte
         
         // 检查是否为默认转发规则
         if (rule.isDefaultForward) {
-            debugPrint("规则 " + rule.ruleName + " 是默认转发规则，直接匹配");
+            LOG_DEBUG_PRINT("规则 " + rule.ruleName + " 是默认转发规则，直接匹配");
             matched = true;
         } else {
-            debugPrint("检查规则 " + rule.ruleName + " 的匹配条件:");
-            debugPrint("  来源号码模式: " + rule.sourceNumber);
-            debugPrint("  关键词: " + rule.keywords);
+            LOG_DEBUG_PRINT("检查规则 " + rule.ruleName + " 的匹配条件:");
+            LOG_DEBUG_PRINT("  来源号码模式: " + rule.sourceNumber);
+            LOG_DEBUG_PRINT("  关键词: " + rule.keywords);
             
-            // 检查号码匹配
-            bool numberMatch = rule.sourceNumber.isEmpty() || 
+            // 检查号码匹配（名单规则按号码集合判断）
+            String listName;
+            bool negated = false;
+            bool numberMatch;
+            if (NumberSet::parseListPattern(rule.sourceNumber, listName, negated)) {
+                auto list = snapshot.numberLists.find(listName);
+                bool listed = list != snapshot.numberLists.end() &&
+                              list->second->contains(NumberSet::keyOf(context.sender.c_str()));
+                numberMatch = listed != negated;
+            } else {
+                numberMatch = rule.sourceNumber.isEmpty() || 
                               matchPhoneNumber(rule.sourceNumber, context.sender);
-            debugPrint("  号码匹配结果: " + String(numberMatch ? "是" : "否"));
+            }
+            LOG_DEBUG_PRINT("  号码匹配结果: " + String(numberMatch ? "是" : "否"));
             
             // 检查关键词匹配
             bool keywordMatch = rule.keywords.isEmpty() || 
                                matchKeywords(rule.keywords, context.content);
-            debugPrint("  关键词匹配结果: " + String(keywordMatch ? "是" : "否"));
+            LOG_DEBUG_PRINT("  关键词匹配结果: " + String(keywordMatch ? "是" : "否"));
             
             matched = numberMatch && keywordMatch;
         }
         
         if (matched) {
-            matchedRules.push_back(rule);
-            debugPrint("✓ 规则匹配成功: " + rule.ruleName);
+            indices[count++] = static_cast<uint16_t>(index);
+            LOG_DEBUG_PRINT("✓ 规则匹配成功: " + rule.ruleName);
         } else {
-            debugPrint("✗ 规则不匹配: " + rule.ruleName);
+            LOG_DEBUG_PRINT("✗ 规则不匹配: " + rule.ruleName);
         }
     }
     
-    debugPrint("规则匹配完成，共匹配到 " + String(matchedRules.size()) + " 条规则");
-    return matchedRules;
+    LOG_DEBUG_PRINT("规则匹配完成，共匹配到 " + String(count) + " 条规则");
+    return count;
 }
 
 /**
@@ -348,29 +877,375 @@ bool PushManager::matchKeywords(const String& keywords, const String& content) {
  * @brief 执行推送
  * @param rule 转发规则
  * @param context 推送上下文
+ * @param prepared 预解析的渠道配置（nullptr时按rule.pushConfig解析）
  * @return PushResult 推送结果
  */
-PushResult PushManager::executePush(const ForwardRule& rule, const PushContext& context) {
-    debugPrint("执行推送，类型: " + rule.pushType);
+PushResult PushManager::executePush(const ForwardRule& rule, const PushContext& context,
+                                    const PushChannelConfig* prepared, int outboxId) {
+    LOG_DEBUG_PRINT("执行推送，类型: " + rule.pushType);
+    
+    PushResult result;
+    if (outboxId > 0 && context.outboxId != outboxId) {
+        PushContext tagged = context;
+        tagged.outboxId = outboxId;
+        result = pushToChannel(rule.pushType, rule.pushConfig, tagged, prepared);
+    } else {
+        result = pushToChannel(rule.pushType, rule.pushConfig, context, prepared);
+    }
     
-    PushResult result = pushToChannel(rule.pushType, rule.pushConfig, context);
+    // 等待服务器确认的推送在确认结果到达后再记录
+    if (result != PUSH_PENDING) {
+        recordForwardResult(rule, context, result);
+    }
     
+    return result;
+}
+
+/**
+ * @brief 将规则的推送结果记录到短信记录
+ * @param rule 转发规则
+ * @param context 推送上下文
+ * @param result 推送结果
+ */
+void PushManager::recordForwardResult(const ForwardRule& rule, const PushContext& context, PushResult result) {
     // 更新短信记录的转发状态
+    // 投递到数据库工作线程后不等待，推送路径不因数据库繁忙而阻塞
     if (context.smsRecordId > 0) {
-        DatabaseManager& dbManager = DatabaseManager::getInstance();
-        SMSRecord record = dbManager.getSMSRecordById(context.smsRecordId);
-        if (record.id > 0) {
-            record.ruleId = rule.id;
-            record.forwarded = (result == PUSH_SUCCESS);
-            record.status = (result == PUSH_SUCCESS) ? "forwarded" : "failed";
-            if (result == PUSH_SUCCESS) {
-                record.forwardedAt = formatTimestamp(context.timestamp);
+        int smsRecordId = context.smsRecordId;
+        int ruleId = rule.id;
+        bool forwarded = (result == PUSH_SUCCESS);
+        String forwardedAt = forwarded ? formatTimestamp(context.timestamp) : String();
+        DbWorker::getInstance().post([smsRecordId, ruleId, forwarded, forwardedAt]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            SMSRecord record = dbManager.getSMSRecordById(smsRecordId);
+            if (record.id > 0) {
+                record.ruleId = ruleId;
+                record.forwarded = forwarded;
+                record.status = forwarded ? "forwarded" : "failed";
+                if (forwarded) {
+                    record.forwardedAt = forwardedAt;
+                }
+                dbManager.updateSMSRecord(record);
+            }
+        });
+    }
+    
+    // 通知事件流订阅者
+    EventBus& eventBus = EventBus::getInstance();
+    if (eventBus.hasSubscribers()) {
+        JsonDocument doc;
+        doc["sms_id"] = context.smsRecordId;
+        doc["rule_id"] = rule.id;
+        doc["rule_name"] = rule.ruleName;
+        doc["push_type"] = rule.pushType;
+        doc["result"] = (int)result;
+        doc["status"] = (result == PUSH_SUCCESS) ? "forwarded" : "failed";
+        String data;
+        serializeJson(doc, data);
+        eventBus.publish(EVENT_TYPE_PUSH, data);
+    }
+}
+
+/**
+ * @brief 为复用发件箱条目结果的同目标规则记录推送结果
+ * @param followerRuleIds 规则ID（逗号分隔）
+ * @param context 推送上下文
+ * @param result 推送结果
+ */
+void PushManager::recordFollowerResults(const String& followerRuleIds, const PushContext& context, PushResult result) {
+    if (followerRuleIds.isEmpty()) {
+        return;
+    }
+    std::shared_ptr<const ForwardRuleSnapshot> snapshot = acquireRuleSnapshot();
+    if (!snapshot) {
+        return;
+    }
+    
+    const char* cursor = followerRuleIds.c_str();
+    while (*cursor != '\0') {
+        char* end = nullptr;
+        long ruleId = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            break;
+        }
+        for (const ForwardRule& rule : snapshot->rules) {
+            if (rule.id == ruleId) {
+                recordForwardResult(rule, context, result);
+                break;
+            }
+        }
+        cursor = *end == ',' ? end + 1 : end;
+    }
+}
+
+/**
+ * @brief 推送前写入发件箱条目（断电或重启后可继续重试）
+ * @param rule 转发规则
+ * @param context 推送上下文
+ * @param holdSeconds 推送完成前发生重启时，距首次重试的秒数
+ * @param followerRuleIds 推送目标相同、复用本条目结果的规则ID
+ * @return int 发件箱条目ID，-1表示无需或写入失败
+ */
+int PushManager::journalOutboxEntry(const ForwardRule& rule, const PushContext& context, time_t holdSeconds,
+                                    const String& followerRuleIds) {
+    if (context.smsRecordId <= 0 || rule.id <= 0) {
+        return -1;
+    }
+    
+    PushOutboxEntry entry;
+    entry.id = 0;
+    entry.smsId = context.smsRecordId;
+    entry.ruleId = rule.id;
+    entry.attempt = 0;
+    // 本次推送完成前若发生重启，条目将在holdSeconds后被重试
+    entry.nextAttemptAt = time(nullptr) + holdSeconds;
+    entry.lastError = "";
+    entry.createdAt = 0;
+    entry.followerRuleIds = followerRuleIds;
+    
+    int outboxId = -1;
+    String dbError;
+    if (!DbWorker::getInstance().call([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            outboxId = dbManager.addPushOutboxEntry(entry);
+            if (outboxId <= 0) {
+                dbError = dbManager.getLastError();
+            }
+        })) {
+        dbError = DbWorker::getInstance().getLastError();
+    }
+    if (outboxId <= 0) {
+        LOG_DEBUG_PRINT("写入发件箱失败: " + dbError);
+        return -1;
+    }
+    return outboxId;
+}
+
+/**
+ * @brief 发送一个汇总，并逐条记录转发结果与结算发件箱条目
+ * @param digest 待发送的汇总
+ */
+void PushManager::flushDigest(PendingDigest& digest) {
+    const ForwardRule& rule = digest.rule;
+    String title = "📬 短信汇总（" + String(digest.entries.size()) + "条）";
+    
+    LOG_DEBUG_PRINT("发送规则 " + rule.ruleName + " 的汇总，共 " + String(digest.entries.size()) + " 条短信");
+    
+    // 端点限流或熔断时各条短信的发件箱条目整体推迟，由drainOutbox逐条补发
+    uint32_t endpoint = 0;
+    unsigned long retryInMs = 0;
+    if (!admitEndpoint(rule, endpoint, retryInMs)) {
+        for (const DigestEntry& item : digest.entries) {
+            if (item.outboxId > 0) {
+                PushOutboxEntry entry;
+                entry.id = item.outboxId;
+                entry.smsId = item.smsRecordId;
+                entry.ruleId = rule.id;
+                entry.attempt = 0;
+                entry.nextAttemptAt = 0;
+                entry.createdAt = 0;
+                deferOutboxEntry(entry, retryInMs);
             }
-            dbManager.updateSMSRecord(record);
         }
+        return;
     }
     
-    return result;
+    PushResult result = PUSH_FAILED;
+    PushChannelRegistry::ChannelLease channel = PushChannelRegistry::getInstance().acquireChannel(rule.pushType);
+    if (!channel || !digest.config) {
+        setError("未找到推送渠道: " + rule.pushType);
+        result = PUSH_CONFIG_ERROR;
+    } else {
+        channel->setDebugMode(debugMode);
+        result = channel->pushDigest(*digest.config, title, digest.body);
+        if (result != PUSH_SUCCESS) {
+            setError("汇总推送失败: " + channel->getLastError());
+            LOG_DEBUG_PRINT("❌ " + lastError);
+        }
+    }
+    endpointGuard.report(endpoint, result, millis());
+    
+    // 汇总不在此重试：失败时各条短信的发件箱条目按退避排期，由drainOutbox逐条补发
+    for (const DigestEntry& item : digest.entries) {
+        PushContext context;
+        context.smsRecordId = item.smsRecordId;
+        context.timestamp = item.timestamp;
+        recordForwardResult(rule, context, result);
+        recordFollowerResults(item.followerRuleIds, context, result);
+        
+        if (item.outboxId > 0) {
+            PushOutboxEntry entry;
+            entry.id = item.outboxId;
+            entry.smsId = item.smsRecordId;
+            entry.ruleId = rule.id;
+            entry.attempt = 0;
+            entry.nextAttemptAt = 0;
+            entry.createdAt = 0;
+            settleOutboxEntry(entry, result);
+        }
+    }
+}
+
+/**
+ * @brief 从规则推送配置中解析汇总策略
+ * @param pushConfig 推送配置（JSON格式）
+ * @return DigestPolicy 汇总策略
+ */
+DigestPolicy PushManager::parseDigestPolicy(const String& pushConfig) {
+    DigestPolicy policy;
+    if (pushConfig.indexOf("digest_window") == -1) {
+        return policy;
+    }
+    
+    JsonDocument doc;
+    if (deserializeJson(doc, pushConfig) != DeserializationError::Ok) {
+        return policy;
+    }
+    
+    long windowS = doc["digest_window"] | 0L;
+    long maxMessages = doc["digest_max"] | (long)DIGEST_DEFAULT_MAX_MESSAGES;
+    if (windowS <= 0) {
+        return policy;
+    }
+    if (windowS > DIGEST_MAX_WINDOW_S) {
+        windowS = DIGEST_MAX_WINDOW_S;
+    }
+    if (maxMessages < 1) {
+        maxMessages = 1;
+    } else if (maxMessages > DIGEST_MAX_MESSAGES) {
+        maxMessages = DIGEST_MAX_MESSAGES;
+    }
+    
+    policy.windowMs = static_cast<uint32_t>(windowS) * 1000UL;
+    policy.maxMessages = static_cast<uint16_t>(maxMessages);
+    return policy;
+}
+
+/**
+ * @brief 根据推送结果更新发件箱条目：成功或不可重试时删除，否则按指数退避重新排期
+ * @param entry 发件箱条目
+ * @param result 推送结果
+ */
+void PushManager::settleOutboxEntry(PushOutboxEntry& entry, PushResult result) {
+    DbWorker& dbWorker = DbWorker::getInstance();
+    int outboxId = entry.id;
+    
+    // 配置错误或规则失效时重试没有意义
+    if (result == PUSH_SUCCESS || result == PUSH_CONFIG_ERROR ||
+        result == PUSH_NO_RULE || result == PUSH_RULE_DISABLED) {
+        if (!dbWorker.call([outboxId]() {
+                DatabaseManager::getInstance().deletePushOutboxEntry(outboxId);
+            })) {
+            LOG_DEBUG_PRINT("删除发件箱条目失败: " + dbWorker.getLastError());
+        }
+        return;
+    }
+    
+    entry.attempt++;
+    if (entry.attempt >= PUSH_OUTBOX_MAX_ATTEMPTS) {
+        LogManager::getInstance().logError(LOG_MODULE_SMS, "❌ 短信 " + String(entry.smsId) + " 经 " +
+                                           String(entry.attempt) + " 次重试仍推送失败，放弃: " + lastError);
+        if (!dbWorker.call([outboxId]() {
+                DatabaseManager::getInstance().deletePushOutboxEntry(outboxId);
+            })) {
+            LOG_DEBUG_PRINT("删除发件箱条目失败: " + dbWorker.getLastError());
+        }
+        return;
+    }
+    
+    time_t backoff = computeOutboxBackoff(entry.attempt);
+    entry.nextAttemptAt = time(nullptr) + backoff;
+    entry.lastError = lastError;
+    if (!updateOutboxEntry(entry)) {
+        return;
+    }
+    
+    LOG_DEBUG_PRINT("发件箱条目 " + String(entry.id) + " 将在 " + String((long)backoff) + " 秒后重试");
+}
+
+/**
+ * @brief 在数据库工作线程中写回发件箱条目
+ * @param entry 发件箱条目
+ * @return true 写入成功
+ * @return false 写入失败（已输出日志）
+ */
+bool PushManager::updateOutboxEntry(const PushOutboxEntry& entry) {
+    bool updated = false;
+    String dbError;
+    if (!DbWorker::getInstance().call([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            updated = dbManager.updatePushOutboxEntry(entry);
+            if (!updated) {
+                dbError = dbManager.getLastError();
+            }
+        })) {
+        dbError = DbWorker::getInstance().getLastError();
+    }
+    if (!updated) {
+        LOG_DEBUG_PRINT("更新发件箱失败: " + dbError);
+    }
+    return updated;
+}
+
+/**
+ * @brief 计算第attempt次失败后的退避时长
+ * @param attempt 已失败的尝试次数
+ * @return time_t 退避秒数
+ */
+time_t PushManager::computeOutboxBackoff(int attempt) {
+    time_t backoff = PUSH_OUTBOX_BASE_DELAY_S;
+    for (int i = 1; i < attempt && backoff < PUSH_OUTBOX_MAX_DELAY_S; i++) {
+        backoff *= 2;
+    }
+    return backoff > PUSH_OUTBOX_MAX_DELAY_S ? PUSH_OUTBOX_MAX_DELAY_S : backoff;
+}
+
+/**
+ * @brief 申请向规则的推送端点推送一次（限流与熔断），被拒绝时记录原因
+ * @param rule 转发规则
+ * @param endpoint 输出：端点标识，放行后以此报告推送结果
+ * @param retryInMs 输出：被拒绝时建议的等待毫秒数
+ * @return true 放行
+ * @return false 推送已暂停，或端点超出速率限制、已熔断
+ */
+bool PushManager::admitEndpoint(const ForwardRule& rule, uint32_t& endpoint, unsigned long& retryInMs) {
+    endpoint = PushEndpointGuard::endpointKey(rule.pushType, rule.pushConfig);
+    if (pushPaused.load()) {
+        retryInMs = MEMORY_PRESSURE_PUSH_DEFER_MS;
+        setError("内存紧张，推送暂缓: " + rule.pushType);
+        MetricsRegistry::getInstance().increment(METRIC_PUSH_DEFERRED, rule.pushType.c_str());
+        LOG_DEBUG_PRINT("⏸️ 规则 " + rule.ruleName + " 暂不推送: " + lastError);
+        return false;
+    }
+    EndpointAdmission admission = endpointGuard.admit(endpoint, rule.pushType, millis(), retryInMs);
+    if (admission == ENDPOINT_ADMITTED) {
+        return true;
+    }
+    
+    if (admission == ENDPOINT_CIRCUIT_OPEN) {
+        setError("推送端点连续失败已熔断，" + String((retryInMs + 999) / 1000) + " 秒后恢复: " + rule.pushType);
+    } else {
+        setError("推送端点超出速率限制（每分钟 " + String(PushEndpointGuard::ratePerMinute(rule.pushType)) +
+                 " 条）: " + rule.pushType);
+    }
+    MetricsRegistry::getInstance().increment(METRIC_PUSH_DEFERRED, rule.pushType.c_str());
+    LOG_DEBUG_PRINT("⏸️ 规则 " + rule.ruleName + " 暂不推送: " + lastError);
+    return false;
+}
+
+/**
+ * @brief 推迟发件箱条目（不计入重试次数）
+ * @param entry 发件箱条目
+ * @param delayMs 推迟的毫秒数
+ */
+void PushManager::deferOutboxEntry(PushOutboxEntry& entry, unsigned long delayMs) {
+    time_t delaySeconds = (time_t)((delayMs + 999) / 1000);
+    entry.nextAttemptAt = time(nullptr) + (delaySeconds > 0 ? delaySeconds : 1);
+    entry.lastError = lastError;
+    if (!updateOutboxEntry(entry)) {
+        return;
+    }
+    LOG_DEBUG_PRINT("发件箱条目 " + String(entry.id) + " 推迟 " + String((long)delaySeconds) + " 秒");
 }
 
 /**
@@ -378,92 +1253,82 @@ PushResult PushManager::executePush(const ForwardRule& rule, const PushContext&
  * @param channelName 渠道名称
  * @param config 推送配置（JSON格式）
  * @param context 推送上下文
+ * @param prepared 预解析的渠道配置（nullptr时解析config）
  * @return PushResult 推送结果
  */
-PushResult PushManager::pushToChannel(const String& channelName, const String& config, const PushContext& context) {
+PushResult PushManager::pushToChannel(const String& channelName, const String& config, const PushContext& context,
+                                      const PushChannelConfig* prepared) {
     if (!initialized) {
         setError("推送管理器未初始化");
         return PUSH_FAILED;
     }
     
-    debugPrint("使用渠道推送: " + channelName);
-    debugPrint("推送配置: " + config);
-    debugPrint("推送内容: " + context.content);
+    LOG_DEBUG_PRINT("使用渠道推送: " + channelName);
+    LOG_DEBUG_PRINT("推送配置: " + config);
+    LOG_DEBUG_PRINT("推送内容: " + context.content);
     
-    // 通过推送渠道注册器获取具体的推送渠道实例
+    // 从推送渠道注册器租用渠道实例（池化复用，保留签名上下文等预热状态）
     PushChannelRegistry& registry = PushChannelRegistry::getInstance();
-    auto channel = registry.createChannel(channelName);
+    PushChannelRegistry::ChannelLease channel = registry.acquireChannel(channelName);
     
     if (!channel) {
         setError("未找到推送渠道: " + channelName);
-        debugPrint("❌ 推送失败: 未找到渠道 " + channelName);
+        LOG_DEBUG_PRINT("❌ 推送失败: 未找到渠道 " + channelName);
         return PUSH_FAILED;
     }
     
-    debugPrint("✅ 成功创建推送渠道实例: " + channelName);
-    
-    // 设置调试模式
-    if (debugMode) {
-        channel->setDebugMode(true);
-    }
+    // 设置调试模式（池中实例可能保留着上一次使用者的设置）
+    channel->setDebugMode(debugMode);
     
     // 执行推送，带重试机制
     PushResult result = PUSH_FAILED;
     String lastError = "";
     
     for (int attempt = 1; attempt <= MAX_PUSH_RETRY_COUNT; attempt++) {
-        debugPrint("推送尝试 " + String(attempt) + "/" + String(MAX_PUSH_RETRY_COUNT));
+        LOG_DEBUG_PRINT("推送尝试 " + String(attempt) + "/" + String(MAX_PUSH_RETRY_COUNT));
         
-        // 执行推送
-        result = channel->push(config, context);
+        // 执行推送（已预解析配置时跳过JSON解析与校验）
+        SmsTrace::mark(SMS_TRACE_PUSH);
+        uint32_t attemptStartUs = micros();
+        result = prepared != nullptr ? channel->pushPrepared(*prepared, context) : channel->push(config, context);
+        MetricsRegistry& metrics = MetricsRegistry::getInstance();
+        metrics.observe(METRIC_PUSH_LATENCY, micros() - attemptStartUs, channelName.c_str());
         
         if (result == PUSH_SUCCESS) {
-            debugPrint("✅ 推送成功完成 (尝试 " + String(attempt) + ")");
+            LOG_DEBUG_PRINT("✅ 推送成功完成 (尝试 " + String(attempt) + ")");
             break;
         } else {
             // 记录错误信息
+            metrics.increment(METRIC_PUSH_FAILURES, channelName.c_str());
             lastError = channel->getLastError();
-            debugPrint("❌ 推送失败 (尝试 " + String(attempt) + "): " + lastError);
+            LOG_DEBUG_PRINT("❌ 推送失败 (尝试 " + String(attempt) + "): " + lastError);
+            
+            // 服务端明确限流时立即重试只会再被拒绝，交给发件箱按退避重试
+            if (lastError.indexOf("状态码: 429") != -1) {
+                LOG_DEBUG_PRINT("服务端限流，放弃本轮重试");
+                break;
+            }
             
-            // 运行HTTP诊断以识别问题原因
+            // 记录缓存的模块与HTTP状态辅助定位问题；这里不发AT命令，
+            // 主动诊断会绕过请求锁打断保持中的HTTP会话，只在命令行/网页诊断中使用
             if (lastError.indexOf("HTTP") != -1 || lastError.indexOf("网络") != -1 || lastError.indexOf("连接") != -1) {
-                debugPrint("🔍 检测到网络相关错误，运行HTTP诊断...");
-                HttpDiagnostics& diagnostics = HttpDiagnostics::getInstance();
-                HttpDiagnosticResult diagResult = diagnostics.runFullDiagnostic();
-                
-                debugPrint("📊 HTTP诊断结果:");
-                debugPrint("  - AT命令处理器: " + String(diagResult.atHandlerStatus == HTTP_DIAG_OK ? "正常" : "异常"));
-                debugPrint("  - GSM模块: " + String(diagResult.gsmModuleStatus == HTTP_DIAG_OK ? "正常" : "异常"));
-                debugPrint("  - 网络连接: " + String(diagResult.networkStatus == HTTP_DIAG_OK ? "正常" : "异常"));
-                debugPrint("  - PDP上下文: " + String(diagResult.pdpContextStatus == HTTP_DIAG_OK ? "正常" : "异常"));
-                debugPrint("  - HTTP服务: " + String(diagResult.httpServiceStatus == HTTP_DIAG_OK ? "正常" : "异常"));
-                debugPrint("  - HTTP功能: " + String(diagResult.httpFunctionStatus == HTTP_DIAG_OK ? "正常" : "异常"));
-                
-                if (!diagResult.errorMessage.isEmpty()) {
-                    debugPrint("  - 错误详情: " + diagResult.errorMessage);
+                ModemStatus status = GsmService::getInstance().getStatusSnapshot();
+                if (status.valid) {
+                    LOG_DEBUG_PRINT("📊 模块状态: " + String(status.online ? "在线" : "离线") +
+                                    "，SIM: " + String(status.simReady ? "就绪" : "未就绪") +
+                                    "，网络: " + String(status.isRegistered() ? "已注册" : "未注册") +
+                                    "，信号: " + String(status.signalStrength) +
+                                    "（" + String((millis() - status.refreshedAt) / 1000) + "秒前）");
+                } else {
+                    LOG_DEBUG_PRINT("📊 模块状态: 尚未刷新");
                 }
+                LOG_DEBUG_PRINT("📊 HTTP状态: " + HttpClient::getInstance().describeCachedState());
             }
             
             // 如果不是最后一次尝试，等待后重试
             if (attempt < MAX_PUSH_RETRY_COUNT) {
-                debugPrint("等待 " + String(PUSH_RETRY_DELAY_MS) + "ms 后重试...");
+                LOG_DEBUG_PRINT("等待 " + String(PUSH_RETRY_DELAY_MS) + "ms 后重试...");
                 delay(PUSH_RETRY_DELAY_MS);
-                
-                // 垃圾回收：释放当前渠道实例，重新创建
-                channel.reset(); // 智能指针自动释放内存
-                
-                // 重新创建渠道实例
-                channel = registry.createChannel(channelName);
-                if (!channel) {
-                    setError("重试时无法创建推送渠道: " + channelName);
-                    debugPrint("❌ 重试失败: 无法重新创建渠道 " + channelName);
-                    return PUSH_FAILED;
-                }
-                
-                // 重新设置调试模式
-                if (debugMode) {
-                    channel->setDebugMode(true);
-                }
             }
         }
     }
@@ -471,10 +1336,10 @@ PushResult PushManager::pushToChannel(const String& channelName, const String& c
     // 设置最终错误信息
     if (result != PUSH_SUCCESS) {
         setError("推送失败 (" + String(MAX_PUSH_RETRY_COUNT) + "次重试后): " + lastError);
-        debugPrint("❌ 推送最终失败，已重试 " + String(MAX_PUSH_RETRY_COUNT) + " 次");
+        LOG_DEBUG_PRINT("❌ 推送最终失败，已重试 " + String(MAX_PUSH_RETRY_COUNT) + " 次");
     }
     
-    // 垃圾回收：确保渠道实例被正确释放
+    // 归还渠道实例
     channel.reset();
     
     return result;
@@ -508,7 +1373,7 @@ std::vector<PushChannelExample> PushManager::getAllChannelExamples() const {
     
     for (const String& channelName : channels) {
         const PushChannelRegistry::ChannelMetadata* metadata = registry.getChannelMetadata(channelName);
-        auto channel = registry.createChannel(channelName);
+        auto channel = registry.acquireChannel(channelName);
         if (channel && metadata) {
             PushChannelExample example = channel->getConfigExample();
             example.channelName = channelName;
@@ -535,7 +1400,7 @@ std::vector<PushChannelHelp> PushManager::getAllChannelHelp() const {
     
     for (const String& channelName : channels) {
         const PushChannelRegistry::ChannelMetadata* metadata = registry.getChannelMetadata(channelName);
-        auto channel = registry.createChannel(channelName);
+        auto channel = registry.acquireChannel(channelName);
         if (channel && metadata) {
             PushChannelHelp help = channel->getHelp();
             help.channelName = channelName;
@@ -634,12 +1499,12 @@ bool PushManager::reloadChannels() {
         return false;
     }
     
-    debugPrint("重新加载推送渠道...");
+    LOG_DEBUG_PRINT("重新加载推送渠道...");
     
     // 注册表模式下，渠道是静态注册的，无需重新加载
     // 这里可以添加清理缓存等操作
     
-    debugPrint("渠道重新加载完成");
+    LOG_DEBUG_PRINT("渠道重新加载完成");
     
     return true;
 }
@@ -740,7 +1605,7 @@ void PushManager::setDebugMode(bool enable) {
  */
 void PushManager::setError(const String& error) {
     lastError = error;
-    debugPrint("错误: " + error);
+    LOG_DEBUG_PRINT("错误: " + error);
 }
 
 /**
@@ -764,21 +1629,302 @@ bool PushManager::loadRulesToCache() {
         return false;
     }
     
-    debugPrint("开始加载转发规则到缓存...");
+    LOG_DEBUG_PRINT("开始加载转发规则到缓存...");
+    
+    // 整个加载在数据库工作线程中执行：网页请求在工作线程中增量更新缓存时也持有cacheUpdateMutex，
+    // 在其他任务中持锁等待工作线程会与之互相等待
+    bool executed = DbWorker::getInstance().call([&]() {
+        // 与增量更新互斥，避免较旧的全量结果覆盖较新的增量
+        std::lock_guard<std::mutex> updateLock(cacheUpdateMutex);
+        
+        // 在新快照上完成加载与编译，旧快照在此期间仍可被匹配使用
+        std::shared_ptr<ForwardRuleSnapshot> snapshot = std::make_shared<ForwardRuleSnapshot>();
+        
+        // 从数据库获取所有转发规则
+        DatabaseManager& dbManager = DatabaseManager::getInstance();
+        snapshot->rules = dbManager.getAllForwardRules();
+        
+        LOG_DEBUG_PRINT("成功加载 " + String(snapshot->rules.size()) + " 条转发规则到缓存");
+        
+        snapshot->channelConfigs.resize(snapshot->rules.size());
+        snapshot->digestPolicies.resize(snapshot->rules.size());
+        for (size_t i = 0; i < snapshot->rules.size(); i++) {
+            prepareSnapshotRule(*snapshot, i);
+        }
+        
+        // 号码名单整体加载到PSRAM中的哈希集合，名单规则匹配时不再访问数据库
+        std::vector<NumberListSummary> lists = dbManager.getNumberListSummaries();
+        for (const NumberListSummary& list : lists) {
+            std::shared_ptr<const NumberSet> numbers = loadNumberList(list.name, list.count);
+            if (numbers) {
+                snapshot->numberLists[list.name] = numbers;
+            }
+        }
+        
+        publishSnapshot(snapshot);
+    });
+    if (!executed) {
+        setError("加载转发规则失败: " + DbWorker::getInstance().getLastError());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 增量更新规则缓存中的一条规则（不存在时追加）
+ * @param rule 已写入数据库的规则
+ * @return true 更新成功
+ * @return false 更新失败
+ */
+bool PushManager::upsertCachedRule(const ForwardRule& rule) {
+    if (!initialized) {
+        setError("推送管理器未初始化");
+        return false;
+    }
+    if (rule.id <= 0) {
+        setError("无效的规则ID: " + String(rule.id));
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> updateLock(cacheUpdateMutex);
+    std::shared_ptr<ForwardRuleSnapshot> snapshot = copyCurrentSnapshot();
+    if (!snapshot) {
+        // 缓存尚未加载，首次使用时会完整加载
+        return true;
+    }
     
-    // 清空现有缓存
-    cachedRules.clear();
+    // 规则按ID升序排列（与getAllForwardRules()一致）
+    size_t index = 0;
+    while (index < snapshot->rules.size() && snapshot->rules[index].id < rule.id) {
+        index++;
+    }
+    if (index == snapshot->rules.size() || snapshot->rules[index].id != rule.id) {
+        snapshot->rules.insert(snapshot->rules.begin() + index, rule);
+        snapshot->channelConfigs.insert(snapshot->channelConfigs.begin() + index, nullptr);
+        snapshot->digestPolicies.insert(snapshot->digestPolicies.begin() + index, DigestPolicy());
+    } else {
+        snapshot->rules[index] = rule;
+        snapshot->channelConfigs[index] = nullptr;
+        snapshot->digestPolicies[index] = DigestPolicy();
+    }
+    prepareSnapshotRule(*snapshot, index);
+    
+    LOG_DEBUG_PRINT("增量更新规则缓存: " + rule.ruleName);
+    publishSnapshot(snapshot);
+    return true;
+}
+
+/**
+ * @brief 从规则缓存中移除一条规则
+ * @param ruleId 规则ID
+ * @return true 移除成功或规则不在缓存中
+ * @return false 移除失败
+ */
+bool PushManager::removeCachedRule(int ruleId) {
+    if (!initialized) {
+        setError("推送管理器未初始化");
+        return false;
+    }
     
-    // 从数据库获取所有转发规则
+    std::lock_guard<std::mutex> updateLock(cacheUpdateMutex);
+    std::shared_ptr<ForwardRuleSnapshot> snapshot = copyCurrentSnapshot();
+    if (!snapshot) {
+        return true;
+    }
+    
+    for (size_t i = 0; i < snapshot->rules.size(); i++) {
+        if (snapshot->rules[i].id == ruleId) {
+            snapshot->rules.erase(snapshot->rules.begin() + i);
+            snapshot->channelConfigs.erase(snapshot->channelConfigs.begin() + i);
+            snapshot->digestPolicies.erase(snapshot->digestPolicies.begin() + i);
+            LOG_DEBUG_PRINT("从规则缓存移除规则: " + String(ruleId));
+            publishSnapshot(snapshot);
+            return true;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 从数据库重新加载一个号码名单并发布新快照
+ * @param listName 名单名
+ * @return true 重新加载成功
+ * @return false 加载失败
+ */
+bool PushManager::reloadNumberList(const String& listName) {
+    if (!initialized) {
+        setError("推送管理器未初始化");
+        return false;
+    }
+    
+    // 与loadRulesToCache()相同，持有cacheUpdateMutex的数据库访问都在工作线程中执行
+    bool reloaded = false;
+    bool executed = DbWorker::getInstance().call([&]() {
+        std::lock_guard<std::mutex> updateLock(cacheUpdateMutex);
+        std::shared_ptr<ForwardRuleSnapshot> snapshot = copyCurrentSnapshot();
+        if (!snapshot) {
+            reloaded = true;
+            return;
+        }
+        
+        int count = 0;
+        for (const NumberListSummary& list : DatabaseManager::getInstance().getNumberListSummaries()) {
+            if (list.name == listName) {
+                count = list.count;
+                break;
+            }
+        }
+        if (count == 0) {
+            snapshot->numberLists.erase(listName);
+        } else {
+            std::shared_ptr<const NumberSet> numbers = loadNumberList(listName, count);
+            if (!numbers) {
+                return;
+            }
+            snapshot->numberLists[listName] = numbers;
+        }
+        
+        LOG_DEBUG_PRINT("重新加载号码名单 " + listName + "，共 " + String(count) + " 个号码");
+        publishSnapshot(snapshot);
+        reloaded = true;
+    });
+    if (!executed) {
+        setError("重新加载号码名单失败: " + DbWorker::getInstance().getLastError());
+        return false;
+    }
+    return reloaded;
+}
+
+/**
+ * @brief 获取当前规则快照中的号码名单
+ * @return NumberListMap 名单名到号码集合的映射
+ */
+NumberListMap PushManager::getNumberLists() {
+    std::shared_ptr<const ForwardRuleSnapshot> snapshot = initialized ? acquireRuleSnapshot() : nullptr;
+    return snapshot ? snapshot->numberLists : NumberListMap();
+}
+
+/**
+ * @brief 从数据库加载一个号码名单（在数据库工作线程中调用）
+ * @param listName 名单名
+ * @param expected 预计号码数
+ * @return std::shared_ptr<const NumberSet> 号码集合，加载失败返回nullptr
+ */
+std::shared_ptr<const NumberSet> PushManager::loadNumberList(const String& listName, size_t expected) {
+    std::shared_ptr<NumberSet> numbers = std::make_shared<NumberSet>(expected);
+    if (!numbers->isReady()) {
+        setError("号码名单 " + listName + " 内存分配失败");
+        return nullptr;
+    }
     DatabaseManager& dbManager = DatabaseManager::getInstance();
-    cachedRules = dbManager.getAllForwardRules();
+    if (!dbManager.forEachNumberListEntry(listName, [&](const char* number) {
+            numbers->insert(number);
+        })) {
+        setError("读取号码名单 " + listName + " 失败: " + dbManager.getLastError());
+        return nullptr;
+    }
+    return numbers;
+}
+
+/**
+ * @brief 复制当前快照的规则及逐条预解析结果，作为增量更新的起点
+ * @return std::shared_ptr<ForwardRuleSnapshot> 快照副本，未加载时返回nullptr
+ */
+std::shared_ptr<ForwardRuleSnapshot> PushManager::copyCurrentSnapshot() {
+    std::shared_ptr<const ForwardRuleSnapshot> current;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        current = ruleSnapshot;
+    }
+    if (!current) {
+        return nullptr;
+    }
     
-    debugPrint("成功加载 " + String(cachedRules.size()) + " 条转发规则到缓存");
+    // 预解析的渠道配置不可变，副本与旧快照共享
+    std::shared_ptr<ForwardRuleSnapshot> snapshot = std::make_shared<ForwardRuleSnapshot>();
+    snapshot->rules = current->rules;
+    snapshot->channelConfigs = current->channelConfigs;
+    snapshot->digestPolicies = current->digestPolicies;
+    snapshot->numberLists = current->numberLists;
+    return snapshot;
+}
+
+/**
+ * @brief 预解析快照中一条规则的渠道配置与汇总策略
+ * @param snapshot 正在构建的快照
+ * @param index 规则下标
+ */
+void PushManager::prepareSnapshotRule(ForwardRuleSnapshot& snapshot, size_t index) {
+    // 预解析并校验启用规则的渠道配置，推送时不再解析JSON；
+    // 渠道不存在或配置无效的规则保留nullptr，推送时按原JSON路径报告错误
+    const ForwardRule& rule = snapshot.rules[index];
+    if (!rule.enabled) {
+        return;
+    }
+    PushChannelRegistry::ChannelLease channel = PushChannelRegistry::getInstance().acquireChannel(rule.pushType);
+    if (!channel) {
+        return;
+    }
+    snapshot.channelConfigs[index] = channel->prepareConfig(rule.pushConfig);
+    if (!snapshot.channelConfigs[index]) {
+        LOG_DEBUG_PRINT("规则 " + rule.ruleName + " 的推送配置无效: " + channel->getLastError());
+        return;
+    }
     
-    // 标记缓存已加载
-    cacheLoaded = true;
+    // 汇总只对支持合并推送的渠道生效
+    if (channel->supportsDigest()) {
+        snapshot.digestPolicies[index] = parseDigestPolicy(rule.pushConfig);
+    }
+}
+
+/**
+ * @brief 计算推送目标分组、编译匹配器并发布快照
+ * @param snapshot 规则与逐条预解析结果已就绪的快照
+ */
+void PushManager::publishSnapshot(const std::shared_ptr<ForwardRuleSnapshot>& snapshot) {
+    // 推送渠道与配置完全相同的规则归为同一推送目标，以首条规则的下标标识
+    std::map<String, uint16_t> destinations;
+    snapshot->destinationLeaders.resize(snapshot->rules.size());
+    for (size_t i = 0; i < snapshot->rules.size(); i++) {
+        const ForwardRule& rule = snapshot->rules[i];
+        String key = rule.pushType + '\n' + rule.pushConfig;
+        auto it = destinations.find(key);
+        if (it == destinations.end()) {
+            it = destinations.insert(std::make_pair(key, static_cast<uint16_t>(i))).first;
+        }
+        snapshot->destinationLeaders[i] = it->second;
+    }
     
-    return true;
+    // 预编译匹配器：关键词拆分、号码模式分类与前缀字典树只在发布时构建一次
+    snapshot->matcherReady = snapshot->matcher.compile(snapshot->rules, &snapshot->numberLists);
+    if (!snapshot->matcherReady) {
+        LOG_DEBUG_PRINT("规则数量超过匹配器上限，改为逐条匹配");
+    }
+    
+    // 替换快照：持有旧快照的推送流程继续使用旧规则，最后一个持有者释放时旧快照被回收
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    ruleSnapshot = snapshot;
+}
+
+/**
+ * @brief 获取当前规则快照（未加载时先加载）
+ * @return std::shared_ptr<const ForwardRuleSnapshot> 规则快照，加载失败返回nullptr
+ */
+std::shared_ptr<const ForwardRuleSnapshot> PushManager::acquireRuleSnapshot() {
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (ruleSnapshot) {
+            return ruleSnapshot;
+        }
+    }
+    
+    LOG_DEBUG_PRINT("规则缓存未加载，开始加载缓存...");
+    if (!loadRulesToCache()) {
+        return nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return ruleSnapshot;
 }
 
 /**
@@ -792,11 +1938,8 @@ bool PushManager::refreshRuleCache() {
         return false;
     }
     
-    debugPrint("刷新转发规则缓存...");
-    
-    // 重置缓存状态
-    cacheLoaded = false;
+    LOG_DEBUG_PRINT("刷新转发规则缓存...");
     
-    // 重新加载规则
+    // 重新加载规则（成功后原子替换快照，失败时保留旧快照）
     return loadRulesToCache();
 }
\ No newline at end of file
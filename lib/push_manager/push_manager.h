@@ -17,9 +17,16 @@
 #include <Arduino.h>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include "../database_manager/database_manager.h"
 #include "../http_client/http_client.h"
 #include "push_channel_registry.h"
+#include "rule_matcher.h"
+#include "push_digest.h"
+#include "push_throttle.h"
+#include "../benchmark/benchmark.h"
 
 /**
  * @brief 加载统计信息结构
@@ -43,6 +50,56 @@ struct PushTemplate {
     String format;         ///< 消息格式（text, markdown, json等）
 };
 
+/**
+ * @struct ForwardRuleSnapshot
+ * @brief 转发规则快照（规则列表及其预编译匹配器）
+ *
+ * 发布后不再修改，刷新缓存时整体替换；推送流程持有快照期间，
+ * 其中的规则引用与匹配结果下标始终有效
+ */
+struct ForwardRuleSnapshot {
+    std::vector<ForwardRule> rules;  ///< 规则列表
+    RuleMatcher matcher;             ///< 由rules预编译的匹配器
+    bool matcherReady = false;       ///< 匹配器是否可用（否则逐条解析规则匹配）
+    std::vector<std::shared_ptr<const PushChannelConfig>> channelConfigs; ///< 与rules一一对应的预解析渠道配置（nullptr表示需按JSON推送）
+    std::vector<uint16_t> destinationLeaders; ///< 与rules一一对应：推送渠道与配置完全相同的第一条规则的下标
+    std::vector<DigestPolicy> digestPolicies; ///< 与rules一一对应的汇总策略（windowMs为0表示逐条推送）
+    NumberListMap numberLists;       ///< 名单规则引用的号码集合（按名单名）
+};
+
+/**
+ * @struct MatchedRules
+ * @brief 一条短信的规则匹配结果（推送工作线程分队列时匹配一次，推送时直接使用）
+ */
+struct MatchedRules {
+    std::shared_ptr<const ForwardRuleSnapshot> snapshot; ///< 匹配所用的规则快照（nullptr表示尚未匹配）
+    uint16_t indices[RULE_MATCH_MAX_RESULTS];            ///< 命中规则在快照中的下标
+    size_t count = 0;                                    ///< 命中规则数
+};
+
+/**
+ * @struct PendingDelivery
+ * @brief 已交给渠道客户端、等待服务器确认的推送
+ */
+struct PendingDelivery {
+    ForwardRule rule;              ///< 转发规则
+    int smsRecordId;               ///< 短信记录ID
+    String timestamp;              ///< 接收时间戳（确认后记录转发时间）
+    PushOutboxEntry entry;         ///< 发件箱条目（确认后删除，失败时按退避重试）
+    uint32_t endpoint;             ///< 端点标识（确认后报告限流与熔断状态）
+    unsigned long deadline;        ///< 放弃等待的时间（millis）
+};
+
+/**
+ * @struct DeliveryReport
+ * @brief 渠道客户端报告的确认结果
+ */
+struct DeliveryReport {
+    int outboxId;                  ///< 发件箱条目ID
+    bool delivered;                ///< 是否已被服务器确认
+    unsigned long receivedAt;      ///< 收到报告的时间（millis）
+};
+
 /**
  * @class PushManager
  * @brief 推送管理器类
@@ -67,9 +124,20 @@ public:
     /**
      * @brief 处理短信推送
      * @param context 推送上下文
+     * @param matched 已有的规则匹配结果（nullptr或未匹配时在此匹配）
      * @return PushResult 推送结果
      */
-    PushResult processSmsForward(const PushContext& context);
+    PushResult processSmsForward(const PushContext& context, const MatchedRules* matched = nullptr);
+
+    /**
+     * @brief 以当前规则快照匹配短信（只匹配，不推送）
+     * 
+     * 供PushWorker在工作线程中选择优先级队列，匹配结果随任务保存，推送时不再重复匹配
+     * @param context 推送上下文
+     * @param matched 输出：匹配结果（规则不可用时snapshot为nullptr）
+     * @return int 命中规则的最小priority值，没有命中规则或规则不可用时返回-1
+     */
+    int matchRules(const PushContext& context, MatchedRules& matched);
 
     /**
      * @brief 根据规则ID推送短信
@@ -79,6 +147,66 @@ public:
      */
     PushResult pushByRule(int ruleId, const PushContext& context);
 
+    /**
+     * @brief 处理发件箱中到期的重试条目
+     * 
+     * 由PushWorker在工作线程中调用，按指数退避重试失败的推送，
+     * 直接使用发件箱记录的规则ID，不重新执行规则匹配
+     * @param maxEntries 本轮最多处理的条目数
+     * @return int 本轮实际重试的条目数
+     */
+    int drainOutbox(int maxEntries);
+
+    /**
+     * @brief 发送所有已到期的汇总
+     * 
+     * 由PushWorker在工作线程中调用
+     * @return int 发送的汇总数
+     */
+    int flushDueDigests();
+
+    /**
+     * @brief 获取距离下一个汇总到期的时间
+     * @return unsigned long 毫秒数，没有待发送的汇总时返回ULONG_MAX
+     */
+    unsigned long getNextDigestDelayMs() const;
+
+    /**
+     * @brief 报告一条异步确认推送的结果（由渠道客户端的任务调用，只入队并唤醒推送工作线程）
+     * @param outboxId 发件箱条目ID
+     * @param delivered 是否已被服务器确认
+     */
+    void reportDelivery(int outboxId, bool delivered);
+
+    /**
+     * @brief 结算已收到确认结果或等待超时的推送
+     *
+     * 由PushWorker在工作线程中调用：确认成功时删除发件箱条目，失败或超时时按退避重新排期
+     * @return int 结算的推送数
+     */
+    int settleDeliveries();
+
+    /**
+     * @brief 获取距离下一个等待确认的推送超时的时间
+     * @return unsigned long 毫秒数，没有等待确认的推送时返回ULONG_MAX
+     */
+    unsigned long getNextDeliveryDelayMs();
+
+    /**
+     * @brief 暂停或恢复推送（内存紧张时由MemoryPressureManager调用）
+     *
+     * 暂停期间匹配到的推送写入发件箱后推迟，恢复后由发件箱重试送出
+     * @param paused 是否暂停
+     */
+    void setPushPaused(bool paused);
+
+    /**
+     * @brief 推送是否已暂停
+     * @return true 已暂停
+     * @return false 正常推送
+     */
+    bool isPushPaused() const;
+
     /**
      * @brief 测试推送配置
      * @param pushType 推送类型
@@ -166,6 +294,49 @@ public:
      */
     bool loadRulesToCache();
 
+    /**
+     * @brief 增量更新规则缓存中的一条规则（不存在时追加）
+     * 
+     * 只重新解析该规则的渠道配置，不重新查询数据库；缓存未加载时不做任何事
+     * @param rule 已写入数据库的规则（含ID）
+     * @return true 更新成功
+     * @return false 更新失败
+     */
+    bool upsertCachedRule(const ForwardRule& rule);
+
+    /**
+     * @brief 从规则缓存中移除一条规则
+     * @param ruleId 规则ID
+     * @return true 移除成功或规则不在缓存中
+     * @return false 移除失败
+     */
+    bool removeCachedRule(int ruleId);
+
+    /**
+     * @brief 从数据库重新加载一个号码名单并发布新快照（名单导入或删除后调用）
+     * 
+     * 缓存未加载时不做任何事，首次使用时随规则一起完整加载
+     * @param listName 名单名
+     * @return true 重新加载成功
+     * @return false 加载失败（保留旧名单）
+     */
+    bool reloadNumberList(const String& listName);
+
+    /**
+     * @brief 获取当前规则快照中的号码名单（未加载时先加载规则缓存）
+     * @return NumberListMap 名单名到号码集合的映射（集合只读，与快照共享）
+     */
+    NumberListMap getNumberLists();
+
+    /**
+     * @brief 测量以当前规则快照匹配一条短信的耗时（只匹配，不推送）
+     * @param name 测量项名称
+     * @param context 推送上下文
+     * @param iterations 执行次数
+     * @return BenchmarkResult 测量结果（规则快照不可用时iterations为0）
+     */
+    BenchmarkResult benchmarkRuleMatch(const String& name, const PushContext& context, int iterations);
+
 private:
     /**
      * @brief 私有构造函数（单例模式）
@@ -187,12 +358,36 @@ private:
      */
     PushManager& operator=(const PushManager&) = delete;
 
+    /**
+     * @brief 按匹配的转发规则推送短信（processSmsForward的主体）
+     * @param context 推送上下文
+     * @param matched 已有的规则匹配结果（nullptr或未匹配时在此匹配）
+     * @return PushResult 推送结果
+     */
+    PushResult forwardByMatchedRules(const PushContext& context, const MatchedRules* matched);
+
+    /**
+     * @brief 记录推送结束并保存当前任务的链路追踪
+     * @param context 推送上下文
+     */
+    void finishTrace(const PushContext& context);
+
     /**
      * @brief 匹配转发规则
      * @param context 推送上下文
-     * @return std::vector<ForwardRule> 匹配的规则列表
+     * @param snapshot 规则快照
+     * @param indices 输出的匹配规则在snapshot.rules中的下标（升序）
+     * @param capacity indices容量
+     * @return size_t 匹配的规则数
      */
-    std::vector<ForwardRule> matchForwardRules(const PushContext& context);
+    size_t matchForwardRules(const PushContext& context, const ForwardRuleSnapshot& snapshot,
+                             uint16_t* indices, size_t capacity);
+
+    /**
+     * @brief 获取当前规则快照（未加载时先加载）
+     * @return std::shared_ptr<const ForwardRuleSnapshot> 规则快照，加载失败返回nullptr
+     */
+    std::shared_ptr<const ForwardRuleSnapshot> acquireRuleSnapshot();
 
     /**
      * @brief 检查号码是否匹配
@@ -216,20 +411,149 @@ private:
      * @brief 执行推送
      * @param rule 转发规则
      * @param context 推送上下文
-     * @return PushResult 推送结果
+     * @param prepared 预解析的渠道配置（nullptr时按rule.pushConfig解析）
+     * @param outboxId 发件箱条目ID（异步确认的渠道以此关联确认结果，-1表示无）
+     * @return PushResult 推送结果（PUSH_PENDING时转发结果在确认后记录）
+     */
+    PushResult executePush(const ForwardRule& rule, const PushContext& context,
+                           const PushChannelConfig* prepared = nullptr, int outboxId = -1);
+
+    /**
+     * @brief 登记等待服务器确认的推送（发件箱条目保留到确认结果到达）
+     * @param rule 转发规则
+     * @param context 推送上下文
+     * @param entry 发件箱条目
+     * @param endpoint 端点标识
+     */
+    void awaitDelivery(const ForwardRule& rule, const PushContext& context, const PushOutboxEntry& entry,
+                       uint32_t endpoint);
+
+    /**
+     * @brief 发件箱条目是否正在等待服务器确认
+     * @param outboxId 发件箱条目ID
+     * @return true 正在等待，不应重试
+     * @return false 未在等待
      */
-    PushResult executePush(const ForwardRule& rule, const PushContext& context);
+    bool isAwaitingDelivery(int outboxId);
+
+    /**
+     * @brief 将规则的推送结果记录到短信记录
+     * @param rule 转发规则
+     * @param context 推送上下文
+     * @param result 推送结果
+     */
+    void recordForwardResult(const ForwardRule& rule, const PushContext& context, PushResult result);
+
+    /**
+     * @brief 为复用发件箱条目结果的同目标规则记录推送结果
+     * @param followerRuleIds 规则ID（逗号分隔，已删除的规则跳过）
+     * @param context 推送上下文
+     * @param result 推送结果
+     */
+    void recordFollowerResults(const String& followerRuleIds, const PushContext& context, PushResult result);
+
+    /**
+     * @brief 推送前写入发件箱条目（断电或重启后可继续重试）
+     * @param rule 转发规则
+     * @param context 推送上下文
+     * @param holdSeconds 推送完成前发生重启时，距首次重试的秒数
+     * @param followerRuleIds 推送目标相同、复用本条目结果的规则ID（逗号分隔）
+     * @return int 发件箱条目ID，-1表示无需或写入失败
+     */
+    int journalOutboxEntry(const ForwardRule& rule, const PushContext& context,
+                           time_t holdSeconds = PUSH_OUTBOX_BASE_DELAY_S, const String& followerRuleIds = String());
+
+    /**
+     * @brief 发送一个汇总，并逐条记录转发结果与结算发件箱条目
+     * @param digest 待发送的汇总
+     */
+    void flushDigest(PendingDigest& digest);
+
+    /**
+     * @brief 从规则推送配置中解析汇总策略
+     * @param pushConfig 推送配置（JSON格式）
+     * @return DigestPolicy 汇总策略，未配置digest_window时windowMs为0
+     */
+    static DigestPolicy parseDigestPolicy(const String& pushConfig);
+
+    /**
+     * @brief 根据推送结果更新发件箱条目：成功或不可重试时删除，否则按指数退避重新排期
+     * @param entry 发件箱条目
+     * @param result 推送结果
+     */
+    void settleOutboxEntry(PushOutboxEntry& entry, PushResult result);
+
+    /**
+     * @brief 计算第attempt次失败后的退避时长
+     * @param attempt 已失败的尝试次数
+     * @return time_t 退避秒数
+     */
+    static time_t computeOutboxBackoff(int attempt);
+
+    /**
+     * @brief 申请向规则的推送端点推送一次（限流与熔断），被拒绝时记录原因
+     * @param rule 转发规则
+     * @param endpoint 输出：端点标识，放行后以此报告推送结果
+     * @param retryInMs 输出：被拒绝时建议的等待毫秒数
+     * @return true 放行
+     * @return false 推送已暂停，或端点超出速率限制、已熔断
+     */
+    bool admitEndpoint(const ForwardRule& rule, uint32_t& endpoint, unsigned long& retryInMs);
+
+    /**
+     * @brief 推迟发件箱条目（不计入重试次数）
+     * @param entry 发件箱条目
+     * @param delayMs 推迟的毫秒数
+     */
+    void deferOutboxEntry(PushOutboxEntry& entry, unsigned long delayMs);
+
+    /**
+     * @brief 在数据库工作线程中写回发件箱条目
+     * @param entry 发件箱条目
+     * @return true 写入成功
+     * @return false 写入失败（已输出日志）
+     */
+    bool updateOutboxEntry(const PushOutboxEntry& entry);
 
     /**
      * @brief 使用指定渠道执行推送
      * @param channelName 渠道名称
      * @param config 推送配置（JSON格式）
      * @param context 推送上下文
+     * @param prepared 预解析的渠道配置（nullptr时解析config）
      * @return PushResult 推送结果
      */
-    PushResult pushToChannel(const String& channelName, const String& config, const PushContext& context);
+    PushResult pushToChannel(const String& channelName, const String& config, const PushContext& context,
+                             const PushChannelConfig* prepared = nullptr);
+
+
+
+    /**
+     * @brief 复制当前快照的规则及逐条预解析结果，作为增量更新的起点
+     * @return std::shared_ptr<ForwardRuleSnapshot> 快照副本，未加载时返回nullptr
+     */
+    std::shared_ptr<ForwardRuleSnapshot> copyCurrentSnapshot();
+
+    /**
+     * @brief 预解析快照中一条规则的渠道配置与汇总策略
+     * @param snapshot 正在构建的快照
+     * @param index 规则下标
+     */
+    void prepareSnapshotRule(ForwardRuleSnapshot& snapshot, size_t index);
 
+    /**
+     * @brief 计算推送目标分组、编译匹配器并发布快照
+     * @param snapshot 规则与逐条预解析结果已就绪的快照
+     */
+    void publishSnapshot(const std::shared_ptr<ForwardRuleSnapshot>& snapshot);
 
+    /**
+     * @brief 从数据库加载一个号码名单
+     * @param listName 名单名
+     * @param expected 预计号码数（用于确定哈希表大小）
+     * @return std::shared_ptr<const NumberSet> 号码集合，加载失败返回nullptr
+     */
+    std::shared_ptr<const NumberSet> loadNumberList(const String& listName, size_t expected);
 
     /**
      * @brief 格式化时间戳
@@ -254,8 +578,15 @@ private:
     String lastError;              ///< 最后的错误信息
     bool debugMode;                ///< 调试模式
     bool initialized;              ///< 是否已初始化
-    std::vector<ForwardRule> cachedRules; ///< 缓存的转发规则
-    bool cacheLoaded;              ///< 缓存是否已加载
+    std::shared_ptr<const ForwardRuleSnapshot> ruleSnapshot; ///< 当前规则快照（nullptr表示未加载）
+    std::mutex snapshotMutex;      ///< 保护ruleSnapshot指针的读取与替换
+    std::mutex cacheUpdateMutex;   ///< 串行化全量加载与增量更新
+    PushDigestBuffer digestBuffer; ///< 正在收集的汇总
+    PushEndpointGuard endpointGuard; ///< 推送端点的限流与熔断状态
+    std::atomic<bool> pushPaused;  ///< 推送已暂停（内存紧张）
+    std::map<int, PendingDelivery> pendingDeliveries; ///< 等待服务器确认的推送（按发件箱条目ID）
+    std::vector<DeliveryReport> deliveryReports;     ///< 尚未结算的确认结果
+    std::mutex deliveryMutex;      ///< 保护pendingDeliveries与deliveryReports
 };
 
 #endif // PUSH_MANAGER_H
\ No newline at end of file
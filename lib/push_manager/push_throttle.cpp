@@ -0,0 +1,261 @@
+/**
+ * @file push_throttle.cpp
+ * @brief 推送端点守卫实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "push_throttle.h"
+
+/// FNV-1a参数
+static const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static const uint32_t FNV_PRIME = 16777619u;
+
+/**
+ * @struct ChannelRateLimit
+ * @brief 渠道的默认速率限制
+ */
+struct ChannelRateLimit {
+    const char* pushType;           ///< 推送渠道类型
+    uint16_t ratePerMinute;         ///< 每分钟最多推送条数
+};
+
+/// 有服务端限额的渠道（未列出的渠道不限速，只做熔断）
+static const ChannelRateLimit CHANNEL_RATE_LIMITS[] = {
+    {"dingtalk", PUSH_RATE_DINGTALK_PER_MINUTE},
+    {"wecom", PUSH_RATE_WECOM_PER_MINUTE},
+    {"feishu_bot", PUSH_RATE_FEISHU_PER_MINUTE}
+};
+
+/**
+ * @brief 将一段字节并入FNV-1a哈希
+ * @param hash 当前哈希
+ * @param data 数据
+ * @param length 长度
+ * @return uint32_t 新的哈希
+ */
+static uint32_t fnvAppend(uint32_t hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 构造函数
+ */
+PushEndpointGuard::PushEndpointGuard() {
+}
+
+/**
+ * @brief 计算推送端点标识
+ * @param pushType 推送渠道类型
+ * @param pushConfig 推送配置（JSON格式）
+ * @return uint32_t 端点标识
+ */
+uint32_t PushEndpointGuard::endpointKey(const String& pushType, const String& pushConfig) {
+    const char* target = pushConfig.c_str();
+    size_t targetLength = pushConfig.length();
+
+    // 只截取webhook_url的值，不解析整个JSON；模板等其他字段不同的规则仍共享同一机器人的限额
+    int keyPos = pushConfig.indexOf("\"webhook_url\"");
+    if (keyPos != -1) {
+        int colon = pushConfig.indexOf(':', keyPos + 13);
+        int start = colon != -1 ? pushConfig.indexOf('"', colon + 1) : -1;
+        int end = start != -1 ? pushConfig.indexOf('"', start + 1) : -1;
+        if (end != -1) {
+            target += start + 1;
+            targetLength = end - start - 1;
+        }
+    }
+
+    const char separator = 0;
+    uint32_t hash = FNV_OFFSET_BASIS;
+    hash = fnvAppend(hash, pushType.c_str(), pushType.length());
+    hash = fnvAppend(hash, &separator, 1);
+    return fnvAppend(hash, target, targetLength);
+}
+
+/**
+ * @brief 获取渠道的默认速率限制
+ * @param pushType 推送渠道类型
+ * @return uint16_t 每分钟最多推送条数（0表示不限速）
+ */
+uint16_t PushEndpointGuard::ratePerMinute(const String& pushType) {
+    for (const ChannelRateLimit& limit : CHANNEL_RATE_LIMITS) {
+        if (pushType == limit.pushType) {
+            return limit.ratePerMinute;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 申请向端点推送一次
+ * @param key 端点标识
+ * @param pushType 推送渠道类型
+ * @param now 当前时间（millis）
+ * @param retryInMs 输出：被拒绝时建议的等待毫秒数
+ * @return EndpointAdmission 准入结果
+ */
+EndpointAdmission PushEndpointGuard::admit(uint32_t key, const String& pushType, unsigned long now,
+                                           unsigned long& retryInMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EndpointState& state = acquireState(key, pushType, now);
+    state.lastUsedAt = now;
+    retryInMs = 0;
+
+    bool probe = false;
+    if (state.open) {
+        unsigned long elapsed = now - state.openedAt;
+        if (elapsed < state.cooldownMs) {
+            retryInMs = state.cooldownMs - elapsed;
+            return ENDPOINT_CIRCUIT_OPEN;
+        }
+        // 冷却结束：只放行一次试探，结果报告前其余推送仍视为熔断
+        if (state.probing) {
+            retryInMs = (unsigned long)PUSH_OUTBOX_BASE_DELAY_S * 1000UL;
+            return ENDPOINT_CIRCUIT_OPEN;
+        }
+        probe = true;
+    }
+
+    if (state.ratePerMinute > 0) {
+        refill(state, now);
+        if (state.milliTokens < 1000) {
+            retryInMs = (1000 - state.milliTokens) * 60UL / state.ratePerMinute + 1;
+            return ENDPOINT_THROTTLED;
+        }
+        state.milliTokens -= 1000;
+    }
+
+    state.probing = probe;
+    return ENDPOINT_ADMITTED;
+}
+
+/**
+ * @brief 报告已放行推送的结果
+ * @param key 端点标识
+ * @param result 推送结果
+ * @param now 当前时间（millis）
+ */
+void PushEndpointGuard::report(uint32_t key, PushResult result, unsigned long now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = endpoints.begin();
+    while (it != endpoints.end() && it->key != key) {
+        ++it;
+    }
+    if (it == endpoints.end()) {
+        return;
+    }
+    EndpointState& state = *it;
+    bool wasProbing = state.probing;
+    state.probing = false;
+
+    if (result == PUSH_SUCCESS) {
+        state.consecutiveFailures = 0;
+        state.open = false;
+        state.cooldownMs = PUSH_CIRCUIT_COOLDOWN_MS;
+        return;
+    }
+
+    // 只有推送失败与网络错误说明端点不可用；配置错误与规则失效不影响端点状态
+    if (result != PUSH_FAILED && result != PUSH_NETWORK_ERROR) {
+        return;
+    }
+
+    if (state.consecutiveFailures < UINT8_MAX) {
+        state.consecutiveFailures++;
+    }
+    if (wasProbing) {
+        unsigned long cooldownMs = state.cooldownMs * 2;
+        openCircuit(state, cooldownMs > PUSH_CIRCUIT_MAX_COOLDOWN_MS ? PUSH_CIRCUIT_MAX_COOLDOWN_MS : cooldownMs, now);
+    } else if (!state.open && state.consecutiveFailures >= PUSH_CIRCUIT_FAILURE_THRESHOLD) {
+        openCircuit(state, PUSH_CIRCUIT_COOLDOWN_MS, now);
+    }
+}
+
+/**
+ * @brief 查找端点状态，不存在时创建（已满时替换最久未使用的未熔断端点）
+ * @param key 端点标识
+ * @param pushType 推送渠道类型
+ * @param now 当前时间（millis）
+ * @return EndpointState& 端点状态
+ */
+PushEndpointGuard::EndpointState& PushEndpointGuard::acquireState(uint32_t key, const String& pushType,
+                                                                  unsigned long now) {
+    for (EndpointState& state : endpoints) {
+        if (state.key == key) {
+            return state;
+        }
+    }
+
+    EndpointState created;
+    created.key = key;
+    created.ratePerMinute = ratePerMinute(pushType);
+    created.milliTokens = (uint32_t)PUSH_RATE_BURST * 1000;
+    created.refilledAt = now;
+    created.lastUsedAt = now;
+    created.consecutiveFailures = 0;
+    created.open = false;
+    created.probing = false;
+    created.openedAt = 0;
+    created.cooldownMs = PUSH_CIRCUIT_COOLDOWN_MS;
+
+    if (endpoints.size() < PUSH_ENDPOINT_MAX_TRACKED) {
+        endpoints.push_back(created);
+        return endpoints.back();
+    }
+
+    // 熔断中的端点保留状态，否则被替换后会立即恢复请求
+    EndpointState* victim = nullptr;
+    for (EndpointState& state : endpoints) {
+        if (!state.open && (victim == nullptr || now - state.lastUsedAt > now - victim->lastUsedAt)) {
+            victim = &state;
+        }
+    }
+    if (victim == nullptr) {
+        victim = &endpoints.front();
+    }
+    *victim = created;
+    return *victim;
+}
+
+/**
+ * @brief 按流逝时间补充令牌
+ * @param state 端点状态
+ * @param now 当前时间（millis）
+ */
+void PushEndpointGuard::refill(EndpointState& state, unsigned long now) {
+    const uint32_t capacity = (uint32_t)PUSH_RATE_BURST * 1000;
+    unsigned long elapsed = now - state.refilledAt;
+    if (state.milliTokens >= capacity) {
+        state.milliTokens = capacity;
+        state.refilledAt = now;
+        return;
+    }
+
+    // 每毫秒补充 ratePerMinute/60 个千分之一令牌；只把已折算成令牌的时间计入，避免逐次取整丢失
+    unsigned long missing = capacity - state.milliTokens;
+    if (elapsed >= missing * 60 / state.ratePerMinute + 1) {
+        state.milliTokens = capacity;
+        state.refilledAt = now;
+        return;
+    }
+    unsigned long added = elapsed * state.ratePerMinute / 60;
+    state.milliTokens += added;
+    state.refilledAt += added * 60 / state.ratePerMinute;
+}
+
+/**
+ * @brief 熔断端点
+ * @param state 端点状态
+ * @param cooldownMs 冷却时间
+ * @param now 当前时间（millis）
+ */
+void PushEndpointGuard::openCircuit(EndpointState& state, unsigned long cooldownMs, unsigned long now) {
+    state.open = true;
+    state.openedAt = now;
+    state.cooldownMs = cooldownMs;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file push_throttle.h
+ * @brief 推送端点守卫 - 按推送目标限流，并对持续失败的目标熔断
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以令牌桶限制每个推送端点（机器人Webhook地址）的发送速率，
+ *    钉钉、企业微信等机器人超出每分钟限额后的请求只会被拒绝
+ * 2. 端点连续失败达到阈值后熔断一段冷却时间，期间不再发起请求；
+ *    冷却结束后放行一次试探，成功则恢复，失败则加倍冷却时间
+ * 3. 被拒绝的推送由PushManager推迟到发件箱，不计入重试次数
+ */
+
+#ifndef PUSH_THROTTLE_H
+#define PUSH_THROTTLE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <mutex>
+#include "push_channel_base.h"
+#include "../../include/constants.h"
+
+/**
+ * @enum EndpointAdmission
+ * @brief 端点准入结果
+ */
+enum EndpointAdmission {
+    ENDPOINT_ADMITTED = 0,          ///< 放行
+    ENDPOINT_THROTTLED = 1,         ///< 超出速率限制
+    ENDPOINT_CIRCUIT_OPEN = 2       ///< 端点已熔断
+};
+
+/**
+ * @class PushEndpointGuard
+ * @brief 推送端点守卫（线程安全）
+ *
+ * 每次admit()放行后必须以report()报告推送结果，否则试探状态不会解除
+ */
+class PushEndpointGuard {
+public:
+    /**
+     * @brief 构造函数
+     */
+    PushEndpointGuard();
+
+    /**
+     * @brief 计算推送端点标识
+     *
+     * 配置中含webhook_url时以渠道类型与该地址标识（同一机器人共享限额），
+     * 否则以渠道类型与整个配置标识
+     * @param pushType 推送渠道类型
+     * @param pushConfig 推送配置（JSON格式）
+     * @return uint32_t 端点标识
+     */
+    static uint32_t endpointKey(const String& pushType, const String& pushConfig);
+
+    /**
+     * @brief 获取渠道的默认速率限制
+     * @param pushType 推送渠道类型
+     * @return uint16_t 每分钟最多推送条数（0表示不限速）
+     */
+    static uint16_t ratePerMinute(const String& pushType);
+
+    /**
+     * @brief 申请向端点推送一次
+     * @param key 端点标识
+     * @param pushType 推送渠道类型
+     * @param now 当前时间（millis）
+     * @param retryInMs 输出：被拒绝时建议的等待毫秒数
+     * @return EndpointAdmission 准入结果
+     */
+    EndpointAdmission admit(uint32_t key, const String& pushType, unsigned long now, unsigned long& retryInMs);
+
+    /**
+     * @brief 报告已放行推送的结果
+     * @param key 端点标识
+     * @param result 推送结果
+     * @param now 当前时间（millis）
+     */
+    void report(uint32_t key, PushResult result, unsigned long now);
+
+private:
+    /**
+     * @struct EndpointState
+     * @brief 端点状态
+     */
+    struct EndpointState {
+        uint32_t key;                   ///< 端点标识
+        uint16_t ratePerMinute;         ///< 每分钟最多推送条数（0表示不限速）
+        uint32_t milliTokens;           ///< 令牌余量（千分之一个令牌）
+        unsigned long refilledAt;       ///< 上次补充令牌的时间（millis）
+        unsigned long lastUsedAt;       ///< 最近一次申请的时间（millis）
+        uint8_t consecutiveFailures;    ///< 连续失败次数
+        bool open;                      ///< 是否已熔断
+        bool probing;                   ///< 冷却结束后的试探推送是否进行中
+        unsigned long openedAt;         ///< 熔断开始时间（millis）
+        unsigned long cooldownMs;       ///< 本次熔断的冷却时间
+    };
+
+    /**
+     * @brief 查找端点状态，不存在时创建（已满时替换最久未使用的未熔断端点）
+     * @param key 端点标识
+     * @param pushType 推送渠道类型
+     * @param now 当前时间（millis）
+     * @return EndpointState& 端点状态
+     */
+    EndpointState& acquireState(uint32_t key, const String& pushType, unsigned long now);
+
+    /**
+     * @brief 按流逝时间补充令牌
+     * @param state 端点状态
+     * @param now 当前时间（millis）
+     */
+    static void refill(EndpointState& state, unsigned long now);
+
+    /**
+     * @brief 熔断端点
+     * @param state 端点状态
+     * @param cooldownMs 冷却时间
+     * @param now 当前时间（millis）
+     */
+    static void openCircuit(EndpointState& state, unsigned long cooldownMs, unsigned long now);
+
+private:
+    std::vector<EndpointState> endpoints;   ///< 已知端点（最多PUSH_ENDPOINT_MAX_TRACKED个）
+    std::mutex mutex;                       ///< 保护endpoints
+};
+
+#endif // PUSH_THROTTLE_H
@@ -0,0 +1,486 @@
+/**
+ * @file push_worker.cpp
+ * @brief 异步推送工作线程实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "push_worker.h"
+#include "push_manager.h"
+#include "../log_manager/log_manager.h"
+#include "../task_topology/task_topology.h"
+#include "../metrics/metrics.h"
+#include "../../include/constants.h"
+#include <esp_heap_caps.h>
+#include <new>
+#include <limits.h>
+
+/// 优先级队列名称（指标标签与日志）
+static const char* const PUSH_LANE_NAMES[PUSH_PRIORITY_LANES] = { "high", "normal", "low" };
+
+// 单例实例
+PushWorker& PushWorker::getInstance() {
+    static PushWorker instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+PushWorker::PushWorker()
+    : intakeQueue(nullptr), queueStorage(nullptr), workerHandle(nullptr),
+      debugMode(false), initialized(false), drainPending(false) {
+    for (int lane = 0; lane < PUSH_PRIORITY_LANES; lane++) {
+        laneQueues[lane] = nullptr;
+    }
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief 析构函数
+ */
+PushWorker::~PushWorker() {
+}
+
+/**
+ * @brief 创建队列并启动工作线程
+ * @return true 启动成功
+ * @return false 启动失败
+ */
+bool PushWorker::initialize() {
+    if (initialized) {
+        return true;
+    }
+
+    // 队列只存放指针，存储区放在PSRAM中，避免占用内部RAM；接收队列排在各优先级队列之后
+    size_t laneStorageSize = PUSH_QUEUE_LENGTH * sizeof(PushJob*);
+    size_t storageSize = laneStorageSize * (PUSH_PRIORITY_LANES + 1);
+    queueStorage = (uint8_t*)heap_caps_malloc(storageSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (queueStorage == nullptr) {
+        queueStorage = (uint8_t*)heap_caps_malloc(storageSize, MALLOC_CAP_8BIT);
+    }
+    if (queueStorage == nullptr) {
+        setError("推送队列存储区分配失败");
+        return false;
+    }
+
+    // 静态队列不会创建失败（参数均为编译期常量）
+    for (int lane = 0; lane < PUSH_PRIORITY_LANES; lane++) {
+        laneQueues[lane] = xQueueCreateStatic(PUSH_QUEUE_LENGTH, sizeof(PushJob*),
+                                              queueStorage + lane * laneStorageSize, &queueControls[lane]);
+    }
+    intakeQueue = xQueueCreateStatic(PUSH_QUEUE_LENGTH, sizeof(PushJob*),
+                                     queueStorage + PUSH_PRIORITY_LANES * laneStorageSize, &intakeControl);
+
+    // 内存区分配失败不影响推送，临时对象回退到堆分配
+    if (!arena.initialize(PUSH_MESSAGE_ARENA_BYTES)) {
+        debugPrint("推送内存区分配失败，使用堆分配");
+    }
+
+    if (!TaskTopology::getInstance().createTask(SYSTEM_TASK_PUSH_WORKER, workerTask, this, &workerHandle)) {
+        for (int lane = 0; lane < PUSH_PRIORITY_LANES; lane++) {
+            vQueueDelete(laneQueues[lane]);
+            laneQueues[lane] = nullptr;
+        }
+        vQueueDelete(intakeQueue);
+        intakeQueue = nullptr;
+        heap_caps_free(queueStorage);
+        queueStorage = nullptr;
+        setError("推送工作线程创建失败");
+        return false;
+    }
+
+    initialized = true;
+    debugPrint("推送工作线程已启动，" + String(PUSH_PRIORITY_LANES) + " 个优先级队列，每个容量: " +
+               String(PUSH_QUEUE_LENGTH));
+    return true;
+}
+
+/**
+ * @brief 检查工作线程是否已运行
+ * @return true 已运行
+ * @return false 未运行
+ */
+bool PushWorker::isRunning() const {
+    return initialized;
+}
+
+/**
+ * @brief 投递推送任务（不阻塞调用方）
+ * @param context 推送上下文
+ * @return true 投递成功
+ * @return false 队列已满或未初始化
+ */
+bool PushWorker::enqueue(const PushContext& context) {
+    if (!initialized) {
+        setError("推送工作线程未初始化");
+        return false;
+    }
+
+    PushJob* job = allocateJob();
+    if (job == nullptr) {
+        stats.dropped++;
+        setError("推送任务内存分配失败");
+        return false;
+    }
+
+    // 规则匹配留给工作线程，接收路径只复制上下文
+    job->type = PUSH_JOB_SMS;
+    job->context = context;
+    job->lane = PUSH_LANE_LOW;
+    job->enqueuedAt = millis();
+    job->enqueuedAtUs = micros();
+
+    if (xQueueSend(intakeQueue, &job, 0) != pdTRUE) {
+        releaseJob(job);
+        stats.dropped++;
+        setError("推送接收队列已满");
+        return false;
+    }
+    xTaskNotifyGive(workerHandle);
+
+    stats.enqueued++;
+    debugPrint("推送任务已入队，短信ID: " + String(context.smsRecordId) + "，排队数量: " +
+               String(getPendingCount()));
+    return true;
+}
+
+/**
+ * @brief 请求处理发件箱中到期的重试条目（由定时任务调用）
+ * @return true 投递成功或已有待处理请求
+ * @return false 队列已满或未初始化
+ */
+bool PushWorker::requestOutboxDrain() {
+    if (!initialized) {
+        setError("推送工作线程未初始化");
+        return false;
+    }
+    
+    if (drainPending) {
+        return true;
+    }
+    
+    PushJob* job = allocateJob();
+    if (job == nullptr) {
+        setError("推送任务内存分配失败");
+        return false;
+    }
+    
+    // 重试让位于新短信：放入低优先级队列
+    job->type = PUSH_JOB_OUTBOX_DRAIN;
+    job->lane = PUSH_LANE_LOW;
+    
+    drainPending = true;
+    if (!submit(job)) {
+        drainPending = false;
+        releaseJob(job);
+        setError("推送队列已满");
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 唤醒工作线程（不投递任务）
+ */
+void PushWorker::wake() {
+    if (initialized && workerHandle != nullptr) {
+        xTaskNotifyGive(workerHandle);
+    }
+}
+
+/**
+ * @brief 获取当前排队的任务数量
+ * @return size_t 排队数量
+ */
+size_t PushWorker::getPendingCount() const {
+    size_t pending = intakeQueue != nullptr ? uxQueueMessagesWaiting(intakeQueue) : 0;
+    for (int lane = 0; lane < PUSH_PRIORITY_LANES; lane++) {
+        if (laneQueues[lane] != nullptr) {
+            pending += uxQueueMessagesWaiting(laneQueues[lane]);
+        }
+    }
+    return pending;
+}
+
+/**
+ * @brief 获取统计信息
+ * @return PushWorkerStats 统计信息
+ */
+PushWorkerStats PushWorker::getStats() const {
+    PushWorkerStats snapshot = stats;
+    snapshot.pending = getPendingCount();
+    return snapshot;
+}
+
+/**
+ * @brief 获取推送内存区统计信息
+ * @return MessageArenaStats 统计信息
+ */
+MessageArenaStats PushWorker::getArenaStats() const {
+    return arena.getStats();
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String PushWorker::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 启用调试模式
+ * @param enable 是否启用
+ */
+void PushWorker::setDebugMode(bool enable) {
+    debugMode = enable;
+}
+
+/**
+ * @brief FreeRTOS任务入口
+ * @param parameter PushWorker实例指针
+ */
+void PushWorker::workerTask(void* parameter) {
+    PushWorker* worker = static_cast<PushWorker*>(parameter);
+
+    while (true) {
+        // 有待发送的汇总或等待确认的推送时，最迟在其到期时醒来
+        PushManager& pushManager = PushManager::getInstance();
+        unsigned long delayMs = pushManager.getNextDigestDelayMs();
+        unsigned long deliveryDelayMs = pushManager.getNextDeliveryDelayMs();
+        if (deliveryDelayMs < delayMs) {
+            delayMs = deliveryDelayMs;
+        }
+        TickType_t waitTicks = (delayMs == ULONG_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(delayMs);
+
+        // 每入队一个任务通知计数加一；每次只取一个，下一轮重新从最高优先级队列开始
+        if (ulTaskNotifyTake(pdFALSE, waitTicks) > 0) {
+            worker->classifyIntake();
+            PushJob* job = worker->takeNextJob();
+            if (job != nullptr) {
+                worker->processJob(job);
+                releaseJob(job);
+            }
+        }
+
+        pushManager.settleDeliveries();
+        pushManager.flushDueDigests();
+    }
+}
+
+/**
+ * @brief 匹配接收队列中的新短信，按命中规则的最高优先级分入各队列
+ */
+void PushWorker::classifyIntake() {
+    PushManager& pushManager = PushManager::getInstance();
+    PushJob* job = nullptr;
+    while (xQueueReceive(intakeQueue, &job, 0) == pdTRUE) {
+        // 推送管理器初始化失败时不匹配，进入低优先级队列，推送时再匹配
+        SmsTraceScope traceScope(job->context.trace);
+        SmsTrace::mark(SMS_TRACE_WORKER);
+        int priority = pushManager.initialize() ? pushManager.matchRules(job->context, job->matched) : -1;
+        PushLane lane = laneForPriority(priority);
+        job->lane = lane;
+
+        // 入队时已通知过工作线程，这里只移动任务，不再通知；入队时间保持不变
+        if (xQueueSend(laneQueues[lane], &job, 0) != pdTRUE) {
+            // 该任务对应的通知会在取不到任务时空转一次
+            releaseJob(job);
+            stats.dropped++;
+            setError(String("推送队列已满: ") + PUSH_LANE_NAMES[lane]);
+            continue;
+        }
+        debugPrint("短信ID " + String(job->context.smsRecordId) + " 分入队列: " + PUSH_LANE_NAMES[lane]);
+    }
+}
+
+/**
+ * @brief 取出优先级最高的任务
+ * @return PushJob* 任务对象，所有队列为空时返回nullptr
+ */
+PushJob* PushWorker::takeNextJob() {
+    PushJob* job = nullptr;
+    for (int lane = 0; lane < PUSH_PRIORITY_LANES; lane++) {
+        if (xQueueReceive(laneQueues[lane], &job, 0) == pdTRUE) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 根据规则优先级选择队列
+ * @param priority 命中规则的最高优先级（-1表示没有命中规则）
+ * @return PushLane 队列
+ */
+PushLane PushWorker::laneForPriority(int priority) {
+    if (priority < 0) {
+        // 没有命中规则的短信只需记录结果
+        return PUSH_LANE_LOW;
+    }
+    if (priority <= PUSH_LANE_HIGH_MAX_PRIORITY) {
+        return PUSH_LANE_HIGH;
+    }
+    if (priority <= PUSH_LANE_NORMAL_MAX_PRIORITY) {
+        return PUSH_LANE_NORMAL;
+    }
+    return PUSH_LANE_LOW;
+}
+
+/**
+ * @brief 将任务放入其优先级队列并唤醒工作线程
+ * @param job 推送任务
+ * @return true 投递成功
+ * @return false 队列已满
+ */
+bool PushWorker::submit(PushJob* job) {
+    job->enqueuedAt = millis();
+    job->enqueuedAtUs = micros();
+    if (xQueueSend(laneQueues[job->lane], &job, 0) != pdTRUE) {
+        return false;
+    }
+    xTaskNotifyGive(workerHandle);
+    return true;
+}
+
+/**
+ * @brief 处理单个推送任务
+ * @param job 推送任务
+ */
+void PushWorker::processJob(PushJob* job) {
+    LogManager& logger = LogManager::getInstance();
+    PushManager& pushManager = PushManager::getInstance();
+
+    // 本任务的临时字符串与JSON分配在推送内存区中，函数返回时整体复位
+    ArenaScope arenaScope(arena);
+
+    unsigned long waitMs = millis() - job->enqueuedAt;
+    if (waitMs > stats.maxQueueWaitMs) {
+        stats.maxQueueWaitMs = waitMs;
+    }
+
+    if (!pushManager.initialize()) {
+        logger.logError(LOG_MODULE_SMS, "❌ 推送管理器初始化失败: " + pushManager.getLastError());
+        if (job->type == PUSH_JOB_OUTBOX_DRAIN) {
+            drainPending = false;
+        } else {
+            stats.processed++;
+            stats.failed++;
+        }
+        return;
+    }
+
+    if (job->type == PUSH_JOB_OUTBOX_DRAIN) {
+        drainPending = false;
+        int retried = pushManager.drainOutbox(PUSH_OUTBOX_DRAIN_BATCH);
+        if (retried > 0) {
+            debugPrint("发件箱本轮重试条目数: " + String(retried));
+        }
+        return;
+    }
+
+    SmsTraceScope traceScope(job->context.trace);
+    PushResult result = pushManager.processSmsForward(job->context, &job->matched);
+    // 入队到推送完成的延迟（含排队与推送），按优先级队列区分
+    MetricsRegistry::getInstance().observe(METRIC_FORWARD_LATENCY, micros() - job->enqueuedAtUs,
+                                           PUSH_LANE_NAMES[job->lane]);
+    logResult(result, waitMs);
+}
+
+/**
+ * @brief 输出推送结果日志并更新统计
+ * @param result 推送结果
+ * @param waitMs 排队等待时间
+ */
+void PushWorker::logResult(PushResult result, unsigned long waitMs) {
+    LogManager& logger = LogManager::getInstance();
+    PushManager& pushManager = PushManager::getInstance();
+    stats.processed++;
+
+    switch (result) {
+        case PUSH_SUCCESS:
+            stats.succeeded++;
+            logger.logInfo(LOG_MODULE_SMS, "✅ 短信转发成功 (排队 " + String(waitMs) + " ms)");
+            break;
+
+        case PUSH_NO_RULE:
+            logger.logInfo(LOG_MODULE_SMS, "ℹ️ 没有匹配的转发规则，跳过转发");
+            break;
+
+        case PUSH_RULE_DISABLED:
+            logger.logInfo(LOG_MODULE_SMS, "ℹ️ 转发规则已禁用，跳过转发");
+            break;
+
+        case PUSH_DEFERRED:
+            logger.logInfo(LOG_MODULE_SMS, "⏸️ 推送端点限流或熔断，已推迟到发件箱: " + pushManager.getLastError());
+            break;
+
+        case PUSH_PENDING:
+            logger.logInfo(LOG_MODULE_SMS, "📤 短信已发布，等待服务器确认 (排队 " + String(waitMs) + " ms)");
+            break;
+
+        case PUSH_CONFIG_ERROR:
+            stats.failed++;
+            logger.logError(LOG_MODULE_SMS, "❌ 转发配置错误: " + pushManager.getLastError());
+            break;
+
+        case PUSH_NETWORK_ERROR:
+            stats.failed++;
+            logger.logError(LOG_MODULE_SMS, "❌ 网络错误: " + pushManager.getLastError());
+            break;
+
+        case PUSH_FAILED:
+        default:
+            stats.failed++;
+            logger.logError(LOG_MODULE_SMS, "❌ 短信转发失败: " + pushManager.getLastError());
+            break;
+    }
+}
+
+/**
+ * @brief 分配推送任务对象（优先使用PSRAM）
+ * @return PushJob* 任务对象，失败返回nullptr
+ */
+PushJob* PushWorker::allocateJob() {
+    void* memory = heap_caps_malloc(sizeof(PushJob), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (memory == nullptr) {
+        memory = heap_caps_malloc(sizeof(PushJob), MALLOC_CAP_8BIT);
+    }
+    if (memory == nullptr) {
+        return nullptr;
+    }
+    return new (memory) PushJob();
+}
+
+/**
+ * @brief 释放推送任务对象
+ * @param job 任务对象
+ */
+void PushWorker::releaseJob(PushJob* job) {
+    if (job == nullptr) {
+        return;
+    }
+    job->~PushJob();
+    heap_caps_free(job);
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void PushWorker::setError(const String& error) {
+    lastError = error;
+    debugPrint("错误: " + error);
+}
+
+/**
+ * @brief 调试输出
+ * @param message 调试信息
+ */
+void PushWorker::debugPrint(const String& message) {
+    if (debugMode) {
+        Serial.println("[PushWorker] " + message);
+    }
+}
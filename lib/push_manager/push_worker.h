@@ -0,0 +1,264 @@
+/**
+ * @file push_worker.h
+ * @brief 异步推送工作线程 - 将短信转发从UART接收路径中解耦
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 维护高、普通、低三个有界的推送任务队列（任务对象优先分配在PSRAM）
+ * 2. 在独立的FreeRTOS任务中调用PushManager执行推送，每次都先取优先级最高的任务，
+ *    验证码等高优先级短信不必排在一串营销短信的HTTP推送之后
+ * 3. 让短信接收路径只承担"解码 + 入库"的开销：新短信先进入接收队列，
+ *    由工作线程匹配规则后分入优先级队列，匹配结果随任务保存，推送时不再重复匹配
+ * 4. 每个任务在推送内存区中执行，模板渲染与渠道JSON等临时分配不占用内部RAM，任务结束后整体复位
+ */
+
+#ifndef PUSH_WORKER_H
+#define PUSH_WORKER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "push_channel_base.h"
+#include "push_manager.h"
+#include "../message_arena/message_arena.h"
+#include "../../include/constants.h"
+
+/**
+ * @enum PushJobType
+ * @brief 推送任务类型
+ */
+enum PushJobType {
+    PUSH_JOB_SMS = 0,              ///< 新短信：匹配规则并推送
+    PUSH_JOB_OUTBOX_DRAIN          ///< 处理发件箱中到期的重试条目
+};
+
+/**
+ * @enum PushLane
+ * @brief 推送优先级队列（按命中规则的最高优先级划分）
+ */
+enum PushLane {
+    PUSH_LANE_HIGH = 0,            ///< 高优先级（如验证码）
+    PUSH_LANE_NORMAL,              ///< 普通
+    PUSH_LANE_LOW                  ///< 低优先级（如营销短信、发件箱重试）
+};
+
+/**
+ * @struct PushJob
+ * @brief 推送队列中的任务项
+ */
+struct PushJob {
+    PushJobType type;              ///< 任务类型
+    PushContext context;           ///< 推送上下文（仅PUSH_JOB_SMS有效）
+    MatchedRules matched;          ///< 分入优先级队列时的规则匹配结果（仅PUSH_JOB_SMS有效）
+    PushLane lane;                 ///< 所在的优先级队列
+    unsigned long enqueuedAt;      ///< 入队时间（millis）
+    uint32_t enqueuedAtUs;         ///< 入队时间（micros，用于延迟直方图）
+};
+
+/**
+ * @struct PushWorkerStats
+ * @brief 推送工作线程统计信息
+ */
+struct PushWorkerStats {
+    unsigned long enqueued;        ///< 入队总数
+    unsigned long processed;       ///< 已处理总数
+    unsigned long succeeded;       ///< 推送成功数
+    unsigned long failed;          ///< 推送失败数
+    unsigned long dropped;         ///< 队列满被拒绝数
+    unsigned long maxQueueWaitMs;  ///< 最大排队等待时间
+    size_t pending;                ///< 当前排队数量
+};
+
+/**
+ * @class PushWorker
+ * @brief 异步推送工作线程类
+ *
+ * 短信处理器通过enqueue()投递推送任务，工作线程在后台串行执行推送，
+ * HTTP重试与网络等待不会再阻塞UART监控任务。正在进行的推送不会被打断，
+ * 高优先级任务在当前推送完成后立即执行
+ */
+class PushWorker {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return PushWorker& 单例引用
+     */
+    static PushWorker& getInstance();
+
+    /**
+     * @brief 创建队列并启动工作线程
+     * @return true 启动成功
+     * @return false 启动失败
+     */
+    bool initialize();
+
+    /**
+     * @brief 检查工作线程是否已运行
+     * @return true 已运行
+     * @return false 未运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 投递推送任务（不阻塞调用方）
+     * 
+     * 任务先进入接收队列，调用方不做规则匹配；工作线程匹配后按命中规则的最高优先级分入队列
+     * @param context 推送上下文
+     * @return true 投递成功
+     * @return false 队列已满或未初始化
+     */
+    bool enqueue(const PushContext& context);
+
+    /**
+     * @brief 请求处理发件箱中到期的重试条目（由定时任务调用）
+     * 
+     * 重试在工作线程中串行执行，与新短信推送共享同一个HTTP通道，
+     * 已有未处理的请求时不会重复投递
+     * @return true 投递成功或已有待处理请求
+     * @return false 队列已满或未初始化
+     */
+    bool requestOutboxDrain();
+
+    /**
+     * @brief 唤醒工作线程（不投递任务），用于结算异步到达的推送确认
+     */
+    void wake();
+
+    /**
+     * @brief 获取当前排队的任务数量
+     * @return size_t 排队数量
+     */
+    size_t getPendingCount() const;
+
+    /**
+     * @brief 获取统计信息
+     * @return PushWorkerStats 统计信息
+     */
+    PushWorkerStats getStats() const;
+
+    /**
+     * @brief 获取推送内存区统计信息
+     * @return MessageArenaStats 统计信息
+     */
+    MessageArenaStats getArenaStats() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+    /**
+     * @brief 启用调试模式
+     * @param enable 是否启用
+     */
+    void setDebugMode(bool enable);
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    PushWorker();
+
+    /**
+     * @brief 析构函数
+     */
+    ~PushWorker();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    PushWorker(const PushWorker&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    PushWorker& operator=(const PushWorker&) = delete;
+
+    /**
+     * @brief FreeRTOS任务入口
+     * @param parameter PushWorker实例指针
+     */
+    static void workerTask(void* parameter);
+
+    /**
+     * @brief 匹配接收队列中的新短信，按命中规则的最高优先级分入各队列
+     */
+    void classifyIntake();
+
+    /**
+     * @brief 取出优先级最高的任务
+     * @return PushJob* 任务对象，所有队列为空时返回nullptr
+     */
+    PushJob* takeNextJob();
+
+    /**
+     * @brief 根据规则优先级选择队列
+     * @param priority 命中规则的最高优先级（-1表示没有命中规则）
+     * @return PushLane 队列
+     */
+    static PushLane laneForPriority(int priority);
+
+    /**
+     * @brief 将任务放入其优先级队列并唤醒工作线程
+     * @param job 推送任务
+     * @return true 投递成功
+     * @return false 队列已满
+     */
+    bool submit(PushJob* job);
+
+    /**
+     * @brief 处理单个推送任务
+     * @param job 推送任务
+     */
+    void processJob(PushJob* job);
+
+    /**
+     * @brief 输出推送结果日志并更新统计
+     * @param result 推送结果
+     * @param waitMs 排队等待时间
+     */
+    void logResult(PushResult result, unsigned long waitMs);
+
+    /**
+     * @brief 分配推送任务对象（优先使用PSRAM）
+     * @return PushJob* 任务对象，失败返回nullptr
+     */
+    static PushJob* allocateJob();
+
+    /**
+     * @brief 释放推送任务对象
+     * @param job 任务对象
+     */
+    static void releaseJob(PushJob* job);
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+    /**
+     * @brief 调试输出
+     * @param message 调试信息
+     */
+    void debugPrint(const String& message);
+
+private:
+    QueueHandle_t laneQueues[PUSH_PRIORITY_LANES];      ///< 各优先级的推送任务队列（存放PushJob指针）
+    QueueHandle_t intakeQueue;                          ///< 尚未匹配规则的新短信任务队列
+    uint8_t* queueStorage;                              ///< 全部队列的存储区（PSRAM）
+    StaticQueue_t queueControls[PUSH_PRIORITY_LANES];   ///< 静态队列控制块
+    StaticQueue_t intakeControl;                        ///< 接收队列控制块
+    TaskHandle_t workerHandle;     ///< 工作线程句柄
+    MessageArena arena;            ///< 推送内存区（每个任务结束后复位）
+    PushWorkerStats stats;         ///< 统计信息
+    String lastError;              ///< 最后的错误信息
+    bool debugMode;                ///< 调试模式
+    bool initialized;              ///< 是否已初始化
+    volatile bool drainPending;    ///< 是否已有待处理的发件箱请求
+};
+
+#endif // PUSH_WORKER_H
@@ -0,0 +1,219 @@
+/**
+ * @file rule_backtest.cpp
+ * @brief 转发规则回测实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "rule_backtest.h"
+#include "push_manager.h"
+#include "number_set.h"
+
+namespace {
+
+/**
+ * @brief 计算UTF-8字符串的字符数
+ * @param text 字符串
+ * @return size_t 字符数
+ */
+size_t utf8Length(const String& text) {
+    size_t count = 0;
+    for (size_t i = 0; i < text.length(); i++) {
+        if ((static_cast<uint8_t>(text[i]) & 0xC0) != 0x80) {
+            count++;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+RuleBacktest::RuleBacktest()
+    : cursorId(0), maxRecords(0), maxSamples(0), examined(0), matched(0), samplesKept(0),
+      finished(true), limitReached(false), elapsedMs(0) {}
+
+/**
+ * @brief 准备回测：编译规则并生成全文索引预筛选查询
+ * @param rule 待回测的规则
+ * @param maxRecords 最多检查的短信数
+ * @param maxSamples 最多保留的命中样例数
+ * @return true 准备完成
+ * @return false 规则无法编译
+ */
+bool RuleBacktest::begin(const ForwardRule& rule, int maxRecords, size_t maxSamples) {
+    rules.assign(1, rule);
+    rules[0].enabled = true;
+
+    // 名单规则需要当前快照中的号码集合
+    NumberListMap numberLists;
+    String listName;
+    bool negated = false;
+    if (NumberSet::parseListPattern(rule.sourceNumber, listName, negated)) {
+        numberLists = PushManager::getInstance().getNumberLists();
+    }
+    if (!matcher.compile(rules, &numberLists)) {
+        lastError = "规则编译失败";
+        return false;
+    }
+
+    matchQuery = DatabaseManager::getInstance().isSearchIndexEnabled() ? buildMatchQuery(rule) : String();
+    cursorId = 0;
+    this->maxRecords = maxRecords;
+    this->maxSamples = maxSamples;
+    examined = 0;
+    matched = 0;
+    samplesKept = 0;
+    finished = maxRecords <= 0;
+    limitReached = false;
+    elapsedMs = 0;
+    lastError = "";
+    return true;
+}
+
+/**
+ * @brief 检查下一批短信
+ * @param samples 输出：本批新增的命中样例（追加）
+ * @return true 还有短信未检查
+ * @return false 已结束
+ */
+bool RuleBacktest::step(std::vector<RuleBacktestSample>& samples) {
+    if (finished) {
+        return false;
+    }
+
+    unsigned long start = millis();
+    int batch = maxRecords - examined < RULE_BACKTEST_BATCH_ROWS ? maxRecords - examined : RULE_BACKTEST_BATCH_ROWS;
+    DatabaseManager& dbManager = DatabaseManager::getInstance();
+    uint16_t index;
+
+    int count = dbManager.scanSMSBatch(cursorId, matchQuery, batch,
+        [&](int id, const char* fromNumber, const char* content, time_t receivedAt) {
+            if (matcher.match(fromNumber, content, &index, 1) == 0) {
+                return;
+            }
+            matched++;
+            if (samplesKept < maxSamples) {
+                samples.push_back(RuleBacktestSample{id, fromNumber, content, receivedAt});
+                samplesKept++;
+            }
+        }, cursorId);
+    elapsedMs += millis() - start;
+
+    if (count < 0) {
+        lastError = dbManager.getLastError();
+        finished = true;
+        return false;
+    }
+
+    examined += count;
+    if (count < batch) {
+        finished = true;
+    } else if (examined >= maxRecords) {
+        finished = true;
+        limitReached = true;
+    }
+    return !finished;
+}
+
+/**
+ * @brief 是否使用了全文索引预筛选
+ * @return true 只检查了全文索引命中的记录
+ * @return false 检查了全部记录
+ */
+bool RuleBacktest::isPrefiltered() const {
+    return !matchQuery.isEmpty();
+}
+
+/**
+ * @brief 是否因达到maxRecords而提前结束
+ * @return true 还有更早的记录未检查
+ * @return false 已检查到最早的记录
+ */
+bool RuleBacktest::isLimitReached() const {
+    return limitReached;
+}
+
+/**
+ * @brief 获取已交给匹配器检查的短信数
+ * @return int 检查数
+ */
+int RuleBacktest::getExamined() const {
+    return examined;
+}
+
+/**
+ * @brief 获取命中数
+ * @return int 命中数
+ */
+int RuleBacktest::getMatched() const {
+    return matched;
+}
+
+/**
+ * @brief 获取各批累计耗时
+ * @return unsigned long 耗时(ms)
+ */
+unsigned long RuleBacktest::getElapsedMs() const {
+    return elapsedMs;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String RuleBacktest::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief 由规则关键词生成FTS5预筛选查询
+ *
+ * 关键词之间是"或"的关系，生成 content : ("关键词1" OR "关键词2")；
+ * 任一关键词短于trigram可索引的长度时无法预筛选，返回空串
+ * @param rule 规则
+ * @return String 查询表达式，无法预筛选时为空
+ */
+String RuleBacktest::buildMatchQuery(const ForwardRule& rule) {
+    // 默认转发与未配置关键词的规则只按号码判断，需要检查全部记录
+    if (rule.isDefaultForward || rule.keywords.isEmpty()) {
+        return String();
+    }
+
+    // 与RuleMatcher相同的拆分方式：按逗号分割，每个关键词去空白，跳过空关键词
+    String query = "content : (";
+    int terms = 0;
+    int begin = 0;
+    while (begin <= (int)rule.keywords.length()) {
+        int comma = rule.keywords.indexOf(',', begin);
+        int end = comma >= 0 ? comma : rule.keywords.length();
+        String keyword = rule.keywords.substring(begin, end);
+        keyword.trim();
+        if (!keyword.isEmpty()) {
+            if (utf8Length(keyword) < SMS_SEARCH_MIN_INDEXED_CHARS) {
+                return String();
+            }
+            // 作为短语整体匹配，避免关键词中的FTS5语法字符被解释
+            keyword.replace("\"", "\"\"");
+            if (terms > 0) {
+                query += " OR ";
+            }
+            query += '"';
+            query += keyword;
+            query += '"';
+            terms++;
+        }
+        if (comma < 0) {
+            break;
+        }
+        begin = comma + 1;
+    }
+
+    if (terms == 0) {
+        return String();
+    }
+    query += ')';
+    return query;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file rule_backtest.h
+ * @brief 转发规则回测 - 用预编译匹配器分批检查历史短信，统计规则会命中哪些记录
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 将待回测的规则（可以是尚未保存的编辑内容）单独编译为RuleMatcher，与推送时的匹配结果一致
+ * 2. 关键词都不短于SMS_SEARCH_MIN_INDEXED_CHARS个字符且全文索引可用时，生成FTS5查询，
+ *    只读取内容命中任一关键词的记录（trigram不区分大小写，结果是匹配器结果的超集，最终仍由匹配器判定）
+ * 3. 按ID倒序分批读取，每批只取号码与内容列并直接交给匹配器，不构造SMSRecord；
+ *    每批是一次独立的数据库调用，回测期间短信入库不会被长时间阻塞
+ * 4. 统计检查数与命中数，保留最新的若干条命中样例
+ */
+
+#ifndef RULE_BACKTEST_H
+#define RULE_BACKTEST_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../database_manager/database_manager.h"
+#include "rule_matcher.h"
+#include "../../include/constants.h"
+
+/**
+ * @struct RuleBacktestSample
+ * @brief 命中样例
+ */
+struct RuleBacktestSample {
+    int id;                 ///< 短信记录ID
+    String fromNumber;      ///< 发送方号码
+    String content;         ///< 短信内容
+    time_t receivedAt;      ///< 接收时间
+};
+
+/**
+ * @class RuleBacktest
+ * @brief 一次规则回测（begin()之后反复调用step()直到返回false）
+ */
+class RuleBacktest {
+public:
+    /**
+     * @brief 构造函数
+     */
+    RuleBacktest();
+
+    /**
+     * @brief 准备回测：编译规则并生成全文索引预筛选查询
+     * @param rule 待回测的规则（忽略启用状态，按启用处理）
+     * @param maxRecords 最多检查的短信数
+     * @param maxSamples 最多保留的命中样例数
+     * @return true 准备完成
+     * @return false 规则无法编译
+     */
+    bool begin(const ForwardRule& rule, int maxRecords = RULE_BACKTEST_MAX_RECORDS,
+               size_t maxSamples = RULE_BACKTEST_MAX_SAMPLES);
+
+    /**
+     * @brief 检查下一批短信（须在数据库工作线程调用）
+     * @param samples 输出：本批新增的命中样例（追加）
+     * @return true 还有短信未检查
+     * @return false 已检查完、达到maxRecords或读取失败
+     */
+    bool step(std::vector<RuleBacktestSample>& samples);
+
+    /**
+     * @brief 是否使用了全文索引预筛选
+     * @return true 只检查了全文索引命中的记录
+     * @return false 检查了全部记录
+     */
+    bool isPrefiltered() const;
+
+    /**
+     * @brief 是否因达到maxRecords而提前结束
+     * @return true 还有更早的记录未检查
+     * @return false 已检查到最早的记录
+     */
+    bool isLimitReached() const;
+
+    /**
+     * @brief 获取已交给匹配器检查的短信数
+     * @return int 检查数
+     */
+    int getExamined() const;
+
+    /**
+     * @brief 获取命中数
+     * @return int 命中数
+     */
+    int getMatched() const;
+
+    /**
+     * @brief 获取各批累计耗时（不含批与批之间的等待）
+     * @return unsigned long 耗时(ms)
+     */
+    unsigned long getElapsedMs() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息（无错误时为空）
+     */
+    String getLastError() const;
+
+private:
+    /**
+     * @brief 由规则关键词生成FTS5预筛选查询
+     * @param rule 规则
+     * @return String 查询表达式，无法预筛选时为空
+     */
+    static String buildMatchQuery(const ForwardRule& rule);
+
+    std::vector<ForwardRule> rules;     ///< 只含待回测规则（匹配器下标指向此列表）
+    RuleMatcher matcher;                ///< 由rules编译的匹配器
+    String matchQuery;                  ///< 全文索引预筛选查询（空表示不预筛选）
+    int cursorId;                       ///< 下一批的游标（ID小于此值），0表示从最新开始
+    int maxRecords;                     ///< 最多检查的短信数
+    size_t maxSamples;                  ///< 最多保留的样例数
+    int examined;                       ///< 已检查的短信数
+    int matched;                        ///< 命中数
+    size_t samplesKept;                 ///< 已输出的样例数
+    bool finished;                      ///< 是否已结束
+    bool limitReached;                  ///< 是否因达到maxRecords结束
+    unsigned long elapsedMs;            ///< 累计耗时
+    String lastError;                   ///< 最后的错误信息
+};
+
+#endif // RULE_BACKTEST_H
@@ -0,0 +1,439 @@
+/**
+ * @file rule_matcher.cpp
+ * @brief 转发规则匹配器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "rule_matcher.h"
+#include <ctype.h>
+#include <string.h>
+
+namespace {
+
+/**
+ * @brief 去除区间首尾空白（与String::trim()一致）
+ * @param begin 起始指针（输入输出）
+ * @param end 结束指针（输入输出）
+ */
+void trimRange(const char*& begin, const char*& end) {
+    while (begin < end && isspace(static_cast<unsigned char>(*begin))) {
+        begin++;
+    }
+    while (end > begin && isspace(static_cast<unsigned char>(*(end - 1)))) {
+        end--;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+RuleMatcher::RuleMatcher() {
+    compile(std::vector<ForwardRule>());
+}
+
+/**
+ * @brief 根据规则列表编译匹配器
+ * @param rules 规则列表
+ * @param numberLists 名单规则引用的号码集合
+ * @return true 编译成功
+ * @return false 规则数超过上限
+ */
+bool RuleMatcher::compile(const std::vector<ForwardRule>& rules, const NumberListMap* numberLists) {
+    compiled.clear();
+    pool.clear();
+    trie.clear();
+    trieLinks.clear();
+    unconditional.clear();
+    residual.clear();
+    listRules.clear();
+    listSets.clear();
+    keywordNodes.clear();
+    keywordOutputs.clear();
+    memset(keywordRoot, 0, sizeof(keywordRoot));
+    trie.push_back(TrieNode{0, -1, -1, -1});
+    keywordNodes.push_back(KeywordNode{0, -1, -1, 0, -1, -1});
+
+    if (rules.size() > RULE_MATCHER_MAX_RULES) {
+        return false;
+    }
+
+    for (size_t i = 0; i < rules.size(); i++) {
+        const ForwardRule& rule = rules[i];
+        if (!rule.enabled) {
+            continue;
+        }
+
+        CompiledRule entry;
+        entry.ruleIndex = static_cast<uint16_t>(i);
+        entry.matchAll = rule.isDefaultForward;
+        entry.numberKind = NUMBER_ANY;
+        entry.prefixOffset = 0;
+        entry.prefixLength = 0;
+        entry.suffixOffset = 0;
+        entry.suffixLength = 0;
+        entry.keywordsRequired = false;
+        entry.keywordCount = 0;
+        entry.listIndex = -1;
+
+        uint16_t compiledIndex = static_cast<uint16_t>(compiled.size());
+
+        if (entry.matchAll) {
+            compiled.push_back(entry);
+            unconditional.push_back(compiledIndex);
+            continue;
+        }
+
+        // 号码模式分类，判定顺序与PushManager::matchPhoneNumber保持一致
+        const char* pattern = rule.sourceNumber.c_str();
+        size_t patternLength = rule.sourceNumber.length();
+        String listName;
+        bool negated = false;
+        if (NumberSet::parseListPattern(rule.sourceNumber, listName, negated)) {
+            entry.numberKind = negated ? NUMBER_NOT_IN_LIST : NUMBER_IN_LIST;
+            if (numberLists != nullptr) {
+                auto it = numberLists->find(listName);
+                if (it != numberLists->end() && it->second) {
+                    entry.listIndex = static_cast<int16_t>(listSets.size());
+                    listSets.push_back(it->second);
+                }
+            }
+        } else if (patternLength == 0 || (patternLength == 1 && pattern[0] == '*')) {
+            entry.numberKind = NUMBER_ANY;
+        } else if (pattern[patternLength - 1] == '*') {
+            entry.numberKind = NUMBER_PREFIX;
+            entry.prefixLength = patternLength - 1;
+            entry.prefixOffset = appendToPool(pattern, entry.prefixLength);
+        } else if (pattern[0] == '*') {
+            entry.numberKind = NUMBER_SUFFIX;
+            entry.suffixLength = patternLength - 1;
+            entry.suffixOffset = appendToPool(pattern + 1, entry.suffixLength);
+        } else {
+            const char* star = static_cast<const char*>(memchr(pattern, '*', patternLength));
+            if (star != nullptr) {
+                size_t starIndex = star - pattern;
+                entry.numberKind = NUMBER_PREFIX_SUFFIX;
+                entry.prefixLength = starIndex;
+                entry.prefixOffset = appendToPool(pattern, starIndex);
+                entry.suffixLength = patternLength - starIndex - 1;
+                entry.suffixOffset = appendToPool(star + 1, entry.suffixLength);
+            } else {
+                entry.numberKind = NUMBER_EXACT;
+                entry.prefixLength = patternLength;
+                entry.prefixOffset = appendToPool(pattern, patternLength);
+            }
+        }
+
+        // 关键词预先拆分：整体去空白后按逗号分割，每个关键词再去空白，跳过空关键词
+        entry.keywordsRequired = !rule.keywords.isEmpty();
+        if (entry.keywordsRequired) {
+            const char* begin = rule.keywords.c_str();
+            const char* end = begin + rule.keywords.length();
+            trimRange(begin, end);
+
+            while (begin < end) {
+                const char* comma = static_cast<const char*>(memchr(begin, ',', end - begin));
+                const char* itemEnd = comma != nullptr ? comma : end;
+                const char* itemBegin = begin;
+                trimRange(itemBegin, itemEnd);
+                if (itemEnd > itemBegin) {
+                    insertKeyword(compiledIndex, itemBegin, itemEnd - itemBegin);
+                    entry.keywordCount++;
+                }
+                if (comma == nullptr) {
+                    break;
+                }
+                begin = comma + 1;
+            }
+        }
+
+        compiled.push_back(entry);
+
+        switch (entry.numberKind) {
+            case NUMBER_ANY:
+                unconditional.push_back(compiledIndex);
+                break;
+            case NUMBER_EXACT:
+                insertTrie(compiledIndex, pattern, patternLength, true);
+                break;
+            case NUMBER_PREFIX:
+                insertTrie(compiledIndex, pattern, entry.prefixLength, false);
+                break;
+            case NUMBER_IN_LIST:
+            case NUMBER_NOT_IN_LIST:
+                listRules.push_back(compiledIndex);
+                break;
+            default:
+                residual.push_back(compiledIndex);
+                break;
+        }
+    }
+
+    buildKeywordLinks();
+    return true;
+}
+
+/**
+ * @brief 匹配短信
+ * @param sender 发送方号码
+ * @param content 短信内容
+ * @param indices 输出的匹配规则下标
+ * @param capacity indices容量
+ * @return size_t 匹配的规则数
+ */
+size_t RuleMatcher::match(const char* sender, const char* content, uint16_t* indices, size_t capacity) const {
+    if (compiled.empty() || capacity == 0) {
+        return 0;
+    }
+    if (sender == nullptr) {
+        sender = "";
+    }
+    if (content == nullptr) {
+        content = "";
+    }
+
+    // 号码条件满足的候选规则位图（按编译顺序即原列表顺序输出，无需排序）
+    uint32_t candidates[(RULE_MATCHER_MAX_RULES + 31) / 32];
+    size_t words = (compiled.size() + 31) / 32;
+    memset(candidates, 0, words * sizeof(uint32_t));
+
+    for (uint16_t index : unconditional) {
+        candidates[index >> 5] |= 1UL << (index & 31);
+    }
+
+    size_t senderLength = strlen(sender);
+    for (uint16_t index : residual) {
+        if (matchResidualNumber(compiled[index], sender, senderLength)) {
+            candidates[index >> 5] |= 1UL << (index & 31);
+        }
+    }
+
+    // 名单规则：发送方号码只规范化并哈希一次，每个名单一次哈希表查找
+    if (!listRules.empty()) {
+        uint64_t senderKey = NumberSet::keyOf(sender);
+        for (uint16_t index : listRules) {
+            const CompiledRule& rule = compiled[index];
+            bool listed = rule.listIndex >= 0 && listSets[rule.listIndex]->contains(senderKey);
+            if (listed != (rule.numberKind == NUMBER_NOT_IN_LIST)) {
+                candidates[index >> 5] |= 1UL << (index & 31);
+            }
+        }
+    }
+
+    // 沿字典树走一遍发送方号码，沿途节点上的前缀规则与终点上的精确规则命中
+    int32_t node = 0;
+    size_t depth = 0;
+    while (node >= 0) {
+        for (int32_t link = trie[node].firstRule; link >= 0; link = trieLinks[link].next) {
+            const TrieRuleLink& item = trieLinks[link];
+            if (!item.exact || depth == senderLength) {
+                candidates[item.compiledIndex >> 5] |= 1UL << (item.compiledIndex & 31);
+            }
+        }
+        if (depth == senderLength) {
+            break;
+        }
+
+        char ch = sender[depth];
+        int32_t child = trie[node].firstChild;
+        while (child >= 0 && trie[child].ch != ch) {
+            child = trie[child].nextSibling;
+        }
+        node = child;
+        depth++;
+    }
+
+    // 只有候选规则需要关键词时才扫描内容，且整条短信只扫描一遍
+    uint32_t keywordHits[(RULE_MATCHER_MAX_RULES + 31) / 32];
+    bool scanned = false;
+
+    size_t count = 0;
+    for (size_t word = 0; word < words && count < capacity; word++) {
+        uint32_t bits = candidates[word];
+        while (bits != 0 && count < capacity) {
+            uint16_t index = static_cast<uint16_t>(word * 32 + __builtin_ctz(bits));
+            bits &= bits - 1;
+
+            const CompiledRule& rule = compiled[index];
+            if (!rule.matchAll && rule.keywordsRequired) {
+                if (!scanned) {
+                    memset(keywordHits, 0, words * sizeof(uint32_t));
+                    scanKeywords(content, keywordHits);
+                    scanned = true;
+                }
+                if ((keywordHits[index >> 5] & (1UL << (index & 31))) == 0) {
+                    continue;
+                }
+            }
+            indices[count++] = rule.ruleIndex;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief 获取已编译的规则数量
+ * @return size_t 规则数量
+ */
+size_t RuleMatcher::getRuleCount() const {
+    return compiled.size();
+}
+
+/**
+ * @brief 向字符池追加一段字符串
+ * @param data 字符串
+ * @param length 长度
+ * @return uint32_t 偏移
+ */
+uint32_t RuleMatcher::appendToPool(const char* data, size_t length) {
+    uint32_t offset = pool.size();
+    pool.insert(pool.end(), data, data + length);
+    pool.push_back('\0');
+    return offset;
+}
+
+/**
+ * @brief 将号码模式插入字典树
+ * @param compiledIndex 编译后规则下标
+ * @param key 模式字符串
+ * @param length 长度
+ * @param exact 是否为精确匹配
+ */
+void RuleMatcher::insertTrie(uint16_t compiledIndex, const char* key, size_t length, bool exact) {
+    int32_t node = 0;
+    for (size_t i = 0; i < length; i++) {
+        int32_t child = trie[node].firstChild;
+        while (child >= 0 && trie[child].ch != key[i]) {
+            child = trie[child].nextSibling;
+        }
+        if (child < 0) {
+            child = trie.size();
+            trie.push_back(TrieNode{key[i], -1, trie[node].firstChild, -1});
+            trie[node].firstChild = child;
+        }
+        node = child;
+    }
+
+    trieLinks.push_back(TrieRuleLink{compiledIndex, exact, trie[node].firstRule});
+    trie[node].firstRule = trieLinks.size() - 1;
+}
+
+/**
+ * @brief 检查非字典树规则的号码是否匹配
+ * @param rule 编译后规则
+ * @param sender 发送方号码
+ * @param senderLength 号码长度
+ * @return true 匹配
+ * @return false 不匹配
+ */
+bool RuleMatcher::matchResidualNumber(const CompiledRule& rule, const char* sender, size_t senderLength) const {
+    if (rule.numberKind == NUMBER_PREFIX_SUFFIX) {
+        if (senderLength < rule.prefixLength ||
+            memcmp(sender, &pool[rule.prefixOffset], rule.prefixLength) != 0) {
+            return false;
+        }
+    }
+
+    // 前缀与后缀允许重叠，与String::startsWith()/endsWith()组合的行为一致
+    return senderLength >= rule.suffixLength &&
+           memcmp(sender + senderLength - rule.suffixLength, &pool[rule.suffixOffset], rule.suffixLength) == 0;
+}
+
+/**
+ * @brief 将关键词插入自动机
+ * @param compiledIndex 编译后规则下标
+ * @param keyword 关键词
+ * @param length 长度
+ */
+void RuleMatcher::insertKeyword(uint16_t compiledIndex, const char* keyword, size_t length) {
+    int32_t node = 0;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byte = static_cast<uint8_t>(keyword[i]);
+        int32_t child = keywordNodes[node].firstChild;
+        while (child >= 0 && keywordNodes[child].byte != byte) {
+            child = keywordNodes[child].nextSibling;
+        }
+        if (child < 0) {
+            child = keywordNodes.size();
+            keywordNodes.push_back(KeywordNode{byte, -1, keywordNodes[node].firstChild, 0, -1, -1});
+            keywordNodes[node].firstChild = child;
+            if (node == 0) {
+                keywordRoot[byte] = child;
+            }
+        }
+        node = child;
+    }
+
+    keywordOutputs.push_back(KeywordOutput{compiledIndex, keywordNodes[node].firstOutput});
+    keywordNodes[node].firstOutput = keywordOutputs.size() - 1;
+}
+
+/**
+ * @brief 按层序计算失配指针与输出链接
+ */
+void RuleMatcher::buildKeywordLinks() {
+    std::vector<int32_t> order;
+    order.reserve(keywordNodes.size());
+
+    for (int32_t child = keywordNodes[0].firstChild; child >= 0; child = keywordNodes[child].nextSibling) {
+        keywordNodes[child].fail = 0;
+        keywordNodes[child].outputLink = -1;
+        order.push_back(child);
+    }
+
+    for (size_t head = 0; head < order.size(); head++) {
+        int32_t node = order[head];
+        for (int32_t child = keywordNodes[node].firstChild; child >= 0; child = keywordNodes[child].nextSibling) {
+            int32_t fail = nextKeywordState(keywordNodes[node].fail, keywordNodes[child].byte);
+            keywordNodes[child].fail = fail;
+            keywordNodes[child].outputLink = keywordNodes[fail].firstOutput >= 0 ? fail : keywordNodes[fail].outputLink;
+            order.push_back(child);
+        }
+    }
+}
+
+/**
+ * @brief 自动机状态转移
+ * @param node 当前节点
+ * @param byte 输入字节
+ * @return int32_t 下一个节点
+ */
+int32_t RuleMatcher::nextKeywordState(int32_t node, uint8_t byte) const {
+    while (node != 0) {
+        for (int32_t child = keywordNodes[node].firstChild; child >= 0; child = keywordNodes[child].nextSibling) {
+            if (keywordNodes[child].byte == byte) {
+                return child;
+            }
+        }
+        node = keywordNodes[node].fail;
+    }
+    return keywordRoot[byte];
+}
+
+/**
+ * @brief 扫描短信内容，标记关键词命中的规则
+ * @param content 短信内容
+ * @param hits 命中位图
+ */
+void RuleMatcher::scanKeywords(const char* content, uint32_t* hits) const {
+    if (keywordNodes.size() <= 1) {
+        return;
+    }
+
+    int32_t node = 0;
+    for (const char* p = content; *p != '\0'; p++) {
+        node = nextKeywordState(node, static_cast<uint8_t>(*p));
+
+        int32_t output = keywordNodes[node].firstOutput >= 0 ? node : keywordNodes[node].outputLink;
+        while (output >= 0) {
+            for (int32_t link = keywordNodes[output].firstOutput; link >= 0; link = keywordOutputs[link].next) {
+                uint16_t index = keywordOutputs[link].compiledIndex;
+                hits[index >> 5] |= 1UL << (index & 31);
+            }
+            output = keywordNodes[output].outputLink;
+        }
+    }
+}
@@ -0,0 +1,208 @@
+/**
+ * @file rule_matcher.h
+ * @brief 转发规则匹配器 - 在规则缓存加载时预编译，匹配时不分配堆内存
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 将ForwardRule的关键词预先拆分为独立的字符串
+ * 2. 将来源号码模式预先分类（任意/精确/前缀/后缀/前后缀）
+ * 3. 用前缀字典树索引精确与前缀号码模式，一次遍历发送方号码即可得到候选规则
+ * 4. 用所有规则关键词构建一个Aho-Corasick自动机，短信内容只扫描一遍即可得到关键词命中的规则
+ *    （按字节匹配，UTF-8编码的中文关键词与String::indexOf()结果一致）
+ * 5. 名单规则（"list:名单名"/"!list:名单名"）引用号码集合，发送方号码只规范化并哈希一次，
+ *    每条名单规则O(1)判断，与名单大小无关
+ * 6. 返回匹配规则在规则列表中的下标（按原列表顺序）
+ */
+
+#ifndef RULE_MATCHER_H
+#define RULE_MATCHER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../database_manager/database_manager.h"
+#include "number_set.h"
+#include "../../include/constants.h"
+
+/**
+ * @class RuleMatcher
+ * @brief 预编译的转发规则匹配器
+ *
+ * compile()之后对象不再修改，可被多个任务同时调用match()
+ */
+class RuleMatcher {
+public:
+    /**
+     * @brief 构造函数（空匹配器，不匹配任何规则）
+     */
+    RuleMatcher();
+
+    /**
+     * @brief 根据规则列表编译匹配器
+     * @param rules 规则列表（match()返回的下标指向此列表）
+     * @param numberLists 名单规则引用的号码集合（nullptr或缺少的名单视为空名单）
+     * @return true 编译成功
+     * @return false 规则数超过RULE_MATCHER_MAX_RULES
+     */
+    bool compile(const std::vector<ForwardRule>& rules, const NumberListMap* numberLists = nullptr);
+
+    /**
+     * @brief 匹配短信
+     * @param sender 发送方号码
+     * @param content 短信内容
+     * @param indices 输出的匹配规则下标（升序）
+     * @param capacity indices容量
+     * @return size_t 匹配的规则数（最多capacity条）
+     */
+    size_t match(const char* sender, const char* content, uint16_t* indices, size_t capacity) const;
+
+    /**
+     * @brief 获取已编译的（启用的）规则数量
+     * @return size_t 规则数量
+     */
+    size_t getRuleCount() const;
+
+private:
+    /**
+     * @enum NumberPatternKind
+     * @brief 来源号码模式类型（与原matchPhoneNumber的判定顺序一致）
+     */
+    enum NumberPatternKind {
+        NUMBER_ANY = 0,         ///< 空或"*"：任意号码
+        NUMBER_EXACT,           ///< 不含通配符：精确匹配
+        NUMBER_PREFIX,          ///< 以*结尾：前缀匹配
+        NUMBER_SUFFIX,          ///< 以*开头：后缀匹配
+        NUMBER_PREFIX_SUFFIX,   ///< 中间含*：前缀+后缀匹配
+        NUMBER_IN_LIST,         ///< "list:名单名"：号码在名单中
+        NUMBER_NOT_IN_LIST      ///< "!list:名单名"：号码不在名单中
+    };
+
+    /**
+     * @struct CompiledRule
+     * @brief 编译后的单条规则
+     */
+    struct CompiledRule {
+        uint16_t ruleIndex;         ///< 在原规则列表中的下标
+        bool matchAll;              ///< 默认转发规则：忽略号码与关键词
+        uint8_t numberKind;         ///< 号码模式类型（NumberPatternKind）
+        uint32_t prefixOffset;      ///< 前缀在字符池中的偏移
+        uint16_t prefixLength;      ///< 前缀长度
+        uint32_t suffixOffset;      ///< 后缀在字符池中的偏移
+        uint16_t suffixLength;      ///< 后缀长度
+        bool keywordsRequired;      ///< 是否配置了关键词（配置了但全为空白时从不匹配）
+        uint16_t keywordCount;      ///< 有效关键词数量
+        int16_t listIndex;          ///< 名单规则引用的号码集合在listSets中的下标，-1表示空名单
+    };
+
+    /**
+     * @struct TrieNode
+     * @brief 号码前缀字典树节点（孩子-兄弟表示）
+     */
+    struct TrieNode {
+        char ch;                    ///< 边上的字符
+        int32_t firstChild;         ///< 第一个子节点，-1表示无
+        int32_t nextSibling;        ///< 下一个兄弟节点，-1表示无
+        int32_t firstRule;          ///< 挂在该节点上的规则链表头，-1表示无
+    };
+
+    /**
+     * @struct TrieRuleLink
+     * @brief 字典树节点上的规则链表项
+     */
+    struct TrieRuleLink {
+        uint16_t compiledIndex;     ///< 编译后规则下标
+        bool exact;                 ///< true: 号码须在此节点结束；false: 前缀即可
+        int32_t next;               ///< 下一项，-1表示无
+    };
+
+    /**
+     * @struct KeywordNode
+     * @brief 关键词自动机节点（孩子-兄弟表示，根节点另有256项直接跳转表）
+     */
+    struct KeywordNode {
+        uint8_t byte;               ///< 边上的字节
+        int32_t firstChild;         ///< 第一个子节点，-1表示无
+        int32_t nextSibling;        ///< 下一个兄弟节点，-1表示无
+        int32_t fail;               ///< 失配指针
+        int32_t firstOutput;        ///< 在该节点结束的关键词所属规则链表头，-1表示无
+        int32_t outputLink;         ///< 沿失配链最近的有输出的节点，-1表示无
+    };
+
+    /**
+     * @struct KeywordOutput
+     * @brief 关键词自动机节点上的规则链表项
+     */
+    struct KeywordOutput {
+        uint16_t compiledIndex;     ///< 编译后规则下标
+        int32_t next;               ///< 下一项，-1表示无
+    };
+
+    /**
+     * @brief 向字符池追加一段字符串（以'\0'结尾）
+     * @param data 字符串
+     * @param length 长度
+     * @return uint32_t 在字符池中的偏移
+     */
+    uint32_t appendToPool(const char* data, size_t length);
+
+    /**
+     * @brief 将号码模式插入字典树
+     * @param compiledIndex 编译后规则下标
+     * @param key 模式字符串（精确号码或前缀）
+     * @param length 长度
+     * @param exact 是否为精确匹配
+     */
+    void insertTrie(uint16_t compiledIndex, const char* key, size_t length, bool exact);
+
+    /**
+     * @brief 检查非字典树规则的号码是否匹配
+     * @param rule 编译后规则
+     * @param sender 发送方号码
+     * @param senderLength 号码长度
+     * @return true 匹配
+     * @return false 不匹配
+     */
+    bool matchResidualNumber(const CompiledRule& rule, const char* sender, size_t senderLength) const;
+
+    /**
+     * @brief 将关键词插入自动机
+     * @param compiledIndex 编译后规则下标
+     * @param keyword 关键词
+     * @param length 长度
+     */
+    void insertKeyword(uint16_t compiledIndex, const char* keyword, size_t length);
+
+    /**
+     * @brief 按层序计算失配指针与输出链接
+     */
+    void buildKeywordLinks();
+
+    /**
+     * @brief 自动机状态转移
+     * @param node 当前节点
+     * @param byte 输入字节
+     * @return int32_t 下一个节点
+     */
+    int32_t nextKeywordState(int32_t node, uint8_t byte) const;
+
+    /**
+     * @brief 扫描短信内容，标记关键词命中的规则
+     * @param content 短信内容
+     * @param hits 命中位图（按编译后规则下标）
+     */
+    void scanKeywords(const char* content, uint32_t* hits) const;
+
+    std::vector<CompiledRule> compiled;     ///< 编译后的规则（仅启用的规则）
+    std::vector<char> pool;                 ///< 字符池：号码模式的前缀与后缀
+    std::vector<TrieNode> trie;             ///< 号码前缀字典树（下标0为根）
+    std::vector<TrieRuleLink> trieLinks;    ///< 字典树节点上的规则链表
+    std::vector<uint16_t> unconditional;    ///< 号码条件恒成立的规则（默认转发/任意号码）
+    std::vector<uint16_t> residual;         ///< 不在字典树中、需要逐条检查号码的规则（后缀/前后缀）
+    std::vector<uint16_t> listRules;        ///< 名单规则
+    std::vector<std::shared_ptr<const NumberSet>> listSets; ///< 名单规则引用的号码集合（持有引用）
+    std::vector<KeywordNode> keywordNodes;  ///< 关键词自动机节点（下标0为根）
+    std::vector<KeywordOutput> keywordOutputs; ///< 关键词自动机节点上的规则链表
+    int32_t keywordRoot[256];               ///< 根节点的直接跳转表（无此边时为0）
+};
+
+#endif // RULE_MATCHER_H
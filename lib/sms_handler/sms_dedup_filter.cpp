@@ -0,0 +1,150 @@
+/**
+ * @file sms_dedup_filter.cpp
+ * @brief 来信去重过滤器实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "sms_dedup_filter.h"
+#include "../database_manager/database_manager.h"
+#include "../db_worker/db_worker.h"
+
+/// FNV-1a参数
+static const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static const uint32_t FNV_PRIME = 16777619u;
+
+/**
+ * @brief 将一段字节并入FNV-1a哈希
+ * @param hash 当前哈希
+ * @param data 数据
+ * @param length 长度
+ * @return uint32_t 新的哈希
+ */
+static uint32_t fnvAppend(uint32_t hash, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 构造函数
+ */
+SmsDedupFilter::SmsDedupFilter() : nextSlot(0), loaded(false) {
+    memset(entries, 0, sizeof(entries));
+}
+
+/**
+ * @brief 计算来信指纹
+ * @param sender 发送方号码
+ * @param timestamp SCTS时间戳
+ * @param refNum 长短信参考号
+ * @param partNum 长短信分片序号
+ * @param text 解码后的正文
+ * @return uint32_t 指纹
+ */
+uint32_t SmsDedupFilter::fingerprint(const char* sender, const char* timestamp, uint16_t refNum, uint8_t partNum,
+                                     const char* text) {
+    // 字段之间插入分隔符，避免"12"+"3"与"1"+"23"得到相同的哈希
+    const uint8_t separator = 0;
+    uint8_t tail[3] = { (uint8_t)(refNum >> 8), (uint8_t)refNum, partNum };
+    uint32_t hash = FNV_OFFSET_BASIS;
+    hash = fnvAppend(hash, (const uint8_t*)sender, strlen(sender));
+    hash = fnvAppend(hash, &separator, 1);
+    hash = fnvAppend(hash, (const uint8_t*)timestamp, strlen(timestamp));
+    hash = fnvAppend(hash, &separator, 1);
+    hash = fnvAppend(hash, tail, sizeof(tail));
+    // 单条短信没有参考号，同一发送方在同一秒内的两条短信只能靠正文区分
+    hash = fnvAppend(hash, (const uint8_t*)text, strlen(text));
+    // 0用于标记空槽
+    return hash != 0 ? hash : 1;
+}
+
+/**
+ * @brief 检查指纹是否已出现过
+ * @param fingerprint 指纹
+ * @return true 重复的来信
+ * @return false 新的来信
+ */
+bool SmsDedupFilter::contains(uint32_t fingerprint) {
+    loadPersisted();
+    for (size_t i = 0; i < SMS_DEDUP_ENTRIES; i++) {
+        if (entries[i] == fingerprint) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 只在内存中记录指纹
+ * @param fingerprint 指纹
+ */
+void SmsDedupFilter::remember(uint32_t fingerprint) {
+    if (!contains(fingerprint)) {
+        push(fingerprint);
+    }
+}
+
+/**
+ * @brief 记录已入库短信的指纹，同时写入数据库
+ * @param fingerprint 指纹
+ */
+void SmsDedupFilter::commit(uint32_t fingerprint) {
+    remember(fingerprint);
+    if (DatabaseManager::getInstance().isReady()) {
+        // 指纹写入不影响本次处理结果，投递后不等待
+        DbWorker::getInstance().post([fingerprint]() {
+            DatabaseManager::getInstance().addSmsFingerprint(fingerprint);
+        });
+    }
+}
+
+/**
+ * @brief 移除只在内存中记录的指纹
+ * @param fingerprint 指纹
+ */
+void SmsDedupFilter::forget(uint32_t fingerprint) {
+    for (size_t i = 0; i < SMS_DEDUP_ENTRIES; i++) {
+        if (entries[i] == fingerprint) {
+            entries[i] = 0;
+        }
+    }
+}
+
+/**
+ * @brief 首次使用时从数据库载入最近的指纹
+ */
+void SmsDedupFilter::loadPersisted() {
+    if (loaded) {
+        return;
+    }
+    DatabaseManager& dbManager = DatabaseManager::getInstance();
+    if (!dbManager.isReady()) {
+        return;
+    }
+
+    // 连接只能由数据库工作线程使用；请求未执行时下次再载入
+    std::vector<uint32_t> persisted;
+    if (!DbWorker::getInstance().call([&persisted]() {
+            persisted = DatabaseManager::getInstance().getRecentSmsFingerprints(SMS_DEDUP_ENTRIES);
+        })) {
+        return;
+    }
+    loaded = true;
+
+    // 从旧到新写入，最新的指纹最后被覆盖
+    for (uint32_t fingerprint : persisted) {
+        push(fingerprint);
+    }
+}
+
+/**
+ * @brief 写入内存环形数组
+ * @param fingerprint 指纹
+ */
+void SmsDedupFilter::push(uint32_t fingerprint) {
+    entries[nextSlot] = fingerprint;
+    nextSlot = (nextSlot + 1) % SMS_DEDUP_ENTRIES;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file sms_dedup_filter.h
+ * @brief 来信去重过滤器 - 识别网络重传的短信，避免重复入库与推送
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以发送方、SCTS时间戳、长短信参考号/分片序号与正文计算32位指纹
+ * 2. 在内存中保留最近SMS_DEDUP_ENTRIES个指纹，检查只需扫描一个定长数组
+ * 3. 入库的短信指纹同时写入数据库，首次使用时载入最近的指纹，重启后仍能识别重传
+ */
+
+#ifndef SMS_DEDUP_FILTER_H
+#define SMS_DEDUP_FILTER_H
+
+#include <Arduino.h>
+#include "../../include/constants.h"
+
+/**
+ * @class SmsDedupFilter
+ * @brief 最近来信指纹集合（非线程安全，由短信处理任务独占使用）
+ */
+class SmsDedupFilter {
+public:
+    /**
+     * @brief 构造函数
+     */
+    SmsDedupFilter();
+
+    /**
+     * @brief 计算来信指纹
+     * @param sender 发送方号码
+     * @param timestamp SCTS时间戳（PDU中的原始格式）
+     * @param refNum 长短信参考号（单条短信为0）
+     * @param partNum 长短信分片序号（单条短信为0）
+     * @param text 解码后的正文（长短信为本分片的文本）
+     * @return uint32_t 指纹（不为0）
+     */
+    static uint32_t fingerprint(const char* sender, const char* timestamp, uint16_t refNum, uint8_t partNum,
+                                const char* text);
+
+    /**
+     * @brief 检查指纹是否已出现过
+     * @param fingerprint 指纹
+     * @return true 重复的来信
+     * @return false 新的来信
+     */
+    bool contains(uint32_t fingerprint);
+
+    /**
+     * @brief 只在内存中记录指纹（如尚未拼接完成的长短信分片）
+     * @param fingerprint 指纹
+     */
+    void remember(uint32_t fingerprint);
+
+    /**
+     * @brief 记录已入库短信的指纹，同时写入数据库
+     * @param fingerprint 指纹
+     */
+    void commit(uint32_t fingerprint);
+
+    /**
+     * @brief 移除只在内存中记录的指纹（入库失败的短信重新导入时不应被当作重传）
+     * @param fingerprint 指纹
+     */
+    void forget(uint32_t fingerprint);
+
+private:
+    /**
+     * @brief 首次使用时从数据库载入最近的指纹（数据库未就绪时下次再试）
+     */
+    void loadPersisted();
+
+    /**
+     * @brief 写入内存环形数组（不检查重复）
+     * @param fingerprint 指纹
+     */
+    void push(uint32_t fingerprint);
+
+private:
+    uint32_t entries[SMS_DEDUP_ENTRIES];    ///< 指纹环形数组（0表示空槽）
+    size_t nextSlot;                        ///< 下一个写入位置
+    bool loaded;                            ///< 是否已载入数据库中的指纹
+};
+
+#endif // SMS_DEDUP_FILTER_H
@@ -1,122 +1,399 @@
 #include "sms_handler.h"
 #include "Arduino.h"
 #include "log_manager.h"
+#include "../at_command_handler/at_command_handler.h"
+#include "../db_worker/db_worker.h"
+#include "../event_bus/event_bus.h"
+#include "../metrics/metrics.h"
 #include "../../include/constants.h"
+#include <ArduinoJson.h>
+#include <limits.h>
+#include <algorithm>
 
-// 引用外部声明的串口对象
-extern HardwareSerial simSerial;
+SmsHandler::SmsHandler(AtCommandHandler& atHandler)
+    : atHandler(atHandler), modem(atHandler.getArbiter().getIndex()) {
+}
 
-void SmsHandler::processLine(const String& line) {
-    LogManager& logger = LogManager::getInstance();
-    
-    if (line.startsWith("+CMTI:")) {
-        logger.logInfo(LOG_MODULE_SMS, "收到新短信通知，准备读取...");
-        int commaIndex = line.lastIndexOf(',');
-        if (commaIndex != -1) {
-            String indexStr = line.substring(commaIndex + 1);
-            indexStr.trim();
-            readMessage(indexStr.toInt());
-        }
-    }
-    // 处理+CMT格式的直接短信通知（当前配置使用的格式）
-    else if (line.startsWith("+CMT:")) {
-        logger.logInfo(LOG_MODULE_SMS, "📱 收到新短信通知 (+CMT格式)");
-        // +CMT格式的短信通知，PDU数据在下一行
-        // 这里不需要特殊处理，uart_dispatcher会处理PDU数据
+void SmsHandler::processLine(const char* line, size_t length) {
+    switch (classifyUrc(line, length)) {
+        case URC_CMTI:
+            // 连同之前积压在存储中的短信一起批量导入
+            LOG_INFO(LOG_MODULE_SMS, "收到新短信通知，准备读取...");
+            drainStorage();
+            break;
+        // 处理+CMT格式的直接短信通知（当前配置使用的格式）
+        case URC_CMT:
+            LOG_INFO(LOG_MODULE_SMS, "📱 收到新短信通知 (+CMT格式)");
+            // +CMT格式的短信通知，PDU数据在下一行
+            // 这里不需要特殊处理，uart_dispatcher会处理PDU数据
+            break;
+        default:
+            break;
     }
 }
 
-void SmsHandler::processMessageBlock(const String& block) {
+void SmsHandler::processMessageBlock(const char* pdu, size_t length, uint32_t receivedUs) {
     LogManager& logger = LogManager::getInstance();
     
     // 添加调试输出
-    logger.logInfo(LOG_MODULE_SMS, "📥 接收到PDU数据，长度: " + String(block.length()));
-    logger.logInfo(LOG_MODULE_SMS, "📥 PDU内容: " + block);
+    LOG_INFO(LOG_MODULE_SMS, "📥 接收到PDU数据，长度: " + String(length));
+    LOG_DEBUG(LOG_MODULE_SMS, "📥 PDU内容: " + String(pdu));
     
-    PDU pdu;
-    if (!pdu.decodePDU(block.c_str())) {
-        logger.logError(LOG_MODULE_SMS, "❌ PDU解码失败，PDU数据: " + block);
+    // 原地解码，发送方、时间戳与正文都在定长存储中，不经过堆内存
+    SmsPdu decoded;
+    if (!decodeSmsPdu(pdu, length, decoded, pduText, sizeof(pduText))) {
+        LOG_ERROR(LOG_MODULE_SMS, "❌ PDU解码失败，PDU数据: " + String(pdu));
+        // 无法解码的存储短信同样删除，避免每次导入都被重复读取
+        markStoredMessageDone();
         return;
     }
-    
-    logger.logInfo(LOG_MODULE_SMS, "✅ PDU解码成功");
 
-    int* concatInfo = pdu.getConcatInfo();
-    if (concatInfo && concatInfo[0] != 0) {
-        // 这是一个长短信分片
-        unsigned short refNum = concatInfo[0];
-        unsigned char partNum = concatInfo[1];
-        unsigned char totalParts = concatInfo[2];
+    // 本行触发入库的短信（单条或本分片集齐的长短信）从读到该行起追踪
+    SmsTrace trace;
+    trace.begin(receivedUs);
+    trace.record(SMS_TRACE_DECODED);
+    SmsTraceScope traceScope(trace);
+    
+    LOG_INFO(LOG_MODULE_SMS, "✅ PDU解码成功");
+    MetricsRegistry::getInstance().increment(METRIC_SMS_RECEIVED);
 
-        logger.logInfo(LOG_MODULE_SMS, "收到长短信分片，消息引用: " + String(refNum) + "，分片序号: " + String(partNum) + "/" + String(totalParts));
+    // 每收到一条短信顺便清理超时的长短信，空闲时由UART监控任务定期清理
+    flushExpiredConcatenations();
 
-        // 存储完整的PDU，而不仅仅是文本部分，以便后续正确拼接
-        smsCache[refNum].totalParts = totalParts;
-        smsCache[refNum].parts[partNum] = block; // 存储原始PDU
+    // 分片信息不合法时按单条短信处理，避免残缺的缓存条目永远无法集齐
+    bool isConcatenated = decoded.concatTotal > 1 &&
+                          decoded.concatPart >= 1 && decoded.concatPart <= decoded.concatTotal;
+    uint16_t refNum = isConcatenated ? decoded.concatRef : 0;
+    uint8_t partNum = isConcatenated ? decoded.concatPart : 0;
 
-        // 检查是否已收到所有分片
-        if (smsCache[refNum].parts.size() == totalParts) {
-            assembleAndProcessSms(refNum);
+    // 确认丢失时网络会重传同一条短信，在入库与推送前丢弃
+    uint32_t fingerprint = SmsDedupFilter::fingerprint(decoded.sender, decoded.timestamp, refNum, partNum,
+                                                       decoded.text);
+    if (dedupFilter.contains(fingerprint)) {
+        LOG_WARN(LOG_MODULE_SMS, "♻️ 忽略重复的短信，发送方: " + String(decoded.sender) + "，时间: " + String(decoded.timestamp));
+        // 重复的存储分片若仍在等待拼接，随该长短信入库后再删除；其余重复短信已入库，可以删除
+        if (drainIndex >= 0) {
+            for (ConcatenatedSms& sms : smsCache) {
+                for (uint32_t cached : sms.fingerprints) {
+                    if (cached == fingerprint) {
+                        if (std::find(sms.storageIndices.begin(), sms.storageIndices.end(), drainIndex) ==
+                            sms.storageIndices.end()) {
+                            sms.storageIndices.push_back(drainIndex);
+                        }
+                        return;
+                    }
+                }
+            }
+            markStoredMessageDone();
         }
+        return;
+    }
+
+    // 之后入库的短信（单条或本分片集齐的长短信）统计从读到该行起的延迟
+    lineReceivedUs = receivedUs;
+    lineTimingActive = true;
+
+    String sender = decoded.sender;
+    String timestamp = decoded.timestamp;
+
+    if (isConcatenated) {
+        // 这是一个长短信分片（参考号可能为16位）
+        uint8_t totalParts = decoded.concatTotal;
+
+        LOG_INFO(LOG_MODULE_SMS, "收到长短信分片，消息引用: " + String(refNum) + "，分片序号: " + String(partNum) + "/" + String(totalParts));
+
+        // 分片指纹先只记在内存中，整条短信入库后再持久化
+        dedupFilter.remember(fingerprint);
+        // 只缓存解码后的文本，拼接时无需再次解码
+        addConcatenatedPart(sender, timestamp, refNum, partNum, totalParts, String(decoded.text), fingerprint);
     } else {
         // 这是一个单条短信
-        String sender = pdu.getSender();
-        String content = pdu.getText();
-        String timestamp = pdu.getTimeStamp();
+        String content = decoded.text;
         
         // 输出短信接收日志
         logger.printSeparator("收到新短信");
-        logger.logInfo(LOG_MODULE_SMS, "📞 发送方: " + sender);
-        logger.logInfo(LOG_MODULE_SMS, "📝 内容: " + content);
-        logger.logInfo(LOG_MODULE_SMS, "🕐 时间: " + timestamp);
+        LOG_INFO(LOG_MODULE_SMS, "📞 发送方: " + sender);
+        LOG_INFO(LOG_MODULE_SMS, "📝 内容: " + content);
+        LOG_INFO(LOG_MODULE_SMS, "🕐 时间: " + timestamp);
         logger.printSeparator();
         
-        // 处理完整短信（存储到数据库并转发）
-        processSmsComplete(sender, content, timestamp);
+        // 处理完整短信（存储到数据库并转发）；入库失败的存储短信保留在存储中，下次导入时重试
+        // 指纹也只在入库成功后记录，否则重新导入或网络重传时会被当作重复丢弃
+        int recordId = processSmsComplete(sender, content, timestamp);
+        if (recordId > 0) {
+            dedupFilter.commit(fingerprint);
+            markStoredMessageDone();
+        }
     }
+    lineTimingActive = false;
 }
 
-void SmsHandler::assembleAndProcessSms(uint8_t refNum) {
-    // 拼接长短信
-    String fullMessage = "";
-    String sender = "";
-    String timestamp = "";
-    auto& sms = smsCache[refNum];
+void SmsHandler::addConcatenatedPart(const String& sender, const String& timestamp, uint16_t refNum,
+                                     uint8_t partNum, uint8_t totalParts, const String& text, uint32_t fingerprint) {
+    size_t index = smsCache.size();
+    for (size_t i = 0; i < smsCache.size(); i++) {
+        if (smsCache[i].refNum == refNum && smsCache[i].sender == sender) {
+            index = i;
+            break;
+        }
+    }
+
+    // 同一参考号的总分片数变化，说明参考号已被新的长短信复用
+    if (index < smsCache.size() && smsCache[index].totalParts != totalParts) {
+        LOG_WARN(LOG_MODULE_SMS, "⚠️ 长短信参考号 " + String(refNum) + " 被复用，先处理已收到的分片");
+        assembleAndProcessSms(index, false);
+        index = smsCache.size();
+    }
+
+    if (index == smsCache.size()) {
+        if (smsCache.size() >= SMS_CONCAT_MAX_ENTRIES) {
+            LOG_WARN(LOG_MODULE_SMS, "⚠️ 待拼接长短信过多，先处理最早的一条");
+            assembleAndProcessSms(0, false);
+        }
+        ConcatenatedSms entry;
+        entry.sender = sender;
+        entry.refNum = refNum;
+        entry.totalParts = totalParts;
+        entry.timestamp = timestamp;
+        entry.firstSeenMs = millis();
+        entry.bytes = 0;
+        smsCache.push_back(entry);
+        index = smsCache.size() - 1;
+    }
+
+    ConcatenatedSms& sms = smsCache[index];
+    auto existing = sms.parts.find(partNum);
+    if (existing != sms.parts.end()) {
+        // 重复投递的分片以最新的为准
+        sms.bytes -= existing->second.length();
+        smsCacheBytes -= existing->second.length();
+    }
+    sms.parts[partNum] = text;
+    sms.fingerprints.push_back(fingerprint);
+    if (drainIndex >= 0) {
+        sms.storageIndices.push_back(drainIndex);
+    }
+    sms.bytes += text.length();
+    smsCacheBytes += text.length();
+    if (partNum == 1) {
+        // 时间戳以第1段为准
+        sms.timestamp = timestamp;
+    }
 
-    // 按顺序拼接所有分片的用户数据部分
+    if (sms.parts.size() == sms.totalParts) {
+        assembleAndProcessSms(index, true);
+        return;
+    }
+
+    // 超出总字节上限时从最早的长短信开始按已收到的部分处理
+    while (smsCacheBytes > SMS_CONCAT_MAX_BYTES && !smsCache.empty()) {
+        LOG_WARN(LOG_MODULE_SMS, "⚠️ 待拼接分片超出缓存上限，先处理最早的一条长短信");
+        assembleAndProcessSms(0, false);
+    }
+}
+
+void SmsHandler::flushExpiredConcatenations() {
+    unsigned long now = millis();
+    size_t i = 0;
+    while (i < smsCache.size()) {
+        if (now - smsCache[i].firstSeenMs >= SMS_CONCAT_TIMEOUT_MS) {
+            LOG_WARN(LOG_MODULE_SMS, "⏰ 长短信分片等待超时，消息引用: " + String(smsCache[i].refNum) +
+                     "，已收到 " + String((int)smsCache[i].parts.size()) + "/" + String(smsCache[i].totalParts));
+            assembleAndProcessSms(i, false);
+        } else {
+            i++;
+        }
+    }
+}
+
+unsigned long SmsHandler::getMsUntilConcatenationExpiry() const {
+    unsigned long now = millis();
+    unsigned long remaining = ULONG_MAX;
+    for (const ConcatenatedSms& sms : smsCache) {
+        unsigned long age = now - sms.firstSeenMs;
+        unsigned long left = age >= SMS_CONCAT_TIMEOUT_MS ? 0 : SMS_CONCAT_TIMEOUT_MS - age;
+        if (left < remaining) {
+            remaining = left;
+        }
+    }
+    return remaining;
+}
+
+void SmsHandler::assembleAndProcessSms(size_t index, bool complete) {
+    // 取出缓存条目，处理期间的任何重入都不会看到它
+    ConcatenatedSms sms = smsCache[index];
+    smsCache.erase(smsCache.begin() + index);
+    smsCacheBytes -= sms.bytes;
+
+    // 按顺序拼接所有分片，缺失的分片用占位符标出
+    String fullMessage;
+    fullMessage.reserve(sms.bytes);
     for (int i = 1; i <= sms.totalParts; ++i) {
-        PDU pduPart;
-        if (pduPart.decodePDU(sms.parts[i].c_str())) {
-            fullMessage += pduPart.getText();
-            // 从第一个分片获取发送人和时间戳信息
-            if (i == 1) {
-                sender = pduPart.getSender();
-                timestamp = pduPart.getTimeStamp();
-            }
+        auto part = sms.parts.find((uint8_t)i);
+        if (part != sms.parts.end()) {
+            fullMessage += part->second;
+        } else {
+            fullMessage += SMS_CONCAT_MISSING_MARK;
         }
     }
+    const String& sender = sms.sender;
+    const String& timestamp = sms.timestamp;
 
     // 输出长短信拼接完成日志
     LogManager& logger = LogManager::getInstance();
-    logger.printSeparator("长短信拼接完成");
-    logger.logInfo(LOG_MODULE_SMS, "📞 发送方: " + sender);
-    logger.logInfo(LOG_MODULE_SMS, "📝 完整内容: " + fullMessage);
-    logger.logInfo(LOG_MODULE_SMS, "🕐 时间: " + timestamp);
+    logger.printSeparator(complete ? "长短信拼接完成" : "长短信部分分片缺失");
+    LOG_INFO(LOG_MODULE_SMS, "📞 发送方: " + sender);
+    LOG_INFO(LOG_MODULE_SMS, "📝 完整内容: " + fullMessage);
+    LOG_INFO(LOG_MODULE_SMS, "🕐 时间: " + timestamp);
     logger.printSeparator();
     
-    // 处理完整短信（存储到数据库并转发）
-    processSmsComplete(sender, fullMessage, timestamp);
+    // 处理完整短信（存储到数据库并转发）；被挤出的残缺条目与刚到达的行无关，不统计入库延迟
+    bool timing = lineTimingActive;
+    lineTimingActive = timing && complete;
+    int recordId = processSmsComplete(sender, fullMessage, timestamp);
+    lineTimingActive = timing;
+    // 入库失败时撤销分片指纹，重新导入或重传的分片可以再次拼接
+    for (uint32_t fingerprint : sms.fingerprints) {
+        if (recordId > 0) {
+            dedupFilter.commit(fingerprint);
+        } else {
+            dedupFilter.forget(fingerprint);
+        }
+    }
 
-    // 清理此消息的缓存
-    smsCache.erase(refNum);
+    // 整条入库后删除从存储导入的分片：导入过程中随本批删除，否则（由新到达的分片集齐或超时）立即删除；
+    // 入库失败时分片保留在存储中，下次导入时重新拼接
+    if (recordId > 0 && !sms.storageIndices.empty()) {
+        if (drainingStorage) {
+            drainedIndices.insert(drainedIndices.end(), sms.storageIndices.begin(), sms.storageIndices.end());
+        } else {
+            commitAndDeleteStored(sms.storageIndices);
+        }
+    }
+
+    if (!complete || drainingStorage) {
+        // 超时或被挤出的条目、从存储中读取的短信都不对应刚到达的+CMT，无需确认
+        return;
+    }
 
     // 发送确认
-    simSerial.println("AT+CNMA");
+    atHandler.sendCommand("AT+CNMA", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+}
+
+int SmsHandler::drainStorage() {
+    // PDU模式下每条的格式为 +CMGL: <index>,<stat>,[<alpha>],<length>\r\n<pdu>，stat 0/1为已接收的未读/已读短信
+    int imported = 0;
+    // 保留在存储中的分片下一轮仍会被列出，已处理过的索引不再重复处理
+    std::vector<int> seen;
+
+    while (true) {
+        AtResponse response = atHandler.sendCommandWithFullResponse("AT+CMGL=4", SMS_STORAGE_LIST_TIMEOUT_MS);
+        uint32_t listedUs = micros();
+        if (response.result != AT_RESULT_SUCCESS || response.response.indexOf("ERROR") != -1) {
+            LOG_ERROR(LOG_MODULE_SMS, "❌ 读取模块存储短信失败，响应: " + response.response);
+            return imported > 0 ? imported : -1;
+        }
+
+        int processed = 0;
+        bool more = false;
+        const char* cursor = response.response.c_str();
+        drainedIndices.clear();
+        drainingStorage = true;
+        while ((cursor = strstr(cursor, "+CMGL:")) != nullptr) {
+            int index = atoi(cursor + 6);
+            const char* comma = strchr(cursor, ',');
+            int stat = comma != nullptr ? atoi(comma + 1) : -1;
+
+            // 下一行为PDU
+            const char* lineEnd = strchr(cursor, '\n');
+            if (lineEnd == nullptr) {
+                break;
+            }
+            const char* pduStart = lineEnd + 1;
+            size_t pduLength = strcspn(pduStart, "\r\n");
+            cursor = pduStart + pduLength;
+
+            if (stat != 0 && stat != 1) {
+                // 已发送/未发送的短信不属于接收方向，保留在存储中
+                continue;
+            }
+            if (std::find(seen.begin(), seen.end(), index) != seen.end()) {
+                continue;
+            }
+            if (processed >= SMS_STORAGE_DRAIN_BATCH) {
+                more = true;
+                break;
+            }
+            seen.push_back(index);
+            processed++;
+            if (pduLength == 0 || pduLength > MODEM_LINE_MAX_LENGTH) {
+                LOG_ERROR(LOG_MODULE_SMS, "❌ 存储短信PDU长度异常，索引: " + String(index));
+                drainedIndices.push_back(index);
+            } else {
+                memcpy(storedPdu, pduStart, pduLength);
+                storedPdu[pduLength] = '\0';
+                // 单条短信入库、长短信集齐入库或无法解码时记入drainedIndices；
+                // 只缓存待拼接的分片留在存储中，掉电重启后仍可重新导入
+                drainIndex = index;
+                processMessageBlock(storedPdu, pduLength, listedUs);
+                drainIndex = -1;
+            }
+        }
+        drainingStorage = false;
+
+        if (processed == 0) {
+            break;
+        }
+        imported += processed;
+
+        std::vector<int> indices;
+        indices.swap(drainedIndices);
+        if (!indices.empty() && !commitAndDeleteStored(indices)) {
+            break;
+        }
+        if (!more) {
+            break;
+        }
+    }
+
+    if (imported > 0) {
+        LOG_INFO(LOG_MODULE_SMS, "📥 已从SIM" + String(modem + 1) + "存储导入 " + String(imported) + " 条短信");
+    }
+    return imported;
+}
+
+bool SmsHandler::commitAndDeleteStored(const std::vector<int>& indices) {
+    // 入库提交后才从存储中删除，提交失败时短信保留在存储中等待下次导入
+    bool committed = false;
+    if (!DbWorker::getInstance().call([&committed]() {
+            committed = DatabaseManager::getInstance().flushGroupCommit(true);
+        }) || !committed) {
+        LOG_ERROR(LOG_MODULE_SMS, "❌ 短信入库提交失败，保留模块存储中的短信");
+        return false;
+    }
+    return deleteStoredMessages(indices);
+}
+
+void SmsHandler::markStoredMessageDone() {
+    if (drainIndex >= 0) {
+        drainedIndices.push_back(drainIndex);
+    }
 }
 
-void SmsHandler::readMessage(int messageIndex) {
-    // 读取短信索引: messageIndex
-    simSerial.print("AT+CMGR=" + String(messageIndex) + "\r\n");
+bool SmsHandler::deleteStoredMessages(const std::vector<int>& indices) {
+    std::vector<String> commands;
+    commands.reserve(indices.size());
+    for (int index : indices) {
+        commands.push_back("AT+CMGD=" + String(index));
+    }
+
+    // 多条删除命令拼接为一行发送
+    AtResponse response = atHandler.sendCommandBatch(commands, DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    if (response.result != AT_RESULT_SUCCESS) {
+        LOG_ERROR(LOG_MODULE_SMS, "❌ 删除模块存储短信失败，响应: " + response.response);
+        return false;
+    }
+    return true;
 }
 
 /**
@@ -130,29 +407,13 @@ String SmsHandler::formatTimestamp(const String& pduTimestamp) {
         return "时间格式错误";
     }
     
-    // 提取各个时间组件
-    String year = pduTimestamp.substring(0, 2);
-    String month = pduTimestamp.substring(2, 4);
-    String day = pduTimestamp.substring(4, 6);
-    String hour = pduTimestamp.substring(6, 8);
-    String minute = pduTimestamp.substring(8, 10);
-    String second = pduTimestamp.substring(10, 12);
-    
-    // 转换年份 (假设20xx年)
-    int yearInt = year.toInt();
-    if (yearInt >= 0 && yearInt <= 99) {
-        yearInt += 2000;
-    }
-    
+    // 直接按位置取各个时间组件，年份按20xx处理
     // 格式化为可读格式: YYYY-MM-DD HH:mm:ss
-    String formattedTime = String(yearInt) + "-" + 
-                          (month.length() == 1 ? "0" + month : month) + "-" +
-                          (day.length() == 1 ? "0" + day : day) + " " +
-                          (hour.length() == 1 ? "0" + hour : hour) + ":" +
-                          (minute.length() == 1 ? "0" + minute : minute) + ":" +
-                          (second.length() == 1 ? "0" + second : second);
-    
-    return formattedTime;
+    const char* digits = pduTimestamp.c_str();
+    char formatted[20];
+    snprintf(formatted, sizeof(formatted), "20%.2s-%.2s-%.2s %.2s:%.2s:%.2s",
+             digits, digits + 2, digits + 4, digits + 6, digits + 8, digits + 10);
+    return String(formatted);
 }
 
 /**
@@ -160,20 +421,21 @@ String SmsHandler::formatTimestamp(const String& pduTimestamp) {
  * @param sender 发送方号码
  * @param content 短信内容
  * @param timestamp 接收时间戳
+ * @return int 记录ID，-1表示入库失败
  */
-void SmsHandler::processSmsComplete(const String& sender, const String& content, const String& timestamp) {
-    LogManager& logger = LogManager::getInstance();
-    logger.logInfo(LOG_MODULE_SMS, "🔄 开始处理短信...");
+int SmsHandler::processSmsComplete(const String& sender, const String& content, const String& timestamp) {
+    LOG_INFO(LOG_MODULE_SMS, "🔄 开始处理短信...");
     
     // 存储到数据库
     int recordId = storeSmsToDatabase(sender, content, timestamp);
     if (recordId > 0) {
-        logger.logInfo(LOG_MODULE_SMS, "💾 短信已存储到数据库，记录ID: " + String(recordId));
+        LOG_INFO(LOG_MODULE_SMS, "💾 短信已存储到数据库，记录ID: " + String(recordId));
         forwardSms(sender, content, timestamp, recordId);
     } else {
-        logger.logError(LOG_MODULE_SMS, "❌ 短信存储到数据库失败，仍尝试转发");
+        LOG_ERROR(LOG_MODULE_SMS, "❌ 短信存储到数据库失败，仍尝试转发");
         forwardSms(sender, content, timestamp, -1);
     }
+    return recordId;
 }
 
 /**
@@ -185,14 +447,12 @@ void SmsHandler::processSmsComplete(const String& sender, const String& content,
  */
 int SmsHandler::storeSmsToDatabase(const String& sender, const String& content, const String& timestamp) {
     DatabaseManager& dbManager = DatabaseManager::getInstance();
-    LogManager& logger = LogManager::getInstance();
-    
     // 启用数据库调试模式
     dbManager.setDebugMode(true);
     
     // 检查数据库是否就绪
     if (!dbManager.isReady()) {
-        logger.logError(LOG_MODULE_SMS, "❌ 数据库未就绪，无法存储短信");
+        LOG_ERROR(LOG_MODULE_SMS, "❌ 数据库未就绪，无法存储短信");
         return -1;
     }
     
@@ -207,15 +467,50 @@ int SmsHandler::storeSmsToDatabase(const String& sender, const String& content,
     record.status = "received"; // 设置默认值
     record.forwardedAt = ""; // 设置默认值
     
-    logger.logInfo(LOG_MODULE_SMS, "📝 准备存储短信: 发送方=" + sender + ", 内容长度=" + String(content.length()));
+    LOG_INFO(LOG_MODULE_SMS, "📝 准备存储短信: SIM" + String(modem + 1) + ", 发送方=" + sender + ", 内容长度=" + String(content.length()));
     
     // 添加到数据库
-    int recordId = dbManager.addSMSRecord(record);
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    int recordId = -1;
+    String dbError;
+    uint32_t insertStartUs = micros();
+    // 在数据库工作线程中写入，连续到达的短信在同一提交窗口内合并提交
+    bool ran = DbWorker::getInstance().call([&]() {
+        recordId = dbManager.addSMSRecord(record);
+        if (recordId <= 0) {
+            dbError = dbManager.getLastError();
+        }
+    });
+    uint32_t insertEndUs = micros();
+    metrics.observe(METRIC_DB_INSERT, insertEndUs - insertStartUs);
+    if (!ran) {
+        dbError = DbWorker::getInstance().getLastError();
+    }
     
     if (recordId <= 0) {
-        logger.logError(LOG_MODULE_SMS, "❌ 数据库存储失败: " + dbManager.getLastError());
+        metrics.increment(METRIC_DB_INSERT_FAILURES);
+        LOG_ERROR(LOG_MODULE_SMS, "❌ 数据库存储失败: " + dbError);
     } else {
-        logger.logInfo(LOG_MODULE_SMS, "✅ 短信存储成功，记录ID: " + String(recordId));
+        if (lineTimingActive) {
+            metrics.observe(METRIC_SMS_LINE_TO_DB, insertEndUs - lineReceivedUs);
+        }
+        SmsTrace::mark(SMS_TRACE_STORED);
+        
+        LOG_INFO(LOG_MODULE_SMS, "✅ 短信存储成功，记录ID: " + String(recordId));
+        
+        // 通知事件流订阅者（Web界面无需轮询短信列表）
+        EventBus& eventBus = EventBus::getInstance();
+        if (eventBus.hasSubscribers()) {
+            JsonDocument doc;
+            doc["id"] = recordId;
+            doc["from"] = record.fromNumber;
+            doc["content"] = record.content;
+            doc["received_at"] = record.receivedAt;
+            doc["status"] = record.status;
+            String data;
+            serializeJson(doc, data);
+            eventBus.publish(EVENT_TYPE_SMS, data);
+        }
     }
     
     return recordId;
@@ -223,67 +518,80 @@ int SmsHandler::storeSmsToDatabase(const String& sender, const String& content,
 
 /**
  * @brief 推送短信到配置的转发目标
+ * 
+ * 推送任务投递到PushWorker队列后立即返回，HTTP推送在后台线程执行；
+ * 仅当工作线程不可用或队列已满时才退化为同步推送
  * @param sender 发送方号码
  * @param content 短信内容
  * @param timestamp 接收时间戳
  * @param smsRecordId 短信记录ID
- * @return true 推送成功
+ * @return true 推送已投递或成功
  * @return false 推送失败
  */
 bool SmsHandler::forwardSms(const String& sender, const String& content, const String& timestamp, int smsRecordId) {
-    PushManager& pushManager = PushManager::getInstance();
-    
-    // 检查推送管理器是否已初始化，如果没有则初始化一次
-    static bool pushManagerInitialized = false;
-    if (!pushManagerInitialized) {
-        if (!pushManager.initialize()) {
-            LogManager::getInstance().logError(LOG_MODULE_SMS, "❌ 推送管理器初始化失败: " + pushManager.getLastError());
-            return false;
-        }
-        // 启用推送管理器调试模式
-        pushManager.setDebugMode(true);
-        pushManagerInitialized = true;
-        LogManager::getInstance().logInfo(LOG_MODULE_SMS, "✅ 推送管理器初始化成功");
-    }
-    
     // 构建推送上下文
     PushContext context;
     context.sender = sender;
     context.content = content;
     context.timestamp = timestamp;
     context.smsRecordId = smsRecordId;
+    SmsTrace* trace = SmsTrace::current();
+    if (trace != nullptr && smsRecordId > 0) {
+        context.trace = *trace;
+        context.trace.record(SMS_TRACE_QUEUED);
+    }
     
-    // 处理短信转发
+    // 优先投递到异步推送队列
+    PushWorker& pushWorker = PushWorker::getInstance();
+    if (pushWorker.enqueue(context)) {
+        LOG_INFO(LOG_MODULE_SMS, "📤 短信已加入推送队列，排队数量: " + String(pushWorker.getPendingCount()));
+        return true;
+    }
+    LOG_WARN(LOG_MODULE_SMS, "⚠️ 推送队列不可用(" + pushWorker.getLastError() + ")，改为同步推送");
+    
+    PushManager& pushManager = PushManager::getInstance();
+    if (!pushManager.initialize()) {
+        LOG_ERROR(LOG_MODULE_SMS, "❌ 推送管理器初始化失败: " + pushManager.getLastError());
+        return false;
+    }
     
     // 处理短信转发
+    SmsTraceScope traceScope(context.trace);
     PushResult result = pushManager.processSmsForward(context);
     
     // 处理结果
-    LogManager& logger = LogManager::getInstance();
     switch (result) {
         case PUSH_SUCCESS:
-            logger.logInfo(LOG_MODULE_SMS, "✅ 短信转发成功");
+            LOG_INFO(LOG_MODULE_SMS, "✅ 短信转发成功");
             return true;
             
         case PUSH_NO_RULE:
-            logger.logInfo(LOG_MODULE_SMS, "ℹ️ 没有匹配的转发规则，跳过转发");
+            LOG_INFO(LOG_MODULE_SMS, "ℹ️ 没有匹配的转发规则，跳过转发");
             return true; // 没有规则不算失败
             
         case PUSH_RULE_DISABLED:
-            logger.logInfo(LOG_MODULE_SMS, "ℹ️ 转发规则已禁用，跳过转发");
+            LOG_INFO(LOG_MODULE_SMS, "ℹ️ 转发规则已禁用，跳过转发");
             return true; // 规则禁用不算失败
             
+        case PUSH_DEFERRED:
+            LOG_INFO(LOG_MODULE_SMS, "⏸️ 推送端点限流或熔断，已推迟到发件箱: " + pushManager.getLastError());
+            return true; // 发件箱稍后重试
+            
+        case PUSH_PENDING:
+            LOG_INFO(LOG_MODULE_SMS, "📤 短信已发布，等待服务器确认");
+            return true; // 确认失败时发件箱稍后重试
+            
         case PUSH_CONFIG_ERROR:
-            logger.logError(LOG_MODULE_SMS, "❌ 转发配置错误: " + pushManager.getLastError());
+            LOG_ERROR(LOG_MODULE_SMS, "❌ 转发配置错误: " + pushManager.getLastError());
             return false;
             
         case PUSH_NETWORK_ERROR:
-            logger.logError(LOG_MODULE_SMS, "❌ 网络错误: " + pushManager.getLastError());
+            LOG_ERROR(LOG_MODULE_SMS, "❌ 网络错误: " + pushManager.getLastError());
             return false;
             
         case PUSH_FAILED:
         default:
-            logger.logError(LOG_MODULE_SMS, "❌ 短信转发失败: " + pushManager.getLastError());
+            LOG_ERROR(LOG_MODULE_SMS, "❌ 短信转发失败: " + pushManager.getLastError());
             return false;
     }
 }
\ No newline at end of file
@@ -2,25 +2,114 @@
 #define SMS_HANDLER_H
 
 #include <Arduino.h>
-#include <pdulib.h>
+#include "../pdu_decoder/pdu_decoder.h"
 #include <map>
+#include <vector>
+#include "../line_framer/line_framer.h"
+#include "../at_command_handler/at_command_handler.h"
 #include "../database_manager/database_manager.h"
 #include "../push_manager/push_manager.h"
+#include "../push_manager/push_worker.h"
+#include "sms_dedup_filter.h"
 
-// 用于存储分段短信的结构体
+// 用于存储分段短信的结构体（按发送方与16位参考号区分）
 struct ConcatenatedSms {
-    int totalParts; // 短信总部分数
-    std::map<int, String> parts; // 已接收的部分，key是部分编号，value是PDU内容
+    String sender;                      ///< 发送方号码
+    uint16_t refNum;                    ///< 消息参考号
+    uint8_t totalParts;                 ///< 短信总部分数
+    String timestamp;                   ///< 接收时间戳（取自最先到达的分片，收到第1段后以其为准）
+    unsigned long firstSeenMs;          ///< 收到首个分片的时间（millis）
+    size_t bytes;                       ///< 已缓存分片文本的字节数
+    std::map<uint8_t, String> parts;    ///< 已接收的部分，key是部分编号，value是解码后的文本
+    std::vector<uint32_t> fingerprints; ///< 已接收分片的来信指纹，入库后写入数据库
+    std::vector<int> storageIndices;    ///< 从模块存储导入的分片索引，整条入库后才删除
 };
 
 class SmsHandler {
 public:
-    void processLine(const String& line);
-    void processMessageBlock(const String& block);
+    /**
+     * @brief 构造函数
+     * @param atHandler 所属SIM模块的AT命令处理器（读取存储、确认新短信）
+     */
+    explicit SmsHandler(AtCommandHandler& atHandler);
+
+    /**
+     * @brief 处理一行非PDU的模块输出
+     * @param line 行内容（已去除首尾空白，以'\0'结尾）
+     * @param length 行长度
+     */
+    void processLine(const char* line, size_t length);
+
+    /**
+     * @brief 处理+CMT之后的PDU数据行
+     * @param pdu PDU十六进制字符串（以'\0'结尾）
+     * @param length PDU长度
+     * @param receivedUs 读到该行的时间（micros，用于统计入库延迟）
+     */
+    void processMessageBlock(const char* pdu, size_t length, uint32_t receivedUs);
+
+    /**
+     * @brief 将超过SMS_CONCAT_TIMEOUT_MS仍不完整的长短信按已收到的部分入库并释放缓存
+     */
+    void flushExpiredConcatenations();
+
+    /**
+     * @brief 获取距最早一条待拼接长短信超时的时间
+     * @return unsigned long 剩余时间（毫秒），没有待拼接的长短信时返回ULONG_MAX
+     */
+    unsigned long getMsUntilConcatenationExpiry() const;
+
+    /**
+     * @brief 批量导入模块存储（SIM/ME）中的短信
+     *
+     * 以AT+CMGL列出所有已接收的短信，逐条解码处理，每SMS_STORAGE_DRAIN_BATCH条
+     * 提交一次数据库，提交成功后用AT+CMGD批量删除已入库的短信，直到存储中不再有未处理的短信。
+     * 只缓存在smsCache中等待拼接的长短信分片保留在存储中，整条入库后才删除
+     * @return int 本次导入的短信条数，-1表示读取存储失败
+     */
+    int drainStorage();
 
 private:
-    void readMessage(int messageIndex);
-    void assembleAndProcessSms(uint8_t refNum);
+    /**
+     * @brief 从模块存储中删除已导入的短信
+     * @param indices 存储索引列表
+     * @return true 删除成功
+     * @return false 删除失败（短信保留在存储中，下次导入时会再次读取）
+     */
+    bool deleteStoredMessages(const std::vector<int>& indices);
+
+    /**
+     * @brief 提交数据库后删除已入库短信在模块存储中的副本
+     * @param indices 存储索引列表
+     * @return true 已提交并删除
+     * @return false 提交或删除失败（短信保留在存储中）
+     */
+    bool commitAndDeleteStored(const std::vector<int>& indices);
+
+    /**
+     * @brief 正在导入的存储短信已入库或无需保留，记为可删除
+     */
+    void markStoredMessageDone();
+
+    /**
+     * @brief 缓存一个长短信分片，集齐后拼接处理
+     * @param sender 发送方号码
+     * @param timestamp 接收时间戳
+     * @param refNum 消息参考号
+     * @param partNum 分片序号（从1开始）
+     * @param totalParts 总分片数
+     * @param text 分片解码后的文本
+     * @param fingerprint 分片的来信指纹
+     */
+    void addConcatenatedPart(const String& sender, const String& timestamp, uint16_t refNum,
+                             uint8_t partNum, uint8_t totalParts, const String& text, uint32_t fingerprint);
+
+    /**
+     * @brief 拼接并处理缓存中的长短信，然后释放其缓存
+     * @param index 在smsCache中的下标
+     * @param complete 是否已集齐所有分片（未集齐时缺失部分以SMS_CONCAT_MISSING_MARK占位）
+     */
+    void assembleAndProcessSms(size_t index, bool complete);
     
     /**
      * @brief 将PDU时间戳转换为可读的日期时间格式
@@ -34,8 +123,9 @@ private:
      * @param sender 发送方号码
      * @param content 短信内容
      * @param timestamp 接收时间戳
+     * @return int 记录ID，-1表示入库失败（转发仍会尝试）
      */
-    void processSmsComplete(const String& sender, const String& content, const String& timestamp);
+    int processSmsComplete(const String& sender, const String& content, const String& timestamp);
     
     /**
      * @brief 存储短信到数据库
@@ -47,18 +137,30 @@ private:
     int storeSmsToDatabase(const String& sender, const String& content, const String& timestamp);
     
     /**
-     * @brief 推送短信到配置的转发目标
+     * @brief 推送短信到配置的转发目标（投递到异步推送队列）
      * @param sender 发送方号码
      * @param content 短信内容
      * @param timestamp 接收时间戳
      * @param smsRecordId 短信记录ID
-     * @return true 推送成功
+     * @return true 推送已投递或成功
      * @return false 推送失败
      */
     bool forwardSms(const String& sender, const String& content, const String& timestamp, int smsRecordId);
 
-    // 使用map来缓存不同参考号的长短信
-    std::map<uint8_t, ConcatenatedSms> smsCache;
+    AtCommandHandler& atHandler;    ///< 所属SIM模块的AT命令处理器
+    uint8_t modem;                  ///< 所属SIM模块序号（0为主模块）
+
+    // 拼接中的长短信，条数不超过SMS_CONCAT_MAX_ENTRIES，按首个分片到达顺序排列
+    std::vector<ConcatenatedSms> smsCache;
+    size_t smsCacheBytes = 0;   ///< 所有缓存分片文本的总字节数
+    SmsDedupFilter dedupFilter;     ///< 识别网络重传的来信
+    char pduText[SMS_PDU_TEXT_BUFFER_SIZE];     ///< 解码PDU正文的缓冲区
+    char storedPdu[MODEM_LINE_MAX_LENGTH + 1];  ///< 导入模块存储时暂存单条PDU的缓冲区
+    bool drainingStorage = false;   ///< 是否正在导入模块存储中的短信（无需AT+CNMA确认）
+    int drainIndex = -1;            ///< 正在处理的存储短信索引（-1表示不是从存储导入）
+    std::vector<int> drainedIndices;    ///< 本批可以删除的存储索引（短信已入库或无法解码）
+    bool lineTimingActive = false;  ///< 正在处理的PDU行是否需要统计入库延迟（超时清理的长短信不统计）
+    uint32_t lineReceivedUs = 0;    ///< 正在处理的PDU行被读到的时间（micros）
 };
 
 #endif // SMS_HANDLER_H
\ No newline at end of file
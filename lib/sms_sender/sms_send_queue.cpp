@@ -0,0 +1,258 @@
+/**
+ * @file sms_send_queue.cpp
+ * @brief 短信发送队列实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "sms_send_queue.h"
+#include "../at_command_handler/at_command_handler.h"
+#include "../gsm_service/gsm_service.h"
+#include "../log_manager/log_manager.h"
+#include "../task_topology/task_topology.h"
+#include <esp_system.h>
+#include <new>
+
+/**
+ * @brief 获取单例实例
+ * @return SmsSendQueue& 单例引用
+ */
+SmsSendQueue& SmsSendQueue::getInstance() {
+    static SmsSendQueue instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+SmsSendQueue::SmsSendQueue()
+    : jobQueue(nullptr), senderHandle(nullptr), senderReady(false),
+      nextJobId(1), nextRefNumber((uint8_t)(esp_random() & 0xFF)), initialized(false) {
+    // 参考号随机起始，避免重启后与接收方尚未拼完的旧长短信冲突
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief 创建队列并启动发送任务
+ * @return true 启动成功
+ * @return false 启动失败
+ */
+bool SmsSendQueue::initialize() {
+    if (initialized) {
+        return true;
+    }
+
+    jobQueue = xQueueCreate(SMS_SEND_QUEUE_LENGTH, sizeof(SmsSendJob*));
+    if (jobQueue == nullptr) {
+        setError("短信发送队列创建失败");
+        return false;
+    }
+
+    if (!TaskTopology::getInstance().createTask(SYSTEM_TASK_SMS_SEND, senderTask, this, &senderHandle)) {
+        vQueueDelete(jobQueue);
+        jobQueue = nullptr;
+        setError("短信发送任务创建失败");
+        return false;
+    }
+
+    initialized = true;
+    return true;
+}
+
+/**
+ * @brief 检查发送任务是否已运行
+ * @return true 已运行
+ * @return false 未运行
+ */
+bool SmsSendQueue::isRunning() const {
+    return initialized;
+}
+
+/**
+ * @brief 投递一条待发送的短信
+ * @param recipient 接收方号码
+ * @param message 短信内容
+ * @param callback 发送完成回调
+ * @return uint32_t 发送任务ID，0表示投递失败
+ */
+uint32_t SmsSendQueue::enqueue(const String& recipient, const String& message, const SmsSendCallback& callback) {
+    if (!initialized) {
+        setError("短信发送队列未初始化");
+        return 0;
+    }
+    if (!sender.validatePhoneNumber(recipient) || message.length() == 0) {
+        setError("接收方号码格式无效或短信内容为空");
+        return 0;
+    }
+
+    SmsSendJob* job = new (std::nothrow) SmsSendJob();
+    if (job == nullptr) {
+        stats.dropped++;
+        setError("短信发送任务内存分配失败");
+        return 0;
+    }
+    job->id = nextJobId++;
+    job->recipient = recipient;
+    job->message = message;
+    job->callback = callback;
+    job->enqueuedAt = millis();
+
+    // 入队后任务可能随时被发送任务处理并释放，先取出ID
+    uint32_t jobId = job->id;
+    if (xQueueSend(jobQueue, &job, 0) != pdTRUE) {
+        delete job;
+        stats.dropped++;
+        setError("短信发送队列已满");
+        return 0;
+    }
+
+    stats.enqueued++;
+    return jobId;
+}
+
+/**
+ * @brief 获取统计信息
+ * @return SmsSendQueueStats 统计信息
+ */
+SmsSendQueueStats SmsSendQueue::getStats() const {
+    SmsSendQueueStats snapshot = stats;
+    snapshot.pending = jobQueue != nullptr ? uxQueueMessagesWaiting(jobQueue) : 0;
+    return snapshot;
+}
+
+/**
+ * @brief 获取最后的错误信息
+ * @return String 错误信息
+ */
+String SmsSendQueue::getLastError() const {
+    return lastError;
+}
+
+/**
+ * @brief FreeRTOS任务入口
+ * @param parameter SmsSendQueue实例指针
+ */
+void SmsSendQueue::senderTask(void* parameter) {
+    SmsSendQueue* queue = static_cast<SmsSendQueue*>(parameter);
+    SmsSendJob* job = nullptr;
+
+    while (true) {
+        if (xQueueReceive(queue->jobQueue, &job, portMAX_DELAY) != pdTRUE || job == nullptr) {
+            continue;
+        }
+
+        SmsSendReport report;
+        report.jobId = job->id;
+        report.recipient = job->recipient;
+        report.queueWaitMs = millis() - job->enqueuedAt;
+        unsigned long start = millis();
+        queue->processJob(*job, report);
+        report.durationMs = millis() - start;
+
+        if (report.result == SMS_SUCCESS) {
+            queue->stats.succeeded++;
+            LogManager::getInstance().logInfo(LOG_MODULE_SMS, "📤 短信已发送至 " + report.recipient + "，分段数: " +
+                                              String((int)report.parts.size()) + "，耗时 " + String(report.durationMs) + " ms");
+        } else {
+            queue->stats.failed++;
+            LogManager::getInstance().logError(LOG_MODULE_SMS, "❌ 短信发送失败，接收方: " + report.recipient + "，原因: " + report.error);
+        }
+
+        if (job->callback) {
+            job->callback(report);
+        }
+        delete job;
+        job = nullptr;
+    }
+}
+
+/**
+ * @brief 发送一条短信的所有分段
+ * @param job 发送任务
+ * @param report 输出：发送报告
+ */
+void SmsSendQueue::processJob(const SmsSendJob& job, SmsSendReport& report) {
+    report.result = SMS_SUCCESS;
+
+    // 分段直接引用job.message中的范围，不复制子串
+    SmsSegmentPlan plan;
+    if (!planSmsSegments(job.message.c_str(), job.message.length(), plan)) {
+        report.result = SMS_ERROR_INVALID_PARAMETER;
+        report.error = "短信内容超过" + String(SMS_SEND_MAX_PARTS) + "个分段";
+        return;
+    }
+    if (!ensureSender()) {
+        report.result = SMS_ERROR_SCA_NOT_SET;
+        report.error = sender.getLastError();
+        return;
+    }
+    // 整条短信只检查一次网络，分段之间不再查询
+    if (!sender.isNetworkReady()) {
+        report.result = SMS_ERROR_NETWORK_NOT_READY;
+        report.error = "网络未就绪";
+        return;
+    }
+
+    AtCommandHandler& atHandler = AtCommandHandler::getInstance();
+    bool multipart = plan.count > 1;
+    uint8_t refNumber = 0;
+    if (multipart) {
+        refNumber = nextRefNumber++;
+        // 分段之间保持无线链路，后续分段无需重新建立连接；不支持时逐条发送同样可用
+        atHandler.sendCommand("AT+CMMS=1", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    }
+
+    const char* text = job.message.c_str();
+    for (uint8_t i = 0; i < plan.count; i++) {
+        const SmsSegment& segment = plan.parts[i];
+        SmsSendPartResult part;
+        part.partNumber = (uint8_t)(i + 1);
+        part.messageRef = -1;
+        if (report.result != SMS_SUCCESS) {
+            // 接收方无法拼出缺少分段的长短信，后续分段不再发送
+            part.result = SMS_ERROR_CANCELLED;
+        } else {
+            part.result = multipart
+                ? sender.sendSmsPart(job.recipient, text + segment.offset, segment.length, segment.alphabet,
+                                     refNumber, plan.count, part.partNumber, part.messageRef)
+                : sender.sendSmsPart(job.recipient, text, segment.length, segment.alphabet, 0, 0, 0, part.messageRef);
+            if (part.result == SMS_SUCCESS) {
+                stats.partsSent++;
+            } else {
+                part.error = sender.getLastError();
+                report.result = part.result;
+                report.error = "第" + String(part.partNumber) + "段发送失败: " + part.error;
+            }
+        }
+        report.parts.push_back(part);
+    }
+
+    if (multipart) {
+        atHandler.sendCommand("AT+CMMS=0", "OK", DEFAULT_AT_COMMAND_TIMEOUT_MS);
+    }
+}
+
+/**
+ * @brief 首次发送前初始化短信发送器
+ * @return true 发送器可用
+ * @return false 初始化失败
+ */
+bool SmsSendQueue::ensureSender() {
+    if (senderReady) {
+        return true;
+    }
+    String sca = GsmService::getInstance().getSmsCenterNumber();
+    if (sca.length() == 0) {
+        return false;
+    }
+    senderReady = sender.initialize(sca);
+    return senderReady;
+}
+
+/**
+ * @brief 设置错误信息
+ * @param error 错误信息
+ */
+void SmsSendQueue::setError(const String& error) {
+    lastError = error;
+}
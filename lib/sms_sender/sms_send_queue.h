@@ -0,0 +1,183 @@
+/**
+ * @file sms_send_queue.h
+ * @brief 短信发送队列 - 在后台任务中发送短信，超长内容自动拆分为长短信
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 维护一个有界的发送任务队列，调用方投递后立即返回
+ * 2. 由planSmsSegments()拆分超长内容，每个分段独立选择GSM 7位或UCS2，分段不会切开字符或扩展表转义
+ * 3. 分段之间以AT+CMMS=1保持无线链路，连续提交各分段的AT+CMGS
+ * 4. 发送完成后通过回调报告每个分段的结果与网络消息参考号
+ */
+
+#ifndef SMS_SEND_QUEUE_H
+#define SMS_SEND_QUEUE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "sms_sender.h"
+#include "../../include/constants.h"
+
+/**
+ * @struct SmsSendPartResult
+ * @brief 一个分段的发送结果
+ */
+struct SmsSendPartResult {
+    uint8_t partNumber;         ///< 分段序号（从1开始）
+    SmsSendResult result;       ///< 发送结果
+    int messageRef;             ///< 网络返回的消息参考号（失败时为-1）
+    String error;               ///< 错误信息
+};
+
+/**
+ * @struct SmsSendReport
+ * @brief 一条短信的发送报告
+ */
+struct SmsSendReport {
+    uint32_t jobId;                         ///< 发送任务ID
+    String recipient;                       ///< 接收方号码
+    SmsSendResult result;                   ///< 整体结果（所有分段成功时为SMS_SUCCESS）
+    String error;                           ///< 整体失败的原因
+    std::vector<SmsSendPartResult> parts;   ///< 各分段的结果
+    unsigned long queueWaitMs;              ///< 排队等待时长
+    unsigned long durationMs;               ///< 发送耗时
+};
+
+/**
+ * @brief 发送完成回调（在发送任务中调用，须快速返回）
+ * @param report 发送报告
+ */
+typedef std::function<void(const SmsSendReport& report)> SmsSendCallback;
+
+/**
+ * @struct SmsSendQueueStats
+ * @brief 发送队列统计信息
+ */
+struct SmsSendQueueStats {
+    unsigned long enqueued;     ///< 入队总数
+    unsigned long succeeded;    ///< 全部分段发送成功的短信数
+    unsigned long failed;       ///< 发送失败的短信数
+    unsigned long dropped;      ///< 队列满被拒绝数
+    unsigned long partsSent;    ///< 发送成功的分段总数
+    size_t pending;             ///< 当前排队数量
+};
+
+/**
+ * @class SmsSendQueue
+ * @brief 后台短信发送队列
+ */
+class SmsSendQueue {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return SmsSendQueue& 单例引用
+     */
+    static SmsSendQueue& getInstance();
+
+    /**
+     * @brief 创建队列并启动发送任务
+     * @return true 启动成功
+     * @return false 启动失败
+     */
+    bool initialize();
+
+    /**
+     * @brief 检查发送任务是否已运行
+     * @return true 已运行
+     * @return false 未运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 投递一条待发送的短信（不阻塞调用方）
+     * @param recipient 接收方号码
+     * @param message 短信内容（UTF-8，超过单条容量时拆分为长短信）
+     * @param callback 发送完成回调（可为空）
+     * @return uint32_t 发送任务ID，0表示投递失败
+     */
+    uint32_t enqueue(const String& recipient, const String& message, const SmsSendCallback& callback = nullptr);
+
+    /**
+     * @brief 获取统计信息
+     * @return SmsSendQueueStats 统计信息
+     */
+    SmsSendQueueStats getStats() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     * @return String 错误信息
+     */
+    String getLastError() const;
+
+private:
+    /**
+     * @struct SmsSendJob
+     * @brief 发送队列中的任务项
+     */
+    struct SmsSendJob {
+        uint32_t id;                ///< 发送任务ID
+        String recipient;           ///< 接收方号码
+        String message;             ///< 短信内容
+        SmsSendCallback callback;   ///< 发送完成回调
+        unsigned long enqueuedAt;   ///< 入队时间（millis）
+    };
+
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    SmsSendQueue();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    SmsSendQueue(const SmsSendQueue&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    SmsSendQueue& operator=(const SmsSendQueue&) = delete;
+
+    /**
+     * @brief FreeRTOS任务入口
+     * @param parameter SmsSendQueue实例指针
+     */
+    static void senderTask(void* parameter);
+
+    /**
+     * @brief 发送一条短信的所有分段
+     * @param job 发送任务
+     * @param report 输出：发送报告
+     */
+    void processJob(const SmsSendJob& job, SmsSendReport& report);
+
+    /**
+     * @brief 首次发送前初始化短信发送器（读取短信中心号码并设置PDU模式）
+     * @return true 发送器可用
+     * @return false 初始化失败
+     */
+    bool ensureSender();
+
+    /**
+     * @brief 设置错误信息
+     * @param error 错误信息
+     */
+    void setError(const String& error);
+
+private:
+    QueueHandle_t jobQueue;         ///< 发送任务队列（存放SmsSendJob指针）
+    TaskHandle_t senderHandle;      ///< 发送任务句柄
+    SmsSender sender;               ///< PDU编码与AT+CMGS发送（仅由发送任务使用）
+    bool senderReady;               ///< 发送器是否已初始化
+    uint32_t nextJobId;             ///< 下一个发送任务ID
+    uint8_t nextRefNumber;          ///< 下一个长短信参考号
+    SmsSendQueueStats stats;        ///< 统计信息
+    String lastError;               ///< 最后的错误信息
+    bool initialized;               ///< 是否已初始化
+};
+
+#endif // SMS_SEND_QUEUE_H
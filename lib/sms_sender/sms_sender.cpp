@@ -1,6 +1,6 @@
 /**
  * @file sms_sender.cpp
- * @brief 短信发送模块实现 - 使用pdulib库进行PDU编码和短信发送
+ * @brief 短信发送模块实现 - PDU编码和短信发送
  * @author ESP-SMS-Relay Project
  * @version 1.0.0
  * @date 2024
@@ -8,22 +8,14 @@
 
 #include "sms_sender.h"
 #include "constants.h"
-#include <HardwareSerial.h>
-
-// 引用外部声明的串口对象
-extern HardwareSerial simSerial;
+#include "../at_command_handler/at_command_handler.h"
 
 /**
  * @brief 构造函数
- * @param buffer_size PDU编码缓冲区大小
  */
-SmsSender::SmsSender(int buffer_size) 
-    : pdu_encoder_(nullptr), initialized_(false) {
-    // 创建PDU编码器实例
-    pdu_encoder_ = new PDU(buffer_size);
-    if (!pdu_encoder_) {
-        last_error_ = "内存分配失败：无法创建PDU编码器";
-    }
+SmsSender::SmsSender() 
+    : initialized_(false) {
+    pdu_buffer_[0] = '\0';
 }
 
 /**
@@ -40,19 +32,13 @@ SmsSender::~SmsSender() {
  * @return false 初始化失败
  */
 bool SmsSender::initialize(const String& sca_number) {
-    if (!pdu_encoder_) {
-        last_error_ = "PDU编码器未创建";
-        return false;
-    }
-    
     if (sca_number.length() == 0) {
         last_error_ = "短信中心号码不能为空";
         return false;
     }
     
-    // 设置短信中心号码
+    // 设置短信中心号码（编码时写入PDU）
     sca_number_ = sca_number;
-    pdu_encoder_->setSCAnumber(sca_number_.c_str());
     
     // 检查网络状态
     if (!isNetworkReady()) {
@@ -83,11 +69,6 @@ SmsSendResult SmsSender::sendSms(const String& recipient, const String& message)
         return SMS_ERROR_SCA_NOT_SET;
     }
     
-    if (!pdu_encoder_) {
-        last_error_ = "PDU编码器不可用";
-        return SMS_ERROR_ENCODE_FAILED;
-    }
-    
     // 验证参数
     if (recipient.length() == 0 || message.length() == 0) {
         last_error_ = "接收方号码或短信内容不能为空";
@@ -105,50 +86,48 @@ SmsSendResult SmsSender::sendSms(const String& recipient, const String& message)
         return SMS_ERROR_NETWORK_NOT_READY;
     }
     
-    // 开始发送短信
-    
-    // 进行PDU编码
-    int tpdu_length = pdu_encoder_->encodePDU(recipient.c_str(), message.c_str());
-    
-    if (tpdu_length < 0) {
-        // 处理编码错误
-        switch (tpdu_length) {
-            case PDU::UCS2_TOO_LONG:
-                last_error_ = "UCS2消息过长";
-                break;
-            case PDU::GSM7_TOO_LONG:
-                last_error_ = "GSM7消息过长";
-                break;
-            case PDU::WORK_BUFFER_TOO_SMALL:
-                last_error_ = "工作缓冲区太小";
-                break;
-            case PDU::ADDRESS_FORMAT:
-                last_error_ = "地址格式错误";
-                break;
-            case PDU::MULTIPART_NUMBERS:
-                last_error_ = "多部分消息编号错误";
-                break;
-            case PDU::ALPHABET_8BIT_NOT_SUPPORTED:
-                last_error_ = "不支持8位字母表";
-                break;
-            default:
-                last_error_ = "PDU编码失败，未知错误";
-                break;
-        }
+    // 单条发送只接受一条短信能容纳的内容，超长内容由SmsSendQueue拆分
+    SmsSegmentPlan plan;
+    if (!planSmsSegments(message.c_str(), message.length(), plan) || plan.count != 1) {
+        last_error_ = "短信内容超过单条短信容量";
         return SMS_ERROR_ENCODE_FAILED;
     }
     
-    // 获取编码后的PDU数据
-    const char* pdu_data = pdu_encoder_->getSMS();
-    if (!pdu_data) {
-        last_error_ = "获取PDU数据失败";
-        return SMS_ERROR_ENCODE_FAILED;
+    int message_ref = -1;
+    return sendSmsPart(recipient, message.c_str(), message.length(), plan.parts[0].alphabet, 0, 0, 0, message_ref);
+}
+
+/**
+ * @brief 发送长短信的一个分段
+ * @param recipient 接收方号码
+ * @param text 分段内容
+ * @param length 分段字节数
+ * @param alphabet 分段编码
+ * @param refNumber 长短信参考号
+ * @param totalParts 总分段数
+ * @param partNumber 分段序号
+ * @param messageRef 输出：网络返回的消息参考号
+ * @return SmsSendResult 发送结果
+ */
+SmsSendResult SmsSender::sendSmsPart(const String& recipient, const char* text, size_t length, SmsAlphabet alphabet,
+                                     uint8_t refNumber, uint8_t totalParts, uint8_t partNumber, int& messageRef) {
+    messageRef = -1;
+    if (!initialized_) {
+        last_error_ = "短信发送器未初始化";
+        return SMS_ERROR_SCA_NOT_SET;
     }
     
-    // PDU编码成功
+    // 进行PDU编码（分段时写入长短信用户数据头），结果以Ctrl+Z结尾
+    int tpdu_length = encodeSmsSubmit(sca_number_.c_str(), recipient.c_str(), text, length, alphabet,
+                                      refNumber, totalParts, partNumber, pdu_buffer_, sizeof(pdu_buffer_));
+    
+    if (tpdu_length < 0) {
+        setEncodeError(tpdu_length);
+        return SMS_ERROR_ENCODE_FAILED;
+    }
     
     // 发送PDU数据
-    if (!sendPduData(pdu_data, tpdu_length)) {
+    if (!sendPduData(pdu_buffer_, tpdu_length, messageRef)) {
         return SMS_ERROR_SEND_TIMEOUT;
     }
     
@@ -156,6 +135,33 @@ SmsSendResult SmsSender::sendSms(const String& recipient, const String& message)
     return SMS_SUCCESS;
 }
 
+/**
+ * @brief 将编码错误码转换为错误描述
+ * @param code 编码错误码
+ */
+void SmsSender::setEncodeError(int code) {
+    switch (code) {
+        case PDU_ENCODE_TOO_LONG:
+            last_error_ = "消息超过分段容量";
+            break;
+        case PDU_ENCODE_BUFFER_TOO_SMALL:
+            last_error_ = "工作缓冲区太小";
+            break;
+        case PDU_ENCODE_ADDRESS_FORMAT:
+            last_error_ = "地址格式错误";
+            break;
+        case PDU_ENCODE_MULTIPART:
+            last_error_ = "多部分消息编号错误";
+            break;
+        case PDU_ENCODE_UNENCODABLE:
+            last_error_ = "消息含无法以GSM 7位编码的字符";
+            break;
+        default:
+            last_error_ = "PDU编码失败，未知错误";
+            break;
+    }
+}
+
 /**
  * @brief 发送文本模式短信（仅用于启动时测试）
  * @param recipient 接收方号码
@@ -229,31 +235,9 @@ String SmsSender::getLastError() const {
  * @return false 网络未注册
  */
 bool SmsSender::isNetworkReady() {
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
-    }
-    
-    // 发送AT+CREG?命令
-    simSerial.println("AT+CREG?");
-    
-    unsigned long start_time = millis();
-    String response = "";
-    
-    // 等待响应
-    while (millis() - start_time < 3000) {
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-        }
-        
-        // 检查是否收到完整响应
-        if (response.indexOf("OK") != -1 || response.indexOf("ERROR") != -1) {
-            break;
-        }
-        
-        vTaskDelay(1);
-    }
+    // 发送AT+CREG?命令，等待到最终结果码
+    AtResponse atResponse = AtCommandHandler::getInstance().sendCommandWithFullResponse("AT+CREG?", 3000);
+    String response = atResponse.response;
     
     // 解析CREG响应
     int cregIndex = response.indexOf("+CREG:");
@@ -301,9 +285,6 @@ bool SmsSender::isNetworkReady() {
  */
 void SmsSender::setScaNumber(const String& sca_number) {
     sca_number_ = sca_number;
-    if (pdu_encoder_) {
-        pdu_encoder_->setSCAnumber(sca_number_.c_str());
-    }
 }
 
 /**
@@ -311,50 +292,15 @@ void SmsSender::setScaNumber(const String& sca_number) {
  * @param command AT命令
  * @param expected_response 期望的响应
  * @param timeout 超时时间（毫秒）
- * @param wait_for_prompt 是否等待'>'提示符
  * @return true 命令执行成功
  * @return false 命令执行失败
  */
 bool SmsSender::sendAtCommand(const String& command, const String& expected_response, 
-                             unsigned long timeout, bool wait_for_prompt) {
-    // 清空串口缓冲区
-    while (simSerial.available()) {
-        simSerial.read();
-    }
-    
-    // 发送命令
-    if (command.length() > 0) {
-        simSerial.println(command);
-    }
-    
-    unsigned long start_time = millis();
-    String response = "";
-    
-    if (wait_for_prompt) {
-        // 等待'>'提示符
-        while (millis() - start_time < timeout) {
-            if (simSerial.available()) {
-                char c = simSerial.read();
-                if (c == '>') {
-                    return true;
-                }
-            }
-            vTaskDelay(1);
-        }
-    } else {
-        // 等待期望的响应
-        while (millis() - start_time < timeout) {
-            if (simSerial.available()) {
-                char c = simSerial.read();
-                response += c;
-            }
-            
-            if (expected_response.length() == 0 || response.indexOf(expected_response) != -1) {
-                return true;
-            }
-            
-            vTaskDelay(1);
-        }
+                             unsigned long timeout) {
+    AtResponse response = AtCommandHandler::getInstance().sendCommand(command, expected_response, timeout);
+    
+    if (response.result == AT_RESULT_SUCCESS) {
+        return true;
     }
     
     last_error_ = "AT命令执行失败: " + command;
@@ -365,45 +311,32 @@ bool SmsSender::sendAtCommand(const String& command, const String& expected_resp
  * @brief 发送PDU数据
  * @param pdu_data PDU数据字符串
  * @param tpdu_length TPDU长度
+ * @param message_ref 输出：网络返回的消息参考号
  * @return true 发送成功
  * @return false 发送失败
  */
-bool SmsSender::sendPduData(const char* pdu_data, int tpdu_length) {
+bool SmsSender::sendPduData(const char* pdu_data, int tpdu_length, int& message_ref) {
     // 构造AT+CMGS命令
     String cmgs_command = "AT+CMGS=" + String(tpdu_length);
     
-    // 发送AT+CMGS命令，等待'>'提示符
-    if (!sendAtCommand(cmgs_command, "", DEFAULT_AT_COMMAND_TIMEOUT_MS, true)) {
+    // 编码器输出的PDU数据已经包含了Ctrl+Z结束符
+    // AT+CMGS、'>'提示符与PDU在同一事务内完成，等待+CMGS:及其后的OK
+    AtResponse response = AtCommandHandler::getInstance().sendCommandWithData(
+        cmgs_command, ">", pdu_data, nullptr, nullptr, DEFAULT_AT_COMMAND_TIMEOUT_MS, DEFAULT_SMS_SEND_TIMEOUT_MS);
+    if (response.response.indexOf(">") == -1) {
         last_error_ = "发送AT+CMGS命令失败";
         return false;
     }
     
-    // pdulib的getSMS()方法返回的PDU数据已经包含了Ctrl+Z结束符
-    // 直接发送完整的PDU数据
-    simSerial.print(pdu_data);
-    
-    // 等待发送结果
-    unsigned long start_time = millis();
-    String response = "";
+    int cmgs_index = response.response.indexOf("+CMGS:");
+    if (cmgs_index != -1 && response.response.indexOf("OK") != -1) {
+        message_ref = response.response.substring(cmgs_index + 6).toInt();
+        return true;
+    }
     
-    while (millis() - start_time < DEFAULT_SMS_SEND_TIMEOUT_MS) { // SMS发送超时
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-        }
-        
-        // 检查成功响应
-        if (response.indexOf("+CMGS:") != -1 && response.indexOf("OK") != -1) {
-            return true;
-        }
-        
-        // 检查错误响应
-        if (response.indexOf("ERROR") != -1) {
-            last_error_ = "PDU发送失败: " + response;
-            return false;
-        }
-        
-        vTaskDelay(10);
+    if (response.response.indexOf("ERROR") != -1) {
+        last_error_ = "PDU发送失败: " + response.response;
+        return false;
     }
     
     last_error_ = "PDU发送超时";
@@ -444,10 +377,9 @@ bool SmsSender::validatePhoneNumber(const String& phone_number) {
  * @return false 包含中文或特殊字符
  */
 bool SmsSender::isSimpleTextMessage(const String& message) {
-    for (int i = 0; i < message.length(); i++) {
-        char c = message.charAt(i);
-        // 只允许ASCII字符：字母、数字、空格和基本标点
-        if (c < 32 || c > 126) {
+    // 只允许ASCII字符：字母、数字、空格和基本标点
+    for (const uint8_t* p = (const uint8_t*)message.c_str(); *p != '\0'; p++) {
+        if (*p < 32 || *p > 126) {
             return false;
         }
     }
@@ -465,44 +397,22 @@ bool SmsSender::sendTextData(const String& recipient, const String& message) {
     // 构造AT+CMGS命令（文本模式）
     String cmgs_command = "AT+CMGS=\"" + recipient + "\"";
     
-    // 发送AT+CMGS命令，等待'>'提示符
-    if (!sendAtCommand(cmgs_command, "", DEFAULT_AT_COMMAND_TIMEOUT_MS, true)) {
+    // 短信内容以Ctrl+Z结束，与AT+CMGS、'>'提示符在同一事务内写入，等待+CMGS:及其后的OK
+    String payload;
+    payload.reserve(message.length() + 1);
+    payload.concat(message);
+    payload.concat((char)0x1A);
+    AtResponse response = AtCommandHandler::getInstance().sendCommandWithData(
+        cmgs_command, ">", payload, nullptr, nullptr, DEFAULT_AT_COMMAND_TIMEOUT_MS, DEFAULT_SMS_SEND_TIMEOUT_MS);
+    if (response.response.indexOf(">") == -1) {
         last_error_ = "发送AT+CMGS命令失败（文本模式）";
         return false;
     }
     
-    // 发送短信内容
-    simSerial.print(message);
-    simSerial.write(0x1A); // Ctrl+Z结束符
-    
-    // 等待发送结果
-    unsigned long start_time = millis();
-    String response = "";
-    bool send_success = false;
-    
-    while (millis() - start_time < DEFAULT_SMS_SEND_TIMEOUT_MS) { // SMS发送超时
-        if (simSerial.available()) {
-            char c = simSerial.read();
-            response += c;
-            
-            // 检查成功响应
-            if (response.indexOf("+CMGS:") != -1 && response.indexOf("OK") != -1) {
-                send_success = true;
-                break;
-            }
-            
-            // 检查错误响应
-            if (response.indexOf("ERROR") != -1 || response.indexOf("+CMS ERROR") != -1) {
-                break;
-            }
-        }
-        vTaskDelay(10);
-    }
-    
-    if (send_success) {
+    if (response.response.indexOf("+CMGS:") != -1 && response.response.indexOf("OK") != -1) {
         return true;
     } else {
-        last_error_ = "文本模式发送超时或失败: " + response;
+        last_error_ = "文本模式发送超时或失败: " + response.response;
         return false;
     }
 }
@@ -511,9 +421,5 @@ bool SmsSender::sendTextData(const String& recipient, const String& message) {
  * @brief 清理资源
  */
 void SmsSender::cleanup() {
-    if (pdu_encoder_) {
-        delete pdu_encoder_;
-        pdu_encoder_ = nullptr;
-    }
     initialized_ = false;
 }
\ No newline at end of file
@@ -1,12 +1,12 @@
 /**
  * @file sms_sender.h
- * @brief 短信发送模块 - 使用pdulib库进行PDU编码和短信发送
+ * @brief 短信发送模块 - PDU编码和短信发送
  * @author ESP-SMS-Relay Project
  * @version 1.0.0
  * @date 2024
  * 
  * 该模块提供了完整的短信发送功能，包括：
- * - PDU编码（使用pdulib库）
+ * - PDU编码（查表编码器直接写入固定缓冲区，见pdu_encoder）
  * - AT命令处理
  * - 错误处理和重试机制
  * - 内存管理
@@ -16,7 +16,7 @@
 #define SMS_SENDER_H
 
 #include <Arduino.h>
-#include <pdulib.h>
+#include "../pdu_encoder/pdu_encoder.h"
 
 /**
  * @brief 短信发送结果枚举
@@ -28,22 +28,22 @@ enum SmsSendResult {
     SMS_ERROR_ENCODE_FAILED,        ///< PDU编码失败
     SMS_ERROR_AT_COMMAND_FAILED,    ///< AT命令执行失败
     SMS_ERROR_SEND_TIMEOUT,         ///< 发送超时
-    SMS_ERROR_INVALID_PARAMETER     ///< 参数无效
+    SMS_ERROR_INVALID_PARAMETER,    ///< 参数无效
+    SMS_ERROR_CANCELLED             ///< 前面的分段发送失败，本分段未发送
 };
 
 /**
  * @brief 短信发送器类
  * 
- * 该类封装了完整的短信发送功能，使用pdulib库进行PDU编码，
+ * 该类封装了完整的短信发送功能，PDU编码到对象内的固定缓冲区，
  * 提供简洁的API接口用于发送短信。
  */
 class SmsSender {
 public:
     /**
      * @brief 构造函数
-     * @param buffer_size PDU编码缓冲区大小，默认200字节
      */
-    SmsSender(int buffer_size = 200);
+    SmsSender();
     
     /**
      * @brief 析构函数
@@ -61,11 +61,26 @@ public:
     /**
      * @brief 发送短信
      * @param recipient 接收方号码（支持国际格式，如+8610086）
-     * @param message 短信内容（UTF-8编码）
+     * @param message 短信内容（UTF-8编码，须能放入一条短信）
      * @return SmsSendResult 发送结果
      */
     SmsSendResult sendSms(const String& recipient, const String& message);
     
+    /**
+     * @brief 发送长短信的一个分段（不检查网络状态，由调用方在整条短信发送前检查一次）
+     * @param recipient 接收方号码
+     * @param text 分段内容（UTF-8编码，指向整条短信中由planSmsSegments()划定的范围）
+     * @param length 分段字节数
+     * @param alphabet 分段编码
+     * @param refNumber 长短信参考号（单条短信为0）
+     * @param totalParts 总分段数（单条短信为0）
+     * @param partNumber 分段序号（从1开始，单条短信为0）
+     * @param messageRef 输出：网络返回的消息参考号（+CMGS: <mr>），失败时为-1
+     * @return SmsSendResult 发送结果
+     */
+    SmsSendResult sendSmsPart(const String& recipient, const char* text, size_t length, SmsAlphabet alphabet,
+                              uint8_t refNumber, uint8_t totalParts, uint8_t partNumber, int& messageRef);
+    
     /**
      * @brief 发送文本模式短信（仅用于启动时测试）
      * @param recipient 接收方号码
@@ -93,8 +108,16 @@ public:
      */
     void setScaNumber(const String& sca_number);
     
+    /**
+     * @brief 验证手机号码格式
+     * @param phone_number 手机号码
+     * @return true 格式正确
+     * @return false 格式错误
+     */
+    bool validatePhoneNumber(const String& phone_number);
+    
 private:
-    PDU* pdu_encoder_;              ///< PDU编码器实例
+    char pdu_buffer_[SMS_SEND_PDU_BUFFER_SIZE];  ///< 十六进制PDU编码缓冲区
     String sca_number_;             ///< 短信中心号码
     String last_error_;             ///< 最后一次错误信息
     bool initialized_;              ///< 初始化状态
@@ -104,29 +127,27 @@ private:
      * @param command AT命令
      * @param expected_response 期望的响应
      * @param timeout 超时时间（毫秒）
-     * @param wait_for_prompt 是否等待'>'提示符
      * @return true 命令执行成功
      * @return false 命令执行失败
      */
     bool sendAtCommand(const String& command, const String& expected_response, 
-                      unsigned long timeout, bool wait_for_prompt = false);
+                      unsigned long timeout);
     
     /**
      * @brief 发送PDU数据
      * @param pdu_data PDU数据字符串
      * @param tpdu_length TPDU长度
+     * @param message_ref 输出：网络返回的消息参考号，未解析到时为-1
      * @return true 发送成功
      * @return false 发送失败
      */
-    bool sendPduData(const char* pdu_data, int tpdu_length);
+    bool sendPduData(const char* pdu_data, int tpdu_length, int& message_ref);
     
     /**
-     * @brief 验证手机号码格式
-     * @param phone_number 手机号码
-     * @return true 格式正确
-     * @return false 格式错误
+     * @brief 将编码错误码转换为错误描述
+     * @param code 编码错误码（PduEncodeError）
      */
-    bool validatePhoneNumber(const String& phone_number);
+    void setEncodeError(int code);
     
     /**
      * @brief 检测消息是否为纯英文数字（适合文本模式）
@@ -0,0 +1,131 @@
+/**
+ * @file sms_trace.cpp
+ * @brief 短信链路追踪实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "sms_trace.h"
+
+/// 当前任务的活动追踪（每个FreeRTOS任务各自一份）
+static thread_local SmsTrace* activeTrace = nullptr;
+
+/**
+ * @brief 构造函数（未启动的追踪不记录任何阶段）
+ */
+SmsTrace::SmsTrace() : originUs(0), count(0), active(false), overflowed(false) {
+}
+
+/**
+ * @brief 启动追踪
+ * @param originUs 起点时间（micros）
+ */
+void SmsTrace::begin(uint32_t originUs) {
+    this->originUs = originUs;
+    count = 0;
+    active = true;
+    overflowed = false;
+}
+
+/**
+ * @brief 是否已启动
+ * @return true 已启动
+ * @return false 未启动
+ */
+bool SmsTrace::isActive() const {
+    return active;
+}
+
+/**
+ * @brief 记录一个阶段（超出SMS_TRACE_MAX_EVENTS的阶段被丢弃）
+ * @param stage 阶段
+ */
+void SmsTrace::record(SmsTraceStage stage) {
+    if (!active) {
+        return;
+    }
+    if (count >= SMS_TRACE_MAX_EVENTS) {
+        overflowed = true;
+        return;
+    }
+    events[count].offsetMs = (micros() - originUs) / 1000;
+    events[count].stage = stage;
+    count++;
+}
+
+/**
+ * @brief 序列化为紧凑文本
+ * @return String 追踪文本，未启动时为空
+ */
+String SmsTrace::serialize() const {
+    String text;
+    if (!active) {
+        return text;
+    }
+    text.reserve(count * 6 + 2);
+    char token[16];
+    for (uint8_t i = 0; i < count; i++) {
+        snprintf(token, sizeof(token), i == 0 ? "%c%lu" : " %c%lu", events[i].stage, (unsigned long)events[i].offsetMs);
+        text += token;
+    }
+    if (overflowed) {
+        text += count > 0 ? " ~" : "~";
+    }
+    return text;
+}
+
+/**
+ * @brief 获取阶段字母对应的名称
+ * @param stage 阶段字母
+ * @return const char* 阶段名称
+ */
+const char* SmsTrace::getStageName(char stage) {
+    switch (stage) {
+        case SMS_TRACE_DECODED: return "PDU解码";
+        case SMS_TRACE_STORED: return "入库";
+        case SMS_TRACE_QUEUED: return "交给推送";
+        case SMS_TRACE_WORKER: return "推送线程开始";
+        case SMS_TRACE_MATCHED: return "规则匹配";
+        case SMS_TRACE_PUSH: return "推送尝试";
+        case SMS_TRACE_TOKEN_FETCH: return "获取令牌";
+        case SMS_TRACE_TOKEN: return "令牌就绪";
+        case SMS_TRACE_HTTP: return "HTTP请求";
+        case SMS_TRACE_HTTP_ACTION: return "HTTPACTION";
+        case SMS_TRACE_HTTP_DONE: return "HTTP完成";
+        case SMS_TRACE_FINISHED: return "推送结束";
+    }
+    return "未知";
+}
+
+/**
+ * @brief 获取当前任务的活动追踪
+ * @return SmsTrace* 活动追踪，没有时返回nullptr
+ */
+SmsTrace* SmsTrace::current() {
+    return activeTrace;
+}
+
+/**
+ * @brief 在当前任务的活动追踪上记录一个阶段
+ * @param stage 阶段
+ */
+void SmsTrace::mark(SmsTraceStage stage) {
+    if (activeTrace != nullptr) {
+        activeTrace->record(stage);
+    }
+}
+
+/**
+ * @brief 构造函数
+ * @param trace 追踪（未启动时不登记）
+ */
+SmsTraceScope::SmsTraceScope(SmsTrace& trace) : previous(activeTrace) {
+    activeTrace = trace.isActive() ? &trace : nullptr;
+}
+
+/**
+ * @brief 析构函数
+ */
+SmsTraceScope::~SmsTraceScope() {
+    activeTrace = previous;
+}
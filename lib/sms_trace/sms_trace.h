@@ -0,0 +1,136 @@
+/**
+ * @file sms_trace.h
+ * @brief 短信链路追踪 - 记录一条短信从串口到推送完成的各阶段时间点
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 在SmsHandler收到PDU行时创建追踪，以读到该行的时间为起点
+ * 2. 追踪随PushContext进入推送队列；执行中的追踪登记为当前任务的活动追踪，
+ *    PushManager、推送渠道、令牌缓存与HttpClient无需额外参数即可打点
+ * 3. 推送结束后序列化为紧凑文本（如"D2 S41 Q42 W43 M43 P44 H45 A812 E830 F831"），
+ *    与短信记录一起保存，供Web界面查看
+ */
+
+#ifndef SMS_TRACE_H
+#define SMS_TRACE_H
+
+#include <Arduino.h>
+#include "../../include/constants.h"
+
+/**
+ * @enum SmsTraceStage
+ * @brief 追踪阶段（取值即序列化时的阶段字母）
+ */
+enum SmsTraceStage : char {
+    SMS_TRACE_DECODED = 'D',        ///< PDU解码完成
+    SMS_TRACE_STORED = 'S',         ///< 短信记录已入库
+    SMS_TRACE_QUEUED = 'Q',         ///< 交给推送（加入推送队列，队列不可用时同步推送）
+    SMS_TRACE_WORKER = 'W',         ///< 推送工作线程开始处理
+    SMS_TRACE_MATCHED = 'M',        ///< 转发规则匹配完成
+    SMS_TRACE_PUSH = 'P',           ///< 开始一次推送尝试
+    SMS_TRACE_TOKEN_FETCH = 'K',    ///< 缓存未命中，开始获取访问令牌
+    SMS_TRACE_TOKEN = 'T',          ///< 访问令牌就绪
+    SMS_TRACE_HTTP = 'H',           ///< 开始HTTP请求
+    SMS_TRACE_HTTP_ACTION = 'A',    ///< 模块HTTPACTION返回状态码
+    SMS_TRACE_HTTP_DONE = 'E',      ///< HTTP请求结束
+    SMS_TRACE_FINISHED = 'F'        ///< 推送处理结束
+};
+
+/**
+ * @class SmsTrace
+ * @brief 单条短信的追踪记录（定长，可按值拷贝）
+ */
+class SmsTrace {
+public:
+    /**
+     * @brief 构造函数（未启动的追踪不记录任何阶段）
+     */
+    SmsTrace();
+
+    /**
+     * @brief 启动追踪
+     * @param originUs 起点时间（micros）
+     */
+    void begin(uint32_t originUs);
+
+    /**
+     * @brief 是否已启动
+     * @return true 已启动
+     * @return false 未启动
+     */
+    bool isActive() const;
+
+    /**
+     * @brief 记录一个阶段（超出SMS_TRACE_MAX_EVENTS的阶段被丢弃）
+     * @param stage 阶段
+     */
+    void record(SmsTraceStage stage);
+
+    /**
+     * @brief 序列化为紧凑文本："阶段字母+距起点毫秒数"，以空格分隔，阶段被丢弃时以"~"结尾
+     * @return String 追踪文本，未启动时为空
+     */
+    String serialize() const;
+
+    /**
+     * @brief 获取阶段字母对应的名称
+     * @param stage 阶段字母
+     * @return const char* 阶段名称
+     */
+    static const char* getStageName(char stage);
+
+    /**
+     * @brief 获取当前任务的活动追踪
+     * @return SmsTrace* 活动追踪，没有时返回nullptr
+     */
+    static SmsTrace* current();
+
+    /**
+     * @brief 在当前任务的活动追踪上记录一个阶段（没有活动追踪时不做任何事）
+     * @param stage 阶段
+     */
+    static void mark(SmsTraceStage stage);
+
+private:
+    /**
+     * @struct Event
+     * @brief 一个阶段时间点
+     */
+    struct Event {
+        uint32_t offsetMs;          ///< 距起点的毫秒数
+        char stage;                 ///< 阶段字母
+    };
+
+    Event events[SMS_TRACE_MAX_EVENTS];     ///< 已记录的阶段
+    uint32_t originUs;                      ///< 起点时间（micros）
+    uint8_t count;                          ///< 已记录的阶段数
+    bool active;                            ///< 是否已启动
+    bool overflowed;                        ///< 是否有阶段被丢弃
+};
+
+/**
+ * @class SmsTraceScope
+ * @brief 在作用域内把追踪登记为当前任务的活动追踪，离开时恢复之前的活动追踪
+ */
+class SmsTraceScope {
+public:
+    /**
+     * @brief 构造函数
+     * @param trace 追踪（未启动时不登记）
+     */
+    explicit SmsTraceScope(SmsTrace& trace);
+
+    /**
+     * @brief 析构函数
+     */
+    ~SmsTraceScope();
+
+private:
+    SmsTraceScope(const SmsTraceScope&) = delete;
+    SmsTraceScope& operator=(const SmsTraceScope&) = delete;
+
+    SmsTrace* previous;                     ///< 之前的活动追踪
+};
+
+#endif // SMS_TRACE_H
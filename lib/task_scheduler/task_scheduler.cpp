@@ -8,7 +8,34 @@
  */
 
 #include "task_scheduler.h"
+#include "../task_topology/task_topology.h"
 #include "../../include/constants.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * @brief 格式化单个任务的信息
+ * @param task 任务
+ * @return String 任务信息
+ */
+static String formatTaskInfo(const ScheduledTask& task) {
+    String info = "任务ID: " + String(task.id) + ", 名称: " + task.name;
+    info += ", 类型: " + String(task.type == TASK_ONCE ? "一次性" : "周期性");
+    info += ", 状态: " + String(task.enabled ? "启用" : "禁用");
+    info += ", 执行位置: " + String(task.dispatch == TASK_DISPATCH_WORKER ? "工作线程" : "主循环");
+    if (task.type == TASK_PERIODIC) {
+        info += ", 间隔: " + String(task.interval) + "ms";
+    }
+    info += ", 下次执行: " + String(task.nextExecution);
+    info += ", 执行次数: " + String(task.runCount);
+    if (task.runCount > 0) {
+        info += ", 耗时(最近/平均/最长): " + String(task.lastRunMs) + "/" +
+                String(task.totalRunMs / task.runCount) + "/" + String(task.maxRunMs) + "ms";
+        info += ", 最大延迟: " + String(task.maxLateMs) + "ms";
+    }
+    info += ", 超时: " + String(task.overrunCount) + ", 跳过: " + String(task.skippedCount);
+    return info;
+}
 
 /**
  * @brief 获取单例实例
@@ -23,7 +50,7 @@ TaskScheduler& TaskScheduler::getInstance() {
  * @brief 私有构造函数（单例模式）
  */
 TaskScheduler::TaskScheduler() 
-    : initialized(false), nextTaskId(1), debugMode(false), lastTaskCheck(0) {
+    : initialized(false), workerQueue(nullptr), workerHandle(nullptr), nextTaskId(1), debugMode(false) {
 }
 
 /**
@@ -48,8 +75,20 @@ bool TaskScheduler::initialize() {
     
     // 清空任务列表
     tasks.clear();
+    dueHeap.clear();
     nextTaskId = 1;
-    lastTaskCheck = millis();
+    
+    // 启动调度工作线程；失败时耗时任务退回主循环执行
+    workerQueue = xQueueCreate(TASK_SCHEDULER_WORKER_QUEUE_LENGTH, sizeof(WorkerJob*));
+    if (workerQueue != nullptr) {
+        if (!TaskTopology::getInstance().createTask(SYSTEM_TASK_SCHEDULER_WORKER, workerTask, this, &workerHandle)) {
+            vQueueDelete(workerQueue);
+            workerQueue = nullptr;
+        }
+    }
+    if (workerQueue == nullptr) {
+        debugPrint("调度工作线程启动失败，工作线程任务将在主循环中执行");
+    }
     
     initialized = true;
     debugPrint("任务调度器初始化完成");
@@ -71,10 +110,12 @@ bool TaskScheduler::isInitialized() const {
  * @param interval 执行间隔（毫秒）
  * @param callback 回调函数
  * @param executeImmediately 是否立即执行一次
+ * @param dispatch 执行位置
  * @return int 任务ID，-1表示失败
  */
 int TaskScheduler::addPeriodicTask(const String& name, unsigned long interval, 
-                                  std::function<void()> callback, bool executeImmediately) {
+                                  std::function<void()> callback, bool executeImmediately,
+                                  TaskDispatch dispatch) {
     if (!initialized) {
         setError("任务调度器未初始化");
         return -1;
@@ -90,6 +131,7 @@ int TaskScheduler::addPeriodicTask(const String& name, unsigned long interval,
         return -1;
     }
     
+    std::lock_guard<std::mutex> lock(taskMutex);
     ScheduledTask task;
     task.id = generateTaskId();
     task.name = name;
@@ -98,6 +140,7 @@ int TaskScheduler::addPeriodicTask(const String& name, unsigned long interval,
     task.callback = callback;
     task.enabled = true;
     task.executing = false;
+    task.dispatch = workerQueue != nullptr ? dispatch : TASK_DISPATCH_LOOP;
     
     unsigned long currentTime = millis();
     if (executeImmediately) {
@@ -109,6 +152,7 @@ int TaskScheduler::addPeriodicTask(const String& name, unsigned long interval,
     }
     
     tasks.push_back(task);
+    scheduleTask(task);
     
     debugPrint("添加周期性任务: " + name + ", ID: " + String(task.id) + ", 间隔: " + String(interval) + "ms");
     return task.id;
@@ -119,9 +163,11 @@ int TaskScheduler::addPeriodicTask(const String& name, unsigned long interval,
  * @param name 任务名称
  * @param delay 延迟执行时间（毫秒）
  * @param callback 回调函数
+ * @param dispatch 执行位置
  * @return int 任务ID，-1表示失败
  */
-int TaskScheduler::addOnceTask(const String& name, unsigned long delay, std::function<void()> callback) {
+int TaskScheduler::addOnceTask(const String& name, unsigned long delay, std::function<void()> callback,
+                               TaskDispatch dispatch) {
     if (!initialized) {
         setError("任务调度器未初始化");
         return -1;
@@ -132,6 +178,7 @@ int TaskScheduler::addOnceTask(const String& name, unsigned long delay, std::fun
         return -1;
     }
     
+    std::lock_guard<std::mutex> lock(taskMutex);
     ScheduledTask task;
     task.id = generateTaskId();
     task.name = name;
@@ -140,12 +187,14 @@ int TaskScheduler::addOnceTask(const String& name, unsigned long delay, std::fun
     task.callback = callback;
     task.enabled = true;
     task.executing = false;
+    task.dispatch = workerQueue != nullptr ? dispatch : TASK_DISPATCH_LOOP;
     
     unsigned long currentTime = millis();
     task.lastExecuted = 0;
     task.nextExecution = currentTime + delay;
     
     tasks.push_back(task);
+    scheduleTask(task);
     
     debugPrint("添加一次性任务: " + name + ", ID: " + String(task.id) + ", 延迟: " + String(delay) + "ms");
     return task.id;
@@ -164,12 +213,18 @@ bool TaskScheduler::setTaskEnabled(int taskId, bool enabled) {
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(taskMutex);
     ScheduledTask* task = findTask(taskId);
     if (!task) {
         setError("未找到任务ID: " + String(taskId));
         return false;
     }
     
+    // 禁用时堆中的旧项在出堆时丢弃，重新启用时再次入堆
+    if (enabled && !task->enabled) {
+        task->enabled = true;
+        scheduleTask(*task);
+    }
     task->enabled = enabled;
     debugPrint("任务 " + task->name + " (ID: " + String(taskId) + ") " + (enabled ? "启用" : "禁用"));
     return true;
@@ -177,69 +232,144 @@ bool TaskScheduler::setTaskEnabled(int taskId, bool enabled) {
 
 /**
  * @brief 处理任务调度（需要在主循环中调用）
+ * 
+ * 依次弹出堆顶已到期的任务：主循环任务直接执行，工作线程任务投递到调度队列。
+ * 只处理本次调用开始时已到期的任务，耗时超过间隔的周期任务不会让本次调用无法返回
  */
 void TaskScheduler::handleTasks() {
     if (!initialized) {
         return;
     }
     
-    unsigned long currentTime = millis();
-    
-    // 避免频繁检查，至少间隔100ms
-    if (currentTime - lastTaskCheck < 100) {
-        return;
-    }
-    lastTaskCheck = currentTime;
+    unsigned long checkTime = millis();
     
-    // 遍历所有任务
-    for (auto it = tasks.begin(); it != tasks.end();) {
-        ScheduledTask& task = *it;
-        
-        // 跳过禁用或正在执行的任务
-        if (!task.enabled || task.executing) {
-            ++it;
-            continue;
-        }
+    while (true) {
+        int taskId = 0;
+        TaskType type = TASK_ONCE;
+        TaskDispatch dispatch = TASK_DISPATCH_LOOP;
+        String name;
+        std::function<void()> callback;
         
-        // 检查是否到了执行时间
-        if (currentTime >= task.nextExecution) {
-            debugPrint("执行任务: " + task.name + " (ID: " + String(task.id) + ")");
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            ScheduledTask* task = nullptr;
+            while (!dueHeap.empty() && (long)(checkTime - dueHeap.front().due) >= 0) {
+                HeapEntry entry = dueHeap.front();
+                std::pop_heap(dueHeap.begin(), dueHeap.end(), laterThan);
+                dueHeap.pop_back();
+                
+                // 跳过已删除、禁用或改期的旧项
+                ScheduledTask* candidate = findTask(entry.taskId);
+                if (!candidate || !candidate->enabled || candidate->nextExecution != entry.due) {
+                    continue;
+                }
+                
+                // 上一次仍在工作线程中执行，本周期跳过
+                if (candidate->executing) {
+                    candidate->skippedCount++;
+                    debugPrint("任务仍在执行，跳过本次: " + candidate->name);
+                    if (candidate->type == TASK_PERIODIC) {
+                        candidate->nextExecution = millis() + candidate->interval;
+                        scheduleTask(*candidate);
+                    }
+                    continue;
+                }
+                
+                task = candidate;
+                break;
+            }
             
-            // 标记为正在执行
-            task.executing = true;
+            if (!task) {
+                return;
+            }
             
-            // 执行回调函数
-            try {
-                task.callback();
-            } catch (...) {
-                debugPrint("任务执行异常: " + task.name);
+            // 记录相对到期时间的延迟，并先排好下一次执行
+            unsigned long currentTime = millis();
+            unsigned long lateMs = currentTime - task->nextExecution;
+            if (lateMs > task->maxLateMs) {
+                task->maxLateMs = lateMs;
+            }
+            task->executing = true;
+            task->lastExecuted = currentTime;
+            if (task->type == TASK_PERIODIC) {
+                task->nextExecution = currentTime + task->interval;
+                scheduleTask(*task);
             }
             
-            // 更新执行时间
-            task.lastExecuted = currentTime;
-            task.executing = false;
+            taskId = task->id;
+            type = task->type;
+            dispatch = task->dispatch;
+            name = task->name;
+            callback = task->callback;
+        }
+        
+        if (dispatch == TASK_DISPATCH_WORKER) {
+            WorkerJob* job = new (std::nothrow) WorkerJob();
+            if (job) {
+                job->taskId = taskId;
+                job->name = name;
+                job->callback = callback;
+                if (xQueueSend(workerQueue, &job, 0) == pdTRUE) {
+                    debugPrint("投递任务到工作线程: " + name + " (ID: " + String(taskId) + ")");
+                    continue;
+                }
+                delete job;
+            }
             
-            // 处理不同类型的任务
-            if (task.type == TASK_ONCE) {
-                // 一次性任务执行后删除
-                debugPrint("一次性任务完成，删除: " + task.name);
-                it = tasks.erase(it);
-                continue;
-            } else if (task.type == TASK_PERIODIC) {
-                // 周期性任务更新下次执行时间
-                task.nextExecution = currentTime + task.interval;
+            // 工作队列已满：周期任务等下一周期，一次性任务稍后重试
+            std::lock_guard<std::mutex> lock(taskMutex);
+            ScheduledTask* task = findTask(taskId);
+            if (task) {
+                task->executing = false;
+                task->skippedCount++;
+                if (type == TASK_ONCE) {
+                    task->nextExecution = millis() + TASK_SCHEDULER_MAX_IDLE_MS;
+                    scheduleTask(*task);
+                }
             }
+            debugPrint("工作线程队列已满，跳过任务: " + name);
+            continue;
         }
         
-        ++it;
+        debugPrint("执行任务: " + name + " (ID: " + String(taskId) + ")");
+        finishRun(taskId, runCallback(name, callback));
     }
 }
 
+/**
+ * @brief 获取距下一个任务到期的时间（loop()据此休眠）
+ * @param maxWait 最长返回值（毫秒）
+ * @return unsigned long 等待时间（毫秒），已有任务到期时为0
+ */
+unsigned long TaskScheduler::getMsUntilNextTask(unsigned long maxWait) {
+    if (!initialized) {
+        return maxWait;
+    }
+    
+    std::lock_guard<std::mutex> lock(taskMutex);
+    while (!dueHeap.empty()) {
+        const HeapEntry& top = dueHeap.front();
+        const ScheduledTask* task = findTask(top.taskId);
+        if (task && task->enabled && task->nextExecution == top.due) {
+            long remaining = (long)(top.due - millis());
+            if (remaining <= 0) {
+                return 0;
+            }
+            return (unsigned long)remaining < maxWait ? (unsigned long)remaining : maxWait;
+        }
+        // 堆顶是旧项，顺便丢弃
+        std::pop_heap(dueHeap.begin(), dueHeap.end(), laterThan);
+        dueHeap.pop_back();
+    }
+    return maxWait;
+}
+
 /**
  * @brief 获取任务数量
  * @return int 任务数量
  */
 int TaskScheduler::getTaskCount() const {
+    std::lock_guard<std::mutex> lock(taskMutex);
     return tasks.size();
 }
 
@@ -248,6 +378,7 @@ int TaskScheduler::getTaskCount() const {
  * @return int 启用的任务数量
  */
 int TaskScheduler::getEnabledTaskCount() const {
+    std::lock_guard<std::mutex> lock(taskMutex);
     int count = 0;
     for (const auto& task : tasks) {
         if (task.enabled) {
@@ -263,16 +394,10 @@ int TaskScheduler::getEnabledTaskCount() const {
  * @return String 任务信息，空字符串表示未找到
  */
 String TaskScheduler::getTaskInfo(int taskId) const {
+    std::lock_guard<std::mutex> lock(taskMutex);
     for (const auto& task : tasks) {
         if (task.id == taskId) {
-            String info = "任务ID: " + String(task.id) + ", 名称: " + task.name;
-            info += ", 类型: " + String(task.type == TASK_ONCE ? "一次性" : "周期性");
-            info += ", 状态: " + String(task.enabled ? "启用" : "禁用");
-            if (task.type == TASK_PERIODIC) {
-                info += ", 间隔: " + String(task.interval) + "ms";
-            }
-            info += ", 下次执行: " + String(task.nextExecution);
-            return info;
+            return formatTaskInfo(task);
         }
     }
     return "";
@@ -283,12 +408,20 @@ String TaskScheduler::getTaskInfo(int taskId) const {
  * @return String 所有任务信息
  */
 String TaskScheduler::getAllTasksInfo() const {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    int enabledCount = 0;
+    for (const auto& task : tasks) {
+        if (task.enabled) {
+            enabledCount++;
+        }
+    }
+    
     String info = "任务调度器状态: " + String(initialized ? "已初始化" : "未初始化");
-    info += ", 任务总数: " + String(getTaskCount());
-    info += ", 启用任务数: " + String(getEnabledTaskCount()) + "\n";
+    info += ", 任务总数: " + String((int)tasks.size());
+    info += ", 启用任务数: " + String(enabledCount) + "\n";
     
     for (const auto& task : tasks) {
-        info += getTaskInfo(task.id) + "\n";
+        info += formatTaskInfo(task) + "\n";
     }
     
     return info;
@@ -299,7 +432,9 @@ String TaskScheduler::getAllTasksInfo() const {
  */
 void TaskScheduler::clearAllTasks() {
     debugPrint("清理所有任务");
+    std::lock_guard<std::mutex> lock(taskMutex);
     tasks.clear();
+    dueHeap.clear();
     nextTaskId = 1;
 }
 
@@ -342,6 +477,99 @@ ScheduledTask* TaskScheduler::findTask(int taskId) {
     return nullptr;
 }
 
+/**
+ * @brief 将任务的下次执行时间加入最小堆（调用方须持有taskMutex）
+ * @param task 任务
+ */
+void TaskScheduler::scheduleTask(const ScheduledTask& task) {
+    HeapEntry entry;
+    entry.due = task.nextExecution;
+    entry.taskId = task.id;
+    dueHeap.push_back(entry);
+    std::push_heap(dueHeap.begin(), dueHeap.end(), laterThan);
+}
+
+/**
+ * @brief 记录一次执行结果，一次性任务执行后删除
+ * @param taskId 任务ID
+ * @param runMs 执行耗时（毫秒）
+ */
+void TaskScheduler::finishRun(int taskId, unsigned long runMs) {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+        ScheduledTask& task = *it;
+        if (task.id != taskId) {
+            continue;
+        }
+        
+        task.executing = false;
+        task.runCount++;
+        task.lastRunMs = runMs;
+        task.totalRunMs += runMs;
+        if (runMs > task.maxRunMs) {
+            task.maxRunMs = runMs;
+        }
+        
+        // 主循环任务以固定预算衡量，工作线程中的周期任务以执行间隔衡量
+        unsigned long budget = task.dispatch == TASK_DISPATCH_LOOP ? TASK_SCHEDULER_INLINE_BUDGET_MS : task.interval;
+        if (budget > 0 && runMs > budget) {
+            task.overrunCount++;
+            debugPrint("任务执行超时: " + task.name + ", 耗时: " + String(runMs) + "ms");
+        }
+        
+        if (task.type == TASK_ONCE) {
+            // 一次性任务执行后删除
+            debugPrint("一次性任务完成，删除: " + task.name);
+            tasks.erase(it);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief 安全执行回调函数
+ * @param name 任务名称
+ * @param callback 回调函数
+ * @return unsigned long 执行耗时（毫秒）
+ */
+unsigned long TaskScheduler::runCallback(const String& name, const std::function<void()>& callback) {
+    unsigned long startTime = millis();
+    try {
+        callback();
+    } catch (...) {
+        debugPrint("任务执行异常: " + name);
+    }
+    return millis() - startTime;
+}
+
+/**
+ * @brief 调度工作线程入口
+ * @param parameter TaskScheduler实例指针
+ */
+void TaskScheduler::workerTask(void* parameter) {
+    TaskScheduler* scheduler = static_cast<TaskScheduler*>(parameter);
+    WorkerJob* job = nullptr;
+    
+    while (true) {
+        if (xQueueReceive(scheduler->workerQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        scheduler->debugPrint("工作线程执行任务: " + job->name + " (ID: " + String(job->taskId) + ")");
+        scheduler->finishRun(job->taskId, scheduler->runCallback(job->name, job->callback));
+        delete job;
+    }
+}
+
+/**
+ * @brief 堆排序比较：到期时间晚的排在后面（按millis回绕安全的差值比较）
+ * @param a 堆项
+ * @param b 堆项
+ * @return true a晚于b
+ */
+bool TaskScheduler::laterThan(const HeapEntry& a, const HeapEntry& b) {
+    return (long)(a.due - b.due) > 0;
+}
+
 /**
  * @brief 设置错误信息
  * @param error 错误信息
@@ -6,13 +6,21 @@
  * 
  * 提供定时任务调度功能，支持周期性任务执行
  * 主要用于数据库清理、系统维护等定期任务
+ *
+ * 待执行任务按下次执行时间维护在最小堆中，loop()只需查看堆顶即可知道
+ * 距下一个任务到期的时间并据此休眠；耗时较长的任务可交给调度工作线程执行，
+ * 不占用Arduino主循环。每个任务记录执行次数、耗时与超时统计
  */
 
 #ifndef TASK_SCHEDULER_H
 #define TASK_SCHEDULER_H
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 #include <vector>
+#include <mutex>
 #include <functional>
 
 /**
@@ -24,6 +32,15 @@ enum TaskType {
     TASK_PERIODIC   ///< 周期性任务
 };
 
+/**
+ * @enum TaskDispatch
+ * @brief 任务执行位置
+ */
+enum TaskDispatch {
+    TASK_DISPATCH_LOOP,     ///< 在loop()中直接执行（须快速返回）
+    TASK_DISPATCH_WORKER    ///< 交给调度工作线程执行（适合数据库清理、网络请求等耗时任务）
+};
+
 /**
  * @struct ScheduledTask
  * @brief 调度任务结构体
@@ -38,12 +55,22 @@ struct ScheduledTask {
     std::function<void()> callback;        ///< 回调函数
     bool enabled;                           ///< 是否启用
     bool executing;                         ///< 是否正在执行
+    TaskDispatch dispatch;                  ///< 执行位置
+    unsigned long runCount;                 ///< 执行次数
+    unsigned long overrunCount;             ///< 超时次数（loop任务超过预算，工作线程任务超过间隔）
+    unsigned long skippedCount;             ///< 到期时上一次仍未结束或工作队列已满而跳过的次数
+    unsigned long lastRunMs;                ///< 最近一次执行耗时（毫秒）
+    unsigned long maxRunMs;                 ///< 最长执行耗时（毫秒）
+    unsigned long totalRunMs;               ///< 累计执行耗时（毫秒）
+    unsigned long maxLateMs;                ///< 实际开始执行相对到期时间的最大延迟（毫秒）
     
     /**
      * @brief 构造函数
      */
     ScheduledTask() : id(0), type(TASK_ONCE), interval(0), lastExecuted(0), 
-                     nextExecution(0), enabled(true), executing(false) {}
+                     nextExecution(0), enabled(true), executing(false), dispatch(TASK_DISPATCH_LOOP),
+                     runCount(0), overrunCount(0), skippedCount(0), lastRunMs(0), maxRunMs(0),
+                     totalRunMs(0), maxLateMs(0) {}
 };
 
 /**
@@ -81,19 +108,23 @@ public:
      * @param interval 执行间隔（毫秒）
      * @param callback 回调函数
      * @param executeImmediately 是否立即执行一次
+     * @param dispatch 执行位置
      * @return int 任务ID，-1表示失败
      */
     int addPeriodicTask(const String& name, unsigned long interval, 
-                       std::function<void()> callback, bool executeImmediately = false);
+                       std::function<void()> callback, bool executeImmediately = false,
+                       TaskDispatch dispatch = TASK_DISPATCH_LOOP);
 
     /**
      * @brief 添加一次性任务
      * @param name 任务名称
      * @param delay 延迟执行时间（毫秒）
      * @param callback 回调函数
+     * @param dispatch 执行位置
      * @return int 任务ID，-1表示失败
      */
-    int addOnceTask(const String& name, unsigned long delay, std::function<void()> callback);
+    int addOnceTask(const String& name, unsigned long delay, std::function<void()> callback,
+                    TaskDispatch dispatch = TASK_DISPATCH_LOOP);
 
     /**
      * @brief 启用/禁用任务
@@ -109,6 +140,13 @@ public:
      */
     void handleTasks();
 
+    /**
+     * @brief 获取距下一个任务到期的时间（loop()据此休眠）
+     * @param maxWait 最长返回值（毫秒）
+     * @return unsigned long 等待时间（毫秒），已有任务到期时为0
+     */
+    unsigned long getMsUntilNextTask(unsigned long maxWait);
+
     /**
      * @brief 获取任务数量
      * @return int 任务数量
@@ -152,6 +190,25 @@ public:
     void setDebugMode(bool enable);
 
 private:
+    /**
+     * @struct HeapEntry
+     * @brief 最小堆中的一项（任务禁用、删除或改期后旧项在出堆时丢弃）
+     */
+    struct HeapEntry {
+        unsigned long due;                  ///< 到期时间
+        int taskId;                         ///< 任务ID
+    };
+
+    /**
+     * @struct WorkerJob
+     * @brief 投递给调度工作线程的一次执行
+     */
+    struct WorkerJob {
+        int taskId;                         ///< 任务ID
+        String name;                        ///< 任务名称
+        std::function<void()> callback;     ///< 回调函数副本（任务表变化不影响执行）
+    };
+
     /**
      * @brief 私有构造函数（单例模式）
      */
@@ -185,6 +242,41 @@ private:
      */
     ScheduledTask* findTask(int taskId);
 
+    /**
+     * @brief 将任务的下次执行时间加入最小堆（调用方须持有taskMutex）
+     * @param task 任务
+     */
+    void scheduleTask(const ScheduledTask& task);
+
+    /**
+     * @brief 记录一次执行结果，一次性任务执行后删除
+     * @param taskId 任务ID
+     * @param runMs 执行耗时（毫秒）
+     */
+    void finishRun(int taskId, unsigned long runMs);
+
+    /**
+     * @brief 安全执行回调函数
+     * @param name 任务名称
+     * @param callback 回调函数
+     * @return unsigned long 执行耗时（毫秒）
+     */
+    unsigned long runCallback(const String& name, const std::function<void()>& callback);
+
+    /**
+     * @brief 调度工作线程入口
+     * @param parameter TaskScheduler实例指针
+     */
+    static void workerTask(void* parameter);
+
+    /**
+     * @brief 堆排序比较：到期时间晚的排在后面（按millis回绕安全的差值比较）
+     * @param a 堆项
+     * @param b 堆项
+     * @return true a晚于b
+     */
+    static bool laterThan(const HeapEntry& a, const HeapEntry& b);
+
     /**
      * @brief 设置错误信息
      * @param error 错误信息
@@ -200,10 +292,13 @@ private:
 private:
     bool initialized;                       ///< 是否已初始化
     std::vector<ScheduledTask> tasks;       ///< 任务列表
+    std::vector<HeapEntry> dueHeap;         ///< 按到期时间排列的最小堆
+    mutable std::mutex taskMutex;           ///< 保护任务列表与最小堆（执行回调时不持有）
+    QueueHandle_t workerQueue;              ///< 调度工作线程队列（存放WorkerJob指针）
+    TaskHandle_t workerHandle;              ///< 调度工作线程句柄
     int nextTaskId;                         ///< 下一个任务ID
     String lastError;                       ///< 最后的错误信息
     bool debugMode;                         ///< 调试模式
-    unsigned long lastTaskCheck;           ///< 上次任务检查时间
 };
 
 #endif // TASK_SCHEDULER_H
\ No newline at end of file
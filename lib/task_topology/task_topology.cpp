@@ -0,0 +1,193 @@
+/**
+ * @file task_topology.cpp
+ * @brief 系统任务拓扑实现
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include "task_topology.h"
+#include "../../include/config.h"
+#include "../../include/constants.h"
+#include "../log_manager/log_manager.h"
+
+/**
+ * @brief 系统任务拓扑表（按SystemTaskId顺序）
+ */
+static const SystemTaskSpec TASK_SPECS[SYSTEM_TASK_COUNT] = {
+    { "ModemArbiterTask", MODEM_ARBITER_STACK_SIZE, MODEM_ARBITER_PRIORITY, MODEM_ARBITER_CORE },
+    { "UartMonitorTask", UART_MONITOR_STACK_SIZE, UART_MONITOR_PRIORITY, UART_MONITOR_CORE },
+    { "SmsSendTask", SMS_SEND_STACK_SIZE, SMS_SEND_PRIORITY, SMS_SEND_CORE },
+    { "PushWorkerTask", PUSH_WORKER_STACK_SIZE, PUSH_WORKER_PRIORITY, PUSH_WORKER_CORE },
+    { "SchedulerTask", TASK_SCHEDULER_WORKER_STACK_SIZE, TASK_SCHEDULER_WORKER_PRIORITY, TASK_SCHEDULER_WORKER_CORE },
+    { "LogSinkTask", LOG_SINK_STACK_SIZE, LOG_SINK_PRIORITY, LOG_SINK_CORE },
+    { "ModemSimTask", MODEM_SIM_STACK_SIZE, MODEM_SIM_PRIORITY, MODEM_SIM_CORE },
+    { "DbWorkerTask", DB_WORKER_STACK_SIZE, DB_WORKER_PRIORITY, DB_WORKER_CORE },
+    { "ModemArbiter2", MODEM_ARBITER_STACK_SIZE, MODEM_ARBITER_PRIORITY, MODEM_ARBITER_CORE },
+    { "UartMonitor2", UART_MONITOR_STACK_SIZE, UART_MONITOR_PRIORITY, UART_MONITOR_CORE },
+    { "ModemArbiter3", MODEM_ARBITER_STACK_SIZE, MODEM_ARBITER_PRIORITY, MODEM_ARBITER_CORE },
+    { "UartMonitor3", UART_MONITOR_STACK_SIZE, UART_MONITOR_PRIORITY, UART_MONITOR_CORE },
+};
+
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+#define ARDUINO_LOOP_STACK_SIZE CONFIG_ARDUINO_LOOP_STACK_SIZE
+#else
+#define ARDUINO_LOOP_STACK_SIZE 0
+#endif
+
+/**
+ * @brief 获取单例实例
+ * @return TaskTopology& 单例引用
+ */
+TaskTopology& TaskTopology::getInstance() {
+    static TaskTopology instance;
+    return instance;
+}
+
+/**
+ * @brief 构造函数
+ */
+TaskTopology::TaskTopology() {
+    for (int i = 0; i < SYSTEM_TASK_COUNT; i++) {
+        handles[i] = nullptr;
+    }
+    for (int i = 0; i < SYSTEM_TASK_COUNT + 2; i++) {
+        warnedFreeBytes[i] = UINT32_MAX;
+    }
+}
+
+/**
+ * @brief 获取任务的创建参数
+ * @param id 任务ID
+ * @return const SystemTaskSpec& 创建参数
+ */
+const SystemTaskSpec& TaskTopology::getSpec(SystemTaskId id) {
+    return TASK_SPECS[id];
+}
+
+/**
+ * @brief 按拓扑表创建并登记任务
+ * @param id 任务ID
+ * @param function 任务入口
+ * @param parameter 任务参数
+ * @param handle 输出：任务句柄（可为nullptr）
+ * @return true 创建成功
+ * @return false 创建失败
+ */
+bool TaskTopology::createTask(SystemTaskId id, TaskFunction_t function, void* parameter, TaskHandle_t* handle) {
+    const SystemTaskSpec& spec = TASK_SPECS[id];
+    TaskHandle_t created = nullptr;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        function,
+        spec.name,
+        spec.stackSize,
+        parameter,
+        spec.priority,
+        &created,
+        spec.core
+    );
+    if (result != pdPASS) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        handles[id] = created;
+    }
+    if (handle != nullptr) {
+        *handle = created;
+    }
+    return true;
+}
+
+/**
+ * @brief 获取所有任务（含Arduino loop与AsyncTCP）的栈使用情况
+ * @return std::vector<TaskStackInfo> 栈使用情况
+ */
+std::vector<TaskStackInfo> TaskTopology::getStackInfo() const {
+    std::vector<TaskStackInfo> result;
+    result.reserve(SYSTEM_TASK_COUNT + 2);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < SYSTEM_TASK_COUNT; i++) {
+            result.push_back(readTask(TASK_SPECS[i].name, handles[i], TASK_SPECS[i].stackSize));
+        }
+    }
+
+    // 由框架与库创建的任务按名称查找
+    result.push_back(readTask("loopTask", xTaskGetHandle("loopTask"), ARDUINO_LOOP_STACK_SIZE));
+    result.push_back(readTask("async_tcp", xTaskGetHandle("async_tcp"), 0));
+    return result;
+}
+
+/**
+ * @brief 检查任务栈高水位，余量低于TASK_STACK_WARN_FREE_BYTES时输出告警
+ * @return int 余量不足的任务数
+ */
+int TaskTopology::checkStackWatermarks() {
+    std::vector<TaskStackInfo> tasks = getStackInfo();
+    int lowCount = 0;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        const TaskStackInfo& task = tasks[i];
+        if (!task.running || task.freeBytes >= TASK_STACK_WARN_FREE_BYTES) {
+            continue;
+        }
+        lowCount++;
+
+        // 高水位只降不升，只在余量进一步下降时再次告警
+        if (task.freeBytes < warnedFreeBytes[i]) {
+            warnedFreeBytes[i] = task.freeBytes;
+            LOG_WARN(LOG_MODULE_SYSTEM, "任务栈余量不足: " + task.name + "，剩余 " + String(task.freeBytes) +
+                     " 字节" + (task.stackSize > 0 ? " / " + String(task.stackSize) + " 字节" : String("")));
+        }
+    }
+    return lowCount;
+}
+
+/**
+ * @brief 获取任务拓扑与栈使用情况描述
+ * @return String 描述
+ */
+String TaskTopology::getReport() const {
+    String report = "任务名称            核心  优先级  栈大小  最小剩余\n";
+    for (const TaskStackInfo& task : getStackInfo()) {
+        String line = task.name;
+        while (line.length() < 20) {
+            line += " ";
+        }
+        if (!task.running) {
+            report += line + "未运行\n";
+            continue;
+        }
+        line += (task.core < 0 ? String("任意") : String(task.core)) + "     ";
+        line += String(task.priority) + "       ";
+        line += (task.stackSize > 0 ? String(task.stackSize) : String("-")) + "    ";
+        line += String(task.freeBytes);
+        report += line + "\n";
+    }
+    return report;
+}
+
+/**
+ * @brief 读取任务的栈使用情况
+ * @param name 任务名称
+ * @param handle 任务句柄（nullptr表示任务不存在）
+ * @param stackSize 栈大小（未知时为0）
+ * @return TaskStackInfo 栈使用情况
+ */
+TaskStackInfo TaskTopology::readTask(const char* name, TaskHandle_t handle, uint32_t stackSize) {
+    TaskStackInfo info;
+    info.name = name;
+    info.running = handle != nullptr;
+    info.stackSize = stackSize;
+    info.freeBytes = 0;
+    info.priority = 0;
+    info.core = -1;
+    if (handle != nullptr) {
+        // ESP-IDF中栈以字节为单位
+        info.freeBytes = uxTaskGetStackHighWaterMark(handle);
+        info.priority = uxTaskPriorityGet(handle);
+        BaseType_t affinity = xTaskGetAffinity(handle);
+        info.core = affinity == tskNO_AFFINITY ? -1 : (int)affinity;
+    }
+    return info;
+}
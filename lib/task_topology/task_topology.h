@@ -0,0 +1,145 @@
+/**
+ * @file task_topology.h
+ * @brief 系统任务拓扑 - 集中定义各FreeRTOS任务的核心、优先级与栈大小
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该模块负责:
+ * 1. 以一张表登记所有系统任务（核心与优先级在config.h中配置），各模块按任务ID创建任务
+ * 2. 以xTaskCreatePinnedToCore创建任务，调制解调器I/O与Web、推送分处不同核心
+ * 3. 统计各任务（含Arduino loop与AsyncTCP）的栈高水位，栈余量不足时输出告警
+ */
+
+#ifndef TASK_TOPOLOGY_H
+#define TASK_TOPOLOGY_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <vector>
+#include <mutex>
+
+/**
+ * @enum SystemTaskId
+ * @brief 系统任务ID
+ */
+enum SystemTaskId {
+    SYSTEM_TASK_MODEM_ARBITER = 0,      ///< 调制解调器仲裁器（独占SIM串口）
+    SYSTEM_TASK_UART_MONITOR,           ///< 短信URC消费者
+    SYSTEM_TASK_SMS_SEND,               ///< 短信发送队列
+    SYSTEM_TASK_PUSH_WORKER,            ///< 推送工作线程
+    SYSTEM_TASK_SCHEDULER_WORKER,       ///< 定时任务工作线程
+    SYSTEM_TASK_LOG_SINK,               ///< 异步日志输出
+    SYSTEM_TASK_MODEM_SIMULATOR,        ///< 调制解调器模拟器（回放串口流量，按需创建）
+    SYSTEM_TASK_DB_WORKER,              ///< 数据库工作线程（独占SQLite连接）
+    SYSTEM_TASK_MODEM2_ARBITER,         ///< 第2个SIM模块的仲裁器（SIM_MODEM_COUNT>1时创建）
+    SYSTEM_TASK_MODEM2_MONITOR,         ///< 第2个SIM模块的短信URC消费者
+    SYSTEM_TASK_MODEM3_ARBITER,         ///< 第3个SIM模块的仲裁器（SIM_MODEM_COUNT>2时创建）
+    SYSTEM_TASK_MODEM3_MONITOR,         ///< 第3个SIM模块的短信URC消费者
+    SYSTEM_TASK_COUNT
+};
+
+/**
+ * @struct SystemTaskSpec
+ * @brief 系统任务的创建参数
+ */
+struct SystemTaskSpec {
+    const char* name;                   ///< 任务名称
+    uint32_t stackSize;                 ///< 栈大小（字节）
+    UBaseType_t priority;               ///< 优先级
+    BaseType_t core;                    ///< 运行核心
+};
+
+/**
+ * @struct TaskStackInfo
+ * @brief 任务栈使用情况
+ */
+struct TaskStackInfo {
+    String name;                        ///< 任务名称
+    bool running;                       ///< 任务是否存在
+    uint32_t stackSize;                 ///< 栈大小（字节，未知时为0）
+    uint32_t freeBytes;                 ///< 运行以来栈剩余的最小值（字节）
+    UBaseType_t priority;               ///< 当前优先级
+    int core;                           ///< 绑定的核心（-1表示不绑定）
+};
+
+/**
+ * @class TaskTopology
+ * @brief 系统任务拓扑类
+ */
+class TaskTopology {
+public:
+    /**
+     * @brief 获取单例实例
+     * @return TaskTopology& 单例引用
+     */
+    static TaskTopology& getInstance();
+
+    /**
+     * @brief 获取任务的创建参数
+     * @param id 任务ID
+     * @return const SystemTaskSpec& 创建参数
+     */
+    static const SystemTaskSpec& getSpec(SystemTaskId id);
+
+    /**
+     * @brief 按拓扑表创建并登记任务
+     * @param id 任务ID
+     * @param function 任务入口
+     * @param parameter 任务参数
+     * @param handle 输出：任务句柄（可为nullptr）
+     * @return true 创建成功
+     * @return false 创建失败
+     */
+    bool createTask(SystemTaskId id, TaskFunction_t function, void* parameter, TaskHandle_t* handle);
+
+    /**
+     * @brief 获取所有任务（含Arduino loop与AsyncTCP）的栈使用情况
+     * @return std::vector<TaskStackInfo> 栈使用情况
+     */
+    std::vector<TaskStackInfo> getStackInfo() const;
+
+    /**
+     * @brief 检查任务栈高水位，余量低于TASK_STACK_WARN_FREE_BYTES时输出告警（由定时任务调用）
+     * @return int 余量不足的任务数
+     */
+    int checkStackWatermarks();
+
+    /**
+     * @brief 获取任务拓扑与栈使用情况描述
+     * @return String 描述
+     */
+    String getReport() const;
+
+private:
+    /**
+     * @brief 私有构造函数（单例模式）
+     */
+    TaskTopology();
+
+    /**
+     * @brief 禁用拷贝构造函数
+     */
+    TaskTopology(const TaskTopology&) = delete;
+
+    /**
+     * @brief 禁用赋值操作符
+     */
+    TaskTopology& operator=(const TaskTopology&) = delete;
+
+    /**
+     * @brief 读取任务的栈使用情况
+     * @param name 任务名称
+     * @param handle 任务句柄（nullptr表示任务不存在）
+     * @param stackSize 栈大小（未知时为0）
+     * @return TaskStackInfo 栈使用情况
+     */
+    static TaskStackInfo readTask(const char* name, TaskHandle_t handle, uint32_t stackSize);
+
+private:
+    TaskHandle_t handles[SYSTEM_TASK_COUNT];    ///< 已创建任务的句柄
+    uint32_t warnedFreeBytes[SYSTEM_TASK_COUNT + 2];   ///< 已告警时的栈余量（含loop与AsyncTCP，余量继续下降才再次告警）
+    mutable std::mutex mutex;                   ///< 保护句柄表
+};
+
+#endif // TASK_TOPOLOGY_H
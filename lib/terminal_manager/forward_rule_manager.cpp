@@ -7,6 +7,7 @@
 
 #include "forward_rule_manager.h"
 #include "database_manager.h"
+#include "../db_worker/db_worker.h"
 #include "log_manager.h"
 #include "../push_manager/push_channel_registry.h"
 #include "../push_manager/push_manager.h"
@@ -85,26 +86,33 @@ int ForwardRuleManager::addRule(const ForwardRule& rule) {
         return -1;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
-    // 直接使用DatabaseManager的公共接口，不需要手动构建SQL
-    
-    // 使用DatabaseManager的公共接口
-    int ruleId = db.addForwardRule(rule);
-    if (ruleId <= 0) {
-        lastError = "Failed to insert rule: " + db.getLastError();
+    int ruleId = -1;
+    ForwardRule newRule;
+    newRule.id = 0;
+    if (!runDatabase([&](DatabaseManager& db) {
+            ruleId = db.addForwardRule(rule);
+            if (ruleId <= 0) {
+                lastError = "Failed to insert rule: " + db.getLastError();
+                return;
+            }
+            // 读回数据库生成的字段（ID、时间戳）
+            newRule = db.getForwardRuleById(ruleId);
+        }) || ruleId <= 0) {
         return -1;
     }
     
+    if (newRule.id <= 0) {
+        newRule = rule;
+        newRule.id = ruleId;
+    }
+    
     // 更新缓存
     if (enableCache) {
-        ForwardRule newRule = rule;
-        newRule.id = ruleId;
         addToCache(newRule);
     }
     
-    // 刷新推送管理器缓存
-    PushManager::getInstance().refreshRuleCache();
+    // 增量更新推送管理器缓存
+    PushManager::getInstance().upsertCachedRule(newRule);
     
     return ruleId;
 }
@@ -127,13 +135,17 @@ bool ForwardRuleManager::updateRule(const ForwardRule& rule) {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
-    // 直接使用DatabaseManager的公共接口，不需要手动构建SQL
-    
-    // 使用DatabaseManager的公共接口
-    if (!db.updateForwardRule(rule)) {
-        lastError = "Failed to update rule: " + db.getLastError();
+    bool updated = false;
+    ForwardRule storedRule;
+    storedRule.id = 0;
+    if (!runDatabase([&](DatabaseManager& db) {
+            if (!db.updateForwardRule(rule)) {
+                lastError = "Failed to update rule: " + db.getLastError();
+                return;
+            }
+            updated = true;
+            storedRule = db.getForwardRuleById(rule.id);
+        }) || !updated) {
         return false;
     }
     
@@ -142,6 +154,9 @@ bool ForwardRuleManager::updateRule(const ForwardRule& rule) {
         updateCache(rule);
     }
     
+    // 增量更新推送管理器缓存
+    PushManager::getInstance().upsertCachedRule(storedRule.id > 0 ? storedRule : rule);
+    
     return true;
 }
 
@@ -156,11 +171,13 @@ bool ForwardRuleManager::deleteRule(int ruleId) {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
-    // 使用DatabaseManager的公共接口
-    if (!db.deleteForwardRule(ruleId)) {
-        lastError = "Failed to delete rule: " + db.getLastError();
+    bool deleted = false;
+    if (!runDatabase([&](DatabaseManager& db) {
+            deleted = db.deleteForwardRule(ruleId);
+            if (!deleted) {
+                lastError = "Failed to delete rule: " + db.getLastError();
+            }
+        }) || !deleted) {
         return false;
     }
     
@@ -169,8 +186,8 @@ bool ForwardRuleManager::deleteRule(int ruleId) {
         removeFromCache(ruleId);
     }
     
-    // 刷新推送管理器缓存
-    PushManager::getInstance().refreshRuleCache();
+    // 增量更新推送管理器缓存
+    PushManager::getInstance().removeCachedRule(ruleId);
     
     return true;
 }
@@ -199,9 +216,13 @@ ForwardRule ForwardRuleManager::getRule(int ruleId) {
     }
     
     // 从数据库查询
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
-    ForwardRule rule = db.getForwardRuleById(ruleId);
+    ForwardRule rule;
+    rule.id = 0;
+    if (!runDatabase([&](DatabaseManager& db) {
+            rule = db.getForwardRuleById(ruleId);
+        })) {
+        return emptyRule;
+    }
     if (rule.id == 0) {
         lastError = "Rule not found";
         return emptyRule;
@@ -223,91 +244,12 @@ std::vector<ForwardRule> ForwardRuleManager::getRules(const RuleQueryCondition&
         return rules;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
-    // 构建SQL查询
-    String sql = "SELECT * FROM forward_rules";
-    std::vector<String> params;
-    std::vector<String> whereClauses;
-    
-    // 添加过滤条件
-    if (condition.filterByEnabled) {
-        whereClauses.push_back("enabled = ?");
-        params.push_back(String(condition.enabledValue ? 1 : 0));
-    }
-    
-    if (condition.filterByPushType && !condition.pushType.isEmpty()) {
-        whereClauses.push_back("push_type = ?");
-        params.push_back(condition.pushType);
-    }
-    
-    // 添加WHERE子句
-    if (!whereClauses.empty()) {
-        sql += " WHERE ";
-        for (size_t i = 0; i < whereClauses.size(); i++) {
-            if (i > 0) sql += " AND ";
-            sql += whereClauses[i];
-        }
-    }
-    
-    // 添加排序
-    if (condition.orderByPriority) {
-        sql += " ORDER BY priority DESC, id ASC";
-    } else {
-        sql += " ORDER BY id ASC";
-    }
-    
-    // 添加限制
-    if (condition.limit > 0) {
-        sql += " LIMIT " + String(condition.limit);
-        if (condition.offset > 0) {
-            sql += " OFFSET " + String(condition.offset);
-        }
-    }
-    
-    // 由于executeQuery需要回调函数，我们使用getAllForwardRules然后进行过滤
-    std::vector<ForwardRule> allRules = db.getAllForwardRules();
-    
-    // 根据条件过滤规则
-    for (const ForwardRule& rule : allRules) {
-        bool match = true;
-        
-        // 检查启用状态
-        if (condition.filterByEnabled && rule.enabled != condition.enabledValue) {
-            match = false;
-        }
-        
-        // 检查推送类型匹配
-        if (match && condition.filterByPushType && !condition.pushType.isEmpty()) {
-            if (rule.pushType != condition.pushType) {
-                match = false;
-            }
-        }
-        
-        if (match) {
-            rules.push_back(rule);
-        }
-    }
-    
-    // 排序
-    if (condition.orderByPriority) {
-        // 由于 ForwardRule 结构体中没有 priority 字段，简单按 ID 排序
-        std::sort(rules.begin(), rules.end(), [](const ForwardRule& a, const ForwardRule& b) {
-            return a.id < b.id; // 按ID升序排序
-        });
-    }
-    
-    // 应用限制和偏移
-    if (condition.limit > 0) {
-        int startIndex = condition.offset;
-        int endIndex = std::min(startIndex + condition.limit, (int)rules.size());
-        
-        if (startIndex < rules.size()) {
-            rules = std::vector<ForwardRule>(rules.begin() + startIndex, rules.begin() + endIndex);
-        } else {
-            rules.clear();
-        }
-    }
+    // 过滤、排序与分页在SQL中完成
+    int enabledFilter = condition.filterByEnabled ? (condition.enabledValue ? 1 : 0) : -1;
+    String pushType = condition.filterByPushType ? condition.pushType : String("");
+    runDatabase([&](DatabaseManager& db) {
+        rules = db.getForwardRules(enabledFilter, pushType, condition.limit, condition.offset, condition.orderByPriority);
+    });
     
     return rules;
 }
@@ -333,19 +275,22 @@ bool ForwardRuleManager::setRuleEnabled(int ruleId, bool enabled) {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 由于DatabaseManager没有专门的更新启用状态接口，我们需要先获取规则再更新
-    ForwardRule rule = db.getForwardRuleById(ruleId);
-    if (rule.id == 0) {
-        lastError = "Rule not found: " + String(ruleId);
-        return false;
-    }
-    
-    rule.enabled = enabled;
-    
-    if (!db.updateForwardRule(rule)) {
-        lastError = "Failed to update rule status: " + db.getLastError();
+    ForwardRule rule;
+    rule.id = 0;
+    bool updated = false;
+    if (!runDatabase([&](DatabaseManager& db) {
+            rule = db.getForwardRuleById(ruleId);
+            if (rule.id == 0) {
+                lastError = "Rule not found: " + String(ruleId);
+                return;
+            }
+            rule.enabled = enabled;
+            updated = db.updateForwardRule(rule);
+            if (!updated) {
+                lastError = "Failed to update rule status: " + db.getLastError();
+            }
+        }) || !updated) {
         return false;
     }
     
@@ -354,6 +299,9 @@ bool ForwardRuleManager::setRuleEnabled(int ruleId, bool enabled) {
         updateRuleEnabledInCache(ruleId, enabled);
     }
     
+    // 增量更新推送管理器缓存
+    PushManager::getInstance().upsertCachedRule(rule);
+    
     return true;
 }
 
@@ -368,24 +316,27 @@ bool ForwardRuleManager::setRulePriority(int ruleId, int priority) {
         return false;
     }
     
-    if (priority < 0 || priority > 1000) {
+    if (priority < 0 || priority > FORWARD_RULE_MAX_PRIORITY) {
         lastError = "Priority must be between 0 and 1000";
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 由于DatabaseManager没有专门的更新优先级接口，我们需要先获取规则再更新
-    ForwardRule rule = db.getForwardRuleById(ruleId);
-    if (rule.id == 0) {
-        lastError = "Rule not found: " + String(ruleId);
-        return false;
-    }
-    
-    // priority 字段不存在于 ForwardRule 结构体中，跳过优先级设置
-    
-    if (!db.updateForwardRule(rule)) {
-        lastError = "Failed to update rule priority: " + db.getLastError();
+    ForwardRule rule;
+    rule.id = 0;
+    bool updated = false;
+    if (!runDatabase([&](DatabaseManager& db) {
+            rule = db.getForwardRuleById(ruleId);
+            if (rule.id <= 0) {
+                lastError = "Rule not found: " + String(ruleId);
+                return;
+            }
+            rule.priority = priority;
+            updated = db.updateForwardRule(rule);
+            if (!updated) {
+                lastError = "Failed to update rule priority: " + db.getLastError();
+            }
+        }) || !updated) {
         return false;
     }
     
@@ -394,6 +345,9 @@ bool ForwardRuleManager::setRulePriority(int ruleId, int priority) {
         updateRulePriorityInCache(ruleId, priority);
     }
     
+    // 增量更新推送管理器缓存，新的优先级立即影响推送顺序
+    PushManager::getInstance().upsertCachedRule(rule);
+    
     return true;
 }
 
@@ -418,6 +372,10 @@ RuleValidationError ForwardRuleManager::validateRule(const ForwardRule& rule) {
         return RULE_ERROR_EMPTY_PUSH_CONFIG;
     }
     
+    if (rule.priority < 0 || rule.priority > FORWARD_RULE_MAX_PRIORITY) {
+        return RULE_ERROR_INVALID_PRIORITY;
+    }
+    
     // 验证sourceNumber的正则表达式模式（如果不为空且不是简单通配符）
     if (!rule.sourceNumber.isEmpty() && !validateRegexPattern(rule.sourceNumber)) {
         return RULE_ERROR_INVALID_REGEX;
@@ -475,10 +433,12 @@ int ForwardRuleManager::getRuleCount() {
         return 0;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 使用高效的COUNT查询而不是获取所有规则
-    return db.getForwardRuleCount();
+    int count = 0;
+    runDatabase([&count](DatabaseManager& db) {
+        count = db.getForwardRuleCount();
+    });
+    return count;
 }
 
 int ForwardRuleManager::getEnabledRuleCount() {
@@ -486,10 +446,12 @@ int ForwardRuleManager::getEnabledRuleCount() {
         return 0;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 使用高效的COUNT查询而不是获取所有规则
-    return db.getEnabledForwardRuleCount();
+    int count = 0;
+    runDatabase([&count](DatabaseManager& db) {
+        count = db.getEnabledForwardRuleCount();
+    });
+    return count;
 }
 
 std::vector<ForwardRule> ForwardRuleManager::getMostUsedRules(int limit) {
@@ -497,10 +459,11 @@ std::vector<ForwardRule> ForwardRuleManager::getMostUsedRules(int limit) {
         return std::vector<ForwardRule>();
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 使用getAllForwardRules获取所有规则，然后手动排序
-    std::vector<ForwardRule> rules = db.getAllForwardRules();
+    std::vector<ForwardRule> rules;
+    runDatabase([&rules](DatabaseManager& db) {
+        rules = db.getAllForwardRules();
+    });
     
     // 按使用次数和最后使用时间排序
     // 由于ForwardRule结构体中没有usageCount和lastUsedTime字段，
@@ -528,21 +491,22 @@ bool ForwardRuleManager::updateRuleUsage(int ruleId) {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 由于DatabaseManager没有专门的更新使用次数接口，我们需要先获取规则再更新
-    ForwardRule rule = db.getForwardRuleById(ruleId);
-    if (rule.id == 0) {
-        lastError = "Rule not found: " + String(ruleId);
-        return false;
-    }
-    
-    // 由于ForwardRule结构体中没有usageCount和lastUsedTime字段，
-    // 这里只更新updatedAt字段
-    rule.updatedAt = getCurrentTimestamp();
-    
-    if (!db.updateForwardRule(rule)) {
-        lastError = "Failed to update rule usage: " + db.getLastError();
+    bool updated = false;
+    if (!runDatabase([&](DatabaseManager& db) {
+            ForwardRule rule = db.getForwardRuleById(ruleId);
+            if (rule.id == 0) {
+                lastError = "Rule not found: " + String(ruleId);
+                return;
+            }
+            // 由于ForwardRule结构体中没有usageCount和lastUsedTime字段，
+            // 这里只更新updatedAt字段
+            rule.updatedAt = getCurrentTimestamp();
+            updated = db.updateForwardRule(rule);
+            if (!updated) {
+                lastError = "Failed to update rule usage: " + db.getLastError();
+            }
+        }) || !updated) {
         return false;
     }
     
@@ -570,16 +534,20 @@ bool ForwardRuleManager::setAllRulesEnabled(bool enabled) {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 由于DatabaseManager没有批量更新接口，我们需要逐个更新规则
-    std::vector<ForwardRule> rules = db.getAllForwardRules();
-    for (ForwardRule& rule : rules) {
-        rule.enabled = enabled;
-        if (!db.updateForwardRule(rule)) {
-            lastError = "Failed to update rule " + String(rule.id) + ": " + db.getLastError();
-            return false;
-        }
+    bool updated = true;
+    if (!runDatabase([&](DatabaseManager& db) {
+            std::vector<ForwardRule> rules = db.getAllForwardRules();
+            for (ForwardRule& rule : rules) {
+                rule.enabled = enabled;
+                if (!db.updateForwardRule(rule)) {
+                    lastError = "Failed to update rule " + String(rule.id) + ": " + db.getLastError();
+                    updated = false;
+                    return;
+                }
+            }
+        }) || !updated) {
+        return false;
     }
     
     // 刷新缓存
@@ -596,15 +564,19 @@ bool ForwardRuleManager::deleteAllRules() {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     // 由于DatabaseManager没有批量删除接口，我们需要逐个删除规则
-    std::vector<ForwardRule> rules = db.getAllForwardRules();
-    for (const ForwardRule& rule : rules) {
-        if (!db.deleteForwardRule(rule.id)) {
-            lastError = "Failed to delete rule " + String(rule.id) + ": " + db.getLastError();
-            return false;
-        }
+    bool deleted = true;
+    if (!runDatabase([&](DatabaseManager& db) {
+            std::vector<ForwardRule> rules = db.getAllForwardRules();
+            for (const ForwardRule& rule : rules) {
+                if (!db.deleteForwardRule(rule.id)) {
+                    lastError = "Failed to delete rule " + String(rule.id) + ": " + db.getLastError();
+                    deleted = false;
+                    return;
+                }
+            }
+        }) || !deleted) {
+        return false;
     }
     
     // 清空缓存
@@ -621,9 +593,8 @@ bool ForwardRuleManager::importRules(const std::vector<ForwardRule>& rules) {
         return false;
     }
     
-    DatabaseManager& db = DatabaseManager::getInstance();
-    
     bool success = true;
+    int importedCount = 0;
     
     for (const ForwardRule& rule : rules) {
         // 验证规则
@@ -634,14 +605,27 @@ bool ForwardRuleManager::importRules(const std::vector<ForwardRule>& rules) {
             success = false;
             break;
         }
-        
-        // 使用DatabaseManager的公共接口插入规则
-        int newRuleId = db.addForwardRule(rule);
-        if (newRuleId <= 0) {
-            lastError = "Failed to import rule '" + rule.ruleName + "': " + db.getLastError();
-            success = false;
-            break;
-        }
+    }
+    
+    // 全部通过验证后在一个数据库请求中逐条插入
+    if (success && !runDatabase([&](DatabaseManager& db) {
+            for (const ForwardRule& rule : rules) {
+                // 使用DatabaseManager的公共接口插入规则
+                int newRuleId = db.addForwardRule(rule);
+                if (newRuleId <= 0) {
+                    lastError = "Failed to import rule '" + rule.ruleName + "': " + db.getLastError();
+                    success = false;
+                    return;
+                }
+                importedCount++;
+            }
+        })) {
+        success = false;
+    }
+    
+    // 全部插入后只重新加载一次推送管理器缓存，导入耗时与规则数成线性关系
+    if (importedCount > 0) {
+        PushManager::getInstance().refreshRuleCache();
     }
     
     // 刷新缓存
@@ -672,6 +656,16 @@ void ForwardRuleManager::refreshCache() {
     }
 }
 
+bool ForwardRuleManager::runDatabase(const std::function<void(DatabaseManager&)>& job) {
+    // SQLite连接只能由数据库工作线程使用；在工作线程中调用时直接执行
+    DbWorker& dbWorker = DbWorker::getInstance();
+    if (dbWorker.call([&job]() { job(DatabaseManager::getInstance()); })) {
+        return true;
+    }
+    lastError = "Database request not executed: " + dbWorker.getLastError();
+    return false;
+}
+
 void ForwardRuleManager::addToCache(const ForwardRule& rule) {
     if (!enableCache) {
         return;
@@ -747,7 +741,7 @@ void ForwardRuleManager::updateRulePriorityInCache(int ruleId, int priority) {
     
     for (ForwardRule& rule : ruleCache) {
         if (rule.id == ruleId) {
-            // priority 字段不存在于 ForwardRule 结构体中，跳过优先级设置
+            rule.priority = priority;
             rule.updatedAt = String(getCurrentTimestamp());  // 使用 updatedAt 而不是 updateTime
             return;
         }
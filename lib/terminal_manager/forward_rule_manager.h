@@ -13,6 +13,7 @@
 
 #include <Arduino.h>
 #include <vector>
+#include <functional>
 #include "../database_manager/database_manager.h"
 
 // 前向声明
@@ -415,6 +416,14 @@ private:
      */
     void updateRuleUsageInCache(int ruleId);
     
+    /**
+     * @brief 在数据库工作线程中执行数据库操作并等待完成
+     * @param job 数据库操作
+     * @return true 已执行
+     * @return false 未执行（队列已满或等待超时，错误信息见lastError）
+     */
+    bool runDatabase(const std::function<void(DatabaseManager&)>& job);
+    
     // ==================== 私有成员变量 ====================
     
     bool initialized;              ///< 初始化状态
@@ -7,9 +7,18 @@
 
 #include "terminal_manager.h"
 #include "../database_manager/database_manager.h"
+#include "../db_worker/db_worker.h"
+#include "../flash_vfs/flash_vfs.h"
 #include "../log_manager/log_manager.h"
 #include "../push_manager/push_manager.h"
 #include "../gsm_service/gsm_service.h"
+#include "../pdu_decoder/pdu_decoder.h"
+#include "../benchmark/benchmark.h"
+#include "../modem_simulator/modem_simulator.h"
+#include "../sms_sender/sms_send_queue.h"
+#include "../task_topology/task_topology.h"
+#include "../task_scheduler/task_scheduler.h"
+#include "../boot_sequencer/boot_sequencer.h"
 #include "../../include/constants.h"
 #include <regex>
 #include <time.h>
@@ -406,12 +415,28 @@ bool TerminalManager::processCommand(const String& command) {
         executeEnableCommand(args);
     } else if (cmd == "disable" || cmd == "dis") {
         executeDisableCommand(args);
+    } else if (cmd == "priority") {
+        executePriorityCommand(args);
     } else if (cmd == "test") {
         executeTestCommand(args);
     } else if (cmd == "status" || cmd == "stat") {
         executeStatusCommand(args);
     } else if (cmd == "synctime" || cmd == "time") {
         executeSyncTimeCommand(args);
+    } else if (cmd == "dbbench") {
+        executeDbBenchCommand(args);
+    } else if (cmd == "dbinfo") {
+        executeDbInfoCommand();
+    } else if (cmd == "tasks") {
+        executeTasksCommand();
+    } else if (cmd == "pdubench") {
+        executePduBenchCommand(args);
+    } else if (cmd == "bench") {
+        executeBenchCommand(args);
+    } else if (cmd == "modemsim") {
+        executeModemSimCommand(args);
+    } else if (cmd == "sendsms") {
+        executeSendSmsCommand(args);
     } else if (cmd == "import") {
         executeImportCommand(args);
     } else if (cmd == "export") {
@@ -793,6 +818,7 @@ void TerminalManager::executeHelpCommand(const std::vector<String>& args) {
     Serial.println("通用命令:");
     Serial.println("  help, h [渠道名]           - 显示帮助信息，可指定渠道查看详细配置");
     Serial.println("  status, stat               - 显示系统状态");
+    Serial.println("  tasks                      - 显示任务栈高水位、定时任务统计与启动耗时");
     Serial.println("  synctime, time [sync|set]  - 网络时间同步测试");
     Serial.println("  clear, cls                 - 清屏");
     Serial.println("  exit, quit, q              - 退出CLI");
@@ -803,14 +829,22 @@ void TerminalManager::executeHelpCommand(const std::vector<String>& args) {
     Serial.println("  delete, del, rm <id>       - 根据ID删除规则");
     Serial.println("  enable, en <id>            - 根据ID启用规则");
     Serial.println("  disable, dis <id>          - 根据ID禁用规则");
+    Serial.println("  priority <id> <0-1000>     - 设置规则优先级（越小越先推送）");
     Serial.println("  test <id> <发送方> <内容>   - 测试规则匹配");
     Serial.println();
     Serial.println("数据管理:");
     Serial.println("  import                     - 导入规则（交互式）");
     Serial.println("  export                     - 导出所有规则");
+    Serial.println("  dbbench [次数]             - 测量短信插入耗时（预编译语句对比）");
+    Serial.println("  dbinfo                     - 显示数据库存储布局与缓存命中率");
+    Serial.println("  pdubench [次数] [PDU]      - 测量PDU解码耗时（pdulib与原地解码对比）");
+    Serial.println("  bench [测试组] [次数] [参数] - 基准测试，输出p50/p95/最大耗时（不带参数列出测试组）");
+    Serial.println("  sendsms <号码> <内容>      - 通过发送队列发送短信（超长内容自动分段）");
     Serial.println();
     Serial.println("AT命令:");
     Serial.println("  at <AT命令>                - AT命令透传到GSM模块");
+    Serial.println("  modemsim run [速率/秒] [事件数] [脚本] - 以模拟器接管串口回放流量（速率0不限速）");
+    Serial.println("  modemsim status|stop       - 查看回放报告 / 停止回放并恢复串口");
     Serial.println();
     
     // 显示可用的推送渠道
@@ -899,7 +933,7 @@ void TerminalManager::executeAddCommandWithNamedParams(const std::vector<String>
         namedParams.find("type") == namedParams.end() || 
         namedParams.find("config") == namedParams.end()) {
         
-        Serial.println("用法: add name=<规则名称> sender=<发送方> type=<推送类型> config=<推送配置> [keywords=<关键词>] [default=<true/false>] [enabled=<true/false>]");
+        Serial.println("用法: add name=<规则名称> sender=<发送方> type=<推送类型> config=<推送配置> [keywords=<关键词>] [default=<true/false>] [enabled=<true/false>] [priority=<0-1000>]");
         Serial.println("示例: add name=银行提醒 sender=95588 type=wechat_official config={\"app_id\":\"wx123\",\"app_secret\":\"secret\",\"open_ids\":\"openid1,openid2\",\"template_id\":\"template123\",\"template_format\":{\"content\":{\"value\":\"{content}\",\"color\":\"#173177\"}}} keywords=余额 default=false");
         Serial.println("\n参数说明:");
         Serial.println("  name     - 规则名称 (必需)");
@@ -909,6 +943,7 @@ void TerminalManager::executeAddCommandWithNamedParams(const std::vector<String>
         Serial.println("  keywords - 短信内容关键词过滤 (可选)");
         Serial.println("  default  - 是否默认转发: true/false (可选，默认false)");
         Serial.println("  enabled  - 是否启用规则: true/false (可选，默认true)");
+        Serial.println("  priority - 优先级: 0-1000，越小越先推送 (可选，默认100)");
         return;
     }
     
@@ -939,6 +974,11 @@ void TerminalManager::executeAddCommandWithNamedParams(const std::vector<String>
         rule.enabled = true;
     }
     
+    // 优先级参数
+    if (namedParams.find("priority") != namedParams.end()) {
+        rule.priority = namedParams["priority"].toInt();
+    }
+    
     addRuleAndShowResult(rule);
 }
 
@@ -953,6 +993,7 @@ void TerminalManager::addRuleAndShowResult(const ForwardRule& rule) {
         Serial.println("  关键词: " + (rule.keywords.isEmpty() ? "无" : rule.keywords));
         Serial.println("  默认转发: " + String(rule.isDefaultForward ? "是" : "否"));
         Serial.println("  启用状态: " + String(rule.enabled ? "是" : "否"));
+        Serial.println("  优先级: " + String(rule.priority));
     } else {
         Serial.println("添加规则失败: " + getLastError());
     }
@@ -1025,6 +1066,28 @@ void TerminalManager::executeDisableCommand(const std::vector<String>& args) {
     }
 }
 
+void TerminalManager::executePriorityCommand(const std::vector<String>& args) {
+    if (args.size() < 2) {
+        Serial.println("用法: priority <规则ID> <0-1000>");
+        Serial.println("数字越小越先推送；优先级不高于" + String(PUSH_LANE_HIGH_MAX_PRIORITY) +
+                       "的规则进入高优先级推送队列");
+        return;
+    }
+    
+    int ruleId = args[0].toInt();
+    if (ruleId <= 0) {
+        Serial.println("无效的规则ID: " + args[0]);
+        return;
+    }
+    
+    int priority = args[1].toInt();
+    if (setRulePriority(ruleId, priority)) {
+        Serial.println("规则优先级已设置为 " + String(priority) + "。");
+    } else {
+        Serial.println("设置优先级失败: " + getLastError());
+    }
+}
+
 void TerminalManager::executeTestCommand(const std::vector<String>& args) {
     if (args.size() < 3) {
         Serial.println("用法: test <规则ID> <发送方> <内容>");
@@ -1072,6 +1135,224 @@ void TerminalManager::executeStatusCommand(const std::vector<String>& args) {
     Serial.println("  缓存启用: " + String(config.enableCache ? "是" : "否"));
     Serial.println("  验证启用: " + String(config.enableValidation ? "是" : "否"));
     Serial.println("  日志启用: " + String(config.enableLogging ? "是" : "否"));
+    
+    // 只读取后台刷新的快照，不向模块发送命令
+    ModemStatus modem = GsmService::getInstance().getStatusSnapshot();
+    Serial.println("\n模块状态:");
+    if (!modem.valid) {
+        Serial.println("  尚未查询");
+        return;
+    }
+    unsigned long now = millis();
+    Serial.println("  模块在线: " + String(modem.online ? "是" : "否"));
+    Serial.println("  SIM卡就绪: " + String(modem.simReady ? "是" : "否"));
+    Serial.println("  网络注册: " + String(modem.isRegistered() ? "已注册" : "未注册") +
+                   "（" + String((now - modem.networkUpdatedAt) / 1000) + "秒前）");
+    Serial.println("  信号强度: " + (modem.signalStrength < 0 ? String("未知") : String(modem.signalStrength) + "/31"));
+    Serial.println("  刷新时间: " + String((now - modem.refreshedAt) / 1000) + "秒前");
+}
+
+void TerminalManager::executeDbBenchCommand(const std::vector<String>& args) {
+    int iterations = args.size() > 0 ? args[0].toInt() : 50;
+    if (iterations <= 0 || iterations > 1000) {
+        Serial.println("次数应在1-1000之间");
+        return;
+    }
+    
+    Serial.println("\n=== 短信插入耗时测量（" + String(iterations) + "次） ===");
+    Serial.println("存储:         " + String(DB_USE_RAW_PARTITION ? "原始分区" : "LittleFS"));
+    // 在数据库工作线程中测量，与合并提交窗口中的写入串行执行
+    DbBenchmarkResult result;
+    result.iterations = 0;
+    String dbError;
+    if (!DbWorker::getInstance().call([&]() {
+            result = DatabaseManager::getInstance().benchmarkInsert(iterations);
+            if (result.iterations == 0) {
+                dbError = DatabaseManager::getInstance().getLastError();
+            }
+        })) {
+        dbError = DbWorker::getInstance().getLastError();
+    }
+    if (result.iterations == 0) {
+        Serial.println("测量失败: " + dbError);
+        return;
+    }
+    
+    Serial.println("每次编译语句: " + String(result.uncachedAvgUs) + " us/条");
+    Serial.println("预编译语句:   " + String(result.cachedAvgUs) + " us/条");
+    if (result.cachedAvgUs > 0) {
+        Serial.println("吞吐量:       " + String(1000000.0f / result.cachedAvgUs, 1) + " 条/秒");
+    }
+    if (result.flashStatsAvailable) {
+        Serial.println("擦除扇区:     " + String(result.erasesPerInsert, 2) + " 个/条");
+        Serial.println("写入flash:    " + String(result.bytesPerInsert) + " 字节/条");
+    } else {
+        Serial.println("flash写入:    未统计（LittleFS需启用CONFIG_SPI_FLASH_ENABLE_COUNTERS）");
+    }
+}
+
+void TerminalManager::executePduBenchCommand(const std::vector<String>& args) {
+    // 默认使用一条UCS2编码的长短信分片（16位参考号，含代理对字符）
+    static const char* samplePdu =
+        "0891683108200105F0440D91683119325476F800084210412143002315060804123403024F60597DFF0C4E16754CD83DDE00";
+    
+    int iterations = args.size() > 0 ? args[0].toInt() : 200;
+    if (iterations <= 0 || iterations > 10000) {
+        Serial.println("次数应在1-10000之间");
+        return;
+    }
+    String pdu = args.size() > 1 ? args[1] : String(samplePdu);
+    
+    Serial.println("\n=== PDU解码耗时测量（" + String(iterations) + "次） ===");
+    PduBenchmarkResult result = benchmarkPduDecode(pdu.c_str(), iterations);
+    if (result.iterations == 0) {
+        Serial.println("测量失败: PDU无法解码");
+        return;
+    }
+    
+    Serial.println("pdulib:   " + String(result.pdulibAvgUs) + " us/条");
+    Serial.println("原地解码: " + String(result.inPlaceAvgUs) + " us/条");
+}
+
+void TerminalManager::executeBenchCommand(const std::vector<String>& args) {
+    if (args.empty()) {
+        Serial.println("用法: bench <测试组|all> [次数] [参数]");
+        Serial.println("测试组:");
+        Serial.print(Benchmark::getSuiteHelp());
+        return;
+    }
+    
+    // 未指定次数时使用各测试组的默认次数
+    int iterations = args.size() > 1 ? args[1].toInt() : 0;
+    if (args.size() > 1 && (iterations <= 0 || iterations > BENCH_MAX_ITERATIONS)) {
+        Serial.println("次数应在1-" + String(BENCH_MAX_ITERATIONS) + "之间");
+        return;
+    }
+    String arg = args.size() > 2 ? args[2] : String("");
+    
+    Serial.println("\n=== 基准测试: " + args[0] +
+                   (iterations > 0 ? "（每项" + String(iterations) + "次）" : String("")) + " ===");
+    std::vector<BenchmarkResult> results;
+    if (!Benchmark::runSuite(args[0], iterations, arg, results)) {
+        Serial.println("未知的测试组: " + args[0]);
+        return;
+    }
+    
+    for (const BenchmarkResult& result : results) {
+        Serial.println(Benchmark::format(result));
+    }
+}
+
+void TerminalManager::executeModemSimCommand(const std::vector<String>& args) {
+    ModemSimulator& simulator = ModemSimulator::getInstance();
+    String action = args.size() > 0 ? args[0] : String("status");
+    
+    if (action == "run") {
+        ModemSimulatorOptions options;
+        options.ratePerSecond = args.size() > 1 ? args[1].toInt() : 10;
+        options.eventCount = args.size() > 2 ? args[2].toInt() : 100;
+        options.scriptPath = args.size() > 3 ? args[3] : String("");
+        if (!simulator.start(options)) {
+            Serial.println("启动失败: " + simulator.getLastError());
+            return;
+        }
+        Serial.println("模拟器已接管串口，回放期间不接收真实短信；用 modemsim status 查看进度");
+        return;
+    }
+    
+    if (action == "stop") {
+        if (!simulator.isRunning()) {
+            Serial.println("模拟器未在回放");
+            return;
+        }
+        simulator.stop();
+        Serial.println("已请求停止，回放任务随后恢复串口");
+        return;
+    }
+    
+    if (action != "status") {
+        Serial.println("用法: modemsim run [速率/秒] [事件数] [脚本] | status | stop");
+        return;
+    }
+    
+    ModemSimulatorReport report = simulator.getReport();
+    Serial.println("\n=== 调制解调器模拟器 ===");
+    Serial.println("状态:     " + String(report.running ? "回放中" : "空闲"));
+    Serial.println("事件:     已发出 " + String(report.sentEvents) + " / 计划 " + String(report.plannedEvents) +
+                   "，丢弃 " + String(report.droppedEvents));
+    Serial.println("迟发:     " + String(report.lateEvents) + " 个，最大 " + String(report.maxLagMs) + " ms");
+    Serial.println("丢弃行:   " + String(report.droppedLines) + "（订阅者队列已满或行过长）");
+    Serial.println("应答命令: " + String(report.answeredCommands));
+    Serial.println("入库短信: " + String(report.storedSms) + "，完成推送: " + String(report.completedPushes));
+    if (report.storedSms > 0 && report.elapsedMs > 0) {
+        Serial.println("吞吐:     " + String(report.storedSms * 1000.0 / report.elapsedMs, 1) + " 条/秒（" +
+                       String(report.elapsedMs) + " ms）");
+    }
+}
+
+void TerminalManager::executeSendSmsCommand(const std::vector<String>& args) {
+    if (args.size() < 2) {
+        Serial.println("用法: sendsms <号码> <内容>");
+        Serial.println("示例: sendsms 10086 \"查询余额\"");
+        return;
+    }
+    
+    uint32_t jobId = SmsSendQueue::getInstance().enqueue(args[0], args[1], [](const SmsSendReport& report) {
+        for (const SmsSendPartResult& part : report.parts) {
+            Serial.println("  分段 " + String(part.partNumber) + "/" + String((int)report.parts.size()) + ": " +
+                           (part.result == SMS_SUCCESS ? "成功，参考号 " + String(part.messageRef) :
+                            part.result == SMS_ERROR_CANCELLED ? String("未发送") : "失败 - " + part.error));
+        }
+        Serial.println(report.result == SMS_SUCCESS ? "✓ 短信发送完成" : "✗ 短信发送失败: " + report.error);
+    });
+    if (jobId == 0) {
+        Serial.println("✗ 无法加入发送队列: " + SmsSendQueue::getInstance().getLastError());
+        return;
+    }
+    Serial.println("短信已加入发送队列，任务ID: " + String(jobId));
+}
+
+void TerminalManager::executeDbInfoCommand() {
+    DatabaseInfo info;
+    info.isOpen = false;
+    if (!DbWorker::getInstance().call([&info]() {
+            info = DatabaseManager::getInstance().getDatabaseInfo();
+        })) {
+        Serial.println("数据库忙: " + DbWorker::getInstance().getLastError());
+        return;
+    }
+    if (!info.isOpen) {
+        Serial.println("数据库未打开");
+        return;
+    }
+    
+    Serial.println("\n=== 数据库信息 ===");
+    Serial.println("路径:       " + info.dbPath);
+    Serial.println("存储:       " + String(info.rawPartition ? "原始分区 (" DB_RAW_PARTITION_LABEL ")" : "LittleFS"));
+    Serial.println("文件大小:   " + String((unsigned long)info.dbSize) + " 字节");
+    Serial.println("页面大小:   " + String(info.pageSize) + " 字节");
+    Serial.println("缓存容量:   " + String(info.cacheSizePages) + " 页");
+    Serial.println("页面缓存:   " + String(info.psramPageCache ? "PSRAM" : "内部RAM"));
+    Serial.println("SQLite堆:   " + String(info.psramHeap ? "PSRAM" : "系统malloc"));
+    Serial.println("缓存命中:   " + String(info.cacheHits) + " / 未命中: " + String(info.cacheMisses) +
+                   "（命中率 " + String(info.cacheHitRatio * 100.0f, 1) + "%）");
+    if (info.rawPartition) {
+        FlashVfsStats stats = FlashVfs::getInstance().getStats();
+        Serial.println("分区容量:   " + String((unsigned long)FlashVfs::getInstance().getCapacity()) + " 字节");
+        Serial.println("flash写入:  " + String(stats.bytesProgrammed) + " 字节，擦除 " + String(stats.sectorsErased) +
+                       " 扇区，跳过 " + String(stats.skippedWrites) + " 次未变化写入（本次启动以来）");
+    }
+}
+
+void TerminalManager::executeTasksCommand() {
+    Serial.println("\n=== 系统任务 ===");
+    Serial.print(TaskTopology::getInstance().getReport());
+    
+    Serial.println("\n=== 定时任务 ===");
+    Serial.print(TaskScheduler::getInstance().getAllTasksInfo());
+    
+    Serial.println("\n=== 启动阶段 ===");
+    Serial.println(BootSequencer::getInstance().getReport());
 }
 
 void TerminalManager::executeSyncTimeCommand(const std::vector<String>& args) {
@@ -1166,6 +1447,7 @@ void TerminalManager::executeExportCommand(const std::vector<String>& args) {
         Serial.println("    \"pushConfig\": " + rule.pushConfig + ",");
         Serial.println("    \"enabled\": " + String(rule.enabled ? "true" : "false") + ",");
         Serial.println("    \"isDefaultForward\": " + String(rule.isDefaultForward ? "true" : "false") + ",");
+        Serial.println("    \"priority\": " + String(rule.priority) + ",");
         Serial.println("    \"createdAt\": \"" + rule.createdAt + "\",");
         Serial.println("    \"updatedAt\": \"" + rule.updatedAt + "\"");
         Serial.print("  }");
@@ -1204,6 +1486,7 @@ void TerminalManager::printRule(const ForwardRule& rule) {
     Serial.println("  推送配置: " + rule.pushConfig);
     Serial.println("  启用状态: " + String(rule.enabled ? "是" : "否"));
     Serial.println("  默认转发: " + String(rule.isDefaultForward ? "是" : "否"));
+    Serial.println("  优先级: " + String(rule.priority));
     Serial.println("  创建时间: " + rule.createdAt);
     Serial.println("  更新时间: " + rule.updatedAt);
     Serial.println();
@@ -1221,6 +1504,7 @@ void TerminalManager::printRules(const std::vector<ForwardRule>& rules) {
         }
         Serial.println("    推送配置: " + rule.pushConfig);
         Serial.println("    默认转发: " + String(rule.isDefaultForward ? "是" : "否"));
+        Serial.println("    优先级: " + String(rule.priority));
         Serial.println("    更新时间: " + rule.updatedAt);
         Serial.println();
     }
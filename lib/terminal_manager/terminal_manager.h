@@ -329,6 +329,12 @@ private:
      */
     void executeDisableCommand(const std::vector<String>& args);
     
+    /**
+     * @brief 执行设置规则优先级命令
+     * @param args 参数列表
+     */
+    void executePriorityCommand(const std::vector<String>& args);
+    
     /**
      * @brief 执行测试规则命令
      * @param args 参数列表
@@ -347,6 +353,46 @@ private:
      */
     void executeSyncTimeCommand(const std::vector<String>& args);
     
+    /**
+     * @brief 执行数据库插入耗时测量命令
+     * @param args 参数列表（可选插入次数）
+     */
+    void executeDbBenchCommand(const std::vector<String>& args);
+    
+    /**
+     * @brief 执行PDU解码耗时测量命令
+     * @param args 参数列表（可选解码次数与PDU）
+     */
+    void executePduBenchCommand(const std::vector<String>& args);
+    
+    /**
+     * @brief 执行基准测试命令
+     * @param args 参数列表（测试组名称或all，可选执行次数）
+     */
+    void executeBenchCommand(const std::vector<String>& args);
+    
+    /**
+     * @brief 执行调制解调器模拟器命令
+     * @param args 参数列表（run [速率] [事件数] [脚本] | status | stop）
+     */
+    void executeModemSimCommand(const std::vector<String>& args);
+    
+    /**
+     * @brief 执行发送短信命令（投递到发送队列）
+     * @param args 参数列表（号码与内容）
+     */
+    void executeSendSmsCommand(const std::vector<String>& args);
+    
+    /**
+     * @brief 执行数据库信息命令（存储布局与缓存命中率）
+     */
+    void executeDbInfoCommand();
+    
+    /**
+     * @brief 执行任务信息命令（核心、优先级、栈高水位、定时任务统计与启动耗时）
+     */
+    void executeTasksCommand();
+    
     /**
      * @brief 执行导入命令
      * @param args 参数列表
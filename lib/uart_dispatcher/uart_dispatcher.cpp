@@ -1,20 +1,18 @@
 #include "uart_dispatcher.h"
 #include "../../include/constants.h"
-#include "sms_handler.h"
 
-SmsHandler smsHandler;
+UartDispatcher::UartDispatcher(AtCommandHandler& atHandler) : smsHandler(atHandler) {
+}
 
-void UartDispatcher::process(const String& data) {
+void UartDispatcher::process(const LineView& line, UrcType urc, uint32_t receivedUs) {
     // 只在未抑制输出时才打印原始数据
     if (!suppressOutput) {
-        Serial.print(data);
+        Serial.write((const uint8_t*)line.data, line.length);
+        Serial.println();
     }
 
-    String trimmedData = data;
-    trimmedData.trim();
-
     // 检查是否是+CMT: URC的开始
-    if (trimmedData.startsWith("+CMT:")) {
+    if (urc == URC_CMT) {
         isBuffering = true; // 准备接收下一行的PDU数据
         return; // 等待PDU数据行
     }
@@ -22,17 +20,29 @@ void UartDispatcher::process(const String& data) {
     // 如果我们正在等待PDU数据
     if (isBuffering) {
         // 并且当前行不为空（避免处理+CMT和PDU之间的空行）
-        if (trimmedData.length() > 0) {
-            smsHandler.processMessageBlock(trimmedData);
+        if (line.length > 0) {
+            smsHandler.processMessageBlock(line.data, line.length, receivedUs);
             isBuffering = false; // PDU处理完毕，重置状态
         }
     } else {
         // 如果不是在处理PDU，则按常规方式处理其他URC或响应
-        smsHandler.processLine(trimmedData);
+        smsHandler.processLine(line.data, line.length);
     }
     // 其他消息当前仅打印，不作进一步处理。
 }
 
+void UartDispatcher::poll() {
+    smsHandler.flushExpiredConcatenations();
+}
+
+unsigned long UartDispatcher::getPollWaitMs() const {
+    return smsHandler.getMsUntilConcatenationExpiry();
+}
+
+void UartDispatcher::drainStoredMessages() {
+    smsHandler.drainStorage();
+}
+
 void UartDispatcher::setSuppressOutput(bool suppress) {
     suppressOutput = suppress;
 }
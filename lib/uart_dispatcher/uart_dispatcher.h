@@ -2,6 +2,8 @@
 #define UART_DISPATCHER_H
 
 #include <Arduino.h>
+#include "../line_framer/line_framer.h"
+#include "../sms_handler/sms_handler.h"
 
 /**
  * @class UartDispatcher
@@ -9,14 +11,39 @@
  * 
  * 负责处理来自GSM模块的串口数据，包括SMS消息和AT命令响应。
  * 当CLI运行时，会抑制原始数据输出以避免干扰用户交互。
+ * 每个SIM模块一个实例，由该模块的UART监控任务创建。
  */
 class UartDispatcher {
 public:
     /**
-     * @brief 处理串口数据
-     * @param data 接收到的串口数据
+     * @brief 构造函数
+     * @param atHandler 所属SIM模块的AT命令处理器
      */
-    void process(const String& data);
+    explicit UartDispatcher(AtCommandHandler& atHandler);
+
+    /**
+     * @brief 处理一行串口数据
+     * @param line 行视图（已去除首尾空白，以'\0'结尾）
+     * @param urc 行的URC类型（由classifyUrc()识别）
+     * @param receivedUs 仲裁器读到该行的时间（micros，用于统计入库延迟）
+     */
+    void process(const LineView& line, UrcType urc, uint32_t receivedUs);
+
+    /**
+     * @brief 处理定时事务（清理等待超时的长短信分片），在串口空闲时调用
+     */
+    void poll();
+
+    /**
+     * @brief 获取下一次需要调用poll()的等待时间
+     * @return unsigned long 等待时间（毫秒），无需定时处理时返回ULONG_MAX
+     */
+    unsigned long getPollWaitMs() const;
+
+    /**
+     * @brief 批量导入模块存储中积压的短信（如断电或离线期间收到的短信）
+     */
+    void drainStoredMessages();
     
     /**
      * @brief 设置是否抑制原始数据输出
@@ -37,7 +64,7 @@ public:
     bool isBufferingPDU() const;
 
 private:
-    String messageBuffer;           ///< 消息缓冲区
+    SmsHandler smsHandler;          ///< 所属SIM模块的短信处理器
     bool isBuffering = false;       ///< 是否正在缓冲PDU数据
     bool suppressOutput = false;    ///< 是否抑制原始数据输出
 };
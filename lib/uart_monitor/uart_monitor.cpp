@@ -1,73 +1,94 @@
 #include "uart_monitor.h"
-#include "../include/config.h"
 #include "../../include/constants.h"
 #include "uart_dispatcher.h"
-#include "terminal_manager.h"
+#include "../line_framer/line_framer.h"
+#include "../modem_arbiter/modem_arbiter.h"
+#include "../at_command_handler/at_command_handler.h"
+#include <limits.h>
+#include <atomic>
 
-extern HardwareSerial simSerial;
-UartDispatcher dispatcher;
+/**
+ * @brief 单个SIM模块的短信接收状态
+ */
+struct MonitorContext {
+  UartDispatcher* dispatcher;                 // 任务启动时创建
+  std::atomic<QueueHandle_t> queue;           // 任务启动后可用的URC队列
+  std::atomic<bool> drainRequested;           // 是否有待处理的存储导入请求
+  ModemLine wakeup;                           // 唤醒任务用的空行
+  ModemLine item;                             // 行数据较大，放在静态存储区避免占用任务栈
+};
+
+static MonitorContext contexts[MODEM_MAX_COUNT];
+
+void uart_monitor_request_storage_drain(uint8_t modem) {
+  if (modem >= MODEM_MAX_COUNT) {
+    return;
+  }
+  MonitorContext& context = contexts[modem];
+  context.drainRequested.store(true);
+  QueueHandle_t queue = context.queue.load();
+  if (queue == nullptr) {
+    // 任务尚未启动，启动时会先导入一次
+    return;
+  }
+
+  // 空行只用于唤醒任务，不会被当作URC处理
+  context.wakeup.length = 0;
+  context.wakeup.truncated = false;
+  context.wakeup.receivedUs = 0;
+  context.wakeup.data[0] = '\0';
+  xQueueSend(queue, &context.wakeup, 0);
+}
 
 void uart_monitor_task(void *pvParameters) {
-  String buffer = "";
-  bool atCommandMode = false;
-  unsigned long lastAtCommandTime = 0;
-  const unsigned long AT_COMMAND_TIMEOUT = DEFAULT_AT_COMMAND_TIMEOUT_MS; // AT命令超时
-  
+  uint8_t modem = (uint8_t)(uintptr_t)pvParameters;
+  MonitorContext& context = contexts[modem];
+
+  // 串口由调制解调器仲裁器独占读取，这里只消费订阅到的短信相关URC，
+  // 因此短信处理过程中可以放心地通过仲裁器执行AT+CMGR/AT+CNMA等命令
+  ModemArbiter& arbiter = ModemArbiter::getModem(modem);
+  QueueHandle_t urcQueue = ModemArbiter::createLineQueue(MODEM_URC_QUEUE_LENGTH);
+  if (urcQueue == nullptr) {
+    Serial.printf("❌ SIM%d短信URC队列创建失败，UART监控任务退出\n", modem + 1);
+    vTaskDelete(NULL);
+    return;
+  }
+  context.dispatcher = new UartDispatcher(AtCommandHandler::getModem(modem));
+  UartDispatcher& dispatcher = *context.dispatcher;
+
+  // +CMT:与+CBM:的PDU在下一行，需要一并投递
+  arbiter.subscribe("+CMT:", urcQueue, true);
+  arbiter.subscribe("+CMTI:", urcQueue);
+  arbiter.subscribe("+CDSI:", urcQueue);
+  arbiter.subscribe("+CBM:", urcQueue, true);
+
+  // 订阅完成后再导入离线期间积压在模块存储中的短信，期间新到的短信由URC队列缓存
+  context.drainRequested.store(false);
+  context.queue.store(urcQueue);
+  dispatcher.drainStoredMessages();
+
+  ModemLine& item = context.item;
+
   while (1) {
-    // 检查CLI状态
-    TerminalManager& terminalManager = TerminalManager::getInstance();
-    bool cliRunning = terminalManager.isCLIRunning();
-    
-    // 检查是否有AT命令正在执行（通过检测最近是否有AT命令发送）
-    unsigned long currentTime = millis();
-    if (atCommandMode && (currentTime - lastAtCommandTime > AT_COMMAND_TIMEOUT)) {
-      atCommandMode = false; // AT命令超时，退出AT命令模式
+    // 只在最早的长短信分片到期时醒来清理，没有待拼接的短信时一直阻塞，空闲期间可进入浅睡眠
+    unsigned long waitMs = dispatcher.getPollWaitMs();
+    TickType_t waitTicks = waitMs == ULONG_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitMs) + 1;
+    if (xQueueReceive(urcQueue, &item, waitTicks) != pdTRUE) {
+      dispatcher.poll();
+      continue;
     }
-    
-    if (simSerial.available()) {
-        String newData = simSerial.readString();
-        
-        // 检测是否是AT命令响应（包含"AT"开头的命令回显）
-        if (newData.indexOf("AT") != -1 && cliRunning) {
-          atCommandMode = true;
-          lastAtCommandTime = currentTime;
-        }
-        
-        buffer += newData;
-        
-        // 当CLI运行且处于AT命令模式时，抑制输出但仍然处理数据
-        if (cliRunning && atCommandMode) {
-          dispatcher.setSuppressOutput(true);
-        } else {
-          dispatcher.setSuppressOutput(false);
-        }
-        
-        int newlineIndex;
-        while ((newlineIndex = buffer.indexOf('\n')) != -1) {
-            String line = buffer.substring(0, newlineIndex + 1);
-            buffer.remove(0, newlineIndex + 1);
-            
-            // 检查是否是短信相关的URC（+CMT:, +CMTI:等）
-            String trimmedLine = line;
-            trimmedLine.trim();
-            
-            // 短信相关的URC始终需要处理，即使在CLI模式下
-             if (trimmedLine.startsWith("+CMT:") || 
-                 trimmedLine.startsWith("+CMTI:") || 
-                 trimmedLine.startsWith("+CDSI:") ||
-                 trimmedLine.startsWith("+CBM:") ||
-                 (dispatcher.isBufferingPDU() && trimmedLine.length() > 10)) { // PDU数据行
-              // 强制处理短信相关数据，不受CLI状态影响
-              dispatcher.setSuppressOutput(false);
-              dispatcher.process(line);
-            } else if (!cliRunning || !atCommandMode) {
-              // 非AT命令模式或CLI未运行时，正常处理所有数据
-              dispatcher.process(line);
-            }
-            // 在AT命令模式下，非短信相关的数据会被忽略，避免干扰CLI
-        }
+
+    if (item.length == 0) {
+      if (context.drainRequested.exchange(false)) {
+        dispatcher.drainStoredMessages();
+      }
+      continue;
     }
-    
-    vTaskDelay(50 / portTICK_PERIOD_MS); // 增加延时以允许更多数据到达缓冲区
+
+    LineView line;
+    line.data = item.data;
+    line.length = item.length;
+    line.truncated = item.truncated;
+    dispatcher.process(line, classifyUrc(line.data, line.length), item.receivedUs);
   }
 }
\ No newline at end of file
@@ -2,7 +2,23 @@
 #define UART_MONITOR_H
 
 
+#include <stdint.h>
 
+/**
+ * @brief UART监控任务：从调制解调器仲裁器订阅短信相关URC并分发给短信处理器
+ *
+ * 每个SIM模块一个任务，各自拥有短信处理器（长短信拼接、去重状态互不影响）
+ * @param pvParameters SIM模块序号（以指针传入，0为主模块）
+ */
 void uart_monitor_task(void *pvParameters);
 
-#endif // UART_MONITOR_H
\ No newline at end of file
+/**
+ * @brief 请求UART监控任务重新导入模块存储中的短信（可在任意任务中调用）
+ *
+ * 用于开机时GSM初始化晚于短信接收启动的情况：新消息指示（AT+CNMI）配置完成前
+ * 到达的短信只存入模块存储而不上报URC，配置完成后需再导入一次
+ * @param modem SIM模块序号（0为主模块）
+ */
+void uart_monitor_request_storage_drain(uint8_t modem = 0);
+
+#endif // UART_MONITOR_H
@@ -28,6 +28,9 @@ form button { margin-top: 1.5rem; }
 .pagination a:hover:not(.active) { background-color: #ddd; }
 .pagination a.disabled { color: #ccc; cursor: not-allowed; pointer-events: none; }
 .sms-content { max-width: 400px; word-wrap: break-word; }
+.sms-trace-row td { background: #f8f9fa; font-size: 0.85rem; }
+.sms-trace-stage { white-space: nowrap; }
+.log-view { background: #1e1e1e; color: #d4d4d4; padding: 1rem; border-radius: 4px; max-height: 70vh; overflow: auto; white-space: pre-wrap; word-wrap: break-word; font-size: 0.85rem; }
 .docs-container { background-color: #fff; padding: 1rem; border-radius: 8px; margin-top: 1rem; }
 .docs-container pre { white-space: pre-wrap; word-wrap: break-word; font-family: "SFMono-Regular", Consolas, "Liberation Mono", Menlo, Courier, monospace; font-size: 0.9rem; color: #333; }
 .form-group { margin-bottom: 1rem; }
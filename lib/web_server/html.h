@@ -50,11 +50,16 @@ const char HTML_CONTENT[] PROGMEM = R"rawliteral(
                 <label for="push-config">推送配置 (JSON):</label>
                 <textarea id="push-config" rows="6" required></textarea>
 
+                <label for="priority">优先级 (0-1000，越小越先推送，验证码规则可设为0):</label>
+                <input type="number" id="priority" min="0" max="1000" value="100">
+
                 <label><input type="checkbox" id="enabled"> 启用</label>
                 <label><input type="checkbox" id="is-default-forward"> 默认转发</label>
 
                 <button type="submit">保存</button>
+                <button type="button" onclick="backtestRule()">回测历史短信</button>
             </form>
+            <div id="backtest-result"></div>
         </div>
     </div>
 
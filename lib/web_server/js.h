@@ -4,12 +4,86 @@
 const char JS_CONTENT[] PROGMEM = R"rawliteral(
 let currentRules = [];
 const SMS_PAGE_SIZE = 20;
+let smsPageCursors = {};
+let currentPage = null;
+let currentSmsPage = 1;
+let lastHealth = null;
 
 window.onload = () => {
     showPage('rules');
+    connectEvents();
 };
 
+// 订阅设备事件流：新短信、推送结果与系统状态由设备主动推送，无需轮询
+function connectEvents() {
+    if (!window.EventSource) return;
+    const source = new EventSource('/api/events');
+    source.addEventListener('sms', e => onSmsEvent(JSON.parse(e.data)));
+    source.addEventListener('push', e => onPushEvent(JSON.parse(e.data)));
+    source.addEventListener('health', e => onHealthEvent(JSON.parse(e.data)));
+}
+
+function renderSmsRow(sms) {
+    return `<tr data-sms-id="${sms.id}">
+                <td>${sms.id}</td>
+                <td>${sms.from}</td>
+                <td class="sms-content">${sms.content}</td>
+                <td>${new Date(sms.received_at * 1000).toLocaleString()}</td>
+                <td class="sms-status">${sms.status}</td>
+                <td><a href="#" onclick="toggleSmsTrace(${sms.id}); return false;">耗时</a></td>
+            </tr>`;
+}
+
+// 展开/收起短信的链路追踪：各阶段距PDU到达的毫秒数
+async function toggleSmsTrace(smsId) {
+    const row = document.querySelector(`tr[data-sms-id="${smsId}"]`);
+    if (!row) return;
+    const next = row.nextElementSibling;
+    if (next && next.classList.contains('sms-trace-row')) {
+        next.remove();
+        return;
+    }
+    let html;
+    try {
+        const response = await fetch(`/api/sms_trace?id=${smsId}`);
+        if (!response.ok) {
+            html = '没有追踪记录（仅记录本次启动后收到并推送的短信）';
+        } else {
+            const data = await response.json();
+            let previous = 0;
+            html = data.stages.map(s => {
+                const step = s.offset_ms - previous;
+                previous = s.offset_ms;
+                return `<span class="sms-trace-stage">${s.name} <b>+${s.offset_ms}ms</b> (${step}ms)</span>`;
+            }).join(' → ');
+            if (data.truncated) html += ' …';
+        }
+    } catch (error) {
+        html = '加载追踪失败';
+    }
+    row.insertAdjacentHTML('afterend', `<tr class="sms-trace-row"><td colspan="${row.cells.length}">${html}</td></tr>`);
+}
+
+function onSmsEvent(sms) {
+    if (currentPage !== 'sms_history' || currentSmsPage !== 1) return;
+    const body = document.getElementById('sms-table-body');
+    if (!body) return;
+    body.insertAdjacentHTML('afterbegin', renderSmsRow(sms));
+    while (body.rows.length > SMS_PAGE_SIZE) body.deleteRow(body.rows.length - 1);
+}
+
+function onPushEvent(push) {
+    const row = document.querySelector(`tr[data-sms-id="${push.sms_id}"] .sms-status`);
+    if (row) row.textContent = push.status;
+}
+
+function onHealthEvent(health) {
+    lastHealth = health;
+    if (currentPage === 'status') renderStatus();
+}
+
 function showPage(page) {
+    currentPage = page;
     const content = document.getElementById('content');
     content.innerHTML = '<h2>加载中...</h2>';
     if (page === 'rules') {
@@ -151,18 +225,18 @@ async function loadRules() {
 async function loadSmsHistory(page = 1) {
     const content = document.getElementById('content');
     try {
-        const response = await fetch(`/api/sms_history?page=${page}&limit=${SMS_PAGE_SIZE}`);
+        // 已知游标的页按游标定位，其余页号退回偏移分页
+        if (page === 1) smsPageCursors = {};
+        currentSmsPage = page;
+        const cursor = smsPageCursors[page];
+        const query = cursor ? `before_id=${cursor.before_id}&before_ts=${cursor.before_ts}` : `page=${page}`;
+        const response = await fetch(`/api/sms_history?${query}&limit=${SMS_PAGE_SIZE}`);
         const data = await response.json();
+        if (data.next) smsPageCursors[page + 1] = data.next;
         let html = '<h2>短信历史</h2>';
-        html += '<table><thead><tr><th>ID</th><th>发送方</th><th>内容</th><th>接收时间</th><th>状态</th></tr></thead><tbody>';
+        html += '<table><thead><tr><th>ID</th><th>发送方</th><th>内容</th><th>接收时间</th><th>状态</th><th>追踪</th></tr></thead><tbody id="sms-table-body">';
         data.records.forEach(sms => {
-            html += `<tr>
-                <td>${sms.id}</td>
-                <td>${sms.from}</td>
-                <td class="sms-content">${sms.content}</td>
-                <td>${new Date(sms.received_at * 1000).toLocaleString()}</td>
-                <td>${sms.status}</td>
-            </tr>`;
+            html += renderSmsRow(sms);
         });
         html += '</tbody></table>';
         html += renderPagination(page, data.total, SMS_PAGE_SIZE, 'loadSmsHistory');
@@ -216,6 +290,7 @@ function openModal(ruleId = null) {
     const form = document.getElementById('rule-form');
     form.reset();
     document.getElementById('rule-id').value = '';
+    document.getElementById('backtest-result').innerHTML = '';
 
     loadPushChannels().then(() => {
         if (ruleId) {
@@ -230,6 +305,7 @@ function openModal(ruleId = null) {
                 document.getElementById('push-config').value = rule.push_config;
                 document.getElementById('enabled').checked = rule.enabled;
                 document.getElementById('is-default-forward').checked = rule.is_default_forward;
+                document.getElementById('priority').value = rule.priority;
             }
         } else {
             document.getElementById('modal-title').innerText = '添加规则';
@@ -251,7 +327,8 @@ async function saveRule() {
         push_type: document.getElementById('push-type').value,
         push_config: document.getElementById('push-config').value,
         enabled: document.getElementById('enabled').checked,
-        is_default_forward: document.getElementById('is-default-forward').checked
+        is_default_forward: document.getElementById('is-default-forward').checked,
+        priority: parseInt(document.getElementById('priority').value, 10)
     };
 
     const isUpdate = !!ruleId;
@@ -283,6 +360,52 @@ async function saveRule() {
     return false;
 }
 
+// 用表单中（可能尚未保存）的号码与关键词检查历史短信，显示命中数与最新的命中样例
+async function backtestRule() {
+    const result = document.getElementById('backtest-result');
+    result.innerHTML = '<p>回测中...</p>';
+    const rule = {
+        source_number: document.getElementById('source-number').value,
+        keywords: document.getElementById('keywords').value,
+        is_default_forward: document.getElementById('is-default-forward').checked
+    };
+
+    try {
+        const response = await fetch('/api/rules/backtest', {
+            method: 'POST',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify(rule)
+        });
+        if (!response.ok) {
+            result.innerHTML = `<p>回测失败: ${await response.text()}</p>`;
+            return;
+        }
+        const data = await response.json();
+        const summary = data.summary;
+        let html = `<p>检查 ${summary.examined} / ${summary.total} 条短信${data.prefiltered ? '（全文索引预筛选）' : ''}，`;
+        html += `命中 ${summary.matched} 条，耗时 ${summary.elapsed_ms} ms`;
+        if (summary.limit_reached) html += '，已达检查上限，更早的短信未检查';
+        html += '</p>';
+        if (summary.error) html += `<p>读取中断: ${summary.error}</p>`;
+        if (data.samples.length > 0) {
+            html += '<table><thead><tr><th>ID</th><th>发送方</th><th>内容</th><th>接收时间</th></tr></thead><tbody>';
+            data.samples.forEach(sms => {
+                html += `<tr>
+                    <td>${sms.id}</td>
+                    <td>${sms.from}</td>
+                    <td class="sms-content">${sms.content}</td>
+                    <td>${new Date(sms.received_at * 1000).toLocaleString()}</td>
+                </tr>`;
+            });
+            html += '</tbody></table>';
+        }
+        result.innerHTML = html;
+    } catch (error) {
+        console.error('回测规则时出错:', error);
+        result.innerHTML = '<p>回测时发生错误。</p>';
+    }
+}
+
 async function deleteRule(ruleId) {
     if (!confirm('您确定要删除此规则吗？')) return;
 
@@ -304,8 +427,57 @@ async function deleteRule(ruleId) {
     }
 }
 
-function loadLogs() { document.getElementById('content').innerHTML = '<h2>系统日志</h2><p>此功能待实现。</p>'; }
-function loadStatus() { document.getElementById('content').innerHTML = '<h2>系统状态</h2><p>此功能待实现。</p>'; }
+let logNextSeq = null;
+
+async function loadLogs() {
+    const content = document.getElementById('content');
+    logNextSeq = null;
+    content.innerHTML = '<h2>系统日志</h2><p><button onclick="fetchLogs()">加载更新</button></p><pre id="log-view" class="log-view"></pre>';
+    await fetchLogs();
+}
+
+// 按序号增量拉取：只取上次之后的新日志
+async function fetchLogs() {
+    const view = document.getElementById('log-view');
+    if (!view) return;
+    try {
+        const query = logNextSeq === null ? '' : `?since=${logNextSeq}`;
+        const response = await fetch(`/api/logs${query}`);
+        const data = await response.json();
+        if (!data.available) {
+            view.textContent = '设备未启用内存日志缓冲区';
+            return;
+        }
+        let text = '';
+        if (data.lost > 0) text += `... 已丢失 ${data.lost} 条日志 ...\n`;
+        data.entries.forEach(e => {
+            const time = e.time ? new Date(e.time * 1000).toLocaleString() : `+${(e.uptime_ms / 1000).toFixed(3)}s`;
+            text += `[${time}] [${e.level}] [${e.module}] ${e.message}\n`;
+        });
+        view.textContent += text;
+        logNextSeq = data.next;
+    } catch (error) {
+        console.error('加载日志失败:', error);
+    }
+}
+function loadStatus() { renderStatus(); }
+
+function renderStatus() {
+    const content = document.getElementById('content');
+    if (!lastHealth) {
+        content.innerHTML = '<h2>系统状态</h2><p>等待设备推送状态...</p>';
+        return;
+    }
+    const h = lastHealth;
+    content.innerHTML = `<h2>系统状态</h2>
+        <table><tbody>
+            <tr><td>运行时间</td><td>${Math.floor(h.uptime_s / 3600)}小时${Math.floor(h.uptime_s % 3600 / 60)}分</td></tr>
+            <tr><td>可用堆内存</td><td>${h.free_heap} 字节（最低 ${h.min_free_heap}）</td></tr>
+            <tr><td>可用PSRAM</td><td>${h.free_psram} 字节</td></tr>
+            <tr><td>AP客户端</td><td>${h.ap_clients}</td></tr>
+            <tr><td>事件流客户端</td><td>${h.event_clients}</td></tr>
+        </tbody></table>`;
+}
 
 function loadDatabase() {
     const content = document.getElementById('content');
@@ -1,14 +1,33 @@
 #include "web_server.h"
 #include <ESPAsyncWebServer.h>
 #include "../database_manager/database_manager.h"
+#include "../../include/constants.h"
 #include <ArduinoJson.h>
+#include <memory>
+#include <functional>
+#include <esp_heap_caps.h>
 #include "html.h"
 #include "css.h"
 #include "js.h"
+#if __has_include("web_assets_gz.h")
+#include "web_assets_gz.h"
+#define WEB_ASSETS_GZIP 1
+#endif
 #include "ap_html.h"
 #include "docs_guide.h"
 #include "../wifi_manager_web/wifi_manager_web.h"
 #include "../push_manager/push_channel_registry.h"
+#include "../push_manager/push_manager.h"
+#include "../push_manager/number_set.h"
+#include "../push_manager/rule_backtest.h"
+#include "../event_bus/event_bus.h"
+#include "../log_manager/log_manager.h"
+#include "../log_manager/log_ring.h"
+#include "../metrics/metrics.h"
+#include "../sms_trace/sms_trace.h"
+#include "../gsm_service/gsm_service.h"
+#include "../db_worker/db_worker.h"
+#include "../filesystem_manager/filesystem_manager.h"
 
 // --- Singleton Instance ---
 WebServer& WebServer::getInstance() {
@@ -17,20 +36,83 @@ WebServer& WebServer::getInstance() {
 }
 
 // --- Constructor & Destructor ---
-WebServer::WebServer() : server(new AsyncWebServer(80)) {}
+WebServer::WebServer()
+    : server(new AsyncWebServer(80)), events(new AsyncEventSource("/api/events")), eventSubscription(0),
+      running(false), paused(false) {}
 
 WebServer::~WebServer() {
+    if (eventSubscription != 0) {
+        EventBus::getInstance().unsubscribe(eventSubscription);
+    }
     delete server;
+    delete events;
 }
 
 // --- Public Methods ---
 void WebServer::start() {
     setupRoutes();
     server->begin();
+    running = true;
+    paused = false;
+
+    // Forward application events (new SMS, push results) to the event stream
+    if (eventSubscription == 0) {
+        AsyncEventSource* stream = events;
+        eventSubscription = EventBus::getInstance().subscribe([stream](const char* type, const String& data) {
+            if (stream->count() > 0) {
+                stream->send(data.c_str(), type, millis());
+            }
+        });
+    }
 }
 
 void WebServer::stop() {
+    if (eventSubscription != 0) {
+        EventBus::getInstance().unsubscribe(eventSubscription);
+        eventSubscription = 0;
+    }
+    server->end();
+    running = false;
+    paused = false;
+}
+
+void WebServer::pause() {
+    if (!running || paused) {
+        return;
+    }
+    // Closes event stream clients and the listener; routes stay registered
+    events->close();
     server->end();
+    paused = true;
+}
+
+void WebServer::resume() {
+    if (!running || !paused) {
+        return;
+    }
+    server->begin();
+    paused = false;
+}
+
+bool WebServer::isPaused() const {
+    return paused;
+}
+
+void WebServer::publishHealth() {
+    if (events->count() == 0) {
+        return;
+    }
+    JsonDocument doc;
+    doc["uptime_s"] = millis() / 1000;
+    doc["free_heap"] = ESP.getFreeHeap();
+    doc["min_free_heap"] = ESP.getMinFreeHeap();
+    doc["free_psram"] = ESP.getFreePsram();
+    doc["ap_clients"] = WiFi.softAPgetStationNum();
+    doc["event_clients"] = events->count();
+    doc["log_dropped"] = LogManager::getInstance().getDroppedCount();
+    String data;
+    serializeJson(doc, data);
+    events->send(data.c_str(), EVENT_TYPE_HEALTH, millis());
 }
 
 // --- Route Setup ---
@@ -42,14 +124,32 @@ void WebServer::setupRoutes() {
     server->on("/api/wifi/ap_settings", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleUpdateAPSettings);
     server->on("/api/rules/update", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleUpdateRule);
     server->on("/api/rules/delete", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleDeleteRule);
+    server->on("/api/rules/backtest", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleBacktestRule);
+    server->on("/api/number_lists/import", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleImportNumberList);
+    server->on("/api/number_lists/delete", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleDeleteNumberList);
+    server->on("/api/backup/download", HTTP_GET, WebServer::handleDownloadBackup);
     
     // API routes - medium length paths
     server->on("/api/push_channels", HTTP_GET, WebServer::handleGetPushChannels);
     server->on("/api/sms_history", HTTP_GET, WebServer::handleGetSmsHistory);
+    server->on("/api/sms_search", HTTP_GET, WebServer::handleSearchSms);
+    server->on("/api/sms_trace", HTTP_GET, WebServer::handleGetSmsTrace);
     server->on("/api/rules", HTTP_GET, WebServer::handleGetRules);
     server->on("/api/rules", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, WebServer::handleAddRule);
     server->on("/api/reboot", HTTP_POST, WebServer::handleReboot);
     server->on("/api/logs", HTTP_GET, WebServer::handleGetLogs);
+    server->on("/api/metrics", HTTP_GET, WebServer::handleGetMetrics);
+    server->on("/api/modem_status", HTTP_GET, WebServer::handleGetModemStatus);
+    server->on("/api/export", HTTP_GET, WebServer::handleExportSms);
+    server->on("/api/backup", HTTP_GET, WebServer::handleGetBackupStatus);
+    server->on("/api/backup", HTTP_POST, WebServer::handleStartBackup);
+    server->on("/api/number_lists", HTTP_GET, WebServer::handleGetNumberLists);
+
+    // Live events (SSE) - replaces polling for new SMS and push results
+    events->onConnect([](AsyncEventSourceClient *client) {
+        client->send("{}", "hello", millis(), WEB_EVENTS_RETRY_MS);
+    });
+    server->addHandler(events);
     
     // Static content - shorter paths
     server->on("/style.css", HTTP_GET, WebServer::handleStyle);
@@ -61,17 +161,246 @@ void WebServer::setupRoutes() {
     server->onNotFound(WebServer::handleNotFound);
 }
 
+// --- Streaming JSON ---
+// Chunked response body produced piece by piece. The producer appends the next
+// piece (e.g. one batch of rows) to `out` and returns false once it has
+// emitted the last one, so only a single batch is held in memory at a time.
+// Producers run on the database worker, never on the AsyncTCP task: the fill
+// callback waits at most WEB_DB_INLINE_WAIT_MS for a piece and otherwise
+// returns RESPONSE_TRY_AGAIN so the network stack keeps running.
+namespace {
+
+typedef std::function<bool(String& out)> JsonChunkProducer;
+
+struct JsonChunkState {
+    JsonChunkProducer produce;
+    String pending;
+    size_t offset = 0;
+    bool finished = false;
+    std::shared_ptr<DbRequest> inflight;    // Piece being produced on the worker
+    String piece;                           // Written by the worker, read once inflight is done
+    bool more = false;
+};
+
+AsyncWebServerResponse* beginJsonStream(AsyncWebServerRequest *request, JsonChunkProducer produce,
+                                        const char* contentType = "application/json") {
+    std::shared_ptr<JsonChunkState> state = std::make_shared<JsonChunkState>();
+    state->produce = produce;
+    return request->beginChunkedResponse(contentType,
+        [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            while (!state->finished && state->pending.length() - state->offset < maxLen) {
+                if (!state->inflight) {
+                    std::shared_ptr<JsonChunkState> shared = state;
+                    state->inflight = DbWorker::getInstance().post([shared]() {
+                        shared->more = shared->produce(shared->piece);
+                    });
+                }
+                if (!state->inflight || !state->inflight->wait(WEB_DB_INLINE_WAIT_MS)) {
+                    // Worker queue full or piece not ready yet: send what we have, or retry later
+                    break;
+                }
+                state->inflight.reset();
+                if (state->offset > 0) {
+                    state->pending.remove(0, state->offset);
+                    state->offset = 0;
+                }
+                state->pending += state->piece;
+                state->piece = "";
+                state->finished = !state->more;
+            }
+            size_t available = state->pending.length() - state->offset;
+            if (available == 0 && !state->finished) {
+                return RESPONSE_TRY_AGAIN;
+            }
+            size_t count = available < maxLen ? available : maxLen;
+            memcpy(buffer, state->pending.c_str() + state->offset, count);
+            state->offset += count;
+            return count;
+        });
+}
+
+// Runs a database call from a handler that has to pick the status code from
+// its outcome. The AsyncTCP task waits at most WEB_DB_CALL_TIMEOUT_MS for the
+// worker to start it; false means it was not run and the caller answers 503.
+bool callDatabase(std::function<void()> job) {
+    return DbWorker::getInstance().call(job, WEB_DB_CALL_TIMEOUT_MS);
+}
+
+void sendDatabaseBusy(AsyncWebServerRequest *request) {
+    request->send(HTTP_STATUS_SERVICE_UNAVAILABLE, "text/plain", "Database busy, try again");
+}
+
+void appendJson(String& out, JsonDocument& doc) {
+    String piece;
+    serializeJson(doc, piece);
+    out += piece;
+}
+
+void appendSmsRecord(String& out, const SMSRecord& record, bool first) {
+    JsonDocument doc;
+    doc["id"] = record.id;
+    doc["from"] = record.fromNumber;
+    doc["content"] = record.content;
+    doc["received_at"] = record.receivedAt;
+    doc["status"] = record.status;
+    if (!first) {
+        out += ',';
+    }
+    appendJson(out, doc);
+}
+
+// One NDJSON line per record with every column, for off-device archival
+void appendSmsExportLine(String& out, const SMSRecord& record) {
+    JsonDocument doc;
+    doc["id"] = record.id;
+    doc["from"] = record.fromNumber;
+    doc["to"] = record.toNumber;
+    doc["content"] = record.content;
+    doc["rule_id"] = record.ruleId;
+    doc["forwarded"] = record.forwarded;
+    doc["status"] = record.status;
+    doc["forwarded_at"] = record.forwardedAt;
+    doc["received_at"] = record.receivedAt;
+    appendJson(out, doc);
+    out += '\n';
+}
+
+void appendBacktestSample(String& out, const RuleBacktestSample& sample, bool first) {
+    JsonDocument doc;
+    doc["id"] = sample.id;
+    doc["from"] = sample.fromNumber;
+    doc["content"] = sample.content;
+    doc["received_at"] = sample.receivedAt;
+    if (!first) {
+        out += ',';
+    }
+    appendJson(out, doc);
+}
+
+void appendForwardRule(String& out, const ForwardRule& rule, bool first) {
+    JsonDocument doc;
+    doc["id"] = rule.id;
+    doc["rule_name"] = rule.ruleName;
+    doc["source_number"] = rule.sourceNumber;
+    doc["keywords"] = rule.keywords;
+    doc["push_type"] = rule.pushType;
+    doc["push_config"] = rule.pushConfig;
+    doc["enabled"] = rule.enabled;
+    doc["is_default_forward"] = rule.isDefaultForward;
+    doc["priority"] = rule.priority;
+    if (!first) {
+        out += ',';
+    }
+    appendJson(out, doc);
+}
+
+// Number list names end up in rule patterns ("list:<name>"), so keep them to
+// a plain identifier alphabet
+bool isValidNumberListName(const String& name) {
+    if (name.isEmpty() || name.length() > NUMBER_LIST_NAME_MAX_LENGTH) {
+        return false;
+    }
+    for (size_t i = 0; i < name.length(); i++) {
+        char ch = name[i];
+        if (!isalnum((unsigned char)ch) && ch != '_' && ch != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Normalizes numbers separated by newlines, commas or semicolons into `out`
+// as '\n'-separated E.164 numbers; returns how many were written
+int normalizeNumberList(const char* text, char* out, size_t outSize, int& invalid) {
+    int count = 0;
+    size_t used = 0;
+    char token[NUMBER_LIST_MAX_NUMBER_LENGTH * 2];
+    char normalized[NUMBER_LIST_MAX_NUMBER_LENGTH];
+    invalid = 0;
+    out[0] = '\0';
+    while (*text != '\0') {
+        size_t length = strcspn(text, "\n,;");
+        const char* begin = text;
+        const char* end = text + length;
+        while (begin < end && isspace((unsigned char)*begin)) begin++;
+        while (end > begin && isspace((unsigned char)*(end - 1))) end--;
+        if (end > begin) {
+            size_t tokenLength = end - begin;
+            bool ok = tokenLength < sizeof(token);
+            if (ok) {
+                memcpy(token, begin, tokenLength);
+                token[tokenLength] = '\0';
+                ok = NumberSet::normalize(token, normalized, sizeof(normalized));
+            }
+            size_t normalizedLength = ok ? strlen(normalized) : 0;
+            if (ok && used + normalizedLength + 2 <= outSize) {
+                memcpy(out + used, normalized, normalizedLength);
+                used += normalizedLength;
+                out[used++] = '\n';
+                out[used] = '\0';
+                count++;
+            } else {
+                invalid++;
+            }
+        }
+        text += length;
+        if (*text != '\0') {
+            text++;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
 // --- Handlers Implementation ---
+#ifdef WEB_ASSETS_GZIP
+// Serve a pre-compressed asset with a strong ETag; revalidation with a
+// matching If-None-Match gets an empty 304
+static void sendCompressedAsset(AsyncWebServerRequest *request, const char *contentType,
+                                const uint8_t *content, size_t length, const char *etag,
+                                const String& cacheControl) {
+    if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", cacheControl);
+        request->send(response);
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse_P(200, contentType, content, length);
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+}
+#endif
+
 void WebServer::handleRoot(AsyncWebServerRequest *request) {
+#ifdef WEB_ASSETS_GZIP
+    // The page itself is always revalidated; it pins the versioned CSS/JS URLs
+    sendCompressedAsset(request, "text/html", HTML_CONTENT_GZ, HTML_CONTENT_GZ_LEN,
+                        HTML_CONTENT_ETAG, "no-cache");
+#else
     request->send_P(200, "text/html", HTML_CONTENT);
+#endif
 }
 
 void WebServer::handleStyle(AsyncWebServerRequest *request) {
+#ifdef WEB_ASSETS_GZIP
+    sendCompressedAsset(request, "text/css", CSS_CONTENT_GZ, CSS_CONTENT_GZ_LEN,
+                        CSS_CONTENT_ETAG, "public, max-age=" + String(WEB_ASSET_MAX_AGE_S) + ", immutable");
+#else
     request->send_P(200, "text/css", CSS_CONTENT);
+#endif
 }
 
 void WebServer::handleScript(AsyncWebServerRequest *request) {
+#ifdef WEB_ASSETS_GZIP
+    sendCompressedAsset(request, "application/javascript", JS_CONTENT_GZ, JS_CONTENT_GZ_LEN,
+                        JS_CONTENT_ETAG, "public, max-age=" + String(WEB_ASSET_MAX_AGE_S) + ", immutable");
+#else
     request->send_P(200, "application/javascript", JS_CONTENT);
+#endif
 }
 
 void WebServer::handleGetDocsGuide(AsyncWebServerRequest *request) {
@@ -85,33 +414,40 @@ void WebServer::handleGetPushChannels(AsyncWebServerRequest *request) {
     for (const String& channel : channels) {
         array.add(channel);
     }
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+    // Serialize straight into the response buffer instead of an intermediate String
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
 }
 
 void WebServer::handleGetRules(AsyncWebServerRequest *request) {
-    DatabaseManager& dbManager = DatabaseManager::getInstance();
-    std::vector<ForwardRule> rules = dbManager.getAllForwardRules();
-
-    JsonDocument doc;
-    JsonArray array = doc.to<JsonArray>();
+    // Rules are read in id order, one batch per chunk
+    struct RulesCursor {
+        int offset = 0;
+        bool opened = false;
+        bool done = false;
+    };
+    std::shared_ptr<RulesCursor> cursor = std::make_shared<RulesCursor>();
 
-    for (const auto& rule : rules) {
-        JsonObject ruleObj = array.add<JsonObject>();
-        ruleObj["id"] = rule.id;
-        ruleObj["rule_name"] = rule.ruleName;
-        ruleObj["source_number"] = rule.sourceNumber;
-        ruleObj["keywords"] = rule.keywords;
-        ruleObj["push_type"] = rule.pushType;
-        ruleObj["push_config"] = rule.pushConfig;
-        ruleObj["enabled"] = rule.enabled;
-        ruleObj["is_default_forward"] = rule.isDefaultForward;
-    }
-
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+    request->send(beginJsonStream(request, [cursor](String& out) {
+        if (!cursor->opened) {
+            cursor->opened = true;
+            out += '[';
+            return true;
+        }
+        if (cursor->done) {
+            out += ']';
+            return false;
+        }
+        std::vector<ForwardRule> rules = DatabaseManager::getInstance()
+            .getForwardRules(-1, "", WEB_STREAM_BATCH_ROWS, cursor->offset);
+        for (size_t i = 0; i < rules.size(); i++) {
+            appendForwardRule(out, rules[i], cursor->offset == 0 && i == 0);
+        }
+        cursor->offset += rules.size();
+        cursor->done = (int)rules.size() < WEB_STREAM_BATCH_ROWS;
+        return true;
+    }));
 }
 
 void WebServer::handleGetSmsHistory(AsyncWebServerRequest *request) {
@@ -124,24 +460,270 @@ void WebServer::handleGetSmsHistory(AsyncWebServerRequest *request) {
     if (request->hasParam("limit")) {
         limit = request->getParam("limit")->value().toInt();
     }
+    if (page < 1) {
+        page = 1;
+    }
+    if (limit < 1 || limit > MAX_QUERY_LIMIT) {
+        limit = 20;
+    }
+
+    // The page is streamed in batches: the first batch is located by the
+    // request's cursor (or offset), later ones seek from the last row sent
+    struct HistoryCursor {
+        int remaining;
+        int offset;
+        time_t beforeTs;
+        int beforeId;
+        bool keyset;
+        bool opened = false;
+        int sent = 0;
+    };
+    std::shared_ptr<HistoryCursor> cursor = std::make_shared<HistoryCursor>();
+    cursor->remaining = limit;
+    cursor->offset = 0;
+    cursor->beforeTs = 0;
+    cursor->beforeId = 0;
+    cursor->keyset = true;
+    if (request->hasParam("before_id") && request->hasParam("before_ts")) {
+        // Cursor paging: seek from the last record of the previous page
+        cursor->beforeId = request->getParam("before_id")->value().toInt();
+        cursor->beforeTs = (time_t)request->getParam("before_ts")->value().toInt();
+    } else if (page > 1) {
+        cursor->offset = (page - 1) * limit;
+        cursor->keyset = false;
+    }
+
+    request->send(beginJsonStream(request, [cursor, limit](String& out) {
+        if (!cursor->opened) {
+            cursor->opened = true;
+            out += "{\"total\":";
+            out += String(DatabaseManager::getInstance().getSMSRecordCount());
+            out += ",\"records\":[";
+            return true;
+        }
+        if (cursor->remaining <= 0) {
+            out += ']';
+            // A full page may have more records behind it
+            if (cursor->sent == limit) {
+                out += ",\"next\":{\"before_id\":";
+                out += String(cursor->beforeId);
+                out += ",\"before_ts\":";
+                out += String((long)cursor->beforeTs);
+                out += '}';
+            }
+            out += '}';
+            return false;
+        }
 
-    int offset = (page - 1) * limit;
+        DatabaseManager& dbManager = DatabaseManager::getInstance();
+        int batch = cursor->remaining < WEB_STREAM_BATCH_ROWS ? cursor->remaining : WEB_STREAM_BATCH_ROWS;
+        std::vector<SMSRecord> records = cursor->keyset
+            ? dbManager.getSMSRecordsBefore(cursor->beforeTs, cursor->beforeId, batch)
+            : dbManager.getSMSRecords(batch, cursor->offset);
+        for (const auto& record : records) {
+            appendSmsRecord(out, record, cursor->sent == 0);
+            cursor->sent++;
+        }
+        if (!records.empty()) {
+            cursor->beforeId = records.back().id;
+            cursor->beforeTs = records.back().receivedAt;
+            cursor->keyset = true;
+        }
+        cursor->remaining = (int)records.size() < batch ? 0 : cursor->remaining - batch;
+        return true;
+    }));
+}
 
-    DatabaseManager& dbManager = DatabaseManager::getInstance();
-    std::vector<SMSRecord> records = dbManager.getSMSRecords(limit, offset);
-    int totalRecords = dbManager.getSMSRecordCount();
+void WebServer::handleSearchSms(AsyncWebServerRequest *request) {
+    if (!request->hasParam("q")) {
+        request->send(400, "text/plain", "Missing query parameter 'q'");
+        return;
+    }
+    String query = request->getParam("q")->value();
+    query.trim();
+    if (query.isEmpty()) {
+        request->send(400, "text/plain", "Query must not be empty");
+        return;
+    }
 
+    int limit = 20;
+    if (request->hasParam("limit")) {
+        limit = request->getParam("limit")->value().toInt();
+    }
+    if (limit < 1 || limit > MAX_QUERY_LIMIT) {
+        limit = 20;
+    }
+
+    // Full-text search can take a while; the whole body is built on the database worker
+    request->send(beginJsonStream(request, [query, limit](String& out) {
+        std::vector<SMSRecord> records = DatabaseManager::getInstance().searchSMS(query, limit);
+
+        JsonDocument doc;
+        doc["query"] = query;
+        doc["count"] = records.size();
+        JsonArray recordsArray = doc["records"].to<JsonArray>();
+
+        for (const auto& record : records) {
+            JsonObject recordObj = recordsArray.add<JsonObject>();
+            recordObj["id"] = record.id;
+            recordObj["from"] = record.fromNumber;
+            recordObj["content"] = record.content;
+            recordObj["received_at"] = record.receivedAt;
+            recordObj["status"] = record.status;
+        }
+        appendJson(out, doc);
+        return false;
+    }));
+}
+
+// GET /api/export?since_id=<id>[&limit=<n>]
+// Incremental export: records with id > since_id in id order, one JSON
+// object per line (NDJSON). The archiver keeps the last id it received as
+// its watermark; fewer than `limit` lines means it has caught up. Rows are
+// read in WEB_STREAM_BATCH_ROWS batches on the database worker, interleaved
+// with ingestion writes.
+void WebServer::handleExportSms(AsyncWebServerRequest *request) {
+    int sinceId = 0;
+    int limit = WEB_EXPORT_MAX_ROWS;
+    if (request->hasParam("since_id")) {
+        sinceId = request->getParam("since_id")->value().toInt();
+    }
+    if (request->hasParam("limit")) {
+        limit = request->getParam("limit")->value().toInt();
+    }
+    if (sinceId < 0 || limit < 1 || limit > WEB_EXPORT_MAX_ROWS) {
+        request->send(HTTP_STATUS_BAD_REQUEST, "text/plain",
+                      "since_id must be >= 0 and limit 1-" + String(WEB_EXPORT_MAX_ROWS));
+        return;
+    }
+
+    struct ExportCursor {
+        int afterId;
+        int remaining;
+    };
+    std::shared_ptr<ExportCursor> cursor = std::make_shared<ExportCursor>();
+    cursor->afterId = sinceId;
+    cursor->remaining = limit;
+
+    request->send(beginJsonStream(request, [cursor](String& out) {
+        int batch = cursor->remaining < WEB_STREAM_BATCH_ROWS ? cursor->remaining : WEB_STREAM_BATCH_ROWS;
+        std::vector<SMSRecord> records = DatabaseManager::getInstance().getSMSRecordsAfterId(cursor->afterId, batch);
+        for (const auto& record : records) {
+            appendSmsExportLine(out, record);
+        }
+        if (!records.empty()) {
+            cursor->afterId = records.back().id;
+        }
+        cursor->remaining -= (int)records.size();
+        return (int)records.size() == batch && cursor->remaining > 0;
+    }, "application/x-ndjson"));
+}
+
+// GET /api/backup: progress of the online backup and outcome of the last one
+void WebServer::handleGetBackupStatus(AsyncWebServerRequest *request) {
+    DbBackupStatus status;
+    if (!callDatabase([&]() { status = DatabaseManager::getInstance().getBackupStatus(); })) {
+        sendDatabaseBusy(request);
+        return;
+    }
     JsonDocument doc;
-    doc["total"] = totalRecords;
-    JsonArray recordsArray = doc["records"].to<JsonArray>();
+    doc["active"] = status.active;
+    doc["path"] = status.path;
+    doc["total_pages"] = status.totalPages;
+    doc["remaining_pages"] = status.remainingPages;
+    doc["last_succeeded"] = status.lastSucceeded;
+    doc["last_error"] = status.lastError;
+    doc["finished_at"] = (long)status.finishedAt;
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// GET /api/backup/download: the last completed backup as a plain SQLite file.
+// Copy it off the device before changing the partition table; LittleFS is
+// recreated by the repartition, so this is the migration path that does not
+// depend on the old filesystem surviving.
+void WebServer::handleDownloadBackup(AsyncWebServerRequest *request) {
+    bool active = false;
+    if (!callDatabase([&]() { active = DatabaseManager::getInstance().isBackupActive(); })) {
+        sendDatabaseBusy(request);
+        return;
+    }
+    if (active) {
+        request->send(409, "text/plain", "Backup in progress, try again when it finishes");
+        return;
+    }
+    fs::FS& fs = FilesystemManager::getInstance().getFS();
+    String path = String(DB_BACKUP_PATH).substring(9);  // strip "/littlefs"
+    if (!fs.exists(path)) {
+        request->send(404, "text/plain", "No backup yet, POST /api/backup first");
+        return;
+    }
+    request->send(fs, path, "application/octet-stream", true);
+}
+
+// POST /api/backup: start an online backup to DB_BACKUP_PATH. Pages are
+// copied in DB_BACKUP_PAGES_PER_STEP batches by a scheduled task, so the
+// request returns immediately; poll GET /api/backup for progress.
+void WebServer::handleStartBackup(AsyncWebServerRequest *request) {
+    bool started = false;
+    String error;
+    if (!callDatabase([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            started = dbManager.beginBackup();
+            if (!started) {
+                error = dbManager.getLastError();
+            }
+        })) {
+        sendDatabaseBusy(request);
+        return;
+    }
+    if (!started) {
+        request->send(409, "text/plain", error);
+        return;
+    }
+    request->send(202, "application/json", "{\"started\":true,\"path\":\"" DB_BACKUP_PATH "\"}");
+}
 
-    for (const auto& record : records) {
-        JsonObject recordObj = recordsArray.add<JsonObject>();
-        recordObj["id"] = record.id;
-        recordObj["from"] = record.fromNumber;
-        recordObj["content"] = record.content;
-        recordObj["received_at"] = record.receivedAt;
-        recordObj["status"] = record.status;
+// Per-message stage timeline recorded from PDU arrival through push completion.
+// The stored form is compact ("D2 S41 Q42 ..."); it is expanded here so the UI
+// does not need to know the stage letters.
+void WebServer::handleGetSmsTrace(AsyncWebServerRequest *request) {
+    if (!request->hasParam("id")) {
+        request->send(400, "text/plain", "Missing query parameter 'id'");
+        return;
+    }
+    int smsId = request->getParam("id")->value().toInt();
+
+    String trace;
+    bool found = false;
+    if (smsId > 0 && !callDatabase([&]() { found = DatabaseManager::getInstance().getSmsTrace(smsId, trace); })) {
+        sendDatabaseBusy(request);
+        return;
+    }
+    if (!found) {
+        request->send(404, "text/plain", "No trace for this message");
+        return;
+    }
+
+    JsonDocument doc;
+    doc["id"] = smsId;
+    doc["raw"] = trace;
+    doc["truncated"] = trace.endsWith("~");
+    JsonArray stages = doc["stages"].to<JsonArray>();
+    const char* cursor = trace.c_str();
+    while (*cursor != '\0') {
+        while (*cursor == ' ') cursor++;
+        char stage = *cursor;
+        if (stage == '\0' || stage == '~') break;
+        char* end = nullptr;
+        unsigned long offsetMs = strtoul(cursor + 1, &end, 10);
+        if (end == cursor + 1) break;
+        JsonObject entry = stages.add<JsonObject>();
+        entry["stage"] = String(stage);
+        entry["name"] = SmsTrace::getStageName(stage);
+        entry["offset_ms"] = offsetMs;
+        cursor = end;
     }
 
     String response;
@@ -150,8 +732,11 @@ void WebServer::handleGetSmsHistory(AsyncWebServerRequest *request) {
 }
 
 void WebServer::handleGetAPSettings(AsyncWebServerRequest *request) {
-    DatabaseManager& dbManager = DatabaseManager::getInstance();
-    APConfig config = dbManager.getAPConfig();
+    APConfig config;
+    if (!callDatabase([&]() { config = DatabaseManager::getInstance().getAPConfig(); })) {
+        sendDatabaseBusy(request);
+        return;
+    }
     
     JsonDocument doc;
     doc["ssid"] = config.ssid;
@@ -195,9 +780,6 @@ void WebServer::handleUpdateAPSettings(AsyncWebServerRequest *request, uint8_t *
             return;
         }
 
-        DatabaseManager& dbManager = DatabaseManager::getInstance();
-        APConfig config = dbManager.getAPConfig(); // Get existing AP config to preserve other fields
-        
         Serial.println("[WebServer] Updating AP settings:");
         Serial.println("  SSID: " + ssid);
         Serial.println(String("  Password: ") + (password.length() > 0 ? "[SET]" : "[EMPTY]"));
@@ -205,25 +787,38 @@ void WebServer::handleUpdateAPSettings(AsyncWebServerRequest *request, uint8_t *
         Serial.println("  Max Connections: " + String(maxConnections));
         Serial.println("  Enabled: " + String(enabled));
         
-        config.ssid = ssid;
-        config.password = password;
-        config.channel = channel;
-        config.maxConnections = maxConnections;
-        config.enabled = enabled;
-
         Serial.println("[WebServer] Calling updateAPConfig...");
-        bool updateResult = dbManager.updateAPConfig(config);
+        bool updateResult = false;
+        String dbError;
+        bool ran = callDatabase([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            APConfig config = dbManager.getAPConfig(); // Get existing AP config to preserve other fields
+            config.ssid = ssid;
+            config.password = password;
+            config.channel = channel;
+            config.maxConnections = maxConnections;
+            config.enabled = enabled;
+            updateResult = dbManager.updateAPConfig(config);
+            if (!updateResult) {
+                dbError = dbManager.getLastError();
+            }
+        });
+        if (!ran) {
+            sendDatabaseBusy(request);
+            return;
+        }
         Serial.println("[WebServer] Update result: " + String(updateResult));
         
         if (updateResult) {
             Serial.println("[WebServer] Settings saved successfully. Rebooting...");
             request->send(200, "text/plain", "Settings saved. Rebooting...");
             delay(1000);
+            LogManager::getInstance().flush();
             ESP.restart();
         } else {
             Serial.println("[WebServer] Failed to save settings to database");
-            Serial.println("[WebServer] Last error: " + dbManager.getLastError());
-            request->send(500, "text/plain", "Failed to save settings: " + dbManager.getLastError());
+            Serial.println("[WebServer] Last error: " + dbError);
+            request->send(500, "text/plain", "Failed to save settings: " + dbError);
         }
     }
 }
@@ -245,8 +840,23 @@ void WebServer::handleAddRule(AsyncWebServerRequest *request, uint8_t *data, siz
         rule.pushConfig = doc["push_config"].as<String>();
         rule.enabled = doc["enabled"].as<bool>();
         rule.isDefaultForward = doc["is_default_forward"].as<bool>();
+        rule.priority = doc["priority"] | FORWARD_RULE_DEFAULT_PRIORITY;
+        if (rule.priority < 0 || rule.priority > FORWARD_RULE_MAX_PRIORITY) {
+            request->send(400, "text/plain", "Priority must be between 0 and 1000");
+            return;
+        }
 
-        if (DatabaseManager::getInstance().addForwardRule(rule) != -1) {
+        int ruleId = -1;
+        bool ran = callDatabase([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            ruleId = dbManager.addForwardRule(rule);
+            if (ruleId != -1) {
+                PushManager::getInstance().upsertCachedRule(dbManager.getForwardRuleById(ruleId));
+            }
+        });
+        if (!ran) {
+            sendDatabaseBusy(request);
+        } else if (ruleId != -1) {
             request->send(200, "text/plain", "OK");
         } else {
             request->send(500, "text/plain", "Failed to add rule");
@@ -273,7 +883,28 @@ void WebServer::handleUpdateRule(AsyncWebServerRequest *request, uint8_t *data,
         rule.enabled = doc["enabled"].as<bool>();
         rule.isDefaultForward = doc["is_default_forward"].as<bool>();
 
-        if (DatabaseManager::getInstance().updateForwardRule(rule)) {
+        bool keepPriority = !doc["priority"].is<int>();
+        rule.priority = keepPriority ? FORWARD_RULE_DEFAULT_PRIORITY : doc["priority"].as<int>();
+        if (rule.priority < 0 || rule.priority > FORWARD_RULE_MAX_PRIORITY) {
+            request->send(400, "text/plain", "Priority must be between 0 and 1000");
+            return;
+        }
+
+        bool updated = false;
+        bool ran = callDatabase([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            // Older clients omit priority; keep the stored value instead of resetting it
+            if (keepPriority) {
+                rule.priority = dbManager.getForwardRuleById(rule.id).priority;
+            }
+            updated = dbManager.updateForwardRule(rule);
+            if (updated) {
+                PushManager::getInstance().upsertCachedRule(dbManager.getForwardRuleById(rule.id));
+            }
+        });
+        if (!ran) {
+            sendDatabaseBusy(request);
+        } else if (updated) {
             request->send(200, "text/plain", "OK");
         } else {
             request->send(500, "text/plain", "Failed to update rule");
@@ -304,26 +935,329 @@ void WebServer::handleDeleteRule(AsyncWebServerRequest *request, uint8_t *data,
             return;
         }
         
-        DatabaseManager& dbManager = DatabaseManager::getInstance();
-        
         // 使用带事务保护的删除方法
-        if (dbManager.deleteForwardRuleWithTransaction(ruleId)) {
+        bool deleted = false;
+        String dbError;
+        bool ran = callDatabase([&]() {
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            deleted = dbManager.deleteForwardRuleWithTransaction(ruleId);
+            if (deleted) {
+                PushManager::getInstance().removeCachedRule(ruleId);
+            } else {
+                dbError = dbManager.getLastError();
+            }
+        });
+        if (!ran) {
+            sendDatabaseBusy(request);
+        } else if (deleted) {
             request->send(200, "text/plain", "Rule deleted successfully");
         } else {
-            String errorMsg = "Failed to delete rule: " + dbManager.getLastError();
+            String errorMsg = "Failed to delete rule: " + dbError;
             request->send(500, "text/plain", errorMsg);
         }
     }
 }
 
+// POST /api/rules/backtest: which stored messages would a rule have matched?
+// Body is either {"id": <rule id>} or the unsaved rule fields from the edit
+// form (source_number, keywords, is_default_forward), plus optional "limit"
+// (messages to examine) and "samples". The rule is compiled on its own and
+// history is streamed newest first in RULE_BACKTEST_BATCH_ROWS batches, each
+// a separate database worker job; keyword rules read only the rows the
+// full-text index returns. Matching samples are emitted as they are found,
+// the counts once the scan ends.
+void WebServer::handleBacktestRule(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (index != 0) {
+        return;
+    }
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, (const char*)data, len);
+    if (error) {
+        request->send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+
+    int ruleId = doc["id"] | 0;
+    int limit = doc["limit"] | RULE_BACKTEST_MAX_RECORDS;
+    int samples = doc["samples"] | RULE_BACKTEST_MAX_SAMPLES;
+    if (limit < 1 || limit > RULE_BACKTEST_MAX_RECORDS || samples < 0 || samples > RULE_BACKTEST_MAX_SAMPLES) {
+        request->send(HTTP_STATUS_BAD_REQUEST, "text/plain",
+                      "limit must be 1-" + String(RULE_BACKTEST_MAX_RECORDS) +
+                      " and samples 0-" + String(RULE_BACKTEST_MAX_SAMPLES));
+        return;
+    }
+
+    ForwardRule rule;
+    if (ruleId <= 0) {
+        rule.sourceNumber = doc["source_number"].as<String>();
+        rule.keywords = doc["keywords"].as<String>();
+        rule.isDefaultForward = doc["is_default_forward"].as<bool>();
+    }
+
+    std::shared_ptr<RuleBacktest> backtest = std::make_shared<RuleBacktest>();
+    bool found = true;
+    bool ready = false;
+    if (!callDatabase([&]() {
+            if (ruleId > 0) {
+                rule = DatabaseManager::getInstance().getForwardRuleById(ruleId);
+                found = rule.id != -1;
+                if (!found) {
+                    return;
+                }
+            }
+            ready = backtest->begin(rule, limit, samples);
+        })) {
+        sendDatabaseBusy(request);
+        return;
+    }
+    if (!found) {
+        request->send(404, "text/plain", "Rule not found");
+        return;
+    }
+    if (!ready) {
+        request->send(500, "text/plain", backtest->getLastError());
+        return;
+    }
+
+    struct BacktestCursor {
+        bool opened = false;
+        size_t sent = 0;
+    };
+    std::shared_ptr<BacktestCursor> cursor = std::make_shared<BacktestCursor>();
+
+    request->send(beginJsonStream(request, [backtest, cursor](String& out) {
+        if (!cursor->opened) {
+            cursor->opened = true;
+            out += "{\"prefiltered\":";
+            out += backtest->isPrefiltered() ? "true" : "false";
+            out += ",\"samples\":[";
+            return true;
+        }
+
+        std::vector<RuleBacktestSample> hits;
+        bool more = backtest->step(hits);
+        for (const auto& sample : hits) {
+            appendBacktestSample(out, sample, cursor->sent == 0);
+            cursor->sent++;
+        }
+        if (more) {
+            return true;
+        }
+
+        JsonDocument summary;
+        summary["examined"] = backtest->getExamined();
+        summary["matched"] = backtest->getMatched();
+        summary["limit_reached"] = backtest->isLimitReached();
+        summary["total"] = DatabaseManager::getInstance().getSMSRecordCount();
+        summary["elapsed_ms"] = backtest->getElapsedMs();
+        if (!backtest->getLastError().isEmpty()) {
+            summary["error"] = backtest->getLastError();
+        }
+        out += "],\"summary\":";
+        appendJson(out, summary);
+        out += '}';
+        return false;
+    }));
+}
+
+void WebServer::handleGetNumberLists(AsyncWebServerRequest *request) {
+    std::vector<NumberListSummary> lists;
+    if (!callDatabase([&]() { lists = DatabaseManager::getInstance().getNumberListSummaries(); })) {
+        sendDatabaseBusy(request);
+        return;
+    }
+    JsonDocument doc;
+    JsonArray array = doc.to<JsonArray>();
+    for (const NumberListSummary& list : lists) {
+        JsonObject entry = array.add<JsonObject>();
+        entry["name"] = list.name;
+        entry["count"] = list.count;
+        entry["pattern"] = String(NUMBER_LIST_PATTERN_PREFIX) + list.name;
+    }
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// POST /api/number_lists/import?list=<name>[&mode=replace]
+// Body: numbers separated by newlines, commas or semicolons. The body is
+// buffered in PSRAM across chunks (freed with the request) and imported in
+// a single transaction once complete.
+void WebServer::handleImportNumberList(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        if (total == 0 || total > NUMBER_LIST_IMPORT_MAX_BYTES) {
+            request->send(413, "text/plain", "Body must be 1-" + String(NUMBER_LIST_IMPORT_MAX_BYTES) + " bytes");
+            return;
+        }
+        String listName = request->hasParam("list") ? request->getParam("list")->value() : "";
+        if (!isValidNumberListName(listName)) {
+            request->send(400, "text/plain", "Query parameter 'list' must be 1-" + String(NUMBER_LIST_NAME_MAX_LENGTH) +
+                                             " letters, digits, '_' or '-'");
+            return;
+        }
+        request->_tempObject = heap_caps_malloc(total + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (request->_tempObject == nullptr) {
+            request->send(HTTP_STATUS_INTERNAL_ERROR, "text/plain", "Out of memory");
+            return;
+        }
+    }
+    char* body = (char*)request->_tempObject;
+    if (body == nullptr || index + len > total) {
+        return;
+    }
+    memcpy(body + index, data, len);
+    if (index + len < total) {
+        return;
+    }
+    body[total] = '\0';
+
+    // Normalizing may add a country code, so leave room for growth
+    size_t outSize = total + total / 2 + NUMBER_LIST_MAX_NUMBER_LENGTH;
+    char* numbers = (char*)heap_caps_malloc(outSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (numbers == nullptr) {
+        request->send(HTTP_STATUS_INTERNAL_ERROR, "text/plain", "Out of memory");
+        return;
+    }
+    int invalid = 0;
+    int valid = normalizeNumberList(body, numbers, outSize, invalid);
+
+    String listName = request->getParam("list")->value();
+    bool replace = request->hasParam("mode") && request->getParam("mode")->value() == "replace";
+    int added = -1;
+    String dbError;
+    bool ran = callDatabase([&]() {
+        DatabaseManager& dbManager = DatabaseManager::getInstance();
+        added = dbManager.importNumberList(listName, numbers, replace);
+        if (added >= 0) {
+            PushManager::getInstance().reloadNumberList(listName);
+        } else {
+            dbError = dbManager.getLastError();
+        }
+    });
+    heap_caps_free(numbers);
+    if (!ran) {
+        sendDatabaseBusy(request);
+        return;
+    }
+    if (added < 0) {
+        request->send(HTTP_STATUS_INTERNAL_ERROR, "text/plain", "Failed to import numbers: " + dbError);
+        return;
+    }
+
+    JsonDocument doc;
+    doc["list"] = listName;
+    doc["pattern"] = String(NUMBER_LIST_PATTERN_PREFIX) + listName;
+    doc["valid"] = valid;
+    doc["added"] = added;
+    doc["invalid"] = invalid;
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void WebServer::handleDeleteNumberList(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)data, len);
+        if (error) {
+            request->send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+        String listName = doc["list"].as<String>();
+        if (!isValidNumberListName(listName)) {
+            request->send(400, "text/plain", "Invalid list name");
+            return;
+        }
+
+        bool deleted = false;
+        bool ran = callDatabase([&]() {
+            deleted = DatabaseManager::getInstance().deleteNumberList(listName);
+            if (deleted) {
+                PushManager::getInstance().reloadNumberList(listName);
+            }
+        });
+        if (!ran) {
+            sendDatabaseBusy(request);
+        } else if (deleted) {
+            request->send(200, "text/plain", "OK");
+        } else {
+            request->send(500, "text/plain", "Failed to delete list");
+        }
+    }
+}
+
 void WebServer::handleGetLogs(AsyncWebServerRequest *request) {
-    // This should be implemented to fetch logs from LogManager
-    request->send(200, "application/json", "[]");
+    LogRing& ring = LogRing::getInstance();
+
+    int limit = LOG_API_DEFAULT_LIMIT;
+    if (request->hasParam("limit")) {
+        limit = request->getParam("limit")->value().toInt();
+    }
+    if (limit < 1 || limit > LOG_API_MAX_LIMIT) {
+        limit = LOG_API_DEFAULT_LIMIT;
+    }
+
+    // Without `since`, return the most recent entries
+    uint32_t since;
+    if (request->hasParam("since")) {
+        since = (uint32_t)strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+    } else {
+        uint32_t end = ring.getNextSeq();
+        since = end > (uint32_t)limit ? end - limit : 0;
+    }
+
+    JsonDocument doc;
+    JsonArray entries = doc["entries"].to<JsonArray>();
+    uint32_t lost = 0;
+    uint32_t next = ring.read(since, limit, [&entries](const LogRecord& record) {
+        JsonObject entry = entries.add<JsonObject>();
+        entry["seq"] = record.seq;
+        entry["uptime_ms"] = record.uptimeMs;
+        entry["time"] = record.unixTime;
+        entry["level"] = LogManager::getLevelTag((LogLevel)record.level);
+        entry["module"] = LogManager::getModuleTag((LogModule)record.module);
+        entry["message"] = record.message;
+    }, lost);
+    doc["next"] = next;
+    doc["lost"] = lost;
+    doc["available"] = ring.isReady();
+
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// Prometheus text exposition format (scrape target for monitoring)
+void WebServer::handleGetMetrics(AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+    MetricsRegistry::getInstance().render(*response);
+    request->send(response);
+}
+
+void WebServer::handleGetModemStatus(AsyncWebServerRequest *request) {
+    // Served from the periodically refreshed snapshot; never touches the UART
+    ModemStatus status = GsmService::getInstance().getStatusSnapshot();
+    unsigned long now = millis();
+    JsonDocument doc;
+    doc["valid"] = status.valid;
+    if (status.valid) {
+        doc["online"] = status.online;
+        doc["sim_ready"] = status.simReady;
+        doc["network_status"] = (int)status.networkStatus;
+        doc["registered"] = status.isRegistered();
+        doc["signal_strength"] = status.signalStrength;
+        doc["refreshed_ms_ago"] = now - status.refreshedAt;
+        doc["network_updated_ms_ago"] = now - status.networkUpdatedAt;
+    }
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
 }
 
 void WebServer::handleReboot(AsyncWebServerRequest *request) {
     request->send(200, "text/plain", "Rebooting...");
     delay(1000);
+    LogManager::getInstance().flush();
     ESP.restart();
 }
 
@@ -378,58 +1312,76 @@ void WebServer::handleExecuteSQL(AsyncWebServerRequest *request, uint8_t *data,
             return;
         }
         
-        // 记录执行开始时间
-        unsigned long startTime = millis();
-        
-        DatabaseManager& dbManager = DatabaseManager::getInstance();
+        // 语句在数据库工作线程中执行，AsyncTCP回调只负责取回结果
+        request->send(beginJsonStream(request, [sqlCommand, sqlLower](String& out) {
+            // 记录执行开始时间
+            unsigned long startTime = millis();
         
-        JsonDocument responseDoc;
+            DatabaseManager& dbManager = DatabaseManager::getInstance();
+            JsonDocument responseDoc;
         
-        // 判断是否为查询语句
-        if (sqlLower.startsWith("select") || sqlLower.startsWith("pragma")) {
-            // 执行查询
-            std::vector<std::map<String, String>> results = dbManager.executeQuery(sqlCommand);
-            
-            if (results.empty() && !dbManager.getLastError().isEmpty()) {
-                // 查询出错
-                responseDoc["success"] = false;
-                responseDoc["error"] = dbManager.getLastError();
-            } else {
-                // 查询成功
-                responseDoc["success"] = true;
-                responseDoc["type"] = "query";
-                responseDoc["rowCount"] = results.size();
-                
+            // 判断是否为查询语句
+            if (sqlLower.startsWith("select") || sqlLower.startsWith("pragma")) {
+                // 执行查询：逐行按列序号直接写入JSON，不经过中间的map结果集
                 JsonArray dataArray = responseDoc["data"].to<JsonArray>();
-                for (const auto& row : results) {
+                size_t rowCount = 0;
+                bool ok = dbManager.forEachRow(sqlCommand, [&](sqlite3_stmt* stmt) {
                     JsonObject rowObj = dataArray.add<JsonObject>();
-                    for (const auto& pair : row) {
-                        rowObj[pair.first] = pair.second;
+                    int columnCount = sqlite3_column_count(stmt);
+                    for (int i = 0; i < columnCount; i++) {
+                        const char* name = sqlite3_column_name(stmt, i);
+                        switch (sqlite3_column_type(stmt, i)) {
+                            case SQLITE_INTEGER:
+                                rowObj[name] = (long long)sqlite3_column_int64(stmt, i);
+                                break;
+                            case SQLITE_FLOAT:
+                                rowObj[name] = sqlite3_column_double(stmt, i);
+                                break;
+                            case SQLITE_NULL:
+                                rowObj[name] = "";
+                                break;
+                            default:
+                                rowObj[name] = (const char*)sqlite3_column_text(stmt, i);
+                                break;
+                        }
                     }
-                }
-            }
-        } else {
-            // 执行非查询语句（INSERT, UPDATE等）
-            bool success = dbManager.executeSQL(sqlCommand);
+                    rowCount++;
+                    return true;
+                });
             
-            if (success) {
-                responseDoc["success"] = true;
-                responseDoc["type"] = "execute";
-                responseDoc["message"] = "SQL executed successfully";
-                // 注意：SQLite不直接提供affected rows，这里简化处理
-                responseDoc["affectedRows"] = "N/A";
+                if (!ok) {
+                    // 查询出错
+                    responseDoc.remove("data");
+                    responseDoc["success"] = false;
+                    responseDoc["error"] = dbManager.getLastError();
+                } else {
+                    // 查询成功
+                    responseDoc["success"] = true;
+                    responseDoc["type"] = "query";
+                    responseDoc["rowCount"] = rowCount;
+                }
             } else {
-                responseDoc["success"] = false;
-                responseDoc["error"] = dbManager.getLastError();
+                // 执行非查询语句（INSERT, UPDATE等）
+                bool success = dbManager.executeSQL(sqlCommand);
+            
+                if (success) {
+                    responseDoc["success"] = true;
+                    responseDoc["type"] = "execute";
+                    responseDoc["message"] = "SQL executed successfully";
+                    // 注意：SQLite不直接提供affected rows，这里简化处理
+                    responseDoc["affectedRows"] = "N/A";
+                } else {
+                    responseDoc["success"] = false;
+                    responseDoc["error"] = dbManager.getLastError();
+                }
             }
-        }
         
-        // 计算执行耗时
-        unsigned long executionTime = millis() - startTime;
-        responseDoc["executionTime"] = executionTime;
-        
-        String response;
-        serializeJson(responseDoc, response);
-        request->send(200, "application/json", response);
+            // 计算执行耗时
+            unsigned long executionTime = millis() - startTime;
+            responseDoc["executionTime"] = executionTime;
+
+            appendJson(out, responseDoc);
+            return false;
+        }));
     }
 }
\ No newline at end of file
@@ -10,6 +10,16 @@ public:
     void start();
     void stop();
 
+    // Temporarily stop accepting connections under memory pressure and
+    // resume later without rebuilding the routes (no-op if never started)
+    void pause();
+    void resume();
+    bool isPaused() const;
+
+    // Push a system-health event to connected event stream clients
+    // (called periodically; no-op when nobody is listening)
+    void publishHealth();
+
 private:
     WebServer();
     ~WebServer();
@@ -26,9 +36,21 @@ private:
     static void handleAddRule(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
     static void handleUpdateRule(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
     static void handleDeleteRule(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    static void handleBacktestRule(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    static void handleGetNumberLists(class AsyncWebServerRequest *request);
+    static void handleImportNumberList(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    static void handleDeleteNumberList(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
     static void handleGetLogs(class AsyncWebServerRequest *request);
+    static void handleGetMetrics(class AsyncWebServerRequest *request);
+    static void handleGetModemStatus(class AsyncWebServerRequest *request);
     static void handleReboot(class AsyncWebServerRequest *request);
     static void handleGetSmsHistory(class AsyncWebServerRequest *request);
+    static void handleSearchSms(class AsyncWebServerRequest *request);
+    static void handleGetSmsTrace(class AsyncWebServerRequest *request);
+    static void handleExportSms(class AsyncWebServerRequest *request);
+    static void handleGetBackupStatus(class AsyncWebServerRequest *request);
+    static void handleStartBackup(class AsyncWebServerRequest *request);
+    static void handleDownloadBackup(class AsyncWebServerRequest *request);
     static void handleGetDocsGuide(class AsyncWebServerRequest *request);
     static void handleGetAPSettings(class AsyncWebServerRequest *request);
     static void handleUpdateAPSettings(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
@@ -41,6 +63,10 @@ private:
     static void handleExecuteSQL(class AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
 
     class AsyncWebServer* server;
+    class AsyncEventSource* events;   // Live event stream at /api/events
+    int eventSubscription;            // EventBus subscription forwarding to `events`
+    bool running;                     // start() called and stop() not yet
+    bool paused;                      // Listener closed by pause()
 };
 
 #endif // WEB_SERVER_H
\ No newline at end of file
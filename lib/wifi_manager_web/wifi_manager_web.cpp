@@ -2,6 +2,7 @@
 #include <WiFi.h>
 #include <DNSServer.h>
 #include "../database_manager/database_manager.h"
+#include "../../include/config.h"
 
 WiFiManagerWeb& WiFiManagerWeb::getInstance() {
     static WiFiManagerWeb instance;
@@ -34,7 +35,8 @@ void WiFiManagerWeb::configureAPMode() {
     Serial.println("  Enabled: " + String(apConfig.enabled));
 
     Serial.println("[WiFiManager] Starting Access Point...");
-    WiFi.mode(WIFI_AP);
+    bool stationEnabled = strlen(WIFI_STA_SSID) > 0;
+    WiFi.mode(stationEnabled ? WIFI_AP_STA : WIFI_AP);
     
     bool apResult = WiFi.softAP(apConfig.ssid.c_str(), apConfig.password.c_str(), apConfig.channel, 0, apConfig.maxConnections);
     Serial.println("[WiFiManager] WiFi.softAP() result: " + String(apResult ? "SUCCESS" : "FAILED"));
@@ -53,6 +55,13 @@ void WiFiManagerWeb::configureAPMode() {
     Serial.println("[WiFiManager] Verifying actual AP settings:");
     Serial.println("  Actual SSID: " + WiFi.softAPSSID());
     Serial.println("  Actual IP: " + WiFi.softAPIP().toString());
+
+    // Station uplink lets pushes bypass the modem; the driver keeps reconnecting on its own
+    if (stationEnabled) {
+        Serial.println("[WiFiManager] Connecting station uplink: " + String(WIFI_STA_SSID));
+        WiFi.setAutoReconnect(true);
+        WiFi.begin(WIFI_STA_SSID, WIFI_STA_PASSWORD);
+    }
 }
 
 WiFiMode WiFiManagerWeb::getMode() {
@@ -63,6 +72,10 @@ String WiFiManagerWeb::getIPAddress() {
     return ipAddress;
 }
 
+bool WiFiManagerWeb::isStationConnected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
 void WiFiManagerWeb::loop() {
     if (currentMode == WM_WIFI_MODE_AP) {
         dnsServer->processNextRequest();
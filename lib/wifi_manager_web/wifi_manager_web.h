@@ -17,6 +17,7 @@ public:
     bool startAP();
     WiFiMode getMode();
     String getIPAddress();
+    bool isStationConnected();
     void loop();
 
 private:
@@ -0,0 +1,116 @@
+"""
+Build-time gzip step for the embedded web UI.
+
+Runs as a PlatformIO pre-build script (see extra_scripts in platformio.ini)
+or standalone: python scripts/gzip_web_assets.py
+
+Reads the raw-literal assets in lib/web_server (html.h, css.h, js.h), gzips
+them and writes lib/web_server/web_assets_gz.h with the compressed bytes and
+a strong ETag per asset. The HTML references the stylesheet and script with
+their content hash as a query string, so those two can be cached for a long
+time and are still refetched after a firmware update changes them.
+
+The output is only rewritten when its content changes, so unchanged assets
+do not trigger a rebuild of web_server.cpp.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    # __file__ is not defined when SCons executes the script
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    ROOT = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(ROOT, "lib", "web_server")
+OUTPUT = os.path.join(WEB_DIR, "web_assets_gz.h")
+
+# (source header, raw-literal array name, generated symbol prefix)
+ASSETS = [
+    ("css.h", "CSS_CONTENT", "CSS"),
+    ("js.h", "JS_CONTENT", "JS"),
+    ("html.h", "HTML_CONTENT", "HTML"),
+]
+
+# Asset URLs rewritten in the HTML to carry the content hash
+VERSIONED_URLS = {
+    "CSS": "/style.css",
+    "JS": "/script.js",
+}
+
+
+def read_raw_literal(filename, name):
+    with open(os.path.join(WEB_DIR, filename), encoding="utf-8") as f:
+        source = f.read()
+    match = re.search(
+        r"const char " + name + r'\[\] PROGMEM = R"rawliteral\((.*?)\)rawliteral";',
+        source,
+        re.S,
+    )
+    if match is None:
+        raise RuntimeError("raw literal %s not found in %s" % (name, filename))
+    return match.group(1).encode("utf-8")
+
+
+def format_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def generate():
+    hashes = {}
+    parts = [
+        "/**",
+        " * @file web_assets_gz.h",
+        " * @brief gzip压缩的Web静态资源（由scripts/gzip_web_assets.py生成，请勿手工修改）",
+        " * @author ESP-SMS-Relay Project",
+        " * @date 2024",
+        " */",
+        "",
+        "#ifndef WEB_ASSETS_GZ_H",
+        "#define WEB_ASSETS_GZ_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+    ]
+
+    for filename, name, prefix in ASSETS:
+        content = read_raw_literal(filename, name)
+        if prefix == "HTML":
+            for asset, url in VERSIONED_URLS.items():
+                versioned = '%s?v=%s' % (url, hashes[asset])
+                content = content.replace(('"%s"' % url).encode(), ('"%s"' % versioned).encode())
+
+        digest = hashlib.sha1(content).hexdigest()[:16]
+        hashes[prefix] = digest
+        # mtime=0 keeps the output reproducible
+        compressed = gzip.compress(content, compresslevel=9, mtime=0)
+
+        parts.append("// %s: %d -> %d bytes" % (filename, len(content), len(compressed)))
+        parts.append('#define %s_CONTENT_ETAG "\\"%s\\""' % (prefix, digest))
+        parts.append("const size_t %s_CONTENT_GZ_LEN = %d;" % (prefix, len(compressed)))
+        parts.append("const uint8_t %s_CONTENT_GZ[] PROGMEM = {" % prefix)
+        parts.append(format_bytes(compressed))
+        parts.append("};")
+        parts.append("")
+
+    parts.append("#endif // WEB_ASSETS_GZ_H")
+    parts.append("")
+    output = "\n".join(parts)
+
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, encoding="utf-8") as f:
+            if f.read() == output:
+                return
+    with open(OUTPUT, "w", encoding="utf-8", newline="\n") as f:
+        f.write(output)
+    print("Generated %s" % os.path.relpath(OUTPUT, ROOT))
+
+
+generate()
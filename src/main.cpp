@@ -14,14 +14,27 @@
 #include <sys/time.h>
 #include "terminal_manager.h"
 #include "database_manager.h"
+#include "db_worker.h"
 #include "log_manager.h"
 #include "filesystem_manager.h"
 #include "gsm_service.h"
 #include "carrier_config.h"
+#include "config_manager.h"
 #include "phone_caller.h"
 #include "uart_monitor.h"
+#include "modem_arbiter.h"
 #include "push_manager.h"
+#include "push_worker.h"
+#include "sms_send_queue.h"
+#include "http_client.h"
+#include "native_http_transport.h"
+#include "access_token_cache.h"
+#include "mqtt_session.h"
 #include "task_scheduler.h"
+#include "power_manager.h"
+#include "memory_pressure.h"
+#include "task_topology.h"
+#include "boot_sequencer.h"
 #include "config.h"
 #include "constants.h"
 #include "wifi_manager_web.h"
@@ -36,17 +49,27 @@ PushManager& pushManager = PushManager::getInstance();
 
 // 定义硬件串口
 HardwareSerial simSerial(SIM_SERIAL_NUM); // 使用配置的串口号
+#if SIM_MODEM_COUNT > 1
+HardwareSerial sim2Serial(SIM2_SERIAL_NUM);
+#endif
+#if SIM_MODEM_COUNT > 2
+HardwareSerial sim3Serial(SIM3_SERIAL_NUM);
+#endif
 
 /**
- * @brief 系统初始化函数
- * 
- * 负责系统组件初始化和CLI启动
+ * @brief 启动阶段：初始化日志
  * @return true 初始化成功
  * @return false 初始化失败
  */
-bool initializeSystem() {
+bool initializeLogging() {
     Serial.println("\n=== ESP-SMS-Relay System Starting ===");
     
+    // 从NVS加载一次配置并发布运行配置快照（失败时沿用默认配置的快照）
+    ConfigManager& configManager = ConfigManager::getInstance();
+    if (!configManager.initialize()) {
+        Serial.println("⚠️  Failed to load configuration, using defaults: " + configManager.getLastError());
+    }
+    
     // 初始化日志管理器
     if (!logManager.initialize()) {
         Serial.println("Failed to initialize Log Manager");
@@ -54,6 +77,21 @@ bool initializeSystem() {
     }
     Serial.println("✓ Log Manager initialized");
     
+    // 日志改由低优先级任务输出到串口，调用方不再阻塞在串口发送上
+    if (logManager.startAsyncSink()) {
+        Serial.println("✓ Async log sink started");
+    } else {
+        Serial.println("⚠️  Async log sink unavailable, logging synchronously");
+    }
+    return true;
+}
+
+/**
+ * @brief 启动阶段：初始化文件系统与数据库
+ * @return true 初始化成功
+ * @return false 初始化失败
+ */
+bool initializeStorage() {
     // 初始化文件系统管理器
     if (!filesystemManager.initialize()) {
         Serial.println("Failed to initialize Filesystem Manager: " + filesystemManager.getLastError());
@@ -68,7 +106,22 @@ bool initializeSystem() {
         return false;
     }
     Serial.println("✓ Database Manager initialized");
-    
+
+    // 启动数据库工作线程，此后各任务的数据库请求由它按序执行
+    if (!DbWorker::getInstance().initialize()) {
+        Serial.println("Database worker not started, running queries inline: " + DbWorker::getInstance().getLastError());
+    } else {
+        Serial.println("✓ Database Worker initialized");
+    }
+    return true;
+}
+
+/**
+ * @brief 启动阶段：初始化规则、推送、发送队列与任务调度
+ * @return true 初始化成功
+ * @return false 初始化失败
+ */
+bool initializeServices() {
     // 初始化终端管理器
     if (!terminalManager.initialize()) {
         Serial.println("Failed to initialize Terminal Manager: " + terminalManager.getLastError());
@@ -83,6 +136,92 @@ bool initializeSystem() {
     }
     Serial.println("✓ Push Manager initialized");
     
+    // 启动异步推送工作线程，短信接收路径不再等待HTTP推送
+    if (!PushWorker::getInstance().initialize()) {
+        Serial.println("⚠️  Failed to start Push Worker, falling back to synchronous push: " + PushWorker::getInstance().getLastError());
+    } else {
+        Serial.println("✓ Push Worker started");
+    }
+    
+    // 启动短信发送队列，发送短信的调用方无需等待AT+CMGS
+    if (!SmsSendQueue::getInstance().initialize()) {
+        Serial.println("⚠️  Failed to start SMS send queue: " + SmsSendQueue::getInstance().getLastError());
+    } else {
+        Serial.println("✓ SMS send queue started");
+    }
+    
+    // 初始化任务调度器（由loop()驱动）
+    TaskScheduler& taskScheduler = TaskScheduler::getInstance();
+    if (!taskScheduler.initialize()) {
+        Serial.println("Failed to initialize Task Scheduler: " + taskScheduler.getLastError());
+        return false;
+    }
+    Serial.println("✓ Task Scheduler initialized");
+    
+    // 定期检查推送发件箱，重试失败或因重启中断的推送
+    taskScheduler.addPeriodicTask("push_outbox_drain", PUSH_OUTBOX_DRAIN_INTERVAL_MS, []() {
+        PushWorker::getInstance().requestOutboxDrain();
+    });
+    
+    // 关闭空闲的HTTP会话，释放模块HTTP服务
+    taskScheduler.addPeriodicTask("http_session_idle", HTTP_SESSION_IDLE_TIMEOUT_MS / 2, []() {
+        for (uint8_t modem = 0; modem < ModemArbiter::getModemCount(); modem++) {
+            HttpClient::getModem(modem).closeIdleSession();
+        }
+        NativeHttpTransport::getInstance().closeIdleConnections();
+    });
+    
+    // 提交合并的短信与发件箱写入
+    taskScheduler.addPeriodicTask("db_group_commit", DB_GROUP_COMMIT_INTERVAL_MS, []() {
+        DbWorker::getInstance().post([]() {
+            DatabaseManager::getInstance().flushGroupCommit();
+        });
+    });
+    
+    // 分批清理超出保留策略的短信，空闲时回收空闲页（在数据库工作线程中执行）
+    taskScheduler.addPeriodicTask("db_retention", DB_RETENTION_INTERVAL_MS, []() {
+        DbWorker::getInstance().post([]() {
+            DatabaseManager::getInstance().runRetentionStep();
+        });
+    });
+    
+    // 在线备份进行中时分批复制页面，两批之间其他数据库请求照常执行
+    taskScheduler.addPeriodicTask("db_backup_step", DB_BACKUP_STEP_INTERVAL_MS, []() {
+        if (DatabaseManager::getInstance().isBackupActive()) {
+            DbWorker::getInstance().post([]() {
+                DatabaseManager::getInstance().stepBackup();
+            });
+        }
+    });
+    
+    // 内部堆紧张时逐级降载（释放缓存、暂停Web服务器与推送），耗尽时提交数据库后重启
+    taskScheduler.addPeriodicTask("memory_pressure", MEMORY_PRESSURE_CHECK_INTERVAL_MS, []() {
+        MemoryPressureManager::getInstance().check();
+    });
+    
+    // 检查各任务的栈高水位，余量不足时告警
+    taskScheduler.addPeriodicTask("stack_watermark", TASK_STACK_CHECK_INTERVAL_MS, []() {
+        TaskTopology::getInstance().checkStackWatermarks();
+    });
+    
+    // 定期批量查询模块状态，状态读取方只读快照，不必为此占用串口
+    taskScheduler.addPeriodicTask("modem_status", MODEM_STATUS_REFRESH_INTERVAL_MS, []() {
+        for (uint8_t modem = 0; modem < ModemArbiter::getModemCount(); modem++) {
+            GsmService::getModem(modem).refreshStatus();
+        }
+    }, false, TASK_DISPATCH_WORKER);
+    
+    // 在访问令牌过期前主动刷新，推送时无需等待获取令牌
+    AccessTokenCache::getInstance().initialize();
+    taskScheduler.addPeriodicTask("token_refresh", TOKEN_REFRESH_CHECK_INTERVAL_MS, []() {
+        AccessTokenCache::getInstance().refreshExpiring();
+    }, false, TASK_DISPATCH_WORKER);
+    
+    // 关闭空闲过久的MQTT连接（模块连接需要发送AT命令）
+    taskScheduler.addPeriodicTask("mqtt_session_idle", MQTT_IDLE_CHECK_INTERVAL_MS, []() {
+        MqttSessionManager::getInstance().closeIdleSessions();
+    }, false, TASK_DISPATCH_WORKER);
+    
     // 加载转发规则到缓存
     if (!pushManager.loadRulesToCache()) {
         Serial.println("⚠️  Failed to load rules to cache: " + pushManager.getLastError());
@@ -90,13 +229,32 @@ bool initializeSystem() {
         Serial.println("✓ Forward rules loaded to cache");
     }
     
-    // 注意：UART监控任务将在GSM初始化完成后启动
-    Serial.println("✓ UART Monitor Task will be started after GSM initialization");
-    
     Serial.println("=== System Initialization Complete ===");
     return true;
 }
 
+/**
+ * @brief 启动阶段：为每个SIM模块启动UART监控任务（短信URC消费者）
+ * 
+ * 由仲裁器投递URC，不依赖GSM探测，开机期间到达的短信也能及时入库
+ * @return true 启动成功
+ * @return false 启动失败
+ */
+bool startSmsIngestion() {
+    static const SystemTaskId MONITOR_TASKS[MODEM_MAX_COUNT] = {
+        SYSTEM_TASK_UART_MONITOR, SYSTEM_TASK_MODEM2_MONITOR, SYSTEM_TASK_MODEM3_MONITOR
+    };
+    for (uint8_t modem = 0; modem < ModemArbiter::getModemCount(); modem++) {
+        if (!TaskTopology::getInstance().createTask(MONITOR_TASKS[modem], uart_monitor_task,
+                                                    (void*)(uintptr_t)modem, NULL)) {
+            Serial.println("❌ Failed to start UART Monitor Task for SIM" + String(modem + 1));
+            return false;
+        }
+    }
+    Serial.println("✓ UART Monitor Task started (" + String(ModemArbiter::getModemCount()) + " SIM)");
+    return true;
+}
+
 /**
  * @brief 初始化WiFi和Web服务器
  */
@@ -113,39 +271,55 @@ void initializeWifiAndWebServer() {
         // 启动Web服务器用于AP模式管理
         WebServer::getInstance().start();
         Serial.println("✓ Web server started for AP mode management.");
+        
+        // 向事件流客户端推送系统状态（无客户端时不执行任何操作）
+        TaskScheduler::getInstance().addPeriodicTask("web_events_health", WEB_EVENTS_HEALTH_INTERVAL_MS, []() {
+            WebServer::getInstance().publishHealth();
+        });
     } else {
         Serial.println("❌ Failed to start WiFi Access Point.");
     }
 }
 
 /**
- * @brief 执行开机自动拨号功能
+ * @brief 启动阶段：探测GSM模块（初始化、网络注册与时间同步）
  * 
- * 检测运营商类型，如果是移动则自动拨打1008611并等待7秒后挂断
+ * 在独立任务中执行，与短信接收、数据库和Web服务的启动并行
+ * @return true 模块已注册网络
+ * @return false 探测失败（跳过开机拨号）
  */
-void performStartupCall() {
-    Serial.println("\n=== 开始执行开机自动拨号检测 ===");
-    
+bool probeModem() {
     // 获取GSM服务实例
     GsmService& gsmService = GsmService::getInstance();
     
     // 初始化GSM服务
     if (!gsmService.initialize()) {
         Serial.println("⚠️  GSM服务初始化失败，跳过开机拨号: " + gsmService.getLastError());
-        return;
+        return false;
     }
     
+    // 新消息指示配置完成前到达的短信只存入模块存储，再导入一次
+    uart_monitor_request_storage_drain();
+    
     // 检查GSM模块是否在线
     if (!gsmService.isModuleOnline()) {
         Serial.println("⚠️  GSM模块未在线，跳过开机拨号");
-        return;
+        return false;
+    }
+    
+    // 运营商与APN只在启动时解析一次，之后各模块读取运行配置快照
+    String imsi = gsmService.getImsi();
+    if (imsi.length() > 0) {
+        CarrierInfo carrier = CarrierConfig::getInstance().resolveCarrier(imsi);
+        ConfigManager::getInstance().setCarrier(imsi, carrier);
+        Serial.println("📱 运营商: " + carrier.name);
     }
     
     // 等待网络注册
     Serial.println("📡 等待网络注册...");
     if (!gsmService.waitForNetworkRegistration(15000)) {
         Serial.println("⚠️  网络注册超时，跳过开机拨号");
-        return;
+        return false;
     }
     
     // GSM服务初始化成功后，尝试同步网络时间
@@ -171,76 +345,103 @@ void performStartupCall() {
     } else {
         Serial.println("⚠️  获取网络时间失败: " + gsmService.getLastError());
     }
+    return true;
+}
+
+/**
+ * @brief 启动阶段：探测主模块以外的SIM模块（初始化与网络注册）
+ * 
+ * 运营商解析、时间同步与开机拨号只以主模块为准
+ * @return true 始终返回true（个别模块探测失败不影响其他模块）
+ */
+bool probeExtraModems() {
+    for (uint8_t modem = 1; modem < ModemArbiter::getModemCount(); modem++) {
+        GsmService& gsmService = GsmService::getModem(modem);
+        if (!gsmService.initialize()) {
+            Serial.println("⚠️  SIM" + String(modem + 1) + " GSM服务初始化失败: " + gsmService.getLastError());
+            continue;
+        }
+        uart_monitor_request_storage_drain(modem);
+        if (!gsmService.waitForNetworkRegistration(15000)) {
+            Serial.println("⚠️  SIM" + String(modem + 1) + " 网络注册超时，推送暂不经该模块发送");
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 输出开机自动拨号结果
+ * @param result 拨号结果
+ * @param error 错误描述
+ */
+void printStartupCallResult(PhoneCallResult result, const String& error) {
+    switch (result) {
+        case CALL_SUCCESS:
+            Serial.println("✅ 开机自动拨号成功完成");
+            break;
+        case CALL_ERROR_NETWORK_NOT_READY:
+            Serial.println("❌ 开机自动拨号失败: 网络未就绪");
+            break;
+        case CALL_ERROR_INVALID_NUMBER:
+            Serial.println("❌ 开机自动拨号失败: 号码格式无效");
+            break;
+        case CALL_ERROR_AT_COMMAND_FAILED:
+            Serial.println("❌ 开机自动拨号失败: AT命令执行失败");
+            break;
+        case CALL_ERROR_CALL_TIMEOUT:
+            Serial.println("❌ 开机自动拨号失败: 拨打超时");
+            break;
+        case CALL_ERROR_HANGUP_FAILED:
+            Serial.println("❌ 开机自动拨号失败: 挂断失败");
+            break;
+        case CALL_ERROR_NOT_CONNECTED:
+            Serial.println("❌ 开机自动拨号失败: 未接通");
+            break;
+        case CALL_ERROR_IN_PROGRESS:
+            Serial.println("❌ 开机自动拨号失败: 已有通话进行中");
+            break;
+        default:
+            Serial.println("❌ 开机自动拨号失败: 未知错误");
+            break;
+    }
     
-    // 获取IMSI号码
-    String imsi = gsmService.getImsi();
-    if (imsi.length() == 0) {
+    if (result != CALL_SUCCESS) {
+        Serial.println("🔍 拨号错误详情: " + error);
+    }
+}
+
+/**
+ * @brief 执行开机自动拨号功能（GSM探测完成后由定时任务延迟执行）
+ * 
+ * 检测运营商类型，如果是移动则自动拨打1008611，保持7秒后挂断（不阻塞调用方）
+ */
+void performStartupCall() {
+    Serial.println("\n=== 开始执行开机自动拨号检测 ===");
+    
+    // 运营商已在GSM探测阶段解析并写入运行配置快照
+    std::shared_ptr<const RuntimeConfig> config = ConfigManager::getInstance().getSnapshot();
+    if (config->imsi.length() == 0) {
         Serial.println("⚠️  无法获取IMSI号码，跳过开机拨号");
         return;
     }
     
-    Serial.println("📱 获取到IMSI: " + imsi);
-    
-    // 获取运营商配置实例并识别运营商
-    CarrierConfig& carrierConfig = CarrierConfig::getInstance();
-    CarrierType carrierType = carrierConfig.identifyCarrier(imsi);
+    Serial.println("📱 获取到IMSI: " + config->imsi);
+    CarrierType carrierType = config->carrier.type;
     
     // 检查是否为中国移动
     if (carrierType == CARRIER_CHINA_MOBILE) {
         Serial.println("📞 检测到中国移动网络，开始自动拨号1008611...");
         
-        // 获取电话拨打器实例
-        PhoneCaller phoneCaller;
-        
-        // 拨打1008611并等待7秒后挂断
-        PhoneCallResult result = phoneCaller.makeCallAndWait("1008611", 7);
-        
-        // 处理拨号结果
-        switch (result) {
-            case CALL_SUCCESS:
-                Serial.println("✅ 开机自动拨号成功完成");
-                break;
-            case CALL_ERROR_NETWORK_NOT_READY:
-                Serial.println("❌ 开机自动拨号失败: 网络未就绪");
-                break;
-            case CALL_ERROR_INVALID_NUMBER:
-                Serial.println("❌ 开机自动拨号失败: 号码格式无效");
-                break;
-            case CALL_ERROR_AT_COMMAND_FAILED:
-                Serial.println("❌ 开机自动拨号失败: AT命令执行失败");
-                break;
-            case CALL_ERROR_CALL_TIMEOUT:
-                Serial.println("❌ 开机自动拨号失败: 拨打超时");
-                break;
-            case CALL_ERROR_HANGUP_FAILED:
-                Serial.println("❌ 开机自动拨号失败: 挂断失败");
-                break;
-            default:
-                Serial.println("❌ 开机自动拨号失败: 未知错误");
-                break;
-        }
-        
+        // 拨号受理后立即返回，通话结果由通话状态上报驱动并在回调中输出
+        PhoneCallResult result = PhoneCaller::getInstance().startCall("1008611", 7, printStartupCallResult);
         if (result != CALL_SUCCESS) {
-            Serial.println("🔍 拨号错误详情: " + phoneCaller.getLastError());
+            printStartupCallResult(result, PhoneCaller::getInstance().getLastError());
         }
     } else {
-        String carrierName = carrierConfig.getCarrierName(carrierType);
-        Serial.println("📋 检测到运营商: " + carrierName + "，非移动网络，跳过开机拨号");
+        Serial.println("📋 检测到运营商: " + config->carrier.name + "，非移动网络，跳过开机拨号");
     }
     
     Serial.println("=== 开机自动拨号检测完成 ===");
-    
-    // GSM初始化完成后，启动UART监控任务
-    Serial.println("\n=== 启动UART监控任务 ===");
-    xTaskCreate(
-        uart_monitor_task,   // Task function
-        "UartMonitorTask",   // Task name
-        10000,               // Stack size (bytes)
-        NULL,                // Parameter
-        1,                   // Priority
-        NULL                 // Task handle
-    );
-    Serial.println("✓ UART Monitor Task started");
 }
 
 
@@ -253,7 +454,29 @@ void performStartupCall() {
 void setup() {
     // 初始化串口
     Serial.begin(115200);
+    simSerial.setRxBufferSize(SIM_UART_RX_BUFFER_SIZE); // 必须在begin()之前设置
     simSerial.begin(SIM_BAUD_RATE, SERIAL_8N1, SIM_RX_PIN, SIM_TX_PIN);
+#if SIM_MODEM_COUNT > 1
+    sim2Serial.setRxBufferSize(SIM_UART_RX_BUFFER_SIZE);
+    sim2Serial.begin(SIM_BAUD_RATE, SERIAL_8N1, SIM2_RX_PIN, SIM2_TX_PIN);
+#endif
+#if SIM_MODEM_COUNT > 2
+    sim3Serial.setRxBufferSize(SIM_UART_RX_BUFFER_SIZE);
+    sim3Serial.begin(SIM_BAUD_RATE, SERIAL_8N1, SIM3_RX_PIN, SIM3_TX_PIN);
+#endif
+    
+    // 启动各SIM模块的调制解调器仲裁器，此后SIM串口只由仲裁任务读写
+    for (uint8_t modem = 0; modem < ModemArbiter::getModemCount(); modem++) {
+        ModemArbiter& arbiter = ModemArbiter::getModem(modem);
+        if (!arbiter.initialize()) {
+            Serial.println("Failed to start Modem Arbiter for SIM" + String(modem + 1) + ": " + arbiter.getLastError());
+        }
+    }
+    
+    // 按配置启用动态调频与自动浅睡眠，SIM串口活动与RI引脚会唤醒系统
+    if (!PowerManager::getInstance().initialize()) {
+        Serial.println("Failed to enable power management: " + PowerManager::getInstance().getLastError());
+    }
     
     // 等待串口稳定
     delay(1000);
@@ -262,28 +485,43 @@ void setup() {
     Serial.println("    ESP32 SMS Relay System");
     Serial.println("    Version: 1.1.0 (Web UI Enabled)");
     Serial.println("    Build: " + String(__DATE__) + " " + String(__TIME__));
+    Serial.println("    Power: " + PowerManager::getInstance().getStatusInfo());
     Serial.println(String('=', 50));
     
-    // 初始化系统
-    if (!initializeSystem()) {
+    // 按依赖关系启动各组件：GSM探测在后台任务中进行，不阻塞短信接收与Web服务
+    BootSequencer& boot = BootSequencer::getInstance();
+    int logging = boot.addStage("logging", {}, initializeLogging, BOOT_STAGE_INLINE, true);
+    int modem = boot.addStage("modem_probe", {logging}, probeModem, BOOT_STAGE_ASYNC);
+    if (ModemArbiter::getModemCount() > 1) {
+        boot.addStage("modem_probe_extra", {logging}, probeExtraModems, BOOT_STAGE_ASYNC);
+    }
+    int storage = boot.addStage("storage", {logging}, initializeStorage, BOOT_STAGE_INLINE, true);
+    int services = boot.addStage("services", {storage}, initializeServices, BOOT_STAGE_INLINE, true);
+    boot.addStage("sms_ingestion", {services}, startSmsIngestion);
+    boot.addStage("wifi_web", {services}, []() {
+        initializeWifiAndWebServer();
+        return true;
+    });
+    boot.addStage("startup_call", {modem, services}, []() {
+        // 网络检查与ATD受理仍是同步AT往返，放到调度工作线程中执行
+        return TaskScheduler::getInstance().addOnceTask("startup_call", BOOT_STARTUP_CALL_DELAY_MS,
+                                                        performStartupCall, TASK_DISPATCH_WORKER) >= 0;
+    });
+    
+    if (!boot.run()) {
         Serial.println("\n❌ System initialization failed! Halting.");
+        Serial.println(boot.getReport());
         while (true) {
             delay(1000);
         }
     }
     
-    // 初始化WiFi和Web服务器
-    initializeWifiAndWebServer();
-    
     // 显示当前状态
     Serial.println("\n=== Current System Status ===");
     Serial.println("Total rules: " + String(terminalManager.getRuleCount()));
     Serial.println("Enabled rules: " + String(terminalManager.getEnabledRuleCount()));
     Serial.println("Free heap: " + String(ESP.getFreeHeap()) + " bytes");
     
-    // 执行开机自动拨号功能
-    performStartupCall();
-    
     // 启动CLI (作为备用接口)
     terminalManager.startCLI();
     
@@ -330,7 +568,8 @@ void loop() {
         logManager.logInfo(LOG_MODULE_SYSTEM, "System heartbeat - Rules: " + String(cachedRuleCount) + 
                       ", Enabled: " + String(cachedEnabledRuleCount) +
                       ", Free heap: " + String(freeHeap) + " bytes" +
-                      ", Free PSRAM: " + String(freePsram) + " bytes");
+                      ", Free PSRAM: " + String(freePsram) + " bytes" +
+                      ", Memory pressure: " + MemoryPressureManager::getInstance().getStatusInfo());
         lastHeartbeat = currentTime;
         
         // 每小时更新一次缓存的规则数量
@@ -341,25 +580,11 @@ void loop() {
         }
     }
     
-    // 内存监控和警告（每2分钟检查一次）
+    // PSRAM监控和警告（每2分钟检查一次；内部堆由memory_pressure定时任务管理）
     static unsigned long lastMemoryCheck = 0;
     if (currentTime - lastMemoryCheck > 120000) { // 改为2分钟
-        size_t freeHeap = ESP.getFreeHeap();
         size_t freePsram = ESP.getFreePsram();
         
-        // 检查堆内存
-        if (freeHeap < 15000) { // 提高警告阈值到15KB
-            Serial.println("⚠️  Low heap memory warning: " + String(freeHeap) + " bytes free");
-            logManager.logWarn(LOG_MODULE_SYSTEM, "WARNING: Low heap memory - " + String(freeHeap) + " bytes free");
-            
-            // 尝试释放一些内存
-            if (freeHeap < 10000) {
-                Serial.println("🔄 Attempting memory cleanup...");
-                // 强制垃圾回收（如果可用）
-                ESP.restart(); // 极端情况下重启系统
-            }
-        }
-        
         // 检查PSRAM内存
         if (freePsram < 50000) { // PSRAM警告阈值50KB
             Serial.println("⚠️  Low PSRAM warning: " + String(freePsram) + " bytes free");
@@ -369,6 +594,7 @@ void loop() {
         lastMemoryCheck = currentTime;
     }
     
-    // 短暂延迟，避免过度占用CPU
-    delay(10);
+    // 休眠到下一个定时任务到期（未启用浅睡眠时最长TASK_SCHEDULER_MAX_IDLE_MS，保证CLI输入及时处理）
+    unsigned long idleMs = taskScheduler.getMsUntilNextTask(PowerManager::getInstance().getMaxIdleMs());
+    delay(idleMs > 0 ? idleMs : 1);
 }
\ No newline at end of file
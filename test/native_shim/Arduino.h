@@ -0,0 +1,420 @@
+/**
+ * @file Arduino.h
+ * @brief 主机测试用Arduino替身 - 在[env:native]中代替arduino-esp32核心
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 该文件提供:
+ * 1. 以std::string实现的String，接口与arduino-esp32的WString一致（只含项目用到的部分）
+ * 2. millis()/micros()/delay()：以进程启动后的单调时钟计时
+ * 3. Print/Stream与HardwareSerial替身：发送的内容保存在缓冲区中，接收数据由测试注入
+ *
+ * 只用于主机测试，固件构建使用框架自带的Arduino.h
+ */
+
+#ifndef NATIVE_SHIM_ARDUINO_H
+#define NATIVE_SHIM_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#define F(s) (s)
+#define PROGMEM
+#define IRAM_ATTR
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+using std::min;
+using std::max;
+
+/**
+ * @class String
+ * @brief Arduino String替身
+ */
+class String {
+public:
+    String() {}
+    String(const char* cstr) : value(cstr != nullptr ? cstr : "") {}
+    String(const char* cstr, size_t length) : value(cstr != nullptr ? std::string(cstr, length) : std::string()) {}
+    String(const std::string& str) : value(str) {}
+    explicit String(char c) : value(1, c) {}
+    explicit String(unsigned char number, unsigned char base = DEC) : value(formatUnsigned(number, base)) {}
+    explicit String(int number, unsigned char base = DEC) : value(formatSigned(number, base)) {}
+    explicit String(unsigned int number, unsigned char base = DEC) : value(formatUnsigned(number, base)) {}
+    explicit String(long number, unsigned char base = DEC) : value(formatSigned(number, base)) {}
+    explicit String(unsigned long number, unsigned char base = DEC) : value(formatUnsigned(number, base)) {}
+    explicit String(long long number, unsigned char base = DEC) : value(formatSigned(number, base)) {}
+    explicit String(unsigned long long number, unsigned char base = DEC) : value(formatUnsigned(number, base)) {}
+    explicit String(float number, unsigned int decimalPlaces = 2) : value(formatFloat(number, decimalPlaces)) {}
+    explicit String(double number, unsigned int decimalPlaces = 2) : value(formatFloat(number, decimalPlaces)) {}
+
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    const char* c_str() const { return value.c_str(); }
+    char* begin() { return &value[0]; }
+    char* end() { return &value[0] + value.size(); }
+    const char* begin() const { return value.data(); }
+    const char* end() const { return value.data() + value.size(); }
+
+    bool reserve(unsigned int size) {
+        value.reserve(size);
+        return true;
+    }
+
+    bool concat(const String& str) { value += str.value; return true; }
+    bool concat(const char* cstr) { if (cstr == nullptr) return false; value += cstr; return true; }
+    bool concat(const char* cstr, unsigned int length) { if (cstr == nullptr) return false; value.append(cstr, length); return true; }
+    bool concat(char c) { value += c; return true; }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+    bool concat(T number) { return concat(String(number)); }
+
+    String& operator=(const char* cstr) { value = cstr != nullptr ? cstr : ""; return *this; }
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* cstr) { concat(cstr); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+    String& operator+=(T number) { concat(number); return *this; }
+
+    bool equals(const String& str) const { return value == str.value; }
+    bool equals(const char* cstr) const { return value == (cstr != nullptr ? cstr : ""); }
+    bool equalsIgnoreCase(const String& str) const {
+        if (value.size() != str.value.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < value.size(); i++) {
+            if (tolower((unsigned char)value[i]) != tolower((unsigned char)str.value[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    int compareTo(const String& str) const { return value.compare(str.value); }
+    bool operator==(const String& str) const { return value == str.value; }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& str) const { return value != str.value; }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& str) const { return value < str.value; }
+    bool operator>(const String& str) const { return value > str.value; }
+    bool operator<=(const String& str) const { return value <= str.value; }
+    bool operator>=(const String& str) const { return value >= str.value; }
+
+    bool startsWith(const String& prefix) const { return startsWith(prefix, 0); }
+    bool startsWith(const String& prefix, unsigned int offset) const {
+        return offset + prefix.value.size() <= value.size() &&
+               value.compare(offset, prefix.value.size(), prefix.value) == 0;
+    }
+    bool endsWith(const String& suffix) const {
+        return suffix.value.size() <= value.size() &&
+               value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+    }
+
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < value.size()) value[index] = c; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return value[index]; }
+
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const {
+        if (size == 0 || buffer == nullptr) {
+            return;
+        }
+        size_t count = index < value.size() ? std::min<size_t>(size - 1, value.size() - index) : 0;
+        memcpy(buffer, value.data() + index, count);
+        buffer[count] = 0;
+    }
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const {
+        getBytes((unsigned char*)buffer, size, index);
+    }
+
+    int indexOf(char c) const { return indexOf(c, 0); }
+    int indexOf(char c, unsigned int from) const { return toIndex(value.find(c, from)); }
+    int indexOf(const String& str) const { return indexOf(str, 0); }
+    int indexOf(const String& str, unsigned int from) const { return toIndex(value.find(str.value, from)); }
+    int lastIndexOf(char c) const { return toIndex(value.rfind(c)); }
+    int lastIndexOf(char c, unsigned int from) const { return toIndex(value.rfind(c, from)); }
+    int lastIndexOf(const String& str) const { return toIndex(value.rfind(str.value)); }
+    int lastIndexOf(const String& str, unsigned int from) const { return toIndex(value.rfind(str.value, from)); }
+
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, length()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const {
+        if (beginIndex > endIndex) {
+            std::swap(beginIndex, endIndex);
+        }
+        if (beginIndex >= value.size()) {
+            return String();
+        }
+        endIndex = std::min<unsigned int>(endIndex, length());
+        return String(value.substr(beginIndex, endIndex - beginIndex));
+    }
+
+    void replace(char find, char replacement) { std::replace(value.begin(), value.end(), find, replacement); }
+    void replace(const String& find, const String& replacement) {
+        if (find.value.empty()) {
+            return;
+        }
+        size_t position = 0;
+        while ((position = value.find(find.value, position)) != std::string::npos) {
+            value.replace(position, find.value.size(), replacement.value);
+            position += replacement.value.size();
+        }
+    }
+    void remove(unsigned int index) { if (index < value.size()) value.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < value.size()) value.erase(index, count); }
+    void toLowerCase() { for (char& c : value) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : value) c = (char)toupper((unsigned char)c); }
+    void trim() {
+        size_t first = 0;
+        while (first < value.size() && isspace((unsigned char)value[first])) {
+            first++;
+        }
+        size_t last = value.size();
+        while (last > first && isspace((unsigned char)value[last - 1])) {
+            last--;
+        }
+        value = value.substr(first, last - first);
+    }
+
+    long toInt() const { return atol(value.c_str()); }
+    float toFloat() const { return (float)atof(value.c_str()); }
+    double toDouble() const { return atof(value.c_str()); }
+
+private:
+    static int toIndex(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+
+    static std::string formatUnsigned(unsigned long long number, unsigned char base) {
+        if (base < 2 || base > 36) {
+            base = DEC;
+        }
+        char buffer[72];
+        size_t i = sizeof(buffer) - 1;
+        buffer[i] = '\0';
+        do {
+            unsigned digit = (unsigned)(number % base);
+            buffer[--i] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            number /= base;
+        } while (number > 0);
+        return std::string(buffer + i);
+    }
+
+    static std::string formatSigned(long long number, unsigned char base) {
+        if (base == DEC && number < 0) {
+            return "-" + formatUnsigned(0ULL - (unsigned long long)number, base);
+        }
+        // 与arduino-esp32一致：非十进制时按无符号位模式输出
+        return base == DEC ? formatUnsigned((unsigned long long)number, base)
+                           : formatUnsigned((unsigned long)number, base);
+    }
+
+    static std::string formatFloat(double number, unsigned int decimalPlaces) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimalPlaces, number);
+        return buffer;
+    }
+
+    std::string value;
+};
+
+inline String operator+(const String& lhs, const String& rhs) { String result(lhs); result += rhs; return result; }
+inline String operator+(const String& lhs, const char* rhs) { String result(lhs); result += rhs; return result; }
+inline String operator+(const char* lhs, const String& rhs) { String result(lhs); result += rhs; return result; }
+inline String operator+(const String& lhs, char rhs) { String result(lhs); result += rhs; return result; }
+template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+inline String operator+(const String& lhs, T rhs) { String result(lhs); result += rhs; return result; }
+inline bool operator==(const char* lhs, const String& rhs) { return rhs == lhs; }
+inline bool operator!=(const char* lhs, const String& rhs) { return rhs != lhs; }
+
+/**
+ * @brief 进程启动后的单调时钟
+ * @return std::chrono::steady_clock::time_point 起点
+ */
+inline std::chrono::steady_clock::time_point hostClockOrigin() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return origin;
+}
+
+inline unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - hostClockOrigin()).count();
+}
+
+inline unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - hostClockOrigin()).count();
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+inline bool psramFound() {
+    return false;
+}
+
+/**
+ * @class EspClass
+ * @brief 芯片信息替身（主机上没有对应的统计，返回固定值）
+ */
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 256 * 1024; }
+    uint32_t getMinFreeHeap() { return 256 * 1024; }
+    uint32_t getFreePsram() { return 0; }
+    uint32_t getFlashChipSize() { return 16 * 1024 * 1024; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint64_t getEfuseMac() { return 0; }
+    const char* getChipModel() { return "host"; }
+    void restart() { abort(); }
+};
+
+static EspClass ESP __attribute__((unused));
+
+/**
+ * @class Print
+ * @brief 字节输出基类
+ */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t written = 0;
+        while (size-- > 0) {
+            written += write(*buffer++);
+        }
+        return written;
+    }
+    size_t write(const char* str) { return str != nullptr ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const String& str) { return write(str.c_str(), str.length()); }
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+    size_t print(T number) { return print(String(number)); }
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { return print(value) + println(); }
+
+    size_t printf(const char* format, ...) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0) {
+            return 0;
+        }
+        return write(buffer, std::min<size_t>((size_t)length, sizeof(buffer) - 1));
+    }
+
+    virtual void flush() {}
+};
+
+/**
+ * @class Stream
+ * @brief 可读写的字节流
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t count = 0;
+        while (count < length && available() > 0) {
+            buffer[count++] = (uint8_t)read();
+        }
+        return count;
+    }
+};
+
+/**
+ * @class HardwareSerial
+ * @brief 串口替身：write()写入的内容保存在发送缓冲区，read()读取测试注入的数据
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud, uint32_t config = 0, int8_t rxPin = -1, int8_t txPin = -1) {
+        (void)config;
+        (void)rxPin;
+        (void)txPin;
+        baudRate = baud;
+    }
+    void end() {}
+    size_t setRxBufferSize(size_t size) { return size; }
+    unsigned long baudRate = 0;
+
+    size_t write(uint8_t c) override {
+        sent.push_back((char)c);
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        sent.append((const char*)buffer, size);
+        return size;
+    }
+    using Print::write;
+
+    int available() override { return (int)(received.size() - readPosition); }
+    int read() override { return readPosition < received.size() ? (uint8_t)received[readPosition++] : -1; }
+    int peek() override { return readPosition < received.size() ? (uint8_t)received[readPosition] : -1; }
+
+    /**
+     * @brief 注入接收数据（模拟对端发送）
+     * @param data 数据
+     */
+    void inject(const std::string& data) {
+        received.erase(0, readPosition);
+        readPosition = 0;
+        received += data;
+    }
+
+    /**
+     * @brief 取出并清空已发送的内容
+     * @return std::string 已发送的内容
+     */
+    std::string takeSent() {
+        std::string result;
+        result.swap(sent);
+        return result;
+    }
+
+private:
+    std::string sent;           ///< 已发送的内容
+    std::string received;       ///< 注入的接收数据
+    size_t readPosition = 0;    ///< 接收数据的读取位置
+};
+
+/**
+ * @brief 控制台串口（所有翻译单元共享同一个实例）
+ * @return HardwareSerial& 串口
+ */
+inline HardwareSerial& hostSerial() {
+    static HardwareSerial serial;
+    return serial;
+}
+
+static HardwareSerial& Serial = hostSerial();
+
+#endif // NATIVE_SHIM_ARDUINO_H
@@ -0,0 +1,137 @@
+/**
+ * @file FS.h
+ * @brief 主机测试用文件系统替身 - fs::FS与File映射到主机目录
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 设备上的路径"/a/b"对应主机目录root下的"a/b"，root由LittleFS.begin()创建
+ */
+
+#ifndef NATIVE_SHIM_FS_H
+#define NATIVE_SHIM_FS_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+#include <memory>
+
+namespace fs {
+
+/**
+ * @class File
+ * @brief 打开的文件（以FILE*实现，拷贝共享同一句柄）
+ */
+class File : public Stream {
+public:
+    File() {}
+    File(FILE* handle, const String& path, bool directory)
+        : handle(handle != nullptr ? std::shared_ptr<FILE>(handle, fclose) : nullptr), filePath(path),
+          directory(directory) {}
+
+    explicit operator bool() const { return handle != nullptr || directory; }
+    bool isDirectory() const { return directory; }
+    const char* path() const { return filePath.c_str(); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        return handle != nullptr ? fwrite(buffer, 1, size, handle.get()) : 0;
+    }
+    using Print::write;
+
+    int available() override { return handle != nullptr ? (int)(size() - position()) : 0; }
+    int read() override {
+        int c = handle != nullptr ? fgetc(handle.get()) : EOF;
+        return c == EOF ? -1 : c;
+    }
+    int peek() override {
+        int c = read();
+        if (c >= 0) {
+            ungetc(c, handle.get());
+        }
+        return c;
+    }
+    size_t read(uint8_t* buffer, size_t size) {
+        return handle != nullptr ? fread(buffer, 1, size, handle.get()) : 0;
+    }
+    bool seek(uint32_t position) { return handle != nullptr && fseek(handle.get(), position, SEEK_SET) == 0; }
+    size_t position() const { return handle != nullptr ? (size_t)ftell(handle.get()) : 0; }
+    size_t size() const {
+        struct stat info;
+        return handle != nullptr && fstat(fileno(handle.get()), &info) == 0 ? (size_t)info.st_size : 0;
+    }
+    time_t getLastWrite() const {
+        struct stat info;
+        return handle != nullptr && fstat(fileno(handle.get()), &info) == 0 ? info.st_mtime : 0;
+    }
+    void flush() override {
+        if (handle != nullptr) {
+            fflush(handle.get());
+        }
+    }
+    void close() {
+        handle.reset();
+        directory = false;
+    }
+
+private:
+    std::shared_ptr<FILE> handle;   ///< 文件句柄
+    String filePath;                ///< 设备上的路径
+    bool directory = false;         ///< 是否为目录
+};
+
+/**
+ * @class FS
+ * @brief 文件系统：设备路径映射到主机目录
+ */
+class FS {
+public:
+    virtual ~FS() {}
+
+    File open(const String& path, const char* mode = "r", bool create = false) {
+        (void)create;
+        String hostFile = hostPath(path);
+        struct stat info;
+        if (stat(hostFile.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            return File(nullptr, path, true);
+        }
+        // "w"/"a"与设备一致：不存在时创建；"r"以"rb"打开
+        String hostMode = String(mode) + "b";
+        return File(fopen(hostFile.c_str(), hostMode.c_str()), path, false);
+    }
+    bool exists(const String& path) {
+        struct stat info;
+        return !root.isEmpty() && stat(hostPath(path).c_str(), &info) == 0;
+    }
+    bool remove(const String& path) { return !root.isEmpty() && ::unlink(hostPath(path).c_str()) == 0; }
+    bool rename(const String& from, const String& to) {
+        return !root.isEmpty() && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+    }
+    bool mkdir(const String& path) { return !root.isEmpty() && ::mkdir(hostPath(path).c_str(), 0755) == 0; }
+    bool rmdir(const String& path) { return !root.isEmpty() && ::rmdir(hostPath(path).c_str()) == 0; }
+
+    /**
+     * @brief 设备路径对应的主机路径
+     * @param path 设备路径
+     * @return String 主机路径
+     */
+    String hostPath(const String& path) const {
+        return path.startsWith("/") ? root + path : root + "/" + path;
+    }
+
+    /**
+     * @brief 主机上的根目录（未挂载时为空）
+     * @return const String& 根目录
+     */
+    const String& getRoot() const { return root; }
+
+protected:
+    String root;    ///< 主机上的根目录
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // NATIVE_SHIM_FS_H
@@ -0,0 +1,102 @@
+/**
+ * @file LittleFS.h
+ * @brief 主机测试用LittleFS替身 - begin()在临时目录中"挂载"文件系统
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef NATIVE_SHIM_LITTLEFS_H
+#define NATIVE_SHIM_LITTLEFS_H
+
+#include "FS.h"
+#include <dirent.h>
+
+namespace fs {
+
+/**
+ * @class LittleFSFS
+ * @brief LittleFS替身：每次挂载使用一个新建的临时目录，卸载时删除
+ */
+class LittleFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs") {
+        (void)formatOnFail;
+        (void)maxOpenFiles;
+        (void)partitionLabel;
+        if (!root.isEmpty()) {
+            return true;
+        }
+        char pattern[] = "/tmp/esp-sms-relay-XXXXXX";
+        if (mkdtemp(pattern) == nullptr) {
+            return false;
+        }
+        root = pattern;
+        mountPoint = basePath;
+        return true;
+    }
+    void end() {
+        if (!root.isEmpty()) {
+            removeTree(root);
+            root = "";
+        }
+    }
+    bool format() {
+        if (root.isEmpty()) {
+            return false;
+        }
+        removeTree(root);
+        return ::mkdir(root.c_str(), 0755) == 0;
+    }
+    size_t totalBytes() { return 4 * 1024 * 1024; }
+    size_t usedBytes() { return 0; }
+
+    /**
+     * @brief 挂载点（设备上SQLite等以"<挂载点>/文件"访问）
+     * @return const String& 挂载点
+     */
+    const String& getMountPoint() const { return mountPoint; }
+
+private:
+    /**
+     * @brief 递归删除主机目录
+     * @param path 目录
+     */
+    static void removeTree(const String& path) {
+        DIR* dir = opendir(path.c_str());
+        if (dir != nullptr) {
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+                String child = path + "/" + entry->d_name;
+                struct stat info;
+                if (stat(child.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+                    removeTree(child);
+                } else {
+                    ::unlink(child.c_str());
+                }
+            }
+            closedir(dir);
+        }
+        ::rmdir(path.c_str());
+    }
+
+    String mountPoint;  ///< 挂载点
+};
+
+} // namespace fs
+
+/**
+ * @brief LittleFS实例（所有翻译单元共享）
+ * @return fs::LittleFSFS& 文件系统
+ */
+inline fs::LittleFSFS& hostLittleFS() {
+    static fs::LittleFSFS littleFS;
+    return littleFS;
+}
+
+static fs::LittleFSFS& LittleFS = hostLittleFS();
+
+#endif // NATIVE_SHIM_LITTLEFS_H
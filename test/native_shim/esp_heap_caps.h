@@ -0,0 +1,33 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief 主机测试用heap_caps替身 - 所有能力的内存都从主机堆分配
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef NATIVE_SHIM_ESP_HEAP_CAPS_H
+#define NATIVE_SHIM_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+inline void* heap_caps_calloc(size_t count, size_t size, uint32_t caps) { (void)caps; return calloc(count, size); }
+inline void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps) { (void)caps; return realloc(ptr, size); }
+inline void heap_caps_free(void* ptr) { free(ptr); }
+
+/// 主机上没有对应的统计，按8MB空闲报告
+inline size_t heap_caps_get_free_size(uint32_t caps) { (void)caps; return 8 * 1024 * 1024; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { (void)caps; return 8 * 1024 * 1024; }
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { (void)caps; return 8 * 1024 * 1024; }
+
+#endif // NATIVE_SHIM_ESP_HEAP_CAPS_H
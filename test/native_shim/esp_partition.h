@@ -0,0 +1,153 @@
+/**
+ * @file esp_partition.h
+ * @brief 主机测试用分区替身 - 内存中的数据分区，按NOR flash的规则擦写
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 分区由测试以hostPartitionCreate()创建；写入只能把1改为0（与flash相同），
+ * 擦除以4KB扇区为单位恢复为0xFF
+ */
+
+#ifndef NATIVE_SHIM_ESP_PARTITION_H
+#define NATIVE_SHIM_ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff
+} esp_partition_subtype_t;
+
+/**
+ * @struct esp_partition_t
+ * @brief 分区描述
+ */
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+/**
+ * @struct HostPartition
+ * @brief 内存中的分区
+ */
+struct HostPartition {
+    esp_partition_t info;           ///< 分区描述
+    std::vector<uint8_t> data;      ///< 分区内容
+};
+
+/**
+ * @brief 已创建的分区
+ * @return std::vector<std::unique_ptr<HostPartition>>& 分区列表
+ */
+inline std::vector<std::unique_ptr<HostPartition>>& hostPartitions() {
+    static std::vector<std::unique_ptr<HostPartition>> partitions;
+    return partitions;
+}
+
+/**
+ * @brief 查找内存分区
+ * @param partition 分区描述
+ * @return HostPartition* 分区，不存在时为nullptr
+ */
+inline HostPartition* hostPartitionOf(const esp_partition_t* partition) {
+    for (auto& entry : hostPartitions()) {
+        if (&entry->info == partition) {
+            return entry.get();
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 创建（或以擦除状态重建）一个数据分区
+ * @param label 分区标签
+ * @param size 分区大小（4KB的整数倍）
+ * @return const esp_partition_t* 分区描述
+ */
+inline const esp_partition_t* hostPartitionCreate(const char* label, uint32_t size) {
+    for (auto& entry : hostPartitions()) {
+        if (strcmp(entry->info.label, label) == 0) {
+            entry->info.size = size;
+            entry->data.assign(size, 0xFF);
+            return &entry->info;
+        }
+    }
+    std::unique_ptr<HostPartition> partition(new HostPartition());
+    memset(&partition->info, 0, sizeof(partition->info));
+    partition->info.type = ESP_PARTITION_TYPE_DATA;
+    partition->info.subtype = ESP_PARTITION_SUBTYPE_ANY;
+    partition->info.size = size;
+    partition->info.erase_size = 4096;
+    strncpy(partition->info.label, label, sizeof(partition->info.label) - 1);
+    partition->data.assign(size, 0xFF);
+    hostPartitions().push_back(std::move(partition));
+    return &hostPartitions().back()->info;
+}
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                       const char* label) {
+    for (auto& entry : hostPartitions()) {
+        if (entry->info.type == type &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || entry->info.subtype == subtype) &&
+            (label == nullptr || strcmp(entry->info.label, label) == 0)) {
+            return &entry->info;
+        }
+    }
+    return nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+    HostPartition* host = hostPartitionOf(partition);
+    if (host == nullptr || offset + size > host->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, host->data.data() + offset, size);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+    HostPartition* host = hostPartitionOf(partition);
+    if (host == nullptr || offset + size > host->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        host->data[offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    HostPartition* host = hostPartitionOf(partition);
+    if (host == nullptr || offset + size > host->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (offset % partition->erase_size != 0 || size % partition->erase_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(host->data.data() + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+#endif // NATIVE_SHIM_ESP_PARTITION_H
@@ -0,0 +1,32 @@
+/**
+ * @file esp_rom_crc.h
+ * @brief 主机测试用ROM CRC替身
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef NATIVE_SHIM_ESP_ROM_CRC_H
+#define NATIVE_SHIM_ESP_ROM_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief CRC32（小端，多项式0xEDB88320，与ROM实现相同：crc参数为上一段的结果）
+ * @param crc 初始值
+ * @param buf 数据
+ * @param len 长度
+ * @return uint32_t CRC
+ */
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    while (len-- > 0) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+#endif // NATIVE_SHIM_ESP_ROM_CRC_H
@@ -0,0 +1,15 @@
+/**
+ * @file esp_spi_flash.h
+ * @brief 主机测试用spi_flash替身（未启用CONFIG_SPI_FLASH_ENABLE_COUNTERS）
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef NATIVE_SHIM_ESP_SPI_FLASH_H
+#define NATIVE_SHIM_ESP_SPI_FLASH_H
+
+#include <stdint.h>
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+#endif // NATIVE_SHIM_ESP_SPI_FLASH_H
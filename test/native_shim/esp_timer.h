@@ -0,0 +1,22 @@
+/**
+ * @file esp_timer.h
+ * @brief 主机测试用esp_timer替身
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef NATIVE_SHIM_ESP_TIMER_H
+#define NATIVE_SHIM_ESP_TIMER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief 启动后的微秒数
+ * @return int64_t 微秒
+ */
+inline int64_t esp_timer_get_time() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - hostClockOrigin()).count();
+}
+
+#endif // NATIVE_SHIM_ESP_TIMER_H
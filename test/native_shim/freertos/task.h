@@ -0,0 +1,33 @@
+/**
+ * @file task.h
+ * @brief 主机测试用FreeRTOS任务接口替身 - 任务句柄对应主机线程
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#ifndef NATIVE_SHIM_FREERTOS_TASK_H
+#define NATIVE_SHIM_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+#include <Arduino.h>
+
+typedef void* TaskHandle_t;
+
+/**
+ * @brief 当前线程的任务句柄（每个线程一个不同的地址）
+ * @return TaskHandle_t 任务句柄
+ */
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    static thread_local char marker;
+    return &marker;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+inline TickType_t xTaskGetTickCount() {
+    return (TickType_t)(millis() / portTICK_PERIOD_MS);
+}
+
+#endif // NATIVE_SHIM_FREERTOS_TASK_H
@@ -0,0 +1,30 @@
+/**
+ * @file host_benchmark.h
+ * @brief 主机测试中的基准测量 - 以设备上bench命令相同的执行器计时并输出结果
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 测试组须同时编译lib/benchmark/benchmark_runner.cpp
+ */
+
+#ifndef NATIVE_SHIM_HOST_BENCHMARK_H
+#define NATIVE_SHIM_HOST_BENCHMARK_H
+
+#include <unity.h>
+#include "../../lib/benchmark/benchmark.h"
+#include "../../include/constants.h"
+
+/// 主机测试中每项测量的执行次数（与设备上离线测试组的默认次数相同）
+#define HOST_BENCH_ITERATIONS BENCH_DEFAULT_ITERATIONS
+
+/**
+ * @brief 输出测量结果，测量未执行或被测代码报告失败时测试失败
+ * @param result 测量结果
+ */
+inline void reportBenchmark(const BenchmarkResult& result) {
+    TEST_MESSAGE(Benchmark::format(result).c_str());
+    TEST_ASSERT_TRUE_MESSAGE(result.iterations > 0, result.name.c_str());
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, result.failures, result.name.c_str());
+}
+
+#endif // NATIVE_SHIM_HOST_BENCHMARK_H
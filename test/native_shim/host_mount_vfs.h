@@ -0,0 +1,70 @@
+/**
+ * @file host_mount_vfs.h
+ * @brief 主机测试用SQLite挂载点映射 - 让"/littlefs/..."路径落到LittleFS替身的主机目录
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * 设备上LittleFS挂载到/littlefs后，SQLite直接以该前缀的路径打开数据库；
+ * 主机上注册一个默认VFS，在计算完整路径时把挂载点替换为主机目录，其余操作交给系统VFS
+ */
+
+#ifndef NATIVE_SHIM_HOST_MOUNT_VFS_H
+#define NATIVE_SHIM_HOST_MOUNT_VFS_H
+
+#include <LittleFS.h>
+#include <sqlite3.h>
+#include <string>
+
+/**
+ * @struct HostMountVfsState
+ * @brief 映射状态
+ */
+struct HostMountVfsState {
+    sqlite3_vfs vfs;            ///< 注册的VFS（除xFullPathname外与系统VFS相同）
+    sqlite3_vfs* base;          ///< 系统VFS
+    std::string mountPoint;     ///< 挂载点（如"/littlefs"）
+    std::string root;           ///< 主机目录
+};
+
+inline HostMountVfsState& hostMountVfsState() {
+    static HostMountVfsState state;
+    return state;
+}
+
+inline int hostMountFullPathname(sqlite3_vfs* vfs, const char* name, int size, char* out) {
+    (void)vfs;
+    HostMountVfsState& state = hostMountVfsState();
+    std::string path = name;
+    if (path.compare(0, state.mountPoint.size() + 1, state.mountPoint + "/") == 0) {
+        path = state.root + path.substr(state.mountPoint.size());
+    }
+    return state.base->xFullPathname(state.base, path.c_str(), size, out);
+}
+
+/**
+ * @brief 把LittleFS替身的挂载点映射给SQLite（须在LittleFS.begin()之后调用）
+ * @return true 已注册为默认VFS
+ * @return false LittleFS未挂载或注册失败
+ */
+inline bool hostMountSqlite() {
+    HostMountVfsState& state = hostMountVfsState();
+    if (LittleFS.getRoot().isEmpty()) {
+        return false;
+    }
+    state.mountPoint = LittleFS.getMountPoint().c_str();
+    state.root = LittleFS.getRoot().c_str();
+    if (state.base == nullptr) {
+        sqlite3_initialize();
+        state.base = sqlite3_vfs_find(nullptr);
+        if (state.base == nullptr) {
+            return false;
+        }
+        state.vfs = *state.base;
+        state.vfs.zName = "hostmount";
+        state.vfs.pNext = nullptr;
+        state.vfs.xFullPathname = hostMountFullPathname;
+    }
+    return sqlite3_vfs_register(&state.vfs, 1) == SQLITE_OK;
+}
+
+#endif // NATIVE_SHIM_HOST_MOUNT_VFS_H
@@ -0,0 +1,75 @@
+/**
+ * @file test_carrier_config.cpp
+ * @brief 运营商配置主机测试：IMSI前缀识别与运营商参数表
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include "../../lib/carrier_config/carrier_config.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_identify_by_prefix() {
+    CarrierConfig& config = CarrierConfig::getInstance();
+    TEST_ASSERT_EQUAL_INT(CARRIER_CHINA_MOBILE, config.identifyCarrier("460001234567890"));
+    TEST_ASSERT_EQUAL_INT(CARRIER_CHINA_MOBILE, config.identifyCarrier("460081234567890"));
+    TEST_ASSERT_EQUAL_INT(CARRIER_CHINA_UNICOM, config.identifyCarrier("460011234567890"));
+    TEST_ASSERT_EQUAL_INT(CARRIER_CHINA_UNICOM, config.identifyCarrier("460091234567890"));
+    TEST_ASSERT_EQUAL_INT(CARRIER_CHINA_TELECOM, config.identifyCarrier("460111234567890"));
+    TEST_ASSERT_EQUAL_INT(CARRIER_UNKNOWN, config.identifyCarrier("310260123456789"));
+}
+
+static void test_rejects_invalid_imsi() {
+    CarrierConfig& config = CarrierConfig::getInstance();
+    TEST_ASSERT_FALSE(config.isValidImsi(""));
+    TEST_ASSERT_FALSE(config.isValidImsi("46000123456789"));
+    TEST_ASSERT_FALSE(config.isValidImsi("46000123456789A"));
+    TEST_ASSERT_TRUE(config.isValidImsi("460001234567890"));
+    TEST_ASSERT_EQUAL_INT(CARRIER_UNKNOWN, config.identifyCarrier("4600012345"));
+}
+
+static void test_carrier_profiles() {
+    CarrierConfig& config = CarrierConfig::getInstance();
+    CarrierInfo telecom = config.resolveCarrier("460111234567890");
+    TEST_ASSERT_EQUAL_INT(CARRIER_CHINA_TELECOM, telecom.type);
+    TEST_ASSERT_EQUAL_STRING("ctnet", telecom.apnConfig.apn.c_str());
+    TEST_ASSERT_EQUAL_STRING("PAP", telecom.apnConfig.authType.c_str());
+
+    CarrierInfo unicom = config.getCarrierInfo(CARRIER_CHINA_UNICOM);
+    TEST_ASSERT_EQUAL_STRING("3gnet", unicom.apnConfig.apn.c_str());
+    TEST_ASSERT_EQUAL_STRING("+8613010112500", unicom.smsCenterNumber.c_str());
+
+    // 未知运营商使用第一项的默认值
+    CarrierInfo unknown = config.resolveCarrier("310260123456789");
+    TEST_ASSERT_EQUAL_INT(CARRIER_UNKNOWN, unknown.type);
+    TEST_ASSERT_TRUE(unknown.apnConfig.apn.isEmpty());
+    TEST_ASSERT_EQUAL_STRING("中国移动", config.getCarrierName(CARRIER_CHINA_MOBILE).c_str());
+}
+
+static void test_bench_identify() {
+    static const char* imsis[] = {
+        "460001234567890", "460011234567890", "460111234567890", "310260123456789"
+    };
+    CarrierConfig& config = CarrierConfig::getInstance();
+    reportBenchmark(Benchmark::run("carrier/识别IMSI", HOST_BENCH_ITERATIONS, [&]() {
+        for (const char* imsi : imsis) {
+            config.identifyCarrier(String(imsi));
+        }
+    }));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_identify_by_prefix);
+    RUN_TEST(test_rejects_invalid_imsi);
+    RUN_TEST(test_carrier_profiles);
+    RUN_TEST(test_bench_identify);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+/**
+ * @file test_database_manager.cpp
+ * @brief 数据库管理器主机测试：在主机SQLite上验证建表、短信/规则/发件箱读写、事务与原始分区VFS
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ *
+ * LittleFS替身把数据库文件放在临时目录中，每个用例使用一个新建的空数据库
+ */
+
+#include <unity.h>
+#include "../../lib/filesystem_manager/filesystem_manager.cpp"
+#include "../../lib/flash_vfs/flash_vfs.cpp"
+#include "../../lib/database_manager/database_manager.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_mount_vfs.h"
+#include "../native_shim/host_benchmark.h"
+
+static DatabaseManager& database = DatabaseManager::getInstance();
+
+void setUp() {
+    TEST_ASSERT_TRUE(FilesystemManager::getInstance().initialize());
+    hostMountSqlite();
+    TEST_ASSERT_TRUE_MESSAGE(database.initialize("sms_relay.db"), database.getLastError().c_str());
+}
+
+void tearDown() {
+    database.close();
+    LittleFS.format();
+}
+
+/**
+ * @brief 构造一条短信记录
+ * @param from 发送方号码
+ * @param content 短信内容
+ * @param receivedAt 接收时间
+ * @return SMSRecord 记录
+ */
+static SMSRecord makeRecord(const String& from, const String& content, time_t receivedAt) {
+    SMSRecord record;
+    record.id = 0;
+    record.fromNumber = from;
+    record.toNumber = "";
+    record.content = content;
+    record.ruleId = 0;
+    record.forwarded = false;
+    record.status = "received";
+    record.forwardedAt = "";
+    record.receivedAt = receivedAt;
+    return record;
+}
+
+static void test_initialize_creates_schema() {
+    TEST_ASSERT_TRUE(database.isReady());
+    TEST_ASSERT_TRUE(LittleFS.exists("/sms_relay.db"));
+    TEST_ASSERT_EQUAL_INT(0, database.getSMSRecordCount());
+    TEST_ASSERT_EQUAL_INT(0, database.getPushOutboxCount());
+
+    // 默认AP配置在首次建库时写入
+    APConfig ap = database.getAPConfig();
+    TEST_ASSERT_FALSE(ap.ssid.isEmpty());
+}
+
+static void test_sms_record_roundtrip_and_paging() {
+    int first = database.addSMSRecord(makeRecord("+8613800000001", "验证码 123456", 1700000000));
+    int second = database.addSMSRecord(makeRecord("10086", "Balance: 12.50", 1700000100));
+    TEST_ASSERT_TRUE(first > 0);
+    TEST_ASSERT_TRUE(second > first);
+    TEST_ASSERT_TRUE(database.flushGroupCommit(true));
+    TEST_ASSERT_EQUAL_INT(2, database.getSMSRecordCount());
+
+    SMSRecord loaded = database.getSMSRecordById(first);
+    TEST_ASSERT_EQUAL_INT(first, loaded.id);
+    TEST_ASSERT_EQUAL_STRING("+8613800000001", loaded.fromNumber.c_str());
+    TEST_ASSERT_EQUAL_STRING("验证码 123456", loaded.content.c_str());
+    TEST_ASSERT_EQUAL_INT((int)1700000000, (int)loaded.receivedAt);
+
+    // 分页按接收时间倒序
+    std::vector<SMSRecord> page = database.getSMSRecords(1, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, page.size());
+    TEST_ASSERT_EQUAL_INT(second, page[0].id);
+    page = database.getSMSRecords(10, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, page.size());
+    TEST_ASSERT_EQUAL_INT(first, page[0].id);
+
+    loaded.forwarded = true;
+    loaded.status = "forwarded";
+    TEST_ASSERT_TRUE(database.updateSMSRecord(loaded));
+    TEST_ASSERT_EQUAL_STRING("forwarded", database.getSMSRecordById(first).status.c_str());
+}
+
+static void test_search_sms() {
+    database.addSMSRecord(makeRecord("95588", "您的验证码是 884422，五分钟内有效", 1700000000));
+    database.addSMSRecord(makeRecord("10086", "流量提醒：本月已使用 80%", 1700000100));
+    database.addSMSRecord(makeRecord("95555", "验证码 119900，请勿泄露", 1700000200));
+    TEST_ASSERT_TRUE(database.flushGroupCommit(true));
+
+    std::vector<SMSRecord> found = database.searchSMS("验证码", 20);
+    TEST_ASSERT_EQUAL_UINT32(2, found.size());
+    for (const SMSRecord& record : found) {
+        TEST_ASSERT_TRUE(record.content.indexOf("验证码") >= 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, database.searchSMS("流量", 20).size());
+    TEST_ASSERT_EQUAL_UINT32(0, database.searchSMS("不存在的关键词", 20).size());
+}
+
+static void test_forward_rule_crud() {
+    ForwardRule rule;
+    rule.id = 0;
+    rule.ruleName = "银行验证码";
+    rule.sourceNumber = "955*";
+    rule.keywords = "验证码";
+    rule.pushType = "webhook";
+    rule.pushConfig = "{\"webhook_url\":\"http://example.com/hook\"}";
+    rule.enabled = true;
+    rule.isDefaultForward = false;
+    rule.priority = 10;
+
+    int before = database.getForwardRuleCount();
+    int ruleId = database.addForwardRule(rule);
+    TEST_ASSERT_TRUE(ruleId > 0);
+    TEST_ASSERT_EQUAL_INT(before + 1, database.getForwardRuleCount());
+
+    ForwardRule loaded = database.getForwardRuleById(ruleId);
+    TEST_ASSERT_EQUAL_STRING("银行验证码", loaded.ruleName.c_str());
+    TEST_ASSERT_EQUAL_STRING("955*", loaded.sourceNumber.c_str());
+    TEST_ASSERT_EQUAL_INT(10, loaded.priority);
+    TEST_ASSERT_TRUE(loaded.enabled);
+
+    loaded.enabled = false;
+    TEST_ASSERT_TRUE(database.updateForwardRule(loaded));
+    TEST_ASSERT_FALSE(database.getForwardRuleById(ruleId).enabled);
+
+    TEST_ASSERT_TRUE(database.deleteForwardRule(ruleId));
+    TEST_ASSERT_EQUAL_INT(before, database.getForwardRuleCount());
+}
+
+static void test_push_outbox_due_entries() {
+    int smsId = database.addSMSRecord(makeRecord("10086", "outbox", 1700000000));
+    TEST_ASSERT_TRUE(smsId > 0);
+
+    PushOutboxEntry entry;
+    entry.id = 0;
+    entry.smsId = smsId;
+    entry.ruleId = 1;
+    entry.attempt = 1;
+    entry.nextAttemptAt = 1700000060;
+    entry.lastError = "HTTP 502";
+    entry.createdAt = 1700000000;
+    entry.followerRuleIds = "3,7";
+    int dueId = database.addPushOutboxEntry(entry);
+    entry.nextAttemptAt = 1700003600;
+    entry.followerRuleIds = "";
+    int laterId = database.addPushOutboxEntry(entry);
+    TEST_ASSERT_TRUE(dueId > 0);
+    TEST_ASSERT_TRUE(laterId > dueId);
+    TEST_ASSERT_TRUE(database.flushGroupCommit(true));
+    TEST_ASSERT_EQUAL_INT(2, database.getPushOutboxCount());
+
+    std::vector<PushOutboxEntry> due = database.getDuePushOutboxEntries(1700000100, 86400, 10);
+    TEST_ASSERT_EQUAL_UINT32(1, due.size());
+    TEST_ASSERT_EQUAL_INT(dueId, due[0].id);
+    TEST_ASSERT_EQUAL_STRING("HTTP 502", due[0].lastError.c_str());
+    TEST_ASSERT_EQUAL_STRING("3,7", due[0].followerRuleIds.c_str());
+
+    // 下次尝试时间超出最大退避时长视为时钟回拨，同样到期
+    TEST_ASSERT_EQUAL_UINT32(2, database.getDuePushOutboxEntries(1700000100, 600, 10).size());
+
+    TEST_ASSERT_TRUE(database.deletePushOutboxEntry(dueId));
+    TEST_ASSERT_EQUAL_INT(1, database.getPushOutboxCount());
+}
+
+static void test_rollback_discards_writes() {
+    TEST_ASSERT_TRUE(database.flushGroupCommit(true));
+    TEST_ASSERT_TRUE(database.beginTransaction());
+    database.addSMSRecord(makeRecord("10086", "rolled back", 1700000000));
+    TEST_ASSERT_TRUE(database.rollbackTransaction());
+    TEST_ASSERT_EQUAL_INT(0, database.getSMSRecordCount());
+}
+
+static void test_records_survive_reopen() {
+    database.addSMSRecord(makeRecord("10086", "persisted", 1700000000));
+    TEST_ASSERT_TRUE(database.close());
+    TEST_ASSERT_TRUE_MESSAGE(database.initialize("sms_relay.db"), database.getLastError().c_str());
+    TEST_ASSERT_EQUAL_INT(1, database.getSMSRecordCount());
+    TEST_ASSERT_EQUAL_STRING("persisted", database.getSMSRecords(1, 0)[0].content.c_str());
+}
+
+static void test_flash_vfs_roundtrip() {
+    hostPartitionCreate(DB_RAW_PARTITION_LABEL, (DB_RAW_JOURNAL_SECTORS + 64) * DB_RAW_SECTOR_SIZE);
+    FlashVfs& flashVfs = FlashVfs::getInstance();
+    TEST_ASSERT_TRUE_MESSAGE(flashVfs.initialize(), flashVfs.getLastError().c_str());
+    TEST_ASSERT_TRUE(flashVfs.format());
+
+    sqlite3* raw = nullptr;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open_v2("/littlefs/raw.db", &raw, flags, DB_RAW_VFS_NAME));
+    // 原始分区只支持回滚日志
+    TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_exec(raw,
+        "PRAGMA journal_mode = DELETE;"
+        "CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT);"
+        "INSERT INTO t(v) VALUES('a'),('b'),('c');", nullptr, nullptr, nullptr));
+    sqlite3_close(raw);
+    TEST_ASSERT_TRUE(flashVfs.hasDatabase());
+
+    // 重新打开后数据仍在
+    TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_open_v2("/littlefs/raw.db", &raw, SQLITE_OPEN_READWRITE, DB_RAW_VFS_NAME));
+    sqlite3_stmt* stmt = nullptr;
+    TEST_ASSERT_EQUAL_INT(SQLITE_OK, sqlite3_prepare_v2(raw, "SELECT COUNT(*) FROM t", -1, &stmt, nullptr));
+    TEST_ASSERT_EQUAL_INT(SQLITE_ROW, sqlite3_step(stmt));
+    TEST_ASSERT_EQUAL_INT(3, sqlite3_column_int(stmt, 0));
+    sqlite3_finalize(stmt);
+    sqlite3_close(raw);
+    TEST_ASSERT_TRUE(flashVfs.getStats().bytesProgrammed > 0);
+}
+
+static void test_bench_db_query() {
+    TEST_ASSERT_TRUE(database.beginTransaction());
+    for (int i = 0; i < 500; i++) {
+        String content = (i % 10 == 0) ? "验证码 " + String(100000 + i) : "普通通知 " + String(i);
+        database.addSMSRecord(makeRecord("1068" + String(i % 50), content, 1700000000 + i));
+    }
+    TEST_ASSERT_TRUE(database.commitTransaction());
+
+    reportBenchmark(Benchmark::run("db-query/最近20条", HOST_BENCH_ITERATIONS, [&]() {
+        database.getSMSRecords(20, 0);
+    }));
+    reportBenchmark(Benchmark::run("db-query/记录总数", HOST_BENCH_ITERATIONS, [&]() {
+        database.getSMSRecordCount();
+    }));
+    reportBenchmark(Benchmark::run("db-query/搜索", HOST_BENCH_ITERATIONS, [&]() {
+        database.searchSMS("验证码", 20);
+    }));
+}
+
+static void test_bench_db_insert() {
+    TEST_ASSERT_TRUE(database.prepareInsertBenchmark());
+    reportBenchmark(Benchmark::runChecked("db-insert/单条提交", HOST_BENCH_ITERATIONS, [&]() {
+        return database.insertBenchmarkRecord();
+    }));
+    TEST_ASSERT_TRUE(database.beginTransaction());
+    reportBenchmark(Benchmark::runChecked("db-insert/事务内", HOST_BENCH_ITERATIONS, [&]() {
+        return database.insertBenchmarkRecord();
+    }));
+    TEST_ASSERT_TRUE(database.commitTransaction());
+    database.finishInsertBenchmark();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_initialize_creates_schema);
+    RUN_TEST(test_sms_record_roundtrip_and_paging);
+    RUN_TEST(test_search_sms);
+    RUN_TEST(test_forward_rule_crud);
+    RUN_TEST(test_push_outbox_due_entries);
+    RUN_TEST(test_rollback_discards_writes);
+    RUN_TEST(test_records_survive_reopen);
+    RUN_TEST(test_flash_vfs_roundtrip);
+    RUN_TEST(test_bench_db_query);
+    RUN_TEST(test_bench_db_insert);
+    int failures = UNITY_END();
+    LittleFS.end();
+    return failures;
+}
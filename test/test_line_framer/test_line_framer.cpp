@@ -0,0 +1,200 @@
+/**
+ * @file test_line_framer.cpp
+ * @brief 串口行分帧器主机测试：分行、环形缓冲区回绕、超长行、按长度取原始字节、结果码与URC识别
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include <string>
+#include "../../lib/line_framer/line_framer.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+static LineFramer framer;
+
+void setUp() {
+    framer.reset();
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief 写入字符串
+ * @param text 数据
+ * @return size_t 实际写入的字节数
+ */
+static size_t feedText(const std::string& text) {
+    return framer.feed((const uint8_t*)text.data(), text.size());
+}
+
+/**
+ * @brief 取出下一行的内容（没有完整的行时测试失败）
+ * @return std::string 行内容
+ */
+static std::string takeLine() {
+    LineView line;
+    TEST_ASSERT_TRUE_MESSAGE(framer.nextLine(line), "没有完整的行");
+    TEST_ASSERT_EQUAL_UINT(strlen(line.data), line.length);
+    return std::string(line.data, line.length);
+}
+
+static void test_splits_and_trims_lines() {
+    feedText("\r\n+CSQ: 20,99\r\n\r\nOK\r\n+CMT");
+    TEST_ASSERT_EQUAL_STRING("", takeLine().c_str());
+    TEST_ASSERT_EQUAL_STRING("+CSQ: 20,99", takeLine().c_str());
+    TEST_ASSERT_EQUAL_STRING("", takeLine().c_str());
+    TEST_ASSERT_EQUAL_STRING("OK", takeLine().c_str());
+
+    // 未以换行结尾的部分留在缓冲区中
+    LineView line;
+    TEST_ASSERT_FALSE(framer.nextLine(line));
+    TEST_ASSERT_EQUAL_UINT(4, framer.buffered());
+    feedText(": ,23\r\n");
+    TEST_ASSERT_EQUAL_STRING("+CMT: ,23", takeLine().c_str());
+}
+
+static void test_line_wrapping_ring_end() {
+    // 先占用到接近缓冲区末尾，使下一行跨越末尾
+    std::string filler(LineFramer::CAPACITY - 10, 'x');
+    feedText(filler + "\n");
+    TEST_ASSERT_EQUAL_UINT(filler.size(), takeLine().size());
+
+    feedText("+CMTI: \"SM\",12\r\n");
+    TEST_ASSERT_EQUAL_STRING("+CMTI: \"SM\",12", takeLine().c_str());
+    TEST_ASSERT_EQUAL_UINT(0, framer.buffered());
+}
+
+static void test_overlong_line_is_truncated() {
+    std::string longLine(LineFramer::CAPACITY + 20, 'A');
+    size_t written = feedText(longLine);
+    TEST_ASSERT_EQUAL_UINT(LineFramer::CAPACITY, written);
+
+    LineView line;
+    TEST_ASSERT_TRUE(framer.nextLine(line));
+    TEST_ASSERT_TRUE(line.truncated);
+    TEST_ASSERT_EQUAL_UINT(LineFramer::CAPACITY, line.length);
+    TEST_ASSERT_EQUAL_UINT(1, framer.getOverflowCount());
+
+    // 余下部分在换行后作为普通行交付
+    feedText(longLine.substr(written) + "\n");
+    TEST_ASSERT_TRUE(framer.nextLine(line));
+    TEST_ASSERT_FALSE(line.truncated);
+    TEST_ASSERT_EQUAL_UINT(20, line.length);
+}
+
+static void test_pending_prompt() {
+    feedText("\r\n> ");
+    LineView line;
+    TEST_ASSERT_TRUE(framer.nextLine(line));
+    TEST_ASSERT_FALSE(framer.nextLine(line));
+    TEST_ASSERT_TRUE(framer.pendingContains("> "));
+    TEST_ASSERT_FALSE(framer.pendingContains("OK"));
+}
+
+/**
+ * @brief 按长度取出原始字节（跨越缓冲区末尾时分两次取出）
+ * @param length 字节数
+ * @return std::string 取出的数据
+ */
+static std::string takeRawText(size_t length) {
+    std::string text;
+    const char* data;
+    size_t taken;
+    while (text.size() < length && (taken = framer.takeRaw(data, length - text.size())) > 0) {
+        text.append(data, taken);
+    }
+    return text;
+}
+
+static void test_take_raw_bytes() {
+    // 数据段中的空白、空行与结果码原样交付，之后恢复分行
+    std::string body = " ERROR\r\n\r\n+CMT: x ";
+    feedText("+HTTPREAD: " + std::to_string(body.size()) + "\r\n" + body + "\r\n+HTTPREAD: 0\r\n");
+    TEST_ASSERT_EQUAL_STRING("+HTTPREAD: 18", takeLine().c_str());
+    std::string raw = takeRawText(body.size());
+    TEST_ASSERT_EQUAL_STRING(body.c_str(), raw.c_str());
+    TEST_ASSERT_EQUAL_STRING("", takeLine().c_str());
+    TEST_ASSERT_EQUAL_STRING("+HTTPREAD: 0", takeLine().c_str());
+
+    // 已扫描但未成行的数据被取出后，剩余部分照常分行
+    std::string filler(LineFramer::CAPACITY - 6, 'x');
+    feedText(filler + "\n");
+    takeLine();
+    feedText("abcdefgh");
+    LineView line;
+    TEST_ASSERT_FALSE(framer.nextLine(line));
+    raw = takeRawText(6);
+    TEST_ASSERT_EQUAL_STRING("abcdef", raw.c_str());
+    feedText("\r\n");
+    TEST_ASSERT_EQUAL_STRING("gh", takeLine().c_str());
+    TEST_ASSERT_EQUAL_UINT(0, framer.buffered());
+
+    const char* data;
+    TEST_ASSERT_EQUAL_UINT(0, framer.takeRaw(data, 4));
+}
+
+static void test_classify_final_result() {
+    struct Case {
+        const char* line;
+        FinalResultCode code;
+    };
+    static const Case cases[] = {
+        {"OK", FINAL_OK},
+        {"ERROR", FINAL_ERROR},
+        {"+CME ERROR: 10", FINAL_ERROR},
+        {"+CMS ERROR: 500", FINAL_ERROR},
+        {"NO CARRIER", FINAL_ERROR},
+        {"BUSY", FINAL_ERROR},
+        {"OKAY", FINAL_NONE},
+        {"+CSQ: 20,99", FINAL_NONE},
+        {"", FINAL_NONE},
+    };
+    for (const Case& entry : cases) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(entry.code, classifyFinalResult(entry.line, strlen(entry.line)), entry.line);
+    }
+}
+
+static void test_classify_urc() {
+    TEST_ASSERT_EQUAL_INT(URC_CMT, classifyUrc("+CMT: ,23", 9));
+    TEST_ASSERT_EQUAL_INT(URC_CMTI, classifyUrc("+CMTI: \"SM\",1", 13));
+    TEST_ASSERT_EQUAL_INT(URC_CDSI, classifyUrc("+CDSI: \"SR\",2", 13));
+    TEST_ASSERT_EQUAL_INT(URC_CBM, classifyUrc("+CBM: 88", 8));
+    TEST_ASSERT_EQUAL_INT(URC_NONE, classifyUrc("+CMGS: 5", 8));
+    TEST_ASSERT_TRUE(lineStartsWith("+HTTPACTION: 0,200,12", 21, "+HTTPACTION:"));
+    TEST_ASSERT_FALSE(lineStartsWith("+HTTP", 5, "+HTTPACTION:"));
+}
+
+static void test_bench_frame_sms_burst() {
+    // 一次+CMT上报：URC行、PDU行与结束的空行
+    static const std::string burst =
+        "\r\n+CMT: ,36\r\n"
+        "07911326040000F0040B911346610089F60000208062917314080CC8F71D14969741F977FD07\r\n"
+        "\r\n+CSQ: 21,99\r\n\r\nOK\r\n";
+    reportBenchmark(Benchmark::runChecked("line-framer/短信上报", HOST_BENCH_ITERATIONS, []() {
+        framer.reset();
+        feedText(burst);
+        LineView line;
+        int urcs = 0;
+        while (framer.nextLine(line)) {
+            if (classifyUrc(line.data, line.length) == URC_CMT) {
+                urcs++;
+            }
+        }
+        return urcs == 1;
+    }));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_splits_and_trims_lines);
+    RUN_TEST(test_line_wrapping_ring_end);
+    RUN_TEST(test_overlong_line_is_truncated);
+    RUN_TEST(test_pending_prompt);
+    RUN_TEST(test_take_raw_bytes);
+    RUN_TEST(test_classify_final_result);
+    RUN_TEST(test_classify_urc);
+    RUN_TEST(test_bench_frame_sms_burst);
+    return UNITY_END();
+}
@@ -0,0 +1,95 @@
+/**
+ * @file test_message_template.cpp
+ * @brief 消息模板主机测试：占位符替换、JSON转义与渲染到内存区缓冲区
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include "../../lib/metrics/metrics.cpp"
+#include "../../lib/message_arena/message_arena.cpp"
+#include "../../lib/push_manager/message_template.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+/// 覆盖全部占位符的消息模板（与设备上bench template的样例相同）
+static const char* FULL_TEMPLATE =
+    "{\"msgtype\":\"text\",\"text\":{\"content\":\"📱 来自 {sender}\\n⏰ {timestamp}\\n🆔 {sms_id}\\n{content}\"}}";
+
+static const String SENDER = "+8613800138000";
+static const String CONTENT = "您的验证码为834921，5分钟内有效。\"引号\"与\\反斜杠需要转义";
+static const String TIMESTAMP = "2024-06-01 12:30:45";
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_replaces_placeholders() {
+    CompiledTemplate compiled("{sender}: {content} ({timestamp}, #{sms_id})");
+    TEST_ASSERT_TRUE(compiled.usesTimestamp());
+    String result = compiled.render("10086", "余额不足", TIMESTAMP, 42, false);
+    TEST_ASSERT_EQUAL_STRING("10086: 余额不足 (2024-06-01 12:30:45, #42)", result.c_str());
+}
+
+static void test_keeps_unknown_braces() {
+    CompiledTemplate compiled("{\"a\":\"{sender}\",\"b\":\"{unknown}\"}");
+    TEST_ASSERT_FALSE(compiled.usesTimestamp());
+    String result = compiled.render("10086", "", "", 1, true);
+    TEST_ASSERT_EQUAL_STRING("{\"a\":\"10086\",\"b\":\"{unknown}\"}", result.c_str());
+}
+
+static void test_escapes_values_only() {
+    CompiledTemplate compiled("\"{content}\"\n");
+    String escaped = compiled.render(SENDER, "a\"b\\c\nd\te", TIMESTAMP, 1, true);
+    TEST_ASSERT_EQUAL_STRING("\"a\\\"b\\\\c\\nd\\te\"\n", escaped.c_str());
+    String raw = compiled.render(SENDER, "a\"b", TIMESTAMP, 1, false);
+    TEST_ASSERT_EQUAL_STRING("\"a\"b\"\n", raw.c_str());
+}
+
+static void test_empty_template() {
+    CompiledTemplate compiled;
+    TEST_ASSERT_TRUE(compiled.isEmpty());
+    TEST_ASSERT_TRUE(compiled.render(SENDER, CONTENT, TIMESTAMP, 1, true).isEmpty());
+}
+
+static void test_render_to_arena_matches_string() {
+    CompiledTemplate compiled(FULL_TEMPLATE);
+    String expected = compiled.render(SENDER, CONTENT, TIMESTAMP, 12345, true);
+
+    MessageArena arena;
+    TEST_ASSERT_TRUE(arena.initialize(PUSH_MESSAGE_ARENA_BYTES));
+    {
+        ArenaScope scope(arena);
+        ArenaText output;
+        compiled.renderTo(output, SENDER, CONTENT, TIMESTAMP.c_str(), 12345, true);
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), output.c_str());
+        TEST_ASSERT_EQUAL_UINT(expected.length(), output.length());
+    }
+    TEST_ASSERT_EQUAL_UINT(0, arena.getStats().overflows);
+}
+
+static void test_bench_render() {
+    String templateStr = FULL_TEMPLATE;
+    reportBenchmark(Benchmark::run("template/编译+渲染", HOST_BENCH_ITERATIONS, [&]() {
+        CompiledTemplate compiled(templateStr);
+        compiled.render(SENDER, CONTENT, TIMESTAMP, 12345, true);
+    }));
+
+    CompiledTemplate precompiled(templateStr);
+    reportBenchmark(Benchmark::run("template/预编译渲染", HOST_BENCH_ITERATIONS, [&]() {
+        precompiled.render(SENDER, CONTENT, TIMESTAMP, 12345, true);
+    }));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_replaces_placeholders);
+    RUN_TEST(test_keeps_unknown_braces);
+    RUN_TEST(test_escapes_values_only);
+    RUN_TEST(test_empty_template);
+    RUN_TEST(test_render_to_arena_matches_string);
+    RUN_TEST(test_bench_render);
+    return UNITY_END();
+}
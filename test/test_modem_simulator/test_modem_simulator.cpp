@@ -0,0 +1,493 @@
+/**
+ * @file test_modem_simulator.cpp
+ * @brief 调制解调器模拟器主机测试：回放抓取的串口记录，经行分帧器与仲裁器的行路由分发并判定事务结果
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "../../lib/line_framer/line_framer.cpp"
+#include "../../lib/modem_arbiter/modem_router.cpp"
+#include "../../lib/modem_simulator/modem_script.cpp"
+#include "../../lib/pdu_decoder/pdu_decoder.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+/// 抓取的串口记录（格式与设备上的回放脚本相同）
+static const char* CAPTURED_TRACE =
+    "# 抓取自A7670C，2024-06-01\n"
+    "< +CMT: ,31\n"
+    "< 0891683108200105F0040D91683118325476F80000420160211404230CC8F71D14969741F977FD07\n"
+    "\n"
+    "< +CMTI: \"SM\",3\n"
+    "\n"
+    "< RING\n"
+    "< +CLIP: \"13800138000\",161,\"\",0,\"\",0\n"
+    "\n"
+    "< +CREG: 1\n"
+    "? AT+CSQ\n"
+    "= +CSQ: 23,99\n"
+    "= OK\n";
+
+static int smsQueue;        ///< 订阅者标识（仲裁器中为队列句柄）
+static int storageQueue;
+static int callQueue;
+
+static unsigned long nowMs;  ///< 路由使用的时间（由用例设置，不读取时钟）
+static LineFramer framer;
+static ModemRouter* router;
+static std::vector<std::pair<void*, std::string>> delivered;
+static std::vector<std::string> unsolicited;
+static std::string dataSegment;     ///< 按长度读取的数据段
+static int promptsReached;          ///< 以完整一行到达的提示符数
+
+/**
+ * @brief 按仲裁器的方式分帧并路由一段串口数据
+ * @param data 串口数据
+ * @param response 当前命令事务的响应
+ * @param status 输出：事务完成时的结果
+ * @return true 当前事务已完成
+ * @return false 无事务或仍在进行
+ */
+static bool pump(const String& data, String& response, ModemTransactionStatus& status) {
+    bool finished = false;
+    size_t offset = 0;
+    while (offset < data.length()) {
+        offset += framer.feed((const uint8_t*)data.c_str() + offset, data.length() - offset);
+        LineView line;
+        while (true) {
+            size_t pending = router->pendingData();
+            if (pending > 0) {
+                const char* raw;
+                size_t length = framer.takeRaw(raw, pending);
+                if (length == 0) {
+                    break;
+                }
+                router->consumeData(length);
+                dataSegment.append(raw, length);
+                continue;
+            }
+            if (!framer.nextLine(line)) {
+                break;
+            }
+            void* subscriber = nullptr;
+            switch (router->route(line, subscriber)) {
+                case MODEM_ROUTE_SUBSCRIBER:
+                    delivered.push_back(std::make_pair(subscriber, std::string(line.data)));
+                    break;
+                case MODEM_ROUTE_RESPONSE:
+                    if (router->appendResponse(line, response, nowMs, status)) {
+                        router->endTransaction();
+                        finished = true;
+                    } else if (router->takePromptReached()) {
+                        promptsReached++;
+                    }
+                    break;
+                case MODEM_ROUTE_WAIT_MATCH:
+                    response = line.data;
+                    status = MODEM_TXN_OK;
+                    router->endTransaction();
+                    finished = true;
+                    break;
+                case MODEM_ROUTE_UNSOLICITED:
+                    unsolicited.push_back(line.data);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return finished;
+}
+
+/**
+ * @brief 分帧并路由（无事务进行中）
+ * @param data 串口数据
+ */
+static void pump(const String& data) {
+    String response;
+    ModemTransactionStatus status;
+    TEST_ASSERT_FALSE(pump(data, response, status));
+}
+
+/**
+ * @brief 把主机写入的命令交给应答器，并把回复分帧路由
+ * @param responder 应答器
+ * @param command 主机写入的数据
+ * @param response 当前命令事务的响应
+ * @param status 输出：事务完成时的结果
+ * @return true 当前事务已完成
+ * @return false 仍在进行
+ */
+static bool converse(ModemResponder& responder, const char* command, String& response,
+                     ModemTransactionStatus& status) {
+    String replies;
+    responder.receive((const uint8_t*)command, strlen(command), replies);
+    // 模块开启回显：先回显命令行
+    String echoed = String(command);
+    return pump(echoed + replies, response, status);
+}
+
+/**
+ * @brief 解析脚本文本
+ * @param text 脚本
+ * @param script 输出
+ */
+static void parseScript(const char* text, ModemScript& script) {
+    script.clear();
+    String all(text);
+    int start = 0;
+    int end;
+    while ((end = all.indexOf('\n', start)) >= 0) {
+        script.addLine(all.substring(start, end));
+        start = end + 1;
+    }
+    if (start < (int)all.length()) {
+        script.addLine(all.substring(start));
+    }
+    script.finish();
+}
+
+void setUp() {
+    nowMs = 1000;
+    framer.reset();
+    delete router;
+    router = new ModemRouter();
+    TEST_ASSERT_TRUE(router->subscribe("+CMT:", &smsQueue, true));
+    TEST_ASSERT_TRUE(router->subscribe("+CMTI:", &storageQueue, false));
+    TEST_ASSERT_TRUE(router->subscribe("RING", &callQueue, false));
+    TEST_ASSERT_TRUE(router->subscribe("+CLIP:", &callQueue, false));
+    delivered.clear();
+    unsolicited.clear();
+    dataSegment.clear();
+    promptsReached = 0;
+}
+
+void tearDown() {
+}
+
+static void test_parse_captured_trace() {
+    ModemScript script;
+    parseScript(CAPTURED_TRACE, script);
+
+    const std::vector<String>& events = script.getEvents();
+    TEST_ASSERT_EQUAL_UINT32(4, events.size());
+    TEST_ASSERT_TRUE(events[0].startsWith("+CMT: ,31\r\n0891"));
+    TEST_ASSERT_TRUE(events[0].endsWith("FD07\r\n"));
+    TEST_ASSERT_EQUAL_STRING("RING\r\n+CLIP: \"13800138000\",161,\"\",0,\"\",0\r\n", events[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("+CREG: 1\r\n", events[3].c_str());
+
+    TEST_ASSERT_EQUAL_UINT32(1, script.getDialogues().size());
+    TEST_ASSERT_EQUAL_STRING("AT+CSQ", script.getDialogues()[0].prefix.c_str());
+    TEST_ASSERT_EQUAL_STRING("+CSQ: 23,99\r\nOK\r\n", script.getDialogues()[0].reply.c_str());
+}
+
+static void test_replay_routes_urcs_to_subscribers() {
+    ModemScript script;
+    parseScript(CAPTURED_TRACE, script);
+    for (const String& event : script.getEvents()) {
+        pump(event);
+    }
+
+    // +CMT:携带下一行PDU投递给同一订阅者；未订阅的+CREG:进入暂存区
+    TEST_ASSERT_EQUAL_UINT32(5, delivered.size());
+    TEST_ASSERT_EQUAL_PTR(&smsQueue, delivered[0].first);
+    TEST_ASSERT_EQUAL_PTR(&smsQueue, delivered[1].first);
+    TEST_ASSERT_TRUE(delivered[1].second.compare(0, 4, "0891") == 0);
+    TEST_ASSERT_EQUAL_PTR(&storageQueue, delivered[2].first);
+    TEST_ASSERT_EQUAL_PTR(&callQueue, delivered[3].first);
+    TEST_ASSERT_EQUAL_PTR(&callQueue, delivered[4].first);
+    TEST_ASSERT_EQUAL_UINT32(1, unsolicited.size());
+
+    String line;
+    TEST_ASSERT_TRUE(router->takeUnsolicited("+CREG:", line));
+    TEST_ASSERT_EQUAL_STRING("+CREG: 1", line.c_str());
+    TEST_ASSERT_FALSE(router->takeUnsolicited("+CREG:", line));
+
+    // 回放的PDU可以被解码
+    static char text[SMS_PDU_TEXT_BUFFER_SIZE];
+    SmsPdu pdu;
+    const std::string& hex = delivered[1].second;
+    TEST_ASSERT_TRUE(decodeSmsPdu(hex.c_str(), hex.size(), pdu, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("How are you?", pdu.text);
+}
+
+static void test_urc_inside_command_response() {
+    ModemScript script;
+    parseScript(CAPTURED_TRACE, script);
+    ModemResponder responder;
+    responder.reset(&script.getDialogues());
+
+    const char* command = "AT+CSQ\r\n";
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 1000, nowMs);
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+    String replies;
+    responder.receive((const uint8_t*)command, strlen(command), replies);
+
+    // 响应中间插入一条短信上报：短信照常投递，不混入命令响应
+    String wire = String("AT+CSQ\r\n") + script.getEvents()[0] + replies;
+    TEST_ASSERT_TRUE(pump(wire, response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_EQUAL_STRING("AT+CSQ\r\n+CSQ: 23,99\r\nOK\r\n", response.c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, delivered.size());
+    TEST_ASSERT_FALSE(router->isActive());
+}
+
+static void test_disabled_subscription_leaves_final_code_to_command() {
+    static int phoneQueue;
+    TEST_ASSERT_TRUE(router->subscribe("NO CARRIER", &phoneQueue, false, false));
+
+    // 空闲时停用的订阅不截取：NO CARRIER是进行中命令的最终结果码，命令不必等到超时
+    const char* command = "AT+NETOPEN\r\n";
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 1000, nowMs);
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+    TEST_ASSERT_TRUE(pump("AT+NETOPEN\r\nNO CARRIER\r\n", response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_ERROR, status);
+    TEST_ASSERT_EQUAL_UINT32(0, delivered.size());
+
+    // 通话期间启用后作为上报投递，不结束同时进行的其他命令
+    TEST_ASSERT_TRUE(router->setSubscriptionEnabled("NO CARRIER", &phoneQueue, true));
+    command = "AT+CSQ\r\n";
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 1000, nowMs);
+    response = "";
+    status = MODEM_TXN_BUSY;
+    TEST_ASSERT_TRUE(pump("AT+CSQ\r\nNO CARRIER\r\n+CSQ: 23,99\r\nOK\r\n", response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_EQUAL_UINT32(1, delivered.size());
+    TEST_ASSERT_TRUE(delivered[0].first == &phoneQueue);
+    TEST_ASSERT_FALSE(router->setSubscriptionEnabled("BUSY", &phoneQueue, true));
+}
+
+static void test_http_dialogue() {
+    ModemResponder responder;
+    responder.reset(nullptr);
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+
+    // DOWNLOAD提示之后在同一事务内写入请求体，请求体收满后的OK结束事务
+    const char* data = "AT+HTTPDATA=4,1000\r\n";
+    router->beginCommand(data, strlen(data), "", nullptr, nullptr, 5000, nowMs);
+    router->expectPrompt("DOWNLOAD");
+    TEST_ASSERT_FALSE(converse(responder, data, response, status));
+    TEST_ASSERT_EQUAL_INT(1, promptsReached);
+    router->continueAfterPrompt(1000, nowMs);
+    TEST_ASSERT_NULL(router->getPendingPrompt());
+    String replies;
+    TEST_ASSERT_EQUAL_UINT(0, responder.receive((const uint8_t*)"{\"a\"", 4, replies));
+    TEST_ASSERT_EQUAL_STRING("OK\r\n", replies.c_str());
+    TEST_ASSERT_TRUE(pump(replies, response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_EQUAL_STRING("AT+HTTPDATA=4,1000\r\nDOWNLOAD\r\nOK\r\n", response.c_str());
+
+    // OK结束命令事务，随后的+HTTPACTION:暂存下来供等待型事务取出
+    const char* action = "AT+HTTPACTION=1\r\n";
+    response = "";
+    router->beginCommand(action, strlen(action), "", nullptr, nullptr, 5000, nowMs);
+    TEST_ASSERT_TRUE(converse(responder, action, response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_EQUAL_UINT32(1, unsolicited.size());
+    router->beginWait("+HTTPACTION:", 30000, nowMs);
+    response = "";
+    TEST_ASSERT_TRUE(router->takeUnsolicited("+HTTPACTION:", response));
+    TEST_ASSERT_EQUAL_STRING("+HTTPACTION: 1,200,2", response.c_str());
+    router->endTransaction();
+
+    // 指定结束行的命令：OK不结束事务，"+HTTPREAD: 2"之后的2字节按长度读取
+    const char* read = "AT+HTTPREAD=0,2\r\n";
+    response = "";
+    router->beginCommand(read, strlen(read), "", "+HTTPREAD: 0", "+HTTPREAD:", 5000, nowMs);
+    TEST_ASSERT_TRUE(converse(responder, read, response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_EQUAL_STRING("{}", dataSegment.c_str());
+    TEST_ASSERT_EQUAL_INT(-1, response.indexOf("{}"));
+}
+
+static void test_http_read_body_is_length_delimited() {
+    // 响应体中的空白、空行、结果码与订阅的URC前缀都属于数据，不能结束事务或投递给订阅者
+    std::string body = "  ERROR\r\n\r\n+CMT: ,23\r\nOK\r\n ";
+    String wire = String("AT+HTTPREAD=0,64\r\nOK\r\n+HTTPREAD: ") + String((unsigned long)body.size()) + "\r\n" +
+                  String(body.c_str()) + "\r\n+HTTPREAD: 0\r\n";
+    const char* read = "AT+HTTPREAD=0,64\r\n";
+    router->beginCommand(read, strlen(read), "", "+HTTPREAD: 0", "+HTTPREAD:", 5000, nowMs);
+
+    // 逐段到达：数据段跨越多次读取
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+    bool finished = false;
+    for (unsigned int i = 0; i < wire.length(); i += 3) {
+        TEST_ASSERT_FALSE(finished);
+        finished = pump(wire.substring(i, i + 3), response, status);
+    }
+    TEST_ASSERT_TRUE(finished);
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_EQUAL_UINT32(body.size(), dataSegment.size());
+    TEST_ASSERT_EQUAL_STRING(body.c_str(), dataSegment.c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, delivered.size());
+    TEST_ASSERT_EQUAL_UINT32(0, router->pendingData());
+
+    // 事务结束后恢复按行路由
+    pump("+CMTI: \"SM\",4\r\n");
+    TEST_ASSERT_EQUAL_UINT32(1, delivered.size());
+}
+
+static void test_sms_send_prompt_and_script_override() {
+    ModemScript script;
+    parseScript("< +CREG: 1\n? AT+CMGS=\n= +CMS ERROR: 304\n", script);
+    ModemResponder responder;
+
+    // 内置对话：AT+CMGS=之后输出提示符，Ctrl+Z结束PDU
+    responder.reset(nullptr);
+    String replies;
+    responder.receive((const uint8_t*)"AT+CMGS=20\r", 11, replies);
+    TEST_ASSERT_EQUAL_STRING("\r\n> ", replies.c_str());
+    framer.feed((const uint8_t*)replies.c_str(), replies.length());
+    TEST_ASSERT_TRUE(framer.pendingContains("> "));
+    replies = "";
+    responder.receive((const uint8_t*)"0011\x1A", 5, replies);
+    TEST_ASSERT_TRUE(replies.indexOf("+CMGS: 1") >= 0);
+
+    // 脚本中的对话优先
+    responder.reset(&script.getDialogues());
+    replies = "";
+    responder.receive((const uint8_t*)"AT+CMGS=20\r", 11, replies);
+    TEST_ASSERT_EQUAL_STRING("+CMS ERROR: 304\r\n", replies.c_str());
+
+    // 提示符之前的错误结束事务，数据不会写入
+    framer.reset();
+    const char* command = "AT+CMGS=20\r";
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 5000, nowMs);
+    router->expectPrompt(">");
+    TEST_ASSERT_TRUE(pump(replies, response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_ERROR, status);
+    TEST_ASSERT_EQUAL_INT(0, promptsReached);
+}
+
+static void test_prompt_holds_transaction_until_data_result() {
+    ModemResponder responder;
+    responder.reset(nullptr);
+    const char* command = "AT+CMGS=20\r";
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 5000, nowMs);
+    router->expectPrompt(">");
+
+    // 提示符不以换行结尾：事务仍在进行，由仲裁器在未成行数据中识别
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+    TEST_ASSERT_FALSE(converse(responder, command, response, status));
+    TEST_ASSERT_TRUE(router->isActive());
+    TEST_ASSERT_EQUAL_STRING(">", router->getPendingPrompt());
+    TEST_ASSERT_TRUE(framer.pendingContains(router->getPendingPrompt()));
+    framer.reset();
+
+    // 等待提示符期间超时：有回显之外的响应也不算成功
+    bool timedOut = false;
+    TEST_ASSERT_FALSE(router->checkTimers(nowMs + 4999, status, timedOut));
+
+    // 写入PDU后按数据写入后的超时重新计时，+CMGS:与OK结束事务
+    nowMs += 4000;
+    router->continueAfterPrompt(60000, nowMs);
+    TEST_ASSERT_FALSE(router->checkTimers(nowMs + 5000, status, timedOut));
+    String replies;
+    responder.receive((const uint8_t*)"0011\x1A", 5, replies);
+    TEST_ASSERT_TRUE(pump(replies, response, status));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_TRUE(response.indexOf("+CMGS: 1") >= 0);
+
+    // 一直没有提示符：超时结果为响应无效而不是成功
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 500, nowMs);
+    router->expectPrompt(">");
+    TEST_ASSERT_FALSE(pump("+CMS: busy\r\n", response, status));
+    TEST_ASSERT_TRUE(router->checkTimers(nowMs + 500, status, timedOut));
+    TEST_ASSERT_TRUE(timedOut);
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_INVALID, status);
+}
+
+static void test_settle_after_non_final_expected() {
+    // 期望响应不是最终结果码：匹配后静默一段时间完成
+    const char* command = "AT+CPIN?\r\n";
+    router->beginCommand(command, strlen(command), "+CPIN:", nullptr, nullptr, 5000, nowMs);
+    String response;
+    ModemTransactionStatus status = MODEM_TXN_BUSY;
+    TEST_ASSERT_FALSE(pump("AT+CPIN?\r\n+CPIN: READY\r\n", response, status));
+    bool timedOut = true;
+    TEST_ASSERT_FALSE(router->checkTimers(nowMs, status, timedOut));
+    TEST_ASSERT_EQUAL_UINT32(MODEM_RESPONSE_SETTLE_MS, router->nextWaitMs(nowMs));
+    TEST_ASSERT_TRUE(router->checkTimers(nowMs + MODEM_RESPONSE_SETTLE_MS, status, timedOut));
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_OK, status);
+    TEST_ASSERT_FALSE(timedOut);
+}
+
+static void test_timeout_without_response() {
+    const char* command = "AT\r\n";
+    router->beginCommand(command, strlen(command), "", nullptr, nullptr, 500, nowMs);
+    ModemTransactionStatus status;
+    bool timedOut = false;
+    TEST_ASSERT_EQUAL_UINT32(400, router->nextWaitMs(1100));
+    TEST_ASSERT_FALSE(router->checkTimers(1499, status, timedOut));
+
+    // 只收到回显不算作响应
+    String response;
+    TEST_ASSERT_FALSE(pump("AT\r\n", response, status));
+    TEST_ASSERT_TRUE(router->checkTimers(1500, status, timedOut));
+    TEST_ASSERT_TRUE(timedOut);
+    TEST_ASSERT_EQUAL_INT(MODEM_TXN_TIMEOUT, status);
+}
+
+static void test_synthetic_sms_decodes() {
+    String event;
+    ModemScript::buildSyntheticSms(7, 1717200000, event);
+    pump(event);
+    TEST_ASSERT_EQUAL_UINT32(2, delivered.size());
+    TEST_ASSERT_EQUAL_PTR(&smsQueue, delivered[1].first);
+
+    static char text[SMS_PDU_TEXT_BUFFER_SIZE];
+    SmsPdu pdu;
+    const std::string& hex = delivered[1].second;
+    TEST_ASSERT_TRUE(decodeSmsPdu(hex.c_str(), hex.size(), pdu, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("+8613800000007", pdu.sender);
+    TEST_ASSERT_EQUAL_STRING("240601000000", pdu.timestamp);
+    TEST_ASSERT_EQUAL_STRING("压测短信 #7", pdu.text);
+
+    // +CMT:中的长度为不含短信中心地址的字节数
+    TEST_ASSERT_EQUAL_STRING(("+CMT: ," + std::to_string(hex.size() / 2 - 1)).c_str(), delivered[0].second.c_str());
+}
+
+static void test_bench_replay_synthetic_sms() {
+    // 与设备上sim replay相同的合成短信，测量分帧、路由与解码的主机耗时
+    static char text[SMS_PDU_TEXT_BUFFER_SIZE];
+    uint32_t index = 0;
+    String event;
+    BenchmarkResult result = Benchmark::runChecked("modem-replay/合成短信", HOST_BENCH_ITERATIONS, [&]() {
+        delivered.clear();
+        ModemScript::buildSyntheticSms(index++, 1717200000, event);
+        pump(event);
+        SmsPdu pdu;
+        return delivered.size() == 2 &&
+               decodeSmsPdu(delivered[1].second.c_str(), delivered[1].second.size(), pdu, text, sizeof(text));
+    });
+    reportBenchmark(result);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_captured_trace);
+    RUN_TEST(test_replay_routes_urcs_to_subscribers);
+    RUN_TEST(test_urc_inside_command_response);
+    RUN_TEST(test_disabled_subscription_leaves_final_code_to_command);
+    RUN_TEST(test_http_dialogue);
+    RUN_TEST(test_http_read_body_is_length_delimited);
+    RUN_TEST(test_sms_send_prompt_and_script_override);
+    RUN_TEST(test_prompt_holds_transaction_until_data_result);
+    RUN_TEST(test_settle_after_non_final_expected);
+    RUN_TEST(test_timeout_without_response);
+    RUN_TEST(test_synthetic_sms_decodes);
+    RUN_TEST(test_bench_replay_synthetic_sms);
+    int failures = UNITY_END();
+    delete router;
+    return failures;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file test_pdu.cpp
+ * @brief PDU编解码主机测试：SMS-DELIVER解码、长短信头、分段规划与SMS-SUBMIT编码
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include "../../lib/pdu_decoder/pdu_decoder.cpp"
+#include "../../lib/pdu_encoder/pdu_encoder.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+/// GSM 7位编码的单条短信（"How are you?"，与设备上bench pdu的样例相同）
+static const char* PDU_GSM7 =
+    "07911326040000F0040B911346610089F60000208062917314080CC8F71D14969741F977FD07";
+
+/// UCS2编码的长短信分片（16位参考号，含代理对字符）
+static const char* PDU_UCS2_PART =
+    "0891683108200105F0440D91683119325476F800084210412143002315060804123403024F60597DFF0C4E16754CD83DDE00";
+
+/// 中英混排长短信（与设备上bench sms-encode的样例相同）
+static const char* SMS_MIXED =
+    "Server alert: disk usage on db-01 reached 91% at 02:14, cleanup job failed with exit code 3. "
+    "服务器告警：磁盘使用率超过阈值，请尽快处理。 Next check in 15 minutes; escalate to on-call if usage keeps rising. "
+    "Ticket INC-20240601-0042 has been opened automatically.";
+
+static char text[SMS_PDU_TEXT_BUFFER_SIZE];
+static char output[SMS_SEND_PDU_BUFFER_SIZE];
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_decode_gsm7() {
+    SmsPdu pdu;
+    TEST_ASSERT_TRUE(decodeSmsPdu(PDU_GSM7, strlen(PDU_GSM7), pdu, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("+31641600986", pdu.sender);
+    TEST_ASSERT_EQUAL_STRING("020826193741", pdu.timestamp);
+    TEST_ASSERT_EQUAL_INT(SMS_ALPHABET_GSM7, pdu.alphabet);
+    TEST_ASSERT_EQUAL_STRING("How are you?", pdu.text);
+    TEST_ASSERT_EQUAL_UINT(12, pdu.textLength);
+    TEST_ASSERT_EQUAL_UINT8(0, pdu.concatTotal);
+    TEST_ASSERT_FALSE(pdu.textTruncated);
+}
+
+static void test_decode_ucs2_concat_part() {
+    SmsPdu pdu;
+    TEST_ASSERT_TRUE(decodeSmsPdu(PDU_UCS2_PART, strlen(PDU_UCS2_PART), pdu, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("+8613912345678", pdu.sender);
+    TEST_ASSERT_EQUAL_INT(SMS_ALPHABET_UCS2, pdu.alphabet);
+    TEST_ASSERT_EQUAL_UINT16(0x1234, pdu.concatRef);
+    TEST_ASSERT_EQUAL_UINT8(2, pdu.concatPart);
+    TEST_ASSERT_EQUAL_UINT8(3, pdu.concatTotal);
+    TEST_ASSERT_EQUAL_INT8(32, pdu.timezoneQuarters);
+    // 代理对合成为一个4字节UTF-8字符
+    TEST_ASSERT_EQUAL_STRING("你好，世界\xF0\x9F\x98\x80", pdu.text);
+}
+
+static void test_decode_rejects_malformed() {
+    SmsPdu pdu;
+    TEST_ASSERT_FALSE(decodeSmsPdu("", 0, pdu, text, sizeof(text)));
+    TEST_ASSERT_FALSE(decodeSmsPdu("07911326", 8, pdu, text, sizeof(text)));
+    // 截去正文的最后一个八位组
+    size_t length = strlen(PDU_GSM7) - 2;
+    TEST_ASSERT_FALSE(decodeSmsPdu(PDU_GSM7, length, pdu, text, sizeof(text)));
+}
+
+static void test_decode_truncates_to_buffer() {
+    SmsPdu pdu;
+    char small[6];
+    TEST_ASSERT_TRUE(decodeSmsPdu(PDU_GSM7, strlen(PDU_GSM7), pdu, small, sizeof(small)));
+    TEST_ASSERT_TRUE(pdu.textTruncated);
+    TEST_ASSERT_EQUAL_STRING("How a", pdu.text);
+}
+
+static void test_plan_segments() {
+    SmsSegmentPlan plan;
+    std::string single(160, 'a');
+    TEST_ASSERT_TRUE(planSmsSegments(single.c_str(), single.size(), plan));
+    TEST_ASSERT_EQUAL_UINT8(1, plan.count);
+
+    std::string two(200, 'a');
+    TEST_ASSERT_TRUE(planSmsSegments(two.c_str(), two.size(), plan));
+    TEST_ASSERT_EQUAL_UINT8(2, plan.count);
+    TEST_ASSERT_EQUAL_UINT16(153, plan.parts[0].units);
+    TEST_ASSERT_EQUAL_UINT16(47, plan.parts[1].units);
+
+    // 英文段落按GSM 7位、含中文的分段按UCS2
+    TEST_ASSERT_TRUE(planSmsSegments(SMS_MIXED, strlen(SMS_MIXED), plan));
+    TEST_ASSERT_EQUAL_UINT8(3, plan.count);
+    TEST_ASSERT_EQUAL_INT(SMS_ALPHABET_GSM7, plan.parts[0].alphabet);
+    TEST_ASSERT_EQUAL_INT(SMS_ALPHABET_UCS2, plan.parts[1].alphabet);
+    TEST_ASSERT_EQUAL_INT(SMS_ALPHABET_GSM7, plan.parts[2].alphabet);
+    size_t covered = 0;
+    for (uint8_t i = 0; i < plan.count; i++) {
+        TEST_ASSERT_EQUAL_UINT(covered, plan.parts[i].offset);
+        covered += plan.parts[i].length;
+    }
+    TEST_ASSERT_EQUAL_UINT(strlen(SMS_MIXED), covered);
+
+    TEST_ASSERT_FALSE(planSmsSegments("", 0, plan));
+}
+
+static void test_encode_submit() {
+    // GSM 03.40的常见样例："hellohello"，使用模块设置的短信中心
+    int length = encodeSmsSubmit("", "+46708251358", "hellohello", 10, SMS_ALPHABET_GSM7, 0, 0, 0,
+                                 output, sizeof(output));
+    TEST_ASSERT_EQUAL_INT(22, length);
+    TEST_ASSERT_EQUAL_STRING_LEN("0001000B916407281553F800000AE8329BFD4697D9EC37", output, 46);
+
+    length = encodeSmsSubmit("+8613800100500", "+8613800138000", "你好", strlen("你好"), SMS_ALPHABET_UCS2, 0, 0, 0,
+                             output, sizeof(output));
+    TEST_ASSERT_EQUAL_INT(18, length);
+    TEST_ASSERT_EQUAL_STRING_LEN("0891683108100005F001000D91683108108300F00008044F60597D", output, 54);
+
+    // 长短信分段：带8位参考号的用户数据头
+    length = encodeSmsSubmit("", "+46708251358", "abc", 3, SMS_ALPHABET_GSM7, 0x42, 2, 1, output, sizeof(output));
+    TEST_ASSERT_EQUAL_INT(22, length);
+    TEST_ASSERT_EQUAL_STRING_LEN("0041000B916407281553F800000A050003420201", output, 40);
+
+    TEST_ASSERT_TRUE(encodeSmsSubmit("", "+46708251358", "hellohello", 10, SMS_ALPHABET_GSM7, 0, 0, 0,
+                                     output, 8) < 0);
+}
+
+static void test_bench_decode() {
+    struct Sample {
+        const char* name;
+        const char* hex;
+    };
+    static const Sample samples[] = {
+        {"pdu/GSM7", PDU_GSM7},
+        {"pdu/UCS2长短信分片", PDU_UCS2_PART}
+    };
+    for (const Sample& sample : samples) {
+        size_t length = strlen(sample.hex);
+        SmsPdu pdu;
+        reportBenchmark(Benchmark::runChecked(sample.name, HOST_BENCH_ITERATIONS, [&]() {
+            return decodeSmsPdu(sample.hex, length, pdu, text, sizeof(text));
+        }));
+    }
+}
+
+static void test_bench_encode_mixed() {
+    size_t length = strlen(SMS_MIXED);
+    reportBenchmark(Benchmark::runChecked("sms-encode/混排长短信", HOST_BENCH_ITERATIONS, [&]() {
+        SmsSegmentPlan plan;
+        if (!planSmsSegments(SMS_MIXED, length, plan)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < plan.count; i++) {
+            const SmsSegment& segment = plan.parts[i];
+            if (encodeSmsSubmit("+8613800100500", "+8613800138000", SMS_MIXED + segment.offset, segment.length,
+                                segment.alphabet, 0x42, plan.count, i + 1, output, sizeof(output)) <= 0) {
+                return false;
+            }
+        }
+        return true;
+    }));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_decode_gsm7);
+    RUN_TEST(test_decode_ucs2_concat_part);
+    RUN_TEST(test_decode_rejects_malformed);
+    RUN_TEST(test_decode_truncates_to_buffer);
+    RUN_TEST(test_plan_segments);
+    RUN_TEST(test_encode_submit);
+    RUN_TEST(test_bench_decode);
+    RUN_TEST(test_bench_encode_mixed);
+    return UNITY_END();
+}
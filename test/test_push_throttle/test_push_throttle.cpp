@@ -0,0 +1,146 @@
+/**
+ * @file test_push_throttle.cpp
+ * @brief 推送端点守卫主机测试：端点标识、令牌桶限速与熔断/试探（以参数传入时间，不依赖时钟）
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include "../../lib/push_manager/push_throttle.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+static const char* DINGTALK_CONFIG =
+    "{\"webhook_url\":\"https://oapi.dingtalk.com/robot/send?access_token=abc\",\"message_template\":\"{content}\"}";
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_endpoint_key_uses_webhook_url() {
+    String otherTemplate =
+        "{\"message_template\":\"{sender}\",\"webhook_url\" : \"https://oapi.dingtalk.com/robot/send?access_token=abc\"}";
+    uint32_t key = PushEndpointGuard::endpointKey("dingtalk", DINGTALK_CONFIG);
+    TEST_ASSERT_EQUAL_UINT32(key, PushEndpointGuard::endpointKey("dingtalk", otherTemplate));
+    TEST_ASSERT_TRUE(key != PushEndpointGuard::endpointKey("wecom", DINGTALK_CONFIG));
+    TEST_ASSERT_TRUE(key != PushEndpointGuard::endpointKey("dingtalk",
+        "{\"webhook_url\":\"https://oapi.dingtalk.com/robot/send?access_token=xyz\"}"));
+
+    // 没有webhook_url时以整个配置标识
+    TEST_ASSERT_TRUE(PushEndpointGuard::endpointKey("mqtt", "{\"host\":\"a\"}") !=
+                     PushEndpointGuard::endpointKey("mqtt", "{\"host\":\"b\"}"));
+}
+
+static void test_rate_limit_token_bucket() {
+    PushEndpointGuard guard;
+    uint32_t key = PushEndpointGuard::endpointKey("dingtalk", DINGTALK_CONFIG);
+    TEST_ASSERT_EQUAL_UINT16(PUSH_RATE_DINGTALK_PER_MINUTE, PushEndpointGuard::ratePerMinute("dingtalk"));
+    TEST_ASSERT_EQUAL_UINT16(0, PushEndpointGuard::ratePerMinute("webhook"));
+
+    unsigned long retryInMs = 0;
+    unsigned long now = 1000;
+    for (int i = 0; i < PUSH_RATE_BURST; i++) {
+        TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "dingtalk", now, retryInMs));
+        guard.report(key, PUSH_SUCCESS, now);
+    }
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_THROTTLED, guard.admit(key, "dingtalk", now, retryInMs));
+    unsigned long perToken = 60000UL / PUSH_RATE_DINGTALK_PER_MINUTE;
+    TEST_ASSERT_EQUAL_UINT32(perToken + 1, retryInMs);
+
+    // 等够一个令牌的时间后恰好再放行一次
+    now += retryInMs;
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "dingtalk", now, retryInMs));
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_THROTTLED, guard.admit(key, "dingtalk", now, retryInMs));
+}
+
+static void test_unlimited_channel() {
+    PushEndpointGuard guard;
+    uint32_t key = PushEndpointGuard::endpointKey("webhook", "{\"webhook_url\":\"http://example.com/hook\"}");
+    unsigned long retryInMs = 0;
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", 1000, retryInMs));
+        guard.report(key, PUSH_SUCCESS, 1000);
+    }
+}
+
+static void test_circuit_opens_and_probes() {
+    PushEndpointGuard guard;
+    uint32_t key = PushEndpointGuard::endpointKey("webhook", "{\"webhook_url\":\"http://example.com/down\"}");
+    unsigned long retryInMs = 0;
+    unsigned long now = 5000;
+
+    // 配置错误不计入失败
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", now, retryInMs));
+    guard.report(key, PUSH_CONFIG_ERROR, now);
+
+    for (int i = 0; i < PUSH_CIRCUIT_FAILURE_THRESHOLD; i++) {
+        TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", now, retryInMs));
+        guard.report(key, PUSH_NETWORK_ERROR, now);
+    }
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_CIRCUIT_OPEN, guard.admit(key, "webhook", now + 1000, retryInMs));
+    TEST_ASSERT_EQUAL_UINT32(PUSH_CIRCUIT_COOLDOWN_MS - 1000, retryInMs);
+
+    // 冷却结束只放行一次试探
+    now += PUSH_CIRCUIT_COOLDOWN_MS;
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", now, retryInMs));
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_CIRCUIT_OPEN, guard.admit(key, "webhook", now, retryInMs));
+
+    // 试探失败：冷却时间加倍
+    guard.report(key, PUSH_FAILED, now);
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_CIRCUIT_OPEN, guard.admit(key, "webhook", now, retryInMs));
+    TEST_ASSERT_EQUAL_UINT32(PUSH_CIRCUIT_COOLDOWN_MS * 2, retryInMs);
+
+    // 试探成功：恢复
+    now += PUSH_CIRCUIT_COOLDOWN_MS * 2;
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", now, retryInMs));
+    guard.report(key, PUSH_SUCCESS, now);
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", now, retryInMs));
+}
+
+static void test_open_endpoints_survive_eviction() {
+    PushEndpointGuard guard;
+    unsigned long retryInMs = 0;
+    uint32_t broken = PushEndpointGuard::endpointKey("webhook", "{\"webhook_url\":\"http://example.com/broken\"}");
+    for (int i = 0; i < PUSH_CIRCUIT_FAILURE_THRESHOLD; i++) {
+        guard.admit(broken, "webhook", 0, retryInMs);
+        guard.report(broken, PUSH_FAILED, 0);
+    }
+
+    // 跟踪的端点已满后，替换最久未使用的未熔断端点
+    for (int i = 0; i < PUSH_ENDPOINT_MAX_TRACKED * 2; i++) {
+        String config = String("{\"webhook_url\":\"http://example.com/") + i + "\"}";
+        uint32_t key = PushEndpointGuard::endpointKey("webhook", config);
+        TEST_ASSERT_EQUAL_INT(ENDPOINT_ADMITTED, guard.admit(key, "webhook", 1000 + i, retryInMs));
+    }
+    TEST_ASSERT_EQUAL_INT(ENDPOINT_CIRCUIT_OPEN, guard.admit(broken, "webhook", 2000, retryInMs));
+}
+
+static void test_bench_admit() {
+    PushEndpointGuard guard;
+    uint32_t key = PushEndpointGuard::endpointKey("feishu_bot", DINGTALK_CONFIG);
+    unsigned long now = 0;
+    reportBenchmark(Benchmark::runChecked("throttle/准入+报告", HOST_BENCH_ITERATIONS, [&]() {
+        // 每次前进一个令牌的时间，保持放行
+        now += 60000UL / PUSH_RATE_FEISHU_PER_MINUTE + 1;
+        unsigned long retryInMs = 0;
+        bool admitted = guard.admit(key, "feishu_bot", now, retryInMs) == ENDPOINT_ADMITTED;
+        guard.report(key, PUSH_SUCCESS, now);
+        return admitted;
+    }));
+    reportBenchmark(Benchmark::run("throttle/端点标识", HOST_BENCH_ITERATIONS, []() {
+        PushEndpointGuard::endpointKey("dingtalk", DINGTALK_CONFIG);
+    }));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_endpoint_key_uses_webhook_url);
+    RUN_TEST(test_rate_limit_token_bucket);
+    RUN_TEST(test_unlimited_channel);
+    RUN_TEST(test_circuit_opens_and_probes);
+    RUN_TEST(test_open_endpoints_survive_eviction);
+    RUN_TEST(test_bench_admit);
+    return UNITY_END();
+}
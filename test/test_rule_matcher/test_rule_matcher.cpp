@@ -0,0 +1,172 @@
+/**
+ * @file test_rule_matcher.cpp
+ * @brief 转发规则匹配器主机测试：号码模式、关键词自动机、号码名单与默认转发
+ * @author ESP-SMS-Relay Project
+ * @date 2024
+ */
+
+#include <unity.h>
+#include "../../lib/push_manager/number_set.cpp"
+#include "../../lib/push_manager/rule_matcher.cpp"
+#include "../../lib/benchmark/benchmark_runner.cpp"
+#include "../native_shim/host_benchmark.h"
+
+static std::vector<ForwardRule> rules;
+
+/**
+ * @brief 追加一条启用的规则
+ * @param sourceNumber 来源号码模式
+ * @param keywords 关键词（逗号分隔）
+ * @param isDefaultForward 是否默认转发
+ */
+static void addRule(const char* sourceNumber, const char* keywords, bool isDefaultForward = false) {
+    ForwardRule rule;
+    rule.id = (int)rules.size() + 1;
+    rule.ruleName = String("rule") + rule.id;
+    rule.sourceNumber = sourceNumber;
+    rule.keywords = keywords;
+    rule.pushType = "webhook";
+    rule.enabled = true;
+    rule.isDefaultForward = isDefaultForward;
+    rules.push_back(rule);
+}
+
+/**
+ * @brief 匹配短信，返回命中规则的ID（逗号分隔，按规则列表顺序）
+ * @param matcher 已编译的匹配器
+ * @param sender 发送方号码
+ * @param content 短信内容
+ * @return std::string 规则ID列表
+ */
+static std::string matchIds(const RuleMatcher& matcher, const char* sender, const char* content) {
+    uint16_t indices[RULE_MATCHER_MAX_RULES];
+    size_t count = matcher.match(sender, content, indices, RULE_MATCHER_MAX_RULES);
+    std::string ids;
+    for (size_t i = 0; i < count; i++) {
+        if (!ids.empty()) {
+            ids += ",";
+        }
+        ids += std::to_string(rules[indices[i]].id);
+    }
+    return ids;
+}
+
+void setUp() {
+    rules.clear();
+}
+
+void tearDown() {
+}
+
+static void test_number_patterns() {
+    addRule("10086", "");           // 1 精确
+    addRule("1069*", "");           // 2 前缀
+    addRule("*8000", "");           // 3 后缀
+    addRule("10*86", "");           // 4 前缀+后缀
+    addRule("*", "");               // 5 任意号码
+    RuleMatcher matcher;
+    TEST_ASSERT_TRUE(matcher.compile(rules));
+    TEST_ASSERT_EQUAL_UINT(5, matcher.getRuleCount());
+
+    TEST_ASSERT_EQUAL_STRING("1,4,5", matchIds(matcher, "10086", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("2,5", matchIds(matcher, "10690000", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("3,5", matchIds(matcher, "+8613800138000", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("4,5", matchIds(matcher, "1012386", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("5", matchIds(matcher, "95588", "").c_str());
+}
+
+static void test_keywords() {
+    addRule("", "验证码,code");             // 1 任一关键词命中
+    addRule("10086", "余额");               // 2 号码与关键词同时满足
+    addRule("", " , ");                     // 3 只有空白关键词：从不匹配
+    RuleMatcher matcher;
+    TEST_ASSERT_TRUE(matcher.compile(rules));
+
+    TEST_ASSERT_EQUAL_STRING("1", matchIds(matcher, "10690000", "【某银行】您的验证码为834921").c_str());
+    TEST_ASSERT_EQUAL_STRING("1", matchIds(matcher, "10690000", "Your code is 834921").c_str());
+    TEST_ASSERT_EQUAL_STRING("2", matchIds(matcher, "10086", "您的余额不足").c_str());
+    TEST_ASSERT_EQUAL_STRING("", matchIds(matcher, "10010", "您的余额不足").c_str());
+    TEST_ASSERT_EQUAL_STRING("", matchIds(matcher, "10086", "晚上一起吃饭吗？").c_str());
+}
+
+static void test_default_forward_and_disabled() {
+    addRule("10086", "不会命中", true);     // 1 默认转发：忽略号码与关键词
+    addRule("", "");                        // 2 已停用
+    rules.back().enabled = false;
+    RuleMatcher matcher;
+    TEST_ASSERT_TRUE(matcher.compile(rules));
+    TEST_ASSERT_EQUAL_UINT(1, matcher.getRuleCount());
+    TEST_ASSERT_EQUAL_STRING("1", matchIds(matcher, "95588", "任意内容").c_str());
+}
+
+static void test_number_lists() {
+    std::shared_ptr<NumberSet> vip(new NumberSet(4));
+    TEST_ASSERT_TRUE(vip->isReady());
+    TEST_ASSERT_TRUE(vip->insert("138-0013-8000"));
+    TEST_ASSERT_TRUE(vip->insert("+1 (650) 555 0100"));
+    NumberListMap lists;
+    lists["vip"] = vip;
+
+    addRule("list:vip", "");                // 1 在名单中
+    addRule("!list:vip", "");               // 2 不在名单中
+    addRule("list:missing", "");            // 3 缺少的名单视为空名单
+    RuleMatcher matcher;
+    TEST_ASSERT_TRUE(matcher.compile(rules, &lists));
+
+    // 号码规范化后比较：国内号码补国家码，"00"前缀视为国际号码
+    TEST_ASSERT_EQUAL_STRING("1", matchIds(matcher, "+8613800138000", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("1", matchIds(matcher, "13800138000", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("1", matchIds(matcher, "0016505550100", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("2", matchIds(matcher, "13900139000", "").c_str());
+
+    String listName;
+    bool negated = false;
+    TEST_ASSERT_TRUE(NumberSet::parseListPattern("!list:vip", listName, negated));
+    TEST_ASSERT_EQUAL_STRING("vip", listName.c_str());
+    TEST_ASSERT_TRUE(negated);
+    TEST_ASSERT_FALSE(NumberSet::parseListPattern("1069*", listName, negated));
+}
+
+static void test_capacity_limits() {
+    addRule("*", "");
+    addRule("*", "");
+    RuleMatcher matcher;
+    TEST_ASSERT_TRUE(matcher.compile(rules));
+    uint16_t indices[1];
+    TEST_ASSERT_EQUAL_UINT(1, matcher.match("10086", "", indices, 1));
+    TEST_ASSERT_EQUAL_UINT16(0, indices[0]);
+}
+
+static void test_bench_match() {
+    // 与常见部署规模相当：若干号码规则、关键词规则与一条默认转发
+    for (int i = 0; i < 20; i++) {
+        String number = String("1069") + (10000 + i) + "*";
+        addRule(number.c_str(), "");
+    }
+    addRule("", "验证码,校验码,动态码,code,OTP");
+    addRule("*95588", "转账,支出,收入");
+    addRule("10086", "余额,流量,话费");
+    addRule("", "", true);
+    RuleMatcher matcher;
+    TEST_ASSERT_TRUE(matcher.compile(rules));
+
+    uint16_t indices[RULE_MATCHER_MAX_RULES];
+    reportBenchmark(Benchmark::runChecked("match/验证码短信", HOST_BENCH_ITERATIONS, [&]() {
+        return matcher.match("10690000", "【某银行】您的验证码为834921，5分钟内有效，请勿泄露。",
+                             indices, RULE_MATCHER_MAX_RULES) == 2;
+    }));
+    reportBenchmark(Benchmark::runChecked("match/普通短信", HOST_BENCH_ITERATIONS, [&]() {
+        return matcher.match("+8613800138000", "晚上一起吃饭吗？", indices, RULE_MATCHER_MAX_RULES) == 1;
+    }));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_number_patterns);
+    RUN_TEST(test_keywords);
+    RUN_TEST(test_default_forward_and_disabled);
+    RUN_TEST(test_number_lists);
+    RUN_TEST(test_capacity_limits);
+    RUN_TEST(test_bench_match);
+    return UNITY_END();
+}